@@ -122,6 +122,9 @@ typedef void (*wsrep_log_cb_t)(wsrep_log_level_t, const char *);
  * PA_UNSAFE    the writeset cannot be applied in parallel
  * COMMUTATIVE  the order in which the writeset is applied does not matter
  * NATIVE       the writeset contains another writeset in this provider format
+ * COMMIT_GROUP more writesets are already waiting to commit right after this
+ *              one, durable flush of the commit may be left to the last
+ *              writeset in the group
  *
  * Note that some of the flags are mutually exclusive (e.g. COMMIT and
  * ROLLBACK).
@@ -132,6 +135,7 @@ typedef void (*wsrep_log_cb_t)(wsrep_log_level_t, const char *);
 #define WSREP_FLAG_PA_UNSAFE            ( 1ULL << 3 )
 #define WSREP_FLAG_COMMUTATIVE          ( 1ULL << 4 )
 #define WSREP_FLAG_NATIVE               ( 1ULL << 5 )
+#define WSREP_FLAG_COMMIT_GROUP         ( 1ULL << 6 )
 
 
 typedef uint64_t wsrep_trx_id_t;  //!< application transaction ID
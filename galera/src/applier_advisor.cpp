@@ -0,0 +1,48 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "applier_advisor.hpp"
+
+#include <gu_lock.hpp>
+
+#include <algorithm>
+
+// weight of the new sample in the smoothed estimate
+static double const SMOOTHING(0.25);
+
+long
+galera::ApplierAdvisor::update(long long const received,
+                               double    const deps_dist,
+                               double    const recv_q,
+                               double    const window)
+{
+    gu::Lock lock(mtx_);
+
+    if (received > received_ && deps_dist > 0)
+    {
+        received_ = received;
+
+        double target(deps_dist);
+
+        // appliers keep up, threads not busy in the window are spare
+        if (recv_q < 1.0)
+        {
+            target = std::min(target, std::max(window + 1.0, 1.0));
+        }
+
+        target = std::max(target, 1.0);
+
+        if (estimate_ > 0) estimate_ += SMOOTHING * (target - estimate_);
+        else               estimate_  = target;
+    }
+
+    return rounded();
+}
+
+long
+galera::ApplierAdvisor::recommended() const
+{
+    gu::Lock lock(mtx_);
+    return rounded();
+}
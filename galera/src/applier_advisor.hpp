@@ -0,0 +1,52 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_APPLIER_ADVISOR_HPP
+#define GALERA_APPLIER_ADVISOR_HPP
+
+#include <gu_mutex.hpp>
+
+namespace galera
+{
+    /*!
+     * Estimates the number of applier threads worth running. The parallelism
+     * the workload allows is given by the average certification dependency
+     * distance. Without receive queue backlog appliers keep up anyway, so
+     * the estimate is further limited by the apply monitor window, which
+     * shows how many write sets are actually applied at once: threads
+     * beyond it only contend on the monitor.
+     *
+     * The estimate is smoothed over samples, samples with no write sets
+     * received in between don't change it.
+     */
+    class ApplierAdvisor
+    {
+    public:
+
+        ApplierAdvisor() : mtx_(), received_(0), estimate_(0) {}
+
+        /*!
+         * @param received  total number of received actions
+         * @param deps_dist average cert dependency distance
+         * @param recv_q    average receive queue length
+         * @param window    average apply monitor window
+         * @return recommended number of applier threads, 0 - no data yet
+         */
+        long update(long long received,
+                    double deps_dist, double recv_q, double window);
+
+        long recommended() const;
+
+    private:
+
+        // must be called under mtx_
+        long rounded() const { return long(estimate_ + 0.5); }
+
+        gu::Mutex mutable mtx_;
+        long long         received_; // at the last accounted sample
+        double            estimate_; // smoothed, 0 until the first sample
+    };
+}
+
+#endif // GALERA_APPLIER_ADVISOR_HPP
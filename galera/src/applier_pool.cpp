@@ -0,0 +1,126 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "applier_pool.hpp"
+
+#include "gu_logger.hpp"
+
+#include <cstdlib> // abort()
+
+galera::ApplierPool::ApplierPool(bool const enabled)
+    :
+    mtx_     (),
+    workers_ (),
+    busy_    (0),
+    queued_  (0),
+    deferred_(0),
+    stolen_  (0),
+    enabled_ (enabled)
+{}
+
+galera::ApplierPool::~ApplierPool()
+{
+    assert(0 == busy_);
+    assert(0 == queued_);
+    assert(workers_.empty());
+
+    if (deferred_ > 0)
+    {
+        log_info << "Applier pool: deferred " << deferred_ << ", stolen "
+                 << stolen_;
+    }
+}
+
+void
+galera::ApplierPool::join(void* const recv_ctx)
+{
+    gu::Lock lock(mtx_);
+
+    assert(0 == find(recv_ctx));
+
+    workers_.push_back(new Worker(recv_ctx));
+}
+
+void
+galera::ApplierPool::leave(void* const recv_ctx)
+{
+    gu::Lock lock(mtx_);
+
+    std::vector<Worker*>::iterator i(workers_.begin());
+    while (i != workers_.end() && (*i)->ctx_ != recv_ctx) ++i;
+
+    assert(i != workers_.end());
+    if (gu_unlikely(i == workers_.end())) return;
+
+    Worker* const w(*i);
+    workers_.erase(i);
+
+    if (!w->queue_.empty())
+    {
+        /* someone must be busy since the queue is not empty and it is not
+         * us as we are leaving, hand our queue over to it */
+        if (gu_unlikely(workers_.empty()))
+        {
+            log_fatal << "Last slave thread leaving with "
+                      << w->queue_.size() << " write sets queued";
+            abort();
+        }
+
+        std::deque<TrxHandle*>& q(workers_.front()->queue_);
+        q.insert(q.end(), w->queue_.begin(), w->queue_.end());
+    }
+
+    delete w;
+}
+
+galera::ApplierPool::Worker*
+galera::ApplierPool::find(void* const recv_ctx) const
+{
+    for (size_t i(0); i < workers_.size(); ++i)
+    {
+        if (workers_[i]->ctx_ == recv_ctx) return workers_[i];
+    }
+
+    return 0;
+}
+
+galera::TrxHandle*
+galera::ApplierPool::take_oldest(const Worker* const own)
+{
+    Worker*                          oldest_w(0);
+    std::deque<TrxHandle*>::iterator oldest;
+
+    for (size_t i(0); i < workers_.size(); ++i)
+    {
+        std::deque<TrxHandle*>& q(workers_[i]->queue_);
+
+        for (std::deque<TrxHandle*>::iterator j(q.begin()); j != q.end(); ++j)
+        {
+            if (0 == oldest_w ||
+                (*j)->global_seqno() < (*oldest)->global_seqno())
+            {
+                oldest_w = workers_[i];
+                oldest   = j;
+            }
+        }
+    }
+
+    assert(oldest_w);
+
+    TrxHandle* const trx(*oldest);
+    oldest_w->queue_.erase(oldest);
+    --queued_;
+    stolen_ += (oldest_w != own);
+
+    return trx;
+}
+
+void
+galera::ApplierPool::stats_get(long long& deferred, long long& stolen) const
+{
+    gu::Lock lock(mtx_);
+
+    deferred = deferred_;
+    stolen   = stolen_;
+}
@@ -0,0 +1,187 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_APPLIER_POOL_HPP
+#define GALERA_APPLIER_POOL_HPP
+
+#include "trx_handle.hpp"
+
+#include "gu_lock.hpp"
+
+#include <deque>
+#include <vector>
+
+namespace galera
+{
+    /*!
+     * Lets slave threads share certified write sets so that a write set
+     * waiting for its dependencies does not hold up the thread that
+     * received it.
+     *
+     * Slave threads belong to the application and apply_cb must be called
+     * with the recv_ctx of the calling thread, so the pool has no threads
+     * of its own: its members are the threads inside async_recv(). A thread
+     * that certified a write set which would wait in the apply monitor
+     * queues it in its own deque and goes back to receiving. Threads that
+     * finish applying take ready write sets from their own deque first,
+     * then steal from the others.
+     *
+     * While anything is queued at least one member is applying: a write set
+     * is queued only when some member is busy, and the last busy member
+     * takes the oldest queued write set even if it has to wait for it.
+     * So there is always someone to pick up the queue and monitor drains
+     * complete as before.
+     */
+    class ApplierPool
+    {
+    public:
+
+        explicit ApplierPool(bool enabled);
+        ~ApplierPool();
+
+        bool enabled() const { return enabled_; }
+
+        /*! Registers receiver thread with the pool for the scope */
+        class Member
+        {
+        public:
+            Member(ApplierPool& pool, void* recv_ctx)
+                : pool_(pool), ctx_(recv_ctx)
+            {
+                if (pool_.enabled()) pool_.join(ctx_);
+            }
+
+            ~Member() { if (pool_.enabled()) pool_.leave(ctx_); }
+
+        private:
+            Member(const Member&);
+            Member& operator=(const Member&);
+
+            ApplierPool& pool_;
+            void* const  ctx_;
+        };
+
+        /*!
+         * Queues trx for later if ready(*trx) is false and some other
+         * member is applying. Otherwise the caller becomes busy, must apply
+         * trx itself and then call next() until it returns NULL.
+         *
+         * @return true if trx was queued
+         */
+        template <class Ready>
+        bool defer(void* const recv_ctx, TrxHandle* const trx,
+                   const Ready& ready)
+        {
+            gu::Lock lock(mtx_);
+
+            if (busy_ > 0 && !ready(*trx))
+            {
+                Worker* const w(find(recv_ctx));
+                assert(w);
+
+                if (gu_likely(w != 0))
+                {
+                    trx->ref();
+                    w->queue_.push_back(trx);
+                    ++queued_;
+                    ++deferred_;
+                    return true;
+                }
+            }
+
+            ++busy_;
+            return false;
+        }
+
+        /*!
+         * Returns next queued trx for a busy member to apply, or NULL when
+         * there is nothing for it to do, after which it is no longer busy.
+         * Returned trx must be unref()'d after applying.
+         */
+        template <class Ready>
+        TrxHandle* next(void* const recv_ctx, const Ready& ready)
+        {
+            gu::Lock lock(mtx_);
+
+            assert(busy_ > 0);
+
+            if (queued_ > 0)
+            {
+                Worker* const own(find(recv_ctx));
+                TrxHandle*    trx(own ? take_ready(*own, ready) : 0);
+
+                for (size_t i(0); 0 == trx && i < workers_.size(); ++i)
+                {
+                    if (workers_[i] == own) continue;
+
+                    trx = take_ready(*workers_[i], ready);
+                    stolen_ += (trx != 0);
+                }
+
+                if (0 == trx && 1 == busy_) trx = take_oldest(own);
+
+                if (trx) return trx;
+            }
+
+            --busy_;
+            return 0;
+        }
+
+        void stats_get(long long& deferred, long long& stolen) const;
+
+    private:
+
+        ApplierPool(const ApplierPool&);
+        ApplierPool& operator=(const ApplierPool&);
+
+        struct Worker
+        {
+            explicit Worker(void* ctx) : ctx_(ctx), queue_() {}
+
+            void* const            ctx_;
+            std::deque<TrxHandle*> queue_;
+
+        private:
+            Worker(const Worker&);
+            Worker& operator=(const Worker&);
+        };
+
+        void join (void* recv_ctx);
+        void leave(void* recv_ctx);
+
+        // must be called under mtx_
+        Worker* find(void* recv_ctx) const;
+
+        template <class Ready>
+        TrxHandle* take_ready(Worker& w, const Ready& ready)
+        {
+            std::deque<TrxHandle*>::iterator i(w.queue_.begin());
+
+            for (; i != w.queue_.end(); ++i)
+            {
+                if (ready(**i))
+                {
+                    TrxHandle* const trx(*i);
+                    w.queue_.erase(i);
+                    --queued_;
+                    return trx;
+                }
+            }
+
+            return 0;
+        }
+
+        TrxHandle* take_oldest(const Worker* own);
+
+        gu::Mutex mutable    mtx_;
+        std::vector<Worker*> workers_;
+        int                  busy_;     // members applying right now
+        long                 queued_;
+        long long            deferred_;
+        long long            stolen_;
+        bool const           enabled_;
+    };
+}
+
+#endif // GALERA_APPLIER_POOL_HPP
@@ -0,0 +1,104 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "cert_hot_keys.hpp"
+
+#include <algorithm> // std::sort()
+#include <sstream>
+#include <cstring>   // memset()
+
+galera::CertHotKeys::CertHotKeys(size_t const top)
+    :
+    sketch_ (),
+    top_    (),
+    max_top_(top),
+    total_  (0)
+{
+    top_.reserve(max_top_);
+}
+
+void
+galera::CertHotKeys::add(const KeySet::KeyPart& kp)
+{
+    uint64_t const h(kp.hash());
+    uint32_t est(~0U);
+
+    for (int row(0); row < DEPTH; ++row)
+    {
+        uint32_t& c(sketch_[row][index(h, row)]);
+        if (gu_likely(c < ~0U)) ++c;
+        est = std::min(est, c);
+    }
+
+    ++total_;
+
+    if (0 == max_top_) return;
+
+    size_t min(0);
+
+    for (size_t i(0); i < top_.size(); ++i)
+    {
+        if (top_[i].hash_ == h)
+        {
+            top_[i].count_ = est;
+            return;
+        }
+
+        if (top_[i].count_ < top_[min].count_) min = i;
+    }
+
+    if (top_.size() < max_top_)
+    {
+        top_.push_back(Entry());
+        min = top_.size() - 1;
+    }
+    else if (top_[min].count_ >= est)
+    {
+        return;
+    }
+
+    std::ostringstream os;
+    os << kp;
+
+    top_[min].hash_  = h;
+    top_[min].count_ = est;
+    top_[min].name_  = os.str();
+}
+
+namespace
+{
+    struct EntryGreater
+    {
+        template <typename E>
+        bool operator()(const E* const l, const E* const r) const
+        {
+            return (l->count_ > r->count_);
+        }
+    };
+}
+
+void
+galera::CertHotKeys::print(std::ostream& os) const
+{
+    std::vector<const Entry*> sorted;
+    sorted.reserve(top_.size());
+
+    for (size_t i(0); i < top_.size(); ++i) sorted.push_back(&top_[i]);
+
+    std::sort(sorted.begin(), sorted.end(), EntryGreater());
+
+    for (size_t i(0); i < sorted.size(); ++i)
+    {
+        if (i) os << ", ";
+        os << sorted[i]->name_ << ':' << sorted[i]->count_;
+    }
+}
+
+void
+galera::CertHotKeys::reset()
+{
+    memset(sketch_, 0, sizeof(sketch_));
+    top_.clear();
+    total_ = 0;
+}
@@ -0,0 +1,86 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_CERT_HOT_KEYS_HPP
+#define GALERA_CERT_HOT_KEYS_HPP
+
+#include "key_set.hpp"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace galera
+{
+    /*!
+     * Approximate top-K of the most frequent key parts.
+     *
+     * Frequencies are estimated by a count-min sketch over KeyPart::hash(),
+     * so memory use does not depend on the number of distinct keys. Only
+     * the K keys with the highest estimates are remembered by name.
+     * Key sets contain separate parts for every key prefix, so tables
+     * touched by many write sets show up here along with hot rows.
+     *
+     * Not thread safe.
+     */
+    class CertHotKeys
+    {
+    public:
+
+        explicit CertHotKeys(size_t top = TOP_DEFAULT);
+
+        void add(const KeySet::KeyPart& kp);
+
+        /*! total number of added keys */
+        long long total() const { return total_; }
+
+        /*! prints "key:count" pairs in descending count order */
+        void print(std::ostream& os) const;
+
+        void reset();
+
+        static size_t const TOP_DEFAULT = 8;
+
+    private:
+
+        static int const DEPTH      = 4;
+        static int const WIDTH_BITS = 11;
+        static int const WIDTH      = 1 << WIDTH_BITS;
+
+        size_t index(uint64_t h, int row) const
+        {
+            static uint64_t const mult[DEPTH] =
+            {
+                0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL,
+                0x165667B19E3779F9ULL, 0xD6E8FEB86659FD93ULL
+            };
+
+            return ((h * mult[row]) >> (64 - WIDTH_BITS));
+        }
+
+        struct Entry
+        {
+            Entry() : hash_(0), count_(0), name_() {}
+
+            uint64_t    hash_;
+            uint32_t    count_;
+            std::string name_;
+        };
+
+        uint32_t           sketch_[DEPTH][WIDTH];
+        std::vector<Entry> top_;
+        size_t const       max_top_;
+        long long          total_;
+    };
+
+    inline std::ostream&
+    operator << (std::ostream& os, const CertHotKeys& hk)
+    {
+        hk.print(os);
+        return os;
+    }
+}
+
+#endif // GALERA_CERT_HOT_KEYS_HPP
@@ -0,0 +1,189 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "cert_index_ng.hpp"
+
+#include <gu_mem_stats.hpp>
+
+#include <algorithm> // std::swap()
+
+/* slot and filter arrays */
+static inline long long
+table_bytes(size_t const capacity)
+{
+    return capacity * (sizeof(uint64_t) + sizeof(void*) + 4);
+}
+
+static inline void
+mem_account(long long const bytes)
+{
+    gu::MemStats::add(gu::MemStats::CERT_INDEX, bytes);
+}
+
+galera::CertIndexNG::CertIndexNG()
+    :
+    slots_ (new Slot[MIN_CAPACITY]()),
+    filter_(new uint8_t[MIN_CAPACITY * 4]()),
+    mask_  (MIN_CAPACITY - 1),
+    shift_ (64 - __builtin_ctzll(MIN_CAPACITY)),
+    size_  (0)
+{
+    mem_account(table_bytes(MIN_CAPACITY));
+}
+
+galera::CertIndexNG::~CertIndexNG()
+{
+    mem_account(-table_bytes(mask_ + 1));
+    delete[] filter_;
+    delete[] slots_;
+}
+
+void
+galera::CertIndexNG::filter_add(uint64_t const h)
+{
+    uint8_t* const w(filter_ + filter_word(h) * FILTER_BLOCK);
+    int c1, c2;
+    filter_counters(h, c1, c2);
+
+    if (gu_likely(w[c1] < 0xff)) ++w[c1];
+    if (gu_likely(w[c2] < 0xff)) ++w[c2];
+}
+
+void
+galera::CertIndexNG::filter_remove(uint64_t const h)
+{
+    uint8_t* const w(filter_ + filter_word(h) * FILTER_BLOCK);
+    int c1, c2;
+    filter_counters(h, c1, c2);
+
+    assert(w[c1] > 0 && w[c2] > 0);
+
+    /* saturated counter has lost count, leave it till rebuild */
+    if (gu_likely(w[c1] < 0xff)) --w[c1];
+    if (gu_likely(w[c2] < 0xff)) --w[c2];
+}
+
+void
+galera::CertIndexNG::insert(KeyEntryNG* const ke)
+{
+    assert(ke);
+    assert(NULL == find(ke->key()));
+
+    /* keep load factor under 3/4 */
+    if (gu_unlikely((size_ + 1) * 4 > (mask_ + 1) * 3)) resize((mask_ + 1) * 2);
+
+    uint64_t const h(ke->key().hash());
+    size_t i(index(h));
+
+    while (slots_[i].entry_) i = (i + 1) & mask_;
+
+    slots_[i].hash_  = h;
+    slots_[i].entry_ = ke;
+    ++size_;
+
+    filter_add(h);
+    mem_account(sizeof(KeyEntryNG));
+}
+
+void
+galera::CertIndexNG::erase(const KeyEntryNG* const ke)
+{
+    size_t i(index(ke->key().hash()));
+
+    while (slots_[i].entry_ != ke)
+    {
+        assert(slots_[i].entry_ != NULL); // must be in the index
+        i = (i + 1) & mask_;
+    }
+
+    filter_remove(slots_[i].hash_);
+
+    /* shift back the following entries whose probe sequence passes
+     * through the hole, so that no tombstones are needed */
+    for (size_t j((i + 1) & mask_); slots_[j].entry_; j = (j + 1) & mask_)
+    {
+        size_t const k(index(slots_[j].hash_));
+
+        /* k is the home slot of j, leave entry in place if k is cyclically
+         * within (i, j] */
+        bool const stays(i <= j ? (i < k && k <= j) : (i < k || k <= j));
+
+        if (!stays)
+        {
+            slots_[i] = slots_[j];
+            i = j;
+        }
+    }
+
+    slots_[i].hash_  = 0;
+    slots_[i].entry_ = NULL;
+    --size_;
+    mem_account(-static_cast<long long>(sizeof(KeyEntryNG)));
+
+    /* give memory back after a spike, with hysteresis against grow */
+    if (gu_unlikely(mask_ + 1 > MIN_CAPACITY && size_ * 8 < mask_ + 1))
+    {
+        resize((mask_ + 1) / 2);
+    }
+}
+
+void
+galera::CertIndexNG::clear()
+{
+    CertIndexNG tmp; // releases current arrays on return
+
+    mem_account(-static_cast<long long>(size_ * sizeof(KeyEntryNG)));
+
+    std::swap(slots_,  tmp.slots_);
+    std::swap(filter_, tmp.filter_);
+    std::swap(mask_,   tmp.mask_);
+    std::swap(shift_,  tmp.shift_);
+    std::swap(size_,   tmp.size_);
+
+    tmp.size_ = 0; // entries were not ours
+}
+
+void
+galera::CertIndexNG::resize(size_t const capacity)
+{
+    assert(0 == (capacity & (capacity - 1)));
+    assert(capacity >= MIN_CAPACITY);
+    assert(capacity > size_);
+
+    Slot*    const old_slots(slots_);
+    size_t   const old_cap  (mask_ + 1);
+    uint8_t* const filter   (new uint8_t[capacity * 4]());
+
+    try
+    {
+        slots_ = new Slot[capacity]();
+    }
+    catch (...)
+    {
+        delete[] filter;
+        throw;
+    }
+
+    delete[] filter_;
+    filter_ = filter;
+    mask_   = capacity - 1;
+    shift_  = 64 - __builtin_ctzll(capacity);
+
+    for (size_t i(0); i < old_cap; ++i)
+    {
+        if (old_slots[i].entry_)
+        {
+            size_t j(index(old_slots[i].hash_));
+
+            while (slots_[j].entry_) j = (j + 1) & mask_;
+
+            slots_[j] = old_slots[i];
+            filter_add(old_slots[i].hash_);
+        }
+    }
+
+    delete[] old_slots;
+
+    mem_account(table_bytes(capacity) - table_bytes(old_cap));
+}
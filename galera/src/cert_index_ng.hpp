@@ -0,0 +1,155 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_CERT_INDEX_NG_HPP
+#define GALERA_CERT_INDEX_NG_HPP
+
+#include "key_entry_ng.hpp"
+
+#include <stdint.h>
+#include <cstddef>
+
+namespace galera
+{
+    /*!
+     * Version 3 certification index: open addressing hash table with linear
+     * probing. Each slot holds the key hash inline next to the entry
+     * pointer, so probing touches only the slot array and an entry is
+     * dereferenced only on full hash match. There are no per-key bucket
+     * nodes and no tombstones: erase() shifts the following slots back.
+     *
+     * Lookups are prefiltered by a counting Bloom filter with two 8-bit
+     * counters per key in the same 64-bit word. The filter takes 4 bytes
+     * per slot, so it stays cache resident much longer than the slot array
+     * and most lookups for keys that are not in the index (the common case
+     * for a clean write set) are answered by a single word load. Counters
+     * are maintained on insert()/erase(), a saturated counter sticks until
+     * the filter is rebuilt on resize.
+     *
+     * Entries are owned by the caller (Certification), the table only
+     * stores pointers to them. Not thread safe.
+     */
+    class CertIndexNG
+    {
+    public:
+
+        CertIndexNG();
+        ~CertIndexNG();
+
+        /*! @return entry matching kp or NULL */
+        KeyEntryNG* find(const KeySet::KeyPart& kp) const
+        {
+            uint64_t const h(kp.hash());
+
+            if (!may_contain(h)) return NULL;
+
+            for (size_t i(index(h)); slots_[i].entry_; i = (i + 1) & mask_)
+            {
+                if (slots_[i].hash_ == h &&
+                    slots_[i].entry_->key().matches(kp))
+                {
+                    return slots_[i].entry_;
+                }
+            }
+
+            return NULL;
+        }
+
+        /*! @return false if kp is definitely not in the index */
+        bool may_contain(const KeySet::KeyPart& kp) const
+        {
+            return may_contain(kp.hash());
+        }
+
+        /*! hints CPU to load the filter word and the slot where search for
+         *  kp starts */
+        void prefetch(const KeySet::KeyPart& kp) const
+        {
+            uint64_t const h(kp.hash());
+            __builtin_prefetch(filter_ + filter_word(h) * FILTER_BLOCK);
+            __builtin_prefetch(slots_ + index(h));
+        }
+
+        /*! inserts entry with the key not present in the index */
+        void insert(KeyEntryNG* ke);
+
+        /*! removes the entry from the index, entry itself is not deleted */
+        void erase(const KeyEntryNG* ke);
+
+        size_t size()  const { return size_; }
+        bool   empty() const { return 0 == size_; }
+
+        /*! applies op to every entry */
+        template <typename Op> void for_each(Op op) const
+        {
+            for (size_t i(0); i <= mask_; ++i)
+            {
+                if (slots_[i].entry_) op(slots_[i].entry_);
+            }
+        }
+
+        /*! removes all entries and releases spare memory */
+        void clear();
+
+    private:
+
+        struct Slot
+        {
+            uint64_t    hash_;
+            KeyEntryNG* entry_;
+        };
+
+        static size_t const MIN_CAPACITY = 1 << 8;
+
+        /* key hashes have uppermost bits zero and some of the lower bits
+         * select a shard, so mix them before taking the top bits */
+        size_t index(uint64_t const h) const
+        {
+            return ((h * 0x9E3779B97F4A7C15ULL) >> shift_);
+        }
+
+        static size_t const FILTER_BLOCK = 8; // counters per 64-bit word
+
+        /* filter has capacity/2 words, 4 counters per slot */
+        size_t filter_word(uint64_t const h) const
+        {
+            return ((h * 0xC2B2AE3D27D4EB4FULL) >> (shift_ + 1));
+        }
+
+        /* two distinct counters within the word */
+        static void filter_counters(uint64_t const h, int& c1, int& c2)
+        {
+            uint64_t const g((h * 0xC2B2AE3D27D4EB4FULL) >> 32);
+
+            c1 = static_cast<int>(g & (FILTER_BLOCK - 1));
+            c2 = static_cast<int>((g >> 3) & (FILTER_BLOCK - 1));
+            if (c1 == c2) c2 ^= 1;
+        }
+
+        bool may_contain(uint64_t const h) const
+        {
+            const uint8_t* const w(filter_ + filter_word(h) * FILTER_BLOCK);
+            int c1, c2;
+            filter_counters(h, c1, c2);
+            return (w[c1] && w[c2]);
+        }
+
+        void filter_add   (uint64_t h);
+        void filter_remove(uint64_t h);
+
+        /* rehashes slots and rebuilds the filter */
+        void resize(size_t capacity);
+
+        Slot*    slots_;
+        uint8_t* filter_; // capacity * 4 counters
+        size_t   mask_;   // capacity - 1
+        int      shift_;  // 64 - log2(capacity)
+        size_t   size_;
+
+        CertIndexNG(const CertIndexNG&);
+        CertIndexNG& operator=(const CertIndexNG&);
+    };
+}
+
+#endif // GALERA_CERT_INDEX_NG_HPP
@@ -0,0 +1,328 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "cert_index_spill.hpp"
+
+#include <gu_atomic.hpp>
+#include <gu_logger.hpp>
+#include <gu_string_utils.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <unistd.h>
+
+galera::CertIndexSpill::Generation::Generation(const std::string& name,
+                                               size_t const       count)
+    :
+    fd_       (name, count * sizeof(Record), false, false),
+    mmap_     (fd_),
+    count_    (0),
+    max_seqno_(WSREP_SEQNO_UNDEFINED)
+{
+    fd_.unlink();
+}
+
+void
+galera::CertIndexSpill::Generation::seal(size_t const        count,
+                                         wsrep_seqno_t const max_seqno)
+{
+    assert(count * sizeof(Record) <= mmap_.size);
+
+    count_     = count;
+    max_seqno_ = max_seqno;
+}
+
+const galera::CertIndexSpill::Record*
+galera::CertIndexSpill::Generation::find(const KeySet::KeyPart& kp) const
+{
+    uint64_t const h(kp.hash());
+
+    for (const Record* r(std::lower_bound(begin(), end(), h, hash_below));
+         r != end() && hash(*r) == h; ++r)
+    {
+        if (r->key().matches(kp)) return r;
+    }
+
+    return NULL;
+}
+
+galera::CertIndexSpill::CertIndexSpill(const std::string& dir)
+    :
+    dir_    (dir),
+    gens_   (),
+    purged_ (WSREP_SEQNO_UNDEFINED),
+    spilled_(WSREP_SEQNO_UNDEFINED)
+{}
+
+galera::CertIndexSpill::~CertIndexSpill()
+{
+    clear();
+}
+
+void
+galera::CertIndexSpill::find(const KeySet::KeyPart& kp, Ref& ref) const
+{
+    for (Generations::const_reverse_iterator g(gens_.rbegin());
+         g != gens_.rend(); ++g)
+    {
+        const Record* const r((*g)->find(kp));
+
+        if (NULL == r) continue;
+
+        if (ref.seqno_ < 0 && r->seqno_ > purged_)
+        {
+            ref.seqno_  = r->seqno_;
+            ref.source_ = &r->source_;
+            ref.toi_    = (r->flags_ & Record::F_TOI) != 0;
+        }
+
+        if (ref.shared_seqno_ < 0 && r->shared_seqno_ > purged_)
+        {
+            ref.shared_seqno_ = r->shared_seqno_;
+        }
+
+        if (ref.seqno_ >= 0 && ref.shared_seqno_ >= 0) break;
+    }
+}
+
+namespace
+{
+    /* selects entries to spill and unreferenced ones to drop */
+    class SpillSelect
+    {
+    public:
+
+        SpillSelect(wsrep_seqno_t const seqno, wsrep_seqno_t const purged,
+                    std::vector<galera::KeyEntryNG*>& spill,
+                    std::vector<galera::KeyEntryNG*>& drop)
+            : seqno_(seqno), purged_(purged), spill_(spill), drop_(drop)
+        {}
+
+        void operator()(galera::KeyEntryNG* const kep) const
+        {
+            const galera::TrxHandle* const trx(kep->ref_trx());
+            wsrep_seqno_t const s(trx ? trx->global_seqno() : -1);
+            wsrep_seqno_t const ss(kep->ref_shared_seqno() > purged_ ?
+                                   kep->ref_shared_seqno() : -1);
+
+            if (std::max(s, ss) > seqno_) return;
+
+            if (s < 0 && ss < 0)
+                drop_.push_back(kep);  // only stale shared reference left
+            else
+                spill_.push_back(kep);
+        }
+
+    private:
+
+        wsrep_seqno_t const               seqno_;
+        wsrep_seqno_t const               purged_;
+        std::vector<galera::KeyEntryNG*>& spill_;
+        std::vector<galera::KeyEntryNG*>& drop_;
+    };
+}
+
+size_t
+galera::CertIndexSpill::spill(CertIndexNG& index, wsrep_seqno_t const seqno)
+{
+    std::vector<KeyEntryNG*> spill;
+    std::vector<KeyEntryNG*> drop;
+
+    index.for_each(SpillSelect(seqno, purged_, spill, drop));
+
+    if (!spill.empty())
+    {
+        /* may throw, index is not modified yet */
+        Generation* const gen(new Generation(next_name(), spill.size()));
+        Record* rec(gen->begin());
+        wsrep_seqno_t max_seqno(WSREP_SEQNO_UNDEFINED);
+
+        for (size_t i(0); i < spill.size(); ++i, ++rec)
+        {
+            const KeyEntryNG&      ke(*spill[i]);
+            const KeySet::KeyPart& kp(ke.key());
+            const TrxHandle* const trx(ke.ref_trx());
+
+            memset(rec, 0, sizeof(*rec));
+            memcpy(rec->key_, kp.ptr(),
+                   std::min(kp.serial_size(), sizeof(rec->key_)));
+
+            rec->seqno_        = trx ? trx->global_seqno() :
+                                 WSREP_SEQNO_UNDEFINED;
+            rec->shared_seqno_ = ke.ref_shared_seqno() > purged_ ?
+                                 ke.ref_shared_seqno() : WSREP_SEQNO_UNDEFINED;
+            rec->source_       = trx ? trx->source_id() : WSREP_UUID_UNDEFINED;
+            rec->flags_        = (trx && trx->is_toi()) ? Record::F_TOI : 0;
+
+            max_seqno = std::max(max_seqno,
+                                 std::max(rec->seqno_, rec->shared_seqno_));
+        }
+
+        gen->seal(spill.size(), max_seqno);
+        std::sort(gen->begin(), gen->end(), hash_less);
+
+        gens_.push_back(gen);
+    }
+
+    spill.insert(spill.end(), drop.begin(), drop.end());
+
+    for (size_t i(0); i < spill.size(); ++i)
+    {
+        index.erase(spill[i]);
+        spill[i]->unref_all();
+        delete spill[i];
+    }
+
+    if (spilled_ < seqno) spilled_ = seqno;
+
+    if (gens_.size() > MAX_GENERATIONS) merge();
+
+    return spill.size();
+}
+
+void
+galera::CertIndexSpill::combine(Record& rec, const Record& older) const
+{
+    if (rec.seqno_ <= purged_ && older.seqno_ > purged_)
+    {
+        rec.seqno_  = older.seqno_;
+        rec.source_ = older.source_;
+        rec.flags_  = older.flags_;
+    }
+
+    if (rec.shared_seqno_ <= purged_)
+    {
+        rec.shared_seqno_ = older.shared_seqno_;
+    }
+}
+
+void
+galera::CertIndexSpill::merge()
+{
+    assert(gens_.size() >= 2);
+
+    const Generation& a(*gens_[0]); // older
+    const Generation& b(*gens_[1]);
+
+    Generation* const gen(new Generation(next_name(), a.count() + b.count()));
+    Record*       out(gen->begin());
+    const Record* ia(a.begin());
+    const Record* ib(b.begin());
+    std::vector<bool> used;
+
+    while (ia != a.end() || ib != b.end())
+    {
+        if (ib == b.end() || (ia != a.end() && hash(*ia) < hash(*ib)))
+        {
+            if (live(*ia)) *out++ = *ia;
+            ++ia;
+        }
+        else if (ia == a.end() || hash(*ib) < hash(*ia))
+        {
+            if (live(*ib)) *out++ = *ib;
+            ++ib;
+        }
+        else
+        {
+            /* runs of equal hashes, usually one record each */
+            uint64_t const h(hash(*ia));
+            const Record* const run(ia);
+            const Record* ea(ia);
+            while (ea != a.end() && hash(*ea) == h) ++ea;
+
+            used.assign(ea - ia, false);
+
+            for (; ib != b.end() && hash(*ib) == h; ++ib)
+            {
+                Record rec(*ib);
+
+                for (const Record* r(ia); r != ea; ++r)
+                {
+                    if (r->key().matches(ib->key()))
+                    {
+                        combine(rec, *r);
+                        used[r - run] = true;
+                        break;
+                    }
+                }
+
+                if (live(rec)) *out++ = rec;
+            }
+
+            for (; ia != ea; ++ia)
+            {
+                if (!used[ia - run] && live(*ia)) *out++ = *ia;
+            }
+        }
+    }
+
+    size_t const count(out - gen->begin());
+
+    log_debug << "Merged cert index spill generations of " << a.count()
+              << " and " << b.count() << " records into " << count;
+
+    gen->seal(count, std::max(a.max_seqno(), b.max_seqno()));
+
+    delete gens_[0];
+    delete gens_[1];
+    gens_.pop_front();
+
+    if (count > 0)
+    {
+        gens_[0] = gen;
+    }
+    else
+    {
+        gens_.pop_front();
+        delete gen;
+    }
+}
+
+void
+galera::CertIndexSpill::purge(wsrep_seqno_t const seqno)
+{
+    if (purged_ >= seqno) return;
+
+    purged_ = seqno;
+
+    for (Generations::iterator g(gens_.begin()); g != gens_.end();)
+    {
+        if ((*g)->max_seqno() <= purged_)
+        {
+            delete *g;
+            g = gens_.erase(g);
+        }
+        else ++g;
+    }
+}
+
+void
+galera::CertIndexSpill::clear()
+{
+    for (size_t i(0); i < gens_.size(); ++i) delete gens_[i];
+
+    gens_.clear();
+    purged_  = WSREP_SEQNO_UNDEFINED;
+    spilled_ = WSREP_SEQNO_UNDEFINED;
+}
+
+size_t
+galera::CertIndexSpill::size() const
+{
+    size_t ret(0);
+
+    for (size_t i(0); i < gens_.size(); ++i) ret += gens_[i]->count();
+
+    return ret;
+}
+
+std::string
+galera::CertIndexSpill::next_name() const
+{
+    static gu::Atomic<long> files(0);
+
+    return (dir_ + "/cert_spill." + gu::to_string(getpid()) + '.' +
+            gu::to_string(files.add_and_fetch(1)));
+}
@@ -0,0 +1,183 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_CERT_INDEX_SPILL_HPP
+#define GALERA_CERT_INDEX_SPILL_HPP
+
+#include "cert_index_ng.hpp"
+
+#include <gu_fdesc.hpp>
+#include <gu_mmap.hpp>
+
+#include <deque>
+#include <string>
+
+namespace galera
+{
+    /*!
+     * Cold part of a version 3 cert index shard. When certification window
+     * grows long (e.g. some node does not let the index to be purged),
+     * entries that were not referenced for a while are moved out of
+     * CertIndexNG into generations: arrays of compact records sorted by key
+     * hash in unlinked memory mapped files, so that they are backed by
+     * page cache instead of process heap.
+     *
+     * A record keeps everything certification needs from the entry: key
+     * hash data, exclusive reference seqno, its source and isolation mode,
+     * and the latest shared reference seqno. It does not point to trx, so
+     * spilled trxs can be purged as usual. References up to the purge
+     * seqno are ignored and a generation is dropped when all its
+     * references are purged.
+     *
+     * Lookups go through generations from the newest to the oldest.
+     * Generations above MAX_GENERATIONS are merged. Not thread safe.
+     */
+    class CertIndexSpill
+    {
+    public:
+
+        /*! latest references to a key, source_ stays valid until
+         *  the spill is modified */
+        struct Ref
+        {
+            Ref() :
+                seqno_       (WSREP_SEQNO_UNDEFINED),
+                shared_seqno_(WSREP_SEQNO_UNDEFINED),
+                source_      (NULL),
+                toi_         (false)
+            {}
+
+            wsrep_seqno_t       seqno_;        // exclusive reference
+            wsrep_seqno_t       shared_seqno_; // shared reference
+            const wsrep_uuid_t* source_;       // exclusive reference source
+            bool                toi_;          // exclusive reference is TOI
+        };
+
+        explicit CertIndexSpill(const std::string& dir = ".");
+        ~CertIndexSpill();
+
+        /*! directory for generation files */
+        void set_dir(const std::string& dir) { dir_ = dir; }
+
+        bool empty() const { return gens_.empty(); }
+
+        /*! fills in unknown (undefined) fields of ref with the latest
+         *  references to kp found in generations */
+        void find(const KeySet::KeyPart& kp, Ref& ref) const;
+
+        /*! moves entries with all references up to seqno from index into a
+         *  new generation. Entries must not have references to trxs which
+         *  are not certified yet.
+         *  @return number of entries removed from index */
+        size_t spill(CertIndexNG& index, wsrep_seqno_t seqno);
+
+        /*! references up to seqno have been purged */
+        void purge(wsrep_seqno_t seqno);
+
+        /*! @return true if entries referenced by seqno could be spilled */
+        bool covers(wsrep_seqno_t const seqno) const
+        {
+            return (seqno <= spilled_);
+        }
+
+        /*! drops all generations */
+        void clear();
+
+        /*! number of records in all generations */
+        size_t size() const;
+
+    private:
+
+        static size_t const MAX_GENERATIONS = 8;
+
+        struct Record
+        {
+            uint64_t      key_[2]; // key part hash data with header
+            wsrep_seqno_t seqno_;
+            wsrep_seqno_t shared_seqno_;
+            wsrep_uuid_t  source_;
+            uint32_t      flags_;
+            uint32_t      pad_;
+
+            static uint32_t const F_TOI = 1;
+
+            KeySet::KeyPart key() const
+            {
+                return KeySet::KeyPart(reinterpret_cast<const gu::byte_t*>
+                                       (key_));
+            }
+        };
+
+        class Generation
+        {
+        public:
+
+            /* file is unlinked right away, only the mapping refers to it */
+            Generation(const std::string& name, size_t count);
+
+            Record*       begin()       { return recs(); }
+            Record*       end()         { return recs() + count_; }
+            const Record* begin() const { return recs(); }
+            const Record* end()   const { return recs() + count_; }
+
+            size_t        count()     const { return count_; }
+            wsrep_seqno_t max_seqno() const { return max_seqno_; }
+
+            /* sets the number of valid records and the latest seqno */
+            void seal(size_t count, wsrep_seqno_t max_seqno);
+
+            /* @return record matching kp or NULL */
+            const Record* find(const KeySet::KeyPart& kp) const;
+
+        private:
+
+            Record* recs() const { return static_cast<Record*>(mmap_.ptr); }
+
+            gu::FileDescriptor fd_;
+            gu::MMap           mmap_;
+            size_t             count_;
+            wsrep_seqno_t      max_seqno_;
+
+            Generation(const Generation&);
+            Generation& operator=(const Generation&);
+        };
+
+        typedef std::deque<Generation*> Generations; // oldest first
+
+        static uint64_t hash(const Record& r) { return r.key().hash(); }
+
+        static bool hash_less(const Record& a, const Record& b)
+        {
+            return hash(a) < hash(b);
+        }
+
+        static bool hash_below(const Record& r, uint64_t const h)
+        {
+            return hash(r) < h;
+        }
+
+        /* fills in references of rec which are purged from older */
+        void combine(Record& rec, const Record& older) const;
+
+        bool live(const Record& r) const
+        {
+            return (r.seqno_ > purged_ || r.shared_seqno_ > purged_);
+        }
+
+        std::string next_name() const;
+
+        /* merges the two oldest generations into one */
+        void merge();
+
+        std::string       dir_;
+        Generations       gens_;
+        wsrep_seqno_t     purged_;  // references up to it are ignored
+        wsrep_seqno_t     spilled_; // highest seqno spilled so far
+
+        CertIndexSpill(const CertIndexSpill&);
+        CertIndexSpill& operator=(const CertIndexSpill&);
+    };
+}
+
+#endif // GALERA_CERT_INDEX_SPILL_HPP
@@ -3,12 +3,15 @@
 //
 
 #include "certification.hpp"
+#include "galera_common.hpp"
 #include "uuid.hpp"
 
 #include "gu_lock.hpp"
 #include "gu_throw.hpp"
+#include "gu_vector.hpp"
 
 #include <map>
+#include <sstream>
 
 using namespace galera;
 
@@ -28,8 +31,16 @@ static std::string const CERT_PARAM_MAX_LENGTH   (CERT_PARAM_PREFIX +
                                                   "max_length");
 static std::string const CERT_PARAM_LENGTH_CHECK (CERT_PARAM_PREFIX +
                                                   "length_check");
+static std::string const CERT_PARAM_KEYED_TOI    (CERT_PARAM_PREFIX +
+                                                  "keyed_toi");
+static std::string const CERT_PARAM_SPILL_KEYS   (CERT_PARAM_PREFIX +
+                                                  "spill_keys");
 
 static std::string const CERT_PARAM_LOG_CONFLICTS_DEFAULT("no");
+/* affects only local apply parallelism, nodes may differ */
+static std::string const CERT_PARAM_KEYED_TOI_DEFAULT("no");
+/* local memory usage trade-off, nodes may differ */
+static std::string const CERT_PARAM_SPILL_KEYS_DEFAULT("0");
 
 /*** It is EXTREMELY important that these constants are the same on all nodes.
  *** Don't change them ever!!! ***/
@@ -40,6 +51,8 @@ void
 galera::Certification::register_params(gu::Config& cnf)
 {
     cnf.add(CERT_PARAM_LOG_CONFLICTS, CERT_PARAM_LOG_CONFLICTS_DEFAULT);
+    cnf.add(CERT_PARAM_KEYED_TOI,     CERT_PARAM_KEYED_TOI_DEFAULT);
+    cnf.add(CERT_PARAM_SPILL_KEYS,    CERT_PARAM_SPILL_KEYS_DEFAULT);
     /* The defaults below are deliberately not reflected in conf: people
      * should not know about these dangerous setting unless they read RTFM. */
     cnf.add(CERT_PARAM_MAX_LENGTH);
@@ -109,8 +122,10 @@ galera::Certification::purge_for_trx_v1to2(TrxHandle* trx)
 }
 
 void
-galera::Certification::purge_for_trx_v3(TrxHandle* trx)
+galera::Certification::purge_for_trx_v3(TrxHandle* trx, int const shard)
 {
+    CertIndexNG& index(shards_[shard].index_);
+
     const KeySetIn& keys(trx->write_set_in().keyset());
     keys.rewind();
 
@@ -118,41 +133,159 @@ galera::Certification::purge_for_trx_v3(TrxHandle* trx)
     for (long i = 0; i < keys.count(); ++i)
     {
         const KeySet::KeyPart& kp(keys.next());
-        KeySet::Key::Prefix const p(kp.prefix());
 
-        KeyEntryNG ke(kp);
-        CertIndexNG::iterator const ci(cert_index_ng_.find(&ke));
+        if (Certification::shard(kp) != shard) continue;
 
-//        assert(ci != cert_index_ng_.end());
-        if (gu_unlikely(cert_index_ng_.end() == ci))
+        /* shared references are dropped in bulk by sweep_shared_v3(),
+         * which saves index lookup for every shared key */
+        if (kp.shared())
         {
-            log_warn << "Missing key";
+            ++shards_[shard].stale_;
+            continue;
+        }
+
+        KeyEntryNG* const kep(index.find(kp));
+
+//        assert(kep != NULL);
+        if (gu_unlikely(NULL == kep))
+        {
+            /* spilled entries are purged by their seqnos */
+            if (!shards_[shard].spill_.covers(trx->global_seqno()))
+            {
+                log_warn << "Missing key";
+            }
             continue;
         }
 
-        KeyEntryNG* const kep(*ci);
         assert(kep->referenced());
 
-        if (kep->ref_trx(p) == trx)
+        if (kep->ref_trx() == trx)
         {
-            kep->unref(p, trx);
+            kep->unref(trx);
+
+            /* trxs are purged in seqno order, so shared reference up to
+             * this one is stale as well */
+            kep->unref_shared(trx->global_seqno());
 
             if (kep->referenced() == false)
             {
-                cert_index_ng_.erase(ci);
+                index.erase(kep);
+                --index_size_ng_;
                 delete kep;
             }
         }
     }
 }
 
+
+namespace
+{
+    class SharedSweep
+    {
+    public:
+
+        SharedSweep(wsrep_seqno_t const seqno,
+                    std::vector<galera::KeyEntryNG*>& unreferenced)
+            : seqno_(seqno), unreferenced_(unreferenced)
+        {}
+
+        void operator()(galera::KeyEntryNG* const kep) const
+        {
+            kep->unref_shared(seqno_);
+            if (kep->referenced() == false) unreferenced_.push_back(kep);
+        }
+
+    private:
+
+        wsrep_seqno_t const               seqno_;
+        std::vector<galera::KeyEntryNG*>& unreferenced_;
+    };
+}
+
+
 void
-galera::Certification::purge_for_trx(TrxHandle* trx)
+galera::Certification::sweep_shared_v3(int const shard,
+                                       wsrep_seqno_t const seqno)
 {
-    if (trx->new_version())
-        purge_for_trx_v3(trx);
-    else
-        purge_for_trx_v1to2(trx);
+    CertIndexNG& index(shards_[shard].index_);
+    std::vector<KeyEntryNG*> unreferenced;
+
+    /* entries can't be erased while iterating */
+    index.for_each(SharedSweep(seqno, unreferenced));
+
+    for (size_t i(0); i < unreferenced.size(); ++i)
+    {
+        index.erase(unreferenced[i]);
+        delete unreferenced[i];
+    }
+
+    index_size_ng_.sub_and_fetch(unreferenced.size());
+    shards_[shard].stale_ = 0;
+}
+
+
+void
+galera::Certification::purge_trxs(const TrxVector& purged)
+{
+    if (purged.empty()) return;
+
+    bool have_v3(false);
+
+    for (TrxVector::const_iterator i(purged.begin());
+         false == have_v3 && i != purged.end(); ++i)
+    {
+        have_v3 = ((*i)->new_version() && (*i)->depends_seqno() > -1);
+    }
+
+    /* walk the shards one by one so that certification is blocked at most
+     * on one shard at a time */
+    for (int s(0); have_v3 && s < N_SHARDS; ++s)
+    {
+        gu::Lock lock(shards_[s].mutex_);
+
+        for (TrxVector::const_iterator i(purged.begin()); i != purged.end();
+             ++i)
+        {
+            TrxHandle* const trx(*i);
+
+            if (trx->new_version() && trx->depends_seqno() > -1)
+            {
+                purge_for_trx_v3(trx, s);
+            }
+        }
+
+        /* sweep when about half of the shard could be stale, so that the
+         * cost of the walk is amortized over the skipped references */
+        CertIndexShard& cs(shards_[s]);
+        if (cs.stale_ >= SWEEP_THRESHOLD &&
+            cs.stale_ >= cs.index_.size() / 2)
+        {
+            sweep_shared_v3(s, purged.back()->global_seqno());
+        }
+
+        cs.spill_.purge(purged.back()->global_seqno());
+    }
+
+    for (TrxVector::const_iterator i(purged.begin()); i != purged.end(); ++i)
+    {
+        TrxHandle* const trx(*i);
+        {
+            TrxHandleLock lock(*trx);
+
+            if (trx->is_committed() == false)
+            {
+                log_warn << "trx not committed in purge and discard: "
+                         << *trx;
+            }
+
+            if (trx->refcnt() > 1)
+            {
+                log_debug << "trx "     << trx->trx_id()
+                          << " refcnt " << trx->refcnt();
+            }
+        }
+        trx->unref();
+    }
 }
 
 
@@ -340,7 +473,7 @@ galera::Certification::do_test_v1to2(TrxHandle* trx, bool store_keys)
                               cert_index_,
                               key,
                               store_keys,
-                              log_conflicts_) == false)
+                              log_conflicts_()) == false)
             {
                 goto cert_fail;
             }
@@ -474,39 +607,68 @@ cert_fail:
 }
 
 
-/*! for convenience returns true if conflict and false if not */
+/*! for convenience returns true if conflict and false if not,
+ *  found is NULL if the key is not in the index (but may be spilled) */
 static inline bool
 certify_and_depend_v3(const galera::KeyEntryNG*   const found,
+                      const galera::CertIndexSpill&     spill,
                       const galera::KeySet::KeyPart&    key,
                       galera::TrxHandle*          const trx,
                       bool                        const log_conflict)
 {
-    const galera::TrxHandle* const ref_trx(
-        found->ref_trx(galera::KeySet::Key::P_EXCLUSIVE));
+    const galera::TrxHandle* const ref_trx(found ? found->ref_trx() : NULL);
+    galera::CertIndexSpill::Ref    ref;
 
-    if (cert_debug_on && ref_trx)
+    if (ref_trx)
+    {
+        ref.seqno_  = ref_trx->global_seqno();
+        ref.source_ = &ref_trx->source_id();
+        ref.toi_    = ref_trx->is_toi();
+    }
+
+    if (found) ref.shared_seqno_ = found->ref_shared_seqno();
+
+    /* references older than the index entry may be spilled */
+    if (gu_unlikely(!spill.empty()) &&
+        (ref.seqno_ < 0 || ref.shared_seqno_ < 0))
+    {
+        spill.find(key, ref);
+    }
+
+    if (cert_debug_on && ref.seqno_ > 0)
     {
         cert_debug << "exclusive match: "
-                   << *trx << " <-----> " << *ref_trx;
+                   << *trx << " <-----> " << ref.seqno_;
     }
 
-    wsrep_seqno_t const ref_seqno(ref_trx ? ref_trx->global_seqno() : -1);
+    wsrep_seqno_t const ref_seqno(ref.seqno_);
 
     // trx should not have any references in index at this point
     assert(ref_trx != trx);
 
-    if (gu_likely(0 != ref_trx))
+    if (gu_likely(ref_seqno > 0))
     {
         // cert conflict takes place if
         // 1) write sets originated from different nodes, are within cert range
         // 2) ref_trx is in isolation mode, write sets are within cert range
-        if ((trx->source_id() != ref_trx->source_id() || ref_trx->is_toi()) &&
+        // isolated trx itself never fails, it only collects dependencies
+        if (!trx->is_toi() &&
+            (trx->source_id() != *ref.source_ || ref.toi_) &&
             ref_seqno >  trx->last_seen_seqno())
         {
             if (gu_unlikely(log_conflict == true))
             {
-                log_info << "trx conflict for key " << key << ": "
-                         << *trx << " <--X--> " << *ref_trx;
+                if (ref_trx)
+                {
+                    log_info << "trx conflict for key " << key << ": "
+                             << *trx << " <--X--> " << *ref_trx;
+                }
+                else
+                {
+                    log_info << "trx conflict for key " << key << ": "
+                             << *trx << " <--X--> spilled seqno "
+                             << ref_seqno << " from " << *ref.source_;
+                }
             }
             return true;
         }
@@ -515,21 +677,23 @@ certify_and_depend_v3(const galera::KeyEntryNG*   const found,
     wsrep_seqno_t depends_seqno(ref_seqno);
     galera::KeySet::Key::Prefix const pfx (key.prefix());
 
+    if (ref_seqno > 0) trx->deps().add(ref_seqno);
+
     if (pfx == galera::KeySet::Key::P_EXCLUSIVE)
         // exclusive keys must depend on shared refs as well
     {
-        const galera::TrxHandle* const ref_shared_trx(
-            found->ref_trx(galera::KeySet::Key::P_SHARED));
+        wsrep_seqno_t const ref_shared_seqno(ref.shared_seqno_);
 
-        assert(ref_shared_trx != trx);
-
-        if (ref_shared_trx)
+        /* shared reference may be already purged, it is committed then
+         * and depending on it is harmless */
+        if (ref_shared_seqno > 0)
         {
-            cert_debug << "shared match: "
-                       << *trx << " <-----> " << *ref_shared_trx;
+            cert_debug << "shared match: " << *trx << " <-----> "
+                       << ref_shared_seqno;
 
-            depends_seqno = std::max(ref_shared_trx->global_seqno(),
-                                     depends_seqno);
+            depends_seqno = std::max(ref_shared_seqno, depends_seqno);
+
+            trx->deps().add(ref_shared_seqno);
         }
     }
 
@@ -541,20 +705,36 @@ certify_and_depend_v3(const galera::KeyEntryNG*   const found,
 
 /* returns true on collision, false otherwise */
 static bool
-certify_v3(galera::Certification::CertIndexNG& cert_index_ng,
+certify_v3(galera::CertIndexNG&                cert_index_ng,
+           const galera::CertIndexSpill&       spill,
            const galera::KeySet::KeyPart&      key,
            galera::TrxHandle*                  trx,
-           bool const store_keys, bool const   log_conflicts)
+           bool const store_keys, bool const   log_conflicts,
+           bool const                          keyed_toi,
+           size_t&                             added)
 {
-    galera::KeyEntryNG ke(key);
-    galera::Certification::CertIndexNG::iterator ci(cert_index_ng.find(&ke));
+    galera::KeyEntryNG* kep(cert_index_ng.find(key));
 
-    if (cert_index_ng.end() == ci)
+    // Note: For we skip certification for isolated trxs, only
+    // cert index and key_list is populated. With keyed TOI isolated trx
+    // depends only on the write sets that touched the same keys.
+    bool const certify(!trx->is_toi() || keyed_toi);
+
+    if (NULL == kep)
     {
+        /* spilled key must be certified before the entry is created:
+         * entry of the failed key is not cleaned up */
+        if (gu_unlikely(!spill.empty()) && certify &&
+            certify_and_depend_v3(NULL, spill, key, trx, log_conflicts))
+        {
+            return true;
+        }
+
         if (store_keys)
         {
-            galera::KeyEntryNG* const kep(new galera::KeyEntryNG(ke));
-            ci = cert_index_ng.insert(kep).first;
+            kep = new galera::KeyEntryNG(key);
+            cert_index_ng.insert(kep);
+            ++added;
 
             cert_debug << "created new entry";
         }
@@ -564,70 +744,146 @@ certify_v3(galera::Certification::CertIndexNG& cert_index_ng,
     {
         cert_debug << "found existing entry";
 
-        galera::KeyEntryNG* const kep(*ci);
-        // Note: For we skip certification for isolated trxs, only
-        // cert index and key_list is populated.
-        return (!trx->is_toi() &&
-                certify_and_depend_v3(kep, key, trx, log_conflicts));
+        return (certify &&
+                certify_and_depend_v3(kep, spill, key, trx, log_conflicts));
     }
 }
 
-galera::Certification::TestResult
-galera::Certification::do_test_v3(TrxHandle* trx, bool store_keys)
+
+class galera::Certification::ShardsLock
 {
-    cert_debug << "BEGIN CERTIFICATION v3: " << *trx;
+public:
+
+    ShardsLock(Certification& cert, ShardMask const mask)
+        : cert_(cert), mask_(mask)
+    {
+        GU_COMPILE_ASSERT(N_SHARDS <= int(sizeof(ShardMask) << 3),
+                          too_many_shards);
+        GU_COMPILE_ASSERT(0 == (N_SHARDS & (N_SHARDS - 1)),
+                          shards_not_power_of_2);
+
+        for (int s(0); s < N_SHARDS; ++s)
+        {
+            if (mask_ & (1U << s))
+            {
+                int const err(cert_.shards_[s].mutex_.lock());
+
+                if (gu_unlikely(err))
+                {
+                    unlock(s);
+                    gu_throw_error(err) << "Failed to lock cert index shard "
+                                        << s;
+                }
+            }
+        }
+    }
+
+    ~ShardsLock() { unlock(N_SHARDS); }
+
+private:
+
+    /* unlock shards below upto in reverse order */
+    void unlock(int const upto)
+    {
+        for (int s(upto - 1); s >= 0; --s)
+        {
+            if (mask_ & (1U << s)) cert_.shards_[s].mutex_.unlock();
+        }
+    }
+
+    ShardsLock(const ShardsLock&);
+    ShardsLock& operator=(const ShardsLock&);
+
+    Certification&  cert_;
+    ShardMask const mask_;
+};
 
-#ifndef NDEBUG
-    // to check that cleanup after cert failure returns cert_index_
-    // to original size
-    size_t prev_cert_index_size(cert_index_.size());
-#endif // NDEBUG
+
+void
+galera::Certification::prepare(TrxHandle* const trx)
+{
+    if (!trx->new_version() || trx->cert_parts_.size() > 0) return;
 
     const KeySetIn& key_set(trx->write_set_in().keyset());
     long const      key_count(key_set.count());
-    long            processed(0);
+    ShardMask       shards(0);
 
+    trx->cert_parts_.reserve(key_count);
 
     key_set.rewind();
+    for (long i(0); i < key_count; ++i)
+    {
+        trx->cert_parts_().push_back(key_set.next());
+        shards |= (1U << shard(trx->cert_parts_[i]));
+    }
+
+    trx->cert_shards_ = shards;
+}
+
+
+galera::Certification::TestResult
+galera::Certification::do_test_v3(TrxHandle* trx, bool store_keys)
+{
+    cert_debug << "BEGIN CERTIFICATION v3: " << *trx;
+
+    prepare(trx); // no-op if done before entering local monitor
+
+    const gu::Vector<KeySet::KeyPart, 16>& keys(trx->cert_parts_);
+    long const key_count(keys.size());
+    long       processed(0);
+    size_t     added(0); // new entries added to the index
+
+    assert(key_count == trx->write_set_in().keyset().count());
+
+    /* lock only the shards touched by this key set */
+    ShardsLock lock(*this, trx->cert_shards_);
+
+    /* index slots are scattered all over memory: keep CERT_PREFETCH slot
+     * loads in flight ahead of the probes */
+    for (long i(0); i < key_count && i < CERT_PREFETCH; ++i)
+    {
+        shards_[shard(keys[i])].index_.prefetch(keys[i]);
+    }
 
     for (; processed < key_count; ++processed)
     {
-        const KeySet::KeyPart& key(key_set.next());
+        const KeySet::KeyPart& key(keys[processed]);
 
-        if (certify_v3(cert_index_ng_, key, trx, store_keys, log_conflicts_))
+        if (processed + CERT_PREFETCH < key_count)
+        {
+            const KeySet::KeyPart& ahead(keys[processed + CERT_PREFETCH]);
+            shards_[shard(ahead)].index_.prefetch(ahead);
+        }
+
+        CertIndexShard& cs(shards_[shard(key)]);
+
+        if (certify_v3(cs.index_, cs.spill_, key, trx, store_keys,
+                       log_conflicts_(), keyed_toi(trx), added))
         {
             goto cert_fail;
         }
     }
 
-    trx->set_depends_seqno(std::max(trx->depends_seqno(), last_pa_unsafe_));
-
     if (store_keys == true)
     {
         assert (key_count == processed);
 
-        key_set.rewind();
         for (long i(0); i < key_count; ++i)
         {
-            const KeySet::KeyPart& k(key_set.next());
-            KeyEntryNG ke(k);
-            CertIndexNG::const_iterator ci(cert_index_ng_.find(&ke));
+            const KeySet::KeyPart& k(keys[i]);
+            KeyEntryNG* const kep(shards_[shard(k)].index_.find(k));
 
-            if (ci == cert_index_ng_.end())
+            if (NULL == kep)
             {
                 gu_throw_fatal << "could not find key '" << k
                                << "' from cert index";
             }
 
-            KeyEntryNG* const kep(*ci);
-
             kep->ref(k.prefix(), k, trx);
 
         }
 
-        if (trx->pa_unsafe()) last_pa_unsafe_ = trx->global_seqno();
-
-        key_count_ += key_count;
+        index_size_ng_ += added;
     }
     cert_debug << "END CERTIFICATION (success): " << *trx;
     return TEST_OK;
@@ -638,29 +894,34 @@ cert_fail:
 
     assert (processed < key_count);
 
+    if (store_keys == true)
+    {
+        gu::Lock lock(stats_mutex_);
+        conflict_keys_.add(keys[processed]);
+    }
+
     if (store_keys == true)
     {
         /* Clean up key entries allocated for this trx */
-        key_set.rewind();
 
         /* 'strictly less' comparison is essential in the following loop:
          * processed key failed cert and was not added to index */
         for (long i(0); i < processed; ++i)
         {
-            KeyEntryNG ke(key_set.next());
+            const KeySet::KeyPart& k(keys[i]);
+            CertIndexNG& index(shards_[shard(k)].index_);
 
             // Clean up cert_index_ from entries which were added by this trx
-            CertIndexNG::iterator ci(cert_index_ng_.find(&ke));
+            KeyEntryNG* const kep(index.find(k));
 
-            if (gu_likely(ci != cert_index_ng_.end()))
+            if (gu_likely(kep != NULL))
             {
-                KeyEntryNG* kep(*ci);
-
                 if (kep->referenced() == false)
                 {
                     // kel was added to cert_index_ by this trx -
                     // remove from cert_index_ and fall through to delete
-                    cert_index_ng_.erase(ci);
+                    index.erase(kep);
+                    --added;
                 }
                 else continue;
 
@@ -669,16 +930,18 @@ cert_fail:
                 delete kep;
 
             }
-            else if(ke.key().shared())
+            else if(k.shared())
             {
                 assert(0); // we actually should never be here, the key should
                            // be either added to cert_index_ or be there already
                 log_warn  << "could not find shared key '"
-                          << ke.key() << "' from cert index";
+                          << k << "' from cert index";
             }
             else { /* exclusive can duplicate shared */ }
         }
-        assert(cert_index_.size() == prev_cert_index_size);
+        // to check that cleanup after cert failure returns index
+        // to original size
+        assert(0 == added);
     }
 
     return TEST_FAILED;
@@ -724,32 +987,57 @@ galera::Certification::do_test(TrxHandle* trx, bool store_keys)
 
     TestResult res(TEST_FAILED);
 
-    gu::Lock lock(mutex_); // why do we need that? - e.g. set_trx_committed()
-
-    /* initialize parent seqno */
-    if ((trx->flags() & (TrxHandle::F_ISOLATION | TrxHandle::F_PA_UNSAFE))
-        || trx_map_.empty())
-    {
-        trx->set_depends_seqno(trx->global_seqno() - 1);
-    }
-    else
     {
-        trx->set_depends_seqno(
-            trx_map_.begin()->second->global_seqno() - 1);
+        gu::Lock lock(mutex_); // why do we need that? - e.g. set_trx_committed()
+
+        /* initialize parent seqno */
+        if ((trx->flags() & TrxHandle::F_PA_UNSAFE) ||
+            (trx->is_toi() && !keyed_toi(trx)) || trx_map_.empty())
+        {
+            trx->set_depends_seqno(trx->global_seqno() - 1);
+        }
+        else
+        {
+            trx->set_depends_seqno(
+                trx_map_.begin()->second->global_seqno() - 1);
+        }
+
+        switch (version_)
+        {
+        case 1:
+        case 2:
+            res = do_test_v1to2(trx, store_keys);
+            break;
+        case 3:
+            /* everything below initial parent seqno was purged from index
+             * and the rest of dependencies will be found in the index */
+            trx->deps().reset(trx->depends_seqno());
+            break;
+        default:
+            gu_throw_fatal << "certification test for version "
+                           << version_ << " not implemented";
+        }
     }
 
-    switch (version_)
+    /* version 3 index is protected by shard locks, so mutex_ is released
+     * for the duration of the test to not block purging and
+     * set_trx_committed() */
+    if (3 == version_) res = do_test_v3(trx, store_keys);
+
+    gu::Lock lock(mutex_);
+
+    if (3 == version_ && TEST_OK == res)
     {
-    case 1:
-    case 2:
-        res = do_test_v1to2(trx, store_keys);
-        break;
-    case 3:
-        res = do_test_v3(trx, store_keys);
-        break;
-    default:
-        gu_throw_fatal << "certification test for version "
-                       << version_ << " not implemented";
+        trx->set_depends_seqno(std::max(trx->depends_seqno(),
+                                        last_pa_unsafe_));
+        trx->deps().raise_floor(last_pa_unsafe_);
+
+        if (store_keys == true)
+        {
+            if (trx->pa_unsafe()) last_pa_unsafe_ = trx->global_seqno();
+
+            key_count_ += trx->write_set_in().keyset().count();
+        }
     }
 
     if (store_keys == true && res == TEST_OK)
@@ -759,7 +1047,13 @@ galera::Certification::do_test(TrxHandle* trx, bool store_keys)
         ++n_certified_;
         deps_dist_ += (trx->global_seqno() - trx->depends_seqno());
         cert_interval_ += (trx->global_seqno() - trx->last_seen_seqno() - 1);
-        index_size_ = (cert_index_.size() + cert_index_ng_.size());
+        index_size_ = (cert_index_.size() + index_size_ng_());
+
+        if (3 == version_ && 0 == n_certified_ % HOT_KEYS_SAMPLE)
+        {
+            const gu::Vector<KeySet::KeyPart, 16>& keys(trx->cert_parts_);
+            for (size_t i(0); i < keys.size(); ++i) hot_keys_.add(keys[i]);
+        }
     }
 
     byte_count_ += trx->size();
@@ -813,7 +1107,8 @@ galera::Certification::Certification(gu::Config& conf, ServiceThd& thd)
     version_               (-1),
     trx_map_               (),
     cert_index_            (),
-    cert_index_ng_         (),
+    shards_                (),
+    index_size_ng_         (0),
     deps_set_              (),
     service_thd_           (thd),
     mutex_                 (),
@@ -824,23 +1119,42 @@ galera::Certification::Certification(gu::Config& conf, ServiceThd& thd)
     last_pa_unsafe_        (-1),
     last_preordered_seqno_ (position_),
     last_preordered_id_    (0),
+    purge_requested_       (position_),
+    purged_seqno_          (position_),
     stats_mutex_           (),
     n_certified_           (0),
     deps_dist_             (0),
     cert_interval_         (0),
     index_size_            (0),
+    hot_keys_              (),
+    conflict_keys_         (),
     key_count_             (0),
     byte_count_            (0),
     trx_count_             (0),
 
     max_length_            (max_length(conf)),
     max_length_check_      (length_check(conf)),
-    log_conflicts_         (conf.get<bool>(CERT_PARAM_LOG_CONFLICTS))
-{}
+    log_conflicts_         (conf, CERT_PARAM_LOG_CONFLICTS),
+    keyed_toi_             (conf.get<bool>(CERT_PARAM_KEYED_TOI)),
+    spill_keys_            (conf.get<size_t>(CERT_PARAM_SPILL_KEYS))
+{
+    if (spill_keys_ > 0)
+    {
+        std::string const dir(conf.has(BASE_DIR) ?
+                              conf.get(BASE_DIR, BASE_DIR_DEFAULT) :
+                              BASE_DIR_DEFAULT);
+
+        for (int s(0); s < N_SHARDS; ++s) shards_[s].spill_.set_dir(dir);
+    }
+
+    service_thd_.set_purge(this);
+}
 
 
 galera::Certification::~Certification()
 {
+    service_thd_.set_purge(0);
+
     log_info << "cert index usage at exit "   << cert_index_.size();
     log_info << "cert trx map usage at exit " << trx_map_.size();
     log_info << "deps set usage at exit "     << deps_set_.size();
@@ -855,7 +1169,14 @@ galera::Certification::~Certification()
 
     gu::Lock lock(mutex_);
 
-    for_each(trx_map_.begin(), trx_map_.end(), PurgeAndDiscard(*this));
+    TrxVector purged;
+    detach_trxs_upto_(position_, purged);
+    purge_trxs(purged);
+    for (int s(0); s < N_SHARDS; ++s)
+    {
+        gu::Lock lock(shards_[s].mutex_);
+        sweep_shared_v3(s, position_);
+    }
     service_thd_.release_seqno(position_);
     service_thd_.flush();
 }
@@ -878,13 +1199,24 @@ void galera::Certification::assign_initial_position(wsrep_seqno_t seqno,
                        << version << " not supported";
     }
 
+    // make sure no background purge pass is in progress or pending
+    service_thd_.set_purge(0);
+
     gu::Lock lock(mutex_);
 
     if (seqno >= position_)
     {
-        std::for_each(trx_map_.begin(), trx_map_.end(), PurgeAndDiscard(*this));
+        TrxVector purged;
+        detach_trxs_upto_(position_, purged);
+        purge_trxs(purged);
+        for (int s(0); s < N_SHARDS; ++s)
+        {
+            gu::Lock lock(shards_[s].mutex_);
+            sweep_shared_v3(s, position_);
+            shards_[s].spill_.purge(position_);
+        }
         assert(cert_index_.size() == 0);
-        assert(cert_index_ng_.size() == 0);
+        assert(index_size_ng_() == 0);
     }
     else
     {
@@ -892,12 +1224,19 @@ void galera::Certification::assign_initial_position(wsrep_seqno_t seqno,
                  << seqno;
         std::for_each(cert_index_.begin(), cert_index_.end(),
                       gu::DeleteObject());
-        std::for_each(cert_index_ng_.begin(), cert_index_ng_.end(),
-                      gu::DeleteObject());
+        for (int s(0); s < N_SHARDS; ++s)
+        {
+            gu::Lock lock(shards_[s].mutex_);
+            CertIndexNG& index(shards_[s].index_);
+            index.for_each(gu::DeleteObject());
+            index.clear();
+            shards_[s].stale_ = 0;
+            shards_[s].spill_.clear();
+        }
+        index_size_ng_ = 0;
         std::for_each(trx_map_.begin(), trx_map_.end(),
                       Unref2nd<TrxMap::value_type>());
         cert_index_.clear();
-        cert_index_ng_.clear();
     }
 
     trx_map_.clear();
@@ -911,7 +1250,11 @@ void galera::Certification::assign_initial_position(wsrep_seqno_t seqno,
     last_pa_unsafe_        = seqno;
     last_preordered_seqno_ = position_;
     last_preordered_id_    = 0;
+    purge_requested_       = seqno;
+    purged_seqno_          = seqno;
     version_               = version;
+
+    service_thd_.set_purge(this);
 }
 
 
@@ -928,6 +1271,7 @@ galera::Certification::test(TrxHandle* trx, bool bval)
         // make sure that last depends seqno is -1 for trxs that failed
         // certification
         trx->set_depends_seqno(WSREP_SEQNO_UNDEFINED);
+        trx->deps().invalidate();
     }
 
     return ret;
@@ -950,19 +1294,43 @@ wsrep_seqno_t galera::Certification::get_safe_to_discard_seqno_() const
 
 
 wsrep_seqno_t
-galera::Certification::purge_trxs_upto_(wsrep_seqno_t const seqno,
-                                        bool const          handle_gcache)
+galera::Certification::detach_trxs_upto_(wsrep_seqno_t const seqno,
+                                         TrxVector&          purged,
+                                         size_t const        budget)
 {
-    assert (seqno > 0);
-
-    TrxMap::iterator purge_bound(trx_map_.upper_bound(seqno));
+    TrxMap::iterator const upper_bound(trx_map_.upper_bound(seqno));
+    TrxMap::iterator       purge_bound(trx_map_.begin());
+    size_t                 entries(0);
 
     cert_debug << "purging index up to " << seqno;
 
-    for_each(trx_map_.begin(), purge_bound, PurgeAndDiscard(*this));
-    trx_map_.erase(trx_map_.begin(), purge_bound);
+    for (; purge_bound != upper_bound; ++purge_bound)
+    {
+        if (budget > 0 && entries >= budget) break;
+
+        TrxHandle* const trx(purge_bound->second);
+
+        if (trx->depends_seqno() > -1)
+        {
+            if (!trx->new_version())
+            {
+                TrxHandleLock lock(*trx);
+                entries += trx->cert_keys_.size();
+                purge_for_trx_v1to2(trx);
+            }
+            else
+            {
+                entries += trx->write_set_in().keyset().count();
+            }
+        }
+
+        purged.push_back(trx);
+    }
+
+    wsrep_seqno_t const retval(purge_bound == upper_bound ?
+                               seqno : purge_bound->first - 1);
 
-    if (handle_gcache) service_thd_.release_seqno(seqno);
+    trx_map_.erase(trx_map_.begin(), purge_bound);
 
     if (0 == ((trx_map_.size() + 1) % 10000))
     {
@@ -971,7 +1339,68 @@ galera::Certification::purge_trxs_upto_(wsrep_seqno_t const seqno,
                   << ", real purge seqno: " << trx_map_.begin()->first - 1;
     }
 
-    return seqno;
+    return retval;
+}
+
+
+bool
+galera::Certification::purge_pass(wsrep_seqno_t const seqno)
+{
+    TrxVector     purged;
+    wsrep_seqno_t purge_seqno;
+    bool          more;
+    {
+        gu::Lock lock(mutex_);
+        wsrep_seqno_t const stds(get_safe_to_discard_seqno_());
+        wsrep_seqno_t const upto(std::min(seqno, stds));
+        purge_seqno = detach_trxs_upto_(upto, purged, PURGE_BUDGET);
+        more = (purge_seqno < upto);
+        if (purged_seqno_ < purge_seqno) purged_seqno_ = purge_seqno;
+    }
+    /* index shards are purged without holding mutex_ */
+    purge_trxs(purged);
+    spill_shards();
+    service_thd_.release_seqno(purge_seqno);
+    return more;
+}
+
+
+void
+galera::Certification::spill_shards()
+{
+    if (0 == spill_keys_) return;
+
+    wsrep_seqno_t upto;
+    {
+        gu::Lock lock(mutex_);
+        if (index_size_ng_() <= spill_keys_) return;
+        upto = purged_seqno_ + (position_ - purged_seqno_) / 2;
+    }
+
+    size_t const shard_keys(spill_keys_ / N_SHARDS);
+    size_t spilled(0);
+    size_t total(0);
+
+    for (int s(0); s < N_SHARDS; ++s)
+    {
+        CertIndexShard& cs(shards_[s]);
+        gu::Lock lock(cs.mutex_);
+
+        if (cs.index_.size() > shard_keys)
+        {
+            spilled += cs.spill_.spill(cs.index_, upto);
+        }
+
+        total += cs.spill_.size();
+    }
+
+    if (spilled > 0)
+    {
+        index_size_ng_.sub_and_fetch(spilled);
+
+        log_debug << "Spilled " << spilled << " cert index entries up to "
+                  << upto << ", " << total << " spilled in total";
+    }
 }
 
 
@@ -982,6 +1411,10 @@ galera::Certification::append_trx(TrxHandle* trx)
     assert(trx->global_seqno() > position_);
 
     trx->ref();
+
+    TrxVector     purged;
+    wsrep_seqno_t trim_seqno(WSREP_SEQNO_UNDEFINED);
+    bool          trim(false);
     {
         gu::Lock lock(mutex_);
 
@@ -1009,8 +1442,9 @@ galera::Certification::append_trx(TrxHandle* trx)
             log_debug << "trx map size: " << trx_map_.size()
                       << " - check if status.last_committed is incrementing";
 
-            wsrep_seqno_t       trim_seqno(position_ - max_length_);
-            wsrep_seqno_t const stds      (get_safe_to_discard_seqno_());
+            wsrep_seqno_t const stds(get_safe_to_discard_seqno_());
+
+            trim_seqno = position_ - max_length_;
 
             if (trim_seqno > stds)
             {
@@ -1023,10 +1457,17 @@ galera::Certification::append_trx(TrxHandle* trx)
                 cert_debug << "purging index up to " << trim_seqno;
             }
 
-            purge_trxs_upto_(trim_seqno, true);
+            detach_trxs_upto_(trim_seqno, purged);
+            trim = true;
         }
     }
 
+    if (gu_unlikely(trim))
+    {
+        purge_trxs(purged);
+        service_thd_.release_seqno(trim_seqno);
+    }
+
     const TestResult retval(test(trx));
 
     {
@@ -1052,6 +1493,7 @@ wsrep_seqno_t galera::Certification::set_trx_committed(TrxHandle* trx)
            trx->is_committed() == false);
 
     wsrep_seqno_t ret(-1);
+    bool          spill(false);
     {
         gu::Lock lock(mutex_);
         if (trx->is_certified() == true)
@@ -1069,9 +1511,14 @@ wsrep_seqno_t galera::Certification::set_trx_committed(TrxHandle* trx)
         if (gu_unlikely(index_purge_required()))
         {
             ret = get_safe_to_discard_seqno_();
+
+            /* purge may be stuck, spill is done by the purge pass too */
+            spill = (spill_keys_ > 0 && index_size_ng_() > spill_keys_);
         }
     }
 
+    if (gu_unlikely(spill)) service_thd_.schedule_purge_pass();
+
     trx->mark_committed();
     trx->clear();
 
@@ -1090,16 +1537,34 @@ galera::TrxHandle* galera::Certification::get_trx(wsrep_seqno_t seqno)
     return i->second;
 }
 
+void
+galera::Certification::hot_keys_get(std::string& hot_keys,
+                                    std::string& conflict_keys,
+                                    long long&   conflicts) const
+{
+    std::ostringstream hot;
+    std::ostringstream cfl;
+
+    gu::Lock lock(stats_mutex_);
+
+    hot << hot_keys_;
+    cfl << conflict_keys_;
+
+    hot_keys      = hot.str();
+    conflict_keys = cfl.str();
+    conflicts     = conflict_keys_.total();
+}
+
 void
 galera::Certification::set_log_conflicts(const std::string& str)
 {
     try
     {
-        bool const old(log_conflicts_);
-        log_conflicts_ = gu::Config::from_config<bool>(str);
-        if (old != log_conflicts_)
+        bool const old(log_conflicts_());
+        log_conflicts_.set(str);
+        if (old != log_conflicts_())
         {
-            log_info << (log_conflicts_ ? "Enabled" : "Disabled")
+            log_info << (log_conflicts_() ? "Enabled" : "Disabled")
                      << " logging of certification conflicts.";
         }
     }
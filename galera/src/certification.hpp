@@ -6,20 +6,24 @@
 #define GALERA_CERTIFICATION_HPP
 
 #include "trx_handle.hpp"
-#include "key_entry_ng.hpp"
+#include "cert_index_ng.hpp"
+#include "cert_index_spill.hpp"
+#include "cert_hot_keys.hpp"
 #include "galera_service_thd.hpp"
 
 #include "gu_unordered.hpp"
 #include "gu_lock.hpp"
 #include "gu_config.hpp"
+#include "gu_atomic.hpp"
 
 #include <map>
 #include <set>
 #include <list>
+#include <vector>
 
 namespace galera
 {
-    class Certification
+    class Certification : public ServiceThd::Purge
     {
     public:
 
@@ -30,16 +34,45 @@ namespace galera
         typedef gu::UnorderedSet<KeyEntryOS*,
                                  KeyEntryPtrHash, KeyEntryPtrEqual> CertIndex;
 
-        typedef gu::UnorderedSet<KeyEntryNG*,
-                                 KeyEntryPtrHashNG, KeyEntryPtrEqualNG>
-        CertIndexNG;
+        /* Version 3 cert index is split into N_SHARDS independently locked
+         * shards by key hash. Must be a power of 2 not exceeding the number
+         * of bits in ShardMask. */
+        static int const N_SHARDS = 16;
+
+        typedef unsigned int ShardMask;
+
+        static int shard(const KeySet::KeyPart& kp)
+        {
+            /* index slots are selected by mixed hash, any bits will do */
+            return ((kp.hash() >> SHARD_SHIFT) & (N_SHARDS - 1));
+        }
 
     private:
 
+        static int const SHARD_SHIFT = 16;
+
+        /* how many keys ahead of the current one to prefetch index slots */
+        static long const CERT_PREFETCH = 8;
+
         typedef std::multiset<wsrep_seqno_t>        DepsSet;
 
         typedef std::map<wsrep_seqno_t, TrxHandle*> TrxMap;
 
+        typedef std::vector<TrxHandle*>             TrxVector;
+
+        struct CertIndexShard
+        {
+            CertIndexShard() : mutex_(), index_(), stale_(0), spill_() {}
+
+            gu::Mutex      mutex_;
+            CertIndexNG    index_;
+            size_t         stale_; // shared references skipped by purge
+            CertIndexSpill spill_; // entries moved out of index_
+        };
+
+        /* Locks a set of shards in ascending order, unlocks in destructor */
+        class ShardsLock;
+
     public:
 
         typedef enum
@@ -49,6 +82,12 @@ namespace galera
         } TestResult;
 
         Certification(gu::Config& conf, ServiceThd& thd);
+
+        /* Caches v3 key parts and the set of index shards they map to in
+         * trx. This does not depend on certification order, so it is called
+         * before entering the local monitor and runs concurrently with
+         * certification of preceding write sets. Idempotent. */
+        static void prepare(TrxHandle* trx);
         ~Certification();
 
         void assign_initial_position(wsrep_seqno_t seqno, int versiono);
@@ -66,15 +105,40 @@ namespace galera
         wsrep_seqno_t
         purge_trxs_upto(wsrep_seqno_t const seqno, bool const handle_gcache)
         {
-            gu::Lock lock(mutex_);
-            const wsrep_seqno_t stds(get_safe_to_discard_seqno_());
-            // assert(seqno <= get_safe_to_discard_seqno());
-            // Note: setting trx committed is not done in total order so
-            // safe to discard seqno may decrease. Enable assertion above when
-            // this issue is fixed.
-            return purge_trxs_upto_(std::min(seqno, stds), handle_gcache);
+            TrxVector purged;
+            wsrep_seqno_t purge_seqno;
+            {
+                gu::Lock lock(mutex_);
+                const wsrep_seqno_t stds(get_safe_to_discard_seqno_());
+                // assert(seqno <= get_safe_to_discard_seqno());
+                // Note: setting trx committed is not done in total order so
+                // safe to discard seqno may decrease. Enable assertion above
+                // when this issue is fixed.
+                purge_seqno = std::min(seqno, stds);
+                detach_trxs_upto_(purge_seqno, purged);
+                if (purged_seqno_ < purge_seqno) purged_seqno_ = purge_seqno;
+            }
+            /* index shards are purged without holding mutex_ */
+            purge_trxs(purged);
+            spill_shards();
+            if (handle_gcache) service_thd_.release_seqno(purge_seqno);
+            return purge_seqno;
+        }
+
+        /* Schedules index purge up to seqno to be done by service thread
+         * in bounded passes of PURGE_BUDGET index entries. */
+        void schedule_purge(wsrep_seqno_t const seqno)
+        {
+            {
+                gu::Lock lock(mutex_);
+                if (purge_requested_ < seqno) purge_requested_ = seqno;
+            }
+            service_thd_.schedule_purge(seqno);
         }
 
+        // ServiceThd::Purge interface, releases purged seqnos in gcache
+        bool purge_pass(wsrep_seqno_t seqno);
+
         // Set trx corresponding to handle committed. Return purge seqno if
         // index purge is required, -1 otherwise.
         wsrep_seqno_t set_trx_committed(TrxHandle*);
@@ -96,6 +160,20 @@ namespace galera
             index_size = index_size_;
         }
 
+        // how far background index purge is behind requested purge seqno
+        wsrep_seqno_t purge_lag() const
+        {
+            gu::Lock lock(mutex_);
+            return std::max<wsrep_seqno_t>(purge_requested_ - purged_seqno_,
+                                           0);
+        }
+
+        /* most frequently certified and most conflicting version 3 keys,
+         * total number of conflicts */
+        void hot_keys_get(std::string& hot_keys,
+                          std::string& conflict_keys,
+                          long long&   conflicts) const;
+
         void stats_reset()
         {
             gu::Lock lock(stats_mutex_);
@@ -103,6 +181,8 @@ namespace galera
             deps_dist_ = 0;
             n_certified_ = 0;
             index_size_ = 0;
+            hot_keys_.reset();
+            conflict_keys_.reset();
         }
 
         void set_log_conflicts(const std::string& str);
@@ -113,13 +193,36 @@ namespace galera
         TestResult do_test_v1to2(TrxHandle*, bool);
         TestResult do_test_v3(TrxHandle*, bool);
         TestResult do_test_preordered(TrxHandle*);
-        void purge_for_trx(TrxHandle*);
         void purge_for_trx_v1to2(TrxHandle*);
-        void purge_for_trx_v3(TrxHandle*);
+        void purge_for_trx_v3(TrxHandle*, int shard);
+
+        /* Drops shared references up to seqno from shard and removes the
+         * entries left unreferenced, shard mutex_ must be held. */
+        void sweep_shared_v3(int shard, wsrep_seqno_t seqno);
+
+        /* Purges cert index from trxs detached from trx_map_ walking one
+         * shard at a time and then releases them. Locks index shards,
+         * may be called with or without mutex_ held. */
+        void purge_trxs(const TrxVector&);
+
+        /* Moves older half of the certification window out of index shards
+         * grown over spill_keys_. Locks mutex_ and index shards. */
+        void spill_shards();
 
         // unprotected variants for internal use
         wsrep_seqno_t get_safe_to_discard_seqno_() const;
-        wsrep_seqno_t purge_trxs_upto_(wsrep_seqno_t, bool sync);
+        /* Moves trxs up to and including seqno from trx_map_ to purged,
+         * purging version 1 and 2 cert index on the way. Stops after
+         * trxs holding budget index entries are detached if budget is
+         * non-zero. Returns seqno up to which trx_map_ was purged. */
+        wsrep_seqno_t detach_trxs_upto_(wsrep_seqno_t, TrxVector& purged,
+                                        size_t budget = 0);
+
+        // index entries to purge per background purge pass
+        static size_t const PURGE_BUDGET = 1 << 12;
+
+        // minimum skipped shared references in a shard to sweep it
+        static size_t const SWEEP_THRESHOLD = 1 << 10;
 
         bool index_purge_required()
         {
@@ -136,54 +239,15 @@ namespace galera
                      (key_count_ = 0, byte_count_ = 0, trx_count_ = 0, true));
         }
 
-        class PurgeAndDiscard
-        {
-        public:
-
-            PurgeAndDiscard(Certification& cert) : cert_(cert) { }
-
-            void operator()(TrxMap::value_type& vt) const
-            {
-                {
-                    TrxHandle* trx(vt.second);
-                    TrxHandleLock lock(*trx);
-
-                    if (trx->is_committed() == false)
-                    {
-                        log_warn << "trx not committed in purge and discard: "
-                                 << *trx;
-                    }
-
-                    if (trx->depends_seqno() > -1)
-                    {
-                        cert_.purge_for_trx(trx);
-                    }
-
-                    if (trx->refcnt() > 1)
-                    {
-                        log_debug << "trx "     << trx->trx_id()
-                                  << " refcnt " << trx->refcnt();
-                    }
-                }
-                vt.second->unref();
-            }
-
-            PurgeAndDiscard(const PurgeAndDiscard& other) : cert_(other.cert_)
-            { }
-
-        private:
-
-            void operator=(const PurgeAndDiscard&);
-            Certification& cert_;
-        };
-
         int           version_;
         TrxMap        trx_map_;
         CertIndex     cert_index_;
-        CertIndexNG   cert_index_ng_;
+        CertIndexShard shards_[N_SHARDS]; // mutex_ may be held when locking
+                                          // shards, but never vice versa
+        gu::Atomic<size_t> index_size_ng_;
         DepsSet       deps_set_;
         ServiceThd&   service_thd_;
-        gu::Mutex     mutex_;
+        gu::Mutex     mutex_; // protects everything but cert index shards
         size_t        trx_size_warn_count_;
         wsrep_seqno_t initial_position_;
         wsrep_seqno_t position_;
@@ -191,11 +255,18 @@ namespace galera
         wsrep_seqno_t last_pa_unsafe_;
         wsrep_seqno_t last_preordered_seqno_;
         wsrep_trx_id_t last_preordered_id_;
+        wsrep_seqno_t purge_requested_;
+        wsrep_seqno_t purged_seqno_;
         gu::Mutex     stats_mutex_;
         size_t        n_certified_;
         wsrep_seqno_t deps_dist_;
         wsrep_seqno_t cert_interval_;
         size_t        index_size_;
+        CertHotKeys   hot_keys_;      // from sampled write sets
+        CertHotKeys   conflict_keys_; // from every conflict
+
+        // keys of every HOT_KEYS_SAMPLE-th certified write set are counted
+        static size_t const HOT_KEYS_SAMPLE = 16;
 
         size_t        key_count_;
         size_t        byte_count_;
@@ -210,7 +281,23 @@ namespace galera
 
         unsigned int const max_length_check_; /* Mask how often to check */
 
-        bool               log_conflicts_;
+        gu::Config::Handle<bool> log_conflicts_;
+
+        /* TOI with keys waits only for write sets touching the same keys
+         * instead of everything before it. PA unsafe and keyless TOI are
+         * still fully isolated. */
+        bool const               keyed_toi_;
+
+        /* Number of keys in index above which index shards are spilled to
+         * disk, 0 means never */
+        size_t const             spill_keys_;
+
+        bool keyed_toi(const TrxHandle* const trx) const
+        {
+            return (keyed_toi_ && version_ >= 3 && trx->is_toi() &&
+                    !(trx->flags() & TrxHandle::F_PA_UNSAFE) &&
+                    trx->write_set_in().keyset().count() > 0);
+        }
     };
 }
 
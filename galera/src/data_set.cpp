@@ -4,3 +4,62 @@
 
 #include "data_set.hpp"
 
+
+#include "gu_throw.hpp"
+
+#include <zlib.h>
+
+/* VER2 payload: uleb128 encoded size of uncompressed data followed by
+ * zlib stream */
+
+void
+galera::DataSet::compress (const gu::byte_t* const src,
+                           size_t            const size,
+                           int               const level,
+                           gu::Buffer&             out)
+{
+    size_t const prefix(gu::uleb128_size(size));
+    uLongf       csize (compressBound(size));
+
+    out.resize(prefix + csize);
+
+    gu::uleb128_encode(size, &out[0], prefix, 0);
+
+    int const err(compress2(&out[prefix], &csize, src, size, level));
+
+    if (gu_unlikely(Z_OK != err))
+    {
+        gu_throw_error (ENOMEM) << "Failed to compress " << size
+                                << " bytes of data set: " << zError(err);
+    }
+
+    out.resize(prefix + csize);
+}
+
+void
+galera::DataSet::decompress (const gu::byte_t* const src,
+                             size_t            const size,
+                             gu::Buffer&             out)
+{
+    size_t       dsize;
+    size_t const prefix(gu::uleb128_decode(src, size, 0, dsize));
+    uLongf       usize (dsize);
+
+    if (gu_unlikely(0 == dsize))
+    {
+        gu_throw_error (EPROTO) << "Empty compressed data set";
+    }
+
+    out.resize(dsize);
+
+    int const err(uncompress(&out[0], &usize, src + prefix, size - prefix));
+
+    if (gu_unlikely(Z_OK != err || usize != dsize))
+    {
+        out.clear();
+        gu_throw_error (EPROTO) << "Failed to decompress data set of "
+                                << size << " bytes: " << zError(err)
+                                << ", size " << usize << ", expected "
+                                << dsize;
+    }
+}
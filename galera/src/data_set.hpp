@@ -8,6 +8,7 @@
 
 #include "gu_rset.hpp"
 #include "gu_vlq.hpp"
+#include "gu_buffer.hpp"
 
 
 namespace galera
@@ -19,10 +20,21 @@ namespace galera
         enum Version
         {
             EMPTY = 0,
-            VER1
+            VER1,
+            VER2  /* VER1 with compressed payload */
         };
 
-        static Version const MAX_VERSION = VER1;
+        static Version const MAX_VERSION = VER2;
+
+        static int const DEFAULT_COMPRESSION_LEVEL = 1;
+
+        /*! Compresses size bytes from src to out (VER2 payload format) */
+        static void compress (const gu::byte_t* src, size_t size, int level,
+                              gu::Buffer& out);
+
+        /*! Decompresses VER2 payload of size bytes from src to out */
+        static void decompress (const gu::byte_t* src, size_t size,
+                                gu::Buffer& out);
 
         static Version version (unsigned int ver)
         {
@@ -79,27 +91,43 @@ namespace galera
 
         DataSetOut () // empty ctor for slave TrxHandle
             :
-            gu::RecordSetOut<DataSet::RecordOut>(), version_()
+            gu::RecordSetOut<DataSet::RecordOut>(), version_(), level_(),
+            raw_(), comp_()
         {}
 
         DataSetOut (gu::byte_t*             reserved,
                     size_t                  reserved_size,
                     const BaseName&         base_name,
-                    DataSet::Version        version)
+                    DataSet::Version        version,
+                    int                     level =
+                    DataSet::DEFAULT_COMPRESSION_LEVEL,
+                    gu::RecordSet::CheckType ct = gu::RecordSet::CHECK_MMH128)
             :
             gu::RecordSetOut<DataSet::RecordOut> (
                 reserved,
                 reserved_size,
                 base_name,
-                check_type      (version),
+                check_type      (version, ct),
                 ds_to_rs_version(version)
                 ),
-            version_(version)
+            version_(version),
+            level_  (level),
+            raw_    (),
+            comp_   ()
         {}
 
         size_t
         append (const void* const src, size_t const size, bool const store)
         {
+            if (DataSet::VER2 == version_)
+            {
+                /* collect data to be compressed at once in gather() */
+                const gu::byte_t* const ptr(static_cast<const gu::byte_t*>
+                                            (src));
+                raw_.insert(raw_.end(), ptr, ptr + size);
+                return size;
+            }
+
             /* append data as is, don't count as a new record */
             gu::RecordSetOut<DataSet::RecordOut>::append (src, size, store,
                                                           false);
@@ -108,23 +136,54 @@ namespace galera
             return size;
         }
 
+        int count () const
+        {
+            return (DataSet::VER2 == version_ ?
+                    !raw_.empty() :
+                    gu::RecordSetOut<DataSet::RecordOut>::count());
+        }
+
         DataSet::Version
         version () const { return count() ? version_ : DataSet::EMPTY; }
 
+        /* version to be used for other data sets of the same writeset */
+        DataSet::Version
+        set_version () const { return version_; }
+
+        /* checksum type to be used for other data sets of the same writeset */
+        gu::RecordSet::CheckType
+        set_check_type () const { return check_type_; }
+
         typedef gu::RecordSet::GatherVector GatherVector;
 
+        ssize_t gather (GatherVector& out)
+        {
+            if (DataSet::VER2 == version_ && !raw_.empty() && comp_.empty())
+            {
+                DataSet::compress (&raw_[0], raw_.size(), level_, comp_);
+                gu::RecordSetOut<DataSet::RecordOut>::append (
+                    &comp_[0], comp_.size(), false, false);
+            }
+
+            return gu::RecordSetOut<DataSet::RecordOut>::gather (out);
+        }
+
     private:
 
         // depending on version we may pack data differently
         DataSet::Version const version_;
+        int              const level_;
+        gu::Buffer             raw_;  // VER2 data to compress
+        gu::Buffer             comp_; // VER2 compressed data
 
         static gu::RecordSet::CheckType
-        check_type (DataSet::Version ver)
+        check_type (DataSet::Version ver, gu::RecordSet::CheckType ct)
         {
             switch (ver)
             {
             case DataSet::EMPTY: break; /* Can't create EMPTY DataSetOut */
-            case DataSet::VER1:  return gu::RecordSet::CHECK_MMH128;
+            case DataSet::VER1:
+            case DataSet::VER2:  return ct;
             }
             throw;
         }
@@ -135,7 +194,8 @@ namespace galera
             switch (ver)
             {
             case DataSet::EMPTY: break; /* Can't create EMPTY DataSetOut */
-            case DataSet::VER1:  return gu::RecordSet::VER1;
+            case DataSet::VER1:
+            case DataSet::VER2:  return gu::RecordSet::VER1;
             }
             throw;
         }
@@ -149,27 +209,44 @@ namespace galera
         DataSetIn (DataSet::Version ver, const gu::byte_t* buf, size_t size)
             :
             gu::RecordSetIn<DataSet::RecordIn>(buf, size, false),
-            version_(ver)
+            version_(ver),
+            plain_  ()
         {}
 
         DataSetIn () : gu::RecordSetIn<DataSet::RecordIn>(),
-                       version_(DataSet::EMPTY)
+                       version_(DataSet::EMPTY),
+                       plain_  ()
         {}
 
         void init (DataSet::Version ver, const gu::byte_t* buf, size_t size)
         {
             gu::RecordSetIn<DataSet::RecordIn>::init(buf, size, false);
             version_ = ver;
+            plain_.clear();
         }
 
         gu::Buf next () const
         {
-            return gu::RecordSetIn<DataSet::RecordIn>::next().buf();
+            gu::Buf const buf
+                (gu::RecordSetIn<DataSet::RecordIn>::next().buf());
+
+            if (gu_likely(DataSet::VER2 != version_)) return buf;
+
+            /* decompress on first access */
+            if (plain_.empty())
+            {
+                DataSet::decompress (static_cast<const gu::byte_t*>(buf.ptr),
+                                     buf.size, plain_);
+            }
+
+            gu::Buf const ret = { &plain_[0], ssize_t(plain_.size()) };
+            return ret;
         }
 
     private:
 
-        DataSet::Version version_;
+        DataSet::Version   version_;
+        mutable gu::Buffer plain_; // decompressed VER2 payload
 
     }; /* class DataSetIn */
 
@@ -18,7 +18,10 @@
 #include <GCache.hpp>
 #include <cerrno>
 
+/* DummyGcs may be selected instead for builds without networking */
+#ifndef GCS_IMPL
 #define GCS_IMPL Gcs
+#endif
 
 namespace galera
 {
@@ -40,8 +43,11 @@ namespace galera
         virtual ssize_t sendv(const WriteSetVector&, size_t,
                               gcs_act_type_t, bool) = 0;
         virtual ssize_t send (const void*, size_t, gcs_act_type_t, bool) = 0;
+        /* if the 4th argument is true, the vector is a single buffer
+         * allocated in gcache, the last one selects bulk send class,
+         * @see gcs_replv() */
         virtual ssize_t replv(const WriteSetVector&,
-                              gcs_action& act, bool) = 0;
+                              gcs_action& act, bool, bool, bool) = 0;
         virtual ssize_t repl (gcs_action& act, bool) = 0;
         virtual gcs_seqno_t caused() = 0;
         virtual ssize_t schedule() = 0;
@@ -53,6 +59,7 @@ namespace galera
                                                const std::string& sst_donor,
                                                const gu_uuid_t& ist_uuid,
                                                gcs_seqno_t ist_seqno,
+                                               int ist_donors,
                                                gcs_seqno_t* seqno_l) = 0;
         virtual ssize_t desync(gcs_seqno_t* seqno_l) = 0;
         virtual void    join(gcs_seqno_t seqno) = 0;
@@ -131,9 +138,10 @@ namespace galera
         }
 
         ssize_t replv(const WriteSetVector& actv,
-                      struct gcs_action& act, bool scheduled)
+                      struct gcs_action& act, bool scheduled, bool cached,
+                      bool bulk)
         {
-            return gcs_replv(conn_, &actv[0], &act, scheduled);
+            return gcs_replv(conn_, &actv[0], &act, scheduled, cached, bulk);
         }
 
         ssize_t repl(struct gcs_action& act, bool scheduled)
@@ -165,6 +173,7 @@ namespace galera
                                        const std::string& sst_donor,
                                        const gu_uuid_t& ist_uuid,
                                        gcs_seqno_t ist_seqno,
+                                       int ist_donors,
                                        gcs_seqno_t* seqno_l)
         {
             return gcs_request_state_transfer(conn_,
@@ -172,6 +181,7 @@ namespace galera
                                               req, req_len,
                                               sst_donor.c_str(),
                                               &ist_uuid, ist_seqno,
+                                              ist_donors,
                                               seqno_l);
         }
 
@@ -274,11 +284,16 @@ namespace galera
         { return -ENOSYS; }
 
         ssize_t replv(const WriteSetVector& actv,
-                      gcs_action& act, bool scheduled)
+                      gcs_action& act, bool scheduled, bool cached, bool)
         {
             ssize_t ret(set_seqnos(act));
 
-            if (gu_likely(0 != gcache_ && ret > 0))
+            if (cached && ret > 0)
+            {
+                assert (actv[0].size == act.size);
+                act.buf = actv[0].ptr;
+            }
+            else if (gu_likely(0 != gcache_ && ret > 0))
             {
                 assert (ret == act.size);
                 gu::byte_t* ptr(
@@ -341,6 +356,7 @@ namespace galera
                                        const std::string& sst_donor,
                                        const gu_uuid_t& ist_uuid,
                                        gcs_seqno_t ist_seqno,
+                                       int ist_donors,
                                        gcs_seqno_t* seqno_l)
         {
             *seqno_l = GCS_SEQNO_ILL;
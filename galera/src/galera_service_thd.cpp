@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010-2013 Codership Oy <info@codership.com>
+ * Copyright (C) 2010-2017 Codership Oy <info@codership.com>
  *
  * Using broadcasts instead of signals below to wake flush callers due to
  * theoretical possibility of more than 2 threads involved.
@@ -7,13 +7,56 @@
 
 #include "galera_service_thd.hpp"
 
+#include <algorithm> // std::max()
+#include <cerrno>
+
 const uint32_t galera::ServiceThd::A_NONE = 0;
 
 static const uint32_t A_LAST_COMMITTED = 1U <<  0;
 static const uint32_t A_RELEASE_SEQNO  = 1U <<  1;
+static const uint32_t A_PURGE          = 1U <<  2;
 static const uint32_t A_FLUSH          = 1U << 30;
 static const uint32_t A_EXIT           = 1U << 31;
 
+/* Last committed report alone can wait for the report interval to pass,
+ * for other actions the thread must be woken up right away. */
+static inline bool idle(uint32_t const act)
+{
+    return (0 == (act & ~A_LAST_COMMITTED));
+}
+
+void
+galera::ServiceThd::wait_for_work (gu::Lock& lock)
+{
+    for (;;)
+    {
+        if (A_NONE == data_.act_)
+        {
+            lock.wait(cond_);
+            continue;
+        }
+
+        if (A_LAST_COMMITTED == data_.act_)
+        {
+            long long const now(gu_time_monotonic());
+
+            if (now < report_next_)
+            {
+                gu::datetime::Date const until(gu::datetime::Date::calendar()
+                                               + (report_next_ - now));
+                try { lock.wait(cond_, until); }
+                catch (gu::Exception& e)
+                {
+                    if (e.get_errno() != ETIMEDOUT) throw;
+                }
+                continue;
+            }
+        }
+
+        return;
+    }
+}
+
 void*
 galera::ServiceThd::thd_func (void* arg)
 {
@@ -23,15 +66,39 @@ galera::ServiceThd::thd_func (void* arg)
     while (!exit)
     {
         galera::ServiceThd::Data data;
+        galera::ServiceThd::Purge* purge(0);
 
         {
             gu::Lock lock(st->mtx_);
 
-            if (A_NONE == st->data_.act_) lock.wait(st->cond_);
+            st->wait_for_work(lock);
 
             data = st->data_;
             st->data_.act_ = A_NONE; // clear pending actions
 
+            if (data.act_ & A_LAST_COMMITTED)
+            {
+                long long const now(gu_time_monotonic());
+
+                if (now < st->report_next_ &&
+                    !(data.act_ & (A_FLUSH | A_EXIT)))
+                {
+                    // woken up for something else, report can still wait
+                    data.act_ &= ~A_LAST_COMMITTED;
+                    st->data_.act_ = A_LAST_COMMITTED;
+                }
+                else
+                {
+                    st->report_next_ = now + st->report_interval_;
+                }
+            }
+
+            if (data.act_ & A_PURGE)
+            {
+                purge = st->purge_;
+                st->purging_ = (purge != 0);
+            }
+
             if (data.act_ & A_FLUSH)
             {
                 if (A_FLUSH == data.act_)
@@ -81,6 +148,33 @@ galera::ServiceThd::thd_func (void* arg)
                              << data.release_seqno_ << ": " << e.what();
                 }
             }
+
+            if (purge)
+            {
+                bool more(false);
+
+                try
+                {
+                    more = purge->purge_pass(data.purge_seqno_);
+                }
+                catch (std::exception& e)
+                {
+                    log_warn << "Exception purging up to "
+                             << data.purge_seqno_ << ": " << e.what();
+                }
+
+                gu::Lock lock(st->mtx_);
+
+                st->purging_ = false;
+
+                // reschedule next pass unless reset in between
+                if (more && st->data_.purge_seqno_ >= data.purge_seqno_)
+                {
+                    st->data_.act_ |= A_PURGE;
+                }
+
+                st->flush_.broadcast(); // wake up set_purge() waiters
+            }
         }
     }
 
@@ -94,7 +188,11 @@ galera::ServiceThd::ServiceThd (GcsI& gcs, gcache::GCache& gcache) :
     mtx_    (),
     cond_   (),
     flush_  (),
-    data_   ()
+    data_   (),
+    purge_  (0),
+    purging_(false),
+    report_interval_(0),
+    report_next_    (0)
 {
     gu_thread_create (&thd_, NULL, thd_func, this);
 }
@@ -118,7 +216,7 @@ galera::ServiceThd::flush()
 
     if (!(data_.act_ & A_EXIT))
     {
-        if (data_.act_ == A_NONE) cond_.signal();
+        if (idle(data_.act_)) cond_.signal();
         data_.act_ |= A_FLUSH;
         do { lock.wait(flush_); } while (data_.act_ & A_FLUSH);
     }
@@ -130,6 +228,7 @@ galera::ServiceThd::reset()
     gu::Lock lock(mtx_);
     data_.act_ = A_NONE;
     data_.last_committed_ = 0;
+    data_.purge_seqno_ = 0;
 }
 
 void
@@ -147,6 +246,17 @@ galera::ServiceThd::report_last_committed(gcs_seqno_t seqno)
     }
 }
 
+void
+galera::ServiceThd::set_report_interval(const gu::datetime::Period& interval)
+{
+    gu::Lock lock(mtx_);
+
+    report_interval_ = std::max(interval.get_nsecs(), 0LL);
+    report_next_     = 0;
+
+    if (A_LAST_COMMITTED == data_.act_) cond_.signal(); // may be due now
+}
+
 void
 galera::ServiceThd::release_seqno(gcs_seqno_t seqno)
 {
@@ -156,8 +266,48 @@ galera::ServiceThd::release_seqno(gcs_seqno_t seqno)
     {
         data_.release_seqno_ = seqno;
 
-        if (data_.act_ == A_NONE) cond_.signal();
+        if (idle(data_.act_)) cond_.signal();
 
         data_.act_ |= A_RELEASE_SEQNO;
     }
 }
+
+void
+galera::ServiceThd::schedule_purge(gcs_seqno_t seqno)
+{
+    gu::Lock lock(mtx_);
+
+    if (data_.purge_seqno_ < seqno)
+    {
+        data_.purge_seqno_ = seqno;
+
+        if (idle(data_.act_)) cond_.signal();
+
+        data_.act_ |= A_PURGE;
+    }
+}
+
+void
+galera::ServiceThd::schedule_purge_pass()
+{
+    gu::Lock lock(mtx_);
+
+    if (purge_ && !(data_.act_ & A_PURGE))
+    {
+        if (idle(data_.act_)) cond_.signal();
+
+        data_.act_ |= A_PURGE;
+    }
+}
+
+void
+galera::ServiceThd::set_purge(Purge* const purge)
+{
+    gu::Lock lock(mtx_);
+
+    while (purging_) lock.wait(flush_);
+
+    purge_ = purge;
+
+    if (0 == purge_) data_.act_ &= ~A_PURGE;
+}
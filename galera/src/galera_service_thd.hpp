@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010-2013 Codership Oy <info@codership.com>
+ * Copyright (C) 2010-2017 Codership Oy <info@codership.com>
  */
 
 #ifndef GALERA_SERVICE_THD_HPP
@@ -9,6 +9,7 @@
 #include <GCache.hpp>
 
 #include <gu_lock.hpp> // gu::Mutex and gu::Cond
+#include <gu_datetime.hpp>
 
 namespace galera
 {
@@ -16,6 +17,17 @@ namespace galera
     {
     public:
 
+        /*! Interface for a purge task done incrementally in the background */
+        class Purge
+        {
+        public:
+            virtual ~Purge() {}
+
+            /*! performs a bounded purge pass up to and including seqno
+             *  @return true if there is more to purge */
+            virtual bool purge_pass (gcs_seqno_t seqno) = 0;
+        };
+
         ServiceThd (GcsI& gcs, gcache::GCache& gcache);
 
         ~ServiceThd ();
@@ -35,9 +47,25 @@ namespace galera
         /*! schedule seqno to be reported as last committed */
         void report_last_committed (gcs_seqno_t seqno);
 
+        /*! minimum interval between last committed reports: reports coming
+         *  more often are coalesced into one. 0 sends every report as soon
+         *  as possible. */
+        void set_report_interval (const gu::datetime::Period& interval);
+
         /*! release write sets up to and including seqno */
         void release_seqno (gcs_seqno_t seqno);
 
+        /*! schedule background purge up to and including seqno */
+        void schedule_purge (gcs_seqno_t seqno);
+
+        /*! schedule purge pass even if purge seqno has not advanced,
+         *  lets the purge task do its other work */
+        void schedule_purge_pass ();
+
+        /*! set background purge task, 0 to unset. Waits for the ongoing
+         *  purge pass to finish. */
+        void set_purge (Purge* purge);
+
     private:
 
         static const uint32_t A_NONE;
@@ -46,11 +74,13 @@ namespace galera
         {
             gcs_seqno_t last_committed_;
             gcs_seqno_t release_seqno_;
+            gcs_seqno_t purge_seqno_;
             uint32_t    act_;
 
             Data() :
                 last_committed_(0),
                 release_seqno_ (0),
+                purge_seqno_   (0),
                 act_           (A_NONE)
             {}
         };
@@ -62,6 +92,13 @@ namespace galera
         gu::Cond        cond_;  // service request condition
         gu::Cond        flush_; // flush condition
         Data            data_;
+        Purge*          purge_;
+        bool            purging_; // purge pass in progress
+        long long       report_interval_; // nanoseconds
+        long long       report_next_;     // earliest time for next report
+
+        /* waits until there is something to do, must be called under mtx_ */
+        void wait_for_work (gu::Lock& lock);
 
         static void* thd_func (void*);
 
@@ -7,6 +7,7 @@
 #include "trx_handle.hpp"
 
 #include "gu_serialize.hpp"
+#include "gu_probe.h"
 
 #include "galera_info.hpp"
 
@@ -111,6 +112,7 @@ void galera::GcsActionSource::dispatch(void* const              recv_ctx,
     case GCS_ACT_TORDERED:
     {
         assert(act.seqno_g > 0);
+        GU_PROBE3(ws_recv, act.seqno_g, act.seqno_l, act.size);
         GcsActionTrx trx(trx_pool_, act);
         trx.trx()->set_state(TrxHandle::S_REPLICATING);
         gu_trace(replicator_.process_trx(recv_ctx, trx.trx()));
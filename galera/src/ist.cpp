@@ -9,17 +9,86 @@
 #include "gu_uri.hpp"
 #include "gu_debug_sync.hpp"
 #include "gu_progress.hpp"
+#include "gu_datetime.hpp"
+#include "gu_time.h"
 
 #include "GCache.hpp"
 #include "galera_common.hpp"
 #include <boost/bind.hpp>
 #include <fstream>
 #include <algorithm>
+#include <poll.h>
+#include <unistd.h> // usleep()
 
 namespace
 {
+    /* Keys of IST write sets are never certified on joiner: certification
+     * index is reset to the group seqno on every primary configuration,
+     * IST ends before it, so joiner starts certifying with the same empty
+     * window as the rest of the group. Keys are kept only for joiner's
+     * gcache to hold complete write sets it could donate itself later. */
     static std::string const CONF_KEEP_KEYS     ("ist.keep_keys");
     static bool        const CONF_KEEP_KEYS_DEFAULT (true);
+    static std::string const CONF_STREAMS       ("ist.streams");
+    static int         const CONF_STREAMS_DEFAULT   (1);
+    static std::string const CONF_DONORS        ("ist.donors");
+    static int         const CONF_DONORS_DEFAULT    (1);
+    static int         const MAX_STREAMS            (16);
+    static long long   const CONF_SEND_RATE_DEFAULT (0);
+    static std::string const CONF_FC_LIMIT      ("gcs.fc_limit");
+
+    static std::string const CONF_RESUME_TIMEOUT("ist.resume_timeout");
+    static std::string const CONF_RESUME_TIMEOUT_DEFAULT("PT30S");
+
+    static std::string const CONF_COMPRESSION   ("ist.compression");
+    static std::string const CONF_COMPRESSION_DEFAULT("off");
+
+    /* write sets read from gcache at a time, also the read ahead unit */
+    static std::string const CONF_BATCH_SIZE    ("ist.batch_size");
+    static long        const CONF_BATCH_SIZE_DEFAULT(1024);
+    static long        const MAX_BATCH_SIZE         (1 << 16);
+
+    static int streams_from_config(const gu::Config& conf)
+    {
+        int const streams(conf.get(CONF_STREAMS, CONF_STREAMS_DEFAULT));
+        return std::max(1, std::min(streams, MAX_STREAMS));
+    }
+
+    /* every donor of a split IST takes one stream */
+    static int donors_from_config(const gu::Config& conf)
+    {
+        int const donors(conf.get(CONF_DONORS, CONF_DONORS_DEFAULT));
+        return std::max(1, std::min(donors, MAX_STREAMS));
+    }
+
+    static size_t batch_size_from_config(const gu::Config& conf)
+    {
+        long const size(conf.get(CONF_BATCH_SIZE, CONF_BATCH_SIZE_DEFAULT));
+        return std::max(1L, std::min(size, MAX_BATCH_SIZE));
+    }
+
+    /* how long to wait for the other side to reconnect after interruption,
+     * nanoseconds, 0 to fail right away */
+    static long long resume_timeout_from_config(const gu::Config& conf)
+    {
+        return gu::datetime::Period(conf.get(CONF_RESUME_TIMEOUT,
+                                             CONF_RESUME_TIMEOUT_DEFAULT))
+            .get_nsecs();
+    }
+
+    /* whether sender should compress the stream if receiver supports it */
+    static bool compression_from_config(const gu::Config& conf)
+    {
+        std::string const c(conf.get(CONF_COMPRESSION,
+                                     CONF_COMPRESSION_DEFAULT));
+
+        if (c == "zlib") return true;
+        if (c == "off")  return false;
+
+        gu_throw_error(EINVAL) << "Invalid value for " << CONF_COMPRESSION
+                               << ": '" << c << "', expected 'off' or 'zlib'";
+        GU_DEBUG_NORETURN;
+    }
 }
 
 
@@ -35,16 +104,20 @@ namespace galera
                         wsrep_seqno_t first,
                         wsrep_seqno_t last,
                         AsyncSenderMap& asmap,
-                        int version)
+                        int version,
+                        int share,
+                        int donors)
                 :
-                Sender (conf, asmap.gcache(), peer, version),
+                Sender (conf, asmap.gcache(), peer, version, &asmap.gcs()),
                 conf_  (conf),
                 peer_  (peer),
                 first_ (first),
                 last_  (last),
                 asmap_ (asmap),
                 thread_()
-            { }
+            {
+                set_share(share, donors);
+            }
 
             const gu::Config&  conf()   { return conf_;   }
             const std::string& peer()   { return peer_;   }
@@ -75,6 +148,8 @@ std::string const
 galera::ist::Receiver::RECV_ADDR("ist.recv_addr");
 std::string const
 galera::ist::Receiver::RECV_BIND("ist.recv_bind");
+std::string const
+galera::ist::Sender::SEND_RATE("ist.send_rate");
 
 void
 galera::ist::register_params(gu::Config& conf)
@@ -82,6 +157,12 @@ galera::ist::register_params(gu::Config& conf)
     conf.add(Receiver::RECV_ADDR);
     conf.add(Receiver::RECV_BIND);
     conf.add(CONF_KEEP_KEYS);
+    conf.add(CONF_STREAMS);
+    conf.add(CONF_DONORS, gu::to_string(CONF_DONORS_DEFAULT));
+    conf.add(Sender::SEND_RATE, gu::to_string(CONF_SEND_RATE_DEFAULT));
+    conf.add(CONF_RESUME_TIMEOUT, CONF_RESUME_TIMEOUT_DEFAULT);
+    conf.add(CONF_COMPRESSION, CONF_COMPRESSION_DEFAULT);
+    conf.add(CONF_BATCH_SIZE, gu::to_string(CONF_BATCH_SIZE_DEFAULT));
 }
 
 galera::ist::Receiver::Receiver(gu::Config&           conf,
@@ -92,17 +173,30 @@ galera::ist::Receiver::Receiver(gu::Config&           conf,
     recv_bind_    (),
     io_service_   (),
     acceptor_     (io_service_),
+    endpoint_     (),
     ssl_ctx_      (io_service_, asio::ssl::context::sslv23),
     mutex_        (),
     cond_         (),
-    consumers_    (),
+    apply_cond_   (),
+    streams_      (),
+    parked_       (),
+    pending_      (),
+    progress_     (0),
     current_seqno_(-1),
     last_seqno_   (-1),
+    first_seqno_  (-1),
+    recv_bytes_   (0),
+    start_        (0),
+    end_          (0),
     conf_         (conf),
+    resume_timeout_(resume_timeout_from_config(conf)),
     trx_pool_     (sp),
     thread_       (),
     error_code_   (0),
     version_      (-1),
+    streams_left_ (0),
+    active_streams_(0),
+    stopping_     (false),
     use_ssl_      (false),
     running_      (false),
     ready_        (false)
@@ -148,6 +242,97 @@ extern "C" void* run_receiver_thread(void* arg)
     return 0;
 }
 
+
+class galera::ist::Receiver::Stream
+{
+public:
+
+    /* receiving state: which part of a trx message is being read */
+    enum State { S_HEADER, S_META, S_BODY };
+
+    Stream(Receiver&             receiver,
+           asio::io_service&     io_service,
+           asio::ssl::context&   ssl_ctx,
+           TrxHandle::SlavePool& sp,
+           int                   version,
+           bool                  keep_keys)
+        :
+        receiver_  (receiver),
+        socket_    (io_service),
+        ssl_stream_(io_service, ssl_ctx),
+        strand_    (io_service),
+        proto_     (sp, version, keep_keys),
+        buf_       (),
+        ptr_       (0),
+        left_      (0),
+        want_      (0),
+        state_     (S_HEADER),
+        trx_       (0),
+        len_       (0),
+        seqno_g_   (WSREP_SEQNO_UNDEFINED),
+        seqno_d_   (WSREP_SEQNO_UNDEFINED),
+        recv_bytes_(0),
+        bytes_     (0),
+        next_      (WSREP_SEQNO_UNDEFINED),
+        broken_    (false),
+        compress_  (false)
+    { }
+
+    ~Stream() { if (trx_) trx_->unref(); }
+
+    void close(bool const ssl)
+    {
+        if (ssl)
+        {
+            ssl_stream_.lowest_layer().close();
+        }
+        else
+        {
+            socket_.close();
+        }
+    }
+
+    /* the next size bytes of the stream go to ptr */
+    void expect(void* const ptr, size_t const size)
+    {
+        ptr_  = static_cast<gu::byte_t*>(ptr);
+        left_ = want_ = size;
+    }
+
+    Receiver&                                receiver_;
+    asio::ip::tcp::socket                    socket_;
+    asio::ssl::stream<asio::ip::tcp::socket> ssl_stream_;
+    asio::io_service::strand                 strand_; // handlers of stream
+    Proto                                    proto_;
+    gu::Buffer                               buf_;   // header, meta data
+    gu::byte_t*                              ptr_;   // read destination
+    size_t                                   left_;  // bytes to read there
+    size_t                                   want_;  // read size
+    State                                    state_;
+    TrxHandle*                               trx_;   // received, not queued
+    size_t                                   len_;   // trx message length
+    wsrep_seqno_t                            seqno_g_;
+    wsrep_seqno_t                            seqno_d_;
+    uint64_t                                 recv_bytes_;
+    size_t                                   bytes_; // trx_ bytes
+    wsrep_seqno_t                            next_; // next expected seqno
+    bool                                     broken_; // to be resumed
+    bool                                     compress_; // sender deflates
+
+private:
+
+    Stream(const Stream&);
+    Stream& operator=(const Stream&);
+};
+
+
+extern "C" void* run_receiver_io_thread(void* arg)
+{
+    galera::ist::Receiver* receiver(static_cast<galera::ist::Receiver*>(arg));
+    receiver->run_io();
+    return 0;
+}
+
 static std::string
 IST_determine_recv_addr (gu::Config& conf)
 {
@@ -317,6 +502,8 @@ galera::ist::Receiver::prepare(wsrep_seqno_t first_seqno,
         gu::set_fd_options(acceptor_);
         acceptor_.bind(*i);
         acceptor_.listen();
+        // rebind to the same port if IST has to be resumed
+        endpoint_ = acceptor_.local_endpoint();
         // read recv_addr_ from acceptor_ in case zero port was specified
         recv_addr_ = uri_addr.get_scheme()
             + "://"
@@ -333,8 +520,17 @@ galera::ist::Receiver::prepare(wsrep_seqno_t first_seqno,
             << "', asio error '" << e.what() << "'";
     }
 
-    current_seqno_ = first_seqno;
-    last_seqno_    = last_seqno;
+    {
+        gu::Lock lock(mutex_);
+        current_seqno_ = first_seqno;
+        last_seqno_    = last_seqno;
+        first_seqno_   = first_seqno;
+        recv_bytes_    = 0;
+        start_         = 0;
+        end_           = 0;
+    }
+    streams_left_  = 1; // at least one stream is expected
+    error_code_    = 0;
     int err;
     if ((err = gu_thread_create(&thread_, 0, &run_receiver_thread, this)) != 0)
     {
@@ -354,22 +550,62 @@ galera::ist::Receiver::prepare(wsrep_seqno_t first_seqno,
 }
 
 
-void galera::ist::Receiver::run()
+void galera::ist::Receiver::open_acceptor()
+{
+    acceptor_.open(endpoint_.protocol());
+    acceptor_.set_option(asio::ip::tcp::socket::reuse_address(true));
+    gu::set_fd_options(acceptor_);
+    acceptor_.bind(endpoint_);
+    acceptor_.listen();
+}
+
+
+/* if deadline is given, waits for connection until then, watching for
+ * finished() to be called */
+void galera::ist::Receiver::accept(Stream& stream, long long const deadline)
 {
-    asio::ip::tcp::socket socket(io_service_);
-    asio::ssl::stream<asio::ip::tcp::socket> ssl_stream(io_service_, ssl_ctx_);
+    static long long const POLL_STEP_MS(100);
+
+    while (deadline > 0)
+    {
+        {
+            gu::Lock lock(mutex_);
+            if (running_ == false) gu_throw_error(EINTR);
+        }
+
+        long long const left(deadline - gu_time_monotonic());
+        if (left <= 0)
+        {
+            gu_throw_error(ETIMEDOUT) << "IST donor did not connect in time";
+        }
+
+        struct pollfd pfd;
+        pfd.fd      = acceptor_.native();
+        pfd.events  = POLLIN;
+        pfd.revents = 0;
+
+        int const ret(poll(&pfd, 1, static_cast<int>(
+                               std::min(left / 1000000 + 1, POLL_STEP_MS))));
+        if (ret > 0) break;
+        if (ret < 0 && errno != EINTR)
+        {
+            gu_throw_error(errno) << "poll() on IST listener failed";
+        }
+    }
+
     try
     {
         if (use_ssl_ == true)
         {
-            acceptor_.accept(ssl_stream.lowest_layer());
-            gu::set_fd_options(ssl_stream.lowest_layer());
-            ssl_stream.handshake(asio::ssl::stream<asio::ip::tcp::socket>::server);
+            acceptor_.accept(stream.ssl_stream_.lowest_layer());
+            gu::set_fd_options(stream.ssl_stream_.lowest_layer());
+            stream.ssl_stream_.handshake(
+                asio::ssl::stream<asio::ip::tcp::socket>::server);
         }
         else
         {
-            acceptor_.accept(socket);
-            gu::set_fd_options(socket);
+            acceptor_.accept(stream.socket_);
+            gu::set_fd_options(stream.socket_);
         }
     }
     catch (asio::system_error& e)
@@ -379,84 +615,222 @@ void galera::ist::Receiver::run()
                                          << e.what() << "': "
                                          << gu::extra_error_info(e.code());
     }
-    acceptor_.close();
-    int ec(0);
-    try
+}
+
+
+int galera::ist::Receiver::donors() const
+{
+    return donors_from_config(conf_);
+}
+
+
+/* resume: seqno to ask the reconnected sender to continue from,
+ *         WSREP_SEQNO_UNDEFINED at the start of IST */
+int galera::ist::Receiver::handshake(Stream& stream, int streams, int& index,
+                                     wsrep_seqno_t const resume)
+{
+    Proto p(trx_pool_, version_,
+            conf_.get(CONF_KEEP_KEYS, CONF_KEEP_KEYS_DEFAULT));
+
+    int ret;
+    int8_t   const ctrl(resume < 0 ? Ctrl::C_OK : Ctrl::C_RESUME);
+    uint64_t const from(resume < 0 ? 0 : resume);
+    uint8_t  flags(0);
+
+    // inflating is always supported, it is up to sender to choose
+    if (use_ssl_ == true)
     {
-        Proto p(trx_pool_, version_,
-                conf_.get(CONF_KEEP_KEYS, CONF_KEEP_KEYS_DEFAULT));
+        p.send_handshake(stream.ssl_stream_, streams, Handshake::F_ZLIB);
+        ret = p.recv_handshake_response(stream.ssl_stream_, index, &flags);
+        p.send_ctrl(stream.ssl_stream_, ctrl, from);
+    }
+    else
+    {
+        p.send_handshake(stream.socket_, streams, Handshake::F_ZLIB);
+        ret = p.recv_handshake_response(stream.socket_, index, &flags);
+        p.send_ctrl(stream.socket_, ctrl, from);
+    }
 
-        if (use_ssl_ == true)
+    stream.compress_ = (flags & Handshake::F_ZLIB);
+
+    if (ret > streams || index >= ret)
+    {
+        gu_throw_error(EPROTO) << "invalid IST stream " << index << '/'
+                               << ret << ", offered " << streams;
+    }
+
+    return ret;
+}
+
+
+void galera::ist::Receiver::run()
+{
+    gu::Progress<wsrep_seqno_t> progress(
+        "Receiving IST",
+        " events",
+        last_seqno_ - current_seqno_ + 1,
+        /* The following means reporting progress NO MORE frequently than
+         * once per BOTH 10 seconds (default) and 16 events */
+        16);
+
+    static useconds_t const RETRY_INTERVAL_US(100000); // 0.1s
+
+    wsrep_seqno_t first(current_seqno_); // next seqno to receive
+    long long     deadline(0);           // no reconnect is expected at first
+    int           ec;
+
+    while (true)
+    {
+        wsrep_seqno_t const start(first);
+        bool                broken(false);
+
+        ec = run_session(first, progress, deadline, broken);
+
+        if (!broken) break;
+
+        /* the donor has at most resume_timeout_ to reconnect after the last
+         * interruption that was preceded by some progress */
+        if (0 == deadline || first != start)
         {
-            p.send_handshake(ssl_stream);
-            p.recv_handshake_response(ssl_stream);
-            p.send_ctrl(ssl_stream, Ctrl::C_OK);
+            log_warn << "IST interrupted at " << first
+                     << ", waiting for donor to resume";
+            deadline = gu_time_monotonic() + resume_timeout_;
         }
-        else
+        else if (gu_time_monotonic() < deadline)
         {
-            p.send_handshake(socket);
-            p.recv_handshake_response(socket);
-            p.send_ctrl(socket, Ctrl::C_OK);
+            usleep(RETRY_INTERVAL_US); // failed to reconnect
         }
-
-        /* wait for ready signal from the STR thread */
+        else
         {
-            gu::Lock lock(mutex_);
-            while (ready_ == false) lock.wait(cond_);
+            log_error << "IST donor did not resume in time";
+            ec = ETIMEDOUT;
+            break;
         }
+    }
+
+    gu::Lock lock(mutex_);
+
+    wsrep_seqno_t const received(first - 1);
+
+    running_      = false;
+    streams_left_ = 0;
+    end_          = gu_time_monotonic();
+
+    if (ec != EINTR && error_code_ == 0 && received < last_seqno_)
+    {
+        log_error << "IST didn't contain all write sets, expected last: "
+                  << last_seqno_ << " last received: " << received;
+        ec = EPROTO;
+    }
+    if (ec != EINTR && error_code_ == 0)
+    {
+        error_code_ = ec;
+    }
+    if (0 == ec) progress.finish();
+
+    cond_.broadcast();
+    apply_cond_.broadcast();
+}
+
+
+/* Receives write sets from first over a single connection session, updates
+ * first to the next seqno to receive. Sets broken if the session was
+ * interrupted by a network error and the sender is expected to reconnect
+ * before deadline, 0 deadline means no sender has connected yet. */
+int galera::ist::Receiver::run_session(wsrep_seqno_t&               first,
+                                       gu::Progress<wsrep_seqno_t>& progress,
+                                       long long const              deadline,
+                                       bool&                        broken)
+{
+    bool const resume(deadline > 0);
+    int        ec(0);
+
+    try
+    {
+        /* split IST donors take a stream each */
+        int const offered(std::max(streams_from_config(conf_),
+                                   donors_from_config(conf_)));
+
+        bool const keep_keys(conf_.get(CONF_KEEP_KEYS,
+                                       CONF_KEEP_KEYS_DEFAULT));
+
+        streams_.push_back(new Stream(*this, io_service_, ssl_ctx_,
+                                      trx_pool_, version_, keep_keys));
+        streams_[0]->next_ = first;
+
+        if (!acceptor_.is_open()) open_acceptor();
+
+        accept(*streams_[0], deadline);
+
+        /* when IST is split, the first stream to connect may come from any
+         * of the donors */
+        int index;
+        int const n_streams(handshake(*streams_[0], offered, index,
+                                      resume ? first : WSREP_SEQNO_UNDEFINED));
 
-        gu::Progress<wsrep_seqno_t> progress(
-            "Receiving IST",
-            " events",
-            last_seqno_ - current_seqno_ + 1,
-            /* The following means reporting progress NO MORE frequently than
-             * once per BOTH 10 seconds (default) and 16 events */
-            16);
+        streams_.resize(n_streams, 0);
+        std::swap(streams_[0], streams_[index]);
+        streams_[index]->next_ = first + index;
 
-        while (true)
+        /* the rest of the streams, possibly from other donors, should not
+         * take longer to connect than a dropped stream to reconnect */
+        long long const rest_deadline(resume_timeout_ > 0 ?
+                                      gu_time_monotonic() + resume_timeout_ :
+                                      0);
+
+        for (int i(1); i < n_streams; ++i)
         {
-            TrxHandle* trx;
-            if (use_ssl_ == true)
+            Stream* const stream(new Stream(*this, io_service_, ssl_ctx_,
+                                            trx_pool_, version_, keep_keys));
+
+            try
             {
-                trx = p.recv_trx(ssl_stream);
+                accept(*stream, rest_deadline);
+                (void)handshake(*stream, n_streams, index,
+                                resume ? first : WSREP_SEQNO_UNDEFINED);
             }
-            else
+            catch (...)
             {
-                trx = p.recv_trx(socket);
+                delete stream;
+                throw;
             }
-            if (trx != 0)
-            {
-                if (trx->global_seqno() != current_seqno_)
-                {
-                    log_error << "unexpected trx seqno: " << trx->global_seqno()
-                              << " expected: " << current_seqno_;
-                    ec = EINVAL;
-                    goto err;
-                }
-                ++current_seqno_;
 
-                progress.update(1);
-            }
-            gu::Lock lock(mutex_);
-            assert(ready_);
-            while (consumers_.empty()) lock.wait(cond_);
-            Consumer* cons(consumers_.top());
-            consumers_.pop();
-            cons->trx(trx);
-            cons->cond().signal();
-            if (trx == 0)
+            if (streams_[index] != 0)
             {
-                log_debug << "eof received, closing socket";
-                break;
+                delete stream;
+                gu_throw_error(EPROTO) << "duplicate IST stream " << index;
             }
+
+            stream->next_ = first + index;
+            streams_[index] = stream;
+        }
+
+        acceptor_.close();
+
+        log_info << "IST receiving over " << n_streams << " stream(s)"
+                 << (resume ? ", resumed" : "");
+
+        /* wait for ready signal from the STR thread */
+        {
+            gu::Lock lock(mutex_);
+            while (ready_ == false) lock.wait(cond_);
+            streams_left_   = n_streams;
+            active_streams_ = n_streams;
+            stopping_       = false;
+            progress_       = &progress;
+            if (0 == start_) start_ = gu_time_monotonic();
         }
 
-        progress.finish();
+        run_streams();
+
+        gu::Lock lock(mutex_);
+        progress_ = 0;
     }
     catch (asio::system_error& e)
     {
         log_error << "got error while reading ist stream: " << e.code();
         ec = e.code().value();
+        broken = true;
     }
     catch (gu::Exception& e)
     {
@@ -465,136 +839,587 @@ void galera::ist::Receiver::run()
         {
             log_error << "got exception while reading ist stream: " << e.what();
         }
+        /* a sender that was connecting when the link went down */
+        broken = (resume && ETIMEDOUT != ec && EINTR != ec && EPROTO != ec);
     }
 
-err:
     gu::Lock lock(mutex_);
-    if (use_ssl_ == true)
-    {
-        ssl_stream.lowest_layer().close();
-        // ssl_stream.shutdown();
-    }
-    else
+
+    if (ec != 0)
     {
-        socket.close();
+        progress_ = 0;
+        if (!broken || resume_timeout_ <= 0) running_ = false;
+        cond_.broadcast();
+        apply_cond_.broadcast();
     }
 
-    running_ = false;
-    if (ec != EINTR && current_seqno_ - 1 < last_seqno_)
+    /* last seqno of the gapless sequence received by all streams */
+    wsrep_seqno_t received(last_seqno_ + 1);
+
+    for (size_t i(0); i < streams_.size(); ++i)
     {
-        log_error << "IST didn't contain all write sets, expected last: "
-                  << last_seqno_ << " last received: " << current_seqno_ - 1;
-        ec = EPROTO;
+        if (streams_[i])
+        {
+            received = std::min(received, streams_[i]->next_);
+            if (streams_[i]->broken_) broken = true;
+            streams_[i]->close(use_ssl_);
+            delete streams_[i];
+        }
+        else
+        {
+            received = std::min(received, first);
+        }
     }
-    if (ec != EINTR)
+    streams_.clear();
+    --received;
+
+    first = received + 1;
+
+    if (broken && running_ && resume_timeout_ > 0 && received < last_seqno_)
     {
-        error_code_ = ec;
+        /* write sets past the gap will be sent again */
+        TrxMap::iterator const from(pending_.lower_bound(first));
+        for (TrxMap::iterator i(from); i != pending_.end(); ++i)
+        {
+            i->second->unref();
+        }
+        pending_.erase(from, pending_.end());
+
+        streams_left_ = 1; // keep appliers waiting
+        ec            = 0;
     }
-    while (consumers_.empty() == false)
+    else
     {
-        consumers_.top()->cond().signal();
-        consumers_.pop();
+        broken = false;
     }
+
+    return ec;
 }
 
 
-void galera::ist::Receiver::ready()
+/* Receives all session streams in io_service_. Handlers run in this thread
+ * and, when there are several streams, in helper threads up to the number
+ * of CPUs, so the number of threads does not grow with streams. Handlers of
+ * one stream are serialized by its strand. */
+void galera::ist::Receiver::run_streams()
 {
-    gu::Lock lock(mutex_);
-    ready_ = true;
-    cond_.signal();
-}
+    io_service_.reset();
 
-int galera::ist::Receiver::recv(TrxHandle** trx)
-{
-    Consumer cons;
-    gu::Lock lock(mutex_);
-    if (running_ == false)
+    for (size_t i(0); i < streams_.size(); ++i)
     {
-        if (error_code_ != 0)
+        streams_[i]->strand_.post(boost::bind(&Receiver::stream_event, this,
+                                              streams_[i], E_START,
+                                              asio::error_code(), 0));
+    }
+
+    long const cpus(sysconf(_SC_NPROCESSORS_ONLN));
+    long const helpers(std::min<long>(streams_.size(), std::max(cpus, 1L))-1);
+    std::vector<gu_thread_t> threads;
+
+    for (long i(0); i < helpers; ++i)
+    {
+        gu_thread_t t;
+        int const err(gu_thread_create(&t, 0, &run_receiver_io_thread, this));
+        if (err != 0)
         {
-            gu_throw_error(error_code_) << "IST receiver reported error";
+            log_warn << "Unable to create IST receiver thread: " << err;
+            break;
         }
-        return EINTR;
+        threads.push_back(t);
     }
-    consumers_.push(&cons);
-    cond_.signal();
-    lock.wait(cons.cond());
-    if (cons.trx() == 0)
+
+    run_io();
+
+    for (size_t i(0); i < threads.size(); ++i)
     {
-        if (error_code_ != 0)
+        int const err(gu_thread_join(threads[i], 0));
+        if (err != 0)
         {
-            gu_throw_error(error_code_) << "IST receiver reported error";
+            log_warn << "Failed to join IST receiver thread: " << err;
         }
-        return EINTR;
     }
-    *trx = cons.trx();
-    return 0;
+
+    /* handlers posted to streams that have finished meanwhile, streams are
+     * deleted after that */
+    io_service_.reset();
+    io_service_.poll();
 }
 
 
-wsrep_seqno_t galera::ist::Receiver::finished()
+void galera::ist::Receiver::run_io()
 {
-    if (recv_addr_ == "")
+    /* handlers don't throw, stream_event() catches everything */
+    io_service_.run();
+}
+
+
+void galera::ist::Receiver::stream_event(Stream* const           stream,
+                                         StreamEvent const       event,
+                                         const asio::error_code& ec,
+                                         size_t const            bytes)
+{
+    Stream& s(*stream);
+
+    try
     {
-        log_debug << "IST was not prepared before calling finished()";
+        if (ec) throw asio::system_error(ec);
+
+        switch (event)
+        {
+        case E_START:
+            s.proto_.set_compression(s.compress_);
+            s.buf_.resize(s.proto_.trx_header_size());
+            s.state_ = Stream::S_HEADER;
+            s.expect(&s.buf_[0], s.buf_.size());
+            read_next(s);
+            break;
+        case E_READ:
+            if (s.compress_)
+            {
+                s.proto_.in_filled(bytes);
+            }
+            else
+            {
+                s.ptr_  += bytes;
+                s.left_ -= bytes;
+            }
+            read_next(s);
+            break;
+        case E_RESUME:
+            deliver(s);
+            break;
+        }
     }
-    else
+    catch (asio::system_error& e)
     {
-        interrupt();
-
-        int err;
-        if ((err = gu_thread_join(thread_, 0)) != 0)
+        log_error << "got error while reading ist stream: " << e.code();
+        stream_done(s, e.code().value(), true);
+    }
+    catch (gu::Exception& e)
+    {
+        int const err(e.get_errno());
+        if (err != EINTR)
         {
-            log_warn << "Failed to join IST receiver thread: " << err;
+            log_error << "got exception while reading ist stream: " << e.what();
         }
+        stream_done(s, err, false);
+    }
+    catch (std::exception& e)
+    {
+        log_error << "got exception while reading ist stream: " << e.what();
+        stream_done(s, EPROTO, false);
+    }
+}
 
-        acceptor_.close();
-
-        gu::Lock lock(mutex_);
-
-        running_ = false;
 
-        while (consumers_.empty() == false)
+/* continues reading the expected part, steps to the next part when done */
+void galera::ist::Receiver::read_next(Stream& s)
+{
+    if (s.compress_)
+    {
+        while (s.left_ > 0 && s.proto_.in_pending())
         {
-            consumers_.top()->cond().signal();
-            consumers_.pop();
+            size_t const n(s.proto_.inflate_some(s.ptr_, s.left_));
+            s.ptr_  += n;
+            s.left_ -= n;
         }
+    }
 
-        recv_addr_ = "";
+    if (s.left_ > 0)
+    {
+        async_read(s);
+        return;
     }
 
-    return (current_seqno_ - 1);
+    s.proto_.count_recv(s.want_);
+    step(s);
 }
 
 
-void galera::ist::Receiver::interrupt()
+void galera::ist::Receiver::async_read(Stream& s)
 {
-    gu::URI uri(recv_addr_);
-    try
+    /* compressed input is read as it comes, plain data right into place */
+    if (s.compress_)
     {
-        asio::ip::tcp::resolver::iterator i;
-        try
+        asio::mutable_buffers_1 const buf(s.proto_.in_buffer());
+
+        if (use_ssl_ == true)
         {
-            asio::ip::tcp::resolver resolver(io_service_);
-            asio::ip::tcp::resolver::query
-                query(gu::unescape_addr(uri.get_host()),
-                      uri.get_port(),
-                      asio::ip::tcp::resolver::query::flags(0));
-            i = resolver.resolve(query);
+            s.ssl_stream_.async_read_some(buf, s.strand_.wrap(
+                boost::bind(&Receiver::stream_event, this, &s, E_READ,
+                            asio::placeholders::error,
+                            asio::placeholders::bytes_transferred)));
         }
-        catch (asio::system_error& e)
+        else
         {
-            gu_throw_error(e.code().value())
-                << "failed to resolve host '"
-                << uri.to_string()
-                << "', asio error '" << e.what() << "'";
+            s.socket_.async_read_some(buf, s.strand_.wrap(
+                boost::bind(&Receiver::stream_event, this, &s, E_READ,
+                            asio::placeholders::error,
+                            asio::placeholders::bytes_transferred)));
         }
+    }
+    else
+    {
+        asio::mutable_buffers_1 const buf(asio::buffer(s.ptr_, s.left_));
+
         if (use_ssl_ == true)
         {
-            asio::ssl::stream<asio::ip::tcp::socket>
-                ssl_stream(io_service_, ssl_ctx_);
-            ssl_stream.lowest_layer().connect(*i);
+            asio::async_read(s.ssl_stream_, buf, s.strand_.wrap(
+                boost::bind(&Receiver::stream_event, this, &s, E_READ,
+                            asio::placeholders::error,
+                            asio::placeholders::bytes_transferred)));
+        }
+        else
+        {
+            asio::async_read(s.socket_, buf, s.strand_.wrap(
+                boost::bind(&Receiver::stream_event, this, &s, E_READ,
+                            asio::placeholders::error,
+                            asio::placeholders::bytes_transferred)));
+        }
+    }
+}
+
+
+/* the expected part of a trx message has been read */
+void galera::ist::Receiver::step(Stream& s)
+{
+    switch (s.state_)
+    {
+    case Stream::S_HEADER:
+        s.len_ = s.proto_.trx_header(&s.buf_[0], s.buf_.size());
+
+        if (0 == s.len_)
+        {
+            log_debug << "eof received, closing socket";
+            stream_done(s, 0, false);
+            return;
+        }
+
+        s.buf_.resize(Proto::TRX_META_SIZE);
+        s.state_ = Stream::S_META;
+        s.expect(&s.buf_[0], s.buf_.size());
+        read_next(s);
+        return;
+
+    case Stream::S_META:
+    {
+        size_t ws_size;
+        s.trx_ = s.proto_.trx_meta(&s.buf_[0], s.len_, s.seqno_g_,
+                                   s.seqno_d_, ws_size);
+        if (ws_size > 0)
+        {
+            s.state_ = Stream::S_BODY;
+            s.expect(&s.trx_->write_set_collection()[0], ws_size);
+            read_next(s);
+            return;
+        }
+        break;
+    }
+
+    case Stream::S_BODY:
+        break;
+    }
+
+    TrxHandle* const trx(s.trx_);
+    s.trx_ = 0;
+    s.proto_.trx_complete(trx, s.seqno_g_, s.seqno_d_);
+
+    if (trx->global_seqno() != s.next_)
+    {
+        log_error << "unexpected trx seqno: " << trx->global_seqno()
+                  << " expected: " << s.next_;
+        trx->unref();
+        stream_done(s, EINVAL, false);
+        return;
+    }
+
+    s.next_ += streams_.size();
+
+    s.bytes_      = s.proto_.raw_recv() - s.recv_bytes_;
+    s.recv_bytes_ = s.proto_.raw_recv();
+    s.trx_        = trx;
+
+    deliver(s);
+}
+
+
+/* queues the received trx for appliers, or parks the stream if it is too
+ * far ahead of them, recv() resumes it when the window moves */
+void galera::ist::Receiver::deliver(Stream& s)
+{
+    {
+        gu::Lock lock(mutex_);
+
+        wsrep_seqno_t const seqno(s.trx_->global_seqno());
+
+        if (running_ && !stopping_)
+        {
+            if (seqno - current_seqno_ >= RECV_WINDOW)
+            {
+                parked_.push_back(&s);
+                return;
+            }
+
+            pending_.insert(std::make_pair(seqno, s.trx_));
+            s.trx_       = 0;
+            recv_bytes_ += s.bytes_;
+
+            if (progress_) progress_->update(1);
+
+            /* only one applier can take it, the rest are woken up in
+             * a chain */
+            if (seqno == current_seqno_) apply_cond_.signal();
+        }
+    }
+
+    if (s.trx_ != 0)
+    {
+        /* receiving stopped */
+        stream_done(s, 0, false);
+        return;
+    }
+
+    s.buf_.resize(s.proto_.trx_header_size());
+    s.state_ = Stream::S_HEADER;
+    s.expect(&s.buf_[0], s.buf_.size());
+    read_next(s);
+}
+
+
+void galera::ist::Receiver::release_parked(bool const all)
+{
+    for (std::vector<Stream*>::iterator i(parked_.begin());
+         i != parked_.end();)
+    {
+        Stream* const s(*i);
+
+        if (all || s->trx_->global_seqno() - current_seqno_ < RECV_WINDOW)
+        {
+            s->strand_.post(boost::bind(&Receiver::stream_event, this, s,
+                                        E_RESUME, asio::error_code(), 0));
+            i = parked_.erase(i);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
+
+
+void galera::ist::Receiver::stream_done(Stream& s, int const ec,
+                                        bool const net_error)
+{
+    gu::Lock lock(mutex_);
+
+    if (s.trx_)
+    {
+        s.trx_->unref();
+        s.trx_ = 0;
+    }
+
+    bool abort(false);
+
+    if (net_error && running_ && resume_timeout_ > 0)
+    {
+        /* the session is to be resumed, so the stream is not counted out,
+         * make the rest of the session streams and the sender learn
+         * about it */
+        s.broken_ = true;
+        stopping_ = true;
+        abort     = true;
+    }
+    else
+    {
+        --streams_left_;
+
+        if (ec != 0)
+        {
+            if (ec != EINTR && error_code_ == 0) error_code_ = ec;
+            running_ = false;
+            abort    = true;
+        }
+    }
+
+    if (abort)
+    {
+        for (size_t i(0); i < streams_.size(); ++i)
+        {
+            Stream* const other(streams_[i]);
+            if (other && other != &s)
+            {
+                other->strand_.post(boost::bind(&Stream::close, other,
+                                                use_ssl_));
+            }
+        }
+        release_parked(true);
+    }
+
+    cond_.broadcast();
+    /* appliers waiting for the next trx may have to learn about EOF/error */
+    apply_cond_.broadcast();
+
+    if (--active_streams_ == 0) io_service_.stop();
+}
+
+
+void galera::ist::Stats::set_rate(long long const start, long long const end)
+{
+    long long const elapsed(start > 0 ?
+                            (end > 0 ? end : gu_time_monotonic()) - start : 0);
+
+    rate = (elapsed > 0 ? bytes * 1.0e9 / elapsed : 0);
+
+    wsrep_seqno_t const done(current - first + 1);
+
+    if (current >= last)
+    {
+        eta = 0;
+    }
+    else if (done > 0 && elapsed > 0)
+    {
+        eta = (last - current) * (elapsed * 1.0e-9) / done;
+    }
+    else
+    {
+        eta = -1;
+    }
+}
+
+
+void galera::ist::Receiver::stats_get(Stats& st) const
+{
+    gu::Lock lock(mutex_);
+
+    st.first   = first_seqno_;
+    st.last    = last_seqno_;
+    st.queue   = pending_.size();
+    /* gapless unless several streams are out of step */
+    st.current = current_seqno_ - 1 + st.queue;
+    st.bytes   = recv_bytes_;
+    if (first_seqno_ >= 0) st.set_rate(start_, end_);
+}
+
+
+void galera::ist::Receiver::ready()
+{
+    gu::Lock lock(mutex_);
+    ready_ = true;
+    cond_.broadcast();
+}
+
+int galera::ist::Receiver::recv(TrxHandle** trx)
+{
+    gu::Lock lock(mutex_);
+
+    while (true)
+    {
+        if (!pending_.empty() && pending_.begin()->first == current_seqno_)
+        {
+            *trx = pending_.begin()->second;
+            pending_.erase(pending_.begin());
+            ++current_seqno_;
+
+            release_parked(false); // window moved
+
+            /* pass the next trx on to another applier while this one is
+             * busy applying ours */
+            if (!pending_.empty() && pending_.begin()->first == current_seqno_)
+            {
+                apply_cond_.signal();
+            }
+
+            return 0;
+        }
+
+        if (running_ == false || streams_left_ == 0)
+        {
+            if (error_code_ != 0)
+            {
+                gu_throw_error(error_code_) << "IST receiver reported error";
+            }
+            return EINTR;
+        }
+
+        lock.wait(apply_cond_);
+    }
+}
+
+
+wsrep_seqno_t galera::ist::Receiver::finished()
+{
+    if (recv_addr_ == "")
+    {
+        log_debug << "IST was not prepared before calling finished()";
+    }
+    else
+    {
+        interrupt();
+
+        {
+            /* release stream readers waiting for consumer */
+            gu::Lock lock(mutex_);
+            running_ = false;
+            release_parked(true);
+            cond_.broadcast();
+            apply_cond_.broadcast();
+        }
+
+        int err;
+        if ((err = gu_thread_join(thread_, 0)) != 0)
+        {
+            log_warn << "Failed to join IST receiver thread: " << err;
+        }
+
+        acceptor_.close();
+
+        gu::Lock lock(mutex_);
+
+        running_ = false;
+
+        for (TrxMap::iterator i(pending_.begin()); i != pending_.end(); ++i)
+        {
+            i->second->unref();
+        }
+        pending_.clear();
+
+        cond_.broadcast();
+        apply_cond_.broadcast();
+
+        recv_addr_ = "";
+    }
+
+    return (current_seqno_ - 1);
+}
+
+
+void galera::ist::Receiver::interrupt()
+{
+    gu::URI uri(recv_addr_);
+    try
+    {
+        asio::ip::tcp::resolver::iterator i;
+        try
+        {
+            asio::ip::tcp::resolver resolver(io_service_);
+            asio::ip::tcp::resolver::query
+                query(gu::unescape_addr(uri.get_host()),
+                      uri.get_port(),
+                      asio::ip::tcp::resolver::query::flags(0));
+            i = resolver.resolve(query);
+        }
+        catch (asio::system_error& e)
+        {
+            gu_throw_error(e.code().value())
+                << "failed to resolve host '"
+                << uri.to_string()
+                << "', asio error '" << e.what() << "'";
+        }
+        if (use_ssl_ == true)
+        {
+            asio::ssl::stream<asio::ip::tcp::socket>
+                ssl_stream(io_service_, ssl_ctx_);
+            ssl_stream.lowest_layer().connect(*i);
             gu::set_fd_options(ssl_stream.lowest_layer());
             ssl_stream.handshake(asio::ssl::stream<asio::ip::tcp::socket>::client);
             Proto p(trx_pool_, version_,
@@ -625,7 +1450,8 @@ void galera::ist::Receiver::interrupt()
 galera::ist::Sender::Sender(const gu::Config&  conf,
                             gcache::GCache&    gcache,
                             const std::string& peer,
-                            int                version)
+                            int                version,
+                            GCS_IMPL*          gcs)
     :
     io_service_(),
     socket_    (io_service_),
@@ -633,19 +1459,28 @@ galera::ist::Sender::Sender(const gu::Config&  conf,
     ssl_stream_(0),
     conf_      (conf),
     gcache_    (gcache),
+    peer_      (peer),
     version_   (version),
-    use_ssl_   (false)
+    use_ssl_   (false),
+    ktls_tx_   (false),
+    gcs_       (gcs),
+    fc_limit_  (gcs ? conf.get<long>(CONF_FC_LIMIT) : 0),
+    send_rate_ (conf.get(SEND_RATE, CONF_SEND_RATE_DEFAULT)),
+    resume_timeout_(resume_timeout_from_config(conf)),
+    compress_  (compression_from_config(conf)),
+    batch_size_(batch_size_from_config(conf)),
+    share_     (0),
+    donors_    (1),
+    first_     (-1),
+    last_      (-1),
+    sent_seqno_(-1),
+    sent_bytes_(0),
+    start_     (0),
+    end_       (0)
 {
-    gu::URI uri(peer);
     try
     {
-        asio::ip::tcp::resolver resolver(io_service_);
-        asio::ip::tcp::resolver::query
-            query(gu::unescape_addr(uri.get_host()),
-                  uri.get_port(),
-                  asio::ip::tcp::resolver::query::flags(0));
-        asio::ip::tcp::resolver::iterator i(resolver.resolve(query));
-        if (uri.get_scheme() == "ssl")
+        if (gu::URI(peer).get_scheme() == "ssl")
         {
             use_ssl_ = true;
         }
@@ -653,18 +1488,8 @@ galera::ist::Sender::Sender(const gu::Config&  conf,
         {
             log_info << "IST sender using ssl";
             ssl_prepare_context(conf, ssl_ctx_);
-            // ssl_stream must be created after ssl_ctx_ is prepared...
-            ssl_stream_ = new asio::ssl::stream<asio::ip::tcp::socket>(
-                io_service_, ssl_ctx_);
-            ssl_stream_->lowest_layer().connect(*i);
-            gu::set_fd_options(ssl_stream_->lowest_layer());
-            ssl_stream_->handshake(asio::ssl::stream<asio::ip::tcp::socket>::client);
-        }
-        else
-        {
-            socket_.connect(*i);
-            gu::set_fd_options(socket_);
         }
+        connect();
     }
     catch (asio::system_error& e)
     {
@@ -678,8 +1503,11 @@ galera::ist::Sender::~Sender()
 {
     if (use_ssl_ == true)
     {
-        ssl_stream_->lowest_layer().close();
-        delete ssl_stream_;
+        if (ssl_stream_)
+        {
+            ssl_stream_->lowest_layer().close();
+            delete ssl_stream_;
+        }
     }
     else
     {
@@ -688,6 +1516,441 @@ galera::ist::Sender::~Sender()
     gcache_.seqno_unlock();
 }
 
+
+void galera::ist::Sender::connect()
+{
+    gu::URI const uri(peer_);
+    asio::ip::tcp::resolver resolver(io_service_);
+    asio::ip::tcp::resolver::query
+        query(gu::unescape_addr(uri.get_host()),
+              uri.get_port(),
+              asio::ip::tcp::resolver::query::flags(0));
+    asio::ip::tcp::resolver::iterator i(resolver.resolve(query));
+    if (use_ssl_ == true)
+    {
+        // ssl_stream must be created after ssl_ctx_ is prepared...
+        ssl_stream_ = new asio::ssl::stream<asio::ip::tcp::socket>(
+            io_service_, ssl_ctx_);
+        ssl_stream_->lowest_layer().connect(*i);
+        gu::set_fd_options(ssl_stream_->lowest_layer());
+        ssl_stream_->handshake(asio::ssl::stream<asio::ip::tcp::socket>::client);
+        // write sets go out in plain text, encrypted by the kernel
+        ktls_tx_ = gu::ssl_enable_ktls_tx(*ssl_stream_);
+    }
+    else
+    {
+        socket_.connect(*i);
+        gu::set_fd_options(socket_);
+    }
+}
+
+
+void galera::ist::Sender::reconnect()
+{
+    if (use_ssl_ == true)
+    {
+        if (ssl_stream_)
+        {
+            ssl_stream_->lowest_layer().close();
+            delete ssl_stream_;
+            ssl_stream_ = 0;
+        }
+    }
+    else
+    {
+        socket_.close();
+    }
+    connect();
+}
+
+/* Hands batches of gcache buffers from the main sender thread to the
+ * stream threads and waits for all of them to be sent. GCache seqno lock
+ * stays at the batch start until all streams are done with it. */
+class galera::ist::Sender::Batch
+{
+public:
+
+    explicit Batch(int const streams)
+        :
+        mutex_  (),
+        cond_   (),
+        bufs_   (0),
+        n_      (0),
+        gen_    (0),
+        streams_(streams),
+        pending_(0),
+        error_  (0),
+        net_error_(),
+        last_   (false),
+        done_   (false)
+    { }
+
+    void publish(const std::vector<gcache::GCache::Buffer>& bufs,
+                 size_t const n, bool const last)
+    {
+        gu::Lock lock(mutex_);
+        bufs_    = &bufs;
+        n_       = n;
+        last_    = last;
+        pending_ = streams_;
+        ++gen_;
+        cond_.broadcast();
+    }
+
+    /* waits for stream threads to send their share of the current batch */
+    void wait()
+    {
+        gu::Lock lock(mutex_);
+        while (pending_ > 0) lock.wait(cond_);
+        if (net_error_)
+        {
+            /* network errors are rethrown as such to be resumed */
+            throw asio::system_error(net_error_);
+        }
+        if (error_ != 0)
+        {
+            gu_throw_error(error_) << "IST stream failed";
+        }
+    }
+
+    /* returns false if there are no more batches */
+    bool next(long& gen, const std::vector<gcache::GCache::Buffer>*& bufs,
+              size_t& n, bool& last)
+    {
+        gu::Lock lock(mutex_);
+        while (gen_ == gen && done_ == false) lock.wait(cond_);
+        if (done_) return false;
+        gen  = gen_;
+        bufs = bufs_;
+        n    = n_;
+        last = last_;
+        return true;
+    }
+
+    void done(int const err, const asio::error_code& net_err)
+    {
+        gu::Lock lock(mutex_);
+        if (err != 0 && error_ == 0) error_ = err;
+        if (net_err && !net_error_) net_error_ = net_err;
+        if (--pending_ == 0) cond_.broadcast();
+    }
+
+    void finish()
+    {
+        gu::Lock lock(mutex_);
+        done_ = true;
+        cond_.broadcast();
+    }
+
+private:
+
+    gu::Mutex mutex_;
+    gu::Cond  cond_;
+    const std::vector<gcache::GCache::Buffer>* bufs_;
+    size_t    n_;
+    long      gen_;
+    int const streams_;
+    int       pending_;
+    int       error_;
+    asio::error_code net_error_;
+    bool      last_;
+    bool      done_;
+
+    Batch(const Batch&);
+    Batch& operator=(const Batch&);
+};
+
+
+namespace galera
+{
+    namespace ist
+    {
+        /* additional stream connection of a parallel IST */
+        class StreamSender : public Sender
+        {
+        public:
+
+            StreamSender(const gu::Config&  conf,
+                         gcache::GCache&    gcache,
+                         const std::string& peer,
+                         int                version,
+                         Batch&             batch,
+                         wsrep_seqno_t      first,
+                         int                streams,
+                         int                index)
+                :
+                Sender  (conf, gcache, peer, version),
+                batch_  (batch),
+                first_  (first),
+                streams_(streams),
+                index_  (index),
+                unused_ (1, 0, ""),
+                proto_  (unused_, version,
+                         conf.get(CONF_KEEP_KEYS, CONF_KEEP_KEYS_DEFAULT)),
+                thread_ (),
+                started_(false)
+            {
+                (void)handshake(proto_, streams_, index_);
+            }
+
+            void start();
+            void join();
+            void run();
+
+        private:
+
+            Batch&               batch_;
+            wsrep_seqno_t const  first_;
+            int const            streams_;
+            int const            index_;
+            TrxHandle::SlavePool unused_;
+            Proto                proto_;
+            gu_thread_t          thread_;
+            bool                 started_;
+
+            StreamSender(const StreamSender&);
+            StreamSender& operator=(const StreamSender&);
+        };
+    }
+}
+
+
+extern "C" void* run_stream_sender(void* arg)
+{
+    static_cast<galera::ist::StreamSender*>(arg)->run();
+    return 0;
+}
+
+
+void galera::ist::StreamSender::start()
+{
+    int const err(gu_thread_create(&thread_, 0, &run_stream_sender, this));
+    if (err != 0)
+    {
+        gu_throw_error(err) << "failed to start IST stream sender thread";
+    }
+    started_ = true;
+}
+
+
+void galera::ist::StreamSender::join()
+{
+    if (started_)
+    {
+        int const err(gu_thread_join(thread_, 0));
+        if (err != 0)
+        {
+            log_warn << "thread_join() failed: " << err;
+        }
+        started_ = false;
+    }
+}
+
+
+void galera::ist::StreamSender::run()
+{
+    long gen(0);
+    const std::vector<gcache::GCache::Buffer>* bufs(0);
+    size_t n;
+    bool   last;
+
+    while (batch_.next(gen, bufs, n, last))
+    {
+        int              err(0);
+        asio::error_code net_err;
+
+        try
+        {
+            send_share(proto_, *bufs, n, first_, streams_, index_);
+            if (last) send_eof(proto_);
+        }
+        catch (asio::system_error& e)
+        {
+            log_error << "IST stream " << index_ << " failed: " << e.what();
+            err     = e.code().value();
+            net_err = e.code();
+        }
+        catch (gu::Exception& e)
+        {
+            log_error << "IST stream " << index_ << " failed: " << e.what();
+            err = e.get_errno();
+        }
+
+        batch_.done(err, net_err);
+
+        if (last && !err) wait_close();
+        if (last || err) return;
+    }
+}
+
+
+/* negotiates the number of streams: at most the required number or what
+ * receiver offers, whichever is smaller. If resume is given, it is set to
+ * the seqno receiver wants to resume from or WSREP_SEQNO_UNDEFINED. */
+int galera::ist::Sender::handshake(Proto& p, int const streams, int const index,
+                                   wsrep_seqno_t* const resume)
+{
+    int      ret;
+    int32_t  ctrl;
+    uint64_t len(0);
+    uint8_t  offered(0);
+
+    if (use_ssl_ == true)
+    {
+        ret = std::min(streams, p.recv_handshake(*ssl_stream_, &offered));
+        uint8_t const flags(compress_ ? offered & Handshake::F_ZLIB : 0);
+        if (ktls_tx_ == true)
+        {
+            p.send_handshake_response(ssl_stream_->next_layer(), ret, index,
+                                      flags);
+        }
+        else
+        {
+            p.send_handshake_response(*ssl_stream_, ret, index, flags);
+        }
+        ctrl = p.recv_ctrl(*ssl_stream_, &len);
+    }
+    else
+    {
+        ret = std::min(streams, p.recv_handshake(socket_, &offered));
+        uint8_t const flags(compress_ ? offered & Handshake::F_ZLIB : 0);
+        p.send_handshake_response(socket_, ret, index, flags);
+        ctrl = p.recv_ctrl(socket_, &len);
+    }
+    if (ctrl < 0)
+    {
+        gu_throw_error(EPROTO)
+            << "ist send failed, peer reported error: " << ctrl;
+    }
+
+    p.set_compression(compress_ && (offered & Handshake::F_ZLIB));
+
+    if (resume)
+    {
+        *resume = (Ctrl::C_RESUME == ctrl ?
+                   static_cast<wsrep_seqno_t>(len) : WSREP_SEQNO_UNDEFINED);
+    }
+
+    return ret;
+}
+
+
+void galera::ist::Sender::send_share(
+    Proto& p,
+    const std::vector<gcache::GCache::Buffer>& bufs,
+    size_t const        n,
+    wsrep_seqno_t const first,
+    int const           streams,
+    int const           index)
+{
+    assert(n > 0);
+
+    /* first buffer of the batch which belongs to this stream */
+    size_t const i((index - (bufs[0].seqno_g() - first) % streams + streams)
+                   % streams);
+
+    if (ktls_tx_ == true)
+    {
+        p.send_trxs(ssl_stream_->next_layer(), bufs, i, n, streams);
+    }
+    else if (use_ssl_ == true)
+    {
+        p.send_trxs(*ssl_stream_, bufs, i, n, streams);
+    }
+    else
+    {
+        p.send_trxs(socket_, bufs, i, n, streams);
+    }
+}
+
+
+void galera::ist::Sender::stats_get(Stats& st) const
+{
+    st.first   = first_();
+    st.last    = last_();
+    st.current = sent_seqno_();
+    st.bytes   = sent_bytes_();
+    st.queue   = 0;
+    if (st.first >= 0) st.set_rate(start_(), end_());
+}
+
+
+void galera::ist::Sender::send_eof(Proto& p)
+{
+    if (ktls_tx_ == true)
+    {
+        p.send_ctrl(ssl_stream_->next_layer(), Ctrl::C_EOF);
+    }
+    else if (use_ssl_ == true)
+    {
+        p.send_ctrl(*ssl_stream_, Ctrl::C_EOF);
+    }
+    else
+    {
+        p.send_ctrl(socket_, Ctrl::C_EOF);
+    }
+}
+
+
+void galera::ist::Sender::wait_close()
+{
+    // wait until receiver closes the connection
+    try
+    {
+        gu::byte_t b;
+        size_t n;
+        if (use_ssl_ == true)
+        {
+            n = asio::read(*ssl_stream_, asio::buffer(&b, 1));
+        }
+        else
+        {
+            n = asio::read(socket_, asio::buffer(&b, 1));
+        }
+        if (n > 0)
+        {
+            log_warn << "received " << n
+                     << " bytes, expected none";
+        }
+    }
+    catch (asio::system_error& e)
+    { }
+}
+
+
+/* Keeps the transfer within ist.send_rate and gives way to the appliers of
+ * this node while they lag behind, so that IST does not make it send flow
+ * control messages. Called after each batch is sent. */
+void galera::ist::Sender::throttle(size_t const bytes,
+                                   long long const batch_start)
+{
+    static long long const PAUSE_STEP_NS(10000000LL);  // 10ms
+    static long long const PAUSE_MAX_NS (1000000000LL); // 1s per batch
+
+    long long const rate(send_rate_());
+
+    if (rate > 0)
+    {
+        long long const due(batch_start + bytes * 1000000000LL / rate);
+        long long const now(gu_time_monotonic());
+        if (due > now) usleep((due - now) / 1000);
+    }
+
+    if (gcs_ != 0 && fc_limit_ > 0)
+    {
+        /* pause is bounded not to hold the history locked forever */
+        for (long long paused(0); paused < PAUSE_MAX_NS;
+             paused += PAUSE_STEP_NS)
+        {
+            struct gcs_stats stats;
+            gcs_->get_stats(&stats);
+            if (2 * stats.recv_q_len <= fc_limit_) break;
+            usleep(PAUSE_STEP_NS / 1000);
+        }
+    }
+}
+
+
 void galera::ist::Sender::send(wsrep_seqno_t first, wsrep_seqno_t last)
 {
     if (first > last)
@@ -695,102 +1958,210 @@ void galera::ist::Sender::send(wsrep_seqno_t first, wsrep_seqno_t last)
         gu_throw_error(EINVAL) << "sender send first greater than last: "
                                << first << " > " << last ;
     }
+
+    static long long const RETRY_INTERVAL_US(500000); // 0.5s
+
+    long long deadline(0);
+    bool      resume(false);
+
+    first_      = first;
+    last_       = last;
+    sent_seqno_ = first - 1;
+    sent_bytes_ = 0;
+    start_      = gu_time_monotonic();
+    end_        = 0;
+
+    while (true)
+    {
+        wsrep_seqno_t const start(first);
+
+        try
+        {
+            send_session(first, last, resume);
+            end_ = gu_time_monotonic();
+            return;
+        }
+        catch (asio::system_error& e)
+        {
+            long long const now(gu_time_monotonic());
+
+            /* the receiver has at most resume_timeout_ to reconnect after
+             * the last interruption that was preceded by some progress */
+            if (!resume || first != start) deadline = now + resume_timeout_;
+
+            if (resume_timeout_ <= 0 || now >= deadline)
+            {
+                end_ = now;
+                gu_throw_error(e.code().value())
+                    << "ist send failed: " << e.code()
+                    << "', asio error '" << e.what() << "'";
+            }
+
+            if (!resume || first != start)
+            {
+                log_warn << "IST to " << peer_ << " interrupted at " << first
+                         << ": " << e.what() << ", trying to resume";
+            }
+
+            resume = true;
+            usleep(RETRY_INTERVAL_US);
+        }
+    }
+}
+
+
+/* Sends write sets over a single connection session. In case of resume
+ * reconnects first and continues from where receiver asks to. Network
+ * errors are thrown as asio::system_error, first is advanced past the write
+ * sets that have been sent. */
+void galera::ist::Sender::send_session(wsrep_seqno_t&      first,
+                                       wsrep_seqno_t const last,
+                                       bool const          resume)
+{
+    std::vector<StreamSender*> streams;
+
     try
     {
+        if (resume) reconnect();
+
         TrxHandle::SlavePool unused(1, 0, "");
         Proto p(unused, version_,
                 conf_.get(CONF_KEEP_KEYS, CONF_KEEP_KEYS_DEFAULT));
-        int32_t ctrl;
 
-        if (use_ssl_ == true)
-        {
-            p.recv_handshake(*ssl_stream_);
-            p.send_handshake_response(*ssl_stream_);
-            ctrl = p.recv_ctrl(*ssl_stream_);
-        }
-        else
+        /* a donor of split IST sends its share over a single stream */
+        bool const split(donors_ > 1);
+        int const  wanted(split ? donors_ : static_cast<int>(
+                              std::min<wsrep_seqno_t>(
+                                  streams_from_config(conf_),
+                                  last - first + 1)));
+
+        wsrep_seqno_t from;
+        int const n_streams(handshake(p, wanted, split ? share_ : 0, &from));
+
+        if (split && n_streams != donors_)
         {
-            p.recv_handshake(socket_);
-            p.send_handshake_response(socket_);
-            ctrl = p.recv_ctrl(socket_);
+            gu_throw_error(EPROTO) << "IST receiver accepts only " << n_streams
+                                   << " streams, split between " << donors_
+                                   << " donors";
         }
-        if (ctrl < 0)
+
+        int const own_streams(split ? 1 : n_streams);
+
+        if (resume)
         {
-            gu_throw_error(EPROTO)
-                << "ist send failed, peer reported error: " << ctrl;
+            if (from < 0 || from > last)
+            {
+                gu_throw_error(EPROTO) << "invalid IST resume point " << from
+                                       << ", last: " << last;
+            }
+
+            try
+            {
+                gcache_.seqno_lock(from);
+            }
+            catch (gu::NotFound&)
+            {
+                gu_throw_error(ENODATA) << "can't resume IST from " << from
+                                        << ": not in gcache any more";
+            }
+
+            log_info << "Resuming IST to " << peer_ << " from " << from;
+            first = from;
         }
 
-        std::vector<gcache::GCache::Buffer> buf_vec(
-            std::min(static_cast<size_t>(last - first + 1),
-                     static_cast<size_t>(1024)));
-        ssize_t n_read;
-        while ((n_read = gcache_.seqno_get_buffers(buf_vec, first)) > 0)
+        Batch batch(own_streams - 1);
+
+        try
         {
-            GU_DBUG_SYNC_WAIT("ist_sender_send_after_get_buffers")
-            //log_info << "read " << first << " + " << n_read << " from gcache";
-            for (wsrep_seqno_t i(0); i < n_read; ++i)
+            for (int i(1); i < own_streams; ++i)
+            {
+                streams.push_back(new StreamSender(conf_, gcache_, peer_,
+                                                   version_, batch, first,
+                                                   n_streams, i));
+            }
+
+            for (size_t i(0); i < streams.size(); ++i) streams[i]->start();
+
+            if (split)
+            {
+                log_info << "IST sending share " << share_ << '/' << donors_;
+            }
+            else if (n_streams > 1)
+            {
+                log_info << "IST sending over " << n_streams << " streams";
+            }
+
+            wsrep_seqno_t const ist_first(first);
+
+            std::vector<gcache::GCache::Buffer> buf_vec(
+                std::min(static_cast<size_t>(last - first + 1), batch_size_));
+            ssize_t n_read;
+            while ((n_read = gcache_.seqno_get_buffers(buf_vec, first)) > 0)
             {
-                // log_info << "sending " << buf_vec[i].seqno_g();
-                if (use_ssl_ == true)
+                GU_DBUG_SYNC_WAIT("ist_sender_send_after_get_buffers")
+                //log_info << "read " << first << " + " << n_read << " from gcache";
+                bool const last_batch(buf_vec[n_read - 1].seqno_g() == last);
+                long long const batch_start(gu_time_monotonic());
+
+                batch.publish(buf_vec, n_read, last_batch);
+                send_share(p, buf_vec, n_read, ist_first, n_streams,
+                           split ? share_ : 0);
+                batch.wait();
+
+                size_t bytes(0);
+                for (ssize_t i(0); i < n_read; ++i)
                 {
-                    p.send_trx(*ssl_stream_, buf_vec[i]);
+                    /* only own share counts for a donor of split IST */
+                    if (!split ||
+                        (buf_vec[i].seqno_g() - ist_first) % n_streams ==
+                        share_)
+                    {
+                        bytes += buf_vec[i].size();
+                    }
                 }
-                else
+
+                sent_bytes_ += bytes;
+                sent_seqno_  = buf_vec[n_read - 1].seqno_g();
+
+                if (!last_batch) throttle(bytes, batch_start);
+
+                if (last_batch)
                 {
-                    p.send_trx(socket_, buf_vec[i]);
+                    send_eof(p);
+                    wait_close();
+                    break;
                 }
 
-                if (buf_vec[i].seqno_g() == last)
+                first += n_read;
+                // resize buf_vec to avoid scanning gcache past last
+                size_t next_size(std::min(static_cast<size_t>(last - first + 1),
+                                          batch_size_));
+
+                if (buf_vec.size() != next_size)
                 {
-                    if (use_ssl_ == true)
-                    {
-                        p.send_ctrl(*ssl_stream_, Ctrl::C_EOF);
-                    }
-                    else
-                    {
-                        p.send_ctrl(socket_, Ctrl::C_EOF);
-                    }
-                    // wait until receiver closes the connection
-                    try
-                    {
-                        gu::byte_t b;
-                        size_t n;
-                        if (use_ssl_ == true)
-                        {
-                            n = asio::read(*ssl_stream_, asio::buffer(&b, 1));
-                        }
-                        else
-                        {
-                            n = asio::read(socket_, asio::buffer(&b, 1));
-                        }
-                        if (n > 0)
-                        {
-                            log_warn << "received " << n
-                                     << " bytes, expected none";
-                        }
-                    }
-                    catch (asio::system_error& e)
-                    { }
-                    return;
+                    buf_vec.resize(next_size);
                 }
             }
-            first += n_read;
-            // resize buf_vec to avoid scanning gcache past last
-            size_t next_size(std::min(static_cast<size_t>(last - first + 1),
-                                      static_cast<size_t>(1024)));
-
-            if (buf_vec.size() != next_size)
-            {
-                buf_vec.resize(next_size);
-            }
         }
+        catch (...)
+        {
+            /* streams will see an error on their sockets when we close ours,
+             * or will simply finish current batch */
+            batch.finish();
+            for (size_t i(0); i < streams.size(); ++i) streams[i]->join();
+            throw;
+        }
+
+        batch.finish();
+        for (size_t i(0); i < streams.size(); ++i) streams[i]->join();
     }
-    catch (asio::system_error& e)
+    catch (...)
     {
-        gu_throw_error(e.code().value()) << "ist send failed: " << e.code()
-                                         << "', asio error '" << e.what()
-                                         << "'";
+        for (size_t i(0); i < streams.size(); ++i) delete streams[i];
+        throw;
     }
+
+    for (size_t i(0); i < streams.size(); ++i) delete streams[i];
 }
 
 
@@ -840,10 +2211,13 @@ void galera::ist::AsyncSenderMap::run(const gu::Config&  conf,
                                       const std::string& peer,
                                       wsrep_seqno_t      first,
                                       wsrep_seqno_t      last,
-                                      int                version)
+                                      int                version,
+                                      int                share,
+                                      int                donors)
 {
     gu::Critical crit(monitor_);
-    AsyncSender* as(new AsyncSender(conf, peer, first, last, *this, version));
+    AsyncSender* as(new AsyncSender(conf, peer, first, last, *this, version,
+                                    share, donors));
     int err(gu_thread_create(&as->thread_, 0, &run_async_sender, as));
     if (err != 0)
     {
@@ -862,10 +2236,59 @@ void galera::ist::AsyncSenderMap::remove(AsyncSender* as, wsrep_seqno_t seqno)
     {
         throw gu::NotFound();
     }
+    as->stats_get(last_stats_);
     senders_.erase(i);
 }
 
 
+int galera::ist::AsyncSenderMap::stats_get(Stats& st)
+{
+    gu::Critical crit(monitor_);
+
+    if (senders_.empty())
+    {
+        st = last_stats_;
+        return 0;
+    }
+
+    long long bytes(0);
+    double    rate(0);
+
+    for (std::set<AsyncSender*>::iterator i(senders_.begin());
+         i != senders_.end(); ++i)
+    {
+        Stats s;
+        (*i)->stats_get(s);
+
+        bytes += s.bytes;
+        rate  += s.rate;
+
+        /* unknown eta may mean the longest */
+        if (i == senders_.begin() || s.eta < 0 ||
+            (st.eta >= 0 && s.eta > st.eta))
+        {
+            st = s;
+        }
+    }
+
+    st.bytes = bytes;
+    st.rate  = rate;
+
+    return senders_.size();
+}
+
+
+void galera::ist::AsyncSenderMap::set_send_rate(long long const rate)
+{
+    gu::Critical crit(monitor_);
+    for (std::set<AsyncSender*>::iterator i(senders_.begin());
+         i != senders_.end(); ++i)
+    {
+        (*i)->set_send_rate(rate);
+    }
+}
+
+
 void galera::ist::AsyncSenderMap::cancel()
 {
     gu::Critical crit(monitor_);
@@ -10,18 +10,25 @@
 #include "galera_gcs.hpp"
 #include "trx_handle.hpp"
 #include "gu_config.hpp"
+#include "gu_atomic.hpp"
 #include "gu_lock.hpp"
 #include "gu_monitor.hpp"
 #include "gu_asio.hpp"
 
-#include <stack>
+#include <map>
 #include <set>
+#include <vector>
 
 namespace gcache
 {
     class GCache;
 }
 
+namespace gu
+{
+    template <typename T> class Progress;
+}
+
 namespace galera
 {
     class TrxHandle;
@@ -30,6 +37,27 @@ namespace galera
     {
         void register_params(gu::Config& conf);
 
+        class Proto;
+
+        /*! IST progress as reported in status variables */
+        struct Stats
+        {
+            Stats() : first(-1), last(-1), current(-1), bytes(0), queue(0),
+                      rate(0), eta(-1) { }
+
+            /*! derives rate and eta from progress made between start and
+             *  end (ns), 0 end - still in progress */
+            void set_rate(long long start, long long end);
+
+            wsrep_seqno_t first;   // first seqno of the transfer, -1 if none
+            wsrep_seqno_t last;    // last seqno of the transfer
+            wsrep_seqno_t current; // transferred up to
+            long long     bytes;   // write set bytes transferred
+            long long     queue;   // received, not taken by appliers yet
+            double        rate;    // bytes per second
+            double        eta;     // seconds to completion, -1 if unknown
+        };
+
         class Receiver
         {
         public:
@@ -40,52 +68,79 @@ namespace galera
             ~Receiver();
 
             std::string   prepare(wsrep_seqno_t, wsrep_seqno_t, int);
+            /*! maximum number of donors to split IST between */
+            int           donors() const;
             void          ready();
             int           recv(TrxHandle** trx);
             wsrep_seqno_t finished();
             void          run();
+            /*! runs stream handlers of the current session */
+            void          run_io();
+            /*! progress of the current or the last IST */
+            void          stats_get(Stats&) const;
+
+            class Stream;
 
         private:
 
             void interrupt();
+            void open_acceptor();
+            void accept(Stream& stream, long long deadline);
+            int  handshake(Stream& stream, int streams, int& index,
+                           wsrep_seqno_t resume);
+            int  run_session(wsrep_seqno_t& first,
+                             gu::Progress<wsrep_seqno_t>& progress,
+                             long long deadline, bool& broken);
+
+            /* Streams are received by asynchronous state machines in
+             * io_service_, see stream_event(). */
+            enum StreamEvent { E_START, E_READ, E_RESUME };
+            void run_streams();
+            void stream_event(Stream* stream, StreamEvent event,
+                              const asio::error_code& ec, size_t bytes);
+            void read_next(Stream& stream);
+            void async_read(Stream& stream);
+            void step(Stream& stream);
+            void deliver(Stream& stream);
+            void stream_done(Stream& stream, int ec, bool net_error);
+            /* posts parked streams that fit in the window (all) to be
+             * resumed, mutex_ must be locked */
+            void release_parked(bool all);
+
+            /* how far ahead of the consumer stream readers may go */
+            static wsrep_seqno_t const RECV_WINDOW = 1024;
+
+            typedef std::map<wsrep_seqno_t, TrxHandle*> TrxMap;
 
             std::string                                   recv_addr_;
             std::string                                   recv_bind_;
             asio::io_service                              io_service_;
             asio::ip::tcp::acceptor                       acceptor_;
+            asio::ip::tcp::endpoint                       endpoint_;
             asio::ssl::context                            ssl_ctx_;
             gu::Mutex                                     mutex_;
             gu::Cond                                      cond_;
+            gu::Cond                                      apply_cond_;
 
-            class Consumer
-            {
-            public:
-
-                Consumer() : cond_(), trx_(0) { }
-                ~Consumer() { }
-
-                gu::Cond&  cond()              { return cond_; }
-                void       trx(TrxHandle* trx) { trx_ = trx;   }
-                TrxHandle* trx() const         { return trx_;  }
-
-            private:
-
-                // Non-copyable
-                Consumer(const Consumer&);
-                Consumer& operator=(const Consumer&);
-
-                gu::Cond   cond_;
-                TrxHandle* trx_;
-            };
-
-            std::stack<Consumer*> consumers_;
+            std::vector<Stream*>  streams_;
+            std::vector<Stream*>  parked_;      // waiting for window to move
+            TrxMap                pending_;     // received, not yet applied
+            gu::Progress<wsrep_seqno_t>* progress_;
             wsrep_seqno_t         current_seqno_;
             wsrep_seqno_t         last_seqno_;
+            wsrep_seqno_t         first_seqno_;
+            long long             recv_bytes_;
+            long long             start_;       // first stream connected, ns
+            long long             end_;         // receiving ended, ns
             gu::Config&           conf_;
+            long long const       resume_timeout_; // ns
             TrxHandle::SlavePool& trx_pool_;
             gu_thread_t           thread_;
             int                   error_code_;
             int                   version_;
+            int                   streams_left_; // streams not at EOF yet
+            int                   active_streams_; // state machines running
+            bool                  stopping_;     // session is being aborted
             bool                  use_ssl_;
             bool                  running_;
             bool                  ready_;
@@ -98,20 +153,43 @@ namespace galera
         class Sender
         {
         public:
+            /* bytes per second, 0 for unlimited */
+            static std::string const SEND_RATE;
 
+            /*!
+             * @param gcs if given, sending pauses while the recv queue of
+             *            this node is over half of gcs.fc_limit
+             */
             Sender(const gu::Config& conf,
                    gcache::GCache& gcache,
                    const std::string& peer,
-                   int version);
+                   int version,
+                   GCS_IMPL* gcs = 0);
             virtual ~Sender();
 
             void send(wsrep_seqno_t first, wsrep_seqno_t last);
 
+            void set_send_rate(long long rate) { send_rate_ = rate; }
+
+            /*! progress of send() */
+            void stats_get(Stats&) const;
+
+            /*!
+             * Makes send() transfer only the share of this donor when IST is
+             * split between several ones: every donors-th write set starting
+             * with index, over a single stream.
+             */
+            void set_share(int index, int donors)
+            {
+                share_  = index;
+                donors_ = donors;
+            }
+
             void cancel()
             {
                 if (use_ssl_ == true)
                 {
-                    ssl_stream_->lowest_layer().close();
+                    if (ssl_stream_) ssl_stream_->lowest_layer().close();
                 }
                 else
                 {
@@ -119,16 +197,51 @@ namespace galera
                 }
             }
 
+        protected:
+
+            class Batch;
+
+            int  handshake(Proto& p, int streams, int index,
+                           wsrep_seqno_t* resume = 0);
+            void send_share(Proto& p,
+                            const std::vector<gcache::GCache::Buffer>& bufs,
+                            size_t n, wsrep_seqno_t first, int streams,
+                            int index);
+            void send_eof(Proto& p);
+            void wait_close();
+            void throttle(size_t bytes, long long batch_start);
+
         private:
 
+            void connect();
+            void reconnect();
+            void send_session(wsrep_seqno_t& first, wsrep_seqno_t last,
+                              bool resume);
+
             asio::io_service                          io_service_;
             asio::ip::tcp::socket                     socket_;
             asio::ssl::context                        ssl_ctx_;
             asio::ssl::stream<asio::ip::tcp::socket>* ssl_stream_;
             const gu::Config&                         conf_;
             gcache::GCache&                           gcache_;
+            std::string const                         peer_;
             int                                       version_;
             bool                                      use_ssl_;
+            bool                                      ktls_tx_;
+            GCS_IMPL* const                           gcs_;
+            long                                      fc_limit_;
+            gu::Atomic<long long>                     send_rate_;
+            long long const                           resume_timeout_; // ns
+            bool const                                compress_;
+            size_t const                              batch_size_;
+            int                                       share_;
+            int                                       donors_;
+            gu::Atomic<long long>                     first_;
+            gu::Atomic<long long>                     last_;
+            gu::Atomic<long long>                     sent_seqno_;
+            gu::Atomic<long long>                     sent_bytes_;
+            gu::Atomic<long long>                     start_; // ns
+            gu::Atomic<long long>                     end_;   // ns
 
             Sender(const Sender&);
             void operator=(const Sender&);
@@ -143,20 +256,36 @@ namespace galera
                 :
                 senders_(),
                 monitor_(),
-                gcache_(gcache) { }
+                gcs_(gcs),
+                gcache_(gcache),
+                last_stats_() { }
             void run(const gu::Config& conf,
                      const std::string& peer,
                      wsrep_seqno_t,
                      wsrep_seqno_t,
-                     int);
+                     int,
+                     int share  = 0,
+                     int donors = 1);
             void remove(AsyncSender*, wsrep_seqno_t);
             void cancel();
+            /*! applies new send rate to running senders */
+            void set_send_rate(long long rate);
+            /*!
+             * Sums up progress of running senders, seqnos and eta are of the
+             * one to finish last. If none is running, reports the last one.
+             *
+             * @return number of running senders
+             */
+            int  stats_get(Stats&);
+            GCS_IMPL&       gcs()    { return gcs_;    }
             gcache::GCache& gcache() { return gcache_; }
         private:
             std::set<AsyncSender*> senders_;
             // use monitor instead of mutex, it provides cancellation point
             gu::Monitor            monitor_;
+            GCS_IMPL&              gcs_;
             gcache::GCache&        gcache_;
+            Stats                  last_stats_; // of the last removed one
         };
 
 
@@ -13,6 +13,10 @@
 #include "gu_serialize.hpp"
 #include "gu_vector.hpp"
 
+#include <algorithm>
+
+#include <zlib.h>
+
 //
 // Message class must have non-virtual destructor until
 // support up to version 3 is removed as serialization/deserialization
@@ -36,6 +40,27 @@
 // send_ctrl(EOF)            ----->
 //                          <-----   close()
 // close()
+//
+// Parallel streams:
+// Receiver offers the maximum number of streams it accepts in handshake
+// ctrl field, sender replies with the number of streams to be used in
+// handshake response ctrl field and the index of the stream in flags field.
+// Sender then connects remaining streams and repeats the handshake on each.
+// Stream i carries seqnos first + i, first + i + N, ... where N is the number
+// of streams, so receiver can reorder them without extra metadata. Peers that
+// leave these fields zeroed fall back to a single stream.
+//
+// Resume:
+// Sender that reconnects after network error is answered with
+// send_ctrl(RESUME) instead of send_ctrl(OK), len field of which carries the
+// seqno to continue from.
+//
+// Compression:
+// Receiver sets F_ZLIB in handshake flags field if it can inflate, sender
+// that wants to compress sets it in handshake response len field. Everything
+// sender sends on the stream after handshake is then a single deflate stream,
+// sync flushed after each write, so the dictionary carries over from one
+// write set to the next.
 
 //
 // Note about protocol/message versioning:
@@ -103,13 +128,14 @@ namespace galera
 #endif // NDEBUG
                 if (version_ > 3)
                 {
-                    offset = gu::serialize1(uint8_t(version_),
-                                            buf, buflen, offset);
-                    offset = gu::serialize1(uint8_t(type_),
-                                            buf, buflen, offset);
-                    offset = gu::serialize1(flags_, buf, buflen, offset);
-                    offset = gu::serialize1(ctrl_,  buf, buflen, offset);
-                    offset = gu::serialize8(len_,   buf, buflen, offset);
+                    gu::serial_check(buflen, offset, 4 + sizeof(len_));
+                    offset = gu::serialize1_unchecked(uint8_t(version_),
+                                                      buf, offset);
+                    offset = gu::serialize1_unchecked(uint8_t(type_),
+                                                      buf, offset);
+                    offset = gu::serialize1_unchecked(flags_, buf, offset);
+                    offset = gu::serialize1_unchecked(ctrl_,  buf, offset);
+                    offset = gu::serialize8_unchecked(len_,   buf, offset);
                 }
                 else
                 {
@@ -155,11 +181,12 @@ namespace galera
                 if (u8 > 3)
                 {
                     version_ = u8;
-                    offset = gu::unserialize1(buf, buflen, offset, u8);
+                    gu::serial_check(buflen, offset, 3 + sizeof(len_));
+                    offset = gu::unserialize1_unchecked(buf, offset, u8);
                     type_  = static_cast<Message::Type>(u8);
-                    offset = gu::unserialize1(buf, buflen, offset, flags_);
-                    offset = gu::unserialize1(buf, buflen, offset, ctrl_);
-                    offset = gu::unserialize8(buf, buflen, offset, len_);
+                    offset = gu::unserialize1_unchecked(buf, offset, flags_);
+                    offset = gu::unserialize1_unchecked(buf, offset, ctrl_);
+                    offset = gu::unserialize8_unchecked(buf, offset, len_);
                 }
                 else
                 {
@@ -194,18 +221,25 @@ namespace galera
         class Handshake : public Message
         {
         public:
-            Handshake(int version = -1)
+            enum
+            {
+                F_ZLIB = 1 // stream compression
+            };
+            Handshake(int version = -1, int8_t streams = 0, uint8_t flags = 0)
                 :
-                Message(version, Message::T_HANDSHAKE, 0, 0, 0)
+                Message(version, Message::T_HANDSHAKE, flags, streams, 0)
             { }
         };
 
         class HandshakeResponse : public Message
         {
         public:
-            HandshakeResponse(int version = -1)
+            // flags are the Handshake ones chosen by sender
+            HandshakeResponse(int version = -1, int8_t streams = 0,
+                              uint8_t index = 0, uint8_t flags = 0)
                 :
-                Message(version, Message::T_HANDSHAKE_RESPONSE, 0, 0, 0)
+                Message(version, Message::T_HANDSHAKE_RESPONSE, index, streams,
+                        flags)
             { }
         };
 
@@ -216,11 +250,14 @@ namespace galera
             {
                 // negative values reserved for error codes
                 C_OK = 0,
-                C_EOF = 1
+                C_EOF = 1,
+                // sent by receiver instead of C_OK when sender reconnects
+                // after interruption, len carries the first seqno to send
+                C_RESUME = 2
             };
-            Ctrl(int version = -1, int8_t code = 0)
+            Ctrl(int version = -1, int8_t code = 0, uint64_t len = 0)
                 :
-                Message(version, Message::T_CTRL, 0, code, 0)
+                Message(version, Message::T_CTRL, 0, code, len)
             { }
         };
 
@@ -241,14 +278,26 @@ namespace galera
             Proto(TrxHandle::SlavePool& sp, int version, bool keep_keys)
                 :
                 trx_pool_ (sp),
+                iov_      (),
+                iov_hdrs_ (),
+                zout_     (),
+                zin_      (),
+                zbuf_     (),
                 raw_sent_ (0),
                 real_sent_(0),
+                raw_recv_ (0),
                 version_  (version),
-                keep_keys_(keep_keys)
+                keep_keys_(keep_keys),
+                compress_ (false),
+                zout_init_(false),
+                zin_init_ (false)
             { }
 
             ~Proto()
             {
+                if (zout_init_) deflateEnd(&zout_);
+                if (zin_init_)  inflateEnd(&zin_);
+
                 if (raw_sent_ > 0)
                 {
                     log_info << "ist proto finished, raw sent: "
@@ -261,10 +310,17 @@ namespace galera
                 }
             }
 
+            /*! everything after the handshake is (de)compressed */
+            void set_compression(bool const c) { compress_ = c; }
+
+            /*! uncompressed bytes received so far */
+            uint64_t raw_recv() const { return raw_recv_; }
+
             template <class ST>
-            void send_handshake(ST& socket)
+            void send_handshake(ST& socket, int streams = 1,
+                                uint8_t flags = 0)
             {
-                Handshake  hs(version_);
+                Handshake  hs(version_, streams, flags);
                 gu::Buffer buf(hs.serial_size());
                 size_t offset(hs.serialize(&buf[0], buf.size(), 0));
                 size_t n(asio::write(socket, asio::buffer(&buf[0],
@@ -275,8 +331,10 @@ namespace galera
                 }
             }
 
+            // returns the number of streams offered by receiver,
+            // stores handshake flags in flags if given
             template <class ST>
-            void recv_handshake(ST& socket)
+            int recv_handshake(ST& socket, uint8_t* flags = 0)
             {
                 Message    msg(version_);
                 gu::Buffer buf(msg.serial_size());
@@ -318,12 +376,17 @@ namespace galera
                                            << version_;
                 }
                 // TODO: Figure out protocol versions to use
+
+                if (flags) *flags = msg.flags();
+
+                return std::max<int>(msg.ctrl(), 1);
             }
 
             template <class ST>
-            void send_handshake_response(ST& socket)
+            void send_handshake_response(ST& socket, int streams = 1,
+                                         int index = 0, uint8_t flags = 0)
             {
-                HandshakeResponse hsr(version_);
+                HandshakeResponse hsr(version_, streams, index, flags);
                 gu::Buffer buf(hsr.serial_size());
                 size_t offset(hsr.serialize(&buf[0], buf.size(), 0));
                 size_t n(asio::write(socket, asio::buffer(&buf[0], buf.size())));
@@ -334,8 +397,12 @@ namespace galera
                 }
             }
 
+            // returns the number of streams chosen by sender,
+            // index of this stream is stored in index, flags chosen by sender
+            // in flags if given
             template <class ST>
-            void recv_handshake_response(ST& socket)
+            int recv_handshake_response(ST& socket, int& index,
+                                        uint8_t* flags = 0)
             {
                 Message    msg(version_);
                 gu::Buffer buf(msg.serial_size());
@@ -355,7 +422,9 @@ namespace galera
                 switch (msg.type())
                 {
                 case Message::T_HANDSHAKE_RESPONSE:
-                    break;
+                    index = msg.flags();
+                    if (flags) *flags = static_cast<uint8_t>(msg.len());
+                    return std::max<int>(msg.ctrl(), 1);
                 case Message::T_CTRL:
                     switch (msg.ctrl())
                     {
@@ -369,23 +438,28 @@ namespace galera
                     gu_throw_error(EINVAL) << "unexpected message type: "
                                            << msg.type();
                 }
+
+                gu_throw_fatal; throw;
             }
 
             template <class ST>
-            void send_ctrl(ST& socket, int8_t code)
+            void send_ctrl(ST& socket, int8_t code, uint64_t len = 0)
             {
-                Ctrl       ctrl(version_, code);
+                Ctrl       ctrl(version_, code, len);
                 gu::Buffer buf(ctrl.serial_size());
                 size_t offset(ctrl.serialize(&buf[0], buf.size(), 0));
-                size_t n(asio::write(socket, asio::buffer(&buf[0],buf.size())));
+                std::vector<asio::const_buffer> cbs(
+                    1, asio::const_buffer(&buf[0], buf.size()));
+                size_t n(write(socket, cbs));
                 if (n != offset)
                 {
                     gu_throw_error(EPROTO) << "error sending ctrl message";
                 }
             }
 
+            // len field of the message is stored in len if given
             template <class ST>
-            int8_t recv_ctrl(ST& socket)
+            int8_t recv_ctrl(ST& socket, uint64_t* len = 0)
             {
                 Message    msg(version_);
                 gu::Buffer buf(msg.serial_size());
@@ -409,6 +483,7 @@ namespace galera
                     gu_throw_error(EPROTO) << "unexpected message type: "
                                            << msg.type();
                 }
+                if (len) *len = msg.len();
                 return msg.ctrl();
             }
 
@@ -417,39 +492,318 @@ namespace galera
             void send_trx(ST&                           socket,
                           const gcache::GCache::Buffer& buffer)
             {
-                const bool rolled_back(buffer.seqno_d() == -1);
+                queue_trx(buffer);
+                flush_trxs(socket);
+            }
 
-                galera::WriteSetIn ws;
-                boost::array<asio::const_buffer, 3> cbs;
-                size_t      payload_size; /* size of the 2nd cbs buffer */
-                size_t      sent;
+            // Sends buffers begin, begin + step, ... up to end. Messages
+            // are gathered in as few vectored writes as possible, payload
+            // is sent directly from gcache memory.
+            template <class ST>
+            void send_trxs(ST&                                        socket,
+                           const std::vector<gcache::GCache::Buffer>& bufs,
+                           size_t const begin,
+                           size_t const end,
+                           size_t const step)
+            {
+                for (size_t i(begin); i < end; i += step)
+                {
+                    queue_trx(bufs[i]);
+
+                    if (iov_.size() + MAX_TRX_PIECES > MAX_IOV ||
+                        iov_hdrs_.size() >= MAX_HDRS_SIZE)
+                    {
+                        flush_trxs(socket);
+                    }
+                }
+
+                flush_trxs(socket);
+            }
+
+            template <class ST>
+            galera::TrxHandle*
+            recv_trx(ST& socket)
+            {
+                gu::Buffer buf(trx_header_size());
+                size_t n(read(socket, &buf[0], buf.size()));
+
+                if (n != buf.size())
+                {
+                    gu_throw_error(EPROTO) << "error receiving trx header";
+                }
+
+                size_t const len(trx_header(&buf[0], buf.size()));
+                if (0 == len) return 0;
+
+                // TODO: ideally we want to make seqno_g and cert verdict
+                // be a part of msg object above, so that we can skip this
+                // read. The overhead is tiny given that vast majority of
+                // messages will be trx writesets.
+                buf.resize(TRX_META_SIZE);
+
+                n = read(socket, &buf[0], buf.size());
+                if (n != buf.size())
+                {
+                    gu_throw_error(EPROTO) << "error reading trx meta data";
+                }
+
+                wsrep_seqno_t seqno_g, seqno_d;
+                size_t        ws_size;
+                galera::TrxHandle* const trx(trx_meta(&buf[0], len, seqno_g,
+                                                      seqno_d, ws_size));
+                if (ws_size > 0)
+                {
+                    MappedBuffer& wbuf(trx->write_set_collection());
+
+                    n = read(socket, &wbuf[0], wbuf.size());
+
+                    if (gu_unlikely(n != wbuf.size()))
+                    {
+                        trx->unref();
+                        gu_throw_error(EPROTO)
+                            << "error reading write set data";
+                    }
+                }
+
+                trx_complete(trx, seqno_g, seqno_d);
+                return trx;
+            }
+
+            /*
+             * Pieces of recv_trx() for readers that can't block: a trx
+             * message is a header of trx_header_size() bytes, meta data
+             * of TRX_META_SIZE bytes and write set data of the size
+             * returned by trx_meta(), to be read into
+             * trx->write_set_collection(). Compressed input is taken with
+             * in_buffer()/in_filled() and inflated with inflate_some().
+             */
+
+            static size_t const TRX_META_SIZE = 16; // seqno_g, seqno_d
+
+            size_t trx_header_size() const
+            {
+                return Message(version_).serial_size();
+            }
+
+            /*! @return trx message length, 0 on EOF */
+            size_t trx_header(const gu::byte_t* const buf, size_t const size)
+            {
+                Message msg(version_);
+                (void)msg.unserialize(buf, size, 0);
+
+                log_debug << "received header: " << size << " bytes, type "
+                          << msg.type() << " len " << msg.len();
+
+                switch (msg.type())
+                {
+                case Message::T_TRX:
+                    if (msg.len() < TRX_META_SIZE)
+                    {
+                        gu_throw_error(EPROTO) << "trx message too short: "
+                                               << msg.len();
+                    }
+                    return msg.len();
+                case Message::T_CTRL:
+                    switch (msg.ctrl())
+                    {
+                    case Ctrl::C_EOF:
+                        return 0;
+                    default:
+                        if (msg.ctrl() >= 0)
+                        {
+                            gu_throw_error(EPROTO)
+                                << "unexpected ctrl code: " << msg.ctrl();
+                        }
+                        else
+                        {
+                            gu_throw_error(-msg.ctrl()) <<"peer reported error";
+                        }
+                    }
+                default:
+                    gu_throw_error(EPROTO) << "unexpected message type: "
+                                           << msg.type();
+                }
+
+                gu_throw_fatal; throw;
+                return 0; // keep compiler happy
+            }
+
+            /*! @param len message length returned by trx_header()
+             *  @return new trx, its write set buffer resized to ws_size */
+            galera::TrxHandle* trx_meta(const gu::byte_t* const buf,
+                                        size_t const        len,
+                                        wsrep_seqno_t&      seqno_g,
+                                        wsrep_seqno_t&      seqno_d,
+                                        size_t&             ws_size)
+            {
+                size_t offset(gu::unserialize8(buf, TRX_META_SIZE, 0,
+                                               seqno_g));
+                offset = gu::unserialize8(buf, TRX_META_SIZE, offset,
+                                          seqno_d);
+
+                if (seqno_d == WSREP_SEQNO_UNDEFINED && offset != len)
+                {
+                    gu_throw_error(EINVAL)
+                        << "message size " << len
+                        << " does not match expected size " << offset;
+                }
+
+                galera::TrxHandle* const trx(galera::TrxHandle::New(trx_pool_));
+
+                ws_size = (seqno_d == WSREP_SEQNO_UNDEFINED ? 0 :
+                           len - offset);
+
+                if (ws_size > 0) trx->write_set_collection().resize(ws_size);
+
+                return trx;
+            }
+
+            /*! unserializes write set data read into trx */
+            void trx_complete(galera::TrxHandle* const trx,
+                              wsrep_seqno_t const      seqno_g,
+                              wsrep_seqno_t const      seqno_d)
+            {
+                if (seqno_d != WSREP_SEQNO_UNDEFINED)
+                {
+                    MappedBuffer& wbuf(trx->write_set_collection());
+                    try
+                    {
+                        trx->unserialize(&wbuf[0], wbuf.size(), 0);
+                    }
+                    catch (...)
+                    {
+                        trx->unref();
+                        throw;
+                    }
+                }
+
+                if (seqno_d == WSREP_SEQNO_UNDEFINED ||
+                    trx->version() < 3)
+                {
+                    trx->set_received(0, -1, seqno_g);
+                    trx->set_depends_seqno(seqno_d);
+                }
+                else
+                {
+                    trx->set_received_from_ws();
+                    assert(trx->global_seqno() == seqno_g);
+                    assert(trx->depends_seqno() >= seqno_d);
+                }
+                trx->mark_certified();
+
+                log_debug << "received trx body: " << *trx;
+            }
 
-                if (gu_unlikely(rolled_back))
+            /*! buffer to read compressed input into */
+            asio::mutable_buffers_1 in_buffer()
+            {
+                if (!zin_init_)
+                {
+                    if (Z_OK != inflateInit(&zin_))
+                    {
+                        gu_throw_error(ENOMEM) << "inflateInit() failed";
+                    }
+                    zin_init_ = true;
+                    zbuf_.resize(ZBUF_SIZE);
+                }
+
+                return asio::buffer(&zbuf_[0], zbuf_.size());
+            }
+
+            /*! n bytes were read into in_buffer() */
+            void in_filled(size_t const n)
+            {
+                zin_.next_in  = &zbuf_[0];
+                zin_.avail_in = n;
+            }
+
+            /*! true if some compressed input is left to inflate */
+            bool in_pending() const { return (zin_init_ && zin_.avail_in > 0); }
+
+            /*! inflates pending input into ptr, @return bytes produced */
+            size_t inflate_some(void* const ptr, size_t const size)
+            {
+                zin_.next_out  = static_cast<Bytef*>(ptr);
+                zin_.avail_out = size;
+
+                int const err(inflate(&zin_, Z_SYNC_FLUSH));
+                if (Z_OK != err && Z_BUF_ERROR != err)
+                {
+                    gu_throw_error(EPROTO) << "inflate() failed: " << err;
+                }
+
+                return (size - zin_.avail_out);
+            }
+
+            /*! accounts bytes received with asynchronous reads */
+            void count_recv(size_t const n) { raw_recv_ += n; }
+
+        private:
+
+            // iovec limit for a single write, asio does not pass more than
+            // 64 buffers to writev() anyways
+            static size_t const MAX_IOV        = 64;
+            // pieces per trx message: header + at most 4 write set parts
+            static size_t const MAX_TRX_PIECES = 5;
+            static size_t const MAX_HDRS_SIZE  = 1 << 16;
+
+            // Piece of the write: either external memory (ptr_ != NULL) or
+            // offset into iov_hdrs_
+            struct IOPiece
+            {
+                const void* ptr_;
+                size_t      off_;
+                size_t      size_;
+            };
+
+            void queue_local(const void* const ptr, size_t const size)
+            {
+                size_t const off(iov_hdrs_.size());
+                const gu::byte_t* const b(static_cast<const gu::byte_t*>(ptr));
+                iov_hdrs_.insert(iov_hdrs_.end(), b, b + size);
+
+                if (!iov_.empty() && 0 == iov_.back().ptr_ &&
+                    iov_.back().off_ + iov_.back().size_ == off)
                 {
-                    payload_size = 0;
+                    iov_.back().size_ += size; // merge with previous header
                 }
                 else
+                {
+                    IOPiece const p = { 0, off, size };
+                    iov_.push_back(p);
+                }
+            }
+
+            void queue_trx(const gcache::GCache::Buffer& buffer)
+            {
+                const bool rolled_back(buffer.seqno_d() == -1);
+
+                galera::WriteSetIn ws;
+                galera::WriteSetIn::GatherVector out;
+                size_t payload_size(0);
+
+                const gu::byte_t* const begin
+                    (static_cast<const gu::byte_t*>(buffer.ptr()));
+                const gu::byte_t* const end(begin + buffer.size());
+
+                if (gu_likely(!rolled_back))
                 {
                     if (keep_keys_ || version_ < WS_NG_VERSION)
                     {
+                        gu::Buf const tmp = { buffer.ptr(), buffer.size() };
+                        out->push_back(tmp);
                         payload_size = buffer.size();
-                        const void* const ptr(buffer.ptr());
-                        cbs[1] = asio::const_buffer(ptr, payload_size);
-                        cbs[2] = asio::const_buffer(ptr, 0);
                     }
                     else
                     {
                         gu::Buf tmp = { buffer.ptr(), buffer.size() };
                         ws.read_buf (tmp, 0);
-
-                        WriteSetIn::GatherVector out;
                         payload_size = ws.gather (out, false, false);
-                        assert (2 == out->size());
-                        cbs[1] = asio::const_buffer(out[0].ptr, out[0].size);
-                        cbs[2] = asio::const_buffer(out[1].ptr, out[1].size);
                     }
                 }
 
+                assert(out->size() + 1 <= MAX_TRX_PIECES);
+
                 size_t const trx_meta_size(
                     8 /* serial_size(buffer.seqno_g()) */ +
                     8 /* serial_size(buffer.seqno_d()) */
@@ -457,148 +811,179 @@ namespace galera
 
                 Trx trx_msg(version_, trx_meta_size + payload_size);
 
-                gu::Buffer buf(trx_msg.serial_size() + trx_meta_size);
-                size_t  offset(trx_msg.serialize(&buf[0], buf.size(), 0));
-
+                gu::byte_t hdr[64];
+                assert(trx_msg.serial_size() + trx_meta_size <= sizeof(hdr));
+                size_t offset(trx_msg.serialize(hdr, sizeof(hdr), 0));
                 offset = gu::serialize8(buffer.seqno_g(),
-                                        &buf[0], buf.size(), offset);
+                                        hdr, sizeof(hdr), offset);
                 offset = gu::serialize8(buffer.seqno_d(),
-                                        &buf[0], buf.size(), offset);
-                cbs[0] = asio::const_buffer(&buf[0], buf.size());
+                                        hdr, sizeof(hdr), offset);
+                queue_local(hdr, offset);
 
-                if (gu_likely(payload_size))
+                for (size_t i(0); i < out->size(); ++i)
                 {
-                    sent = asio::write(socket, cbs);
-                }
-                else
-                {
-                    sent = asio::write(socket, asio::buffer(cbs[0]));
+                    const gu::byte_t* const ptr
+                        (static_cast<const gu::byte_t*>(out[i].ptr));
+                    size_t const size(out[i].size);
+
+                    if (0 == size) continue;
+
+                    if (ptr >= begin && ptr + size <= end)
+                    {
+                        IOPiece const p = { ptr, 0, size };
+                        iov_.push_back(p);
+                    }
+                    else
+                    {
+                        // write set header copy owned by ws
+                        queue_local(ptr, size);
+                    }
                 }
 
-                log_debug << "sent " << sent << " bytes";
+                raw_sent_ += offset + (rolled_back ? 0 : buffer.size());
             }
 
-
             template <class ST>
-            galera::TrxHandle*
-            recv_trx(ST& socket)
+            void flush_trxs(ST& socket)
             {
-                Message    msg(version_);
-                gu::Buffer buf(msg.serial_size());
-                size_t n(asio::read(socket, asio::buffer(&buf[0], buf.size())));
+                if (iov_.empty()) return;
 
-                if (n != buf.size())
+                std::vector<asio::const_buffer> cbs;
+                cbs.reserve(iov_.size());
+
+                for (size_t i(0); i < iov_.size(); ++i)
                 {
-                    gu_throw_error(EPROTO) << "error receiving trx header";
+                    const IOPiece& p(iov_[i]);
+                    cbs.push_back(asio::const_buffer(
+                                      p.ptr_ ? p.ptr_ : &iov_hdrs_[p.off_],
+                                      p.size_));
                 }
 
-                (void)msg.unserialize(&buf[0], buf.size(), 0);
+                size_t const sent(write(socket, cbs));
 
-                log_debug << "received header: " << n << " bytes, type "
-                          << msg.type() << " len " << msg.len();
+                log_debug << "sent " << sent << " bytes in " << cbs.size()
+                          << " buffers";
 
-                switch (msg.type())
-                {
-                case Message::T_TRX:
-                {
-                    // TODO: ideally we want to make seqno_g and cert verdict
-                    // be a part of msg object above, so that we can skip this
-                    // read. The overhead is tiny given that vast majority of
-                    // messages will be trx writesets.
-                    wsrep_seqno_t seqno_g, seqno_d;
+                iov_.clear();
+                iov_hdrs_.clear();
+            }
 
-                    buf.resize(sizeof(seqno_g) + sizeof(seqno_d));
+            // size of compressed data chunks written to and read from socket
+            static size_t const ZBUF_SIZE = 1 << 17;
 
-                    n = asio::read(socket, asio::buffer(&buf[0], buf.size()));
-                    if (n != buf.size())
+            // writes buffers, deflating them if compression is on,
+            // returns the number of (uncompressed) bytes written
+            template <class ST>
+            size_t write(ST& socket, const std::vector<asio::const_buffer>& cbs)
+            {
+                if (!compress_)
+                {
+                    size_t const n(asio::write(socket, cbs));
+                    real_sent_ += n;
+                    return n;
+                }
+
+                if (!zout_init_)
+                {
+                    if (Z_OK != deflateInit(&zout_, Z_BEST_SPEED))
                     {
-                        gu_throw_error(EPROTO) << "error reading trx meta data";
+                        gu_throw_error(ENOMEM) << "deflateInit() failed";
                     }
+                    zout_init_ = true;
+                    zbuf_.resize(ZBUF_SIZE);
+                }
+
+                size_t total(0);
+                size_t out(0);
 
-                    size_t offset(gu::unserialize8(&buf[0], buf.size(), 0,
-                                                   seqno_g));
-                    offset = gu::unserialize8(&buf[0], buf.size(), offset,
-                                              seqno_d);
+                for (size_t i(0); i < cbs.size(); ++i)
+                {
+                    size_t const size(asio::buffer_size(cbs[i]));
+                    int const flush(i + 1 == cbs.size() ?
+                                    Z_SYNC_FLUSH : Z_NO_FLUSH);
 
-                    galera::TrxHandle* trx(galera::TrxHandle::New(trx_pool_));
+                    zout_.next_in  = const_cast<Bytef*>(
+                        asio::buffer_cast<const Bytef*>(cbs[i]));
+                    zout_.avail_in = size;
 
-                    if (seqno_d == WSREP_SEQNO_UNDEFINED)
+                    do
                     {
-                        if (offset != msg.len())
+                        if (out == zbuf_.size())
                         {
-                            gu_throw_error(EINVAL)
-                                << "message size " << msg.len()
-                                << " does not match expected size " << offset;
+                            real_sent_ += asio::write(
+                                socket, asio::buffer(&zbuf_[0], out));
+                            out = 0;
                         }
-                    }
-                    else
-                    {
-                        MappedBuffer& wbuf(trx->write_set_collection());
-                        size_t const wsize(msg.len() - offset);
-                        wbuf.resize(wsize);
 
-                        n = asio::read(socket,
-                                       asio::buffer(&wbuf[0], wbuf.size()));
+                        zout_.next_out  = &zbuf_[out];
+                        zout_.avail_out = zbuf_.size() - out;
 
-                        if (gu_unlikely(n != wbuf.size()))
+                        int const err(deflate(&zout_, flush));
+                        if (Z_OK != err && Z_BUF_ERROR != err)
                         {
-                            gu_throw_error(EPROTO)
-                                << "error reading write set data";
+                            gu_throw_error(EPROTO) << "deflate() failed: "
+                                                   << err;
                         }
 
-                        trx->unserialize(&wbuf[0], wbuf.size(), 0);
+                        out = zbuf_.size() - zout_.avail_out;
                     }
+                    while (0 == zout_.avail_out);
 
-                    if (seqno_d == WSREP_SEQNO_UNDEFINED ||
-                        trx->version() < 3)
-                    {
-                        trx->set_received(0, -1, seqno_g);
-                        trx->set_depends_seqno(seqno_d);
-                    }
-                    else
-                    {
-                        trx->set_received_from_ws();
-                        assert(trx->global_seqno() == seqno_g);
-                        assert(trx->depends_seqno() >= seqno_d);
-                    }
-                    trx->mark_certified();
+                    total += size;
+                }
 
-                    log_debug << "received trx body: " << *trx;
-                    return trx;
+                if (out > 0)
+                {
+                    real_sent_ += asio::write(socket,
+                                              asio::buffer(&zbuf_[0], out));
                 }
-                case Message::T_CTRL:
-                    switch (msg.ctrl())
+
+                return total;
+            }
+
+            // reads exactly size bytes, inflating them if compression is on
+            template <class ST>
+            size_t read(ST& socket, void* const ptr, size_t const size)
+            {
+                if (!compress_)
+                {
+                    size_t const n(asio::read(socket, asio::buffer(ptr, size)));
+                    raw_recv_ += n;
+                    return n;
+                }
+
+                gu::byte_t* const dst(static_cast<gu::byte_t*>(ptr));
+                size_t done(0);
+
+                while (done < size)
+                {
+                    if (!in_pending())
                     {
-                    case Ctrl::C_EOF:
-                        return 0;
-                    default:
-                        if (msg.ctrl() >= 0)
-                        {
-                            gu_throw_error(EPROTO)
-                                << "unexpected ctrl code: " << msg.ctrl();
-                        }
-                        else
-                        {
-                            gu_throw_error(-msg.ctrl()) <<"peer reported error";
-                        }
+                        in_filled(socket.read_some(in_buffer()));
                     }
-                default:
-                    gu_throw_error(EPROTO) << "unexpected message type: "
-                                           << msg.type();
+
+                    done += inflate_some(dst + done, size - done);
                 }
 
-                gu_throw_fatal; throw;
-                return 0; // keep compiler happy
+                raw_recv_ += size;
+                return size;
             }
 
-        private:
-
             TrxHandle::SlavePool& trx_pool_;
 
+            std::vector<IOPiece> iov_;
+            gu::Buffer           iov_hdrs_;
+            z_stream             zout_;
+            z_stream             zin_;
+            gu::Buffer           zbuf_; // compressed data
             uint64_t raw_sent_;
             uint64_t real_sent_;
+            uint64_t raw_recv_;
             int      version_;
             bool     keep_keys_;
+            bool     compress_;
+            bool     zout_init_;
+            bool     zin_init_;
         };
     }
 }
@@ -11,69 +11,88 @@ namespace galera
 {
     class TrxHandle;
 
+    /*!
+     * Version 3 cert index entry. Exclusive reference is kept as a trx
+     * pointer, since conflict rules need its source and isolation mode.
+     * Shared references are only ever depended upon, so the entry keeps
+     * just the latest seqno that referenced the key as shared. That seqno
+     * is not unreferenced trx by trx on purge, instead stale shared
+     * references are dropped in bulk by unref_shared().
+     */
     class KeyEntryNG
     {
     public:
         KeyEntryNG(const KeySet::KeyPart& key)
-            : refs_(), key_(key)
-        {
-            std::fill(&refs_[0],
-                      &refs_[KeySet::Key::P_LAST],
-                      reinterpret_cast<TrxHandle*>(NULL));
-        }
+            : ref_(NULL), shared_seqno_(WSREP_SEQNO_UNDEFINED), key_(key)
+        {}
 
         KeyEntryNG(const KeyEntryNG& other)
-        : refs_(), key_(other.key_)
-        {
-            std::copy(&other.refs_[0],
-                      &other.refs_[KeySet::Key::P_LAST],
-                      &refs_[0]);
-        }
+            : ref_(other.ref_), shared_seqno_(other.shared_seqno_),
+              key_(other.key_)
+        {}
 
         const KeySet::KeyPart& key() const { return key_; }
 
         void ref(KeySet::Key::Prefix p, const KeySet::KeyPart& k,
                  TrxHandle* trx)
         {
-            assert(0 == refs_[p] ||
-                   refs_[p]->global_seqno() <= trx->global_seqno());
+            if (KeySet::Key::P_EXCLUSIVE == p)
+            {
+                assert(0 == ref_ ||
+                       ref_->global_seqno() <= trx->global_seqno());
+
+                ref_ = trx;
+            }
+            else
+            {
+                assert(shared_seqno_ <= trx->global_seqno());
+
+                shared_seqno_ = trx->global_seqno();
+            }
 
-            refs_[p] = trx;
             key_ = k;
         }
 
-        void unref(KeySet::Key::Prefix p, TrxHandle* trx)
+        /*! drops exclusive reference of trx */
+        void unref(TrxHandle* trx)
         {
-            assert(refs_[p] != NULL);
+            assert(ref_ != NULL);
 
-            if (refs_[p] == trx)
+            if (ref_ == trx)
             {
-                refs_[p] = NULL;
+                ref_ = NULL;
             }
             else
             {
-                assert(refs_[p]->global_seqno() > trx->global_seqno());
+                assert(ref_->global_seqno() > trx->global_seqno());
                 assert(0);
             }
         }
 
-        bool referenced() const
+        /*! drops shared reference if it is not above seqno */
+        void unref_shared(wsrep_seqno_t const seqno)
         {
-            bool ret(refs_[0] != NULL);
-
-            for (int i(1); false == ret && i <= KeySet::Key::P_LAST; ++i)
-            {
-                ret = (refs_[i] != NULL);
-            }
+            if (shared_seqno_ <= seqno) shared_seqno_ = WSREP_SEQNO_UNDEFINED;
+        }
 
-            return ret;
+        /*! drops all references, for entries moved out of the index */
+        void unref_all()
+        {
+            ref_          = NULL;
+            shared_seqno_ = WSREP_SEQNO_UNDEFINED;
         }
 
-        const TrxHandle* ref_trx(KeySet::Key::Prefix p) const
+        bool referenced() const
         {
-            return refs_[p];
+            return (ref_ != NULL || shared_seqno_ != WSREP_SEQNO_UNDEFINED);
         }
 
+        /*! @return trx holding exclusive reference */
+        const TrxHandle* ref_trx() const { return ref_; }
+
+        /*! @return latest seqno holding shared reference */
+        wsrep_seqno_t ref_shared_seqno() const { return shared_seqno_; }
+
         size_t size() const
         {
             return sizeof(*this);
@@ -82,8 +101,9 @@ namespace galera
         void swap(KeyEntryNG& other) throw()
         {
             using std::swap;
-            gu::swap_array(refs_, other.refs_);
-            swap(key_,  other.key_);
+            swap(ref_,          other.ref_);
+            swap(shared_seqno_, other.shared_seqno_);
+            swap(key_,          other.key_);
         }
 
         KeyEntryNG& operator=(KeyEntryNG ke)
@@ -99,13 +119,9 @@ namespace galera
 
     private:
 
-        TrxHandle*      refs_[KeySet::Key::P_LAST + 1];
+        TrxHandle*      ref_;
+        wsrep_seqno_t   shared_seqno_;
         KeySet::KeyPart key_;
-
-#ifndef NDEBUG
-        void assert_ref(KeySet::Key::Prefix, TrxHandle*) const;
-        void assert_unref(KeySet::Key::Prefix, TrxHandle*) const;
-#endif /* NDEBUG */
     };
 
     inline void swap(KeyEntryNG& a, KeyEntryNG& b) { a.swap(b); }
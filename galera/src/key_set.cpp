@@ -283,37 +283,32 @@ KeySetOut::append (const KeyData& kd)
     int i(0);
 
 #ifdef CHECK_PREVIOUS_KEY
-    /* find common ancestor with the previous key */
-    for (;
-         i < kd.parts_num &&
-             size_t(i + 1) < prev_.size() &&
-             prev_[i + 1].match(kd.parts[i].ptr, kd.parts[i].len);
-         ++i)
+    /* find the remembered key with the longest common ancestor */
+    int s(0);
+    for (int k(0); k < PREV_KEYS; ++k)
     {
-#if 0
-        log_info << "prev[" << (i+1) << "]\n"
-                 << prev_[i+1]
-                 << "\nmatches\n"
-                 << gu::Hexdump(kd.parts[i].ptr, kd.parts[i].len, true);
-#endif /* 0 */
+        int const m(common_prefix(prev_[k], kd));
+        if (m > i) { i = m; s = k; }
     }
-//    log_info << "matched " << i << " parts";
+//    log_info << "matched " << i << " parts of key " << s;
+
+    KeyPartVector& prev(prev_[s]);
 
     /* if we have a fully matched key OR common ancestor is exclusive, return */
     if (i > 0)
     {
-        assert (size_t(i) < prev_.size());
+        assert (size_t(i) < prev.size());
 
-        if (prev_[i].exclusive())
+        if (prev[i].exclusive())
         {
-            assert (prev_.size() == (i + 1U)); // only leaf can be exclusive.
-//           log_info << "Returning after matching exclusive key:\n"<< prev_[i];
+            assert (prev.size() == (i + 1U)); // only leaf can be exclusive.
+//           log_info << "Returning after matching exclusive key:\n"<< prev[i];
             return 0;
         }
 
         if (kd.parts_num == i) /* leaf */
         {
-            assert (prev_[i].shared());
+            assert (prev[i].shared());
             if (kd.shared())
             {
 //                log_info << "Returning after matching all " << i << " parts";
@@ -325,11 +320,11 @@ KeySetOut::append (const KeyData& kd)
     }
 
     int const anc(i);
-    const KeyPart* parent(&prev_[anc]);
+    const KeyPart* parent(&prev[anc]);
 
 //    log_info << "Common ancestor: " << anc << ' ' << *parent;
 #else
-    KeyPart tmp(prev_[0]);
+    KeyPart tmp(prev_[0][0]);
     const KeyPart* const parent(&tmp);
 #endif /* CHECK_PREVIOUS_KEY */
 
@@ -379,16 +374,40 @@ KeySetOut::append (const KeyData& kd)
     assert (anc + j == kd.parts_num);
 
 #ifdef CHECK_PREVIOUS_KEY
-    /* copy new parts to prev_ */
-    prev_().resize(1 + kd.parts_num);
-    std::copy(new_().begin(), new_().begin() + j, prev_().begin() + anc + 1);
+    {
+        /* A key that differs from the matched one only in the leaf or that
+         * extends it replaces it. Otherwise this is a new branch: keep the
+         * matched key for its siblings and remember this one in place of
+         * the oldest other key. */
+        int d(s);
+
+        if ((0 == anc || anc + 1 < kd.parts_num) &&
+            size_t(anc + 1) < prev.size())
+        {
+            d = prev_next_;
+            if (d == s) d = (d + 1) % PREV_KEYS;
+            prev_next_ = (d + 1) % PREV_KEYS;
+        }
+
+        KeyPartVector& dst(prev_[d]);
 
-    /* acquire key part value if it is volatile */
-    if (kd.copy)
-        for (int k(anc + 1); size_t(k) < prev_.size(); ++k)
+        /* copy new parts to dst, preceded by the common ancestors */
+        dst().resize(1 + kd.parts_num);
+
+        if (d != s)
         {
-            prev_[k].acquire();
+            for (int k(1); k <= anc; ++k) dst[k].copy_from(prev[k]);
         }
+
+        std::copy(new_().begin(), new_().begin() + j, dst().begin() + anc + 1);
+
+        /* acquire key part value if it is volatile */
+        if (kd.copy)
+            for (int k(anc + 1); size_t(k) < dst.size(); ++k)
+            {
+                dst[k].acquire();
+            }
+    }
 #endif /* CHECK_PREVIOUS_KEY */
 
 out:
@@ -151,15 +151,9 @@ public:
             assert (NULL != this->data_);
             assert (NULL != kp.data_);
 
-            bool ret(true); // collision by default
-
-#if GU_WORDSIZE == 64
-            const uint64_t* lhs(reinterpret_cast<const uint64_t*>(data_));
-            const uint64_t* rhs(reinterpret_cast<const uint64_t*>(kp.data_));
-#else
-            const uint32_t* lhs(reinterpret_cast<const uint32_t*>(data_));
-            const uint32_t* rhs(reinterpret_cast<const uint32_t*>(kp.data_));
-#endif /* WORDSIZE */
+            /* Words are XORed together and the result tested once, so that
+             * a probe costs no more branches than a version switch. */
+            uint64_t diff(0);
 
             switch (std::min(version(), kp.version()))
             {
@@ -168,25 +162,15 @@ public:
                 throw_match_empty_key(version(), kp.version());
             case FLAT16:
             case FLAT16A:
-#if GU_WORDSIZE == 64
-                ret = (lhs[1] == rhs[1]);
-#else
-                ret = (lhs[2] == rhs[2] && lhs[3] == rhs[3]);
-#endif /* WORDSIZE */
+                diff = load_word(data_ + 8) ^ load_word(kp.data_ + 8);
             case FLAT8:
             case FLAT8A:
                 /* shift is to clear up the header */
-#if GU_WORDSIZE == 64
-                ret = ret && ((gtoh64(lhs[0]) >> HEADER_BITS) ==
-                              (gtoh64(rhs[0]) >> HEADER_BITS));
-#else
-                ret = ret && (lhs[1] == rhs[1] &&
-                              (gtoh32(lhs[0]) >> HEADER_BITS) ==
-                              (gtoh32(rhs[0]) >> HEADER_BITS));
-#endif /* WORDSIZE */
+                diff |= (gtoh64(load_word(data_) ^ load_word(kp.data_))
+                         >> HEADER_BITS);
             }
 
-            return ret;
+            return (0 == diff);
         }
 
         size_t
@@ -249,6 +233,14 @@ public:
         mutable /* to be able to store const object */
         const gu::byte_t* data_; // it never owns the buffer
 
+        /* key parts are not aligned in the record set buffer */
+        static uint64_t load_word (const gu::byte_t* const ptr)
+        {
+            uint64_t ret;
+            ::memcpy(&ret, ptr, sizeof(ret));
+            return ret;
+        }
+
         static size_t
         base_size (Version const ver,
                    const gu::byte_t* const buf, size_t const size)
@@ -577,6 +569,20 @@ public:
             value_ = tmp; own_ = true;
         }
 
+        /* makes this a copy of k that does not take over ownership of
+         * the value, owned value is duplicated */
+        void
+        copy_from(const KeyPart& k)
+        {
+            release();
+            hash_  = k.hash_;
+            part_  = k.part_;
+            value_ = k.value_;
+            size_  = k.size_;
+            ver_   = k.ver_;
+            if (k.own_) acquire();
+        }
+
         void
         release()
         {
@@ -615,29 +621,36 @@ public:
         added_(),
         prev_ (),
         new_  (),
+        prev_next_(0),
         version_()
     {}
 
     KeySetOut (gu::byte_t*             reserved,
                size_t                  reserved_size,
                const BaseName&         base_name,
-               KeySet::Version const   version)
+               KeySet::Version const   version,
+               gu::RecordSet::CheckType const ct = gu::RecordSet::CHECK_MMH128)
         :
         gu::RecordSetOut<KeySet::KeyPart> (
             reserved,
             reserved_size,
             base_name,
-            check_type      (version),
+            check_type      (version, ct),
             ks_to_rs_version(version)
             ),
         added_(),
         prev_ (),
         new_  (),
+        prev_next_(0),
         version_(version)
     {
         assert (version_ != KeySet::EMPTY);
-        KeyPart zero(version_);
-        prev_().push_back(zero);
+
+        for (int k(0); k < PREV_KEYS; ++k)
+        {
+            KeyPart zero(version_);
+            prev_[k]().push_back(zero);
+        }
     }
 
     ~KeySetOut () {}
@@ -650,19 +663,39 @@ public:
 
 private:
 
+    /* Number of recently appended keys whose parts are remembered to skip
+     * hashing and lookup of the common prefix. Several are needed for
+     * interleaved hierarchies, like rows of a few tables updated in turn. */
+    static int const PREV_KEYS = 4;
+
+    typedef gu::Vector<KeyPart,5> KeyPartVector;
+
+    /* length of the common prefix of kd and prev */
+    static int
+    common_prefix (const KeyPartVector& prev, const KeyData& kd)
+    {
+        int i(0);
+
+        while (i < kd.parts_num && size_t(i + 1) < prev.size() &&
+               prev[i + 1].match(kd.parts[i].ptr, kd.parts[i].len)) ++i;
+
+        return i;
+    }
+
     // depending on version we may pack data differently
     KeyParts              added_;
-    gu::Vector<KeyPart,5> prev_;
-    gu::Vector<KeyPart,5> new_;
+    KeyPartVector         prev_[PREV_KEYS];
+    KeyPartVector         new_;
+    int                   prev_next_; // next prev_ slot to reuse
     KeySet::Version       version_;
 
     static gu::RecordSet::CheckType
-    check_type (KeySet::Version ver)
+    check_type (KeySet::Version ver, gu::RecordSet::CheckType ct)
     {
         switch (ver)
         {
         case KeySet::EMPTY: break; /* Can't create EMPTY KeySetOut */
-        default: return gu::RecordSet::CHECK_MMH128;
+        default: return ct;
         }
 
         KeySet::throw_version(ver);
@@ -64,6 +64,10 @@ void galera::MappedBuffer::reserve(size_t sz)
     {
         // buffer size exceeds in-memory threshold, have to mmap
 
+        // grow geometrically to keep the number of remaps (and copies on
+        // the first one) logarithmic in the final size
+        if (real_buf_size_ > sz / 2) sz = real_buf_size_ * 2;
+
         if (gu_unlikely(std::numeric_limits<size_t>::max() - sz < threshold_))
         {
             sz = std::numeric_limits<size_t>::max();
@@ -92,7 +96,7 @@ void galera::MappedBuffer::reserve(size_t sz)
                 gu_throw_error(errno) << "ftruncate() failed";
             }
             byte_t* tmp(reinterpret_cast<byte_t*>(
-                            mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                            mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_SHARED,
                                  fd_, 0)));
             if (tmp == MAP_FAILED)
             {
@@ -107,6 +111,8 @@ void galera::MappedBuffer::reserve(size_t sz)
         }
         else
         {
+            // mapping is shared, so the contents survive remapping
+            // through the file and need not be copied
             if (munmap(buf_, real_buf_size_) != 0)
             {
                 gu_throw_error(errno) << "munmap() failed";
@@ -116,7 +122,7 @@ void galera::MappedBuffer::reserve(size_t sz)
                 gu_throw_error(errno) << "fruncate() failed";
             }
             byte_t* tmp(reinterpret_cast<byte_t*>(
-                            mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd_, 0)));
+                            mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0)));
             if (tmp == MAP_FAILED)
             {
                 buf_ = 0;
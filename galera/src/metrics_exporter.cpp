@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "metrics_exporter.hpp"
+
+#include <gu_logger.hpp>
+
+#include <algorithm> // std::max()
+#include <cerrno>
+#include <cstdio>    // rename()
+#include <cstdlib>   // strtod()
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+#include <unistd.h>  // unlink()
+
+galera::MetricsExporter::MetricsExporter(Source&                     source,
+                                         const std::string&          file,
+                                         const gu::datetime::Period& interval)
+    :
+    source_  (source),
+    thd_     (),
+    mtx_     (),
+    cond_    (),
+    file_    (file),
+    interval_(std::max(interval.get_nsecs(), gu::datetime::MSec)),
+    failed_  (false),
+    exit_    (false)
+{
+    gu_thread_create(&thd_, NULL, thd_func, this);
+}
+
+galera::MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+void
+galera::MetricsExporter::stop()
+{
+    {
+        gu::Lock lock(mtx_);
+        if (exit_) return;
+        exit_ = true;
+        cond_.signal();
+    }
+
+    gu_thread_join(thd_, NULL);
+}
+
+void
+galera::MetricsExporter::set_file(const std::string& file)
+{
+    gu::Lock lock(mtx_);
+    file_   = file;
+    failed_ = false;
+    cond_.signal();
+}
+
+void
+galera::MetricsExporter::set_interval(const gu::datetime::Period& interval)
+{
+    gu::Lock lock(mtx_);
+    interval_ = std::max(interval.get_nsecs(), gu::datetime::MSec);
+    cond_.signal();
+}
+
+static void
+metric_name(std::ostream& os, const char* name)
+{
+    os << "wsrep_";
+
+    for (; *name != '\0'; ++name)
+    {
+        char const c(*name);
+
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_')
+            os << c;
+        else if (c >= 'A' && c <= 'Z')
+            os << static_cast<char>(c - 'A' + 'a');
+        else
+            os << '_';
+    }
+}
+
+void
+galera::MetricsExporter::format(const struct wsrep_stats_var* stats,
+                                std::ostream&                 os)
+{
+    os.precision(std::numeric_limits<double>::digits10 + 2);
+
+    for (const struct wsrep_stats_var* v(stats); v->name != 0; ++v)
+    {
+        switch (v->type)
+        {
+        case WSREP_VAR_INT64:
+            metric_name(os, v->name);
+            os << ' ' << v->value._int64 << '\n';
+            break;
+        case WSREP_VAR_DOUBLE:
+            metric_name(os, v->name);
+            os << ' ' << v->value._double << '\n';
+            break;
+        case WSREP_VAR_STRING:
+        {
+            const char* const str(v->value._string);
+            if (str == 0 || *str == '\0') break;
+
+            char* end;
+            double const val(strtod(str, &end));
+            if (*end != '\0') break; // not a number
+
+            metric_name(os, v->name);
+            os << ' ' << val << '\n';
+            break;
+        }
+        }
+    }
+}
+
+bool
+galera::MetricsExporter::write(const std::string& file, bool const quiet)
+{
+    const struct wsrep_stats_var* const stats(source_.stats_get());
+
+    if (stats == 0) return true; // provider destroyed, nothing to report
+
+    std::string const tmp(file + ".tmp");
+    bool ok;
+
+    {
+        std::ofstream os(tmp.c_str(), std::ios::out | std::ios::trunc);
+        format(stats, os);
+        os.close();
+        ok = !os.fail();
+    }
+
+    source_.stats_free(const_cast<struct wsrep_stats_var*>(stats));
+
+    if (ok && ::rename(tmp.c_str(), file.c_str()) == 0) return true;
+
+    int const err(errno);
+
+    if (!quiet)
+    {
+        log_warn << "Failed to write metrics to '" << file << "': "
+                 << err << " (" << ::strerror(err) << ')';
+    }
+
+    ::unlink(tmp.c_str());
+
+    return false;
+}
+
+void*
+galera::MetricsExporter::thd_func(void* arg)
+{
+    MetricsExporter* const me(static_cast<MetricsExporter*>(arg));
+
+    for (;;)
+    {
+        std::string file;
+        bool        quiet;
+
+        {
+            gu::Lock lock(me->mtx_);
+
+            if (me->exit_) break;
+
+            if (me->file_.empty())
+            {
+                lock.wait(me->cond_);
+                continue;
+            }
+
+            file  = me->file_;
+            quiet = me->failed_;
+        }
+
+        bool const ok(me->write(file, quiet));
+
+        gu::Lock lock(me->mtx_);
+
+        if (me->file_ == file) me->failed_ = !ok;
+
+        if (me->exit_) break;
+
+        gu::datetime::Date const until(gu::datetime::Date::calendar()
+                                       + me->interval_);
+        try { lock.wait(me->cond_, until); }
+        catch (gu::Exception& e)
+        {
+            if (e.get_errno() != ETIMEDOUT) throw;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#ifndef GALERA_METRICS_EXPORTER_HPP
+#define GALERA_METRICS_EXPORTER_HPP
+
+#include "wsrep_api.h"
+
+#include <gu_lock.hpp> // gu::Mutex and gu::Cond
+#include <gu_datetime.hpp>
+#include <gu_threads.h>
+
+#include <ostream>
+#include <string>
+
+namespace galera
+{
+    /*!
+     * Periodically dumps provider status variables into a file in
+     * Prometheus text exposition format, to be picked up by a textfile
+     * collector or any other exporter without going through the DBMS.
+     * The file is replaced atomically, so readers never see partial output.
+     */
+    class MetricsExporter
+    {
+    public:
+
+        /*! Interface for the status variables source */
+        class Source
+        {
+        public:
+            virtual ~Source() {}
+
+            virtual const struct wsrep_stats_var* stats_get() const = 0;
+            virtual void stats_free(struct wsrep_stats_var*) = 0;
+        };
+
+        /*! @param file     path to write metrics to, empty - disabled
+         *  @param interval time between writes */
+        MetricsExporter (Source&                     source,
+                         const std::string&          file,
+                         const gu::datetime::Period& interval);
+
+        ~MetricsExporter ();
+
+        /*! stops the writer thread, waits for the ongoing write to finish.
+         *  Must be called before the source is torn down. */
+        void stop ();
+
+        void set_file (const std::string& file);
+
+        void set_interval (const gu::datetime::Period& interval);
+
+        /*! Writes numeric variables as wsrep_<name> metrics, string
+         *  variables are exported only if they hold a number. */
+        static void format (const struct wsrep_stats_var* stats,
+                            std::ostream&                 os);
+
+    private:
+
+        Source&     source_;
+        gu_thread_t thd_;
+        gu::Mutex   mtx_;
+        gu::Cond    cond_;
+        std::string file_;
+        long long   interval_; // nanoseconds
+        bool        failed_;   // last write failed, don't flood the log
+        bool        exit_;
+
+        /* returns true on success, quiet suppresses failure warning */
+        bool write (const std::string& file, bool quiet);
+
+        static void* thd_func (void*);
+
+        MetricsExporter (const MetricsExporter&);
+        MetricsExporter& operator= (const MetricsExporter&);
+    };
+}
+
+#endif /* GALERA_METRICS_EXPORTER_HPP */
@@ -7,8 +7,11 @@
 
 #include "trx_handle.hpp"
 #include <gu_lock.hpp> // for gu::Mutex and gu::Cond
+#include <gu_atomic.hpp>
 #include <gu_limits.h>
+#include <gu_debug_sync.hpp>
 
+#include <algorithm> // std::fill()
 #include <vector>
 
 namespace galera
@@ -41,28 +44,42 @@ namespace galera
             void operator=(const Process&);
         };
 
-        static const ssize_t process_size_ = (1ULL << 16);
-        static const size_t  process_mask_ = process_size_ - 1;
-
     public:
 
-        Monitor()
+        static const ssize_t DEFAULT_SIZE = (1ULL << 16);
+
+        /*! @param spin number of times enter() polls for monitor progress
+         *              before blocking, 0 to block right away
+         *  @param size max distance from the last left seqno to the ones
+         *              that can enter, rounded up to a power of 2 */
+        explicit
+        Monitor(int spin = 0, ssize_t size = DEFAULT_SIZE)
             :
             mutex_(),
             cond_(),
             last_entered_(-1),
             last_left_(-1),
             drain_seqno_(GU_LLONG_MAX),
-            process_(new Process[process_size_]),
+            process_size_(round_size(size)),
+            process_mask_(process_size_ - 1),
+            process_(new Process*[process_size_]),
+            chunks_(),
+            spin_(spin),
+            leaves_(0),
             entered_(0),
             oooe_(0),
             oool_(0),
             win_size_(0)
-        { }
+        {
+            Process* const chunk(new Process[process_size_]);
+            chunks_.push_back(chunk);
+            for (ssize_t i(0); i < process_size_; ++i) process_[i] = &chunk[i];
+        }
 
         ~Monitor()
         {
             delete[] process_;
+            for (size_t i(0); i < chunks_.size(); ++i) delete[] chunks_[i];
             if (entered_ > 0)
             {
                 log_info << "mon: entered " << entered_
@@ -92,45 +109,57 @@ namespace galera
             }
             if (seqno != -1)
             {
-                const size_t idx(indexof(seqno));
-                process_[idx].wait_cond_.broadcast();
+                process(seqno).wait_cond_.broadcast();
             }
         }
 
         void enter(C& obj)
         {
             const wsrep_seqno_t obj_seqno(obj.seqno());
-            const size_t        idx(indexof(obj_seqno));
             gu::Lock            lock(mutex_);
 
             assert(obj_seqno > last_left_);
 
             pre_enter(obj, lock);
 
-            if (gu_likely(process_[idx].state_ != Process::S_CANCELED))
+            /* the slot stays the same for the seqno within the window even
+             * if the window grows while we wait */
+            Process& p(process(obj_seqno));
+
+            if (gu_likely(p.state_ != Process::S_CANCELED))
             {
-                assert(process_[idx].state_ == Process::S_IDLE);
+                assert(p.state_ == Process::S_IDLE);
 
-                process_[idx].state_ = Process::S_WAITING;
-                process_[idx].obj_   = &obj;
+                p.state_ = Process::S_WAITING;
+                p.obj_   = &obj;
 
 #ifdef GU_DBUG_ON
-                obj.debug_sync(mutex_);
+                if (GU_DBUG_SYNC_ENABLED()) obj.debug_sync(mutex_);
 #endif // GU_DBUG_ON
+                bool spin(spin_ > 0);
+
                 while (may_enter(obj) == false &&
-                       process_[idx].state_ == Process::S_WAITING)
+                       p.state_ == Process::S_WAITING)
                 {
+                    if (spin)
+                    {
+                        // spin only once, then re-check and block
+                        spin_wait(obj);
+                        spin = false;
+                        continue;
+                    }
+
                     obj.unlock();
-                    lock.wait(process_[idx].cond_);
+                    lock.wait(p.cond_);
                     obj.lock();
                 }
 
-                if (process_[idx].state_ != Process::S_CANCELED)
+                if (p.state_ != Process::S_CANCELED)
                 {
-                    assert(process_[idx].state_ == Process::S_WAITING ||
-                           process_[idx].state_ == Process::S_APPLYING);
+                    assert(p.state_ == Process::S_WAITING ||
+                           p.state_ == Process::S_APPLYING);
 
-                    process_[idx].state_ = Process::S_APPLYING;
+                    p.state_ = Process::S_APPLYING;
 
                     ++entered_;
                     oooe_     += ((last_left_ + 1) < obj_seqno);
@@ -139,23 +168,20 @@ namespace galera
                 }
             }
 
-            assert(process_[idx].state_ == Process::S_CANCELED);
-            process_[idx].state_ = Process::S_IDLE;
+            assert(p.state_ == Process::S_CANCELED);
+            p.state_ = Process::S_IDLE;
 
             gu_throw_error(EINTR);
         }
 
         void leave(const C& obj)
         {
-#ifndef NDEBUG
-            size_t   idx(indexof(obj.seqno()));
-#endif /* NDEBUG */
             gu::Lock lock(mutex_);
 
-            assert(process_[idx].state_ == Process::S_APPLYING ||
-                   process_[idx].state_ == Process::S_CANCELED);
+            assert(process(obj.seqno()).state_ == Process::S_APPLYING ||
+                   process(obj.seqno()).state_ == Process::S_CANCELED);
 
-            assert(process_[indexof(last_left_)].state_ == Process::S_IDLE);
+            assert(process(last_left_).state_ == Process::S_IDLE);
 
             post_leave(obj, lock);
         }
@@ -163,7 +189,6 @@ namespace galera
         void self_cancel(C& obj)
         {
             wsrep_seqno_t const obj_seqno(obj.seqno());
-            size_t   idx(indexof(obj_seqno));
             gu::Lock lock(mutex_);
 
             assert(obj_seqno > last_left_);
@@ -182,8 +207,10 @@ namespace galera
                 obj.lock();
             }
 
-            assert(process_[idx].state_ == Process::S_IDLE ||
-                   process_[idx].state_ == Process::S_CANCELED);
+            Process& p(process(obj_seqno));
+
+            assert(p.state_ == Process::S_IDLE ||
+                   p.state_ == Process::S_CANCELED);
 
             if (obj_seqno > last_entered_) last_entered_ = obj_seqno;
 
@@ -193,14 +220,12 @@ namespace galera
             }
             else
             {
-                process_[idx].state_ = Process::S_FINISHED;
+                p.state_ = Process::S_FINISHED;
             }
         }
 
         void interrupt(const C& obj)
         {
-
-            size_t   idx (indexof(obj.seqno()));
             gu::Lock lock(mutex_);
 
             while (obj.seqno() - last_left_ >= process_size_)
@@ -209,19 +234,22 @@ namespace galera
                 lock.wait(cond_);
             }
 
-            if ((process_[idx].state_ == Process::S_IDLE &&
-                 obj.seqno()          >  last_left_ ) ||
-                process_[idx].state_ == Process::S_WAITING )
+            Process& p(process(obj.seqno()));
+
+            if ((p.state_      == Process::S_IDLE &&
+                 obj.seqno()   >  last_left_ ) ||
+                p.state_ == Process::S_WAITING )
             {
-                process_[idx].state_ = Process::S_CANCELED;
-                process_[idx].cond_.signal();
+                p.state_ = Process::S_CANCELED;
+                p.cond_.signal();
+                ++leaves_; // stop spinning waiters
                 // since last_left + 1 cannot be <= S_WAITING we're not
                 // modifying a window here. No broadcasting.
             }
             else
             {
                 log_debug << "interrupting " << obj.seqno()
-                          << " state " << process_[idx].state_
+                          << " state " << p.state_
                           << " le " << last_entered_
                           << " ll " << last_left_;
             }
@@ -232,7 +260,100 @@ namespace galera
             gu::Lock lock(mutex_);
             return last_left_;
         }
-        ssize_t       size()        const { return process_size_; }
+        ssize_t       size()        const
+        {
+            gu::Lock lock(mutex_);
+            return process_size_;
+        }
+
+        /*! Grows the window to at least size seqnos, can be called while
+         *  the monitor is in use. Slots of seqnos in the current window are
+         *  kept, so waiters are not disturbed.
+         *  @throws gu::Exception with EINVAL on attempt to shrink */
+        void set_size(ssize_t const size)
+        {
+            ssize_t const new_size(round_size(size));
+
+            gu::Lock lock(mutex_);
+
+            if (new_size <= process_size_)
+            {
+                if (new_size == process_size_) return;
+
+                gu_throw_error(EINVAL) << "Monitor window can't shrink online: "
+                                       << process_size_ << " -> " << new_size;
+            }
+
+            size_t const new_mask(new_size - 1);
+            Process**    index(new Process*[new_size]);
+            Process*     chunk(NULL);
+
+            try
+            {
+                chunk = new Process[new_size - process_size_];
+                chunks_.push_back(chunk);
+            }
+            catch (...)
+            {
+                delete[] chunk;
+                delete[] index;
+                throw;
+            }
+
+            std::fill(index, index + new_size, static_cast<Process*>(0));
+
+            /* old window occupies process_size_ consecutive new slots */
+            for (wsrep_seqno_t s(last_left_ + 1);
+                 s <= last_left_ + process_size_; ++s)
+            {
+                index[s & new_mask] = &process(s);
+            }
+
+            ssize_t n(0);
+            for (ssize_t i(0); i < new_size; ++i)
+            {
+                if (0 == index[i]) index[i] = &chunk[n++];
+            }
+            assert(n == new_size - process_size_);
+
+            delete[] process_;
+            process_      = index;
+            process_size_ = new_size;
+            process_mask_ = new_mask;
+
+            cond_.broadcast(); // wake up those waiting for window space
+        }
+
+        /*! Returns the highest seqno up to which all seqnos following the
+         *  given one are already waiting to enter the monitor. This makes
+         *  a group of ready seqnos that will pass the monitor in a row. */
+        wsrep_seqno_t waiting_upto(wsrep_seqno_t seqno) const
+        {
+            gu::Lock lock(mutex_);
+
+            while (seqno < last_entered_ &&
+                   process(seqno + 1).state_ == Process::S_WAITING)
+            {
+                ++seqno;
+            }
+
+            return seqno;
+        }
+
+        void set_spin(int spin)
+        {
+            gu::Lock lock(mutex_);
+            spin_ = spin;
+        }
+
+        /*! Tells if seqno has left the monitor. This is for C::condition()
+         *  and so must be called with monitor mutex held. */
+        bool has_left(wsrep_seqno_t seqno) const
+        {
+            return (seqno <= last_left_ ||
+                    (seqno <= last_entered_ &&
+                     process(seqno).state_ == Process::S_FINISHED));
+        }
 
         bool would_block (wsrep_seqno_t seqno) const
         {
@@ -240,6 +361,13 @@ namespace galera
                     seqno > drain_seqno_);
         }
 
+        /*! Tells if obj would have to wait if it tried to enter now. */
+        bool would_wait(const C& obj)
+        {
+            gu::Lock lock(mutex_);
+            return (would_block(obj.seqno()) || may_enter(obj) == false);
+        }
+
         void drain(wsrep_seqno_t seqno)
         {
             gu::Lock lock(mutex_);
@@ -263,8 +391,7 @@ namespace galera
             gu::Lock lock(mutex_);
             if (last_left_ < seqno)
             {
-                size_t idx(indexof(seqno));
-                lock.wait(process_[idx].wait_cond_);
+                lock.wait(process(seqno).wait_cond_);
             }
         }
 
@@ -273,8 +400,7 @@ namespace galera
             gu::Lock lock(mutex_);
             if (last_left_ < seqno)
             {
-                size_t idx(indexof(seqno));
-                lock.wait(process_[idx].wait_cond_, wait_until);
+                lock.wait(process(seqno).wait_cond_, wait_until);
             }
         }
 
@@ -303,14 +429,38 @@ namespace galera
 
     private:
 
-        size_t indexof(wsrep_seqno_t seqno)
+        static ssize_t round_size(ssize_t const size)
+        {
+            ssize_t ret(16);
+            while (ret < size) ret <<= 1;
+            return ret;
+        }
+
+        Process& process(wsrep_seqno_t const seqno) const
         {
-            return (seqno & process_mask_);
+            return *process_[seqno & process_mask_];
         }
 
         bool may_enter(const C& obj) const
         {
-            return obj.condition(last_entered_, last_left_);
+            return obj.condition(last_entered_, last_left_, *this);
+        }
+
+        // poll for any leave from the monitor for at most spin_ iterations
+        // with the mutex released. Saves waiters a sleep/wakeup cycle when
+        // the monitor moves fast.
+        void spin_wait(C& obj)
+        {
+            long const leaves(leaves_());
+            int  const spin(spin_);
+
+            obj.unlock();
+            mutex_.unlock();
+
+            for (int i(0); i < spin && leaves_() == leaves; ++i) {}
+
+            mutex_.lock();
+            obj.lock();
         }
 
         // wait until it is possible to grab slot in monitor,
@@ -335,7 +485,7 @@ namespace galera
         {
             for (wsrep_seqno_t i = last_left_ + 1; i <= last_entered_; ++i)
             {
-                Process& a(process_[indexof(i)]);
+                Process& a(process(i));
 
                 if (Process::S_FINISHED == a.state_)
                 {
@@ -355,7 +505,7 @@ namespace galera
         {
             for (wsrep_seqno_t i = last_left_ + 1; i <= last_entered_; ++i)
             {
-                Process& a(process_[indexof(i)]);
+                Process& a(process(i));
                 if (a.state_           == Process::S_WAITING &&
                     may_enter(*a.obj_) == true)
                 {
@@ -373,13 +523,15 @@ namespace galera
         void post_leave(const C& obj, gu::Lock& lock)
         {
             const wsrep_seqno_t obj_seqno(obj.seqno());
-            const size_t idx(indexof(obj_seqno));
+            Process&            p(process(obj_seqno));
+
+            ++leaves_;
 
             if (last_left_ + 1 == obj_seqno) // we're shrinking window
             {
-                process_[idx].state_ = Process::S_IDLE;
-                last_left_           = obj_seqno;
-                process_[idx].wait_cond_.broadcast();
+                p.state_   = Process::S_IDLE;
+                last_left_ = obj_seqno;
+                p.wait_cond_.broadcast();
 
                 update_last_left();
                 oool_ += (last_left_ > obj_seqno);
@@ -389,16 +541,19 @@ namespace galera
             }
             else
             {
-                process_[idx].state_ = Process::S_FINISHED;
+                p.state_ = Process::S_FINISHED;
+                // waiters that depend on specific seqnos rather than on
+                // last_left_ may be able to enter now
+                wake_up_next();
             }
 
-            process_[idx].obj_ = 0;
+            p.obj_ = 0;
 
             assert((last_left_ >= obj_seqno &&
-                    process_[idx].state_ == Process::S_IDLE) ||
-                   process_[idx].state_ == Process::S_FINISHED);
+                    p.state_ == Process::S_IDLE) ||
+                   p.state_ == Process::S_FINISHED);
             assert(last_left_ != last_entered_ ||
-                   process_[indexof(last_left_)].state_ == Process::S_IDLE);
+                   process(last_left_).state_ == Process::S_IDLE);
 
             if ((last_left_ >= obj_seqno) ||  // - occupied window shrinked
                 (last_left_ >= drain_seqno_)) // - this is to notify drain that
@@ -419,7 +574,7 @@ namespace galera
                 log_debug << "last left greater than drain seqno";
                 for (wsrep_seqno_t i = drain_seqno_; i <= last_left_; ++i)
                 {
-                    const Process& a(process_[indexof(i)]);
+                    const Process& a(process(i));
                     log_debug << "applier " << i
                               << " in state " << a.state_;
                 }
@@ -436,7 +591,12 @@ namespace galera
         wsrep_seqno_t last_entered_;
         wsrep_seqno_t last_left_;
         wsrep_seqno_t drain_seqno_;
-        Process*      process_;
+        ssize_t       process_size_;
+        size_t        process_mask_;
+        Process**     process_; // slot of seqno s is process_[s & mask]
+        std::vector<Process*> chunks_; // Process storage, added as it grows
+        int           spin_;
+        gu::Atomic<long> leaves_; // leave counter for spinning waiters
         long entered_;  // entered
         long oooe_;     // out of order entered
         long oool_;     // out of order left
@@ -0,0 +1,275 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "preordered_sender.hpp"
+#include "write_set_ng.hpp"
+#include "uuid.hpp"
+
+#include "gu_logger.hpp"
+#include "gu_throw.hpp"
+
+#include <algorithm>
+#include <cstring>  // strerror()
+#include <unistd.h> // usleep()
+
+galera::PreorderedSender::PreorderedSender(GcsI&                    gcs,
+                                           const TrxHandle::Params& params,
+                                           gu::Atomic<long long>&   id,
+                                           int const                batch)
+    :
+    gcs_       (gcs),
+    trx_params_(params),
+    id_        (id),
+    batch_     (std::max(batch, 1)),
+    queue_max_ (batch_ * 4),
+    mtx_       (),
+    cond_      (),
+    space_     (),
+    queue_     (),
+    thd_       (),
+    events_    (0),
+    actions_   (0),
+    error_     (0),
+    closing_   (false),
+    started_   (false)
+{}
+
+galera::PreorderedSender::~PreorderedSender()
+{
+    close();
+
+    if (events_ > actions_)
+    {
+        log_info << "Preordered sender: " << events_ << " events in "
+                 << actions_ << " actions";
+    }
+}
+
+void
+galera::PreorderedSender::submit(Event* const        ev,
+                                 const wsrep_uuid_t& source,
+                                 uint16_t const      ws_flags,
+                                 int const           pa_range)
+{
+    assert(enabled());
+
+    ev->source_   = source;
+    ev->flags_    = ws_flags;
+    ev->pa_range_ = pa_range;
+
+    gu::Lock lock(mtx_);
+
+    while (queue_.size() >= queue_max_ && 0 == error_ && !closing_)
+        lock.wait(space_);
+
+    if (gu_unlikely(error_ != 0 || closing_))
+    {
+        delete ev;
+        gu_throw_error(error_ ? error_ : EBADFD)
+            << "Replication of preordered writeset failed.";
+    }
+
+    if (gu_unlikely(!started_))
+    {
+        int const err(gu_thread_create(&thd_, NULL, run, this));
+
+        if (err)
+        {
+            delete ev;
+            gu_throw_error(err) << "Failed to start preordered sender";
+        }
+
+        started_ = true;
+    }
+
+    queue_.push_back(ev);
+    if (1 == queue_.size()) cond_.signal();
+}
+
+void
+galera::PreorderedSender::flush()
+{
+    gu::Lock lock(mtx_);
+
+    while (!queue_.empty() && 0 == error_) lock.wait(space_);
+}
+
+void
+galera::PreorderedSender::close()
+{
+    {
+        gu::Lock lock(mtx_);
+
+        if (!started_) return;
+
+        closing_ = true;
+        cond_.signal();
+        space_.broadcast();
+    }
+
+    gu_thread_join(thd_, NULL);
+
+    gu::Lock lock(mtx_);
+
+    for (size_t i(0); i < queue_.size(); ++i) delete queue_[i];
+
+    if (!queue_.empty())
+    {
+        log_warn << "Preordered sender: dropped " << queue_.size()
+                 << " unsent events";
+        queue_.clear();
+    }
+
+    /* ready to be started again on reconnect */
+    started_ = false;
+    closing_ = false;
+    error_   = 0;
+}
+
+void
+galera::PreorderedSender::stats_get(long long& events,
+                                    long long& actions) const
+{
+    gu::Lock lock(mtx_);
+
+    events  = events_;
+    actions = actions_;
+}
+
+void*
+galera::PreorderedSender::run(void* const arg)
+{
+    static_cast<PreorderedSender*>(arg)->loop();
+    return NULL;
+}
+
+size_t
+galera::PreorderedSender::batch_size() const
+{
+    /* leave room for headers and possible compression overhead */
+    size_t const max_bytes(trx_params_.max_write_set_size_ / 2);
+    const wsrep_uuid_t& source(queue_.front()->source_);
+    size_t bytes(queue_.front()->size());
+    size_t n(1);
+
+    while (n < batch_ && n < queue_.size() &&
+           queue_[n]->source_ == source &&
+           bytes + queue_[n]->size() <= max_bytes)
+    {
+        bytes += queue_[n]->size();
+        ++n;
+    }
+
+    return n;
+}
+
+void
+galera::PreorderedSender::loop()
+{
+    std::vector<Event*> batch;
+    batch.reserve(batch_);
+
+    gu::Lock lock(mtx_);
+
+    for (;;)
+    {
+        while (queue_.empty() && !closing_) lock.wait(cond_);
+
+        if (queue_.empty() || error_ != 0) break; // closing
+
+        /* events stay in the queue while being sent so that flush() waits
+         * for them too */
+        size_t const n(batch_size());
+        batch.assign(queue_.begin(), queue_.begin() + n);
+
+        mtx_.unlock();
+        int const err(send(batch));
+        mtx_.lock();
+
+        for (size_t i(0); i < n; ++i) delete queue_[i];
+        queue_.erase(queue_.begin(), queue_.begin() + n);
+
+        if (gu_likely(0 == err))
+        {
+            events_  += n;
+            actions_ += 1;
+        }
+        else
+        {
+            log_error << "Failed to send " << n << " preordered events: "
+                      << err << " (" << strerror(err) << ')';
+            error_ = err;
+        }
+
+        space_.broadcast(); // wake up producers and flush() callers
+    }
+}
+
+int
+galera::PreorderedSender::send(const std::vector<Event*>& batch)
+{
+    const TrxHandle::Params& p(trx_params_);
+
+    try
+    {
+        WriteSetOut ws(p.working_dir_, wsrep_trx_id_t(this),
+                       /* key format is not essential since we're not adding
+                        * keys */
+                       KeySet::version(p.key_format_), NULL, 0,
+                       0, WriteSetNG::MAX_VERSION, p.data_set_ver_,
+                       p.data_set_ver_, p.max_write_set_size_,
+                       p.compression_level_, p.check_type_);
+
+        uint16_t flags(0);
+        int      pa_range(batch[0]->pa_range_);
+
+        for (size_t i(0); i < batch.size(); ++i)
+        {
+            const Event& ev(*batch[i]);
+
+            /* events outlive ws, no need to copy */
+            if (!ev.data_.empty())
+                ws.append_data(&ev.data_[0], ev.data_.size(), false);
+
+            flags   |= ev.flags_;
+            pa_range = std::min(pa_range, ev.pa_range_);
+        }
+
+        ws.set_flags(flags);
+
+        wsrep_trx_id_t const trx_id(id_.add_and_fetch(1));
+
+        WriteSetNG::GatherVector actv;
+
+        size_t const actv_size(ws.gather(batch[0]->source_, 0, trx_id, actv));
+
+        ws.set_preordered(pa_range); // also adds CRC
+
+        int rcode;
+        do
+        {
+            rcode = gcs_.sendv(actv, actv_size, GCS_ACT_TORDERED, false);
+        }
+        while (rcode == -EAGAIN && !closing() && (usleep(1000), true));
+
+        return (rcode < 0 ? -rcode : 0);
+    }
+    catch (gu::Exception& e)
+    {
+        log_error << "Failed to build preordered write set: " << e.what();
+        return (e.get_errno() ? e.get_errno() : EINVAL);
+    }
+    catch (std::exception& e)
+    {
+        log_error << "Failed to build preordered write set: " << e.what();
+        return ENOMEM;
+    }
+}
+
+bool
+galera::PreorderedSender::closing() const
+{
+    gu::Lock lock(mtx_);
+    return closing_;
+}
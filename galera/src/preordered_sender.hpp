@@ -0,0 +1,123 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_PREORDERED_SENDER_HPP
+#define GALERA_PREORDERED_SENDER_HPP
+
+#include "galera_gcs.hpp"
+#include "trx_handle.hpp"
+
+#include "gu_atomic.hpp"
+#include "gu_lock.hpp"
+
+#include <deque>
+#include <vector>
+
+namespace galera
+{
+    /*!
+     * Sends preordered write sets in the background, merging consecutive
+     * events from the same source into a single GCS action.
+     *
+     * preordered_commit() only copies the event into the queue and returns,
+     * so the caller can feed the next event while the previous ones are on
+     * the wire. The sender thread takes up to batch_ queued events at a
+     * time and replicates them as one write set. A data set is not split
+     * into records, the applier gets it as one buffer of concatenated
+     * self-delimiting events, so the merged data set looks to it just like
+     * a series of events collected for one handle.
+     *
+     * The whole batch gets one global seqno and one preordered id. A failed
+     * send is reported by the next submit().
+     */
+    class PreorderedSender
+    {
+    public:
+
+        /*! Event data collected by preordered_collect() */
+        class Event
+        {
+        public:
+            Event() : data_(), source_(), flags_(0), pa_range_(0) {}
+
+            void append(const void* ptr, size_t len)
+            {
+                const gu::byte_t* const b(static_cast<const gu::byte_t*>(ptr));
+                data_.insert(data_.end(), b, b + len);
+            }
+
+            size_t size() const { return data_.size(); }
+
+        private:
+
+            friend class PreorderedSender;
+
+            gu::Buffer              data_;
+            wsrep_uuid_t            source_;
+            uint16_t                flags_;
+            int                     pa_range_;
+        };
+
+        /*!
+         * @param batch maximum number of events per action, with less than 2
+         *              the sender is disabled
+         */
+        PreorderedSender(GcsI&                    gcs,
+                         const TrxHandle::Params& trx_params,
+                         gu::Atomic<long long>&   id,
+                         int                      batch);
+
+        ~PreorderedSender();
+
+        bool enabled() const { return batch_ > 1; }
+
+        /*!
+         * Queues event for sending and takes ownership of it. Starts the
+         * sender thread if needed, blocks while the queue is full.
+         *
+         * @throws gu::Exception if sending of some earlier event failed
+         */
+        void submit(Event* ev, const wsrep_uuid_t& source,
+                    uint16_t ws_flags, int pa_range);
+
+        /*! Waits until everything queued so far is sent */
+        void flush();
+
+        /*! Sends what is queued and stops the sender thread. The thread is
+         *  started again by the next submit() */
+        void close();
+
+        void stats_get(long long& events, long long& actions) const;
+
+    private:
+
+        PreorderedSender(const PreorderedSender&);
+        PreorderedSender& operator=(const PreorderedSender&);
+
+        static void* run(void* arg);
+
+        void   loop();
+        size_t batch_size() const; // must be called under mtx_
+        int    send(const std::vector<Event*>& batch); // returns errno
+        bool   closing() const;
+
+        GcsI&                    gcs_;
+        const TrxHandle::Params& trx_params_;
+        gu::Atomic<long long>&   id_;
+        size_t const             batch_;
+        size_t const             queue_max_;
+        gu::Mutex mutable        mtx_;
+        gu::Cond                 cond_;  // sender waits for events
+        gu::Cond                 space_; // producers wait for queue space
+        std::deque<Event*>       queue_; // events stay here until sent
+        gu_thread_t              thd_;
+        long long                events_;
+        long long                actions_;
+        int                      error_;
+        bool                     closing_;
+        bool                     started_;
+    };
+}
+
+#endif // GALERA_PREORDERED_SENDER_HPP
@@ -0,0 +1,148 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "repl_lag.hpp"
+#include "uuid.hpp"
+
+#include <gu_lock.hpp>
+
+#include <cstdlib> // llabs()
+
+/* origin timestamps further off are not calendar time */
+static long long const REPL_LAG_MAX = 3600LL * 1000000000LL; // 1 hour
+
+galera::ReplLag::Source::Source(const wsrep_uuid_t& uuid)
+    :
+    uuid_    (uuid),
+    lag_     (),
+    count_   (0),
+    cur_min_ (0),
+    prev_min_(0),
+    cur_n_   (0),
+    prev_n_  (0),
+    seen_    (0)
+{}
+
+galera::ReplLag::ReplLag(size_t const max_sources)
+    :
+    sources_    (),
+    mtx_        (),
+    max_sources_(max_sources > 0 ? max_sources : 1),
+    records_    (0)
+{}
+
+galera::ReplLag::~ReplLag()
+{
+    for (size_t i(0); i < sources_.size(); ++i) delete sources_[i];
+}
+
+galera::ReplLag::Source*
+galera::ReplLag::find(const wsrep_uuid_t& source) const
+{
+    for (size_t i(0); i < sources_.size(); ++i)
+    {
+        if (sources_[i]->uuid_ == source) return sources_[i];
+    }
+
+    return NULL;
+}
+
+bool
+galera::ReplLag::record(const wsrep_uuid_t& source, long long const origin,
+                        const long long t[LAG_MAX])
+{
+    if (origin <= 0 || t[LAG_ORDERED] <= 0) return false;
+
+    long long const ordered(t[LAG_ORDERED] - origin);
+
+    if (llabs(ordered) > REPL_LAG_MAX) return false;
+
+    gu::Lock lock(mtx_);
+
+    Source* s(find(source));
+
+    if (NULL == s)
+    {
+        if (sources_.size() >= max_sources_)
+        {
+            size_t oldest(0);
+            for (size_t i(1); i < sources_.size(); ++i)
+            {
+                if (sources_[i]->seen_ < sources_[oldest]->seen_) oldest = i;
+            }
+
+            delete sources_[oldest];
+            sources_.erase(sources_.begin() + oldest);
+        }
+
+        s = new Source(source);
+        sources_.push_back(s);
+    }
+
+    s->seen_ = ++records_;
+    ++s->count_;
+
+    if (0 == s->cur_n_ || ordered < s->cur_min_) s->cur_min_ = ordered;
+
+    if (++s->cur_n_ >= WINDOW)
+    {
+        s->prev_min_ = s->cur_min_;
+        s->prev_n_   = s->cur_n_;
+        s->cur_n_    = 0;
+    }
+
+    long long const base(origin + s->min());
+
+    for (int i(0); i < LAG_MAX; ++i)
+    {
+        if (t[i] > 0) s->lag_[i].insert_ns(t[i] - base);
+    }
+
+    return true;
+}
+
+void
+galera::ReplLag::print(std::ostream& os, long long const delay) const
+{
+    gu::Lock lock(mtx_);
+
+    for (size_t i(0); i < sources_.size(); ++i)
+    {
+        const Source& s(*sources_[i]);
+
+        if (i > 0) os << ",";
+
+        os << s.uuid_ << ":" << s.count_ << ":"
+           << (s.min() - delay) * 1.0e-9;
+
+        for (int l(0); l < LAG_MAX; ++l)
+        {
+            const gu::Histogram& h(s.lag_[l]);
+            bool const empty(0 == h.count());
+
+            os << ":" << (empty ? 0 : h.percentile(50.0) + delay) * 1.0e-9
+               << ":" << (empty ? 0 : h.percentile(99.0) + delay) * 1.0e-9;
+        }
+    }
+}
+
+long long
+galera::ReplLag::offset(const wsrep_uuid_t& source, long long const delay) const
+{
+    gu::Lock lock(mtx_);
+
+    const Source* const s(find(source));
+
+    return (s ? s->min() - delay : 0);
+}
+
+void
+galera::ReplLag::clear()
+{
+    gu::Lock lock(mtx_);
+
+    for (size_t i(0); i < sources_.size(); ++i) delete sources_[i];
+
+    sources_.clear();
+}
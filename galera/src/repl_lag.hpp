@@ -0,0 +1,119 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_REPL_LAG_HPP
+#define GALERA_REPL_LAG_HPP
+
+#include "wsrep_api.h"
+
+#include <gu_histogram.hpp>
+#include <gu_mutex.hpp>
+
+#include <algorithm>
+#include <vector>
+#include <ostream>
+
+namespace galera
+{
+    /*!
+     * End-to-end replication lag of remote write sets per source node:
+     * time from the write set timestamp set by the originator to the
+     * moment it was ordered, applied and committed here.
+     *
+     * Origin and local clocks are not assumed to be synchronized. For
+     * every source the minimum observed origin to ordered lag is taken
+     * as clock offset plus the minimum network delay (the minimum delay
+     * filter of NTP), and histograms hold lags relative to it. The one-way
+     * network delay, as estimated by the caller from the link RTT, is
+     * added back in print(), so the reported lag is
+     *
+     *   lag - min(ordered lag) + rtt/2
+     *
+     * and the estimated clock offset is min(ordered lag) - rtt/2.
+     * The minimum is taken over the last two windows of WINDOW write sets,
+     * to follow clock drift and steps.
+     *
+     * Up to max_sources nodes are tracked, the one not seen for the longest
+     * time is dropped to make room for a new one. Thread safe.
+     */
+    class ReplLag
+    {
+    public:
+
+        typedef enum
+        {
+            LAG_ORDERED,
+            LAG_APPLIED,
+            LAG_COMMITTED,
+            LAG_MAX
+        } Stage;
+
+        explicit ReplLag(size_t max_sources = MAX_SOURCES_DEFAULT);
+        ~ReplLag();
+
+        /*! @param origin  write set timestamp, calendar time ns
+         *  @param t       local calendar time of every stage, 0 if the
+         *                 stage was not timed
+         *  @return false if origin timestamp is unusable (not set or too
+         *          far off, e.g. monotonic time from older nodes) */
+        bool record(const wsrep_uuid_t& source, long long origin,
+                    const long long t[LAG_MAX]);
+
+        /*! prints comma separated per source statistics
+         *  uuid:count:offset:ordered_p50:ordered_p99:applied_p50:
+         *  applied_p99:committed_p50:committed_p99, in seconds.
+         *  @param delay  one-way network delay estimate, ns */
+        void print(std::ostream& os, long long delay) const;
+
+        /*! estimated clock offset of source in ns given one-way delay,
+         *  0 if source is unknown */
+        long long offset(const wsrep_uuid_t& source, long long delay) const;
+
+        void clear();
+
+        static size_t const MAX_SOURCES_DEFAULT = 16;
+        static int    const WINDOW              = 1024;
+
+    private:
+
+        struct Source
+        {
+            explicit Source(const wsrep_uuid_t& uuid);
+
+            /* clock offset plus minimum network delay estimate */
+            long long min() const
+            {
+                if (0 == cur_n_)  return prev_min_;
+                if (0 == prev_n_) return cur_min_;
+                return std::min(cur_min_, prev_min_);
+            }
+
+            wsrep_uuid_t  uuid_;
+            gu::Histogram lag_[LAG_MAX];
+            long long     count_;
+            long long     cur_min_;  // minimum ordered lag in this window
+            long long     prev_min_; // in the previous window
+            long long     cur_n_;
+            long long     prev_n_;
+            long long     seen_;     // record() counter value when last seen
+
+        private:
+
+            Source(const Source&);
+            Source& operator=(const Source&);
+        };
+
+        Source* find(const wsrep_uuid_t& source) const;
+
+        std::vector<Source*> sources_;
+        gu::Mutex mutable    mtx_;
+        size_t const         max_sources_;
+        long long            records_;
+
+        ReplLag(const ReplLag&);
+        ReplLag& operator=(const ReplLag&);
+    };
+}
+
+#endif // GALERA_REPL_LAG_HPP
@@ -0,0 +1,70 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "repl_qos.hpp"
+
+#include <gu_lock.hpp>
+#include <gu_throw.hpp>
+#include <gu_string_utils.hpp>
+#include <gu_utils.hpp>
+
+static const char* const class_str[] = { "default", "bulk" };
+
+const char*
+galera::ReplQos::to_string(Class const cls)
+{
+    return class_str[cls];
+}
+
+void
+galera::ReplQos::assign(const std::string& spec)
+{
+    std::vector<std::string> const tok(gu::strsplit(spec, ':'));
+
+    if (tok.size() != 2)
+    {
+        gu_throw_error(EINVAL) << "Malformed QoS class assignment '" << spec
+                               << "', expected '<conn_id>:<class>'";
+    }
+
+    wsrep_conn_id_t conn_id;
+    try
+    {
+        conn_id = gu::from_string<wsrep_conn_id_t>(tok[0]);
+    }
+    catch (gu::NotFound&)
+    {
+        gu_throw_error(EINVAL) << "Bad connection id in '" << spec << "'";
+    }
+
+    std::string cls(tok[1]);
+    gu::trim(cls);
+
+    if      (cls == class_str[DEFAULT]) assign(conn_id, DEFAULT);
+    else if (cls == class_str[BULK])    assign(conn_id, BULK);
+    else
+    {
+        gu_throw_error(EINVAL) << "Unknown QoS class '" << cls << "' in '"
+                               << spec << "'";
+    }
+}
+
+void
+galera::ReplQos::assign(wsrep_conn_id_t const conn_id, Class const cls)
+{
+    gu::Lock lock(mtx_);
+
+    if (BULK == cls) bulk_.insert(conn_id);
+    else             bulk_.erase(conn_id);
+
+    bulk_count_ = bulk_.size();
+}
+
+galera::ReplQos::Class
+galera::ReplQos::lookup(wsrep_conn_id_t const conn_id) const
+{
+    gu::Lock lock(mtx_);
+
+    return (bulk_.find(conn_id) != bulk_.end() ? BULK : DEFAULT);
+}
@@ -0,0 +1,67 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_REPL_QOS_HPP
+#define GALERA_REPL_QOS_HPP
+
+#include "wsrep_api.h"
+
+#include <gu_mutex.hpp>
+#include <gu_atomic.hpp>
+
+#include <set>
+#include <string>
+
+namespace galera
+{
+    /*!
+     * Replication QoS classes of local connections. Write sets of BULK
+     * connections have their own size cap and always enter the send monitor
+     * in the low priority (large) class, so that commits of interactive
+     * connections don't queue behind them.
+     */
+    class ReplQos
+    {
+    public:
+
+        enum Class
+        {
+            DEFAULT,
+            BULK
+        };
+
+        ReplQos() : mtx_(), bulk_(), bulk_count_(0) {}
+
+        /*! parses "<conn_id>:<class>" and assigns the class,
+         *  throws EINVAL on malformed spec */
+        void assign(const std::string& spec);
+
+        void assign(wsrep_conn_id_t conn_id, Class cls);
+
+        Class get(wsrep_conn_id_t const conn_id) const
+        {
+            if (gu_likely(0 == bulk_count_())) return DEFAULT;
+
+            return lookup(conn_id);
+        }
+
+        /*! forgets the class of a closed connection */
+        void discard(wsrep_conn_id_t const conn_id)
+        {
+            if (gu_unlikely(0 != bulk_count_())) assign(conn_id, DEFAULT);
+        }
+
+        static const char* to_string(Class cls);
+
+    private:
+
+        Class lookup(wsrep_conn_id_t conn_id) const;
+
+        mutable gu::Mutex         mtx_;
+        std::set<wsrep_conn_id_t> bulk_;
+        gu::Atomic<long>          bulk_count_; // lockless fast path
+    };
+}
+
+#endif // GALERA_REPL_QOS_HPP
@@ -4,10 +4,13 @@
 
 #include "replicator.hpp"
 
+#include <gu_conf.h>
+
 namespace galera
 {
 
 std::string const Replicator::Param::debug_log = "debug";
+std::string const Replicator::Param::log_async = "log_async";
 #ifdef GU_DBUG_ON
 std::string const Replicator::Param::dbug = "dbug";
 std::string const Replicator::Param::signal = "signal";
@@ -16,12 +19,24 @@ std::string const Replicator::Param::signal = "signal";
 void Replicator::register_params(gu::Config& conf)
 {
     conf.add(Param::debug_log, "no");
+    conf.add(Param::log_async, "0");
 #ifdef GU_DBUG_ON
     conf.add(Param::dbug, "");
     conf.add(Param::signal, "");
 #endif // GU_DBUG_ON
 }
 
+void Replicator::set_log_async(long const size)
+{
+    int const err(gu_conf_log_async(size));
+
+    if (err)
+    {
+        gu_throw_error(-err) << "Failed to set " << Param::log_async
+                             << " to " << size;
+    }
+}
+
 const char* const
 Replicator::TRIVIAL_SST(WSREP_STATE_TRANSFER_TRIVIAL);
 
@@ -28,6 +28,7 @@ namespace galera
         struct Param
         {
             static std::string const debug_log;
+            static std::string const log_async;
 #ifdef GU_DBUG_ON
             static std::string const dbug;
             static std::string const signal;
@@ -131,6 +132,10 @@ namespace galera
         virtual void          desync() = 0;
         virtual void          resync() = 0;
 
+        /*! switches asynchronous logging, size - max pending messages,
+         *  0 - log synchronously */
+        static void set_log_async(long size);
+
     protected:
 
         static void register_params(gu::Config&);
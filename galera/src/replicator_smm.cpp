@@ -10,7 +10,9 @@
 #include "galera_info.hpp"
 
 #include <gu_debug_sync.hpp>
+#include <gu_thread.hpp>
 #include <gu_abort.h>
+#include <gu_probe.h>
 
 #include <sstream>
 #include <iostream>
@@ -129,13 +131,21 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
     sst_state_          (SST_NONE),
     co_mode_            (CommitOrder::from_string(
                              config_.get(Param::commit_order))),
+    commit_group_       (config_.get<bool>(Param::commit_group)),
+    compression_        (compression_from_string(
+                             config_.get(Param::compression))),
+    latency_stats_      (config_.get<bool>(Param::latency_stats)),
+    unordered_prefetch_ (config_.get<bool>(Param::unordered_prefetch)),
+    numa_node_          (config_.get<int>(Param::numa_node)),
     state_file_         (config_.get(BASE_DIR)+'/'+GALERA_STATE_FILE),
     st_                 (state_file_),
     safe_to_bootstrap_  (true),
     trx_params_         (config_.get(BASE_DIR), -1,
                          KeySet::version(config_.get(Param::key_format)),
                          gu::from_string<int>(config_.get(
-                             Param::max_write_set_size))),
+                             Param::max_write_set_size)),
+                         DataSet::VER1,
+                         config_.get<int>(Param::compression_level)),
     uuid_               (WSREP_UUID_UNDEFINED),
     state_uuid_         (WSREP_UUID_UNDEFINED),
     state_uuid_str_     (),
@@ -165,13 +175,29 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
     ist_senders_        (gcs_, gcache_),
     wsdb_               (),
     cert_               (config_, service_thd_),
-    local_monitor_      (),
-    apply_monitor_      (),
-    commit_monitor_     (),
+    local_monitor_      (config_.get<int>(Param::local_monitor_spin),
+                         config_.get<ssize_t>(Param::monitor_window)),
+    apply_monitor_      (config_.get<int>(Param::apply_monitor_spin),
+                         config_.get<ssize_t>(Param::monitor_window)),
+    commit_monitor_     (config_.get<int>(Param::commit_monitor_spin),
+                         config_.get<ssize_t>(Param::monitor_window)),
+    applier_pool_       (config_.get<bool>(Param::applier_pool)),
+    applier_advisor_    (),
     causal_read_timeout_(config_.get(Param::causal_read_timeout)),
+    causal_read_max_lag_(gu::datetime::Period(
+                             config_.get(Param::causal_read_max_lag)).get_nsecs()),
+    causal_read_max_lag_seqnos_(config_.get<long>(
+                                    Param::causal_read_max_lag_seqnos)),
+    ordered_mtx_        (),
+    last_ordered_seqno_ (WSREP_SEQNO_UNDEFINED),
+    last_ordered_time_  (0),
+    qos_                (),
+    qos_bulk_max_ws_size_(config_.get<int>(Param::qos_bulk_max_ws_size)),
     receivers_          (),
     replicated_         (),
     replicated_bytes_   (),
+    replicated_bulk_    (),
+    replicated_bulk_bytes_(),
     keys_count_         (),
     keys_bytes_         (),
     data_bytes_         (),
@@ -181,10 +207,26 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
     local_cert_failures_(),
     local_replays_      (),
     causal_reads_       (),
+    causal_reads_bounded_(),
+    local_bf_aborts_    (),
+    local_replay_ns_    (),
+    local_replay_max_ns_(),
     preordered_id_      (),
+    preordered_sender_  (gcs_, trx_params_, preordered_id_,
+                         config_.get<int>(Param::preordered_batch)),
+    latency_            (),
+    repl_lag_           (),
+    trace_              (config_.get<size_t>(Param::trace_size)),
     incoming_list_      (""),
     incoming_mutex_     (),
-    wsrep_stats_        ()
+    wsrep_stats_        (),
+    stats_interval_     (gu::datetime::Period(
+                             config_.get(Param::stats_interval)).get_nsecs()),
+    stats_mutex_        (),
+    stats_snapshot_     (),
+    stats_snapshot_time_(0),
+    metrics_            (*this, "", gu::datetime::Period(
+                             config_.get(Param::metrics_interval)))
 {
     // @todo add guards (and perhaps actions)
     state_.add_transition(Transition(S_CLOSED,  S_DESTROYED));
@@ -222,6 +264,12 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
 
     local_monitor_.set_initial_position(0);
 
+    gu::Allocator::set_heap_cache(config_.get<int>(Param::ws_heap_cache));
+    gu::Allocator::set_huge_pages(config_.get<bool>(Param::ws_huge_pages));
+    trx_params_.key_escalation_ = config_.get<long>(Param::key_escalation);
+    service_thd_.set_report_interval(
+        gu::datetime::Period(config_.get(Param::commit_report_interval)));
+
     wsrep_uuid_t  uuid;
     wsrep_seqno_t seqno;
 
@@ -253,11 +301,20 @@ galera::ReplicatorSMM::ReplicatorSMM(const struct wsrep_init_args* args)
     cert_.assign_initial_position(seqno, trx_proto_ver());
 
     build_stats_vars(wsrep_stats_);
+
+    // fully constructed now, can start exporting stats
+    trace_.set_sample(config_.get<long>(Param::trace_sample));
+    trace_.set_threshold(gu::datetime::Period(
+                             config_.get(Param::trace_threshold)).get_nsecs());
+
+    metrics_.set_file(config_.get(Param::metrics_file, std::string()));
 }
 
 galera::ReplicatorSMM::~ReplicatorSMM()
 {
     log_info << "dtor state: " << state_();
+    metrics_.stop();
+
     switch (state_())
     {
     case S_CONNECTED:
@@ -274,6 +331,8 @@ galera::ReplicatorSMM::~ReplicatorSMM()
     case S_DESTROYED:
         break;
     }
+
+    gu_conf_log_async(0); // flush pending messages while the logger is there
 }
 
 
@@ -330,6 +389,7 @@ wsrep_status_t galera::ReplicatorSMM::close()
 {
     if (state_() != S_CLOSED)
     {
+        preordered_sender_.close(); // sends what is queued
         gcs_.close();
     }
 
@@ -350,6 +410,20 @@ wsrep_status_t galera::ReplicatorSMM::async_recv(void* recv_ctx)
     ++receivers_;
     as_ = &gcs_as_;
 
+    if (numa_node_ >= 0)
+    {
+        try
+        {
+            gu::thread_set_numa_node(gu_thread_self(), numa_node_);
+        }
+        catch (gu::Exception& e)
+        {
+            log_warn << "Applier thread: " << e.what();
+        }
+    }
+
+    ApplierPool::Member const member(applier_pool_, recv_ctx);
+
     bool exit_loop(false);
     wsrep_status_t retval(WSREP_OK);
 
@@ -430,6 +504,8 @@ void galera::ReplicatorSMM::apply_trx(void* recv_ctx, TrxHandle* trx)
     CommitOrder co(*trx, co_mode_);
 
     gu_trace(apply_monitor_.enter(ao));
+    stamp(trx, TrxHandle::T_APPLY_ORDER);
+    GU_PROBE2(apply_begin, trx->global_seqno(), trx->depends_seqno());
     trx->set_state(TrxHandle::S_APPLYING);
 
     wsrep_trx_meta_t meta = {{state_uuid_, trx->global_seqno() },
@@ -445,9 +521,21 @@ void galera::ReplicatorSMM::apply_trx(void* recv_ctx, TrxHandle* trx)
     /* at this point any exception in apply_trx_ws() is fatal, not
      * catching anything. */
 
+    uint32_t flags(TrxHandle::trx_flags_to_wsrep_flags(trx->flags()));
+
     if (gu_likely(co_mode_ != CommitOrder::BYPASS))
     {
         gu_trace(commit_monitor_.enter(co));
+        stamp(trx, TrxHandle::T_COMMIT_ORDER);
+
+        // let application know that the next commit is already waiting
+        // and will flush this one as well
+        if (commit_group_ &&
+            commit_monitor_.waiting_upto(trx->global_seqno()) >
+            trx->global_seqno())
+        {
+            flags |= WSREP_FLAG_COMMIT_GROUP;
+        }
     }
     trx->set_state(TrxHandle::S_COMMITTING);
 
@@ -455,7 +543,7 @@ void galera::ReplicatorSMM::apply_trx(void* recv_ctx, TrxHandle* trx)
     wsrep_cb_status_t const rcode(
         commit_cb_(
             recv_ctx,
-            TrxHandle::trx_flags_to_wsrep_flags(trx->flags()),
+            flags,
             &meta,
             &exit_loop,
             true));
@@ -466,6 +554,8 @@ void galera::ReplicatorSMM::apply_trx(void* recv_ctx, TrxHandle* trx)
     if (gu_likely(co_mode_ != CommitOrder::BYPASS))
     {
         commit_monitor_.leave(co);
+        stamp(trx, TrxHandle::T_COMMITTED);
+        record_latency(*trx);
     }
     trx->set_state(TrxHandle::S_COMMITTED);
 
@@ -479,9 +569,10 @@ void galera::ReplicatorSMM::apply_trx(void* recv_ctx, TrxHandle* trx)
      * ends by the time monitors are drained because of potential gcache
      * cleanup (and loss of the writeset buffer). Perhaps unordered monitor
      * is needed here. */
-    trx->unordered(recv_ctx, unordered_cb_);
+    if (!unordered_prefetch_) trx->unordered(recv_ctx, unordered_cb_);
 
     apply_monitor_.leave(ao);
+    GU_PROBE1(apply_end, trx->global_seqno());
 
     if (trx->is_toi())
     {
@@ -513,7 +604,11 @@ wsrep_status_t galera::ReplicatorSMM::replicate(TrxHandle* trx,
         return retval;
     }
 
+    stamp(trx, TrxHandle::T_REPLICATE);
+
     WriteSetNG::GatherVector actv;
+    void* cached(NULL); // write set buffer in gcache
+    bool const bulk(ReplQos::BULK == qos_.get(trx->conn_id()));
 
     gcs_action act;
     act.type = GCS_ACT_TORDERED;
@@ -528,6 +623,38 @@ wsrep_status_t galera::ReplicatorSMM::replicate(TrxHandle* trx,
                                                trx->conn_id(),
                                                trx->trx_id(),
                                                actv);
+
+        if (gu_unlikely(bulk && qos_bulk_max_ws_size_ > 0 &&
+                        act.size > qos_bulk_max_ws_size_))
+        {
+            gu_throw_error(EMSGSIZE)
+                << "Write set size " << act.size << " of bulk connection "
+                << trx->conn_id() << " exceeds "
+                << Param::qos_bulk_max_ws_size << " = "
+                << qos_bulk_max_ws_size_;
+        }
+
+        /* Serialize write set where it is going to be kept: GCS then
+         * receives own action right there instead of copying it in the
+         * receiving thread. If gcache can't have it, GCS will copy. */
+        cached = gcache_.malloc(act.size);
+
+        if (gu_likely(NULL != cached))
+        {
+            gu::byte_t* const ptr(static_cast<gu::byte_t*>(cached));
+            ssize_t copied(0);
+
+            for (size_t i(0); i < actv.size(); ++i)
+            {
+                memcpy(ptr + copied, actv[i].ptr, actv[i].size);
+                copied += actv[i].size;
+            }
+            assert(copied == act.size);
+
+            actv.resize(1);
+            actv[0].ptr  = cached;
+            actv[0].size = act.size;
+        }
     }
     else
     {
@@ -546,6 +673,8 @@ wsrep_status_t galera::ReplicatorSMM::replicate(TrxHandle* trx,
 
     trx->set_state(TrxHandle::S_REPLICATING);
 
+    GU_PROBE2(ws_send, trx->trx_id(), act.size);
+
     ssize_t rcode(-1);
 
     do
@@ -557,6 +686,7 @@ wsrep_status_t galera::ReplicatorSMM::replicate(TrxHandle* trx,
         if (gu_unlikely(gcs_handle < 0))
         {
             log_debug << "gcs schedule " << strerror(-gcs_handle);
+            if (cached) gcache_.free(cached);
             trx->set_state(TrxHandle::S_MUST_ABORT);
             goto must_abort;
         }
@@ -569,7 +699,7 @@ wsrep_status_t galera::ReplicatorSMM::replicate(TrxHandle* trx,
             assert(trx->last_seen_seqno() >= 0);
             trx->unlock();
             assert (act.buf == NULL); // just a sanity check
-            rcode = gcs_.replv(actv, act, true);
+            rcode = gcs_.replv(actv, act, true, NULL != cached, bulk);
         }
         else
         {
@@ -599,6 +729,8 @@ wsrep_status_t galera::ReplicatorSMM::replicate(TrxHandle* trx,
         assert(act.seqno_l == GCS_SEQNO_ILL && act.seqno_g == GCS_SEQNO_ILL);
         assert(NULL == act.buf || !trx->new_version());
 
+        if (cached) gcache_.free(cached);
+
         if (trx->state() != TrxHandle::S_MUST_ABORT)
         {
             trx->set_state(TrxHandle::S_MUST_ABORT);
@@ -609,22 +741,33 @@ wsrep_status_t galera::ReplicatorSMM::replicate(TrxHandle* trx,
     }
 
     assert(act.buf != NULL);
+    assert(NULL == cached || act.buf == cached);
     assert(act.size == rcode);
     assert(act.seqno_l != GCS_SEQNO_ILL);
     assert(act.seqno_g != GCS_SEQNO_ILL);
 
     ++replicated_;
     replicated_bytes_ += rcode;
+    if (bulk)
+    {
+        ++replicated_bulk_;
+        replicated_bulk_bytes_ += rcode;
+    }
     trx->set_gcs_handle(-1);
 
     if (trx->new_version())
     {
+        /* a cached action is delivered in the very buffer it was written to
+         * locally, nothing to verify */
         gu_trace(trx->unserialize(static_cast<const gu::byte_t*>(act.buf),
-                                  act.size, 0));
+                                  act.size, 0, act.buf != cached));
         trx->update_stats(keys_count_, keys_bytes_, data_bytes_, unrd_bytes_);
     }
 
     trx->set_received(act.buf, act.seqno_l, act.seqno_g);
+    stamp(trx, TrxHandle::T_ORDERED);
+    note_ordered(act.seqno_g);
+    GU_PROBE3(ws_recv, act.seqno_g, act.seqno_l, act.size);
 
     if (trx->state() == TrxHandle::S_MUST_ABORT)
     {
@@ -672,6 +815,15 @@ galera::ReplicatorSMM::abort_trx(TrxHandle* trx)
     case TrxHandle::S_MUST_ABORT:
     case TrxHandle::S_ABORTING: // guess this is here because we can have a race
         return;
+    case TrxHandle::S_MUST_CERT_AND_REPLAY:
+    case TrxHandle::S_MUST_REPLAY_AM:
+    case TrxHandle::S_MUST_REPLAY_CM:
+    case TrxHandle::S_MUST_REPLAY:
+    case TrxHandle::S_REPLAYING:
+        // already ordered and going to be replayed with BF priority, aborting
+        // it again would only make the replay start over
+        log_debug << "ignoring BF abort of replaying trx " << *trx;
+        return;
     case TrxHandle::S_EXECUTING:
         trx->set_state(TrxHandle::S_MUST_ABORT);
         break;
@@ -724,6 +876,8 @@ galera::ReplicatorSMM::abort_trx(TrxHandle* trx)
     default:
         gu_throw_fatal << "invalid state " << trx->state();
     }
+
+    ++local_bf_aborts_;
 }
 
 
@@ -772,6 +926,8 @@ wsrep_status_t galera::ReplicatorSMM::pre_commit(TrxHandle*        trx,
     try
     {
         gu_trace(apply_monitor_.enter(ao));
+        stamp(trx, TrxHandle::T_APPLY_ORDER);
+        GU_PROBE2(apply_begin, trx->global_seqno(), trx->depends_seqno());
     }
     catch (gu::Exception& e)
     {
@@ -794,6 +950,7 @@ wsrep_status_t galera::ReplicatorSMM::pre_commit(TrxHandle*        trx,
             try
             {
                 gu_trace(commit_monitor_.enter(co));
+                stamp(trx, TrxHandle::T_COMMIT_ORDER);
             }
             catch (gu::Exception& e)
             {
@@ -838,6 +995,7 @@ wsrep_status_t galera::ReplicatorSMM::replay_trx(TrxHandle* trx, void* trx_ctx)
     assert(trx->trx_id() != static_cast<wsrep_trx_id_t>(-1));
     assert(trx->global_seqno() > STATE_SEQNO());
 
+    ReplayTimer const timer(*this);
     wsrep_status_t retval(WSREP_OK);
 
     switch (trx->state())
@@ -930,15 +1088,21 @@ wsrep_status_t galera::ReplicatorSMM::post_commit(TrxHandle* trx)
     assert(trx->local_seqno() > -1 && trx->global_seqno() > -1);
 
     CommitOrder co(*trx, co_mode_);
-    if (co_mode_ != CommitOrder::BYPASS) commit_monitor_.leave(co);
+    if (co_mode_ != CommitOrder::BYPASS)
+    {
+        commit_monitor_.leave(co);
+        stamp(trx, TrxHandle::T_COMMITTED);
+    }
 
     ApplyOrder ao(*trx);
     report_last_committed(cert_.set_trx_committed(trx));
     apply_monitor_.leave(ao);
+    GU_PROBE1(apply_end, trx->global_seqno());
 
     trx->set_state(TrxHandle::S_COMMITTED);
 
     ++local_commits_;
+    record_latency(*trx);
 
     return WSREP_OK;
 }
@@ -965,15 +1129,45 @@ wsrep_status_t galera::ReplicatorSMM::post_rollback(TrxHandle* trx)
 }
 
 
+wsrep_seqno_t galera::ReplicatorSMM::bounded_read_seqno()
+{
+    if (gu_likely(0 == causal_read_max_lag_) || state_() != S_SYNCED)
+    {
+        return WSREP_SEQNO_UNDEFINED;
+    }
+
+    long long const now(gu::datetime::Date::monotonic().get_utc());
+
+    gu::Lock lock(ordered_mtx_);
+
+    if (last_ordered_seqno_ < 0 ||
+        now - last_ordered_time_ > causal_read_max_lag_)
+    {
+        return WSREP_SEQNO_UNDEFINED;
+    }
+
+    return std::max<wsrep_seqno_t>(
+        last_ordered_seqno_ - causal_read_max_lag_seqnos_, 0);
+}
+
+
 wsrep_status_t galera::ReplicatorSMM::causal_read(wsrep_gtid_t* gtid)
 {
-    wsrep_seqno_t cseq(static_cast<wsrep_seqno_t>(gcs_.caused()));
+    // Bounded staleness: if total order was seen recently enough, waiting
+    // for it locally saves the round trip through the group.
+    wsrep_seqno_t cseq(bounded_read_seqno());
+    bool const    bounded(cseq >= 0);
 
-    if (cseq < 0)
+    if (!bounded)
     {
-        log_warn << "gcs_caused() returned " << cseq << " (" << strerror(-cseq)
-                 << ')';
-        return WSREP_TRX_FAIL;
+        cseq = static_cast<wsrep_seqno_t>(gcs_.caused());
+
+        if (cseq < 0)
+        {
+            log_warn << "gcs_caused() returned " << cseq << " ("
+                     << strerror(-cseq) << ')';
+            return WSREP_TRX_FAIL;
+        }
     }
 
     try
@@ -1001,6 +1195,7 @@ wsrep_status_t galera::ReplicatorSMM::causal_read(wsrep_gtid_t* gtid)
             gtid->seqno = cseq;
         }
         ++causal_reads_;
+        if (bounded) ++causal_reads_bounded_;
         return WSREP_OK;
     }
     catch (gu::Exception& e)
@@ -1103,8 +1298,9 @@ writeset_from_handle (wsrep_po_handle_t& handle,
                 trx_params.working_dir_, wsrep_trx_id_t(&handle),
                 /* key format is not essential since we're not adding keys */
                 KeySet::version(trx_params.key_format_), NULL, 0,
-                0, WriteSetNG::MAX_VERSION, DataSet::MAX_VERSION, DataSet::MAX_VERSION,
-                trx_params.max_write_set_size_);
+                0, WriteSetNG::MAX_VERSION, trx_params.data_set_ver_,
+                trx_params.data_set_ver_, trx_params.max_write_set_size_,
+                trx_params.compression_level_, trx_params.check_type_);
 
             handle.opaque = ret;
         }
@@ -1117,6 +1313,28 @@ writeset_from_handle (wsrep_po_handle_t& handle,
     return ret;
 }
 
+static PreorderedSender::Event*
+event_from_handle (wsrep_po_handle_t& handle)
+{
+    PreorderedSender::Event* ret
+        (reinterpret_cast<PreorderedSender::Event*>(handle.opaque));
+
+    if (NULL == ret)
+    {
+        try
+        {
+            ret = new PreorderedSender::Event();
+            handle.opaque = ret;
+        }
+        catch (std::bad_alloc& ba)
+        {
+            gu_throw_error(ENOMEM) << "Could not create preordered event";
+        }
+    }
+
+    return ret;
+}
+
 } /* namespace galera */
 
 wsrep_status_t
@@ -1128,6 +1346,19 @@ galera::ReplicatorSMM::preordered_collect(wsrep_po_handle_t&            handle,
     if (gu_unlikely(trx_params_.version_ < WS_NG_VERSION))
         return WSREP_NOT_IMPLEMENTED;
 
+    if (preordered_sender_.enabled())
+    {
+        /* commit returns before the event is sent, so it is always copied */
+        PreorderedSender::Event* const ev(event_from_handle(handle));
+
+        for (size_t i(0); i < count; ++i)
+        {
+            ev->append(data[i].ptr, data[i].len);
+        }
+
+        return WSREP_OK;
+    }
+
     WriteSetOut* const ws(writeset_from_handle(handle, trx_params_));
 
     for (size_t i(0); i < count; ++i)
@@ -1149,6 +1380,26 @@ galera::ReplicatorSMM::preordered_commit(wsrep_po_handle_t&            handle,
     if (gu_unlikely(trx_params_.version_ < WS_NG_VERSION))
         return WSREP_NOT_IMPLEMENTED;
 
+    if (preordered_sender_.enabled())
+    {
+        PreorderedSender::Event* const ev(event_from_handle(handle));
+        handle.opaque = NULL;
+
+        if (gu_likely(true == commit))
+        {
+            /* takes ownership of ev, throws if an earlier send failed */
+            preordered_sender_.submit(ev, source,
+                                      WriteSetNG::wsrep_flags_to_ws_flags(flags),
+                                      pa_range);
+        }
+        else
+        {
+            delete ev;
+        }
+
+        return WSREP_OK;
+    }
+
     WriteSetOut* const ws(writeset_from_handle(handle, trx_params_));
 
     if (gu_likely(true == commit))
@@ -1232,23 +1483,44 @@ void galera::ReplicatorSMM::process_trx(void* recv_ctx, TrxHandle* trx)
     assert(trx->depends_seqno() == -1);
     assert(trx->state() == TrxHandle::S_REPLICATING);
 
+    stamp(trx, TrxHandle::T_ORDERED);
+    note_ordered(trx->global_seqno());
+
     wsrep_status_t const retval(cert_and_catch(trx));
 
     switch (retval)
     {
     case WSREP_OK:
-        try
+        prefetch(recv_ctx, trx);
+
+        if (applier_pool_.enabled())
         {
-            gu_trace(apply_trx(recv_ctx, trx));
+            ApplyReady const ready(apply_monitor_);
+
+            // another slave thread will apply it when it is ready
+            if (applier_pool_.defer(recv_ctx, trx, ready)) break;
+
+            apply_slave_trx(recv_ctx, trx);
+
+            bool exit_loop(trx->exit_loop());
+            TrxHandle* next;
+
+            while ((next = applier_pool_.next(recv_ctx, ready)) != 0)
+            {
+                // its receiver holds it locked until it is done with it
+                next->lock();
+                apply_slave_trx(recv_ctx, next);
+                next->unlock();
+
+                exit_loop = exit_loop || next->exit_loop();
+                next->unref();
+            }
+
+            trx->set_exit_loop(exit_loop);
         }
-        catch (std::exception& e)
+        else
         {
-            st_.mark_corrupt();
-
-            log_fatal << "Failed to apply trx: " << *trx;
-            log_fatal << e.what();
-            log_fatal << "Node consistency compromized, aborting...";
-            abort();
+            apply_slave_trx(recv_ctx, trx);
         }
         break;
     case WSREP_TRX_FAIL:
@@ -1265,6 +1537,36 @@ void galera::ReplicatorSMM::process_trx(void* recv_ctx, TrxHandle* trx)
 }
 
 
+/* Unordered data sets carry no state changes, so with unordered_prefetch
+ * they are delivered as soon as the write set is certified rather than after
+ * it is committed. The application can attach row lookup hints there and warm
+ * up its caches while the write set waits for its turn in the apply monitor.
+ * The write set buffer is safe to access here: gcache can't discard it until
+ * the trx is committed. */
+void galera::ReplicatorSMM::prefetch(void* recv_ctx, const TrxHandle* trx)
+{
+    if (unordered_prefetch_) trx->unordered(recv_ctx, unordered_cb_);
+}
+
+
+void galera::ReplicatorSMM::apply_slave_trx(void* recv_ctx, TrxHandle* trx)
+{
+    try
+    {
+        gu_trace(apply_trx(recv_ctx, trx));
+    }
+    catch (std::exception& e)
+    {
+        st_.mark_corrupt();
+
+        log_fatal << "Failed to apply trx: " << *trx;
+        log_fatal << e.what();
+        log_fatal << "Node consistency compromized, aborting...";
+        abort();
+    }
+}
+
+
 void galera::ReplicatorSMM::process_commit_cut(wsrep_seqno_t seq,
                                                wsrep_seqno_t seqno_l)
 {
@@ -1276,9 +1578,10 @@ void galera::ReplicatorSMM::process_commit_cut(wsrep_seqno_t seq,
 
     if (seq >= cc_seqno_) /* Refs #782. workaround for
                            * assert(seqno >= seqno_released_) in gcache. */
-        cert_.purge_trxs_upto(seq, true);
+        cert_.schedule_purge(seq);
 
     local_monitor_.leave(lo);
+    note_ordered(WSREP_SEQNO_UNDEFINED); // group is alive and we are current
     log_debug << "Got commit cut from GCS: " << seq;
 }
 
@@ -1314,6 +1617,26 @@ void galera::ReplicatorSMM::establish_protocol_versions (int proto_ver)
         trx_params_.version_ = 3;
         str_proto_ver_ = 2;
         break;
+    case 8:
+        // Compressed data sets (DataSet::VER2) allowed in write sets.
+        trx_params_.version_ = 3;
+        str_proto_ver_ = 2;
+        break;
+    case 9:
+        // XXH64 record set checksums allowed in write sets.
+        trx_params_.version_ = 3;
+        str_proto_ver_ = 2;
+        break;
+    case 10:
+        // IST may be split between several donors.
+        trx_params_.version_ = 3;
+        str_proto_ver_ = 3;
+        break;
+    case 11:
+        // CRC32C record set checksums allowed in write sets.
+        trx_params_.version_ = 3;
+        str_proto_ver_ = 3;
+        break;
     default:
         log_fatal << "Configuration change resulted in an unsupported protocol "
             "version: " << proto_ver << ". Can't continue.";
@@ -1321,6 +1644,7 @@ void galera::ReplicatorSMM::establish_protocol_versions (int proto_ver)
     };
 
     protocol_version_ = proto_ver;
+    set_data_set_version();
     log_info << "REPL Protocols: " << protocol_version_ << " ("
               << trx_params_.version_ << ", " << str_proto_ver_ << ")";
 }
@@ -1375,6 +1699,7 @@ galera::ReplicatorSMM::process_conf_change(void*                    recv_ctx,
     assert(seqno_l > -1);
 
     update_incoming_list(view_info);
+    reset_ordered();
 
     LocalOrder lo(seqno_l);
     gu_trace(local_monitor_.enter(lo));
@@ -1701,6 +2026,9 @@ wsrep_status_t galera::ReplicatorSMM::cert(TrxHandle* trx)
 
     trx->set_state(TrxHandle::S_CERTIFYING);
 
+    /* order independent part, done while preceding trxs certify */
+    Certification::prepare(trx);
+
     LocalOrder  lo(*trx);
     ApplyOrder  ao(*trx);
     CommitOrder co(*trx, co_mode_);
@@ -1722,9 +2050,12 @@ wsrep_status_t galera::ReplicatorSMM::cert(TrxHandle* trx)
 
     if (gu_likely (!interrupted))
     {
+        stamp(trx, TrxHandle::T_LOCAL_ORDER);
+
         switch (cert_.append_trx(trx))
         {
         case Certification::TEST_OK:
+            GU_PROBE2(cert_pass, trx->global_seqno(), trx->depends_seqno());
             if (gu_likely(applicable))
             {
                 if (trx->state() == TrxHandle::S_CERTIFYING)
@@ -1756,6 +2087,7 @@ wsrep_status_t galera::ReplicatorSMM::cert(TrxHandle* trx)
                 assert(0);
             }
             local_cert_failures_ += trx->is_local();
+            GU_PROBE2(cert_fail, trx->global_seqno(), int(trx->is_local()));
             trx->set_state(TrxHandle::S_MUST_ABORT);
             retval = WSREP_TRX_FAIL;
             break;
@@ -1777,6 +2109,7 @@ wsrep_status_t galera::ReplicatorSMM::cert(TrxHandle* trx)
                               trx->depends_seqno());
 
         local_monitor_.leave(lo);
+        stamp(trx, TrxHandle::T_CERTIFIED);
     }
     else
     {
@@ -17,23 +17,31 @@
 #include "gcs.hpp"
 #include "monitor.hpp"
 #include "wsdb.hpp"
+#include "applier_pool.hpp"
+#include "applier_advisor.hpp"
+#include "preordered_sender.hpp"
 #include "certification.hpp"
 #include "trx_handle.hpp"
 #include "write_set.hpp"
 #include "galera_service_thd.hpp"
+#include "metrics_exporter.hpp"
+#include "trx_trace.hpp"
+#include "repl_lag.hpp"
+#include "repl_qos.hpp"
 #include "fsm.hpp"
 #include "gcs_action_source.hpp"
 #include "ist.hpp"
 #include "gu_atomic.hpp"
 #include "saved_state.hpp"
 #include "gu_debug_sync.hpp"
+#include "gu_histogram.hpp"
 
 
 #include <map>
 
 namespace galera
 {
-    class ReplicatorSMM : public Replicator
+    class ReplicatorSMM : public Replicator, public MetricsExporter::Source
     {
     public:
 
@@ -91,6 +99,7 @@ namespace galera
         void discard_local_conn(wsrep_conn_id_t conn_id)
         {
             wsdb_.discard_conn(conn_id);
+            qos_.discard(conn_id);
         }
 
         void apply_trx(void* recv_ctx, TrxHandle* trx);
@@ -175,7 +184,34 @@ namespace galera
             static const std::string key_format;
             static const std::string commit_order;
             static const std::string causal_read_timeout;
+            static const std::string causal_read_max_lag;
+            static const std::string causal_read_max_lag_seqnos;
             static const std::string max_write_set_size;
+            static const std::string local_monitor_spin;
+            static const std::string apply_monitor_spin;
+            static const std::string commit_monitor_spin;
+            static const std::string monitor_window;
+            static const std::string commit_group;
+            static const std::string compression;
+            static const std::string compression_level;
+            static const std::string latency_stats;
+            static const std::string ws_heap_cache;
+            static const std::string ws_huge_pages;
+            static const std::string key_escalation;
+            static const std::string applier_pool;
+            static const std::string commit_report_interval;
+            static const std::string preordered_batch;
+            static const std::string unordered_prefetch;
+            static const std::string numa_node;
+            static const std::string stats_interval;
+            static const std::string metrics_file;
+            static const std::string metrics_interval;
+            static const std::string trace_sample;
+            static const std::string trace_threshold;
+            static const std::string trace_size;
+            static const std::string trace_dump;
+            static const std::string qos_class;
+            static const std::string qos_bulk_max_ws_size;
         };
 
         typedef std::pair<std::string, std::string> Default;
@@ -203,10 +239,61 @@ namespace galera
             }
         }
 
+        /* notes that the node has seen group total order up to seqno as of
+         * now, -1 only refreshes the time, see causal_read() */
+        void note_ordered(wsrep_seqno_t const seqno)
+        {
+            if (gu_likely(0 == causal_read_max_lag_)) return;
+
+            gu::Lock lock(ordered_mtx_);
+
+            if (seqno > last_ordered_seqno_) last_ordered_seqno_ = seqno;
+
+            if (last_ordered_seqno_ >= 0)
+            {
+                last_ordered_time_ =
+                    gu::datetime::Date::monotonic().get_utc();
+            }
+        }
+
+        /* forgets the seen total order, e.g. on configuration change */
+        void reset_ordered()
+        {
+            gu::Lock lock(ordered_mtx_);
+            last_ordered_seqno_ = WSREP_SEQNO_UNDEFINED;
+            last_ordered_time_  = 0;
+        }
+
+        /* returns seqno a bounded staleness read has to wait for or -1 if
+         * a full causal read is needed */
+        wsrep_seqno_t bounded_read_seqno();
+
+                /* timestamps pipeline stage if latency stats or trace are enabled */
+        void stamp(TrxHandle* trx, TrxHandle::Stage const s) const
+        {
+            if (gu_unlikely(latency_stats_ || trace_.enabled())) trx->stamp(s);
+        }
+
+        /* records stage latencies and timeline of a committed trx */
+        void record_latency(const TrxHandle& trx)
+        {
+            if (gu_unlikely(latency_stats_)) record_latency_stages(trx);
+            if (gu_unlikely(trace_.enabled())) trace_.record(trx);
+        }
+
+        void record_latency_stages(const TrxHandle& trx);
+
         wsrep_status_t cert(TrxHandle* trx);
         wsrep_status_t cert_and_catch(TrxHandle* trx);
         wsrep_status_t cert_for_aborted(TrxHandle* trx);
 
+        /* passes unordered data of certified trx to the application
+         * ahead of apply if configured so */
+        void prefetch(void* recv_ctx, const TrxHandle* trx);
+
+        /* applies certified slave trx, aborts on failure */
+        void apply_slave_trx(void* recv_ctx, TrxHandle* trx);
+
         void update_state_uuid (const wsrep_uuid_t& u);
         void update_incoming_list (const wsrep_view_info_t& v);
 
@@ -235,7 +322,8 @@ namespace galera
             wsrep_seqno_t seqno() const { return seqno_; }
 
             bool condition(wsrep_seqno_t last_entered,
-                           wsrep_seqno_t last_left) const
+                           wsrep_seqno_t last_left,
+                           const Monitor<LocalOrder>&) const
             {
                 return (last_left + 1 == seqno_);
             }
@@ -270,11 +358,26 @@ namespace galera
 
             wsrep_seqno_t seqno() const { return trx_.global_seqno(); }
 
-            bool condition(wsrep_seqno_t last_entered,
-                           wsrep_seqno_t last_left) const
+            bool condition(wsrep_seqno_t              last_entered,
+                           wsrep_seqno_t              last_left,
+                           const Monitor<ApplyOrder>& mon) const
             {
-                return (trx_.is_local() == true ||
-                        last_left >= trx_.depends_seqno());
+                if (trx_.is_local() == true ||
+                    last_left >= trx_.depends_seqno()) return true;
+
+                // trx may still be ready if all its conflicting
+                // predecessors are known and have been applied
+                const TrxDeps& deps(trx_.deps());
+
+                if (deps.valid() == false || last_left < deps.floor())
+                    return false;
+
+                for (int i(0); i < deps.size(); ++i)
+                {
+                    if (mon.has_left(deps[i]) == false) return false;
+                }
+
+                return true;
             }
 
 #ifdef GU_DBUG_ON
@@ -304,6 +407,49 @@ namespace galera
             TrxHandle& trx_;
         };
 
+        /* ApplierPool predicate: trx can enter apply monitor right away */
+        class ApplyReady
+        {
+        public:
+
+            explicit ApplyReady(Monitor<ApplyOrder>& mon) : mon_(mon) {}
+
+            bool operator()(TrxHandle& trx) const
+            {
+                ApplyOrder const ao(trx);
+                return (mon_.would_wait(ao) == false);
+            }
+
+        private:
+            Monitor<ApplyOrder>& mon_;
+        };
+
+        /* accounts time spent in replay_trx() including monitor waits */
+        class ReplayTimer
+        {
+        public:
+
+            explicit ReplayTimer(ReplicatorSMM& repl)
+                : repl_(repl), start_(gu_time_monotonic()) {}
+
+            ~ReplayTimer()
+            {
+                long long const t(gu_time_monotonic() - start_);
+
+                repl_.local_replay_ns_ += t;
+                /* racy, but replays are serialized by the apply monitor */
+                if (t > repl_.local_replay_max_ns_())
+                    repl_.local_replay_max_ns_ = t;
+            }
+
+        private:
+            ReplayTimer(const ReplayTimer&);
+            ReplayTimer& operator=(const ReplayTimer&);
+
+            ReplicatorSMM&  repl_;
+            long long const start_;
+        };
+
     public:
 
         class CommitOrder
@@ -344,7 +490,8 @@ namespace galera
             void unlock() { trx_.unlock(); }
             wsrep_seqno_t seqno() const { return trx_.global_seqno(); }
             bool condition(wsrep_seqno_t last_entered,
-                           wsrep_seqno_t last_left) const
+                           wsrep_seqno_t last_left,
+                           const Monitor<CommitOrder>&) const
             {
                 switch (mode_)
                 {
@@ -433,8 +580,16 @@ namespace galera
 
         void build_stats_vars (std::vector<struct wsrep_stats_var>& stats);
 
+        /* collects current stats into a gu_malloc()'ed buffer of
+         * buf_size bytes */
+        struct wsrep_stats_var* stats_build(size_t& buf_size) const;
+
         void establish_protocol_versions (int version);
 
+        /* selects data set version from compression setting and protocol */
+        void set_data_set_version();
+        static bool compression_from_string(const std::string& value);
+
         bool state_transfer_required(const wsrep_view_info_t& view_info);
 
         void prepare_for_IST (void*& req, ssize_t& req_len,
@@ -459,6 +614,10 @@ namespace galera
         wsrep_seqno_t donate_sst(void* recv_ctx, const StateRequest& streq,
                                  const wsrep_gtid_t& state_id, bool bypass);
 
+        /* sends a share of split IST on behalf of another donor */
+        void send_ist_share(const void* req, size_t req_size, int share,
+                            int donors);
+
         /* local state seqno for internal use (macro mock up) */
         wsrep_seqno_t STATE_SEQNO(void) { return apply_monitor_.last_left(); }
 
@@ -498,6 +657,9 @@ namespace galera
          * |                 5 |              3 |              1 |
          * |                 6 |              3 |              2 |
          * |                 7 |              3 |              2 |
+         * |                 8 |              3 |              2 |
+         * |                 9 |              3 |              2 |
+         * |                10 |              3 |              3 |
          * -------------------------------------------------------
          */
 
@@ -510,6 +672,11 @@ namespace galera
 
         // configurable params
         const CommitOrder::Mode co_mode_; // commit order mode
+        bool                    commit_group_; // flag commit groups
+        bool                    compression_;  // compress data sets
+        bool                    latency_stats_; // time pipeline stages
+        bool const              unordered_prefetch_; // unordered as hints
+        int const               numa_node_;    // where to run appliers
 
         // persistent data location
         std::string           state_file_;
@@ -566,29 +733,71 @@ namespace galera
         Monitor<LocalOrder>  local_monitor_;
         Monitor<ApplyOrder>  apply_monitor_;
         Monitor<CommitOrder> commit_monitor_;
+        ApplierPool          applier_pool_;
+        mutable ApplierAdvisor applier_advisor_; // updated by stats_get()
         gu::datetime::Period causal_read_timeout_;
+        long long            causal_read_max_lag_; // nanoseconds, 0 - off
+        long                 causal_read_max_lag_seqnos_;
+        gu::Mutex            ordered_mtx_;
+        wsrep_seqno_t        last_ordered_seqno_; // -1 - unknown
+        long long            last_ordered_time_;  // monotonic, nanoseconds
+        ReplQos              qos_;
+        int                  qos_bulk_max_ws_size_; // 0 - same as max_ws_size
 
         // counters
         gu::Atomic<size_t>    receivers_;
-        gu::Atomic<long long> replicated_;
-        gu::Atomic<long long> replicated_bytes_;
-        gu::Atomic<long long> keys_count_;
-        gu::Atomic<long long> keys_bytes_;
-        gu::Atomic<long long> data_bytes_;
-        gu::Atomic<long long> unrd_bytes_;
-        gu::Atomic<long long> local_commits_;
-        gu::Atomic<long long> local_rollbacks_;
+        gu::PerCpuCounter     replicated_;
+        gu::PerCpuCounter     replicated_bytes_;
+        gu::PerCpuCounter     replicated_bulk_;
+        gu::PerCpuCounter     replicated_bulk_bytes_;
+        gu::PerCpuCounter     keys_count_;
+        gu::PerCpuCounter     keys_bytes_;
+        gu::PerCpuCounter     data_bytes_;
+        gu::PerCpuCounter     unrd_bytes_;
+        gu::PerCpuCounter     local_commits_;
+        gu::PerCpuCounter     local_rollbacks_;
         gu::Atomic<long long> local_cert_failures_;
         gu::Atomic<long long> local_replays_;
         gu::Atomic<long long> causal_reads_;
+        gu::Atomic<long long> causal_reads_bounded_;
+        gu::Atomic<long long> local_bf_aborts_;
+        gu::Atomic<long long> local_replay_ns_;     // time spent in replay
+        gu::Atomic<long long> local_replay_max_ns_; // longest replay
 
         gu::Atomic<long long> preordered_id_; // temporary preordered ID
+        PreorderedSender      preordered_sender_;
+
+        // per-stage latencies, see record_latency_stages()
+        typedef enum
+        {
+            LAT_REPL,       // replicate() to total order
+            LAT_LOCAL_WAIT, // total order to local monitor
+            LAT_CERT,       // certification
+            LAT_APPLY_WAIT, // certified to apply monitor
+            LAT_APPLY,      // apply monitor to commit monitor
+            LAT_COMMIT,     // commit monitor enter to leave
+            LAT_TOTAL,      // first stamp to commit monitor leave
+            LAT_MAX
+        } LatencyStage;
+
+        gu::Histogram         latency_[LAT_MAX];
+        ReplLag               repl_lag_; // origin to local stages, per source
+        TrxTrace              trace_; // sampled and slow trx timelines
 
         // non-atomic stats
         std::string           incoming_list_;
         mutable gu::Mutex     incoming_mutex_;
 
         mutable std::vector<struct wsrep_stats_var> wsrep_stats_;
+
+        // stats_get() snapshot, see repl.stats_interval
+        long long                 stats_interval_; // nanoseconds, 0 - off
+        mutable gu::Mutex         stats_mutex_;
+        mutable std::vector<char> stats_snapshot_;
+        mutable long long         stats_snapshot_time_;
+
+        // must be the last to be destroyed first, see ~ReplicatorSMM()
+        MetricsExporter           metrics_;
     };
 
     std::ostream& operator<<(std::ostream& os, ReplicatorSMM::State state);
@@ -7,6 +7,7 @@
 #include "gu_uri.hpp"
 #include "write_set_ng.hpp"
 #include "gu_throw.hpp"
+#include "gu_alloc.hpp"
 
 const std::string galera::ReplicatorSMM::Param::base_host = "base_host";
 const std::string galera::ReplicatorSMM::Param::base_port = "base_port";
@@ -18,14 +19,68 @@ const std::string galera::ReplicatorSMM::Param::commit_order =
     common_prefix + "commit_order";
 const std::string galera::ReplicatorSMM::Param::causal_read_timeout =
     common_prefix + "causal_read_timeout";
+const std::string galera::ReplicatorSMM::Param::causal_read_max_lag =
+    common_prefix + "causal_read_max_lag";
+const std::string galera::ReplicatorSMM::Param::causal_read_max_lag_seqnos =
+    common_prefix + "causal_read_max_lag_seqnos";
 const std::string galera::ReplicatorSMM::Param::proto_max =
     common_prefix + "proto_max";
 const std::string galera::ReplicatorSMM::Param::key_format =
     common_prefix + "key_format";
 const std::string galera::ReplicatorSMM::Param::max_write_set_size =
     common_prefix + "max_ws_size";
-
-int const galera::ReplicatorSMM::MAX_PROTO_VER(7);
+const std::string galera::ReplicatorSMM::Param::local_monitor_spin =
+    common_prefix + "local_monitor_spin";
+const std::string galera::ReplicatorSMM::Param::apply_monitor_spin =
+    common_prefix + "apply_monitor_spin";
+const std::string galera::ReplicatorSMM::Param::commit_monitor_spin =
+    common_prefix + "commit_monitor_spin";
+const std::string galera::ReplicatorSMM::Param::monitor_window =
+    common_prefix + "monitor_window";
+const std::string galera::ReplicatorSMM::Param::commit_group =
+    common_prefix + "commit_group";
+const std::string galera::ReplicatorSMM::Param::compression =
+    common_prefix + "compression";
+const std::string galera::ReplicatorSMM::Param::compression_level =
+    common_prefix + "compression_level";
+const std::string galera::ReplicatorSMM::Param::latency_stats =
+    common_prefix + "latency_stats";
+const std::string galera::ReplicatorSMM::Param::ws_heap_cache =
+    common_prefix + "ws_heap_cache";
+const std::string galera::ReplicatorSMM::Param::ws_huge_pages =
+    common_prefix + "ws_huge_pages";
+const std::string galera::ReplicatorSMM::Param::key_escalation =
+    common_prefix + "key_escalation";
+const std::string galera::ReplicatorSMM::Param::applier_pool =
+    common_prefix + "applier_pool";
+const std::string galera::ReplicatorSMM::Param::commit_report_interval =
+    common_prefix + "commit_report_interval";
+const std::string galera::ReplicatorSMM::Param::preordered_batch =
+    common_prefix + "preordered_batch";
+const std::string galera::ReplicatorSMM::Param::unordered_prefetch =
+    common_prefix + "unordered_prefetch";
+const std::string galera::ReplicatorSMM::Param::numa_node =
+    common_prefix + "numa_node";
+const std::string galera::ReplicatorSMM::Param::stats_interval =
+    common_prefix + "stats_interval";
+const std::string galera::ReplicatorSMM::Param::metrics_file =
+    common_prefix + "metrics_file";
+const std::string galera::ReplicatorSMM::Param::metrics_interval =
+    common_prefix + "metrics_interval";
+const std::string galera::ReplicatorSMM::Param::trace_sample =
+    common_prefix + "trace_sample";
+const std::string galera::ReplicatorSMM::Param::trace_threshold =
+    common_prefix + "trace_threshold";
+const std::string galera::ReplicatorSMM::Param::trace_size =
+    common_prefix + "trace_size";
+const std::string galera::ReplicatorSMM::Param::trace_dump =
+    common_prefix + "trace_dump";
+const std::string galera::ReplicatorSMM::Param::qos_class =
+    common_prefix + "qos_class";
+const std::string galera::ReplicatorSMM::Param::qos_bulk_max_ws_size =
+    common_prefix + "qos_bulk_max_ws_size";
+
+int const galera::ReplicatorSMM::MAX_PROTO_VER(11);
 
 galera::ReplicatorSMM::Defaults::Defaults() : map_()
 {
@@ -35,9 +90,39 @@ galera::ReplicatorSMM::Defaults::Defaults() : map_()
     map_.insert(Default(Param::key_format, "FLAT8"));
     map_.insert(Default(Param::commit_order, "3"));
     map_.insert(Default(Param::causal_read_timeout, "PT30S"));
+    map_.insert(Default(Param::causal_read_max_lag, "PT0S"));
+    map_.insert(Default(Param::causal_read_max_lag_seqnos, "0"));
     const int max_write_set_size(galera::WriteSetNG::MAX_SIZE);
     map_.insert(Default(Param::max_write_set_size,
                         gu::to_string(max_write_set_size)));
+    map_.insert(Default(Param::local_monitor_spin, "0"));
+    map_.insert(Default(Param::apply_monitor_spin, "0"));
+    map_.insert(Default(Param::commit_monitor_spin, "0"));
+    map_.insert(Default(Param::monitor_window,
+                        gu::to_string(Monitor<LocalOrder>::DEFAULT_SIZE)));
+    map_.insert(Default(Param::commit_group, "no"));
+    map_.insert(Default(Param::compression, "off"));
+    const int compression_level(galera::DataSet::DEFAULT_COMPRESSION_LEVEL);
+    map_.insert(Default(Param::compression_level,
+                        gu::to_string(compression_level)));
+    map_.insert(Default(Param::latency_stats, "no"));
+    map_.insert(Default(Param::ws_heap_cache, "16"));
+    map_.insert(Default(Param::ws_huge_pages, "no"));
+    map_.insert(Default(Param::key_escalation, "0"));
+    map_.insert(Default(Param::applier_pool, "no"));
+    map_.insert(Default(Param::commit_report_interval, "PT0.01S"));
+    map_.insert(Default(Param::preordered_batch, "1"));
+    map_.insert(Default(Param::unordered_prefetch, "no"));
+    map_.insert(Default(Param::numa_node, "-1"));
+    map_.insert(Default(Param::stats_interval, "PT0S"));
+    map_.insert(Default(Param::metrics_file, ""));
+    map_.insert(Default(Param::metrics_interval, "PT1S"));
+    map_.insert(Default(Param::trace_sample, "0"));
+    map_.insert(Default(Param::trace_threshold, "PT0S"));
+    map_.insert(Default(Param::trace_size, "1024"));
+    map_.insert(Default(Param::trace_dump, ""));
+    map_.insert(Default(Param::qos_class, ""));
+    map_.insert(Default(Param::qos_bulk_max_ws_size, "0"));
 }
 
 const galera::ReplicatorSMM::Defaults galera::ReplicatorSMM::defaults;
@@ -126,6 +211,19 @@ galera::ReplicatorSMM::ParseOptions::ParseOptions(Replicator&       repl,
 {
     conf.parse(opts);
 
+    /* repl.numa_node is the default for the GCache and GCS nodes */
+    int const numa_node(conf.get<int>(Param::numa_node));
+    if (numa_node >= 0)
+    {
+        static const char* const layers[] =
+            { "gcache.numa_node", "gcs.numa_node", NULL };
+
+        for (const char* const* l(layers); *l != NULL; ++l)
+        {
+            if (conf.get<int>(*l) < 0) conf.set(*l, gu::to_string(numa_node));
+        }
+    }
+
     if (conf.get<bool>(Replicator::Param::debug_log))
     {
         gu_conf_debug_on();
@@ -134,6 +232,8 @@ galera::ReplicatorSMM::ParseOptions::ParseOptions(Replicator&       repl,
     {
         gu_conf_debug_off();
     }
+
+    Replicator::set_log_async(conf.get<long>(Replicator::Param::log_async));
 #ifdef GU_DBUG_ON
     if (conf.is_set(galera::Replicator::Param::dbug))
     {
@@ -167,10 +267,40 @@ galera::ReplicatorSMM::set_param (const std::string& key,
     {
         causal_read_timeout_ = gu::datetime::Period(value);
     }
+    else if (key == Param::causal_read_max_lag)
+    {
+        long long const lag(gu::datetime::Period(value).get_nsecs());
+
+        if (lag < 0)
+        {
+            gu_throw_error(EINVAL) << "Negative value for '" << key << "': "
+                                   << value;
+        }
+
+        reset_ordered(); // don't trust what was tracked before
+        causal_read_max_lag_ = lag;
+    }
+    else if (key == Param::causal_read_max_lag_seqnos)
+    {
+        long const n(gu::Config::from_config<long>(value));
+
+        if (n < 0)
+        {
+            gu_throw_error(EINVAL) << "Negative value for '" << key << "': "
+                                   << value;
+        }
+
+        causal_read_max_lag_seqnos_ = n;
+    }
     else if (key == Param::base_host ||
              key == Param::base_port ||
              key == Param::base_dir ||
-             key == Param::proto_max)
+             key == Param::proto_max ||
+             key == Param::applier_pool ||
+             key == Param::preordered_batch ||
+             key == Param::unordered_prefetch ||
+             key == Param::numa_node ||
+             key == Param::trace_size)
     {
         // nothing to do here, these params take effect only at
         // provider (re)start
@@ -183,6 +313,107 @@ galera::ReplicatorSMM::set_param (const std::string& key,
     {
         trx_params_.max_write_set_size_ = gu::from_string<int>(value);
     }
+    else if (key == Param::local_monitor_spin)
+    {
+        local_monitor_.set_spin(gu::from_string<int>(value));
+    }
+    else if (key == Param::apply_monitor_spin)
+    {
+        apply_monitor_.set_spin(gu::from_string<int>(value));
+    }
+    else if (key == Param::commit_monitor_spin)
+    {
+        commit_monitor_.set_spin(gu::from_string<int>(value));
+    }
+    else if (key == Param::monitor_window)
+    {
+        /* grows only, shrinking needs restart */
+        ssize_t const size(gu::Config::from_config<ssize_t>(value));
+        local_monitor_.set_size(size);
+        apply_monitor_.set_size(size);
+        commit_monitor_.set_size(size);
+    }
+    else if (key == Param::commit_group)
+    {
+        commit_group_ = gu::Config::from_config<bool>(value);
+    }
+    else if (key == Param::compression)
+    {
+        compression_ = compression_from_string(value);
+        set_data_set_version();
+    }
+    else if (key == Param::compression_level)
+    {
+        trx_params_.compression_level_ = gu::from_string<int>(value);
+    }
+    else if (key == Param::latency_stats)
+    {
+        latency_stats_ = gu::Config::from_config<bool>(value);
+    }
+    else if (key == Param::ws_heap_cache)
+    {
+        gu::Allocator::set_heap_cache(gu::from_string<int>(value));
+    }
+    else if (key == Param::ws_huge_pages)
+    {
+        gu::Allocator::set_huge_pages(gu::Config::from_config<bool>(value));
+    }
+    else if (key == Param::key_escalation)
+    {
+        long const rows(gu::Config::from_config<long>(value));
+
+        if (rows < 0)
+        {
+            gu_throw_error(EINVAL) << "Negative value for '" << key << "': "
+                                   << value;
+        }
+
+        trx_params_.key_escalation_ = rows;
+    }
+    else if (key == Param::commit_report_interval)
+    {
+        service_thd_.set_report_interval(gu::datetime::Period(value));
+    }
+    else if (key == Param::stats_interval)
+    {
+        stats_interval_ = gu::datetime::Period(value).get_nsecs();
+    }
+    else if (key == Param::metrics_file)
+    {
+        metrics_.set_file(value);
+    }
+    else if (key == Param::metrics_interval)
+    {
+        metrics_.set_interval(gu::datetime::Period(value));
+    }
+    else if (key == Param::trace_sample)
+    {
+        long const n(gu::Config::from_config<long>(value));
+
+        if (n < 0)
+        {
+            gu_throw_error(EINVAL) << "Negative value for '" << key << "': "
+                                   << value;
+        }
+
+        trace_.set_sample(n);
+    }
+    else if (key == Param::trace_threshold)
+    {
+        trace_.set_threshold(gu::datetime::Period(value).get_nsecs());
+    }
+    else if (key == Param::qos_bulk_max_ws_size)
+    {
+        int const size(gu::Config::from_config<int>(value));
+
+        if (size < 0)
+        {
+            gu_throw_error(EINVAL) << "Negative value for '" << key << "': "
+                                   << value;
+        }
+
+        qos_bulk_max_ws_size_ = size;
+    }
     else
     {
         log_warn << "parameter '" << key << "' not found";
@@ -195,6 +426,18 @@ void
 galera::ReplicatorSMM::param_set (const std::string& key,
                                   const std::string& value)
 {
+    // a trigger, not a setting: acts on every call and is never stored
+    if (key == Param::trace_dump)
+    {
+        log_info << trace_;
+        return;
+    }
+    else if (key == Param::qos_class)
+    {
+        qos_.assign(value);
+        return;
+    }
+
     try
     {
         if (config_.get(key) == value) return;
@@ -218,6 +461,20 @@ galera::ReplicatorSMM::param_set (const std::string& key,
         cert_.set_log_conflicts(value);
         return;
     }
+    else if (key == ist::Sender::SEND_RATE)
+    {
+        long long const rate(gu::Config::from_config<long long>(value));
+
+        if (rate < 0)
+        {
+            gu_throw_error(EINVAL) << "Negative value for '" << key << "': "
+                                   << value;
+        }
+
+        config_.set(key, value);
+        ist_senders_.set_send_rate(rate);
+        return;
+    }
     // this key might be for another module
     else if (0 != key.find(common_prefix))
     {
@@ -245,3 +502,25 @@ galera::ReplicatorSMM::param_get (const std::string& key) const
     return config_.get(key);
 }
 
+void
+galera::ReplicatorSMM::set_data_set_version()
+{
+    trx_params_.data_set_ver_ = (compression_ && protocol_version_ >= 8) ?
+        DataSet::VER2 : DataSet::VER1;
+    if (protocol_version_ >= 11 && gu_crc32c_hardware())
+        trx_params_.check_type_ = gu::RecordSet::CHECK_CRC32C;
+    else if (protocol_version_ >= 9)
+        trx_params_.check_type_ = gu::RecordSet::CHECK_XXH64;
+    else
+        trx_params_.check_type_ = gu::RecordSet::CHECK_MMH128;
+}
+
+bool
+galera::ReplicatorSMM::compression_from_string(const std::string& value)
+{
+    if (value == "off" || value == "none") return false;
+    if (value == "zlib") return true;
+
+    gu_throw_error(EINVAL) << "Unsupported compression '" << value
+                           << "', expected 'off' or 'zlib'"; throw;
+}
@@ -4,6 +4,11 @@
 #include "uuid.hpp"
 #include <gu_debug_sync.hpp>
 #include <gu_mem.h>
+#include <gu_mem_stats.hpp>
+#include <gu_time.h>
+
+#include <cstdlib>
+#include <sstream>
 
 // @todo: should be protected static member of the parent class
 static const size_t GALERA_STAGE_MAX(11);
@@ -79,6 +84,8 @@ typedef enum status_vars
     STATS_LAST_APPLIED,
     STATS_REPLICATED,
     STATS_REPLICATED_BYTES,
+    STATS_REPLICATED_BULK,
+    STATS_REPLICATED_BULK_BYTES,
     STATS_KEYS_COUNT,
     STATS_KEYS_BYTES,
     STATS_DATA_BYTES,
@@ -88,6 +95,9 @@ typedef enum status_vars
     STATS_LOCAL_COMMITS,
     STATS_LOCAL_CERT_FAILURES,
     STATS_LOCAL_REPLAYS,
+    STATS_LOCAL_BF_ABORTS,
+    STATS_LOCAL_REPLAY_TIME,
+    STATS_LOCAL_REPLAY_MAX,
     STATS_LOCAL_SEND_QUEUE,
     STATS_LOCAL_SEND_QUEUE_MAX,
     STATS_LOCAL_SEND_QUEUE_MIN,
@@ -113,7 +123,79 @@ typedef enum status_vars
     STATS_LOCAL_STATE_COMMENT,
     STATS_CERT_INDEX_SIZE,
     STATS_CAUSAL_READS,
+    STATS_CAUSAL_READS_BOUNDED,
     STATS_CERT_INTERVAL,
+    STATS_CERT_PURGE_LAG,
+    STATS_GCACHE_RB_FREE,
+    STATS_GCACHE_RB_USED,
+    STATS_GCACHE_RB_TRAIL,
+    STATS_GCACHE_PAGES,
+    STATS_GCACHE_PAGES_BYTES,
+    STATS_GCACHE_EVICTED,
+    STATS_GCACHE_RB_OVERFLOWS,
+    STATS_GCACHE_LARGE_BUFFERS,
+    STATS_GCACHE_RB_LOCKED,
+    STATS_GCACHE_RB_RESIDENT,
+    STATS_APPLIER_DEFERRED,
+    STATS_APPLIER_STOLEN,
+    STATS_APPLIER_RECOMMENDED,
+    STATS_PREORDERED_EVENTS,
+    STATS_PREORDERED_ACTIONS,
+    STATS_IST_RECV_SEQNO_FIRST,
+    STATS_IST_RECV_SEQNO_LAST,
+    STATS_IST_RECV_SEQNO_CURRENT,
+    STATS_IST_RECV_BYTES,
+    STATS_IST_RECV_RATE,
+    STATS_IST_RECV_ETA,
+    STATS_IST_RECV_QUEUE,
+    STATS_IST_SEND_ACTIVE,
+    STATS_IST_SEND_SEQNO_FIRST,
+    STATS_IST_SEND_SEQNO_LAST,
+    STATS_IST_SEND_SEQNO_CURRENT,
+    STATS_IST_SEND_BYTES,
+    STATS_IST_SEND_RATE,
+    STATS_IST_SEND_ETA,
+    STATS_LATENCY_FIRST, // 4 vars per stage follow, see stats_get()
+    STATS_REPL_LATENCY_AVG = STATS_LATENCY_FIRST,
+    STATS_REPL_LATENCY_P50,
+    STATS_REPL_LATENCY_P99,
+    STATS_REPL_LATENCY_P999,
+    STATS_LOCAL_WAIT_LATENCY_AVG,
+    STATS_LOCAL_WAIT_LATENCY_P50,
+    STATS_LOCAL_WAIT_LATENCY_P99,
+    STATS_LOCAL_WAIT_LATENCY_P999,
+    STATS_CERT_LATENCY_AVG,
+    STATS_CERT_LATENCY_P50,
+    STATS_CERT_LATENCY_P99,
+    STATS_CERT_LATENCY_P999,
+    STATS_APPLY_WAIT_LATENCY_AVG,
+    STATS_APPLY_WAIT_LATENCY_P50,
+    STATS_APPLY_WAIT_LATENCY_P99,
+    STATS_APPLY_WAIT_LATENCY_P999,
+    STATS_APPLY_LATENCY_AVG,
+    STATS_APPLY_LATENCY_P50,
+    STATS_APPLY_LATENCY_P99,
+    STATS_APPLY_LATENCY_P999,
+    STATS_COMMIT_LATENCY_AVG,
+    STATS_COMMIT_LATENCY_P50,
+    STATS_COMMIT_LATENCY_P99,
+    STATS_COMMIT_LATENCY_P999,
+    STATS_TOTAL_LATENCY_AVG,
+    STATS_TOTAL_LATENCY_P50,
+    STATS_TOTAL_LATENCY_P99,
+    STATS_TOTAL_LATENCY_P999,
+    STATS_MEM_FIRST, // one var per gu::MemStats::Tag follows
+    STATS_MEM_POOL = STATS_MEM_FIRST,
+    STATS_MEM_ALLOC_HEAP,
+    STATS_MEM_GCACHE_RAM,
+    STATS_MEM_GCACHE_RB,
+    STATS_MEM_GCACHE_PAGES,
+    STATS_MEM_CERT_INDEX,
+    STATS_MEM_GCOMM_SEND_Q,
+    STATS_CERT_CONFLICTS,
+    STATS_CERT_HOT_KEYS,
+    STATS_CERT_CONFLICT_KEYS,
+    STATS_REPL_LAG,
     STATS_INCOMING_LIST,
     STATS_MAX
 } StatusVars;
@@ -125,6 +207,8 @@ static const struct wsrep_stats_var wsrep_stats[STATS_MAX + 1] =
     { "last_committed",           WSREP_VAR_INT64,  { -1 } },
     { "replicated",               WSREP_VAR_INT64,  { 0 }  },
     { "replicated_bytes",         WSREP_VAR_INT64,  { 0 }  },
+    { "replicated_bulk",          WSREP_VAR_INT64,  { 0 }  },
+    { "replicated_bulk_bytes",    WSREP_VAR_INT64,  { 0 }  },
     { "repl_keys",                WSREP_VAR_INT64,  { 0 }  },
     { "repl_keys_bytes",          WSREP_VAR_INT64,  { 0 }  },
     { "repl_data_bytes",          WSREP_VAR_INT64,  { 0 }  },
@@ -134,6 +218,9 @@ static const struct wsrep_stats_var wsrep_stats[STATS_MAX + 1] =
     { "local_commits",            WSREP_VAR_INT64,  { 0 }  },
     { "local_cert_failures",      WSREP_VAR_INT64,  { 0 }  },
     { "local_replays",            WSREP_VAR_INT64,  { 0 }  },
+    { "local_bf_abort_requests",  WSREP_VAR_INT64,  { 0 }  },
+    { "local_replay_time",        WSREP_VAR_DOUBLE, { 0 }  },
+    { "local_replay_time_max",    WSREP_VAR_DOUBLE, { 0 }  },
     { "local_send_queue",         WSREP_VAR_INT64,  { 0 }  },
     { "local_send_queue_max",     WSREP_VAR_INT64,  { 0 }  },
     { "local_send_queue_min",     WSREP_VAR_INT64,  { 0 }  },
@@ -159,7 +246,77 @@ static const struct wsrep_stats_var wsrep_stats[STATS_MAX + 1] =
     { "local_state_comment",      WSREP_VAR_STRING, { 0 }  },
     { "cert_index_size",          WSREP_VAR_INT64,  { 0 }  },
     { "causal_reads",             WSREP_VAR_INT64,  { 0 }  },
+    { "causal_reads_bounded",     WSREP_VAR_INT64,  { 0 }  },
     { "cert_interval",            WSREP_VAR_DOUBLE, { 0 }  },
+    { "cert_purge_lag",           WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_rb_free_bytes",     WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_rb_used_bytes",     WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_rb_trail_bytes",    WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_pages",             WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_pages_bytes",       WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_evicted",           WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_rb_overflows",      WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_large_buffers",     WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_rb_locked_bytes",   WSREP_VAR_INT64,  { 0 }  },
+    { "gcache_rb_resident_bytes", WSREP_VAR_INT64,  { 0 }  },
+    { "applier_deferred",         WSREP_VAR_INT64,  { 0 }  },
+    { "applier_stolen",           WSREP_VAR_INT64,  { 0 }  },
+    { "applier_threads_recommended", WSREP_VAR_INT64, { 0 } },
+    { "preordered_events",        WSREP_VAR_INT64,  { 0 }  },
+    { "preordered_actions",       WSREP_VAR_INT64,  { 0 }  },
+    { "ist_recv_seqno_first",     WSREP_VAR_INT64,  { -1 } },
+    { "ist_recv_seqno_last",      WSREP_VAR_INT64,  { -1 } },
+    { "ist_recv_seqno_current",   WSREP_VAR_INT64,  { -1 } },
+    { "ist_recv_bytes",           WSREP_VAR_INT64,  { 0 }  },
+    { "ist_recv_rate",            WSREP_VAR_DOUBLE, { 0 }  },
+    { "ist_recv_eta",             WSREP_VAR_DOUBLE, { 0 }  },
+    { "ist_recv_queue",           WSREP_VAR_INT64,  { 0 }  },
+    { "ist_send_active",          WSREP_VAR_INT64,  { 0 }  },
+    { "ist_send_seqno_first",     WSREP_VAR_INT64,  { -1 } },
+    { "ist_send_seqno_last",      WSREP_VAR_INT64,  { -1 } },
+    { "ist_send_seqno_current",   WSREP_VAR_INT64,  { -1 } },
+    { "ist_send_bytes",           WSREP_VAR_INT64,  { 0 }  },
+    { "ist_send_rate",            WSREP_VAR_DOUBLE, { 0 }  },
+    { "ist_send_eta",             WSREP_VAR_DOUBLE, { 0 }  },
+    { "repl_latency_avg",         WSREP_VAR_DOUBLE, { 0 }  },
+    { "repl_latency_p50",         WSREP_VAR_DOUBLE, { 0 }  },
+    { "repl_latency_p99",         WSREP_VAR_DOUBLE, { 0 }  },
+    { "repl_latency_p999",        WSREP_VAR_DOUBLE, { 0 }  },
+    { "local_wait_latency_avg",   WSREP_VAR_DOUBLE, { 0 }  },
+    { "local_wait_latency_p50",   WSREP_VAR_DOUBLE, { 0 }  },
+    { "local_wait_latency_p99",   WSREP_VAR_DOUBLE, { 0 }  },
+    { "local_wait_latency_p999",  WSREP_VAR_DOUBLE, { 0 }  },
+    { "cert_latency_avg",         WSREP_VAR_DOUBLE, { 0 }  },
+    { "cert_latency_p50",         WSREP_VAR_DOUBLE, { 0 }  },
+    { "cert_latency_p99",         WSREP_VAR_DOUBLE, { 0 }  },
+    { "cert_latency_p999",        WSREP_VAR_DOUBLE, { 0 }  },
+    { "apply_wait_latency_avg",   WSREP_VAR_DOUBLE, { 0 }  },
+    { "apply_wait_latency_p50",   WSREP_VAR_DOUBLE, { 0 }  },
+    { "apply_wait_latency_p99",   WSREP_VAR_DOUBLE, { 0 }  },
+    { "apply_wait_latency_p999",  WSREP_VAR_DOUBLE, { 0 }  },
+    { "apply_latency_avg",        WSREP_VAR_DOUBLE, { 0 }  },
+    { "apply_latency_p50",        WSREP_VAR_DOUBLE, { 0 }  },
+    { "apply_latency_p99",        WSREP_VAR_DOUBLE, { 0 }  },
+    { "apply_latency_p999",       WSREP_VAR_DOUBLE, { 0 }  },
+    { "commit_latency_avg",       WSREP_VAR_DOUBLE, { 0 }  },
+    { "commit_latency_p50",       WSREP_VAR_DOUBLE, { 0 }  },
+    { "commit_latency_p99",       WSREP_VAR_DOUBLE, { 0 }  },
+    { "commit_latency_p999",      WSREP_VAR_DOUBLE, { 0 }  },
+    { "total_latency_avg",        WSREP_VAR_DOUBLE, { 0 }  },
+    { "total_latency_p50",        WSREP_VAR_DOUBLE, { 0 }  },
+    { "total_latency_p99",        WSREP_VAR_DOUBLE, { 0 }  },
+    { "total_latency_p999",       WSREP_VAR_DOUBLE, { 0 }  },
+    { "mem_pool_bytes",           WSREP_VAR_INT64,  { 0 }  },
+    { "mem_alloc_heap_bytes",     WSREP_VAR_INT64,  { 0 }  },
+    { "mem_gcache_ram_bytes",     WSREP_VAR_INT64,  { 0 }  },
+    { "mem_gcache_rb_bytes",      WSREP_VAR_INT64,  { 0 }  },
+    { "mem_gcache_pages_bytes",   WSREP_VAR_INT64,  { 0 }  },
+    { "mem_cert_index_bytes",     WSREP_VAR_INT64,  { 0 }  },
+    { "mem_gcomm_send_q_bytes",   WSREP_VAR_INT64,  { 0 }  },
+    { "cert_conflicts",           WSREP_VAR_INT64,  { 0 }  },
+    { "cert_hot_keys",            WSREP_VAR_STRING, { 0 }  },
+    { "cert_conflict_keys",       WSREP_VAR_STRING, { 0 }  },
+    { "repl_lag",                 WSREP_VAR_STRING, { 0 }  },
     { "incoming_addresses",       WSREP_VAR_STRING, { 0 }  },
     { 0,                          WSREP_VAR_STRING, { 0 }  }
 };
@@ -179,17 +336,163 @@ galera::ReplicatorSMM::build_stats_vars (
     stats[STATS_STATE_UUID].value._string = state_uuid_str_;
 }
 
+/* Relocates string pointers that point into the buffer copied from [from] */
+static void
+stats_relocate(struct wsrep_stats_var* const sv,
+               const char* const             from,
+               size_t const                  size)
+{
+    const char* const to(reinterpret_cast<const char*>(sv));
+
+    for (struct wsrep_stats_var* v(sv); ; ++v)
+    {
+        if (v->name >= from && v->name < from + size)
+        {
+            v->name = to + (v->name - from);
+        }
+
+        if (WSREP_VAR_STRING == v->type && v->value._string >= from &&
+            v->value._string < from + size)
+        {
+            v->value._string = to + (v->value._string - from);
+        }
+
+        if (0 == v->name) break;
+    }
+}
+
 const struct wsrep_stats_var*
 galera::ReplicatorSMM::stats_get() const
 {
     if (S_DESTROYED == state_()) return 0;
 
-    std::vector<struct wsrep_stats_var> sv(wsrep_stats_);
+    long long const interval(stats_interval_);
+
+    if (interval <= 0)
+    {
+        size_t size;
+        return stats_build(size);
+    }
+
+    /* Snapshot mode: concurrent and frequent pollers are served a copy of
+     * the last snapshot, only one of them at a time pays for collecting
+     * the stats with all the locks involved. */
+    gu::Lock lock(stats_mutex_);
+
+    long long const now(gu_time_monotonic());
+
+    if (stats_snapshot_.empty() || now - stats_snapshot_time_ >= interval)
+    {
+        size_t size;
+        struct wsrep_stats_var* const buf(stats_build(size));
+
+        if (buf)
+        {
+            const char* const ptr(reinterpret_cast<const char*>(buf));
+            stats_snapshot_.assign(ptr, ptr + size);
+            stats_snapshot_time_ = now;
+        }
+
+        return buf;
+    }
+
+    struct wsrep_stats_var* const buf(static_cast<struct wsrep_stats_var*>(
+                                      gu_malloc(stats_snapshot_.size())));
+
+    if (buf)
+    {
+        memcpy(buf, &stats_snapshot_[0], stats_snapshot_.size());
+        stats_relocate(buf, &stats_snapshot_[0], stats_snapshot_.size());
+    }
+    else
+    {
+        log_warn << "Failed to allocate stats vars buffer to "
+                 << stats_snapshot_.size()
+                 << " bytes. System is running out of memory.";
+    }
+
+    return buf;
+}
+
+struct wsrep_stats_var*
+galera::ReplicatorSMM::stats_build(size_t& buf_size) const
+{
+    std::string hot_keys;
+    std::string conflict_keys;
+    long long   conflicts(0);
+    cert_.hot_keys_get(hot_keys, conflict_keys, conflicts);
+
+    // Get gcs backend status
+    gu::Status status;
+    gcs_.get_status(status);
+#ifdef GU_DBUG_ON
+    status.insert("debug_sync_waiters", gu_debug_sync_waiters());
+#endif // GU_DBUG_ON
+
+    std::string incoming;
+    {
+        gu::Lock lock_inc(incoming_mutex_);
+        incoming = incoming_list_;
+    }
+
+    // one-way delay estimate for replication lag is half of the worst
+    // gmcast link RTT (microseconds)
+    long long delay(0);
+    for (gu::Status::const_iterator i(status.begin()); i != status.end(); ++i)
+    {
+        if (i->first == "gmcast_path_rtt")
+        {
+            delay = strtoll(i->second.c_str(), NULL, 10) * 1000 / 2;
+            break;
+        }
+    }
+
+    std::ostringstream lag;
+    repl_lag_.print(lag, delay);
+    std::string const repl_lag(lag.str());
+
+    // Dynamical strings are copied into buffer allocated after stats var array.
+    // Compute space needed.
+    size_t tail_size(0);
+    for (gu::Status::const_iterator i(status.begin()); i != status.end(); ++i)
+    {
+        tail_size += i->first.size() + 1 + i->second.size() + 1;
+    }
+
+    tail_size += hot_keys.size() + 1 + conflict_keys.size() + 1;
+    tail_size += repl_lag.size() + 1;
+    tail_size += incoming.size() + 1;
+
+    /* Create a buffer to be passed to the caller. */
+    // The buffer size needed:
+    // * Space for wsrep_stats_ array
+    // * Space for additional elements from status map
+    // * Trailing space for string store
+    size_t const sv_size(wsrep_stats_.size() + status.size());
+    size_t const vec_size(sv_size*sizeof(struct wsrep_stats_var));
+    buf_size = vec_size + tail_size;
+
+    struct wsrep_stats_var* const sv(static_cast<struct wsrep_stats_var*>(
+                                     gu_malloc(buf_size)));
+
+    if (!sv)
+    {
+        log_warn << "Failed to allocate stats vars buffer to "
+                 << buf_size
+                 << " bytes. System is running out of memory.";
+        return sv;
+    }
+
+    // static part: names, types and constant values, filled in below
+    memcpy(sv, &wsrep_stats_[0],
+           wsrep_stats_.size()*sizeof(struct wsrep_stats_var));
 
     sv[STATS_PROTOCOL_VERSION   ].value._int64  = protocol_version_;
     sv[STATS_LAST_APPLIED       ].value._int64  = apply_monitor_.last_left();
     sv[STATS_REPLICATED         ].value._int64  = replicated_();
     sv[STATS_REPLICATED_BYTES   ].value._int64  = replicated_bytes_();
+    sv[STATS_REPLICATED_BULK    ].value._int64  = replicated_bulk_();
+    sv[STATS_REPLICATED_BULK_BYTES].value._int64 = replicated_bulk_bytes_();
     sv[STATS_KEYS_COUNT         ].value._int64  = keys_count_();
     sv[STATS_KEYS_BYTES         ].value._int64  = keys_bytes_();
     sv[STATS_DATA_BYTES         ].value._int64  = data_bytes_();
@@ -199,6 +502,11 @@ galera::ReplicatorSMM::stats_get() const
     sv[STATS_LOCAL_COMMITS      ].value._int64  = local_commits_();
     sv[STATS_LOCAL_CERT_FAILURES].value._int64  = local_cert_failures_();
     sv[STATS_LOCAL_REPLAYS      ].value._int64  = local_replays_();
+    sv[STATS_LOCAL_BF_ABORTS    ].value._int64  = local_bf_aborts_();
+    // seconds
+    sv[STATS_LOCAL_REPLAY_TIME  ].value._double = local_replay_ns_() * 1.0e-9;
+    sv[STATS_LOCAL_REPLAY_MAX   ].value._double =
+        local_replay_max_ns_() * 1.0e-9;
 
     struct gcs_stats stats;
     gcs_.get_stats (&stats);
@@ -227,6 +535,81 @@ galera::ReplicatorSMM::stats_get() const
     sv[STATS_CERT_DEPS_DISTANCE  ].value._double = avg_deps_dist;
     sv[STATS_CERT_INTERVAL       ].value._double = avg_cert_interval;
     sv[STATS_CERT_INDEX_SIZE     ].value._int64 = index_size;
+    sv[STATS_CERT_PURGE_LAG      ].value._int64 = cert_.purge_lag();
+
+    sv[STATS_CERT_CONFLICTS      ].value._int64 = conflicts;
+
+    gcache::GCache::Stats gstats;
+    gcache_.stats_get(gstats);
+
+    sv[STATS_GCACHE_RB_FREE      ].value._int64 = gstats.rb_free;
+    sv[STATS_GCACHE_RB_USED      ].value._int64 = gstats.rb_used;
+    sv[STATS_GCACHE_RB_TRAIL     ].value._int64 = gstats.rb_trail;
+    sv[STATS_GCACHE_PAGES        ].value._int64 = gstats.pages;
+    sv[STATS_GCACHE_PAGES_BYTES  ].value._int64 = gstats.pages_bytes;
+    sv[STATS_GCACHE_EVICTED      ].value._int64 = gstats.evicted;
+    sv[STATS_GCACHE_RB_OVERFLOWS ].value._int64 = gstats.rb_overflows;
+    sv[STATS_GCACHE_LARGE_BUFFERS].value._int64 = gstats.large_buffers;
+    sv[STATS_GCACHE_RB_LOCKED    ].value._int64 = gstats.rb_locked;
+    sv[STATS_GCACHE_RB_RESIDENT  ].value._int64 = gstats.rb_resident;
+
+    // stay 0 unless repl.applier_pool is on
+    long long deferred, stolen;
+    applier_pool_.stats_get(deferred, stolen);
+
+    sv[STATS_APPLIER_DEFERRED    ].value._int64 = deferred;
+    sv[STATS_APPLIER_STOLEN      ].value._int64 = stolen;
+
+    // stay 0 unless repl.preordered_batch is above 1
+    long long po_events, po_actions;
+    preordered_sender_.stats_get(po_events, po_actions);
+
+    sv[STATS_PREORDERED_EVENTS   ].value._int64 = po_events;
+    sv[STATS_PREORDERED_ACTIONS  ].value._int64 = po_actions;
+
+    // progress of the current or the last IST, rate in bytes per second,
+    // eta in seconds, -1 if not known yet
+    ist::Stats ist;
+    ist_receiver_.stats_get(ist);
+
+    sv[STATS_IST_RECV_SEQNO_FIRST  ].value._int64  = ist.first;
+    sv[STATS_IST_RECV_SEQNO_LAST   ].value._int64  = ist.last;
+    sv[STATS_IST_RECV_SEQNO_CURRENT].value._int64  = ist.current;
+    sv[STATS_IST_RECV_BYTES        ].value._int64  = ist.bytes;
+    sv[STATS_IST_RECV_RATE         ].value._double = ist.rate;
+    sv[STATS_IST_RECV_ETA          ].value._double = ist.eta;
+    sv[STATS_IST_RECV_QUEUE        ].value._int64  = ist.queue;
+
+    ist = ist::Stats();
+    int const senders(const_cast<ist::AsyncSenderMap&>(ist_senders_).
+                      stats_get(ist));
+
+    sv[STATS_IST_SEND_ACTIVE       ].value._int64  = senders;
+    sv[STATS_IST_SEND_SEQNO_FIRST  ].value._int64  = ist.first;
+    sv[STATS_IST_SEND_SEQNO_LAST   ].value._int64  = ist.last;
+    sv[STATS_IST_SEND_SEQNO_CURRENT].value._int64  = ist.current;
+    sv[STATS_IST_SEND_BYTES        ].value._int64  = ist.bytes;
+    sv[STATS_IST_SEND_RATE         ].value._double = ist.rate;
+    sv[STATS_IST_SEND_ETA          ].value._double = ist.eta;
+
+    // latencies in seconds, stays 0 unless repl.latency_stats is on
+    for (int i(0); i < LAT_MAX; ++i)
+    {
+        const gu::Histogram& h(latency_[i]);
+        struct wsrep_stats_var* const v(&sv[STATS_LATENCY_FIRST + 4*i]);
+
+        v[0].value._double = h.mean()            / 1.0e9;
+        v[1].value._double = h.percentile(50.0)  / 1.0e9;
+        v[2].value._double = h.percentile(99.0)  / 1.0e9;
+        v[3].value._double = h.percentile(99.9)  / 1.0e9;
+    }
+
+    // memory held by subsystems, bytes
+    for (int i(0); i < gu::MemStats::TAG_MAX; ++i)
+    {
+        sv[STATS_MEM_FIRST + i].value._int64 =
+            gu::MemStats::get(static_cast<gu::MemStats::Tag>(i));
+    }
 
     double oooe;
     double oool;
@@ -238,6 +621,11 @@ galera::ReplicatorSMM::stats_get() const
     sv[STATS_APPLY_OOOL          ].value._double = oool;
     sv[STATS_APPLY_WINDOW        ].value._double = win;
 
+    // 0 until some write sets are received
+    sv[STATS_APPLIER_RECOMMENDED ].value._int64 =
+        applier_advisor_.update(gcs_as_.received(), avg_deps_dist,
+                                stats.recv_q_len_avg, win);
+
     const_cast<Monitor<CommitOrder>&>(commit_monitor_).
         get_stats(&oooe, &oool, &win);
 
@@ -250,100 +638,137 @@ galera::ReplicatorSMM::stats_get() const
     sv[STATS_LOCAL_STATE_COMMENT ].value._string = state2stats_str(state_(),
                                                                    sst_state_);
     sv[STATS_CAUSAL_READS].value._int64    = causal_reads_();
-
-    // Get gcs backend status
-    gu::Status status;
-    gcs_.get_status(status);
-#ifdef GU_DBUG_ON
-    status.insert("debug_sync_waiters", gu_debug_sync_waiters());
-#endif // GU_DBUG_ON
-
-    // Dynamical strings are copied into buffer allocated after stats var array.
-    // Compute space needed.
-    size_t tail_size(0);
-    for (gu::Status::const_iterator i(status.begin()); i != status.end(); ++i)
+    sv[STATS_CAUSAL_READS_BOUNDED].value._int64 = causal_reads_bounded_();
+
+    // Initial tail_buf position
+    char* tail_buf(reinterpret_cast<char*>(sv + sv_size));
+
+    // Assign hot keys
+    strncpy(tail_buf, hot_keys.c_str(), hot_keys.size() + 1);
+    sv[STATS_CERT_HOT_KEYS].value._string = tail_buf;
+    tail_buf += hot_keys.size() + 1;
+
+    strncpy(tail_buf, conflict_keys.c_str(), conflict_keys.size() + 1);
+    sv[STATS_CERT_CONFLICT_KEYS].value._string = tail_buf;
+    tail_buf += conflict_keys.size() + 1;
+
+    // stays empty unless repl.latency_stats is on
+    strncpy(tail_buf, repl_lag.c_str(), repl_lag.size() + 1);
+    sv[STATS_REPL_LAG].value._string = tail_buf;
+    tail_buf += repl_lag.size() + 1;
+
+    // Assign incoming list
+    strncpy(tail_buf, incoming.c_str(), incoming.size() + 1);
+    sv[STATS_INCOMING_LIST].value._string = tail_buf;
+    tail_buf += incoming.size() + 1;
+
+    // Iterate over dynamical status variables and assing strings
+    size_t sv_pos(STATS_INCOMING_LIST + 1);
+    for (gu::Status::const_iterator i(status.begin());
+         i != status.end(); ++i, ++sv_pos)
     {
-        tail_size += i->first.size() + 1 + i->second.size() + 1;
+        // Name
+        strncpy(tail_buf, i->first.c_str(), i->first.size() + 1);
+        sv[sv_pos].name = tail_buf;
+        tail_buf += i->first.size() + 1;
+        // Type
+        sv[sv_pos].type = WSREP_VAR_STRING;
+        // Value
+        strncpy(tail_buf, i->second.c_str(), i->second.size() + 1);
+        sv[sv_pos].value._string = tail_buf;
+        tail_buf += i->second.size() + 1;
     }
 
-    gu::Lock lock_inc(incoming_mutex_);
-    tail_size += incoming_list_.size() + 1;
+    assert(sv_pos == sv_size - 1);
 
-    /* Create a buffer to be passed to the caller. */
-    // The buffer size needed:
-    // * Space for wsrep_stats_ array
-    // * Space for additional elements from status map
-    // * Trailing space for string store
-    size_t const vec_size(
-        (sv.size() + status.size())*sizeof(struct wsrep_stats_var));
-    struct wsrep_stats_var* const buf(static_cast<struct wsrep_stats_var*>(
-                                      gu_malloc(vec_size + tail_size)));
+    // NULL terminate
+    sv[sv_pos].name = 0;
+    sv[sv_pos].type = WSREP_VAR_STRING;
+    sv[sv_pos].value._string = 0;
 
-    if (buf)
-    {
-        // Resize sv to have enough space for variables from status
-        sv.resize(sv.size() + status.size());
+    assert(static_cast<size_t>(tail_buf - reinterpret_cast<const char*>(sv)) == buf_size);
+    assert(reinterpret_cast<const char*>(sv)[buf_size - 1] == '\0');
 
-        // Initial tail_buf position
-        char* tail_buf(reinterpret_cast<char*>(buf + sv.size()));
+    return sv;
+}
 
-        // Assign incoming list
-        strncpy(tail_buf, incoming_list_.c_str(), incoming_list_.size() + 1);
-        sv[STATS_INCOMING_LIST].value._string = tail_buf;
-        tail_buf += incoming_list_.size() + 1;
+void
+galera::ReplicatorSMM::stats_reset()
+{
+    if (S_DESTROYED == state_()) return;
 
-        // Iterate over dynamical status variables and assing strings
-        size_t sv_pos(STATS_INCOMING_LIST + 1);
-        for (gu::Status::const_iterator i(status.begin());
-             i != status.end(); ++i, ++sv_pos)
-        {
-            // Name
-            strncpy(tail_buf, i->first.c_str(), i->first.size() + 1);
-            sv[sv_pos].name = tail_buf;
-            tail_buf += i->first.size() + 1;
-            // Type
-            sv[sv_pos].type = WSREP_VAR_STRING;
-            // Value
-            strncpy(tail_buf, i->second.c_str(), i->second.size() + 1);
-            sv[sv_pos].value._string = tail_buf;
-            tail_buf += i->second.size() + 1;
-        }
+    gcs_.flush_stats ();
 
-        assert(sv_pos == sv.size() - 1);
+    apply_monitor_.flush_stats();
 
-        // NULL terminate
-        sv[sv_pos].name = 0;
-        sv[sv_pos].type = WSREP_VAR_STRING;
-        sv[sv_pos].value._string = 0;
+    commit_monitor_.flush_stats();
 
-        assert(static_cast<size_t>(tail_buf - reinterpret_cast<const char*>(buf)) == vec_size + tail_size);
-        assert(reinterpret_cast<const char*>(buf)[vec_size + tail_size - 1] == '\0');
-        // Finally copy sv vector to buf
-        memcpy(buf, &sv[0], vec_size);
-    }
-    else
-    {
-        log_warn << "Failed to allocate stats vars buffer to "
-                 << (vec_size + tail_size)
-                 << " bytes. System is running out of memory.";
+    cert_.stats_reset();
 
-    }
+    for (int i(0); i < LAT_MAX; ++i) latency_[i].clear();
 
-    return buf;
+    repl_lag_.clear();
 }
 
 void
-galera::ReplicatorSMM::stats_reset()
+galera::ReplicatorSMM::record_latency_stages(const TrxHandle& trx)
 {
-    if (S_DESTROYED == state_()) return;
+    static TrxHandle::Stage const from[LAT_MAX] =
+    {
+        TrxHandle::T_REPLICATE,     // LAT_REPL
+        TrxHandle::T_ORDERED,       // LAT_LOCAL_WAIT
+        TrxHandle::T_LOCAL_ORDER,   // LAT_CERT
+        TrxHandle::T_CERTIFIED,     // LAT_APPLY_WAIT
+        TrxHandle::T_APPLY_ORDER,   // LAT_APPLY
+        TrxHandle::T_COMMIT_ORDER,  // LAT_COMMIT
+        TrxHandle::T_MAX            // LAT_TOTAL: first stamp set
+    };
+
+    static TrxHandle::Stage const to[LAT_MAX] =
+    {
+        TrxHandle::T_ORDERED,
+        TrxHandle::T_LOCAL_ORDER,
+        TrxHandle::T_CERTIFIED,
+        TrxHandle::T_APPLY_ORDER,
+        TrxHandle::T_COMMIT_ORDER,
+        TrxHandle::T_COMMITTED,
+        TrxHandle::T_COMMITTED
+    };
+
+    /* stamps could be missing if stats were enabled in the middle of trx
+     * processing or some stage was skipped (slave trx, commit order bypass),
+     * such intervals are not recorded */
+    long long first(0);
+    for (int s(0); s < TrxHandle::T_MAX && 0 == first; ++s)
+    {
+        first = trx.stamp_of(static_cast<TrxHandle::Stage>(s));
+    }
 
-    gcs_.flush_stats ();
+    for (int i(0); i < LAT_MAX; ++i)
+    {
+        long long const t0(from[i] != TrxHandle::T_MAX ?
+                           trx.stamp_of(from[i]) : first);
+        long long const t1(trx.stamp_of(to[i]));
 
-    apply_monitor_.flush_stats();
+        if (t0 > 0 && t1 >= t0) latency_[i].insert_ns(t1 - t0);
+    }
 
-    commit_monitor_.flush_stats();
+    if (!trx.is_local())
+    {
+        /* stamps are not calendar time, shift them by the current
+         * difference of the clocks */
+        long long const shift(gu_time_calendar() - gu_time_fast());
+        long long t[ReplLag::LAG_MAX] =
+        {
+            trx.stamp_of(TrxHandle::T_ORDERED),
+            trx.stamp_of(TrxHandle::T_COMMIT_ORDER),
+            trx.stamp_of(TrxHandle::T_COMMITTED)
+        };
 
-    cert_.stats_reset();
+        for (int i(0); i < ReplLag::LAG_MAX; ++i) if (t[i] > 0) t[i] += shift;
+
+        repl_lag_.record(trx.source_id(), trx.timestamp(), t);
+    }
 }
 
 void
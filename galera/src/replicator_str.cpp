@@ -333,6 +333,52 @@ ReplicatorSMM::donate_sst(void* const         recv_ctx,
     return ret;
 }
 
+void
+ReplicatorSMM::send_ist_share(const void* const req, size_t const req_size,
+                              int const share, int const donors)
+{
+    StateRequest* const streq(read_state_request(req, req_size));
+
+    if (streq->ist_len())
+    {
+        IST_request istr;
+        get_ist_request(streq, &istr);
+
+        if (istr.uuid() == state_uuid_)
+        {
+            log_info << "IST request: " << istr << ", sending share "
+                     << share << '/' << donors;
+
+            try
+            {
+                gcache_.seqno_lock(istr.last_applied() + 1);
+                ist_senders_.run(config_,
+                                 istr.peer(),
+                                 istr.last_applied() + 1,
+                                 cc_seqno_,
+                                 protocol_version_,
+                                 share, donors);
+            }
+            catch (gu::NotFound& nf)
+            {
+                log_error << "IST first seqno " << istr.last_applied() + 1
+                          << " not found from cache, can't send IST share";
+            }
+            catch (gu::Exception& e)
+            {
+                log_error << "IST share failed: " << e.what();
+            }
+        }
+        else
+        {
+            log_error << "IST request " << istr << " does not match history "
+                      << state_uuid_ << ", can't send IST share";
+        }
+    }
+
+    delete streq;
+}
+
 void ReplicatorSMM::process_state_req(void*       recv_ctx,
                                       const void* req,
                                       size_t      req_size,
@@ -345,6 +391,19 @@ void ReplicatorSMM::process_state_req(void*       recv_ctx,
 
     LocalOrder lo(seqno_l);
 
+    ssize_t   len(req_size);
+    int       share;
+    int const donors(gcs_state_req_split(&req, &len, &share));
+    req_size = len;
+
+    if (share > 0) // IST helper, the donor is someone else
+    {
+        gu_trace(local_monitor_.enter(lo));
+        send_ist_share(req, req_size, share, donors);
+        local_monitor_.leave(lo);
+        return;
+    }
+
     gu_trace(local_monitor_.enter(lo));
     apply_monitor_.drain(donor_seq);
 
@@ -423,7 +482,8 @@ void ReplicatorSMM::process_state_req(void*       recv_ctx,
                                          istr.peer(),
                                          istr.last_applied() + 1,
                                          cc_seqno_,
-                                         protocol_version_);
+                                         protocol_version_,
+                                         0, donors);
                     }
                     catch (gu::Exception& e)
                     {
@@ -525,6 +585,7 @@ ReplicatorSMM::prepare_state_request (const void* const   sst_req,
             return new StateRequest_v0 (sst_req, sst_req_len);
         case 1:
         case 2:
+        case 3:
         {
             void*   ist_req(0);
             ssize_t ist_req_len(0);
@@ -592,7 +653,8 @@ ReplicatorSMM::send_state_request (const StateRequest* const req)
 
         ret = gcs_.request_state_transfer(str_proto_ver_,
                                           req->req(), req->len(), sst_donor_,
-                                          ist_uuid, ist_seqno, &seqno_l);
+                                          ist_uuid, ist_seqno,
+                                          ist_receiver_.donors(), &seqno_l);
         if (ret < 0)
         {
             if (!retry_str(ret))
@@ -766,6 +828,11 @@ ReplicatorSMM::request_state_transfer (void* recv_ctx,
 }
 
 
+/* Runs in the thread that requested state transfer as well as in every
+ * other slave thread that got its GCS action queue canceled by the
+ * configuration change (see async_recv()). Trxs are handed out in seqno order,
+ * but apply_trx() lets them run in parallel according to their dependencies,
+ * so IST is applied concurrently with receiving. */
 void ReplicatorSMM::recv_IST(void* recv_ctx)
 {
     while (true)
@@ -797,6 +864,7 @@ void ReplicatorSMM::recv_IST(void* recv_ctx)
                     // processed on donor, just adjust states here
                     trx->set_state(TrxHandle::S_REPLICATING);
                     trx->set_state(TrxHandle::S_CERTIFYING);
+                    prefetch(recv_ctx, trx);
                     apply_trx(recv_ctx, trx);
                     GU_DBUG_SYNC_WAIT("recv_IST_after_apply_trx");
                 }
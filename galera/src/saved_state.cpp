@@ -4,6 +4,7 @@
 
 #include "saved_state.hpp"
 #include "gu_dbug.h"
+#include "gu_datetime.hpp"
 #include "uuid.hpp"
 
 #include <fstream>
@@ -27,11 +28,19 @@ SavedState::SavedState  (const std::string& file) :
     unsafe_       (0),
     corrupt_      (false),
     mtx_          (),
+    cond_         (),
     written_uuid_ (uuid_),
+    written_seqno_(seqno_),
+    written_safe_to_bootstrap_(safe_to_bootstrap_),
     current_len_  (0),
     total_marks_  (0),
     total_locks_  (0),
-    total_writes_ (0)
+    total_writes_ (0),
+    total_deferred_(0),
+    writer_       (),
+    writer_started_(false),
+    writer_stop_  (false),
+    pending_      (false)
 {
 
     GU_DBUG_EXECUTE("galera_init_invalidate_state",
@@ -124,7 +133,9 @@ SavedState::SavedState  (const std::string& file) :
     }
 #endif
 
-    written_uuid_ = uuid_;
+    written_uuid_  = uuid_;
+    written_seqno_ = seqno_;
+    written_safe_to_bootstrap_ = safe_to_bootstrap_;
 
     current_len_ = ftell (fs_);
     log_debug << "Initialized current_len_ to " << current_len_;
@@ -136,12 +147,27 @@ SavedState::SavedState  (const std::string& file) :
     {
         fs_ = freopen (file.c_str(), "w+", fs_); // truncate
         current_len_ = 0;
-        set (uuid_, seqno_, safe_to_bootstrap_);
+        write_and_flush (uuid_, seqno_, safe_to_bootstrap_);
     }
 }
 
 SavedState::~SavedState ()
 {
+    if (writer_started_)
+    {
+        {
+            gu::Lock lock(mtx_);
+            writer_stop_ = true;
+            cond_.signal();
+        }
+
+        gu_thread_join(writer_, NULL);
+    }
+
+    /* nothing may be left behind at shutdown */
+    if (pending_ && 0 == unsafe_()) write_and_flush(uuid_, seqno_,
+                                                    safe_to_bootstrap_);
+
     if (fs_)
     {
         // Closing file descriptor should release the lock, but still...
@@ -182,7 +208,7 @@ SavedState::set (const wsrep_uuid_t& u, wsrep_seqno_t s, bool safe_to_bootstrap)
     safe_to_bootstrap_ = safe_to_bootstrap;
 
     if (0 == unsafe_())
-        write_and_flush (u, s, safe_to_bootstrap);
+        store (u, s, safe_to_bootstrap);
     else
         log_debug << "Not writing state: unsafe counter is " << unsafe_();
 }
@@ -203,6 +229,8 @@ SavedState::mark_unsafe()
 
         assert (unsafe_() > 0);
 
+        pending_ = false; // anything pending is stale now
+
         if (written_uuid_ != WSREP_UUID_UNDEFINED)
         {
             write_and_flush (WSREP_UUID_UNDEFINED, WSREP_SEQNO_UNDEFINED,
@@ -228,7 +256,7 @@ SavedState::mark_safe()
             assert(false == corrupt_);
             /* this will write down proper seqno if set() was called too early
              * (in unsafe state) */
-            write_and_flush (uuid_, seqno_, safe_to_bootstrap_);
+            store (uuid_, seqno_, safe_to_bootstrap_);
         }
     }
 }
@@ -247,11 +275,112 @@ SavedState::mark_corrupt()
     uuid_  = WSREP_UUID_UNDEFINED;
     seqno_ = WSREP_SEQNO_UNDEFINED;
     corrupt_ = true;
+    pending_ = false;
 
     write_and_flush (WSREP_UUID_UNDEFINED, WSREP_SEQNO_UNDEFINED,
                      safe_to_bootstrap_);
 }
 
+/* Losing a deferred write in a crash must leave the file in a state that is
+ * at least as conservative as the new one: undefined uuid makes the node
+ * request full state transfer anyway, undefined seqno makes it recover
+ * position from the storage engine, and safe_to_bootstrap may be lost only
+ * when it is being set. */
+bool
+SavedState::can_defer (const wsrep_uuid_t& u, wsrep_seqno_t,
+                       bool const safe_to_bootstrap) const
+{
+    if (written_safe_to_bootstrap_ && !safe_to_bootstrap) return false;
+
+    if (written_uuid_ == WSREP_UUID_UNDEFINED) return true;
+
+    return (written_uuid_ == u && written_seqno_ < 0);
+}
+
+/* 100ms for state changes to coalesce before the background write */
+static long long const WRITE_DELAY(100 * 1000 * 1000);
+
+void
+SavedState::store (const wsrep_uuid_t& u, wsrep_seqno_t const s,
+                   bool const safe_to_bootstrap)
+{
+    if (written_uuid_ == u && written_seqno_ == s &&
+        written_safe_to_bootstrap_ == safe_to_bootstrap)
+    {
+        pending_ = false;
+        return;
+    }
+
+    if (!can_defer(u, s, safe_to_bootstrap))
+    {
+        write_and_flush (u, s, safe_to_bootstrap);
+        pending_ = false;
+        return;
+    }
+
+    if (gu_unlikely(!writer_started_))
+    {
+        int const err(gu_thread_create(&writer_, NULL, writer_thread, this));
+
+        if (err)
+        {
+            log_warn << "Could not start state file writer: " << err << " ("
+                     << ::strerror(err) << "), writing synchronously";
+            write_and_flush (u, s, safe_to_bootstrap);
+            return;
+        }
+
+        writer_started_ = true;
+    }
+
+    ++total_deferred_;
+
+    if (!pending_)
+    {
+        pending_ = true;
+        cond_.signal();
+    }
+}
+
+void*
+SavedState::writer_thread (void* const arg)
+{
+    static_cast<SavedState*>(arg)->writer_loop();
+    return NULL;
+}
+
+void
+SavedState::writer_loop ()
+{
+    gu::Lock lock(mtx_);
+
+    for (;;)
+    {
+        while (!pending_ && !writer_stop_) lock.wait(cond_);
+
+        if (writer_stop_) break; // destructor writes what is pending
+
+        gu::datetime::Date const until(gu::datetime::Date::calendar()
+                                       + WRITE_DELAY);
+        try { lock.wait(cond_, until); }
+        catch (gu::Exception& e)
+        {
+            if (e.get_errno() != ETIMEDOUT) throw;
+        }
+
+        if (writer_stop_) break;
+
+        /* mark_unsafe() in the meantime clears pending_ and writes the
+         * unsafe state itself */
+        if (pending_ && 0 == unsafe_() && !corrupt_)
+        {
+            write_and_flush (uuid_, seqno_, safe_to_bootstrap_);
+        }
+
+        pending_ = false;
+    }
+}
+
 void
 SavedState::write_and_flush(const wsrep_uuid_t& u, const wsrep_seqno_t s,
                             bool safe_to_bootstrap)
@@ -281,7 +410,9 @@ SavedState::write_and_flush(const wsrep_uuid_t& u, const wsrep_seqno_t s,
         fflush(fs_);
 
         current_len_ = state_len;
-        written_uuid_ = u;
+        written_uuid_  = u;
+        written_seqno_ = s;
+        written_safe_to_bootstrap_ = safe_to_bootstrap;
         ++total_writes_;
     }
     else
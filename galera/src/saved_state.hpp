@@ -8,6 +8,7 @@
 #include "gu_atomic.hpp"
 #include "gu_mutex.hpp"
 #include "gu_lock.hpp"
+#include "gu_threads.h"
 
 #include "wsrep_api.h"
 
@@ -38,6 +39,9 @@ public:
         writes = total_writes_;
     }
 
+    /* writes that were left to the background writer */
+    long deferred() const { return total_deferred_; }
+
 private:
 
     FILE*            fs_;
@@ -50,12 +54,35 @@ private:
     /* this mutex is needed because mark_safe() and mark_corrupt() will be
      * called outside local monitor, so race is possible */
     gu::Mutex        mtx_;
+    gu::Cond         cond_;
     wsrep_uuid_t     written_uuid_;
+    wsrep_seqno_t    written_seqno_;
+    bool             written_safe_to_bootstrap_;
     ssize_t          current_len_;
     gu::Atomic<long> total_marks_;
     long             total_locks_;
     long             total_writes_;
-
+    long             total_deferred_;
+
+    /* Writes which only make the file state less conservative (e.g. marking
+     * it safe again after mark_unsafe()) are left to a background writer:
+     * if they are lost in a crash, the file stays at least as conservative
+     * as the real state. Several of them are coalesced into one write and a
+     * pending one is dropped by mark_unsafe(). All other writes are done in
+     * the caller's context before the call returns. */
+    gu_thread_t      writer_;
+    bool             writer_started_;
+    bool             writer_stop_;
+    bool             pending_;
+
+    static void* writer_thread (void* arg);
+    void writer_loop ();
+
+    // the following must be called under mtx_
+    bool can_defer (const wsrep_uuid_t& u, wsrep_seqno_t s,
+                    bool safe_to_bootstrap) const;
+    void store (const wsrep_uuid_t& u, wsrep_seqno_t s,
+                bool safe_to_bootstrap);
     void write_and_flush (const wsrep_uuid_t& u, const wsrep_seqno_t s,
                           bool safe_to_bootstrap);
 
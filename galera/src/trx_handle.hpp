@@ -32,6 +32,51 @@ namespace galera
     static int const WS_NG_VERSION = WriteSetNG::VER3;
     /* new WS version to be used */
 
+    /*! Conflicting predecessors of a trx as found by certification: trx may
+     *  be applied once all trxs up to and including floor() and all listed
+     *  seqnos are applied. Falls back to depends_seqno gating if invalid. */
+    class TrxDeps
+    {
+    public:
+
+        static int const MAX = 8;
+
+        TrxDeps() : floor_(WSREP_SEQNO_UNDEFINED), size_(-1), seqnos_() {}
+
+        void reset(wsrep_seqno_t floor) { floor_ = floor; size_ = 0; }
+
+        void invalidate() { size_ = -1; }
+
+        void add(wsrep_seqno_t seqno)
+        {
+            if (seqno <= floor_ || size_ < 0) return;
+
+            for (int i(0); i < size_; ++i) if (seqnos_[i] == seqno) return;
+
+            if (size_ < MAX)
+                seqnos_[size_++] = seqno;
+            else
+                size_ = -1; // too many to track
+        }
+
+        void raise_floor(wsrep_seqno_t floor)
+        {
+            if (floor_ < floor) floor_ = floor;
+        }
+
+        bool          valid() const { return size_ >= 0; }
+        wsrep_seqno_t floor() const { return floor_; }
+        int           size()  const { return size_; }
+
+        wsrep_seqno_t operator[](int i) const { return seqnos_[i]; }
+
+    private:
+
+        wsrep_seqno_t floor_;
+        int           size_;
+        wsrep_seqno_t seqnos_[MAX];
+    };
+
     class TrxHandle
     {
     public:
@@ -49,10 +94,20 @@ namespace galera
             int             version_;
             KeySet::Version key_format_;
             int             max_write_set_size_;
+            DataSet::Version data_set_ver_; // VER2 compresses data sets
+            int             compression_level_;
+            gu::RecordSet::CheckType check_type_; // XXH64 proto 9, CRC32C 11
+            long            key_escalation_; // 0 - never
             Params (const std::string& wdir, int ver, KeySet::Version kformat,
-                    int max_write_set_size = WriteSetNG::MAX_SIZE) :
+                    int max_write_set_size = WriteSetNG::MAX_SIZE,
+                    DataSet::Version dver  = DataSet::VER1,
+                    int clevel = DataSet::DEFAULT_COMPRESSION_LEVEL,
+                    gu::RecordSet::CheckType ct = gu::RecordSet::CHECK_MMH128,
+                    long kescal = 0) :
                 working_dir_(wdir), version_(ver), key_format_(kformat),
-                max_write_set_size_(max_write_set_size) {}
+                max_write_set_size_(max_write_set_size),
+                data_set_ver_(dver), compression_level_(clevel),
+                check_type_(ct), key_escalation_(kescal) {}
         };
 
         static const Params Defaults;
@@ -249,6 +304,8 @@ namespace galera
 
         void set_conn_id(wsrep_conn_id_t conn_id) { conn_id_ = conn_id; }
 
+        int64_t timestamp() const { return timestamp_; }
+
         bool is_local()     const { return local_; }
         bool is_certified() const { return certified_; }
 
@@ -324,6 +381,22 @@ namespace galera
         State state() const { return state_(); }
         void set_state(State state) { state_.shift_to(state); }
 
+        /* replication pipeline stages timestamped for latency stats */
+        typedef enum
+        {
+            T_REPLICATE,    // entered replicate()
+            T_ORDERED,      // got total order from GCS
+            T_LOCAL_ORDER,  // entered local monitor
+            T_CERTIFIED,    // certification done
+            T_APPLY_ORDER,  // entered apply monitor
+            T_COMMIT_ORDER, // entered commit monitor
+            T_COMMITTED,    // left commit monitor
+            T_MAX
+        } Stage;
+
+        void      stamp(Stage s) { stamps_[s] = gu_time_fast(); }
+        long long stamp_of(Stage s) const { return stamps_[s]; }
+
         long gcs_handle() const { return gcs_handle_; }
         void set_gcs_handle(long gcs_handle) { gcs_handle_ = gcs_handle; }
 
@@ -337,6 +410,9 @@ namespace galera
 
         wsrep_seqno_t depends_seqno()   const { return depends_seqno_; }
 
+        TrxDeps&       deps()       { return deps_; }
+        const TrxDeps& deps() const { return deps_; }
+
         uint32_t      flags()           const { return write_set_flags_; }
 
         void set_flags(uint32_t flags)
@@ -372,6 +448,65 @@ namespace galera
             }
         }
 
+        /*! Appends an array of keys as passed through wsrep API: version
+         *  check and write set dispatch are done once for the whole array */
+        void append_keys(int const                proto_ver,
+                         const wsrep_key_t* const keys,
+                         size_t const             count,
+                         wsrep_key_type_t const   type,
+                         bool const               copy)
+        {
+            if (proto_ver != version_)
+            {
+                gu_throw_error(EINVAL) << "key version '" << proto_ver
+                                       << "' does not match to trx version' "
+                                       << version_ << "'";
+            }
+
+            if (new_version())
+            {
+                WriteSetOut& wso(write_set_out());
+
+                for (size_t i(0); i < count; ++i)
+                {
+                    wso.append_key(KeyData(proto_ver, keys[i].key_parts,
+                                           keys[i].key_parts_num, type, copy));
+                }
+            }
+            else
+            {
+                for (size_t i(0); i < count; ++i)
+                {
+                    write_set_.append_key(KeyData(proto_ver,
+                                                  keys[i].key_parts,
+                                                  keys[i].key_parts_num,
+                                                  type, copy));
+                }
+            }
+        }
+
+        /*! Appends an array of ordered data buffers, see append_keys() */
+        void append_data(const wsrep_buf_t* const data, size_t const count,
+                         bool const store)
+        {
+            if (new_version())
+            {
+                WriteSetOut& wso(write_set_out());
+
+                for (size_t i(0); i < count; ++i)
+                {
+                    wso.append_data(data[i].ptr, data[i].len, store);
+                }
+            }
+            else
+            {
+                for (size_t i(0); i < count; ++i)
+                {
+                    write_set_.append_data(data[i].ptr, data[i].len);
+                }
+            }
+        }
+
         void append_data(const void* data, const size_t data_len,
                          wsrep_data_type_t type, bool store)
         {
@@ -593,10 +728,10 @@ namespace galera
                 return serial_size();
         }
 
-        void update_stats(gu::Atomic<long long>& kc,
-                          gu::Atomic<long long>& kb,
-                          gu::Atomic<long long>& db,
-                          gu::Atomic<long long>& ub)
+        void update_stats(gu::PerCpuCounter& kc,
+                          gu::PerCpuCounter& kb,
+                          gu::PerCpuCounter& db,
+                          gu::PerCpuCounter& ub)
         {
             assert(new_version());
             kc += write_set_in_.keyset().count();
@@ -617,7 +752,10 @@ namespace galera
 
         size_t serial_size() const;
         size_t serialize  (gu::byte_t* buf, size_t buflen, size_t offset) const;
-        size_t unserialize(const gu::byte_t* buf, size_t buflen, size_t offset);
+        /* verify = false skips write set checksum, only for buffers that
+         * have never left this node */
+        size_t unserialize(const gu::byte_t* buf, size_t buflen, size_t offset,
+                           bool verify = true);
 
         void release_write_set_out()
         {
@@ -637,33 +775,37 @@ namespace galera
         explicit
         TrxHandle(gu::MemPool<true>& mp)
             :
+            local_seqno_       (WSREP_SEQNO_UNDEFINED),
+            global_seqno_      (WSREP_SEQNO_UNDEFINED),
+            last_seen_seqno_   (WSREP_SEQNO_UNDEFINED),
+            depends_seqno_     (WSREP_SEQNO_UNDEFINED),
+            refcnt_            (1),
+            write_set_flags_   (0),
+            version_           (Defaults.version_),
+            local_             (false),
+            certified_         (false),
+            committed_         (false),
+            exit_loop_         (false),
+            wso_               (false),
             source_id_         (WSREP_UUID_UNDEFINED),
             conn_id_           (-1),
             trx_id_            (-1),
             mutex_             (),
             write_set_collection_(Defaults.working_dir_),
             state_             (&trans_map_, S_EXECUTING),
-            local_seqno_       (WSREP_SEQNO_UNDEFINED),
-            global_seqno_      (WSREP_SEQNO_UNDEFINED),
-            last_seen_seqno_   (WSREP_SEQNO_UNDEFINED),
-            depends_seqno_     (WSREP_SEQNO_UNDEFINED),
+            deps_              (),
             timestamp_         (),
+            stamps_            (),
             write_set_         (Defaults.version_),
             write_set_in_      (),
             annotation_        (),
             cert_keys_         (),
+            cert_parts_        (),
+            cert_shards_       (0),
             write_set_buffer_  (0, 0),
             mem_pool_          (mp),
             action_            (0),
             gcs_handle_        (-1),
-            version_           (Defaults.version_),
-            refcnt_            (1),
-            write_set_flags_   (0),
-            local_             (false),
-            certified_         (false),
-            committed_         (false),
-            exit_loop_         (false),
-            wso_               (false),
             mac_               ()
         {}
 
@@ -676,33 +818,37 @@ namespace galera
                   gu::byte_t*         reserved,
                   size_t              reserved_size)
             :
+            local_seqno_       (WSREP_SEQNO_UNDEFINED),
+            global_seqno_      (WSREP_SEQNO_UNDEFINED),
+            last_seen_seqno_   (WSREP_SEQNO_UNDEFINED),
+            depends_seqno_     (WSREP_SEQNO_UNDEFINED),
+            refcnt_            (1),
+            write_set_flags_   (0),
+            version_           (params.version_),
+            local_             (true),
+            certified_         (false),
+            committed_         (false),
+            exit_loop_         (false),
+            wso_               (new_version()),
             source_id_         (source_id),
             conn_id_           (conn_id),
             trx_id_            (trx_id),
             mutex_             (),
             write_set_collection_(params.working_dir_),
             state_             (&trans_map_, S_EXECUTING),
-            local_seqno_       (WSREP_SEQNO_UNDEFINED),
-            global_seqno_      (WSREP_SEQNO_UNDEFINED),
-            last_seen_seqno_   (WSREP_SEQNO_UNDEFINED),
-            depends_seqno_     (WSREP_SEQNO_UNDEFINED),
+            deps_              (),
             timestamp_         (gu_time_calendar()),
+            stamps_            (),
             write_set_         (params.version_),
             write_set_in_      (),
             annotation_        (),
             cert_keys_         (),
+            cert_parts_        (),
+            cert_shards_       (0),
             write_set_buffer_  (0, 0),
             mem_pool_          (mp),
             action_            (0),
             gcs_handle_        (-1),
-            version_           (params.version_),
-            refcnt_            (1),
-            write_set_flags_   (0),
-            local_             (true),
-            certified_         (false),
-            committed_         (false),
-            exit_loop_         (false),
-            wso_               (new_version()),
             mac_               ()
         {
             init_write_set_out(params, reserved, reserved_size);
@@ -729,30 +875,53 @@ namespace galera
                                        store_size - sizeof(WriteSetOut),
                                        0,
                                        WriteSetNG::MAX_VERSION,
-                                       DataSet::MAX_VERSION,
-                                       DataSet::MAX_VERSION,
-                                       params.max_write_set_size_);
+                                       params.data_set_ver_,
+                                       params.data_set_ver_,
+                                       params.max_write_set_size_,
+                                       params.compression_level_,
+                                       params.check_type_);
+
+                wso->set_key_escalation(params.key_escalation_);
             }
         }
 
         TrxHandle(const TrxHandle&);
         void operator=(const TrxHandle& other);
 
+        /* Hot fields: read by certification and monitors for every trx.
+         * Kept together at the start of the object (which is cache line
+         * aligned by the pool) to fit in a single cache line. */
+        wsrep_seqno_t          local_seqno_;
+        wsrep_seqno_t          global_seqno_;
+        wsrep_seqno_t          last_seen_seqno_;
+        wsrep_seqno_t          depends_seqno_;
+        gu::Atomic<int>        refcnt_;
+        uint32_t               write_set_flags_;
+        int                    version_;
+        bool                   local_;
+        bool                   certified_;
+        bool                   committed_;
+        bool                   exit_loop_;
+        bool                   wso_;
+        /* end of hot fields */
+
         wsrep_uuid_t           source_id_;
         wsrep_conn_id_t        conn_id_;
         wsrep_trx_id_t         trx_id_;
         mutable gu::Mutex      mutex_;
         MappedBuffer           write_set_collection_;
         FSM<State, Transition> state_;
-        wsrep_seqno_t          local_seqno_;
-        wsrep_seqno_t          global_seqno_;
-        wsrep_seqno_t          last_seen_seqno_;
-        wsrep_seqno_t          depends_seqno_;
+        TrxDeps                deps_;
         int64_t                timestamp_;
+        long long              stamps_[T_MAX]; // gu_time_fast(), 0 if not set
         WriteSet               write_set_;
         WriteSetIn             write_set_in_;
         gu::Buffer             annotation_;
         CertKeySet             cert_keys_;
+        /* v3 key parts and index shards they map to, cached by
+         * Certification::prepare() */
+        gu::Vector<KeySet::KeyPart, 16> cert_parts_;
+        unsigned int           cert_shards_;
 
         // Write set buffer location if stored outside TrxHandle.
         std::pair<const gu::byte_t*, size_t> write_set_buffer_;
@@ -760,14 +929,6 @@ namespace galera
         gu::MemPool<true>&     mem_pool_;
         const void*            action_;
         long                   gcs_handle_;
-        int                    version_;
-        gu::Atomic<int>        refcnt_;
-        uint32_t               write_set_flags_;
-        bool                   local_;
-        bool                   certified_;
-        bool                   committed_;
-        bool                   exit_loop_;
-        bool                   wso_;
         Mac                    mac_;
 
         friend class Wsdb;
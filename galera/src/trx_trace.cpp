@@ -0,0 +1,88 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "trx_trace.hpp"
+
+#include <gu_lock.hpp>
+
+#include <algorithm> // std::max()
+
+galera::TrxTrace::TrxTrace(size_t const size)
+    :
+    mtx_      (),
+    ring_     (std::max(size, size_t(1))),
+    next_     (0),
+    count_    (0),
+    sample_   (0),
+    threshold_(0)
+{}
+
+void
+galera::TrxTrace::record(const TrxHandle& trx)
+{
+    long long first(0);
+    for (int s(0); s < TrxHandle::T_MAX && 0 == first; ++s)
+    {
+        first = trx.stamp_of(static_cast<TrxHandle::Stage>(s));
+    }
+
+    long long const last(trx.stamp_of(TrxHandle::T_COMMITTED));
+    long const      sample(sample_);
+    long long const threshold(threshold_);
+
+    bool const sampled(sample > 0 && trx.global_seqno() % sample == 0);
+    bool const slow(threshold > 0 && first > 0 && last - first > threshold);
+
+    if (!sampled && !slow) return;
+
+    gu::Lock lock(mtx_);
+
+    Record& r(ring_[next_]);
+
+    r.seqno_  = trx.global_seqno();
+    r.trx_id_ = trx.trx_id();
+    r.local_  = trx.is_local();
+    for (int s(0); s < TrxHandle::T_MAX; ++s)
+    {
+        r.stamps_[s] = trx.stamp_of(static_cast<TrxHandle::Stage>(s));
+    }
+
+    next_  = (next_ + 1) % ring_.size();
+    count_ = std::min(count_ + 1, ring_.size());
+}
+
+void
+galera::TrxTrace::print(std::ostream& os) const
+{
+    static const char* const stage_str[TrxHandle::T_MAX] =
+    {
+        "repl", "ordered", "local", "cert", "apply", "commit", "committed"
+    };
+
+    gu::Lock lock(mtx_);
+
+    os << count_ << " trx timelines, us since the first stage";
+
+    size_t const first((next_ + ring_.size() - count_) % ring_.size());
+
+    for (size_t i(0); i < count_; ++i)
+    {
+        const Record& r(ring_[(first + i) % ring_.size()]);
+
+        long long t0(0);
+        for (int s(0); s < TrxHandle::T_MAX && 0 == t0; ++s) t0 = r.stamps_[s];
+
+        os << "\nseqno: " << r.seqno_ << ", trx: " << r.trx_id_
+           << (r.local_ ? ", local" : ", slave");
+
+        for (int s(0); s < TrxHandle::T_MAX; ++s)
+        {
+            if (r.stamps_[s] > 0)
+            {
+                os << ", " << stage_str[s] << ": "
+                   << (r.stamps_[s] - t0) / 1000;
+            }
+        }
+    }
+}
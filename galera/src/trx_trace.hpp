@@ -0,0 +1,68 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#ifndef GALERA_TRX_TRACE_HPP
+#define GALERA_TRX_TRACE_HPP
+
+#include "trx_handle.hpp"
+
+#include <gu_mutex.hpp>
+
+#include <ostream>
+#include <vector>
+
+namespace galera
+{
+    /*!
+     * Ring buffer of pipeline timelines of recent transactions, built from
+     * TrxHandle stage stamps. Records every trx whose global seqno is
+     * a multiple of the sampling rate and every trx that took longer than
+     * the threshold from the first stamp to commit.
+     */
+    class TrxTrace
+    {
+    public:
+
+        explicit TrxTrace(size_t size);
+
+        /*! record every n-th trx, 0 - off */
+        void set_sample(long n) { sample_ = n; }
+
+        /*! record trxs slower than this, 0 - off */
+        void set_threshold(long long nsecs) { threshold_ = nsecs; }
+
+        bool enabled() const { return (sample_ > 0 || threshold_ > 0); }
+
+        /*! records trx timeline if trx is sampled or slow */
+        void record(const TrxHandle& trx);
+
+        /*! prints recorded timelines, oldest first, one trx per line */
+        void print(std::ostream& os) const;
+
+    private:
+
+        struct Record
+        {
+            wsrep_seqno_t  seqno_;
+            wsrep_trx_id_t trx_id_;
+            bool           local_;
+            long long      stamps_[TrxHandle::T_MAX];
+        };
+
+        gu::Mutex           mtx_;
+        std::vector<Record> ring_;
+        size_t              next_;  // next slot to write
+        size_t              count_; // number of valid records
+        long                sample_;
+        long long           threshold_; // nanoseconds
+    };
+
+    inline std::ostream&
+    operator << (std::ostream& os, const TrxTrace& tt)
+    {
+        tt.print(os); return os;
+    }
+}
+
+#endif // GALERA_TRX_TRACE_HPP
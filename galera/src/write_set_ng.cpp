@@ -107,7 +107,7 @@ WriteSetNG::Header::set_last_seen(const wsrep_seqno_t& last_seen)
     uint64_t*   const ts  (reinterpret_cast<uint64_t*>(ptr_ +V3_TIMESTAMP_OFF));
 
     *ls = gu::htog<uint64_t>(last_seen);
-    *ts = gu::htog<uint64_t>(gu_time_monotonic());
+    *ts = gu::htog<uint64_t>(gu_time_calendar());
 
     update_checksum (ptr_, size() - V3_CHECKSUM_SIZE);
 }
@@ -189,105 +189,132 @@ const char WriteSetOut::annt_suffix[] = "_annt";
 void
 WriteSetIn::init (ssize_t const st)
 {
-    assert(false == check_thr_);
+    assert(NULL == check_jobs_);
+    assert(false == parsed_);
+    assert(false == check_);
 
-    const gu::byte_t* const pptr (header_.payload());
-    ssize_t           const psize(size_ - header_.size());
+    assert (size_ - header_.size() >= 0);
 
-    assert (psize >= 0);
-
-    KeySet::Version const kver(header_.keyset_ver());
-
-    if (kver != KeySet::EMPTY) gu_trace(keys_.init (kver, pptr, psize));
-
-    assert (false == check_);
-    assert (false == check_thr_);
+    /* for now nothing has failed */
+    check_ = true;
 
     if (gu_likely(st > 0)) /* checksum enforced */
     {
         if (size_ >= st)
         {
-            /* buffer too big, start checksumming in background */
-            int const err(gu_thread_create (&check_thr_id_, NULL,
-                                            checksum_thread, this));
+            /* buffer too big, checksum record sets in parallel in the
+             * background, sets are verified independently */
+            init_sets();
 
-            if (gu_likely(0 == err))
-            {
-                check_thr_ = true;
-                return;
-            }
-
-            log_warn << "Starting checksum thread failed: " << err
-                     << '(' << ::strerror(err) << ')';
-
-            /* fall through to checksum in foreground */
+            if (gu_likely(check_submit())) return;
         }
 
-        checksum();
-        checksum_fin();
-    }
-    else /* checksum skipped, pretend it's alright */
-    {
-        check_ = true;
+        /* checksum sections on first access or in verify_checksum() */
+        unchecked_ = CHECK_ALL;
     }
+    /* else checksum skipped, pretend it's alright */
 }
 
 
 void
-WriteSetIn::checksum()
+WriteSetIn::init_sets() const
 {
+    assert (!parsed_);
+
     const gu::byte_t* pptr (header_.payload());
     ssize_t           psize(size_ - header_.size());
 
     assert (psize >= 0);
 
-    try
+    KeySet::Version const kver(header_.keyset_ver());
+
+    if (kver != KeySet::EMPTY)
     {
-        if (keys_.size() > 0)
-        {
-            gu_trace(keys_.checksum());
-            psize -= keys_.size();
-            assert (psize >= 0);
-            pptr  += keys_.size();
-        }
+        gu_trace(keys_.init (kver, pptr, psize));
+        psize -= keys_.size();
+        assert (psize >= 0);
+        pptr  += keys_.size();
+    }
 
-        DataSet::Version const dver(header_.dataset_ver());
+    DataSet::Version const dver(header_.dataset_ver());
 
-        if (gu_likely(dver != DataSet::EMPTY))
+    if (gu_likely(dver != DataSet::EMPTY))
+    {
+        assert (psize > 0);
+        gu_trace(data_.init(dver, pptr, psize));
+        size_t tmpsize(data_.size());
+        psize -= tmpsize;
+        pptr  += tmpsize;
+        assert (psize >= 0);
+
+        if (header_.has_unrd())
         {
-            assert (psize > 0);
-            gu_trace(data_.init(dver, pptr, psize));
-            gu_trace(data_.checksum());
-            size_t tmpsize(data_.size());
+            gu_trace(unrd_.init(dver, pptr, psize));
+            size_t tmpsize(unrd_.size());
             psize -= tmpsize;
             pptr  += tmpsize;
-            assert (psize >= 0);
-
-            if (header_.has_unrd())
-            {
-                gu_trace(unrd_.init(dver, pptr, psize));
-                gu_trace(unrd_.checksum());
-                size_t tmpsize(unrd_.size());
-                psize -= tmpsize;
-                pptr  += tmpsize;
-            }
-
-            if (header_.has_annt())
-            {
-                annt_ = new DataSetIn();
-                gu_trace(annt_->init(dver, pptr, psize));
-                // we don't care for annotation checksum - it is not a reason
-                // to throw an exception and abort execution
-                // gu_trace(annt_->checksum());
+        }
+
+        if (header_.has_annt())
+        {
+            annt_ = new DataSetIn();
+            gu_trace(annt_->init(dver, pptr, psize));
+            // we don't care for annotation checksum - it is not a reason
+            // to throw an exception and abort execution
 #ifndef NDEBUG
-                psize -= annt_->size();
+            psize -= annt_->size();
 #endif
-            }
         }
+    }
 #ifndef NDEBUG
-        assert (psize == 0);
+    assert (psize == 0);
 #endif
-        check_ = true;
+
+    parsed_ = true;
+}
+
+
+void
+WriteSetIn::checksum(int const s) const
+{
+    assert (parsed_);
+
+    const gu::RecordSetInBase* const sets[CHECK_JOBS] =
+        { &keys_, &data_, &unrd_ };
+
+    for (int i(0); i < CHECK_JOBS; ++i)
+    {
+        if (!(s & (1 << i))) continue;
+
+        unchecked_ &= ~(1 << i);
+
+        if (0 == sets[i]->size()) continue; // nothing to verify
+
+        try
+        {
+            sets[i]->checksum();
+        }
+        catch (std::exception& e)
+        {
+            log_error << e.what();
+            check_ = false;
+        }
+        catch (...)
+        {
+            log_error << "Non-standard exception in WriteSet::checksum()";
+            check_ = false;
+        }
+    }
+}
+
+
+void
+WriteSetIn::CheckJob::run()
+{
+    try
+    {
+        set_->checksum();
+        ok_ = true;
     }
     catch (std::exception& e)
     {
@@ -300,9 +327,56 @@ WriteSetIn::checksum()
 }
 
 
+bool
+WriteSetIn::check_submit()
+{
+    const gu::RecordSetInBase* const sets[CHECK_JOBS] =
+        { &keys_, &data_, &unrd_ };
+
+    gu::ThreadPool& pool(gu::ThreadPool::checksum_pool());
+
+    if (gu_unlikely(0 == pool.threads())) return false;
+
+    check_jobs_ = new CheckJob[CHECK_JOBS];
+
+    for (int i(0); i < CHECK_JOBS; ++i)
+    {
+        if (0 == sets[i]->size()) continue; // nothing to verify
+
+        check_jobs_[i].set(*sets[i]);
+
+        bool const ok(pool.submit(check_jobs_[i]));
+        assert(ok); (void)ok; // can fail only if pool has no threads
+    }
+
+    return true;
+}
+
+
+bool
+WriteSetIn::check_wait() const
+{
+    assert(check_jobs_ != NULL);
+
+    bool ret(true);
+
+    for (int i(0); i < CHECK_JOBS; ++i)
+    {
+        check_jobs_[i].wait();
+        ret = ret && check_jobs_[i].ok();
+    }
+
+    delete[] check_jobs_;
+    check_jobs_ = NULL;
+
+    return ret;
+}
+
+
 void
 WriteSetIn::write_annotation(std::ostream& os) const
 {
+    section(0);
     annt_->rewind();
     ssize_t const count(annt_->count());
 
@@ -326,6 +400,8 @@ WriteSetIn::gather(GatherVector& out,
     }
     else
     {
+        section(0);
+
         out->reserve(out->size() + 4);
 
         gu::Buf buf(header_.copy(include_keys, include_unrd));
@@ -25,7 +25,7 @@
 #include <string>
 #include <iomanip>
 
-#include <gu_threads.h>
+#include <gu_thread_pool.hpp>
 
 namespace galera
 {
@@ -260,6 +260,7 @@ namespace galera
                 return seqno_priv();
             }
 
+            /* calendar time in ns when the write set was sent */
             long long        timestamp() const
             {
                 return gu::gtoh(
@@ -492,9 +493,12 @@ namespace galera
                      size_t                  reserved_size,
                      uint16_t                flags    = 0,
                      WriteSetNG::Version     ver      = WriteSetNG::MAX_VERSION,
-                     DataSet::Version        dver     = DataSet::MAX_VERSION,
-                     DataSet::Version        uver     = DataSet::MAX_VERSION,
-                     size_t                  max_size = WriteSetNG::MAX_SIZE)
+                     DataSet::Version        dver     = DataSet::VER1,
+                     DataSet::Version        uver     = DataSet::VER1,
+                     size_t                  max_size = WriteSetNG::MAX_SIZE,
+                     int                     clevel   =
+                     DataSet::DEFAULT_COMPRESSION_LEVEL,
+                     gu::RecordSet::CheckType ct = gu::RecordSet::CHECK_MMH128)
             :
             header_(ver),
             base_name_(dir_name, id),
@@ -502,28 +506,50 @@ namespace galera
             kbn_   (base_name_),
             keys_  (reserved,
                     (reserved_size >>= 6, reserved_size <<= 3, reserved_size),
-                    kbn_, kver),
-            /* 5/8 of reserved goes to data set  */
+                    kbn_, kver, ct),
+            /* the rest of reserved goes to data set, except for unordered
+             * set header space */
             dbn_   (base_name_),
-            data_  (reserved + reserved_size, reserved_size*5, dbn_, dver),
-            /* 2/8 of reserved goes to unordered set  */
+            data_  (reserved + reserved_size,
+                    reserved_size*7 - unrd_reserved(reserved_size), dbn_, dver,
+                    clevel, ct),
+            /* unordered set is normally empty, keep it out of the way */
             ubn_   (base_name_),
-            unrd_  (reserved + reserved_size*6, reserved_size*2, ubn_, uver),
+            unrd_  (reserved + reserved_size*8 - unrd_reserved(reserved_size),
+                    unrd_reserved(reserved_size), ubn_, uver, clevel, ct),
             /* annotation set is not allocated unless requested */
             abn_   (base_name_),
             annt_  (NULL),
             left_  (max_size - keys_.size() - data_.size() - unrd_.size()
                     - header_.size()),
-            flags_ (flags)
+            flags_ (flags),
+            row_keys_  (0),
+            escalate_  (0)
         {}
 
         ~WriteSetOut() { delete annt_; }
 
         void append_key(const KeyData& k)
         {
+            if (gu_unlikely(escalate_ > 0) && k.parts_num > TABLE_KEY_PARTS &&
+                ++row_keys_ > escalate_)
+            {
+                /* bulk write set: certify the whole table instead */
+                KeyData const tk(k.proto_ver, k.parts, TABLE_KEY_PARTS,
+                                 WSREP_KEY_EXCLUSIVE, k.copy);
+                left_ -= keys_.append(tk);
+                return;
+            }
+
             left_ -= keys_.append(k);
         }
 
+        /* After this many row keys (longer than TABLE_KEY_PARTS) the rest of
+         * row keys are replaced with exclusive keys of their tables, so that
+         * certification index cost of a bulk write set is per table and not
+         * per row. 0 disables escalation. */
+        void set_key_escalation(long const row_keys) { escalate_ = row_keys; }
+
         void append_data(const void* data, size_t data_len, bool store)
         {
             left_ -= data_.append(data, data_len, store);
@@ -538,7 +564,10 @@ namespace galera
         {
             if (NULL == annt_)
             {
-                annt_ = new DataSetOut(NULL, 0, abn_, DataSet::MAX_VERSION);
+                /* all data sets share the same version in the header */
+                annt_ = new DataSetOut(NULL, 0, abn_, data_.set_version(),
+                                       DataSet::DEFAULT_COMPRESSION_LEVEL,
+                                       data_.set_check_type());
                 left_ -= annt_->size();
             }
 
@@ -655,6 +684,20 @@ namespace galera
         DataSetOut*         annt_;
         ssize_t             left_;
         uint16_t            flags_;
+        long                row_keys_;
+        long                escalate_;
+
+        /* wsrep keys start with database and table name parts */
+        static long const   TABLE_KEY_PARTS = 2;
+
+        /* enough for an empty record set: header and checksum */
+        static size_t const UNRD_RESERVED = 64;
+
+        /* reserved space for unordered set given 1/8 of the total */
+        static size_t unrd_reserved(size_t const eighth)
+        {
+            return (eighth*2 < UNRD_RESERVED ? eighth*2 : UNRD_RESERVED);
+        }
 
         void check_size()
         {
@@ -679,8 +722,9 @@ namespace galera
               data_  (),
               unrd_  (),
               annt_  (NULL),
-              check_thr_id_(),
-              check_thr_(false),
+              check_jobs_(NULL),
+              unchecked_ (0),
+              parsed_(false),
               check_ (false)
         {
             init (st);
@@ -693,8 +737,9 @@ namespace galera
               data_  (),
               unrd_  (),
               annt_  (NULL),
-              check_thr_id_(),
-              check_thr_(false),
+              check_jobs_(NULL),
+              unchecked_ (0),
+              parsed_(false),
               check_ (false)
         {}
 
@@ -709,20 +754,22 @@ namespace galera
             init (st);
         }
 
-        void read_buf (const gu::byte_t* const ptr, ssize_t const len)
+        /* verify = false skips checksumming altogether */
+        void read_buf (const gu::byte_t* const ptr, ssize_t const len,
+                       bool const verify = true)
         {
             assert (ptr != NULL);
             assert (len >= 0);
             gu::Buf tmp = { ptr, len };
-            read_buf (tmp);
+            read_buf (tmp, verify ? SIZE_THRESHOLD : 0);
         }
 
         ~WriteSetIn ()
         {
-            if (gu_unlikely(check_thr_))
+            if (gu_unlikely(check_jobs_ != NULL))
             {
-                /* checksum was performed in a parallel thread */
-                gu_thread_join (check_thr_id_, NULL);
+                /* checksum is being performed by the pool */
+                check_wait();
             }
 
             delete annt_;
@@ -744,30 +791,35 @@ namespace galera
         wsrep_conn_id_t     conn_id()   const { return header_.conn_id();   }
         wsrep_trx_id_t      trx_id()    const { return header_.trx_id();    }
 
-        const KeySetIn&  keyset()  const { return keys_; }
-        const DataSetIn& dataset() const { return data_; }
-        const DataSetIn& unrdset() const { return unrd_; }
+        /* Sections are parsed and checksummed on first access. Checksum
+         * failure is not reported here but by verify_checksum(). */
+        const KeySetIn&  keyset()  const { section(CHECK_KEYS); return keys_; }
+        const DataSetIn& dataset() const { section(CHECK_DATA); return data_; }
+        const DataSetIn& unrdset() const { section(CHECK_UNRD); return unrd_; }
 
-        bool annotated() const { return (annt_ != NULL); }
+        bool annotated() const { section(0); return (annt_ != NULL); }
         void write_annotation(std::ostream& os) const;
 
         /* This should be called right after certification verdict is obtained
          * and before it is finalized. */
         void verify_checksum() const /* throws */
         {
-            if (gu_unlikely(check_thr_))
+            if (gu_unlikely(check_jobs_ != NULL))
             {
-                /* checksum was performed in a parallel thread */
-                gu_thread_join (check_thr_id_, NULL);
-                check_thr_ = false;
-                checksum_fin();
+                /* checksum was performed by the pool */
+                bool const ok(check_wait());
+                check_ = check_ && ok;
             }
+
+            section(CHECK_ALL);
+            checksum_fin();
         }
 
         uint64_t get_checksum() const
         {
             /* since data segment is the only thing that definitely stays
              * unchanged through WS lifetime, it is the WS signature */
+            section(0);
             return (data_.get_checksum());
         }
 
@@ -794,17 +846,64 @@ namespace galera
 
         WriteSetNG::Header header_;
         ssize_t            size_;
-        KeySetIn           keys_;
-        DataSetIn          data_;
-        DataSetIn          unrd_;
-        DataSetIn*         annt_;
-        gu_thread_t        check_thr_id_;
-        bool mutable       check_thr_;
-        bool               check_;
+        KeySetIn mutable   keys_;
+        DataSetIn mutable  data_;
+        DataSetIn mutable  unrd_;
+        mutable DataSetIn* annt_;
+
+        /* verifies a single record set in a pool thread */
+        class CheckJob : public gu::ThreadPool::Job
+        {
+        public:
+
+            CheckJob() : Job(), set_(NULL), ok_(true) {}
+
+            void set(const gu::RecordSetInBase& s) { set_ = &s; ok_ = false; }
+            bool ok() const { return ok_; }
+
+        protected:
+
+            void run();
+
+        private:
+
+            const gu::RecordSetInBase* set_;
+            bool                       ok_;
+
+            CheckJob(const CheckJob&);
+            CheckJob& operator=(const CheckJob&);
+        };
+
+        static int const   CHECK_JOBS = 3; /* keys_, data_, unrd_ */
+        mutable CheckJob*  check_jobs_;
+
+        enum
+        {
+            CHECK_KEYS = 1 << 0,
+            CHECK_DATA = 1 << 1,
+            CHECK_UNRD = 1 << 2,
+            CHECK_ALL  = CHECK_KEYS | CHECK_DATA | CHECK_UNRD
+        };
+
+        int  mutable       unchecked_; /* sections with deferred checksum */
+        bool mutable       parsed_;    /* sections initialized */
+        bool mutable       check_;     /* no checksum failures seen so far */
 
         static size_t const SIZE_THRESHOLD = 1 << 22; /* 4Mb */
 
-        void checksum (); /* checksums writeset, stores result in check_ */
+        /* makes sure sections are initialized and the ones in mask s are
+         * checksummed */
+        void section(int const s) const
+        {
+            if (gu_unlikely(!parsed_))       init_sets();
+            if (gu_unlikely(unchecked_ & s)) checksum(unchecked_ & s);
+        }
+
+        /* checksums sections in mask s, stores result in check_ */
+        void checksum (int s) const;
+
+        /* initializes data sets */
+        void init_sets () const;
 
         void checksum_fin() const
         {
@@ -814,12 +913,12 @@ namespace galera
             }
         }
 
-        static void* checksum_thread (void* arg)
-        {
-            WriteSetIn* ws(reinterpret_cast<WriteSetIn*>(arg));
-            ws->checksum();
-            return NULL;
-        }
+        /* submits record set checksums to the pool, returns false if
+         * that failed and checksum must be done in foreground */
+        bool check_submit();
+
+        /* waits for and releases pool jobs, returns true if all passed */
+        bool check_wait() const;
 
         /* late initialization after default constructor */
         void init (ssize_t size_threshold);
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2010-2014 Codership Oy <info@codership.com>
+ * Copyright (C) 2010-2017 Codership Oy <info@codership.com>
  */
 
 #include "wsdb.hpp"
@@ -14,26 +14,35 @@
 void galera::Wsdb::print(std::ostream& os) const
 {
     os << "trx map:\n";
-    for (galera::Wsdb::TrxMap::const_iterator i = trx_map_.begin();
-         i != trx_map_.end();
-         ++i)
+    for (size_t s(0); s < SHARDS; ++s)
     {
-        os << i->first << " " << *i->second << "\n";
+        const TrxMap& trx_map(shards_[s].trx_map_);
+        for (galera::Wsdb::TrxMap::const_iterator i = trx_map.begin();
+             i != trx_map.end();
+             ++i)
+        {
+            os << i->first << " " << *i->second << "\n";
+        }
     }
     os << "conn query map:\n";
-    for (galera::Wsdb::ConnMap::const_iterator i = conn_map_.begin();
-         i != conn_map_.end();
-         ++i)
+    for (size_t s(0); s < SHARDS; ++s)
     {
-        os << i->first << " ";
+        const ConnMap& conn_map(shards_[s].conn_map_);
+        for (galera::Wsdb::ConnMap::const_iterator i = conn_map.begin();
+             i != conn_map.end();
+             ++i)
+        {
+            os << i->first << " ";
+        }
     }
     os << "\n";
 }
 
 
-galera::Wsdb::Wsdb()
+galera::Wsdb::Shard::Shard()
     :
-    trx_pool_  (TrxHandle::LOCAL_STORAGE_SIZE(), 512, "LocalTrxHandle"),
+    trx_pool_    (TrxHandle::LOCAL_STORAGE_SIZE(), 512 / SHARDS,
+                  "LocalTrxHandle"),
     trx_map_     (),
     conn_trx_map_(),
     trx_mutex_   (),
@@ -42,31 +51,51 @@ galera::Wsdb::Wsdb()
 {}
 
 
+galera::Wsdb::Wsdb()
+    :
+    shards_()
+{}
+
+
 galera::Wsdb::~Wsdb()
 {
-    log_info << "wsdb trx map usage " << trx_map_.size()
-             << " conn query map usage " << conn_map_.size();
-    log_info << trx_pool_;
+    size_t trx_map_size(0), conn_map_size(0);
+
+    for (size_t s(0); s < SHARDS; ++s)
+    {
+        trx_map_size  += shards_[s].trx_map_.size();
+        conn_map_size += shards_[s].conn_map_.size();
+    }
+
+    log_info << "wsdb trx map usage " << trx_map_size
+             << " conn query map usage " << conn_map_size;
+    log_info << shards_[0].trx_pool_ << " (1 of "
+             << static_cast<int>(SHARDS) << " shards)";
 
     // With debug builds just print trx and query maps to stderr
     // and don't clean up to let valgrind etc to detect leaks.
 #ifndef NDEBUG
     std::cerr << *this;
-    assert(trx_map_.size() == 0);
-    assert(conn_map_.size() == 0);
+    assert(trx_map_size == 0);
+    assert(conn_map_size == 0);
 #else
-    for_each(trx_map_.begin(), trx_map_.end(), Unref2nd<TrxMap::value_type>());
-    for_each(conn_trx_map_.begin(),
-             conn_trx_map_.end(),
-             Unref2nd<ConnTrxMap::value_type>());
+    for (size_t s(0); s < SHARDS; ++s)
+    {
+        Shard& shard(shards_[s]);
+        for_each(shard.trx_map_.begin(), shard.trx_map_.end(),
+                 Unref2nd<TrxMap::value_type>());
+        for_each(shard.conn_trx_map_.begin(),
+                 shard.conn_trx_map_.end(),
+                 Unref2nd<ConnTrxMap::value_type>());
+    }
 #endif // !NDEBUG
 }
 
 
 inline galera::TrxHandle*
-galera::Wsdb::find_trx(wsrep_trx_id_t const trx_id)
+galera::Wsdb::find_trx(Shard& shard, wsrep_trx_id_t const trx_id)
 {
-    gu::Lock lock(trx_mutex_);
+    gu::Lock lock(shard.trx_mutex_);
 
     galera::TrxHandle* trx;
     /* trx-id = 0 is safe-guard condition.
@@ -80,16 +109,16 @@ galera::Wsdb::find_trx(wsrep_trx_id_t const trx_id)
     {
         /* trx_id is valid and unique. Search for this trx_id in the
         trx_id -> trx map: */
-        TrxMap::iterator const i(trx_map_.find(trx_id));
-        trx = (trx_map_.end() == i ? NULL : i->second);
+        TrxMap::iterator const i(shard.trx_map_.find(trx_id));
+        trx = (shard.trx_map_.end() == i ? NULL : i->second);
     }
     else
     {
         /* trx_id is default, so search for repsective connection id
         in connection-transaction map: */
         gu_thread_t const id = gu_thread_self();
-        ConnTrxMap::iterator const i(conn_trx_map_.find(id));
-        trx = (conn_trx_map_.end() == i ? NULL : i->second);
+        ConnTrxMap::iterator const i(shard.conn_trx_map_.find(id));
+        trx = (shard.conn_trx_map_.end() == i ? NULL : i->second);
     }
 
     return (trx);
@@ -97,13 +126,15 @@ galera::Wsdb::find_trx(wsrep_trx_id_t const trx_id)
 
 
 inline galera::TrxHandle*
-galera::Wsdb::create_trx(const TrxHandle::Params& params,
-                         const wsrep_uuid_t&  source_id,
-                         wsrep_trx_id_t const trx_id)
+galera::Wsdb::create_trx(Shard&                   shard,
+                         const TrxHandle::Params& params,
+                         const wsrep_uuid_t&      source_id,
+                         wsrep_trx_id_t const     trx_id)
 {
-    TrxHandle* trx(TrxHandle::New(trx_pool_, params, source_id, -1, trx_id));
+    TrxHandle* trx(TrxHandle::New(shard.trx_pool_, params, source_id, -1,
+                                  trx_id));
 
-    gu::Lock lock(trx_mutex_);
+    gu::Lock lock(shard.trx_mutex_);
 
     galera::TrxHandle* trx_ref;
     if (trx_id != wsrep_trx_id_t(-1))
@@ -111,7 +142,7 @@ galera::Wsdb::create_trx(const TrxHandle::Params& params,
         /* trx_id is valid, add it to trx-map as valid trx_id, which
         is unique accross connections: */
         std::pair<TrxMap::iterator, bool> i
-            (trx_map_.insert(std::make_pair(trx_id, trx)));
+            (shard.trx_map_.insert(std::make_pair(trx_id, trx)));
         if (gu_unlikely(i.second == false)) gu_throw_fatal;
         trx_ref = i.first->second;
     }
@@ -121,7 +152,8 @@ galera::Wsdb::create_trx(const TrxHandle::Params& params,
         that is maintained based on gu_thread_id (actually it is
         alias for connection_id): */
          std::pair<ConnTrxMap::iterator, bool> i
-             (conn_trx_map_.insert(std::make_pair(gu_thread_self(), trx)));
+             (shard.conn_trx_map_.insert(std::make_pair(gu_thread_self(),
+                                                         trx)));
         if (gu_unlikely(i.second == false)) gu_throw_fatal;
         trx_ref = i.first->second;
     }
@@ -136,9 +168,13 @@ galera::Wsdb::get_trx(const TrxHandle::Params& params,
                       wsrep_trx_id_t const trx_id,
                       bool const           create)
 {
-    TrxHandle* retval(find_trx(trx_id));
+    Shard&     shard(trx_shard(trx_id));
+    TrxHandle* retval(find_trx(shard, trx_id));
 
-    if (0 == retval && create) retval = create_trx(params, source_id, trx_id);
+    if (0 == retval && create)
+    {
+        retval = create_trx(shard, params, source_id, trx_id);
+    }
 
     if (retval != 0) retval->ref();
 
@@ -147,18 +183,21 @@ galera::Wsdb::get_trx(const TrxHandle::Params& params,
 
 
 galera::Wsdb::Conn*
-galera::Wsdb::get_conn(wsrep_conn_id_t const conn_id, bool const create)
+galera::Wsdb::get_conn(Shard&                shard,
+                       wsrep_conn_id_t const conn_id,
+                       bool const            create)
 {
-    gu::Lock lock(conn_mutex_);
+    gu::Lock lock(shard.conn_mutex_);
 
-    ConnMap::iterator i(conn_map_.find(conn_id));
+    ConnMap::iterator i(shard.conn_map_.find(conn_id));
 
-    if (conn_map_.end() == i)
+    if (shard.conn_map_.end() == i)
     {
         if (create == true)
         {
             std::pair<ConnMap::iterator, bool> p
-                (conn_map_.insert(std::make_pair(conn_id, Conn(conn_id))));
+                (shard.conn_map_.insert(std::make_pair(conn_id,
+                                                      Conn(conn_id))));
 
             if (gu_unlikely(p.second == false)) gu_throw_fatal;
 
@@ -178,14 +217,15 @@ galera::Wsdb::get_conn_query(const TrxHandle::Params& params,
                              wsrep_trx_id_t const conn_id,
                              bool const           create)
 {
-    Conn* const conn(get_conn(conn_id, create));
+    Shard&      shard(conn_shard(conn_id));
+    Conn* const conn(get_conn(shard, conn_id, create));
 
     if (0 == conn) return 0;
 
     if (conn->get_trx() == 0 && create == true)
     {
         TrxHandle* trx
-            (TrxHandle::New(trx_pool_, params, source_id, conn_id, -1));
+            (TrxHandle::New(shard.trx_pool_, params, source_id, conn_id, -1));
         conn->assign_trx(trx);
     }
 
@@ -195,24 +235,25 @@ galera::Wsdb::get_conn_query(const TrxHandle::Params& params,
 
 void galera::Wsdb::discard_trx(wsrep_trx_id_t trx_id)
 {
-    gu::Lock lock(trx_mutex_);
+    Shard&   shard(trx_shard(trx_id));
+    gu::Lock lock(shard.trx_mutex_);
     if (trx_id != wsrep_trx_id_t(-1))
     {
         TrxMap::iterator i;
-        if ((i = trx_map_.find(trx_id)) != trx_map_.end())
+        if ((i = shard.trx_map_.find(trx_id)) != shard.trx_map_.end())
         {
             i->second->unref();
-            trx_map_.erase(i);
+            shard.trx_map_.erase(i);
         }
     }
     else
     {
         ConnTrxMap::iterator i;
         gu_thread_t id = gu_thread_self();
-        if ((i = conn_trx_map_.find(id)) != conn_trx_map_.end())
+        if ((i = shard.conn_trx_map_.find(id)) != shard.conn_trx_map_.end())
         {
             i->second->unref();
-            conn_trx_map_.erase(i);
+            shard.conn_trx_map_.erase(i);
         }
     }
 }
@@ -220,9 +261,10 @@ void galera::Wsdb::discard_trx(wsrep_trx_id_t trx_id)
 
 void galera::Wsdb::discard_conn_query(wsrep_conn_id_t conn_id)
 {
-    gu::Lock lock(conn_mutex_);
+    Shard&   shard(conn_shard(conn_id));
+    gu::Lock lock(shard.conn_mutex_);
     ConnMap::iterator i;
-    if ((i = conn_map_.find(conn_id)) != conn_map_.end())
+    if ((i = shard.conn_map_.find(conn_id)) != shard.conn_map_.end())
     {
         i->second.assign_trx(0);
     }
@@ -230,10 +272,11 @@ void galera::Wsdb::discard_conn_query(wsrep_conn_id_t conn_id)
 
 void galera::Wsdb::discard_conn(wsrep_conn_id_t conn_id)
 {
-    gu::Lock lock(conn_mutex_);
+    Shard&   shard(conn_shard(conn_id));
+    gu::Lock lock(shard.conn_mutex_);
     ConnMap::iterator i;
-    if ((i = conn_map_.find(conn_id)) != conn_map_.end())
+    if ((i = shard.conn_map_.find(conn_id)) != shard.conn_map_.end())
     {
-        conn_map_.erase(i);
+        shard.conn_map_.erase(i);
     }
 }
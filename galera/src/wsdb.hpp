@@ -1,5 +1,5 @@
 //
-// Copyright (C) 2010-2014 Codership Oy <info@codership.com>
+// Copyright (C) 2010-2017 Codership Oy <info@codership.com>
 //
 #ifndef GALERA_WSDB_HPP
 #define GALERA_WSDB_HPP
@@ -8,6 +8,7 @@
 #include "wsrep_api.h"
 #include "gu_unordered.hpp"
 #include "gu_thread.hpp"
+#include "gu_mem_pool.hpp"
 
 namespace galera
 {
@@ -55,7 +56,14 @@ namespace galera
             size_t operator()(const wsrep_trx_id_t& key) const { return key; }
         };
 
-        typedef gu::UnorderedMap<wsrep_trx_id_t, TrxHandle*, TrxHash> TrxMap;
+        /* map nodes are allocated in create_trx() and freed in discard_trx()
+         * by the same client thread, pool them to save two malloc() calls
+         * on every local transaction */
+        typedef gu::UnorderedMap<wsrep_trx_id_t, TrxHandle*, TrxHash,
+                                 std::equal_to<wsrep_trx_id_t>,
+                                 gu::PoolAllocator<std::pair<
+                                     const wsrep_trx_id_t, TrxHandle*> > >
+        TrxMap;
 
         /* TrxMap structure doesn't take into consideration presence of
         two trx objects with same trx_id (2^64 - 1 which is default trx_id)
@@ -72,7 +80,11 @@ namespace galera
             size_t operator()(const gu_thread_t& key) const { return key; }
         };
 
-        typedef gu::UnorderedMap<gu_thread_t, TrxHandle*, ConnTrxHash> ConnTrxMap;
+        typedef gu::UnorderedMap<gu_thread_t, TrxHandle*, ConnTrxHash,
+                                 std::equal_to<gu_thread_t>,
+                                 gu::PoolAllocator<std::pair<
+                                     const gu_thread_t, TrxHandle*> > >
+        ConnTrxMap;
 
         class ConnHash
         {
@@ -104,25 +116,64 @@ namespace galera
         void print(std::ostream& os) const;
 
     private:
+        /* Maps are split into SHARDS shards, each with its own locks and
+         * trx handle pool, so that client threads working on different
+         * transactions and connections don't contend on a single mutex.
+         * Trx maps are sharded by trx_id (by thread id for the default trx
+         * id), connection map by conn_id. */
+        struct Shard
+        {
+            Shard();
+
+            TrxHandle::LocalPool trx_pool_;
+
+            TrxMap       trx_map_;
+            ConnTrxMap   conn_trx_map_;
+            gu::Mutex    trx_mutex_;
+            ConnMap      conn_map_;
+            gu::Mutex    conn_mutex_;
+
+        private:
+            Shard(const Shard&);
+            void operator=(const Shard&);
+        };
+
+        static int    const SHARD_BITS = 4;
+        static size_t const SHARDS     = 1 << SHARD_BITS;
+
+        static size_t shard_index(uint64_t const key)
+        {
+            /* keys are often sequential, spread them with Fibonacci hash */
+            return ((key * 0x9E3779B97F4A7C15ULL) >> (64 - SHARD_BITS));
+        }
+
+        Shard& trx_shard(wsrep_trx_id_t const trx_id)
+        {
+            return shards_[trx_id != wsrep_trx_id_t(-1) ?
+                           shard_index(trx_id) :
+                           shard_index(ConnTrxHash()(gu_thread_self()))];
+        }
+
+        Shard& conn_shard(wsrep_conn_id_t const conn_id)
+        {
+            return shards_[shard_index(conn_id)];
+        }
+
         // Find existing trx handle in the map
-        TrxHandle* find_trx(wsrep_trx_id_t trx_id);
+        TrxHandle* find_trx(Shard& shard, wsrep_trx_id_t trx_id);
 
         // Create new trx handle
-        TrxHandle* create_trx(const TrxHandle::Params& params,
+        TrxHandle* create_trx(Shard&                   shard,
+                              const TrxHandle::Params& params,
                               const wsrep_uuid_t&      source_id,
                               wsrep_trx_id_t           trx_id);
 
-        Conn*      get_conn(wsrep_conn_id_t conn_id, bool create);
+        Conn*      get_conn(Shard& shard, wsrep_conn_id_t conn_id,
+                            bool create);
 
         static const size_t trx_mem_limit_ = 1 << 20;
 
-        TrxHandle::LocalPool trx_pool_;
-
-        TrxMap       trx_map_;
-        ConnTrxMap   conn_trx_map_;
-        gu::Mutex    trx_mutex_;
-        ConnMap      conn_map_;
-        gu::Mutex    conn_mutex_;
+        Shard shards_[SHARDS];
     };
 
     inline std::ostream& operator<<(std::ostream& os, const Wsdb& w)
@@ -33,6 +33,10 @@ wsrep_set_params (galera::Replicator& repl, const char* params)
                     gu_conf_debug_off();
                 }
             }
+            else if (key == galera::Replicator::Param::log_async)
+            {
+                galera::Replicator::set_log_async(gu::from_string<long>(value));
+            }
 #ifdef GU_DBUG_ON
             else if (key == galera::Replicator::Param::dbug)
             {
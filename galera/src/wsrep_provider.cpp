@@ -567,15 +567,7 @@ wsrep_status_t galera_append_key(wsrep_t*           const gh,
     try
     {
         TrxHandleLock lock(*trx);
-        for (size_t i(0); i < keys_num; ++i)
-        {
-            galera::KeyData k (repl->trx_proto_ver(),
-                               keys[i].key_parts,
-                               keys[i].key_parts_num,
-                               key_type,
-                               copy);
-            trx->append_key(k);
-        }
+        trx->append_keys(repl->trx_proto_ver(), keys, keys_num, key_type, copy);
         retval = WSREP_OK;
     }
     catch (std::exception& e)
@@ -621,8 +613,7 @@ wsrep_status_t galera_append_data(wsrep_t*                const wsrep,
     try
     {
         TrxHandleLock lock(*trx);
-        if (WSREP_DATA_ORDERED == type)
-            append_data_array(trx, data, count, type, copy);
+        if (WSREP_DATA_ORDERED == type) trx->append_data(data, count, copy);
         retval = WSREP_OK;
     }
     catch (std::exception& e)
@@ -0,0 +1,66 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "applier_advisor.hpp"
+
+#include <check.h>
+
+using namespace galera;
+
+START_TEST(test_smoothing)
+{
+    ApplierAdvisor aa;
+
+    fail_unless(aa.recommended() == 0);
+    fail_unless(aa.update(0, 8.0, 10.0, 4.0) == 0, "no data");
+
+    /* first sample is taken as is */
+    fail_unless(aa.update(10, 8.0, 10.0, 4.0) == 8);
+
+    /* without new write sets the sample is ignored */
+    fail_unless(aa.update(10, 1.0, 10.0, 4.0) == 8);
+
+    /* moves towards the new target gradually */
+    long prev(8);
+    for (long long r(11); r < 40; ++r)
+    {
+        long const rec(aa.update(r, 16.0, 10.0, 4.0));
+        fail_unless(rec >= prev && rec <= 16, "rec: %ld, prev: %ld",
+                    rec, prev);
+        prev = rec;
+    }
+    fail_unless(prev == 16, "prev: %ld", prev);
+    fail_unless(aa.recommended() == 16);
+}
+END_TEST
+
+START_TEST(test_no_backlog)
+{
+    ApplierAdvisor aa;
+
+    /* appliers keep up: limited by the apply window */
+    fail_unless(aa.update(1, 16.0, 0.2, 2.0) == 3);
+
+    ApplierAdvisor bb;
+
+    /* always at least one */
+    fail_unless(bb.update(1, 0.5, 5.0, 0.0) == 1);
+}
+END_TEST
+
+Suite* applier_advisor_suite()
+{
+    Suite* s = suite_create("applier_advisor");
+    TCase* tc;
+
+    tc = tcase_create("test_smoothing");
+    tcase_add_test(tc, test_smoothing);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_no_backlog");
+    tcase_add_test(tc, test_no_backlog);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
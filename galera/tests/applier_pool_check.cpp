@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "../src/applier_pool.hpp"
+
+#include <check.h>
+#include <set>
+
+using namespace galera;
+
+namespace
+{
+    class Ready
+    {
+    public:
+        Ready() : ready_() {}
+        void set(wsrep_seqno_t s) { ready_.insert(s); }
+        bool operator()(TrxHandle& trx) const
+        {
+            return (ready_.find(trx.global_seqno()) != ready_.end());
+        }
+    private:
+        std::set<wsrep_seqno_t> ready_;
+    };
+
+    TrxHandle* make_trx(TrxHandle::SlavePool& sp, wsrep_seqno_t const seqno)
+    {
+        TrxHandle* const trx(TrxHandle::New(sp));
+        trx->set_received(0, seqno, seqno);
+        return trx;
+    }
+}
+
+START_TEST(test_applier_pool)
+{
+    TrxHandle::SlavePool sp(sizeof(TrxHandle), 8, "applier_pool_check");
+    ApplierPool pool(true);
+    Ready ready;
+    int ctx1, ctx2;
+    long long deferred, stolen;
+
+    {
+        ApplierPool::Member m1(pool, &ctx1);
+
+        {
+            ApplierPool::Member m2(pool, &ctx2);
+
+            TrxHandle* const t1(make_trx(sp, 1));
+            TrxHandle* const t2(make_trx(sp, 2));
+            TrxHandle* const t3(make_trx(sp, 3));
+
+            /* nobody is applying, caller must apply it itself */
+            fail_if(pool.defer(&ctx1, t1, ready));
+
+            /* ctx1 is busy now, not ready trxs are queued */
+            fail_unless(pool.defer(&ctx2, t2, ready));
+            fail_unless(pool.defer(&ctx2, t3, ready));
+            fail_unless(t2->refcnt() == 2);
+
+            /* ready ones are stolen first */
+            ready.set(3);
+            fail_if(pool.next(&ctx1, ready) != t3);
+            t3->unref();
+
+            /* last busy member takes the oldest even if it is not ready */
+            fail_if(pool.next(&ctx1, ready) != t2);
+            t2->unref();
+
+            fail_if(pool.next(&ctx1, ready) != 0);
+
+            pool.stats_get(deferred, stolen);
+            fail_if(deferred != 2, "deferred: %lld", deferred);
+            fail_if(stolen   != 2, "stolen: %lld",   stolen);
+
+            /* with nobody busy nothing is queued, even if not ready */
+            TrxHandle* const t4(make_trx(sp, 4));
+            fail_if(pool.defer(&ctx2, t4, ready));
+
+            TrxHandle* const t5(make_trx(sp, 5));
+            fail_unless(pool.defer(&ctx2, t5, ready));
+
+            /* own queue of the leaving member is handed over */
+            fail_if(pool.next(&ctx2, ready) != t5);
+            t5->unref();
+            fail_if(pool.next(&ctx2, ready) != 0);
+
+            TrxHandle* const t6(make_trx(sp, 6));
+            TrxHandle* const t7(make_trx(sp, 7));
+            fail_if(pool.defer(&ctx1, t6, ready));
+            fail_unless(pool.defer(&ctx2, t7, ready));
+
+            t1->unref(); t2->unref(); t3->unref(); t4->unref();
+            t5->unref(); t6->unref(); t7->unref();
+        } // ctx2 leaves here with t7 queued
+
+        TrxHandle* trx(pool.next(&ctx1, ready));
+        fail_if(0 == trx);
+        fail_unless(trx->global_seqno() == 7);
+        trx->unref();
+        fail_if(pool.next(&ctx1, ready) != 0);
+    }
+
+    pool.stats_get(deferred, stolen);
+    fail_if(deferred != 4, "deferred: %lld", deferred);
+    fail_if(stolen   != 2, "stolen: %lld",   stolen);
+}
+END_TEST
+
+Suite* applier_pool_suite()
+{
+    Suite* s = suite_create("applier_pool");
+    TCase* tc;
+
+    tc = tcase_create("test_applier_pool");
+    tcase_add_test(tc, test_applier_pool);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
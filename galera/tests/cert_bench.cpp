@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ *
+ * Certification microbenchmark.
+ *
+ * Builds a stream of synthetic version 3 write sets and feeds it to
+ * galera::Certification the same way the replicator does: prepare(),
+ * append_trx(), set_trx_committed() and periodic purge_trxs_upto().
+ * Write sets are generated and serialized before the measurement starts.
+ *
+ * Usage: cert_bench [-n trxs] [-k keys per trx] [-d key depth]
+ *                   [-c conflict %] [-s shared %] [-w cert window]
+ *                   [-p purge interval] [-h hot keys]
+ *
+ * Each key has depth parts: depth - 1 "table" parts shared by all write
+ * sets and a row part. With conflict % probability the row is picked from
+ * a small set of hot rows, otherwise it is unique. Every write set has
+ * seen everything but the last cert window write sets, so hot rows
+ * written within the window conflict unless both keys are shared.
+ */
+
+#include "certification.hpp"
+#include "replicator_smm.hpp"
+#include "galera_service_thd.hpp"
+#include "trx_handle.hpp"
+
+#include "gu_time.h"
+
+#include <sys/resource.h>
+#include <algorithm>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <string>
+
+namespace
+{
+    struct Options
+    {
+        Options()
+            :
+            trxs    (100000),
+            keys    (10),
+            depth   (3),
+            conflict(1),
+            shared  (0),
+            window  (16),
+            purge   (128),
+            hot     (64)
+        {}
+
+        long trxs;
+        long keys;
+        long depth;
+        long conflict; // %
+        long shared;   // %
+        long window;
+        long purge;
+        long hot;
+    };
+
+    void usage(const char* const name)
+    {
+        fprintf(stderr, "Usage: %s [-n trxs] [-k keys per trx] [-d key depth]"
+                " [-c conflict %%] [-s shared %%] [-w cert window]"
+                " [-p purge interval] [-h hot keys]\n", name);
+    }
+
+    class GCacheFile
+    {
+    public:
+        GCacheFile(gu::Config& conf) : name_("cert_bench.gcache")
+        {
+            conf.set("gcache.name", name_);
+            conf.set("gcache.size", "1M");
+        }
+
+        ~GCacheFile()
+        {
+            unlink(name_.c_str());
+            unlink((name_ + ".index").c_str());
+        }
+
+    private:
+        std::string const name_;
+    };
+
+    class Env
+    {
+    public:
+
+        Env() :
+            conf_  (),
+            init_  (conf_, NULL, NULL),
+            file_  (conf_),
+            gcache_(conf_, "."),
+            gcs_   (conf_, gcache_),
+            thd_   (gcs_,  gcache_)
+        {}
+
+        gu::Config&         conf() { return conf_; }
+        galera::ServiceThd& thd()  { return thd_;  }
+
+    private:
+
+        gu::Config         conf_;
+        galera::ReplicatorSMM::InitConfig init_;
+        GCacheFile         file_;
+        gcache::GCache     gcache_;
+        galera::DummyGcs   gcs_;
+        galera::ServiceThd thd_;
+    };
+
+    typedef std::vector<std::vector<gu::byte_t> > WriteSets;
+
+    /* simple LCG to be independent of libc rand() */
+    class Rand
+    {
+    public:
+        Rand() : x_(0x1234567ULL) {}
+        long operator()(long const n)
+        {
+            x_ = x_ * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<long>((x_ >> 33) % n);
+        }
+    private:
+        unsigned long long x_;
+    };
+
+    void generate(const Options& opt, WriteSets& wss)
+    {
+        int const version(3);
+        galera::TrxHandle::LocalPool lp(galera::TrxHandle::LOCAL_STORAGE_SIZE(),
+                                        4, "cert_bench_lp");
+        galera::TrxHandle::Params const params("", version,
+                                               galera::KeySet::MAX_VERSION);
+        wsrep_uuid_t const uuid = {{1, }};
+        Rand rnd;
+
+        std::vector<std::string> parts(opt.depth);
+        std::vector<wsrep_buf_t> bufs(opt.depth);
+
+        for (long d(0); d < opt.depth - 1; ++d)
+        {
+            char str[16];
+            snprintf(str, sizeof(str), "table%ld", d);
+            parts[d] = str;
+        }
+
+        wss.resize(opt.trxs);
+
+        for (long i(0); i < opt.trxs; ++i)
+        {
+            galera::TrxHandle* const trx(
+                galera::TrxHandle::New(lp, params, uuid, 1, i + 1));
+
+            for (long k(0); k < opt.keys; ++k)
+            {
+                char row[32];
+                if (rnd(100) < opt.conflict)
+                    snprintf(row, sizeof(row), "hot%ld", rnd(opt.hot));
+                else
+                    snprintf(row, sizeof(row), "%ld", i * opt.keys + k);
+                parts[opt.depth - 1] = row;
+
+                for (long d(0); d < opt.depth; ++d)
+                {
+                    bufs[d].ptr = parts[d].data();
+                    bufs[d].len = parts[d].size();
+                }
+
+                wsrep_key_type_t const type(rnd(100) < opt.shared ?
+                                            WSREP_KEY_SHARED :
+                                            WSREP_KEY_EXCLUSIVE);
+
+                trx->append_key(galera::KeyData(version, &bufs[0], opt.depth,
+                                                type, true));
+            }
+
+            galera::WriteSetNG::GatherVector out;
+            size_t const size(trx->write_set_out().gather(trx->source_id(),
+                                                          trx->conn_id(),
+                                                          trx->trx_id(),
+                                                          out));
+            /* seqno will be i + 1 */
+            trx->set_last_seen_seqno(std::max(i - opt.window, 0L));
+
+            std::vector<gu::byte_t>& ws(wss[i]);
+            ws.reserve(size);
+            for (size_t b(0); b < out->size(); ++b)
+            {
+                const gu::byte_t* const ptr
+                    (static_cast<const gu::byte_t*>(out[b].ptr));
+                ws.insert(ws.end(), ptr, ptr + out[b].size);
+            }
+
+            trx->unref();
+        }
+    }
+
+    long max_rss_kb()
+    {
+        struct rusage ru;
+        if (getrusage(RUSAGE_SELF, &ru)) return -1;
+        return ru.ru_maxrss;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:k:d:c:s:w:p:h:")) != -1)
+    {
+        long const val(optarg ? strtol(optarg, NULL, 10) : 0);
+
+        switch (c)
+        {
+        case 'n': opt.trxs     = val; break;
+        case 'k': opt.keys     = val; break;
+        case 'd': opt.depth    = val; break;
+        case 'c': opt.conflict = val; break;
+        case 's': opt.shared   = val; break;
+        case 'w': opt.window   = val; break;
+        case 'p': opt.purge    = val; break;
+        case 'h': opt.hot      = val; break;
+        default:  usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (opt.trxs <= 0 || opt.keys <= 0 || opt.depth <= 0 || opt.hot <= 0 ||
+        opt.window < 0 || opt.purge <= 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gu_conf_self_tstamp_on();
+
+    WriteSets wss;
+    generate(opt, wss);
+
+    long const rss_before(max_rss_kb());
+
+    Env env;
+    galera::Certification cert(env.conf(), env.thd());
+    cert.assign_initial_position(0, 3);
+
+    galera::TrxHandle::SlavePool sp(sizeof(galera::TrxHandle), 16,
+                                    "cert_bench_sp");
+
+    long long prepare_ns(0), test_ns(0), purge_ns(0), purge_max_ns(0);
+    long      purges(0), failed(0);
+    size_t    index_max(0);
+
+    for (long i(0); i < opt.trxs; ++i)
+    {
+        wsrep_seqno_t const seqno(i + 1);
+        galera::TrxHandle* const trx(galera::TrxHandle::New(sp));
+
+        trx->unserialize(&wss[i][0], wss[i].size(), 0);
+        trx->set_received(0, seqno, seqno);
+
+        long long const t0(gu_time_monotonic());
+        galera::Certification::prepare(trx);
+        long long const t1(gu_time_monotonic());
+        galera::Certification::TestResult const res(cert.append_trx(trx));
+        long long const t2(gu_time_monotonic());
+
+        prepare_ns += t1 - t0;
+        test_ns    += t2 - t1;
+        if (galera::Certification::TEST_FAILED == res) ++failed;
+
+        cert.set_trx_committed(trx);
+        trx->unref();
+
+        if (0 == seqno % opt.purge && seqno > opt.window)
+        {
+            double interval, dist;
+            size_t index_size;
+            cert.stats_get(interval, dist, index_size);
+            index_max = std::max(index_max, index_size);
+
+            long long const p0(gu_time_monotonic());
+            cert.purge_trxs_upto(seqno - opt.window, false);
+            long long const pause(gu_time_monotonic() - p0);
+
+            purge_ns    += pause;
+            purge_max_ns = std::max(purge_max_ns, pause);
+            ++purges;
+        }
+    }
+
+    double const total_keys(double(opt.trxs) * opt.keys);
+
+    printf("trxs: %ld, keys/trx: %ld, depth: %ld, conflict: %ld%%, "
+           "shared: %ld%%, window: %ld, purge interval: %ld\n",
+           opt.trxs, opt.keys, opt.depth, opt.conflict, opt.shared,
+           opt.window, opt.purge);
+    printf("prepare:     %8.1f ns/key\n", prepare_ns / total_keys);
+    printf("certify:     %8.1f ns/key, %.2f%% failed\n",
+           test_ns / total_keys, 100.0 * failed / opt.trxs);
+    printf("purge:       %8.1f ns/key, avg pause %.1f us, max pause %.1f us\n",
+           purge_ns / total_keys,
+           purges ? purge_ns / 1000.0 / purges : 0.0, purge_max_ns / 1000.0);
+    printf("index:       %8zu entries max, max RSS grew by %ld kB\n",
+           index_max, max_rss_kb() - rss_before);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "../src/cert_hot_keys.hpp"
+
+#include <check.h>
+#include <sstream>
+#include <vector>
+
+using namespace galera;
+
+namespace
+{
+    /* serialized FLAT16 key parts with pseudo-random hashes */
+    class Keys
+    {
+    public:
+
+        explicit Keys(size_t const n) : buf_(n * KEY_SIZE)
+        {
+            KeySet::KeyPart::TmpStore tmp;
+            KeySet::KeyPart::HashData hd;
+            uint64_t x(0x987654321ULL);
+
+            for (size_t i(0); i < n; ++i)
+            {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                hd.align = x;
+                memcpy(hd.buf + 8, &i, sizeof(i));
+
+                KeySet::KeyPart const kp(tmp, hd, KeySet::FLAT16, false,
+                                         NULL, 0);
+                memcpy(&buf_[i * KEY_SIZE], kp.ptr(), KEY_SIZE);
+            }
+        }
+
+        KeySet::KeyPart operator[](size_t const i) const
+        {
+            return KeySet::KeyPart(&buf_[i * KEY_SIZE]);
+        }
+
+    private:
+
+        static size_t const KEY_SIZE = 16;
+
+        std::vector<gu::byte_t> buf_;
+    };
+
+    std::string name(const KeySet::KeyPart& kp)
+    {
+        std::ostringstream os;
+        os << kp;
+        return os.str();
+    }
+}
+
+START_TEST(test_cert_hot_keys)
+{
+    size_t const n(10000);
+    Keys const   keys(n);
+    CertHotKeys  hk(3);
+
+    /* keys 0, 1 and 2 are hot with decreasing frequency, the rest are
+     * background noise seen once or twice */
+    for (size_t i(0); i < n; ++i)
+    {
+        hk.add(keys[i]);
+        if (i % 2) hk.add(keys[i]);
+        if (i % 10 == 0) hk.add(keys[0]);
+        if (i % 20 == 0) hk.add(keys[1]);
+        if (i % 40 == 0) hk.add(keys[2]);
+    }
+
+    long long const total(n + n/2 + n/10 + n/20 + n/40);
+    fail_if(hk.total() != total, "total: expected %lld, got %lld",
+            total, hk.total());
+
+    std::ostringstream os;
+    os << hk;
+    std::string const str(os.str());
+
+    size_t const p0(str.find(name(keys[0])));
+    size_t const p1(str.find(name(keys[1])));
+    size_t const p2(str.find(name(keys[2])));
+
+    fail_if(std::string::npos == p0, "key 0 not found in '%s'", str.c_str());
+    fail_if(std::string::npos == p1, "key 1 not found in '%s'", str.c_str());
+    fail_if(std::string::npos == p2, "key 2 not found in '%s'", str.c_str());
+    fail_unless(p0 < p1 && p1 < p2, "wrong order: '%s'", str.c_str());
+
+    hk.reset();
+    fail_if(hk.total() != 0);
+
+    std::ostringstream empty;
+    empty << hk;
+    fail_unless(empty.str().empty());
+}
+END_TEST
+
+Suite* cert_hot_keys_suite()
+{
+    Suite* s = suite_create("cert_hot_keys");
+    TCase* tc;
+
+    tc = tcase_create("test_cert_hot_keys");
+    tcase_add_test(tc, test_cert_hot_keys);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
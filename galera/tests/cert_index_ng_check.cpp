@@ -0,0 +1,340 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "../src/cert_index_ng.hpp"
+#include "../src/cert_index_spill.hpp"
+#include "../src/uuid.hpp"
+
+#include <check.h>
+#include <vector>
+
+using namespace galera;
+
+namespace
+{
+    /* serialized FLAT16 key parts with pseudo-random hashes */
+    class Keys
+    {
+    public:
+
+        explicit Keys(size_t const n) : buf_(n * KEY_SIZE)
+        {
+            KeySet::KeyPart::TmpStore tmp;
+            KeySet::KeyPart::HashData hd;
+            uint64_t x(0x123456789ULL);
+
+            for (size_t i(0); i < n; ++i)
+            {
+                x = x * 6364136223846793005ULL + 1442695040888963407ULL;
+                hd.align = x;
+                memcpy(hd.buf + 8, &i, sizeof(i)); // make them unique
+
+                KeySet::KeyPart const kp(tmp, hd, KeySet::FLAT16, true,
+                                         NULL, 0);
+                memcpy(&buf_[i * KEY_SIZE], kp.ptr(), KEY_SIZE);
+            }
+        }
+
+        KeySet::KeyPart operator[](size_t const i) const
+        {
+            return KeySet::KeyPart(&buf_[i * KEY_SIZE]);
+        }
+
+        size_t size() const { return buf_.size() / KEY_SIZE; }
+
+    private:
+
+        static size_t const KEY_SIZE = 16;
+
+        std::vector<gu::byte_t> buf_;
+    };
+
+    struct DeleteEntry
+    {
+        void operator()(KeyEntryNG* ke) const { ke->unref_all(); delete ke; }
+    };
+}
+
+START_TEST(test_cert_index_ng)
+{
+    Keys const  keys(20000);
+    CertIndexNG index;
+
+    fail_unless(index.empty());
+
+    for (size_t i(0); i < keys.size(); ++i)
+    {
+        fail_if(index.find(keys[i]) != NULL, "key %zu found before insert", i);
+        index.insert(new KeyEntryNG(keys[i]));
+    }
+
+    fail_if(index.size() != keys.size());
+
+    for (size_t i(0); i < keys.size(); ++i)
+    {
+        index.prefetch(keys[i]);
+        KeyEntryNG* const ke(index.find(keys[i]));
+        fail_if(NULL == ke, "key %zu not found", i);
+        fail_unless(ke->key().matches(keys[i]));
+    }
+
+    /* erase every third key */
+    for (size_t i(0); i < keys.size(); i += 3)
+    {
+        KeyEntryNG* const ke(index.find(keys[i]));
+        index.erase(ke);
+        delete ke;
+    }
+
+    for (size_t i(0); i < keys.size(); ++i)
+    {
+        bool const erased(0 == i % 3);
+        fail_if(erased != (NULL == index.find(keys[i])),
+                "key %zu: erased %d, found %d", i, erased,
+                NULL != index.find(keys[i]));
+    }
+
+    /* erase the rest, index shrinks on the way */
+    for (size_t i(0); i < keys.size(); ++i)
+    {
+        if (0 == i % 3) continue;
+
+        KeyEntryNG* const ke(index.find(keys[i]));
+        fail_if(NULL == ke, "key %zu not found", i);
+        index.erase(ke);
+        delete ke;
+    }
+
+    fail_unless(index.empty());
+
+    for (size_t i(0); i < keys.size(); ++i)
+    {
+        fail_if(index.find(keys[i]) != NULL, "key %zu found after erase", i);
+    }
+
+    /* for_each() and clear() */
+    for (size_t i(0); i < 1000; ++i) index.insert(new KeyEntryNG(keys[i]));
+    fail_if(index.size() != 1000);
+
+    index.for_each(DeleteEntry());
+    index.clear();
+
+    fail_unless(index.empty());
+    fail_if(index.find(keys[0]) != NULL);
+}
+END_TEST
+
+START_TEST(test_cert_index_ng_filter)
+{
+    Keys const  keys(40000);
+    size_t const half(keys.size() / 2);
+    CertIndexNG index;
+
+    for (size_t i(0); i < half; ++i)
+    {
+        index.insert(new KeyEntryNG(keys[i]));
+    }
+
+    /* no false negatives */
+    for (size_t i(0); i < half; ++i)
+    {
+        fail_unless(index.may_contain(keys[i]), "false negative %zu", i);
+    }
+
+    /* false positive rate is bounded */
+    size_t fp(0);
+    for (size_t i(half); i < keys.size(); ++i)
+    {
+        if (index.may_contain(keys[i])) ++fp;
+    }
+    fail_if(fp * 4 > half, "too many false positives: %zu/%zu", fp, half);
+
+    /* counters are decremented on erase */
+    for (size_t i(0); i < half; ++i)
+    {
+        KeyEntryNG* const ke(index.find(keys[i]));
+        index.erase(ke);
+        delete ke;
+    }
+
+    for (size_t i(0); i < keys.size(); ++i)
+    {
+        fail_if(index.may_contain(keys[i]), "key %zu in empty filter", i);
+    }
+}
+END_TEST
+
+START_TEST(test_key_entry_ng_shared)
+{
+    Keys const keys(1);
+    TrxHandle::LocalPool lp(TrxHandle::LOCAL_STORAGE_SIZE(), 4, "ke_lp");
+    wsrep_uuid_t const uuid = {{1, }};
+    TrxHandle* trx[4];
+
+    for (int i(0); i < 4; ++i)
+    {
+        trx[i] = TrxHandle::New(lp, TrxHandle::Defaults, uuid, -1, i + 1);
+        trx[i]->set_received(0, i + 1, i + 1);
+    }
+
+    KeySet::KeyPart const kp(keys[0]);
+    KeyEntryNG ke(kp);
+
+    fail_if(ke.referenced());
+
+    ke.ref(KeySet::Key::P_SHARED,    kp, trx[0]);
+    ke.ref(KeySet::Key::P_EXCLUSIVE, kp, trx[1]);
+    ke.ref(KeySet::Key::P_SHARED,    kp, trx[2]);
+
+    /* only the latest shared reference is kept */
+    fail_unless(ke.ref_trx() == trx[1]);
+    fail_unless(ke.ref_shared_seqno() == 3, "%lld",
+                static_cast<long long>(ke.ref_shared_seqno()));
+
+    ke.unref(trx[1]);
+    fail_unless(ke.ref_trx() == NULL);
+    fail_unless(ke.referenced());
+
+    /* shared reference above the purge seqno survives */
+    ke.unref_shared(2);
+    fail_unless(ke.ref_shared_seqno() == 3);
+
+    ke.ref(KeySet::Key::P_SHARED, kp, trx[3]);
+    ke.unref_shared(4);
+    fail_if(ke.referenced());
+
+    for (int i(0); i < 4; ++i) trx[i]->unref();
+}
+END_TEST
+
+START_TEST(test_cert_index_spill)
+{
+    Keys const keys(64);
+    TrxHandle::LocalPool lp(TrxHandle::LOCAL_STORAGE_SIZE(), 4, "spill_lp");
+    wsrep_uuid_t const uuid[2] = { {{1, }}, {{2, }} };
+    std::vector<TrxHandle*> trx(32);
+
+    for (size_t i(0); i < trx.size(); ++i)
+    {
+        trx[i] = TrxHandle::New(lp, TrxHandle::Defaults, uuid[i % 2], -1, i);
+        trx[i]->set_received(0, i + 1, i + 1);
+    }
+
+    CertIndexNG    index;
+    CertIndexSpill spill;
+
+    for (size_t i(0); i < keys.size(); ++i)
+    {
+        KeyEntryNG* const ke(new KeyEntryNG(keys[i]));
+        index.insert(ke);
+
+        if (i < 32)      // seqnos 1-8
+            ke->ref(KeySet::Key::P_EXCLUSIVE, keys[i], trx[i % 8]);
+        else if (i < 48) // seqno 10
+            ke->ref(KeySet::Key::P_SHARED, keys[i], trx[9]);
+        else             // seqno 12
+            ke->ref(KeySet::Key::P_EXCLUSIVE, keys[i], trx[11]);
+    }
+
+    fail_unless(spill.spill(index, 10) == 48);
+    fail_unless(index.size() == 16);
+    fail_unless(spill.size() == 48);
+    fail_unless(spill.covers(10));
+    fail_if(spill.covers(11));
+
+    CertIndexSpill::Ref ref;
+    spill.find(keys[5], ref);
+    fail_unless(ref.seqno_ == 6, "%lld", static_cast<long long>(ref.seqno_));
+    fail_unless(*ref.source_ == trx[5]->source_id());
+    fail_unless(ref.shared_seqno_ == WSREP_SEQNO_UNDEFINED);
+
+    ref = CertIndexSpill::Ref();
+    spill.find(keys[40], ref);
+    fail_unless(ref.seqno_ == WSREP_SEQNO_UNDEFINED);
+    fail_unless(ref.shared_seqno_ == 10);
+
+    ref = CertIndexSpill::Ref();
+    spill.find(keys[50], ref);
+    fail_unless(ref.seqno_ == WSREP_SEQNO_UNDEFINED);
+
+    /* newer shared reference in newer generation, exclusive in older */
+    KeyEntryNG* const ke5(new KeyEntryNG(keys[5]));
+    index.insert(ke5);
+    ke5->ref(KeySet::Key::P_SHARED, keys[5], trx[12]);
+
+    fail_unless(spill.spill(index, 13) == 17);
+    fail_unless(index.empty());
+
+    ref = CertIndexSpill::Ref();
+    spill.find(keys[5], ref);
+    fail_unless(ref.seqno_ == 6);
+    fail_unless(ref.shared_seqno_ == 13);
+
+    /* purged references are not found */
+    spill.purge(6);
+    ref = CertIndexSpill::Ref();
+    spill.find(keys[5], ref);
+    fail_unless(ref.seqno_ == WSREP_SEQNO_UNDEFINED);
+    fail_unless(ref.shared_seqno_ == 13);
+
+    ref = CertIndexSpill::Ref();
+    spill.find(keys[0], ref);
+    fail_unless(ref.seqno_ == WSREP_SEQNO_UNDEFINED);
+
+    /* generations above the limit are merged, newer references win */
+    for (size_t g(0); g < 12; ++g)
+    {
+        KeyEntryNG* const ke(new KeyEntryNG(keys[g]));
+        index.insert(ke);
+        ke->ref(KeySet::Key::P_EXCLUSIVE, keys[g], trx[13 + g]);
+        fail_unless(spill.spill(index, 14 + g) == 1);
+    }
+
+    for (size_t g(0); g < 12; ++g)
+    {
+        ref = CertIndexSpill::Ref();
+        spill.find(keys[g], ref);
+        fail_unless(ref.seqno_ == wsrep_seqno_t(14 + g), "key %zu: %lld", g,
+                    static_cast<long long>(ref.seqno_));
+        fail_unless(*ref.source_ == trx[13 + g]->source_id());
+    }
+
+    ref = CertIndexSpill::Ref();
+    spill.find(keys[40], ref);
+    fail_unless(ref.shared_seqno_ == 10);
+
+    ref = CertIndexSpill::Ref();
+    spill.find(keys[50], ref);
+    fail_unless(ref.seqno_ == 12);
+
+    spill.purge(100);
+    fail_unless(spill.empty());
+
+    for (size_t i(0); i < trx.size(); ++i) trx[i]->unref();
+}
+END_TEST
+
+Suite* cert_index_ng_suite()
+{
+    Suite* s = suite_create("cert_index_ng");
+    TCase* tc;
+
+    tc = tcase_create("test_cert_index_ng");
+    tcase_add_test(tc, test_cert_index_ng);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_cert_index_ng_filter");
+    tcase_add_test(tc, test_cert_index_ng_filter);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_key_entry_ng_shared");
+    tcase_add_test(tc, test_key_entry_ng_shared);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_cert_index_spill");
+    tcase_add_test(tc, test_cert_index_spill);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
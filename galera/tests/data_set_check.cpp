@@ -231,10 +231,83 @@ START_TEST (ver0)
 }
 END_TEST
 
+START_TEST (ver2)
+{
+    /* highly compressible records */
+    TestRecord rout0(1 << 16, "abc0");
+    TestRecord rout1(1 << 12, "abc1");
+
+    std::vector<gu::byte_t> plain;
+    plain.insert(plain.end(),
+                 static_cast<const gu::byte_t*>(rout0.buf()),
+                 static_cast<const gu::byte_t*>(rout0.buf()) +
+                 rout0.serial_size());
+    plain.insert(plain.end(),
+                 static_cast<const gu::byte_t*>(rout1.buf()),
+                 static_cast<const gu::byte_t*>(rout1.buf()) +
+                 rout1.serial_size());
+
+    gu::byte_t reserved[1024];
+    TestBaseName str("data_set_test");
+    DataSetOut dset_out(reserved, sizeof(reserved), str, DataSet::VER2);
+
+    fail_if (DataSet::EMPTY != dset_out.version());
+
+    dset_out.append (rout0.buf(), rout0.serial_size(), true);
+    dset_out.append (rout1.buf(), rout1.serial_size(), false);
+
+    fail_if (1 != dset_out.count());
+    fail_if (DataSet::VER2 != dset_out.version());
+
+    DataSetOut::GatherVector out_bufs;
+    size_t const out_size (dset_out.gather (out_bufs));
+
+    fail_if (out_size >= plain.size(), "Compressed size %zu >= raw size %zu",
+             out_size, plain.size());
+
+    std::vector<gu::byte_t> in_buf;
+    for (size_t i = 0; i < out_bufs->size(); ++i)
+    {
+        const gu::byte_t* ptr
+            (reinterpret_cast<const gu::byte_t*>(out_bufs[i].ptr));
+        in_buf.insert (in_buf.end(), ptr, ptr + out_bufs[i].size);
+    }
+
+    fail_if (in_buf.size() != out_size);
+
+    galera::DataSetIn dset_in(dset_out.version(),
+                              in_buf.data(), in_buf.size());
+    dset_in.checksum();
+
+    fail_if (dset_in.size()  != out_size);
+    fail_if (dset_in.count() != 1);
+
+    gu::Buf const data(dset_in.next());
+    fail_if (size_t(data.size) != plain.size(),
+             "Expected %zu bytes, got %zd", plain.size(), data.size);
+    fail_if (::memcmp(data.ptr, plain.data(), plain.size()));
+
+    TestRecord const rin0(data.ptr, data.size);
+    fail_if (rin0 != rout0);
+
+    /* corrupted payload must be detected */
+    std::vector<gu::byte_t> bad(in_buf);
+    bad[bad.size() - 1] ^= 0xff;
+    galera::DataSetIn dset_bad(dset_out.version(), bad.data(), bad.size());
+    try
+    {
+        dset_bad.checksum();
+        fail("Corrupted data set passed checksum");
+    }
+    catch (gu::Exception& e) {}
+}
+END_TEST
+
 Suite* data_set_suite ()
 {
     TCase* t = tcase_create ("DataSet");
     tcase_add_test (t, ver0);
+    tcase_add_test (t, ver2);
     tcase_set_timeout(t, 60);
 
     Suite* s = suite_create ("DataSet");
@@ -18,8 +18,18 @@ extern Suite* write_set_ng_suite();
 extern Suite* write_set_suite();
 extern Suite* trx_handle_suite();
 extern Suite* service_thd_suite();
+extern Suite* monitor_suite();
+extern Suite* applier_pool_suite();
+extern Suite* applier_advisor_suite();
+extern Suite* preordered_sender_suite();
+extern Suite* cert_index_ng_suite();
+extern Suite* cert_hot_keys_suite();
 extern Suite* ist_suite();
 extern Suite* saved_state_suite();
+extern Suite* metrics_exporter_suite();
+extern Suite* trx_trace_suite();
+extern Suite* repl_qos_suite();
+extern Suite* repl_lag_suite();
 
 static suite_creator_t suites[] =
 {
@@ -29,8 +39,18 @@ static suite_creator_t suites[] =
     write_set_suite,
     trx_handle_suite,
     service_thd_suite,
+    monitor_suite,
+    applier_pool_suite,
+    applier_advisor_suite,
+    preordered_sender_suite,
+    cert_index_ng_suite,
+    cert_hot_keys_suite,
     ist_suite,
     saved_state_suite,
+    metrics_exporter_suite,
+    trx_trace_suite,
+    repl_qos_suite,
+    repl_lag_suite,
     0
 };
 
@@ -0,0 +1,339 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ *
+ * Certification replay of a real write set stream.
+ *
+ * Recovers the ring buffer of a node's gcache file and feeds the cached
+ * write sets to galera::Certification in seqno order, the same way
+ * cert_bench does with synthetic ones. Optionally keeps the original
+ * spacing between write sets (taken from write set timestamps) scaled
+ * by a factor, so bursts and idle periods are reproduced.
+ *
+ * Usage: gcache_replay [-t time scale] [-p purge interval] [-n max trxs]
+ *                      <galera.cache>
+ *
+ * Time scale 0 (default) replays as fast as possible, 1 in original time,
+ * 2 twice as fast and so on. Every purge interval write sets the index is
+ * purged up to the lowest last seen seqno among them, which is what the
+ * cluster would have agreed on as safe. Recovery rewrites the cache
+ * preamble, so run it on a copy of galera.cache, not on the live file.
+ */
+
+#include "certification.hpp"
+#include "replicator_smm.hpp"
+#include "galera_service_thd.hpp"
+#include "trx_handle.hpp"
+
+#include "GCache.hpp"
+#include "gcache_bh.hpp"
+#include "gcache_rb_store.hpp"
+
+#include "gu_time.h"
+
+#include <sys/stat.h>
+#include <cerrno>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <string>
+
+namespace
+{
+    struct Options
+    {
+        Options()
+            :
+            scale (0),
+            purge (128),
+            trxs  (-1),
+            file  ()
+        {}
+
+        double      scale;
+        long        purge;
+        long        trxs; // -1 - all
+        std::string file;
+    };
+
+    void usage(const char* const name)
+    {
+        fprintf(stderr, "Usage: %s [-t time scale] [-p purge interval]"
+                " [-n max trxs] <galera.cache>\n", name);
+    }
+
+    class GCacheFile
+    {
+    public:
+        GCacheFile(gu::Config& conf) : name_("gcache_replay.gcache")
+        {
+            conf.set("gcache.name", name_);
+            conf.set("gcache.size", "1M");
+        }
+
+        ~GCacheFile()
+        {
+            unlink(name_.c_str());
+            unlink((name_ + ".index").c_str());
+        }
+
+    private:
+        std::string const name_;
+    };
+
+    /* certification environment, as in cert_bench */
+    class Env
+    {
+    public:
+
+        Env() :
+            conf_  (),
+            init_  (conf_, NULL, NULL),
+            file_  (conf_),
+            gcache_(conf_, "."),
+            gcs_   (conf_, gcache_),
+            thd_   (gcs_,  gcache_)
+        {}
+
+        gu::Config&         conf() { return conf_; }
+        galera::ServiceThd& thd()  { return thd_;  }
+
+    private:
+
+        gu::Config         conf_;
+        galera::ReplicatorSMM::InitConfig init_;
+        GCacheFile         file_;
+        gcache::GCache     gcache_;
+        galera::DummyGcs   gcs_;
+        galera::ServiceThd thd_;
+    };
+
+    /* the captured cache, opened with recovery on its own size */
+    class Capture
+    {
+    public:
+
+        explicit Capture(const std::string& name) :
+            conf_  (),
+            gcache_(config(conf_, name), "")
+        {}
+
+        gcache::GCache& gcache() { return gcache_; }
+
+    private:
+
+        static gu::Config& config(gu::Config& conf, const std::string& name)
+        {
+            struct stat st;
+            if (stat(name.c_str(), &st))
+            {
+                gu_throw_error(errno) << "Can't stat '" << name << "'";
+            }
+
+            size_t const overhead(gcache::RingBuffer::pad_size() +
+                                  sizeof(gcache::BufferHeader));
+            if (size_t(st.st_size) <= overhead)
+            {
+                gu_throw_error(EINVAL) << "'" << name
+                                       << "' is not a gcache file";
+            }
+
+            gcache::GCache::register_params(conf);
+            conf.set("gcache.name", name);
+            conf.set("gcache.size", gu::to_string(st.st_size - overhead));
+            conf.set("gcache.recover", "yes");
+            conf.set("gcache.page_prealloc", "0");
+
+            return conf;
+        }
+
+        gu::Config     conf_;
+        gcache::GCache gcache_;
+    };
+
+    /* sleeps until the write set is due, ts is the origin timestamp */
+    class Pacer
+    {
+    public:
+
+        explicit Pacer(double const scale) : scale_(scale), ts0_(0), t0_(0) {}
+
+        void wait(long long const ts)
+        {
+            if (scale_ <= 0 || ts <= 0) return;
+
+            if (0 == ts0_)
+            {
+                ts0_ = ts;
+                t0_  = gu_time_monotonic();
+                return;
+            }
+
+            long long const due(t0_ + static_cast<long long>
+                                ((ts - ts0_) / scale_));
+            long long const now(gu_time_monotonic());
+
+            if (due > now) usleep((due - now) / 1000);
+        }
+
+    private:
+
+        double const scale_;
+        long long    ts0_; // origin time of the first write set
+        long long    t0_;  // local time of the first write set
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    int c;
+
+    while ((c = getopt(argc, argv, "t:p:n:")) != -1)
+    {
+        switch (c)
+        {
+        case 't': opt.scale  = strtod(optarg, NULL);     break;
+        case 'p': opt.purge  = strtol(optarg, NULL, 10); break;
+        case 'n': opt.trxs   = strtol(optarg, NULL, 10); break;
+        default:  usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (optind + 1 != argc || opt.scale < 0 || opt.purge <= 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    opt.file = argv[optind];
+
+    gu_conf_self_tstamp_on();
+
+    try
+    {
+        Capture cap(opt.file);
+        gcache::GCache& gc(cap.gcache());
+
+        wsrep_seqno_t const first(gc.seqno_min());
+        if (first <= 0)
+        {
+            fprintf(stderr, "No write sets recovered from '%s'\n",
+                    opt.file.c_str());
+            return EXIT_FAILURE;
+        }
+
+        Env env;
+        galera::Certification cert(env.conf(), env.thd());
+        galera::TrxHandle::SlavePool sp(sizeof(galera::TrxHandle), 16,
+                                        "gcache_replay_sp");
+        Pacer pacer(opt.scale);
+
+        long long cert_ns(0), keys(0), bytes(0), ts_first(0), ts_last(0);
+        long      trxs(0), skipped(0), failed(0), failed_orig(0);
+        bool      initialized(false);
+        wsrep_seqno_t safe(WSREP_SEQNO_UNDEFINED); // lowest last seen
+
+        std::vector<gcache::GCache::Buffer> bufs(1024);
+        wsrep_seqno_t next(first);
+        long long const start(gu_time_monotonic());
+        size_t n;
+
+        while ((opt.trxs < 0 || trxs < opt.trxs) &&
+               (n = gc.seqno_get_buffers(bufs, next)) > 0)
+        {
+            for (size_t i(0); i < n && (opt.trxs < 0 || trxs < opt.trxs); ++i)
+            {
+                const gcache::GCache::Buffer& b(bufs[i]);
+                wsrep_seqno_t const seqno(b.seqno_g());
+
+                galera::TrxHandle* const trx(galera::TrxHandle::New(sp));
+
+                try
+                {
+                    trx->unserialize(b.ptr(), b.size(), 0);
+                }
+                catch (gu::Exception&)
+                {
+                    /* not a write set or unsupported version */
+                    trx->unref();
+                    ++skipped;
+                    continue;
+                }
+
+                if (!trx->new_version())
+                {
+                    trx->unref();
+                    ++skipped;
+                    continue;
+                }
+
+                if (!initialized)
+                {
+                    cert.assign_initial_position(seqno - 1, trx->version());
+                    initialized = true;
+                }
+
+                long long const ts(trx->write_set_in().timestamp());
+                if (0 == ts_first) ts_first = ts;
+                ts_last = ts;
+
+                pacer.wait(ts);
+
+                trx->set_received(0, seqno, seqno);
+
+                if (WSREP_SEQNO_UNDEFINED == safe ||
+                    trx->last_seen_seqno() < safe)
+                {
+                    safe = trx->last_seen_seqno();
+                }
+
+                long long const t0(gu_time_monotonic());
+                galera::Certification::prepare(trx);
+                galera::Certification::TestResult const res
+                    (cert.append_trx(trx));
+                cert_ns += gu_time_monotonic() - t0;
+
+                if (galera::Certification::TEST_FAILED == res) ++failed;
+                if (b.seqno_d() < 0) ++failed_orig;
+
+                keys  += trx->write_set_in().keyset().count();
+                bytes += b.size();
+                ++trxs;
+
+                cert.set_trx_committed(trx);
+                trx->unref();
+
+                if (0 == trxs % opt.purge)
+                {
+                    if (safe > 0) cert.purge_trxs_upto(safe, false);
+                    safe = WSREP_SEQNO_UNDEFINED;
+                }
+            }
+
+            next = bufs[n - 1].seqno_g() + 1;
+        }
+
+        gc.seqno_unlock();
+
+        double const wall((gu_time_monotonic() - start) * 1.0e-9);
+        double const orig((ts_last - ts_first) * 1.0e-9);
+
+        printf("replayed: %ld write sets (%lld bytes, %lld keys) from "
+               "seqno %lld, %ld skipped\n", trxs, bytes, keys,
+               static_cast<long long>(first), skipped);
+        printf("time:     %.3f s, originally %.3f s, time scale %.2f\n",
+               wall, orig, opt.scale);
+        printf("certify:  %8.1f ns/key, %8.1f us/trx\n",
+               keys ? double(cert_ns) / keys : 0.0,
+               trxs ? cert_ns / 1000.0 / trxs : 0.0);
+        printf("failed:   %ld, originally %ld\n", failed, failed_orig);
+    }
+    catch (std::exception& e)
+    {
+        fprintf(stderr, "Replay failed: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
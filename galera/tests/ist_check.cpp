@@ -74,7 +74,8 @@ public:
     void unlock() { }
     wsrep_seqno_t seqno() const { return trx_.global_seqno(); }
     bool condition(wsrep_seqno_t last_entered,
-                   wsrep_seqno_t last_left) const
+                   wsrep_seqno_t last_left,
+                   const galera::Monitor<TestOrder>&) const
     {
         return (last_left >= trx_.depends_seqno());
     }
@@ -92,16 +93,22 @@ struct sender_args
     wsrep_seqno_t first_;
     wsrep_seqno_t last_;
     int version_;
+    int streams_;
+    bool keep_keys_;
+    bool compress_;
     sender_args(gcache::GCache& gcache,
                 const std::string& peer,
                 wsrep_seqno_t first, wsrep_seqno_t last,
-                int version)
+                int version, int streams, bool keep_keys, bool compress)
         :
         gcache_(gcache),
         peer_  (peer),
         first_ (first),
         last_  (last),
-        version_(version)
+        version_(version),
+        streams_(streams),
+        keep_keys_(keep_keys),
+        compress_(compress)
     { }
 };
 
@@ -114,17 +121,20 @@ struct receiver_args
     size_t        n_receivers_;
     TrxHandle::SlavePool& trx_pool_;
     int           version_;
+    int           streams_;
 
     receiver_args(const std::string listen_addr,
                   wsrep_seqno_t first, wsrep_seqno_t last,
-                  size_t n_receivers, TrxHandle::SlavePool& sp, int version)
+                  size_t n_receivers, TrxHandle::SlavePool& sp, int version,
+                  int streams)
         :
         listen_addr_(listen_addr),
         first_      (first),
         last_       (last),
         n_receivers_(n_receivers),
         trx_pool_   (sp),
-        version_    (version)
+        version_    (version),
+        streams_    (streams)
     { }
 };
 
@@ -147,11 +157,21 @@ extern "C" void* sender_thd(void* arg)
 
     gu::Config conf;
     galera::ReplicatorSMM::InitConfig(conf, NULL, NULL);
+    conf.set("ist.streams", gu::to_string(sargs->streams_));
+    conf.set("ist.keep_keys", gu::to_string(sargs->keep_keys_));
+    conf.set("ist.compression", sargs->compress_ ? "zlib" : "off");
     gu_barrier_wait(&start_barrier);
     galera::ist::Sender sender(conf, sargs->gcache_, sargs->peer_,
                                sargs->version_);
     mark_point();
     sender.send(sargs->first_, sargs->last_);
+
+    galera::ist::Stats st;
+    sender.stats_get(st);
+    fail_unless(st.first == sargs->first_ && st.last == sargs->last_);
+    fail_unless(st.current == sargs->last_, "sent up to %lld",
+                static_cast<long long>(st.current));
+    fail_unless(st.bytes > 0 && st.eta == 0);
     return 0;
 }
 
@@ -191,6 +211,7 @@ extern "C" void* receiver_thd(void* arg)
     mark_point();
 
     conf.set(galera::ist::Receiver::RECV_ADDR, rargs->listen_addr_);
+    conf.set("ist.streams", gu::to_string(rargs->streams_));
     galera::ist::Receiver receiver(conf, rargs->trx_pool_, 0);
     rargs->listen_addr_ = receiver.prepare(rargs->first_, rargs->last_,
                                            rargs->version_);
@@ -216,6 +237,13 @@ extern "C" void* receiver_thd(void* arg)
     }
 
     receiver.finished();
+
+    galera::ist::Stats st;
+    receiver.stats_get(st);
+    fail_unless(st.first == rargs->first_ && st.last == rargs->last_);
+    fail_unless(st.current == rargs->last_, "received up to %lld",
+                static_cast<long long>(st.current));
+    fail_unless(st.queue == 0 && st.bytes > 0 && st.eta == 0);
     return 0;
 }
 
@@ -239,7 +267,10 @@ static int select_trx_version(int protocol_version)
 }
 
 
-static void test_ist_common(int const version)
+static void test_ist_common(int const version, int const streams = 1,
+                            bool const keep_keys = true,
+                            size_t const n_receivers = 1,
+                            bool const compress = false)
 {
     using galera::KeyData;
     using galera::TrxHandle;
@@ -323,8 +354,10 @@ static void test_ist_common(int const version)
 
     mark_point();
 
-    receiver_args rargs(receiver_addr, 1, 10, 1, sp, version);
-    sender_args sargs(*gcache, rargs.listen_addr_, 1, 10, version);
+    receiver_args rargs(receiver_addr, 1, 10, n_receivers, sp, version,
+                        streams);
+    sender_args sargs(*gcache, rargs.listen_addr_, 1, 10, version, streams,
+                      keep_keys, compress);
 
     gu_barrier_init(&start_barrier, 0, 1 + 1 + rargs.n_receivers_);
 
@@ -345,6 +378,7 @@ static void test_ist_common(int const version)
 
     mark_point();
     unlink(gcache_file.c_str());
+    unlink((gcache_file + ".index").c_str());
 }
 
 
@@ -381,6 +415,30 @@ START_TEST(test_ist_v5)
 }
 END_TEST
 
+START_TEST(test_ist_streams)
+{
+    test_ist_common(5, 3);
+}
+END_TEST
+
+START_TEST(test_ist_no_keys)
+{
+    test_ist_common(5, 1, false);
+}
+END_TEST
+
+START_TEST(test_ist_parallel_apply)
+{
+    test_ist_common(5, 2, true, 4);
+}
+END_TEST
+
+START_TEST(test_ist_compression)
+{
+    test_ist_common(5, 2, true, 1, true);
+}
+END_TEST
+
 Suite* ist_suite()
 {
     Suite* s  = suite_create("ist");
@@ -415,5 +473,25 @@ Suite* ist_suite()
     tcase_add_test(tc, test_ist_v5);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("test_ist_streams");
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, test_ist_streams);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_ist_no_keys");
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, test_ist_no_keys);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_ist_parallel_apply");
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, test_ist_parallel_apply);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_ist_compression");
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, test_ist_compression);
+    suite_add_tcase(s, tc);
+
     return s;
 }
@@ -13,6 +13,8 @@
 
 #include <check.h>
 
+#include <cstdio> // snprintf()
+
 using namespace galera;
 
 class TestBaseName : public gu::Allocator::BaseName
@@ -237,10 +239,105 @@ START_TEST (ver0)
 }
 END_TEST
 
+/* rows of several tables appended in turn: common prefixes must be stored
+ * once and remembered values must survive reuse of the caller's buffers */
+START_TEST (interleaved)
+{
+    KeySet::Version const tk_ver(KeySet::FLAT16A);
+
+    gu::byte_t reserved[1024];
+    TestBaseName const str("key_set_test");
+    KeySetOut kso (reserved, sizeof(reserved), str, tk_ver);
+
+    int const tables(3);
+    int const rows(5);
+
+    for (int pass(0); pass < 2; ++pass)
+    {
+        for (int r(0); r < rows; ++r)
+        {
+            for (int t(0); t < tables; ++t)
+            {
+                char table[8];
+                char row[8];
+                snprintf(table, sizeof(table), "t%d", t);
+                snprintf(row,   sizeof(row),   "r%d", r);
+
+                TestKey tk(tk_ver, SHARED, true, "db", table, row);
+                kso.append(tk());
+
+                /* volatile key data */
+                memset(table, 'x', sizeof(table));
+                memset(row,   'x', sizeof(row));
+            }
+        }
+
+        /* second pass appends only duplicates */
+        fail_if (kso.count() != 1 + tables + tables * rows,
+                 "pass %d: key count: expected %d, got %d", pass,
+                 1 + tables + tables * rows, kso.count());
+    }
+
+    /* exclusive table key is added once and covers its rows */
+    TestKey tk_t1(tk_ver, EXCLUSIVE, false, "db", "t1");
+    kso.append(tk_t1());
+    kso.append(tk_t1());
+    fail_if (kso.count() != 2 + tables + tables * rows,
+             "key count: expected %d, got %d",
+             2 + tables + tables * rows, kso.count());
+
+    TestKey tk_r(tk_ver, SHARED, false, "db", "t1", "r9");
+    kso.append(tk_r());
+    fail_if (kso.count() != 2 + tables + tables * rows,
+             "key count: expected %d, got %d",
+             2 + tables + tables * rows, kso.count());
+
+    TestKey tk_n(tk_ver, SHARED, false, "db", "t2", "r9");
+    kso.append(tk_n());
+    fail_if (kso.count() != 3 + tables + tables * rows,
+             "key count: expected %d, got %d",
+             3 + tables + tables * rows, kso.count());
+}
+END_TEST
+
+START_TEST (matches)
+{
+    KeySet::KeyPart::HashData hash;
+    for (size_t i(0); i < sizeof(hash.buf); ++i) hash.buf[i] = i * 17 + 1;
+
+    KeySet::KeyPart::TmpStore ts1, ts2, ts3, ts4;
+
+    /* header bits differ, hashes are the same */
+    KeySet::KeyPart const kp16 (ts1, hash, KeySet::FLAT16, false, NULL, 0);
+    KeySet::KeyPart const kp16x(ts2, hash, KeySet::FLAT16, true,  NULL, 0);
+    fail_unless(kp16.matches(kp16x));
+    fail_unless(kp16x.matches(kp16));
+
+    /* FLAT8 key compares only the first 8 bytes */
+    KeySet::KeyPart const kp8  (ts3, hash, KeySet::FLAT8, false, NULL, 0);
+
+    hash.buf[12] ^= 0x80;
+    KeySet::KeyPart const kp16d(ts4, hash, KeySet::FLAT16, false, NULL, 0);
+    fail_if(kp16.matches(kp16d));
+    fail_if(kp16d.matches(kp16));
+    fail_unless(kp8.matches(kp16d));
+    fail_unless(kp16d.matches(kp8));
+
+    /* highest bit of the first word */
+    hash.buf[12] ^= 0x80;
+    hash.buf[7]  ^= 0x80;
+    KeySet::KeyPart const kp8d (ts4, hash, KeySet::FLAT8, false, NULL, 0);
+    fail_if(kp8.matches(kp8d));
+    fail_if(kp16.matches(kp8d));
+}
+END_TEST
+
 Suite* key_set_suite ()
 {
     TCase* t = tcase_create ("KeySet");
     tcase_add_test (t, ver0);
+    tcase_add_test (t, interleaved);
+    tcase_add_test (t, matches);
     tcase_set_timeout(t, 60);
 
     Suite* s = suite_create ("KeySet");
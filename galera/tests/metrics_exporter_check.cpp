@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "../src/metrics_exporter.hpp"
+
+#include <gu_mem.h>
+
+#include <check.h>
+
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace
+{
+    struct wsrep_stats_var* make_stats()
+    {
+        struct wsrep_stats_var* const sv(static_cast<struct wsrep_stats_var*>
+                                         (gu_malloc(6 * sizeof(*sv))));
+        sv[0].name = "local_commits";
+        sv[0].type = WSREP_VAR_INT64;
+        sv[0].value._int64 = 42;
+        sv[1].name = "apply_oooe";
+        sv[1].type = WSREP_VAR_DOUBLE;
+        sv[1].value._double = 0.5;
+        sv[2].name = "local_state_comment";
+        sv[2].type = WSREP_VAR_STRING;
+        sv[2].value._string = "Synced";
+        sv[3].name = "evs_Delay.Count";
+        sv[3].type = WSREP_VAR_STRING;
+        sv[3].value._string = "17";
+        sv[4].name = "empty";
+        sv[4].type = WSREP_VAR_STRING;
+        sv[4].value._string = "";
+        sv[5].name = 0;
+        sv[5].type = WSREP_VAR_STRING;
+        sv[5].value._string = 0;
+        return sv;
+    }
+
+    class TestSource : public galera::MetricsExporter::Source
+    {
+    public:
+        TestSource() : calls_(0) {}
+
+        const struct wsrep_stats_var* stats_get() const
+        {
+            ++calls_;
+            return make_stats();
+        }
+
+        void stats_free(struct wsrep_stats_var* sv) { gu_free(sv); }
+
+        int calls() const { return calls_; }
+
+    private:
+        mutable int calls_;
+    };
+}
+
+START_TEST(test_format)
+{
+    struct wsrep_stats_var* const sv(make_stats());
+
+    std::ostringstream os;
+    galera::MetricsExporter::format(sv, os);
+    gu_free(sv);
+
+    fail_unless(os.str() ==
+                "wsrep_local_commits 42\n"
+                "wsrep_apply_oooe 0.5\n"
+                "wsrep_evs_delay_count 17\n",
+                "unexpected output:\n%s", os.str().c_str());
+}
+END_TEST
+
+START_TEST(test_write)
+{
+    std::string const file("metrics_exporter_check.prom");
+    unlink(file.c_str());
+
+    TestSource src;
+    galera::MetricsExporter me(src, "", gu::datetime::Period("PT0.01S"));
+
+    usleep(50000);
+    fail_unless(src.calls() == 0, "exported while disabled");
+
+    me.set_file(file);
+
+    for (int i(0); i < 100 && access(file.c_str(), R_OK) != 0; ++i)
+    {
+        usleep(10000);
+    }
+
+    me.stop();
+    fail_unless(src.calls() > 0);
+
+    std::ifstream is(file.c_str());
+    std::string line;
+    std::getline(is, line);
+    fail_unless(line == "wsrep_local_commits 42", "got '%s'", line.c_str());
+
+    fail_unless(access((file + ".tmp").c_str(), F_OK) != 0);
+    unlink(file.c_str());
+}
+END_TEST
+
+Suite* metrics_exporter_suite()
+{
+    Suite* s = suite_create("metrics_exporter");
+    TCase* tc;
+
+    tc = tcase_create("test_format");
+    tcase_add_test(tc, test_format);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_write");
+    tcase_add_test(tc, test_write);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ *
+ * Apply and commit monitor microbenchmark.
+ *
+ * Applier threads take seqnos round robin and run every one through an
+ * apply monitor, "apply" it by spinning for the given number of
+ * iterations and then through a commit monitor, the path every slave
+ * write set takes in ReplicatorSMM. Apply monitor condition is that of
+ * ApplyOrder: a write set may enter once its certification dependency
+ * has left, commit monitor enters in strict seqno order. With conflict %
+ * probability a write set depends on the one right before it, otherwise
+ * on one up to dependency window write sets back, picked with a fixed
+ * seed before the measurement starts.
+ *
+ * Usage: monitor_bench [-t applier threads] [-n trxs] [-c conflict %]
+ *                      [-d dependency window] [-w apply work]
+ *                      [-s monitor spin]
+ *
+ * Reports throughput and the apply monitor's out of order entry fraction
+ * and average window, which is where parallel applying comes from.
+ */
+
+#include "monitor.hpp"
+
+#include "gu_time.h"
+
+#include <algorithm>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        Options()
+            :
+            threads (4),
+            trxs    (200000),
+            conflict(10),
+            window  (16),
+            work    (1000),
+            spin    (0)
+        {}
+
+        long threads;
+        long trxs;
+        long conflict; // %
+        long window;
+        long work;
+        long spin;
+    };
+
+    void usage(const char* const name)
+    {
+        fprintf(stderr, "Usage: %s [-t applier threads] [-n trxs]"
+                " [-c conflict %%] [-d dependency window] [-w apply work]"
+                " [-s monitor spin]\n", name);
+    }
+
+    /* simple LCG to be independent of libc rand() */
+    class Rand
+    {
+    public:
+        Rand() : x_(0x1234567ULL) {}
+        long operator()(long const n)
+        {
+            x_ = x_ * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<long>((x_ >> 33) % n);
+        }
+    private:
+        unsigned long long x_;
+    };
+
+    class ApplyOrder
+    {
+    public:
+        ApplyOrder(wsrep_seqno_t seqno, wsrep_seqno_t depends)
+            : seqno_(seqno), depends_(depends) { }
+        void lock()   { }
+        void unlock() { }
+        wsrep_seqno_t seqno() const { return seqno_; }
+        bool condition(wsrep_seqno_t, wsrep_seqno_t const last_left,
+                       const galera::Monitor<ApplyOrder>&) const
+        {
+            return (last_left >= depends_);
+        }
+#ifdef GU_DBUG_ON
+        void debug_sync(gu::Mutex&) { }
+#endif // GU_DBUG_ON
+    private:
+        wsrep_seqno_t const seqno_;
+        wsrep_seqno_t const depends_;
+    };
+
+    class CommitOrder
+    {
+    public:
+        CommitOrder(wsrep_seqno_t seqno) : seqno_(seqno) { }
+        void lock()   { }
+        void unlock() { }
+        wsrep_seqno_t seqno() const { return seqno_; }
+        bool condition(wsrep_seqno_t, wsrep_seqno_t const last_left,
+                       const galera::Monitor<CommitOrder>&) const
+        {
+            return (last_left + 1 == seqno_);
+        }
+#ifdef GU_DBUG_ON
+        void debug_sync(gu::Mutex&) { }
+#endif // GU_DBUG_ON
+    private:
+        wsrep_seqno_t const seqno_;
+    };
+
+    /* this variable serves to prevent compiler from optimizing out the
+     * apply work */
+    long volatile sink(0);
+
+    struct Applier
+    {
+        const Options*                    opt;
+        const std::vector<wsrep_seqno_t>* depends;
+        galera::Monitor<ApplyOrder>*      apply_monitor;
+        galera::Monitor<CommitOrder>*     commit_monitor;
+        long                              idx;
+    };
+
+    void* applier_thread(void* const arg)
+    {
+        const Applier& a(*static_cast<Applier*>(arg));
+
+        for (long s(a.idx + 1); s <= a.opt->trxs; s += a.opt->threads)
+        {
+            ApplyOrder ao(s, (*a.depends)[s]);
+            a.apply_monitor->enter(ao);
+
+            long h(s);
+            for (long w(0); w < a.opt->work; ++w) h = h * 31 + w;
+            sink += h;
+
+            CommitOrder co(s);
+            a.commit_monitor->enter(co);
+            a.apply_monitor->leave(ao);
+            a.commit_monitor->leave(co);
+        }
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    int c;
+
+    while ((c = getopt(argc, argv, "t:n:c:d:w:s:")) != -1)
+    {
+        long const val(optarg ? strtol(optarg, NULL, 10) : 0);
+
+        switch (c)
+        {
+        case 't': opt.threads  = val; break;
+        case 'n': opt.trxs     = val; break;
+        case 'c': opt.conflict = val; break;
+        case 'd': opt.window   = val; break;
+        case 'w': opt.work     = val; break;
+        case 's': opt.spin     = val; break;
+        default:  usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (opt.threads <= 0 || opt.trxs <= 0 || opt.conflict < 0 ||
+        opt.conflict > 100 || opt.window <= 0 || opt.work < 0 || opt.spin < 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gu_conf_self_tstamp_on();
+
+    Rand rnd;
+    std::vector<wsrep_seqno_t> depends(opt.trxs + 1);
+    for (long s(1); s <= opt.trxs; ++s)
+    {
+        long const dist(rnd(100) < opt.conflict ? 1 : 1 + rnd(opt.window));
+        depends[s] = std::max(s - dist, 0L);
+    }
+
+    galera::Monitor<ApplyOrder>  apply_monitor(opt.spin);
+    galera::Monitor<CommitOrder> commit_monitor(opt.spin);
+    apply_monitor.set_initial_position(0);
+    commit_monitor.set_initial_position(0);
+
+    std::vector<Applier>     appliers(opt.threads);
+    std::vector<gu_thread_t> threads(opt.threads);
+
+    long long const start(gu_time_monotonic());
+
+    for (long i(0); i < opt.threads; ++i)
+    {
+        Applier const a = { &opt, &depends, &apply_monitor, &commit_monitor,
+                            i };
+        appliers[i] = a;
+        if (gu_thread_create(&threads[i], 0, applier_thread, &appliers[i]))
+        {
+            perror("gu_thread_create");
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (long i(0); i < opt.threads; ++i) gu_thread_join(threads[i], 0);
+
+    long long const ns(gu_time_monotonic() - start);
+
+    double oooe, oool, win_size;
+    apply_monitor.get_stats(&oooe, &oool, &win_size);
+
+    printf("threads: %ld, trxs: %ld, conflict: %ld%%, window: %ld, "
+           "work: %ld, spin: %ld\n", opt.threads, opt.trxs, opt.conflict,
+           opt.window, opt.work, opt.spin);
+    printf("apply:       %8.1f ns/trx, %10.0f trx/s\n",
+           double(ns) / opt.trxs, opt.trxs / (ns * 1.0e-9));
+    printf("apply mon:   oooe %.3f, oool %.3f, window %.2f\n",
+           oooe, oool, win_size);
+
+    return EXIT_SUCCESS;
+}
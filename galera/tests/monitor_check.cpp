@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "../src/monitor.hpp"
+
+#include <check.h>
+#include <unistd.h> // usleep()
+
+namespace
+{
+    class SeqOrder
+    {
+    public:
+        SeqOrder(wsrep_seqno_t seqno) : seqno_(seqno) { }
+        void lock()   { }
+        void unlock() { }
+        wsrep_seqno_t seqno() const { return seqno_; }
+        bool condition(wsrep_seqno_t last_entered,
+                       wsrep_seqno_t last_left,
+                       const galera::Monitor<SeqOrder>&) const
+        {
+            return (last_left + 1 == seqno_);
+        }
+#ifdef GU_DBUG_ON
+        void debug_sync(gu::Mutex&) { }
+#endif // GU_DBUG_ON
+    private:
+        wsrep_seqno_t const seqno_;
+    };
+
+    static int const N_THREADS = 4;
+    static wsrep_seqno_t const N_SEQNOS = 10000;
+
+    struct ThreadArgs
+    {
+        galera::Monitor<SeqOrder>* monitor_;
+        wsrep_seqno_t*             last_;
+        int                        idx_;
+        bool                       ok_;
+    };
+
+    void* seq_thread(void* arg)
+    {
+        ThreadArgs* const args(static_cast<ThreadArgs*>(arg));
+
+        for (wsrep_seqno_t s(args->idx_ + 1); s <= N_SEQNOS; s += N_THREADS)
+        {
+            SeqOrder so(s);
+            args->monitor_->enter(so);
+            if (*args->last_ + 1 != s) args->ok_ = false;
+            *args->last_ = s;
+            args->monitor_->leave(so);
+        }
+
+        return 0;
+    }
+
+    static void run_seq_threads(int const spin)
+    {
+        galera::Monitor<SeqOrder> monitor(spin);
+        monitor.set_initial_position(0);
+
+        wsrep_seqno_t last(0);
+        gu_thread_t   threads[N_THREADS];
+        ThreadArgs    args[N_THREADS];
+
+        for (int i(0); i < N_THREADS; ++i)
+        {
+            ThreadArgs const a = { &monitor, &last, i, true };
+            args[i] = a;
+            gu_thread_create(&threads[i], 0, seq_thread, &args[i]);
+        }
+
+        for (int i(0); i < N_THREADS; ++i)
+        {
+            gu_thread_join(threads[i], 0);
+            fail_unless(args[i].ok_, "out of order enter in thread %d", i);
+        }
+
+        fail_unless(last == N_SEQNOS);
+        fail_unless(monitor.last_left() == N_SEQNOS);
+    }
+}
+
+START_TEST(test_monitor_block)
+{
+    run_seq_threads(0);
+}
+END_TEST
+
+START_TEST(test_monitor_spin)
+{
+    run_seq_threads(1 << 12);
+}
+END_TEST
+
+namespace
+{
+    struct GroupArgs
+    {
+        galera::Monitor<SeqOrder>* monitor_;
+        wsrep_seqno_t              seqno_;
+    };
+
+    void* group_thread(void* arg)
+    {
+        GroupArgs* const args(static_cast<GroupArgs*>(arg));
+        SeqOrder so(args->seqno_);
+        args->monitor_->enter(so);
+        args->monitor_->leave(so);
+        return 0;
+    }
+}
+
+START_TEST(test_monitor_waiting_upto)
+{
+    galera::Monitor<SeqOrder> monitor;
+    monitor.set_initial_position(0);
+
+    SeqOrder so1(1);
+    monitor.enter(so1);
+    fail_unless(monitor.waiting_upto(1) == 1);
+
+    static int const n_waiters(3);
+    gu_thread_t threads[n_waiters];
+    GroupArgs   args[n_waiters];
+
+    for (int i(0); i < n_waiters; ++i)
+    {
+        GroupArgs const a = { &monitor, i + 2 };
+        args[i] = a;
+        gu_thread_create(&threads[i], 0, group_thread, &args[i]);
+    }
+
+    for (int count(1000); count > 0 && monitor.waiting_upto(1) != 4; --count)
+    {
+        usleep(1000);
+    }
+
+    fail_unless(monitor.waiting_upto(1) == 4,
+                "waiting upto: %lld", monitor.waiting_upto(1));
+    fail_unless(monitor.waiting_upto(2) == 4);
+
+    monitor.leave(so1);
+
+    for (int i(0); i < n_waiters; ++i) gu_thread_join(threads[i], 0);
+
+    fail_unless(monitor.last_left() == 4);
+    fail_unless(monitor.waiting_upto(4) == 4);
+}
+END_TEST
+
+START_TEST(test_monitor_grow)
+{
+    galera::Monitor<SeqOrder> monitor(0, 10);
+    fail_unless(monitor.size() == 16, "size: %zd", monitor.size());
+    monitor.set_initial_position(0);
+
+    SeqOrder so1(1);
+    monitor.enter(so1);
+
+    /* seqnos 2-15 wait in their slots, 16-20 wait for window space */
+    static int const n_waiters(19);
+    gu_thread_t threads[n_waiters];
+    GroupArgs   args[n_waiters];
+
+    for (int i(0); i < n_waiters; ++i)
+    {
+        GroupArgs const a = { &monitor, i + 2 };
+        args[i] = a;
+        gu_thread_create(&threads[i], 0, group_thread, &args[i]);
+    }
+
+    for (int count(1000); count > 0 && monitor.waiting_upto(1) != 15; --count)
+    {
+        usleep(1000);
+    }
+    fail_unless(monitor.waiting_upto(1) == 15,
+                "waiting upto: %lld", monitor.waiting_upto(1));
+
+    monitor.set_size(64);
+    fail_unless(monitor.size() == 64);
+
+    for (int count(1000); count > 0 && monitor.waiting_upto(1) != 20; --count)
+    {
+        usleep(1000);
+    }
+    fail_unless(monitor.waiting_upto(1) == 20,
+                "waiting upto: %lld", monitor.waiting_upto(1));
+
+    try
+    {
+        monitor.set_size(32);
+        fail("shrinking window must fail");
+    }
+    catch (gu::Exception& e)
+    {
+        fail_unless(e.get_errno() == EINVAL);
+    }
+
+    monitor.leave(so1);
+
+    for (int i(0); i < n_waiters; ++i) gu_thread_join(threads[i], 0);
+
+    fail_unless(monitor.last_left() == 20);
+}
+END_TEST
+
+Suite* monitor_suite()
+{
+    Suite* s = suite_create("monitor");
+    TCase* tc;
+
+    tc = tcase_create("test_monitor_block");
+    tcase_add_test(tc, test_monitor_block);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_monitor_spin");
+    tcase_add_test(tc, test_monitor_spin);
+    tcase_set_timeout(tc, 60);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_monitor_waiting_upto");
+    tcase_add_test(tc, test_monitor_waiting_upto);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_monitor_grow");
+    tcase_add_test(tc, test_monitor_grow);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
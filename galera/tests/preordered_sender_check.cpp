@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "../src/preordered_sender.hpp"
+#include "../src/write_set_ng.hpp"
+
+#include <check.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace galera;
+
+namespace
+{
+    /* records sent actions, holds the first send until released */
+    class RecordingGcs : public DummyGcs
+    {
+    public:
+
+        RecordingGcs() : DummyGcs(), mtx_(), cond_(), acts_(), held_(true),
+                entered_(false) {}
+
+        ssize_t sendv(const WriteSetVector& actv, size_t const act_len,
+                      gcs_act_type_t, bool)
+        {
+            gu::Lock lock(mtx_);
+
+            entered_ = true;
+            cond_.broadcast();
+            while (held_) lock.wait(cond_);
+
+            acts_.push_back(std::vector<gu::byte_t>());
+            std::vector<gu::byte_t>& act(acts_.back());
+            act.reserve(act_len);
+            for (size_t i(0); i < actv->size(); ++i)
+            {
+                const gu::byte_t* const ptr
+                    (static_cast<const gu::byte_t*>(actv[i].ptr));
+                act.insert(act.end(), ptr, ptr + actv[i].size);
+            }
+
+            return act_len;
+        }
+
+        void wait_entered()
+        {
+            gu::Lock lock(mtx_);
+            while (!entered_) lock.wait(cond_);
+        }
+
+        void release()
+        {
+            gu::Lock lock(mtx_);
+            held_ = false;
+            cond_.broadcast();
+        }
+
+        std::vector<std::vector<gu::byte_t> >& acts() { return acts_; }
+
+    private:
+
+        gu::Mutex mtx_;
+        gu::Cond  cond_;
+        std::vector<std::vector<gu::byte_t> > acts_;
+        bool held_;
+        bool entered_;
+    };
+
+    void submit(PreorderedSender& ps, const wsrep_uuid_t& source,
+                const char* const str, int const pa_range)
+    {
+        PreorderedSender::Event* const ev(new PreorderedSender::Event());
+        ev->append(str, strlen(str));
+        ps.submit(ev, source, WriteSetNG::F_COMMIT, pa_range);
+    }
+
+    /* checks that action contains given events and returns its trx id */
+    wsrep_trx_id_t check_act(const std::vector<gu::byte_t>& act,
+                             const char* const evs, int const pa_range)
+    {
+        WriteSetIn ws;
+        ws.read_buf(&act[0], act.size());
+
+        fail_unless(ws.pa_range() == pa_range + 2, "pa_range: %d",
+                    ws.pa_range());
+
+        /* data set is a single buffer of concatenated events */
+        const DataSetIn& ds(ws.dataset());
+        fail_unless(ds.count() == 1, "records: %d", ds.count());
+        ds.rewind();
+
+        gu::Buf const buf(ds.next());
+        std::string const str(static_cast<const char*>(buf.ptr), buf.size);
+        fail_unless(str == evs, "expected '%s', got '%s'", evs, str.c_str());
+
+        return ws.trx_id();
+    }
+}
+
+START_TEST(test_preordered_sender)
+{
+    RecordingGcs gcs;
+    TrxHandle::Params const params("", 3, KeySet::MAX_VERSION);
+    gu::Atomic<long long> id(0);
+    wsrep_uuid_t const a = {{1, }};
+    wsrep_uuid_t const b = {{2, }};
+
+    PreorderedSender disabled(gcs, params, id, 1);
+    fail_if(disabled.enabled());
+
+    PreorderedSender ps(gcs, params, id, 3);
+    fail_unless(ps.enabled());
+
+    submit(ps, a, "e1", 4);
+    gcs.wait_entered(); // e1 is on the wire, the rest queue up behind it
+
+    submit(ps, a, "e2", 4);
+    submit(ps, a, "e3", 2);
+    submit(ps, a, "e4", 4);
+    submit(ps, a, "e5", 4); // batch limit
+    submit(ps, b, "e6", 4); // different source
+
+    gcs.release();
+    ps.flush();
+
+    std::vector<std::vector<gu::byte_t> >& acts(gcs.acts());
+    fail_unless(acts.size() == 4, "actions: %zu", acts.size());
+
+    fail_unless(check_act(acts[0], "e1",     4) == 1);
+    fail_unless(check_act(acts[1], "e2e3e4", 2) == 2); // minimal pa_range
+    fail_unless(check_act(acts[2], "e5",     4) == 3);
+    fail_unless(check_act(acts[3], "e6",     4) == 4);
+
+    long long events, actions;
+    ps.stats_get(events, actions);
+    fail_unless(events  == 6, "events: %lld",  events);
+    fail_unless(actions == 4, "actions: %lld", actions);
+
+    /* can be restarted after close */
+    ps.close();
+    submit(ps, b, "e7", 0);
+    ps.close();
+    fail_unless(acts.size() == 5, "actions: %zu", acts.size());
+}
+END_TEST
+
+Suite* preordered_sender_suite()
+{
+    Suite* s = suite_create("preordered_sender");
+    TCase* tc;
+
+    tc = tcase_create("test_preordered_sender");
+    tcase_add_test(tc, test_preordered_sender);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
@@ -0,0 +1,399 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ *
+ * Replicator throughput benchmark.
+ *
+ * Runs the provider built on top of DummyGcs (a loopback single node group,
+ * no networking) and drives it through the wsrep API from a number of client
+ * threads the way a DBMS does: append_key(), append_data(), pre_commit() and
+ * post_commit(). A receiving thread runs the provider's recv() loop to
+ * process configuration changes, sync and commit cut actions. DummyGcs does
+ * not deliver write sets back, so the applying path is not exercised.
+ *
+ * Usage: repl_bench [-t client threads] [-n trxs per thread]
+ *                   [-k keys per trx] [-r rows] [-s data bytes per trx]
+ *                   [-o provider options]
+ *
+ * Keys are picked at random from a set of rows, so a smaller set means more
+ * dependencies between write sets. Reports TPS, client side latency of
+ * pre_commit() (replication, certification and commit order wait) and of
+ * post_commit() and the provider's own per-stage latency stats
+ * (repl.latency_stats is turned on).
+ */
+
+#include "wsrep_api.h"
+
+#include "gu_lock.hpp"
+#include "gu_time.h"
+
+#include <algorithm>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" int wsrep_loader(wsrep_t* hptr);
+
+namespace
+{
+    struct Options
+    {
+        Options()
+            :
+            threads(4),
+            trxs   (100000),
+            keys   (4),
+            rows   (1000000),
+            size   (256),
+            options()
+        {}
+
+        long        threads;
+        long        trxs;
+        long        keys;
+        long        rows;
+        long        size;
+        std::string options;
+    };
+
+    void usage(const char* const name)
+    {
+        fprintf(stderr, "Usage: %s [-t client threads] [-n trxs per thread]"
+                " [-k keys per trx] [-r rows] [-s data bytes per trx]"
+                " [-o provider options]\n", name);
+    }
+
+    /* synced callback has no other way to reach us */
+    gu::Mutex synced_mtx;
+    gu::Cond  synced_cond;
+    bool      synced(false);
+
+    void log_cb(wsrep_log_level_t const level, const char* const msg)
+    {
+        if (level <= WSREP_LOG_WARN) fprintf(stderr, "%s\n", msg);
+    }
+
+    wsrep_cb_status_t view_cb(void*, void*, const wsrep_view_info_t*,
+                              const char*, size_t, void**, size_t*)
+    {
+        return WSREP_CB_SUCCESS;
+    }
+
+    wsrep_cb_status_t apply_cb(void*, const void*, size_t, uint32_t,
+                               const wsrep_trx_meta_t*)
+    {
+        return WSREP_CB_SUCCESS;
+    }
+
+    wsrep_cb_status_t commit_cb(void*, uint32_t, const wsrep_trx_meta_t*,
+                                wsrep_bool_t*, wsrep_bool_t)
+    {
+        return WSREP_CB_SUCCESS;
+    }
+
+    wsrep_cb_status_t unordered_cb(void*, const void*, size_t)
+    {
+        return WSREP_CB_SUCCESS;
+    }
+
+    wsrep_cb_status_t sst_donate_cb(void*, void*, const void*, size_t,
+                                    const wsrep_gtid_t*, const char*, size_t,
+                                    wsrep_bool_t)
+    {
+        return WSREP_CB_FAILURE;
+    }
+
+    void synced_cb(void*)
+    {
+        gu::Lock lock(synced_mtx);
+        synced = true;
+        synced_cond.broadcast();
+    }
+
+    void* recv_thread(void* const arg)
+    {
+        wsrep_t* const wsrep(static_cast<wsrep_t*>(arg));
+        int ctx; // recv_ctx must not be NULL
+        wsrep->recv(wsrep, &ctx);
+        return NULL;
+    }
+
+    /* simple LCG to be independent of libc rand() */
+    class Rand
+    {
+    public:
+        Rand(unsigned long long const seed) : x_(seed) {}
+        long operator()(long const n)
+        {
+            x_ = x_ * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<long>((x_ >> 33) % n);
+        }
+    private:
+        unsigned long long x_;
+    };
+
+    class Client
+    {
+    public:
+
+        Client(wsrep_t* const wsrep, const Options& opt, long const id)
+            :
+            wsrep_   (wsrep),
+            opt_     (opt),
+            id_      (id),
+            thd_     (),
+            pre_ns_  (0),
+            pre_max_ (0),
+            post_ns_ (0),
+            post_max_(0),
+            failed_  (0)
+        {}
+
+        void start()
+        {
+            if (pthread_create(&thd_, NULL, run, this))
+            {
+                perror("pthread_create");
+                abort();
+            }
+        }
+
+        void join() { pthread_join(thd_, NULL); }
+
+        long long pre_ns()   const { return pre_ns_;   }
+        long long pre_max()  const { return pre_max_;  }
+        long long post_ns()  const { return post_ns_;  }
+        long long post_max() const { return post_max_; }
+        long      failed()   const { return failed_;   }
+
+    private:
+
+        static void* run(void* const arg)
+        {
+            static_cast<Client*>(arg)->loop();
+            return NULL;
+        }
+
+        void loop()
+        {
+            wsrep_conn_id_t const conn(id_ + 1);
+            Rand rnd(id_ + 1);
+
+            std::vector<char>        data(std::max(opt_.size, 1L), 'x');
+            std::vector<std::string> rows(opt_.keys);
+            std::vector<wsrep_buf_t> parts(opt_.keys);
+            std::vector<wsrep_key_t> keys(opt_.keys);
+
+            for (long i(0); i < opt_.trxs; ++i)
+            {
+                wsrep_ws_handle_t ws = { wsrep_trx_id_t(id_ * opt_.trxs + i),
+                                         NULL };
+
+                for (long k(0); k < opt_.keys; ++k)
+                {
+                    char row[32];
+                    snprintf(row, sizeof(row), "%ld", rnd(opt_.rows));
+                    rows[k]          = row;
+                    parts[k].ptr     = rows[k].data();
+                    parts[k].len     = rows[k].size();
+                    keys[k].key_parts     = &parts[k];
+                    keys[k].key_parts_num = 1;
+                }
+
+                wsrep_->append_key(wsrep_, &ws, &keys[0], keys.size(),
+                                   WSREP_KEY_EXCLUSIVE, true);
+
+                if (opt_.size > 0)
+                {
+                    wsrep_buf_t const buf = { &data[0], data.size() };
+                    wsrep_->append_data(wsrep_, &ws, &buf, 1,
+                                        WSREP_DATA_ORDERED, true);
+                }
+
+                wsrep_trx_meta_t meta;
+
+                long long const t0(gu_time_monotonic());
+                wsrep_status_t const rc(wsrep_->pre_commit(wsrep_, conn, &ws,
+                                                           WSREP_FLAG_COMMIT,
+                                                           &meta));
+                long long const t1(gu_time_monotonic());
+
+                if (WSREP_OK == rc)
+                {
+                    wsrep_->post_commit(wsrep_, &ws);
+                }
+                else
+                {
+                    wsrep_->post_rollback(wsrep_, &ws);
+                    ++failed_;
+                }
+
+                long long const t2(gu_time_monotonic());
+
+                pre_ns_   += t1 - t0;
+                pre_max_   = std::max(pre_max_, t1 - t0);
+                post_ns_  += t2 - t1;
+                post_max_  = std::max(post_max_, t2 - t1);
+            }
+
+            wsrep_->free_connection(wsrep_, conn);
+        }
+
+        Client(const Client&);
+        Client& operator=(const Client&);
+
+        wsrep_t* const wsrep_;
+        const Options& opt_;
+        long const     id_;
+        pthread_t      thd_;
+        long long      pre_ns_;
+        long long      pre_max_;
+        long long      post_ns_;
+        long long      post_max_;
+        long           failed_;
+    };
+
+    void print_latency_stats(wsrep_t* const wsrep)
+    {
+        struct wsrep_stats_var* const stats(wsrep->stats_get(wsrep));
+
+        if (!stats) return;
+
+        for (struct wsrep_stats_var* s(stats); s->name != NULL; ++s)
+        {
+            if (WSREP_VAR_DOUBLE == s->type && strstr(s->name, "_latency_") &&
+                s->value._double > 0)
+            {
+                printf("%-28s %10.1f us\n", s->name, s->value._double * 1.0e6);
+            }
+        }
+
+        wsrep->stats_free(wsrep, stats);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    int c;
+
+    while ((c = getopt(argc, argv, "t:n:k:r:s:o:")) != -1)
+    {
+        long const val(optarg ? strtol(optarg, NULL, 10) : 0);
+
+        switch (c)
+        {
+        case 't': opt.threads = val;    break;
+        case 'n': opt.trxs    = val;    break;
+        case 'k': opt.keys    = val;    break;
+        case 'r': opt.rows    = val;    break;
+        case 's': opt.size    = val;    break;
+        case 'o': opt.options = optarg; break;
+        default:  usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (opt.threads <= 0 || opt.trxs <= 0 || opt.keys <= 0 || opt.rows <= 0 ||
+        opt.size < 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::string const options("repl.latency_stats=yes; gcache.size=128M; " +
+                              opt.options);
+
+    wsrep_t wsrep;
+    memset(&wsrep, 0, sizeof(wsrep));
+
+    if (wsrep_loader(&wsrep))
+    {
+        fprintf(stderr, "Failed to load provider\n");
+        return EXIT_FAILURE;
+    }
+
+    struct wsrep_init_args args;
+    memset(&args, 0, sizeof(args));
+
+    args.node_name       = "repl_bench";
+    args.node_address    = "";
+    args.node_incoming   = "";
+    args.data_dir        = ".";
+    args.options         = options.c_str();
+    args.proto_ver       = 1;
+    args.state_id        = &WSREP_GTID_UNDEFINED;
+    args.logger_cb       = log_cb;
+    args.view_handler_cb = view_cb;
+    args.apply_cb        = apply_cb;
+    args.commit_cb       = commit_cb;
+    args.unordered_cb    = unordered_cb;
+    args.sst_donate_cb   = sst_donate_cb;
+    args.synced_cb       = synced_cb;
+
+    if (wsrep.init(&wsrep, &args) != WSREP_OK ||
+        wsrep.connect(&wsrep, "repl_bench", "dummy://", "", true) != WSREP_OK)
+    {
+        fprintf(stderr, "Failed to start provider\n");
+        return EXIT_FAILURE;
+    }
+
+    pthread_t recv;
+    if (pthread_create(&recv, NULL, recv_thread, &wsrep))
+    {
+        perror("pthread_create");
+        return EXIT_FAILURE;
+    }
+
+    {
+        gu::Lock lock(synced_mtx);
+        while (!synced) lock.wait(synced_cond);
+    }
+
+    std::vector<Client*> clients;
+    for (long i(0); i < opt.threads; ++i)
+    {
+        clients.push_back(new Client(&wsrep, opt, i));
+    }
+
+    long long const start(gu_time_monotonic());
+
+    for (size_t i(0); i < clients.size(); ++i) clients[i]->start();
+    for (size_t i(0); i < clients.size(); ++i) clients[i]->join();
+
+    double const secs((gu_time_monotonic() - start) * 1.0e-9);
+
+    long long pre_ns(0), pre_max(0), post_ns(0), post_max(0);
+    long      failed(0);
+
+    for (size_t i(0); i < clients.size(); ++i)
+    {
+        pre_ns  += clients[i]->pre_ns();
+        pre_max  = std::max(pre_max, clients[i]->pre_max());
+        post_ns += clients[i]->post_ns();
+        post_max = std::max(post_max, clients[i]->post_max());
+        failed  += clients[i]->failed();
+        delete clients[i];
+    }
+
+    double const total(double(opt.threads) * opt.trxs);
+
+    printf("threads: %ld, trxs/thread: %ld, keys/trx: %ld, rows: %ld, "
+           "data: %ld bytes\n",
+           opt.threads, opt.trxs, opt.keys, opt.rows, opt.size);
+    printf("throughput:  %10.0f trx/s, %.2f%% failed\n",
+           total / secs, 100.0 * failed / total);
+    printf("pre_commit:  %10.1f us avg, %.1f us max\n",
+           pre_ns / total / 1000.0, pre_max / 1000.0);
+    printf("post_commit: %10.1f us avg, %.1f us max\n",
+           post_ns / total / 1000.0, post_max / 1000.0);
+
+    print_latency_stats(&wsrep);
+
+    wsrep.disconnect(&wsrep);
+    pthread_join(recv, NULL);
+    wsrep.free(&wsrep);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "repl_lag.hpp"
+#include "uuid.hpp"
+
+#include <check.h>
+#include <sstream>
+#include <cstdlib>
+
+using namespace galera;
+
+static long long const MS = 1000000LL;
+
+static wsrep_uuid_t uuid(unsigned char const n)
+{
+    wsrep_uuid_t ret(WSREP_UUID_UNDEFINED);
+    ret.data[15] = n;
+    return ret;
+}
+
+START_TEST(test_skew)
+{
+    ReplLag lag;
+
+    wsrep_uuid_t const src(uuid(1));
+    long long const    skew(5000 * MS); // local clock is 5s ahead
+    long long const    delay(1 * MS);   // one-way network delay
+    long long          origin(1500000000LL * 1000 * MS);
+
+    for (int i(0); i < 2000; ++i, origin += MS)
+    {
+        long long const jitter((i % 10) * MS / 10);
+        long long const t[ReplLag::LAG_MAX] =
+        {
+            origin + skew + delay + jitter,
+            origin + skew + delay + jitter + 2 * MS,
+            origin + skew + delay + jitter + 3 * MS
+        };
+
+        fail_unless(lag.record(src, origin, t));
+    }
+
+    fail_if(llabs(lag.offset(src, delay) - skew) > MS / 10,
+            "offset: %lld", lag.offset(src, delay));
+    fail_unless(0 == lag.offset(uuid(2), delay));
+
+    std::ostringstream os;
+    lag.print(os, delay);
+
+    std::string const str(os.str());
+    std::ostringstream prefix;
+    prefix << src << ":2000:";
+    fail_unless(str.find(prefix.str()) == 0, "%s", str.c_str());
+
+    /* uuid:count:offset:ordered_p50:ordered_p99:... */
+    std::string::size_type pos(prefix.str().length());
+    double const offset(strtod(str.c_str() + pos, NULL));
+    fail_if(offset < 4.9999 || offset > 5.0001, "%s", str.c_str());
+
+    pos = str.find(':', pos) + 1;
+    double const ordered_p50(strtod(str.c_str() + pos, NULL));
+    fail_if(ordered_p50 < 0.0013 || ordered_p50 > 0.0016, "%s", str.c_str());
+
+    pos = str.find(':', pos) + 1;
+    pos = str.find(':', pos) + 1;
+    double const applied_p50(strtod(str.c_str() + pos, NULL));
+    fail_if(applied_p50 < 0.0033 || applied_p50 > 0.0036, "%s", str.c_str());
+
+    lag.clear();
+    fail_unless(0 == lag.offset(src, delay));
+}
+END_TEST
+
+START_TEST(test_unusable)
+{
+    ReplLag lag;
+
+    long long const now(1500000000LL * 1000 * MS);
+    long long const t[ReplLag::LAG_MAX] = { now, now + MS, 0 };
+    long long const none[ReplLag::LAG_MAX] = { 0, now, now };
+
+    fail_if(lag.record(uuid(1), 0, t));
+    fail_if(lag.record(uuid(1), now, none));
+    /* monotonic time from nodes that don't send calendar time */
+    fail_if(lag.record(uuid(1), 1000000 * MS, t));
+
+    std::ostringstream os;
+    lag.print(os, 0);
+    fail_unless(os.str().empty());
+
+    /* stages that were not timed are not recorded */
+    fail_unless(lag.record(uuid(1), now - MS, t));
+}
+END_TEST
+
+START_TEST(test_sources)
+{
+    ReplLag lag(2);
+
+    long long const now(1500000000LL * 1000 * MS);
+
+    for (unsigned char n(1); n <= 3; ++n)
+    {
+        long long const t[ReplLag::LAG_MAX] = { now + n * MS, 0, 0 };
+        fail_unless(lag.record(uuid(n), now, t));
+    }
+
+    fail_unless(0 == lag.offset(uuid(1), 0));
+    fail_unless(2 * MS == lag.offset(uuid(2), 0));
+    fail_unless(3 * MS == lag.offset(uuid(3), 0));
+}
+END_TEST
+
+Suite* repl_lag_suite()
+{
+    Suite* s = suite_create("repl_lag");
+    TCase* tc;
+
+    tc = tcase_create("test_skew");
+    tcase_add_test(tc, test_skew);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_unusable");
+    tcase_add_test(tc, test_unusable);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_sources");
+    tcase_add_test(tc, test_sources);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
@@ -0,0 +1,72 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "repl_qos.hpp"
+
+#include <gu_throw.hpp>
+
+#include <check.h>
+
+using namespace galera;
+
+START_TEST(test_assign)
+{
+    ReplQos qos;
+
+    fail_unless(qos.get(1) == ReplQos::DEFAULT);
+
+    qos.assign("1:bulk");
+    qos.assign(" 3 : bulk");
+    fail_unless(qos.get(1) == ReplQos::BULK);
+    fail_unless(qos.get(2) == ReplQos::DEFAULT);
+    fail_unless(qos.get(3) == ReplQos::BULK);
+
+    qos.assign("1:default");
+    fail_unless(qos.get(1) == ReplQos::DEFAULT);
+
+    qos.discard(3);
+    fail_unless(qos.get(3) == ReplQos::DEFAULT);
+}
+END_TEST
+
+START_TEST(test_malformed)
+{
+    static const char* const bad[] =
+    {
+        "", "1", "bulk", "x:bulk", "1:fast", "1:bulk:2", 0
+    };
+
+    ReplQos qos;
+
+    for (int i(0); bad[i]; ++i)
+    {
+        try
+        {
+            qos.assign(bad[i]);
+            fail("'%s' accepted", bad[i]);
+        }
+        catch (gu::Exception& e)
+        {
+            fail_unless(e.get_errno() == EINVAL, "'%s': %d", bad[i],
+                        e.get_errno());
+        }
+    }
+}
+END_TEST
+
+Suite* repl_qos_suite()
+{
+    Suite* s = suite_create("repl_qos");
+    TCase* tc;
+
+    tc = tcase_create("test_assign");
+    tcase_add_test(tc, test_assign);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_malformed");
+    tcase_add_test(tc, test_malformed);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
@@ -213,6 +213,58 @@ START_TEST(test_corrupt)
 }
 END_TEST
 
+START_TEST(test_deferred)
+{
+    unlink (fname);
+
+    wsrep_uuid_t uuid;
+    gu_uuid_from_string("b2c01654-8dfe-11e1-0800-a834d641cfb5",
+                        to_gu_uuid(uuid));
+
+    {
+        SavedState st(fname);
+        st.set(uuid, WSREP_SEQNO_UNDEFINED, false);
+    }
+
+    long writes_before, writes_after, unused;
+
+    {
+        SavedState st(fname);
+
+        st.stats(unused, unused, writes_before);
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            st.mark_unsafe(); // must be written right away
+            /* making the state safe again is left for the writer and will
+             * be dropped by the next mark_unsafe() */
+            st.mark_safe();
+        }
+
+        st.stats(unused, unused, writes_after);
+
+        fail_if (st.deferred() == 0);
+        fail_if (writes_after - writes_before > 100, "writes: %ld",
+                 writes_after - writes_before);
+    } // pending write must be flushed here
+
+    {
+        SavedState st(fname);
+
+        wsrep_uuid_t  u;
+        wsrep_seqno_t s;
+        bool stb;
+        st.get(u, s, stb);
+
+        fail_if (u != uuid);
+        fail_if (s != WSREP_SEQNO_UNDEFINED);
+        fail_if (stb != false);
+    }
+
+    unlink (fname);
+}
+END_TEST
+
 #define WAIT_FOR(cond)                                                  \
     { int count = 1000; while (--count && !(cond)) { usleep (TEST_USLEEP); }}
 
@@ -225,6 +277,7 @@ Suite* saved_state_suite()
     tcase_add_test  (tc, test_basic);
     tcase_add_test  (tc, test_unsafe);
     tcase_add_test  (tc, test_corrupt);
+    tcase_add_test  (tc, test_deferred);
     tcase_set_timeout(tc, 120);
     suite_add_tcase (s, tc);
 
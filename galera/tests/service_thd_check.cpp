@@ -27,6 +27,7 @@ namespace
             ~GCache_setup()
             {
                 unlink(name_.c_str());
+                unlink((name_ + ".index").c_str());
             }
         private:
             std::string const name_;
@@ -129,6 +130,47 @@ START_TEST(service_thd3)
 }
 END_TEST
 
+START_TEST(service_thd4)
+{
+    TestEnv env;
+    DummyGcs& conn(env.gcs());
+    ServiceThd* thd = new ServiceThd(conn, env.gcache());
+    fail_if (thd == 0);
+
+    conn.set_last_applied(0);
+    thd->set_report_interval(gu::datetime::Period("PT1H"));
+
+    // first report goes out right away
+    thd->report_last_committed (1);
+    WAIT_FOR(conn.last_applied() == 1);
+    fail_if (conn.last_applied() != 1,
+             "seqno = %" PRId64 ", expected 1", conn.last_applied());
+
+    // the following are held back for the rest of the interval
+    thd->report_last_committed (2);
+    thd->report_last_committed (3);
+    thd->release_seqno(-1); // wakes the thread up, but not for report
+    usleep (100 * TEST_USLEEP);
+    fail_if (conn.last_applied() != 1,
+             "seqno = %" PRId64 ", expected 1", conn.last_applied());
+
+    // flush sends the latest one
+    thd->flush();
+    WAIT_FOR(conn.last_applied() == 3);
+    fail_if (conn.last_applied() != 3,
+             "seqno = %" PRId64 ", expected 3", conn.last_applied());
+
+    // resetting interval makes pending report due
+    thd->report_last_committed (4);
+    thd->set_report_interval(gu::datetime::Period("PT0S"));
+    WAIT_FOR(conn.last_applied() == 4);
+    fail_if (conn.last_applied() != 4,
+             "seqno = %" PRId64 ", expected 4", conn.last_applied());
+
+    delete thd;
+}
+END_TEST
+
 Suite* service_thd_suite()
 {
     Suite* s = suite_create ("service_thd");
@@ -138,6 +180,7 @@ Suite* service_thd_suite()
     tcase_add_test  (tc, service_thd1);
     tcase_add_test  (tc, service_thd2);
     tcase_add_test  (tc, service_thd3);
+    tcase_add_test  (tc, service_thd4);
     suite_add_tcase (s, tc);
 
     return s;
@@ -190,6 +190,89 @@ START_TEST(test_serialization)
 }
 END_TEST
 
+static void
+gather_write_set(TrxHandle* const trx, std::vector<gu::byte_t>& buf)
+{
+    WriteSetNG::GatherVector out;
+    size_t const size(trx->write_set_out().gather(trx->source_id(),
+                                                  trx->conn_id(),
+                                                  trx->trx_id(), out));
+    buf.clear();
+    buf.reserve(size);
+    for (size_t i(0); i < out->size(); ++i)
+    {
+        const gu::byte_t* const ptr
+            (static_cast<const gu::byte_t*>(out[i].ptr));
+        buf.insert(buf.end(), ptr, ptr + out[i].size);
+    }
+}
+
+START_TEST(test_append_arrays)
+{
+    TrxHandle::LocalPool lp(TrxHandle::LOCAL_STORAGE_SIZE(), 4, "append_lp");
+    int const version(3);
+    galera::TrxHandle::Params const trx_params(".", version,
+                                               KeySet::MAX_VERSION);
+    wsrep_uuid_t const uuid = {{1, }};
+
+    wsrep_buf_t const parts[] = { { "t", 1 }, { "1", 1 }, { "2", 1 } };
+    wsrep_key_t const keys[] =
+        { { &parts[0], 2 }, { &parts[0], 1 }, { &parts[1], 2 } };
+    size_t const keys_num(sizeof(keys) / sizeof(keys[0]));
+    wsrep_buf_t const data[] = { { "foo", 3 }, { "barbaz", 6 } };
+    size_t const data_num(sizeof(data) / sizeof(data[0]));
+
+    /* reference: one element per call */
+    TrxHandle* trx(TrxHandle::New(lp, trx_params, uuid, 4567, 8910));
+    for (size_t i(0); i < keys_num; ++i)
+    {
+        trx->append_key(KeyData(version, keys[i].key_parts,
+                                keys[i].key_parts_num,
+                                WSREP_KEY_EXCLUSIVE, true));
+    }
+    for (size_t i(0); i < data_num; ++i)
+    {
+        trx->append_data(data[i].ptr, data[i].len, WSREP_DATA_ORDERED, true);
+    }
+    std::vector<gu::byte_t> ref;
+    gather_write_set(trx, ref);
+    trx->release_write_set_out();
+    trx->unref();
+
+    trx = TrxHandle::New(lp, trx_params, uuid, 4567, 8910);
+    try
+    {
+        trx->append_keys(version - 1, keys, keys_num, WSREP_KEY_EXCLUSIVE,
+                         true);
+        fail("key version mismatch not detected");
+    }
+    catch (gu::Exception& e)
+    {
+        fail_unless(e.get_errno() == EINVAL);
+    }
+    trx->append_keys(version, keys, keys_num, WSREP_KEY_EXCLUSIVE, true);
+    trx->append_data(data, data_num, true);
+    std::vector<gu::byte_t> buf;
+    gather_write_set(trx, buf);
+    trx->release_write_set_out();
+    trx->unref();
+
+    fail_unless(buf.size() == ref.size(), "size %zu, expected %zu",
+                buf.size(), ref.size());
+
+    WriteSetIn ws;
+    ws.read_buf(&buf[0], buf.size());
+    ws.verify_checksum();
+
+    WriteSetIn ws_ref;
+    ws_ref.read_buf(&ref[0], ref.size());
+
+    fail_unless(ws.keyset().count() == ws_ref.keyset().count());
+    fail_unless(ws.keyset().count() > int(keys_num));
+    fail_unless(ws.dataset().count() == int(data_num));
+}
+END_TEST
+
 Suite* trx_handle_suite()
 {
     Suite* s = suite_create("trx_handle");
@@ -204,5 +287,9 @@ Suite* trx_handle_suite()
     tcase_add_test(tc, test_serialization);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("test_append_arrays");
+    tcase_add_test(tc, test_append_arrays);
+    suite_add_tcase(s, tc);
+
     return s;
 }
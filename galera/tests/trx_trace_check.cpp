@@ -0,0 +1,105 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "trx_trace.hpp"
+
+#include <check.h>
+
+#include <sstream>
+#include <unistd.h>
+
+using namespace galera;
+
+static void
+record_trx(TrxTrace& tt, TrxHandle::LocalPool& lp, wsrep_seqno_t const seqno,
+           useconds_t const delay = 0)
+{
+    wsrep_uuid_t const uuid = {{1, }};
+    TrxHandle* const trx(TrxHandle::New(lp, TrxHandle::Defaults, uuid, -1,
+                                        seqno));
+
+    trx->stamp(TrxHandle::T_REPLICATE);
+    trx->set_received(0, seqno, seqno);
+    trx->stamp(TrxHandle::T_ORDERED);
+    if (delay) usleep(delay);
+    trx->stamp(TrxHandle::T_COMMITTED);
+
+    tt.record(*trx);
+    trx->unref();
+}
+
+static size_t
+count_lines(const TrxTrace& tt, std::string& out)
+{
+    std::ostringstream os;
+    os << tt;
+    out = os.str();
+
+    size_t ret(0);
+    for (size_t i(0); i < out.size(); ++i) ret += (out[i] == '\n');
+    return ret;
+}
+
+START_TEST(test_sample)
+{
+    TrxHandle::LocalPool lp(TrxHandle::LOCAL_STORAGE_SIZE(), 4, "trace_lp");
+    TrxTrace tt(3);
+    std::string out;
+
+    fail_if(tt.enabled());
+    for (wsrep_seqno_t s(1); s <= 10; ++s) record_trx(tt, lp, s);
+    fail_unless(count_lines(tt, out) == 0, "recorded while disabled: %s",
+                out.c_str());
+
+    tt.set_sample(2);
+    fail_unless(tt.enabled());
+    for (wsrep_seqno_t s(11); s <= 20; ++s) record_trx(tt, lp, s);
+
+    /* 5 sampled, only the last 3 fit */
+    fail_unless(count_lines(tt, out) == 3, "%s", out.c_str());
+    fail_unless(out.find("seqno: 14,") == std::string::npos, "%s",
+                out.c_str());
+    size_t const p16(out.find("seqno: 16,"));
+    size_t const p18(out.find("seqno: 18,"));
+    size_t const p20(out.find("seqno: 20,"));
+    fail_unless(p16 != std::string::npos && p16 < p18 && p18 < p20, "%s",
+                out.c_str());
+    fail_unless(out.find("committed: ") != std::string::npos, "%s",
+                out.c_str());
+    fail_unless(out.find("cert: ") == std::string::npos, "%s", out.c_str());
+}
+END_TEST
+
+START_TEST(test_threshold)
+{
+    TrxHandle::LocalPool lp(TrxHandle::LOCAL_STORAGE_SIZE(), 4, "trace_lp");
+    TrxTrace tt(16);
+    std::string out;
+
+    tt.set_threshold(5 * gu::datetime::MSec);
+    record_trx(tt, lp, 1);
+    record_trx(tt, lp, 2, 20000);
+    record_trx(tt, lp, 3);
+
+    fail_unless(count_lines(tt, out) == 1, "%s", out.c_str());
+    fail_unless(out.find("seqno: 2,") != std::string::npos, "%s",
+                out.c_str());
+}
+END_TEST
+
+Suite* trx_trace_suite()
+{
+    Suite* s = suite_create("trx_trace");
+    TCase* tc;
+
+    tc = tcase_create("test_sample");
+    tcase_add_test(tc, test_sample);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_threshold");
+    tcase_add_test(tc, test_threshold);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
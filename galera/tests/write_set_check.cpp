@@ -31,6 +31,7 @@ namespace
             ~GCache_setup()
             {
                 unlink(name_.c_str());
+                unlink((name_ + ".index").c_str());
             }
         private:
             std::string const name_;
@@ -337,6 +338,21 @@ START_TEST(test_mapped_buffer)
         mb[i] = static_cast<gu::byte_t>(i);
     }
 
+    // grow the file-backed buffer again, contents must be preserved
+    for (size_t sz = (1 << 20) + 1; sz <= (1 << 22); sz += (1 << 18))
+    {
+        size_t const old_size(mb.size());
+        mb.resize(sz);
+        for (size_t i = 0; i < old_size; ++i)
+        {
+            fail_unless(mb[i] == static_cast<gu::byte_t>(i));
+        }
+        for (size_t i = old_size; i < sz; ++i)
+        {
+            mb[i] = static_cast<gu::byte_t>(i);
+        }
+    }
+
 }
 END_TEST
 
@@ -643,6 +659,292 @@ START_TEST(test_trac_726)
 END_TEST
 
 
+START_TEST(test_cert_v3_shards)
+{
+    log_info << "test_cert_v3_shards";
+
+    const int version(3);
+    TestEnv env;
+    galera::Certification cert(env.conf(), env.thd());
+    galera::TrxHandle::Params const trx_params("", version,KeySet::MAX_VERSION);
+    wsrep_uuid_t uuid1 = {{1, }};
+    wsrep_uuid_t uuid2 = {{2, }};
+    cert.assign_initial_position(0, version);
+
+    static int const n_keys(64);
+    char key_str[n_keys][4];
+    wsrep_buf_t keys[n_keys];
+    for (int i(0); i < n_keys; ++i)
+    {
+        snprintf(key_str[i], sizeof(key_str[i]), "%d", i);
+        keys[i].ptr = key_str[i];
+        keys[i].len = strlen(key_str[i]);
+    }
+
+    struct wsinfo_ {
+        const wsrep_uuid_t* uuid;
+        int                 key_begin;
+        int                 key_end;
+        wsrep_seqno_t       global_seqno;
+        wsrep_seqno_t       last_seen_seqno;
+        wsrep_seqno_t       expected_depends_seqno;
+        Certification::TestResult result;
+    } wsi[] = {
+        // 1: all keys in the index, spans all shards
+        { &uuid1, 0,  n_keys, 1, 0,  0, Certification::TEST_OK },
+        // 2: conflicts with 1 on a single key
+        { &uuid2, 17, 18,     2, 0, -1, Certification::TEST_FAILED },
+        // 3: same key as 2, but 1 was seen
+        { &uuid2, 17, 18,     3, 1,  1, Certification::TEST_OK },
+        // 4: depends on 3 which has the same key
+        { &uuid1, 17, 18,     4, 3,  3, Certification::TEST_OK },
+        // 5: keys from 1 after 1-3 were purged: no dependency on 1,
+        //    depends on the first trx left in the index
+        { &uuid2, 0,  16,     5, 1,  3, Certification::TEST_OK },
+    };
+
+    size_t const nws(sizeof(wsi)/sizeof(wsi[0]));
+    std::vector<std::vector<gu::byte_t> > bufs(nws);
+
+    for (size_t i(0); i < nws; ++i)
+    {
+        TrxHandle* trx(TrxHandle::New(lp, trx_params, *wsi[i].uuid, 1, i));
+
+        for (int k(wsi[i].key_begin); k < wsi[i].key_end; ++k)
+        {
+            trx->append_key(KeyData(version, &keys[k], 1,
+                                    WSREP_KEY_EXCLUSIVE, true));
+        }
+
+        WriteSetNG::GatherVector out;
+        size_t const size(trx->write_set_out().gather(trx->source_id(),
+                                                      trx->conn_id(),
+                                                      trx->trx_id(),
+                                                      out));
+        trx->set_last_seen_seqno(wsi[i].last_seen_seqno);
+
+        std::vector<gu::byte_t>& buf(bufs[i]);
+        buf.reserve(size);
+        for (size_t b(0); b < out->size(); ++b)
+        {
+            const gu::byte_t* ptr(static_cast<const gu::byte_t*>(out[b].ptr));
+            buf.insert(buf.end(), ptr, ptr + out[b].size);
+        }
+        trx->unref();
+
+        if (5 == wsi[i].global_seqno)
+        {
+            /* everything up to 4 is committed, safe to discard seqno is
+             * last seen of 4 */
+            wsrep_seqno_t const purged(cert.purge_trxs_upto(4, true));
+            fail_unless(3 == purged, "purged: %lld", purged);
+        }
+
+        trx = TrxHandle::New(sp);
+        trx->unserialize(&buf[0], buf.size(), 0);
+        trx->set_received(0, wsi[i].global_seqno, wsi[i].global_seqno);
+
+        Certification::TestResult result(cert.append_trx(trx));
+        fail_unless(result == wsi[i].result, "g: %lld r: %d er: %d",
+                    trx->global_seqno(), result, wsi[i].result);
+        fail_unless(trx->depends_seqno() == wsi[i].expected_depends_seqno,
+                    "wsi: %zu g: %lld ld: %lld eld: %lld",
+                    i, trx->global_seqno(), trx->depends_seqno(),
+                    wsi[i].expected_depends_seqno);
+
+        if (Certification::TEST_OK == result)
+        {
+            /* explicit dependencies must agree with depends_seqno */
+            const galera::TrxDeps& deps(trx->deps());
+            fail_unless(deps.valid());
+            wsrep_seqno_t max_dep(deps.floor());
+            for (int d(0); d < deps.size(); ++d)
+            {
+                fail_unless(deps[d] > deps.floor());
+                max_dep = std::max(max_dep, deps[d]);
+            }
+            fail_unless(max_dep == trx->depends_seqno(),
+                        "wsi: %zu max dep: %lld", i, max_dep);
+        }
+
+        cert.set_trx_committed(trx);
+        trx->unref();
+    }
+}
+END_TEST
+
+
+START_TEST(test_cert_purge_bg)
+{
+    log_info << "test_cert_purge_bg";
+
+    const int version(3);
+    TestEnv env;
+    galera::Certification cert(env.conf(), env.thd());
+    galera::TrxHandle::Params const trx_params("", version,KeySet::MAX_VERSION);
+    wsrep_uuid_t uuid = {{1, }};
+    cert.assign_initial_position(0, version);
+
+    static int const n_keys(64);
+    char key_str[n_keys][4];
+    wsrep_buf_t keys[n_keys];
+    for (int i(0); i < n_keys; ++i)
+    {
+        snprintf(key_str[i], sizeof(key_str[i]), "%d", i);
+        keys[i].ptr = key_str[i];
+        keys[i].len = strlen(key_str[i]);
+    }
+
+    /* enough trxs to take several background purge passes */
+    static wsrep_seqno_t const n_trx(256);
+    std::vector<std::vector<gu::byte_t> > bufs(n_trx);
+
+    for (wsrep_seqno_t seqno(1); seqno <= n_trx; ++seqno)
+    {
+        TrxHandle* trx(TrxHandle::New(lp, trx_params, uuid, 1, seqno));
+
+        for (int k(0); k < n_keys; ++k)
+        {
+            trx->append_key(KeyData(version, &keys[k], 1,
+                                    WSREP_KEY_EXCLUSIVE, true));
+        }
+
+        WriteSetNG::GatherVector out;
+        size_t const size(trx->write_set_out().gather(trx->source_id(),
+                                                      trx->conn_id(),
+                                                      trx->trx_id(),
+                                                      out));
+        trx->set_last_seen_seqno(seqno - 1);
+
+        std::vector<gu::byte_t>& buf(bufs[seqno - 1]);
+        buf.reserve(size);
+        for (size_t b(0); b < out->size(); ++b)
+        {
+            const gu::byte_t* ptr(static_cast<const gu::byte_t*>(out[b].ptr));
+            buf.insert(buf.end(), ptr, ptr + out[b].size);
+        }
+        trx->unref();
+
+        trx = TrxHandle::New(sp);
+        trx->unserialize(&buf[0], buf.size(), 0);
+        trx->set_received(0, seqno, seqno);
+
+        Certification::TestResult result(cert.append_trx(trx));
+        fail_unless(result == Certification::TEST_OK, "g: %lld r: %d",
+                    seqno, result);
+        fail_unless(trx->depends_seqno() == seqno - 1,
+                    "g: %lld ld: %lld", seqno, trx->depends_seqno());
+        cert.set_trx_committed(trx);
+        trx->unref();
+    }
+
+    fail_unless(cert.purge_lag() == 0);
+
+    cert.schedule_purge(n_trx - 1);
+    env.thd().flush();
+
+    fail_unless(cert.purge_lag() == 0, "purge lag: %lld", cert.purge_lag());
+    fail_unless(cert.get_trx(n_trx - 1) == 0);
+
+    TrxHandle* const last(cert.get_trx(n_trx));
+    fail_unless(last != 0);
+    last->unref();
+}
+END_TEST
+
+
+START_TEST(test_cert_keyed_toi)
+{
+    log_info << "test_cert_keyed_toi";
+
+    const int version(3);
+    TestEnv env;
+    env.conf().set("cert.keyed_toi", "yes");
+    galera::Certification cert(env.conf(), env.thd());
+    galera::TrxHandle::Params const trx_params("", version,KeySet::MAX_VERSION);
+    wsrep_uuid_t uuid1 = {{1, }};
+    wsrep_uuid_t uuid2 = {{2, }};
+    cert.assign_initial_position(0, version);
+
+    wsrep_buf_t const keys[] = { { "a", 1 }, { "b", 1 } };
+    int const no_key(-1);
+
+    struct wsinfo_ {
+        const wsrep_uuid_t* uuid;
+        int                 key;
+        bool                toi;
+        wsrep_seqno_t       global_seqno;
+        wsrep_seqno_t       last_seen_seqno;
+        wsrep_seqno_t       expected_depends_seqno;
+        Certification::TestResult result;
+    } wsi[] = {
+        { &uuid1, 0,      false, 1, 0,  0, Certification::TEST_OK },
+        { &uuid1, 1,      false, 2, 1,  0, Certification::TEST_OK },
+        // 3: TOI on "a" waits only for 1
+        { &uuid1, 0,      true,  3, 2,  1, Certification::TEST_OK },
+        // 4: keyless TOI is fully isolated
+        { &uuid1, no_key, true,  4, 3,  3, Certification::TEST_OK },
+        // 5: conflicts with TOI 3 which it has not seen
+        { &uuid2, 0,      false, 5, 2, -1, Certification::TEST_FAILED },
+        // 6: TOI never fails certification, depends on 2 only
+        { &uuid2, 1,      true,  6, 0,  2, Certification::TEST_OK },
+    };
+
+    size_t const nws(sizeof(wsi)/sizeof(wsi[0]));
+    std::vector<std::vector<gu::byte_t> > bufs(nws);
+
+    for (size_t i(0); i < nws; ++i)
+    {
+        TrxHandle* trx(TrxHandle::New(lp, trx_params, *wsi[i].uuid, 1,
+                                      wsi[i].toi ? wsrep_trx_id_t(-1) : i));
+
+        if (wsi[i].key != no_key)
+        {
+            trx->append_key(KeyData(version, &keys[wsi[i].key], 1,
+                                    WSREP_KEY_EXCLUSIVE, true));
+        }
+
+        if (wsi[i].toi)
+        {
+            trx->set_flags(trx->flags() | TrxHandle::F_ISOLATION);
+        }
+
+        WriteSetNG::GatherVector out;
+        size_t const size(trx->write_set_out().gather(trx->source_id(),
+                                                      trx->conn_id(),
+                                                      trx->trx_id(),
+                                                      out));
+        trx->set_last_seen_seqno(wsi[i].last_seen_seqno);
+
+        std::vector<gu::byte_t>& buf(bufs[i]);
+        buf.reserve(size);
+        for (size_t b(0); b < out->size(); ++b)
+        {
+            const gu::byte_t* ptr(static_cast<const gu::byte_t*>(out[b].ptr));
+            buf.insert(buf.end(), ptr, ptr + out[b].size);
+        }
+        trx->unref();
+
+        trx = TrxHandle::New(sp);
+        trx->unserialize(&buf[0], buf.size(), 0);
+        trx->set_received(0, wsi[i].global_seqno, wsi[i].global_seqno);
+        fail_unless(trx->is_toi() == wsi[i].toi);
+
+        Certification::TestResult result(cert.append_trx(trx));
+        fail_unless(result == wsi[i].result, "g: %lld r: %d er: %d",
+                    trx->global_seqno(), result, wsi[i].result);
+        fail_unless(trx->depends_seqno() == wsi[i].expected_depends_seqno,
+                    "wsi: %zu g: %lld ld: %lld eld: %lld",
+                    i, trx->global_seqno(), trx->depends_seqno(),
+                    wsi[i].expected_depends_seqno);
+
+        cert.set_trx_committed(trx);
+        trx->unref();
+    }
+}
+END_TEST
+
+
 Suite* write_set_suite()
 {
     Suite* s = suite_create("write_set");
@@ -683,5 +985,20 @@ Suite* write_set_suite()
     tcase_set_timeout(tc, 20);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("test_cert_v3_shards");
+    tcase_add_test(tc, test_cert_v3_shards);
+    tcase_set_timeout(tc, 20);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_cert_purge_bg");
+    tcase_add_test(tc, test_cert_purge_bg);
+    tcase_set_timeout(tc, 20);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_cert_keyed_toi");
+    tcase_add_test(tc, test_cert_keyed_toi);
+    tcase_set_timeout(tc, 20);
+    suite_add_tcase(s, tc);
+
     return s;
 }
@@ -251,6 +251,27 @@ START_TEST (ver3_basic)
         fail("%s", e.what());
     }
 
+    try /* this is to test deferred section checksum + corruption */
+    {
+        WriteSetIn wsi(in_buf);
+
+        mark_point();
+        fail_if (wsi.keyset().count() != 1); // keys are not corrupted
+
+        try {
+            wsi.verify_checksum();
+            fail("payload corruption slipped through 3");
+        }
+        catch (gu::Exception& e)
+        {
+            fail_if (e.get_errno() != EINVAL);
+        }
+    }
+    catch (std::exception& e)
+    {
+        fail("%s", e.what());
+    }
+
     in[2] ^= 1; // corrupted 3rd byte of header
 
     try /* this is to test header corruption */
@@ -340,11 +361,146 @@ START_TEST (ver3_annotation)
 }
 END_TEST
 
+START_TEST (ver3_xxh64)
+{
+    wsrep_uuid_t source;
+    gu_uuid_generate (reinterpret_cast<gu_uuid_t*>(&source), NULL, 0);
+
+    std::string const dir(".");
+    wsrep_trx_id_t trx_id(1);
+
+    WriteSetOut wso (dir, trx_id, KeySet::FLAT16, 0, 0, 0, WriteSetNG::VER3,
+                     DataSet::VER1, DataSet::VER1, WriteSetNG::MAX_SIZE,
+                     DataSet::DEFAULT_COMPRESSION_LEVEL,
+                     gu::RecordSet::CHECK_XXH64);
+
+    TestKey tk0(KeySet::MAX_VERSION, SHARED, true, "key0");
+    wso.append_key(tk0());
+
+    uint64_t const data(0xaabbccdd);
+    std::string const annotation("0xaabbccdd");
+
+    wso.append_data (&data, sizeof(data), true);
+    wso.append_annotation (annotation.c_str(), annotation.size(), true);
+
+    WriteSetNG::GatherVector out;
+    size_t const out_size(wso.gather(source, 1, 2, out));
+    wso.set_last_seen(1);
+
+    std::vector<gu::byte_t> in;
+    in.reserve(out_size);
+    for (size_t i(0); i < out->size(); ++i)
+    {
+        const gu::byte_t* ptr(static_cast<const gu::byte_t*>(out[i].ptr));
+        in.insert (in.end(), ptr, ptr + out[i].size);
+    }
+
+    fail_if (in.size() != out_size);
+
+    gu::Buf const in_buf = { in.data(), static_cast<ssize_t>(in.size()) };
+
+    {
+        WriteSetIn wsi(in_buf);
+        wsi.verify_checksum();
+
+        fail_if (wsi.keyset().count() != 1);
+        fail_if (wsi.dataset().count() != 1);
+
+        std::ostringstream os;
+        wsi.write_annotation(os);
+        fail_if (annotation != os.str());
+    }
+
+    /* corrupt the data set, XXH64 checksum must catch it */
+    std::vector<gu::byte_t>::iterator const pos
+        (std::search(in.begin(), in.end(),
+                     reinterpret_cast<const gu::byte_t*>(&data),
+                     reinterpret_cast<const gu::byte_t*>(&data) + sizeof(data)));
+    fail_if (pos == in.end());
+    *pos ^= 1;
+
+    try
+    {
+        WriteSetIn wsi(in_buf);
+        wsi.verify_checksum();
+        fail("corrupted write set passed checksum verification");
+    }
+    catch (gu::Exception& e) {}
+}
+END_TEST
+
+START_TEST (ver3_key_escalation)
+{
+    wsrep_uuid_t source;
+    gu_uuid_generate (reinterpret_cast<gu_uuid_t*>(&source), NULL, 0);
+
+    std::string const dir(".");
+    wsrep_trx_id_t trx_id(1);
+
+    WriteSetOut wso (dir, trx_id, KeySet::FLAT16, 0, 0, 0, WriteSetNG::VER3);
+    wso.set_key_escalation(3);
+
+    /* table level key is not a row key */
+    TestKey tkt(KeySet::MAX_VERSION, SHARED, false, "db", "t0");
+    wso.append_key(tkt());
+
+    const char* const rows[] = { "r0", "r1", "r2", "r3", "r4", "r5" };
+    size_t const rows_num(sizeof(rows)/sizeof(rows[0]));
+
+    for (size_t i(0); i < rows_num; ++i)
+    {
+        TestKey tk(KeySet::MAX_VERSION, SHARED, false, "db", "t0", rows[i]);
+        wso.append_key(tk());
+    }
+
+    for (size_t i(0); i < rows_num; ++i)
+    {
+        TestKey tk(KeySet::MAX_VERSION, SHARED, false, "db", "t1", rows[i]);
+        wso.append_key(tk());
+    }
+
+    uint64_t const data(0xaabbccdd);
+    wso.append_data (&data, sizeof(data), true);
+
+    WriteSetNG::GatherVector out;
+    size_t const out_size(wso.gather(source, 1, 2, out));
+    wso.set_last_seen(1);
+
+    std::vector<gu::byte_t> in;
+    in.reserve(out_size);
+    for (size_t i(0); i < out->size(); ++i)
+    {
+        const gu::byte_t* ptr(static_cast<const gu::byte_t*>(out[i].ptr));
+        in.insert (in.end(), ptr, ptr + out[i].size);
+    }
+
+    gu::Buf const in_buf = { in.data(), static_cast<ssize_t>(in.size()) };
+
+    WriteSetIn wsi(in_buf);
+    wsi.verify_checksum();
+
+    /* db, t0, 3 rows of t0 before escalation, exclusive t0 and t1 */
+    const KeySetIn& ksi(wsi.keyset());
+    fail_if (ksi.count() != 7, "key count: expected 7, got %d", ksi.count());
+
+    int exclusive(0);
+    for (int i(0); i < ksi.count(); ++i)
+    {
+        KeySet::KeyPart kp(ksi.next());
+        exclusive += kp.exclusive();
+    }
+
+    fail_if (exclusive != 2, "exclusive keys: expected 2, got %d", exclusive);
+}
+END_TEST
+
 Suite* write_set_ng_suite ()
 {
     TCase* t = tcase_create ("WriteSet");
     tcase_add_test (t, ver3_basic);
     tcase_add_test (t, ver3_annotation);
+    tcase_add_test (t, ver3_xxh64);
+    tcase_add_test (t, ver3_key_escalation);
     tcase_set_timeout(t, 60);
 
     Suite* s = suite_create ("WriteSet");
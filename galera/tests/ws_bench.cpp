@@ -0,0 +1,355 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ *
+ * Write set format microbenchmark and fuzzer.
+ *
+ * Builds a stream of synthetic version 3 write sets with WriteSetOut and
+ * measures, separately:
+ *   build    - append_key()/append_data() and gather() into one buffer,
+ *   parse    - WriteSetIn construction and KeySetIn/DataSetIn iteration
+ *              with checksum disabled,
+ *   checksum - WriteSetIn construction and verify_checksum().
+ *
+ * With -f N every write set is then corrupted N times (random byte flips,
+ * truncation or extension) and parsed/verified/iterated again. Corruption
+ * must be either detected by an exception or, rarely, pass unnoticed
+ * (e.g. with CHECK_NONE). The slowest fuzzed parse is reported to catch
+ * pathological paths on malformed input.
+ *
+ * Usage: ws_bench [-n trxs] [-k keys per trx] [-d key depth]
+ *                 [-s data bytes per trx] [-r data records per trx]
+ *                 [-K key set version] [-D data set version]
+ *                 [-c checksum type] [-f fuzz rounds]
+ */
+
+#include "write_set_ng.hpp"
+#include "trx_handle.hpp"
+
+#include "gu_time.h"
+
+#include <algorithm>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <string>
+
+namespace
+{
+    struct Options
+    {
+        Options()
+            :
+            trxs   (100000),
+            keys   (1),
+            depth  (3),
+            size   (256),
+            records(1),
+            kver   (galera::KeySet::FLAT8),
+            dver   (galera::DataSet::VER1),
+            check  (gu::RecordSet::CHECK_MMH128),
+            fuzz   (0)
+        {}
+
+        long trxs;
+        long keys;
+        long depth;
+        long size;
+        long records;
+        galera::KeySet::Version  kver;
+        galera::DataSet::Version dver;
+        gu::RecordSet::CheckType check;
+        long fuzz;
+    };
+
+    void usage(const char* const name)
+    {
+        fprintf(stderr, "Usage: %s [-n trxs] [-k keys per trx] [-d key depth]"
+                " [-s data bytes per trx] [-r data records per trx]"
+                " [-K FLAT8|FLAT8A|FLAT16|FLAT16A] [-D data set version 1-2]"
+                " [-c checksum type 0-5] [-f fuzz rounds]\n", name);
+    }
+
+    typedef std::vector<std::vector<gu::byte_t> > WriteSets;
+
+    /* simple LCG to be independent of libc rand() */
+    class Rand
+    {
+    public:
+        Rand() : x_(0x1234567ULL) {}
+        long operator()(long const n)
+        {
+            x_ = x_ * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<long>((x_ >> 33) % n);
+        }
+    private:
+        unsigned long long x_;
+    };
+
+    long long build(const Options& opt, WriteSets& wss)
+    {
+        int const version(3);
+        std::string const dir(".");
+        wsrep_uuid_t const uuid = {{1, }};
+        Rand rnd;
+
+        std::vector<std::string> parts(opt.depth);
+        std::vector<wsrep_buf_t> bufs(opt.depth);
+
+        for (long d(0); d < opt.depth - 1; ++d)
+        {
+            char str[16];
+            snprintf(str, sizeof(str), "table%ld", d);
+            parts[d] = str;
+        }
+
+        /* compressible row-like payload */
+        std::vector<gu::byte_t> data(opt.size);
+        for (size_t b(0); b < data.size(); ++b)
+        {
+            data[b] = static_cast<gu::byte_t>(rnd(100) < 75 ? ' ' : rnd(256));
+        }
+        long const rec_size(opt.size / opt.records);
+
+        /* the same inline store TrxHandle would provide */
+        std::vector<gu::byte_t> reserved
+            (galera::TrxHandle::LOCAL_STORAGE_SIZE());
+
+        wss.resize(opt.trxs);
+
+        long long const t0(gu_time_monotonic());
+
+        for (long i(0); i < opt.trxs; ++i)
+        {
+            galera::WriteSetOut wso(dir, i + 1, opt.kver,
+                                    &reserved[0], reserved.size(), 0,
+                                    galera::WriteSetNG::VER3,
+                                    opt.dver, opt.dver,
+                                    galera::WriteSetNG::MAX_SIZE,
+                                    galera::DataSet::DEFAULT_COMPRESSION_LEVEL,
+                                    opt.check);
+
+            for (long k(0); k < opt.keys; ++k)
+            {
+                char row[32];
+                snprintf(row, sizeof(row), "%ld", i * opt.keys + k);
+                parts[opt.depth - 1] = row;
+
+                for (long d(0); d < opt.depth; ++d)
+                {
+                    bufs[d].ptr = parts[d].data();
+                    bufs[d].len = parts[d].size();
+                }
+
+                wso.append_key(galera::KeyData(version, &bufs[0], opt.depth,
+                                               WSREP_KEY_EXCLUSIVE, true));
+            }
+
+            for (long r(0); r < opt.records; ++r)
+            {
+                wso.append_data(&data[r * rec_size], rec_size, false);
+            }
+
+            galera::WriteSetNG::GatherVector out;
+            size_t const size(wso.gather(uuid, 1, i + 1, out));
+
+            std::vector<gu::byte_t>& ws(wss[i]);
+            ws.clear();
+            ws.reserve(size);
+            for (size_t b(0); b < out->size(); ++b)
+            {
+                const gu::byte_t* const ptr
+                    (static_cast<const gu::byte_t*>(out[b].ptr));
+                ws.insert(ws.end(), ptr, ptr + out[b].size);
+            }
+        }
+
+        return gu_time_monotonic() - t0;
+    }
+
+    /* parses all sections, returns number of records seen */
+    long iterate(const galera::WriteSetIn& ws)
+    {
+        long ret(0);
+
+        const galera::KeySetIn& ks(ws.keyset());
+        ks.rewind();
+        for (int k(0); k < ks.count(); ++k, ++ret)
+        {
+            galera::KeySet::KeyPart const kp(ks.next());
+            (void)kp.shared();
+        }
+
+        const galera::DataSetIn& ds(ws.dataset());
+        ds.rewind();
+        for (int d(0); d < ds.count(); ++d, ++ret)
+        {
+            gu::Buf const b(ds.next());
+            (void)b;
+        }
+
+        return ret;
+    }
+
+    long long parse(const WriteSets& wss, bool const verify)
+    {
+        long long const t0(gu_time_monotonic());
+
+        for (size_t i(0); i < wss.size(); ++i)
+        {
+            galera::WriteSetIn ws;
+            ws.read_buf(&wss[i][0], wss[i].size(), verify);
+
+            if (verify)
+                ws.verify_checksum();
+            else
+                (void)iterate(ws);
+        }
+
+        return gu_time_monotonic() - t0;
+    }
+
+    void corrupt(Rand& rnd, std::vector<gu::byte_t>& ws)
+    {
+        switch (rnd(4))
+        {
+        case 0: /* truncate */
+            ws.resize(rnd(ws.size()));
+            break;
+        case 1: /* extend */
+            ws.resize(ws.size() + 1 + rnd(16), gu::byte_t(rnd(256)));
+            break;
+        default: /* flip a few bytes, mostly in the headers */
+        {
+            long const flips(1 + rnd(4));
+            long const range(rnd(2) ? std::min<long>(ws.size(), 128)
+                                    : ws.size());
+            for (long f(0); f < flips; ++f)
+            {
+                ws[rnd(range)] ^= static_cast<gu::byte_t>(1 + rnd(255));
+            }
+        }
+        }
+    }
+
+    void fuzz(const Options& opt, const WriteSets& wss)
+    {
+        Rand      rnd;
+        long      rejected(0), passed(0), total(0);
+        long long max_ns(0), sum_ns(0);
+
+        for (size_t i(0); i < wss.size(); ++i)
+        {
+            for (long f(0); f < opt.fuzz; ++f, ++total)
+            {
+                std::vector<gu::byte_t> ws(wss[i]);
+                corrupt(rnd, ws);
+                if (ws.empty()) ws.push_back(0);
+
+                long long const t0(gu_time_monotonic());
+                try
+                {
+                    galera::WriteSetIn wsi;
+                    wsi.read_buf(&ws[0], ws.size());
+                    wsi.verify_checksum();
+                    (void)iterate(wsi);
+                    ++passed;
+                }
+                catch (std::exception&)
+                {
+                    ++rejected;
+                }
+                long long const ns(gu_time_monotonic() - t0);
+
+                sum_ns += ns;
+                max_ns  = std::max(max_ns, ns);
+            }
+        }
+
+        printf("fuzz:        %ld rounds, %.2f%% rejected, %ld passed, "
+               "avg %.1f us, max %.1f us\n",
+               total, 100.0 * rejected / total, passed,
+               sum_ns / 1000.0 / total, max_ns / 1000.0);
+    }
+
+    void report(const char* const what, long long const ns, double const bytes,
+                long const trxs)
+    {
+        printf("%-12s %8.1f ns/ws, %8.1f MB/s\n", what, double(ns) / trxs,
+               bytes / (1 << 20) / (ns / 1.0e9));
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:k:d:s:r:K:D:c:f:")) != -1)
+    {
+        long const val(optarg ? strtol(optarg, NULL, 10) : 0);
+
+        try
+        {
+            switch (c)
+            {
+            case 'n': opt.trxs    = val; break;
+            case 'k': opt.keys    = val; break;
+            case 'd': opt.depth   = val; break;
+            case 's': opt.size    = val; break;
+            case 'r': opt.records = val; break;
+            case 'K': opt.kver    = galera::KeySet::version(optarg); break;
+            case 'D': opt.dver    = galera::DataSet::version(val);   break;
+            case 'c':
+                if (val < gu::RecordSet::CHECK_NONE ||
+                    val > gu::RecordSet::CHECK_CRC32C)
+                {
+                    usage(argv[0]);
+                    return EXIT_FAILURE;
+                }
+                opt.check = static_cast<gu::RecordSet::CheckType>(val);
+                break;
+            case 'f': opt.fuzz    = val; break;
+            default:  usage(argv[0]); return EXIT_FAILURE;
+            }
+        }
+        catch (gu::Exception& e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (opt.trxs <= 0 || opt.keys <= 0 || opt.depth <= 0 || opt.size <= 0 ||
+        opt.records <= 0 || opt.records > opt.size || opt.fuzz < 0 ||
+        opt.kver == galera::KeySet::EMPTY || opt.dver == galera::DataSet::EMPTY)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gu_conf_self_tstamp_on();
+
+    WriteSets wss;
+    long long const build_ns(build(opt, wss));
+
+    double bytes(0);
+    for (size_t i(0); i < wss.size(); ++i) bytes += wss[i].size();
+
+    long long const parse_ns(parse(wss, false));
+    long long const check_ns(parse(wss, true));
+
+    printf("trxs: %ld, keys/trx: %ld, depth: %ld, data: %ld bytes in %ld "
+           "records, key set: %d, data set: %d, checksum: %d\n",
+           opt.trxs, opt.keys, opt.depth, opt.size, opt.records,
+           int(opt.kver), int(opt.dver), int(opt.check));
+    printf("write set:   %8.1f bytes avg\n", bytes / opt.trxs);
+    report("build:",    build_ns, bytes, opt.trxs);
+    report("parse:",    parse_ns, bytes, opt.trxs);
+    report("checksum:", check_ns, bytes, opt.trxs);
+
+    if (opt.fuzz > 0) fuzz(opt, wss);
+
+    return EXIT_SUCCESS;
+}
@@ -9,28 +9,151 @@
 #include "gu_throw.hpp"
 #include "gu_assert.hpp"
 #include "gu_limits.h"
+#include "gu_mem_stats.hpp"
+
+#include <pthread.h>
 
 #include <sstream>
 #include <iomanip> // for std::setfill() and std::setw()
+#include <vector>
+
+/* to avoid too frequent allocation, heap pages are (at least) 64K */
+static gu::Allocator::page_size_type
+heap_page_size()
+{
+    static gu::Allocator::page_size_type const ret
+        (gu_page_size_multiple(1 << 16));
+    return ret;
+}
+
+/* Per-thread cache of free standard sized heap pages. These are plain
+ * malloc()ed buffers, so it does not matter which thread allocated them. */
+static int  heap_cache_max(16);
+static bool file_huge_pages(false);
+
+static pthread_key_t  heap_cache_key;
+static pthread_once_t heap_cache_once = PTHREAD_ONCE_INIT;
+
+typedef std::vector<void*> HeapCache;
+
+extern "C" {
+
+static void
+heap_cache_exit (void* arg)
+{
+    HeapCache* const c(static_cast<HeapCache*>(arg));
+    for (size_t i(0); i < c->size(); ++i) ::free((*c)[i]);
+    gu::MemStats::sub(gu::MemStats::ALLOC_HEAP, c->size() * heap_page_size());
+    delete c;
+}
+
+static void
+heap_cache_init ()
+{
+    if (pthread_key_create(&heap_cache_key, heap_cache_exit) != 0)
+    {
+        heap_cache_max = 0;
+    }
+}
+
+}
+
+static HeapCache*
+heap_cache ()
+{
+    if (0 == heap_cache_max) return 0;
+
+    pthread_once(&heap_cache_once, heap_cache_init);
+
+    if (0 == heap_cache_max) return 0; // key creation failed
+
+    HeapCache* c(static_cast<HeapCache*>(pthread_getspecific(heap_cache_key)));
+
+    if (gu_unlikely(0 == c))
+    {
+        c = new HeapCache();
+        if (pthread_setspecific(heap_cache_key, c) != 0)
+        {
+            delete c;
+            return 0;
+        }
+    }
+
+    return c;
+}
+
+static gu::byte_t*
+heap_page_alloc (gu::Allocator::page_size_type const size)
+{
+    if (size == heap_page_size())
+    {
+        HeapCache* const c(heap_cache());
+
+        if (c && !c->empty())
+        {
+            void* const ret(c->back());
+            c->pop_back();
+            return static_cast<gu::byte_t*>(ret);
+        }
+    }
+
+    gu::byte_t* const ret(static_cast<gu::byte_t*>(::malloc(size)));
+
+    if (ret) gu::MemStats::add(gu::MemStats::ALLOC_HEAP, size);
+
+    return ret;
+}
+
+static void
+heap_page_free (gu::byte_t* const ptr, gu::Allocator::page_size_type const size)
+{
+    if (size == heap_page_size())
+    {
+        HeapCache* const c(heap_cache());
+
+        if (c && c->size() < size_t(heap_cache_max))
+        {
+            c->push_back(ptr);
+            return;
+        }
+    }
+
+    ::free(ptr);
+    gu::MemStats::sub(gu::MemStats::ALLOC_HEAP, size);
+}
+
+void
+gu::Allocator::set_heap_cache (int const pages)
+{
+    heap_cache_max = pages > 0 ? pages : 0;
+}
 
+void
+gu::Allocator::set_huge_pages (bool const on)
+{
+    file_huge_pages = on;
+}
 
 gu::Allocator::HeapPage::HeapPage (page_size_type const size) :
-    Page (static_cast<byte_t*>(::malloc(size)), size)
+    Page (heap_page_alloc(size), size),
+    capacity_(size)
 {
     if (0 == base_ptr_) gu_throw_error (ENOMEM);
 }
 
+gu::Allocator::HeapPage::~HeapPage ()
+{
+    heap_page_free (base_ptr_, capacity_);
+}
+
 
 gu::Allocator::Page*
 gu::Allocator::HeapStore::my_new_page (page_size_type const size)
 {
     if (gu_likely(size <= left_))
     {
-        /* to avoid too frequent allocation, make it (at least) 64K */
-        static page_size_type const PAGE_SIZE(gu_page_size_multiple(1 << 16));
-
         page_size_type const page_size
-            (std::min(std::max(size, PAGE_SIZE), left_));
+            (std::min(std::max(size, heap_page_size()), left_));
 
         Page* ret = new HeapPage (page_size);
 
@@ -55,6 +178,9 @@ gu::Allocator::FilePage::FilePage (const std::string& name,
     base_ptr_ = reinterpret_cast<byte_t*>(mmap_.ptr);
     ptr_      = base_ptr_;
     left_     = mmap_.size;
+
+    /* only makes sense if the page can hold at least one huge page */
+    if (file_huge_pages && mmap_.size >= (1U << 21)) mmap_.huge_pages();
 }
 
 
@@ -2,6 +2,11 @@
 /*!
  * @file Continuous buffer allocator for RecordSet
  *
+ * Standard sized heap pages are not freed but kept in a small per-thread
+ * cache, so that write sets built one after another in the same connection
+ * thread reuse the same memory. File pages can be advised to use
+ * transparent huge pages.
+ *
  * $Id$
  */
 
@@ -57,6 +62,12 @@ public:
     /* Total count of pages */
     size_t count() const { return pages_->size(); }
 
+    /* Process-wide settings: the number of heap pages each thread
+     * keeps for reuse (0 disables caching) and whether file pages should be
+     * advised to use transparent huge pages. */
+    static void set_heap_cache (int pages);
+    static void set_huge_pages (bool on);
+
 #ifdef GU_ALLOCATOR_DEBUG
     /* appends own vector of Buf structures to the passed one,
      * should be called only after all allocations have been made.
@@ -115,7 +126,11 @@ private:
 
         HeapPage (page_size_type max_size);
 
-        ~HeapPage () { free (base_ptr_); }
+        ~HeapPage ();
+
+    private:
+
+        page_size_type const capacity_;
     };
 
     class FilePage : public Page
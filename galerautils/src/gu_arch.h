@@ -59,6 +59,9 @@
 # error "Unsupported wordsize"
 #endif
 
+/* Most common, on some CPUs adjacent line prefetch makes 128 better */
+#define GU_CACHE_LINE_SIZE 64
+
 /* I'm not aware of the platforms that don't, but still */
 #define GU_ALLOW_UNALIGNED_READS 1
 
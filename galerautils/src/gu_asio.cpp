@@ -7,6 +7,23 @@
 
 #include <boost/bind.hpp>
 
+#include <cstring>
+
+#ifdef HAVE_LINUX_TLS_H
+#include <linux/tls.h>
+#include <netinet/tcp.h>
+#include <openssl/hmac.h>
+#if defined(TLS_1_3_VERSION) && OPENSSL_VERSION_NUMBER >= 0x10101000L
+#define GU_ASIO_KTLS 1
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#endif /* TLS_1_3_VERSION && OpenSSL >= 1.1.1 */
+#endif /* HAVE_LINUX_TLS_H */
+
 void gu::ssl_register_params(gu::Config& conf)
 {
     // register SSL config parameters
@@ -17,6 +34,7 @@ void gu::ssl_register_params(gu::Config& conf)
     conf.add(gu::conf::ssl_cert);
     conf.add(gu::conf::ssl_ca);
     conf.add(gu::conf::ssl_password_file);
+    conf.add(gu::conf::ssl_ktls);
 }
 
 /* checks if all mandatory SSL options are set */
@@ -76,6 +94,8 @@ void gu::ssl_init_options(gu::Config& conf)
         }
         conf.set(conf::ssl_compression, compression);
 
+        conf.set(conf::ssl_ktls, conf.get(conf::ssl_ktls, false));
+
 
         // verify that asio::ssl::context can be initialized with provided
         // values
@@ -121,6 +141,207 @@ namespace
     };
 }
 
+#ifdef GU_ASIO_KTLS
+namespace
+{
+    // Application traffic secrets of a TLS 1.3 session, recorded by the
+    // keylog callback during the handshake and attached to SSL object.
+    struct KtlsSecrets
+    {
+        std::vector<unsigned char> client;
+        std::vector<unsigned char> server;
+    };
+
+    extern "C" void ktls_secrets_free(void*, void* ptr, CRYPTO_EX_DATA*,
+                                      int, long, void*)
+    {
+        KtlsSecrets* const sec(static_cast<KtlsSecrets*>(ptr));
+        if (sec)
+        {
+            if (!sec->client.empty())
+                OPENSSL_cleanse(&sec->client[0], sec->client.size());
+            if (!sec->server.empty())
+                OPENSSL_cleanse(&sec->server[0], sec->server.size());
+            delete sec;
+        }
+    }
+
+    int ktls_ex_index()
+    {
+        static int const idx(
+            SSL_get_ex_new_index(0, 0, 0, 0, ktls_secrets_free));
+        return idx;
+    }
+
+    void ktls_unhex(const char* str, std::vector<unsigned char>& out)
+    {
+        out.clear();
+        for (; isxdigit(str[0]) && isxdigit(str[1]); str += 2)
+        {
+            char const b[3] = { str[0], str[1], 0 };
+            out.push_back(static_cast<unsigned char>(strtoul(b, 0, 16)));
+        }
+    }
+
+    // Lines are "<label> <client random> <secret>" in hex (NSS key log)
+    extern "C" void ktls_keylog(const SSL* ssl, const char* line)
+    {
+        static const char client[] = "CLIENT_TRAFFIC_SECRET_0 ";
+        static const char server[] = "SERVER_TRAFFIC_SECRET_0 ";
+
+        bool const is_client(strncmp(line, client, sizeof(client) - 1) == 0);
+        if (!is_client && strncmp(line, server, sizeof(server) - 1) != 0)
+            return;
+
+        const char* const secret(strrchr(line, ' '));
+        if (secret == 0) return;
+
+        KtlsSecrets* sec(static_cast<KtlsSecrets*>(
+                             SSL_get_ex_data(ssl, ktls_ex_index())));
+        if (sec == 0)
+        {
+            sec = new KtlsSecrets;
+            if (!SSL_set_ex_data(const_cast<SSL*>(ssl), ktls_ex_index(), sec))
+            {
+                delete sec;
+                return;
+            }
+        }
+
+        ktls_unhex(secret + 1, is_client ? sec->client : sec->server);
+    }
+
+    // HKDF-Expand-Label() of RFC 8446 with empty context, len is at most
+    // the hash length so a single HMAC block suffices
+    bool ktls_expand_label(const EVP_MD*                     md,
+                           const std::vector<unsigned char>& secret,
+                           const char*                       label,
+                           unsigned char*                    out,
+                           size_t                            len)
+    {
+        static const char prefix[] = "tls13 ";
+
+        std::vector<unsigned char> info;
+        info.push_back(static_cast<unsigned char>(len >> 8));
+        info.push_back(static_cast<unsigned char>(len));
+        info.push_back(static_cast<unsigned char>(sizeof(prefix) - 1 +
+                                                  strlen(label)));
+        info.insert(info.end(), prefix, prefix + sizeof(prefix) - 1);
+        info.insert(info.end(), label, label + strlen(label));
+        info.push_back(0); // context length
+        info.push_back(1); // HKDF block counter
+
+        unsigned char block[EVP_MAX_MD_SIZE];
+        unsigned int  block_len(0);
+
+        if (secret.empty() || len > size_t(EVP_MD_size(md)) ||
+            HMAC(md, &secret[0], secret.size(), &info[0], info.size(),
+                 block, &block_len) == 0)
+        {
+            return false;
+        }
+
+        memcpy(out, block, len);
+        OPENSSL_cleanse(block, sizeof(block));
+        return true;
+    }
+
+    template <typename CryptoInfo>
+    bool ktls_crypto_info(const EVP_MD*                     md,
+                          const std::vector<unsigned char>& secret,
+                          unsigned short const              cipher_type,
+                          CryptoInfo&                       ci)
+    {
+        unsigned char iv[sizeof(ci.salt) + sizeof(ci.iv)];
+
+        memset(&ci, 0, sizeof(ci));
+        ci.info.version     = TLS_1_3_VERSION;
+        ci.info.cipher_type = cipher_type;
+
+        if (!ktls_expand_label(md, secret, "key", ci.key, sizeof(ci.key)) ||
+            !ktls_expand_label(md, secret, "iv", iv, sizeof(iv)))
+        {
+            return false;
+        }
+
+        // record sequence number starts from 0, kernel xors it into
+        // salt|iv to form the nonce
+        memcpy(ci.salt, iv, sizeof(ci.salt));
+        memcpy(ci.iv, iv + sizeof(ci.salt), sizeof(ci.iv));
+        OPENSSL_cleanse(iv, sizeof(iv));
+        return true;
+    }
+}
+#endif /* GU_ASIO_KTLS */
+
+bool gu::ssl_enable_ktls_tx(asio::ssl::stream<asio::ip::tcp::socket>& s)
+{
+#ifdef GU_ASIO_KTLS
+    SSL* const ssl(s.impl()->ssl);
+    KtlsSecrets* const sec(static_cast<KtlsSecrets*>(
+                               SSL_get_ex_data(ssl, ktls_ex_index())));
+
+    if (sec == 0) return false; // keylog was not armed: ssl_ktls disabled
+
+    const std::vector<unsigned char>& secret(SSL_is_server(ssl) ?
+                                             sec->server : sec->client);
+
+    const SSL_CIPHER* const cipher(SSL_get_current_cipher(ssl));
+    uint16_t const cipher_id(cipher ? SSL_CIPHER_get_protocol_id(cipher):0);
+
+    if (SSL_version(ssl) != TLS1_3_VERSION ||
+        (cipher_id != 0x1301 /* TLS_AES_128_GCM_SHA256 */ &&
+         cipher_id != 0x1302 /* TLS_AES_256_GCM_SHA384 */))
+    {
+        log_debug << "kernel TLS not supported for " << SSL_get_version(ssl)
+                  << " " << SSL_get_cipher_name(ssl);
+        return false;
+    }
+
+    int const fd(s.lowest_layer().native());
+
+    if (setsockopt(fd, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) != 0)
+    {
+        log_debug << "kernel TLS not available: " << strerror(errno);
+        return false;
+    }
+
+    // until TLS_TX is set the tls ULP passes data through unchanged, so
+    // OpenSSL can still be used if any of the below fails
+    int ret;
+
+    if (cipher_id == 0x1301)
+    {
+        tls12_crypto_info_aes_gcm_128 ci;
+        if (!ktls_crypto_info(EVP_sha256(), secret,
+                              TLS_CIPHER_AES_GCM_128, ci)) return false;
+        ret = setsockopt(fd, SOL_TLS, TLS_TX, &ci, sizeof(ci));
+        OPENSSL_cleanse(&ci, sizeof(ci));
+    }
+    else
+    {
+        tls12_crypto_info_aes_gcm_256 ci;
+        if (!ktls_crypto_info(EVP_sha384(), secret,
+                              TLS_CIPHER_AES_GCM_256, ci)) return false;
+        ret = setsockopt(fd, SOL_TLS, TLS_TX, &ci, sizeof(ci));
+        OPENSSL_cleanse(&ci, sizeof(ci));
+    }
+
+    if (ret != 0)
+    {
+        log_info << "failed to enable kernel TLS: " << strerror(errno);
+        return false;
+    }
+
+    log_info << "kernel TLS enabled for sending, cipher "
+             << SSL_get_cipher_name(ssl);
+    return true;
+#else
+    (void)s;
+    return false;
+#endif /* GU_ASIO_KTLS */
+}
+
 void gu::ssl_prepare_context(const gu::Config& conf, asio::ssl::context& ctx,
                              bool verify_peer_cert)
 {
@@ -146,6 +367,18 @@ void gu::ssl_prepare_context(const gu::Config& conf, asio::ssl::context& ctx,
         ctx.set_options(asio::ssl::context::no_sslv2 |
                         asio::ssl::context::no_sslv3 |
                         asio::ssl::context::no_tlsv1);
+        param = conf::ssl_ktls;
+        if (conf.get<bool>(param, false) == true)
+        {
+#ifdef GU_ASIO_KTLS
+            // Record sequence numbers handed to kernel must start from 0:
+            // no session tickets may be sent after the handshake.
+            SSL_CTX_set_num_tickets(ctx.impl(), 0);
+            SSL_CTX_set_keylog_callback(ctx.impl(), ktls_keylog);
+#else
+            log_info << "kernel TLS is not supported by this build";
+#endif /* GU_ASIO_KTLS */
+        }
     }
     catch (asio::system_error& ec)
     {
@@ -83,6 +83,8 @@ namespace gu
         const std::string ssl_ca("socket.ssl_ca");
         /// SSL password file
         const std::string ssl_password_file("socket.ssl_password_file");
+        /// Use kernel TLS to encrypt sent data when available
+        const std::string ssl_ktls("socket.ssl_ktls");
     }
 
     // Return the cipher in use
@@ -110,6 +112,14 @@ namespace gu
     void ssl_prepare_context(const gu::Config&, asio::ssl::context&,
                              bool verify_peer_cert = true);
 
+    // Hand encryption of data sent on the stream over to kernel TLS.
+    // Must be called right after the handshake, before anything has been
+    // written to the stream. Returns true on success, further writes must
+    // then go in plain text to the next layer while reads stay on the SSL
+    // stream. Returns false and leaves the stream intact if socket.ssl_ktls
+    // is not enabled or kernel TLS is not available for the session.
+    bool ssl_enable_ktls_tx(asio::ssl::stream<asio::ip::tcp::socket>&);
+
     //
     // Address manipulation helpers
     //
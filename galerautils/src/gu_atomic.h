@@ -58,6 +58,13 @@ extern "C" {
 #define gu_atomic_get(ptr, vptr)                        \
     __atomic_load(ptr, vptr, GU_ATOMIC_SYNC_DEFAULT)
 
+// if ptr contains *eptr, stores val there and returns true,
+// otherwise loads contents of ptr to eptr and returns false
+#define gu_atomic_cas(ptr, eptr, val)                           \
+    __atomic_compare_exchange_n(ptr, eptr, val, 0,              \
+                                GU_ATOMIC_SYNC_DEFAULT,          \
+                                GU_ATOMIC_SYNC_DEFAULT)
+
 #elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_8) // use __sync_XXX builtins
 
 #define GU_ATOMIC_SYNC_NONE    0
@@ -83,6 +90,11 @@ extern "C" {
 
 #define gu_atomic_get(ptr, vptr) *vptr = __sync_fetch_and_or(ptr, 0)
 
+#define gu_atomic_cas(ptr, eptr, val)                                   \
+    __extension__ ({ __typeof__(*(eptr)) const gu_cas_e_ = *(eptr);     \
+       *(eptr) = __sync_val_compare_and_swap(ptr, gu_cas_e_, val);      \
+       *(eptr) == gu_cas_e_; })
+
 #else
 #error "This GCC version does not support 8-byte atomics on this platform. Use GCC >= 4.7.x."
 #endif /* __ATOMIC_RELAXED */
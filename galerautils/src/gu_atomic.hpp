@@ -11,8 +11,14 @@
 #define GU_ATOMIC_HPP
 
 #include "gu_atomic.h"
+#include "gu_arch.h"
+
 #include <memory>
 
+#if defined(__linux__)
+#include <sched.h> // sched_getcpu()
+#endif
+
 namespace gu
 {
     template <typename I>
@@ -84,6 +90,69 @@ namespace gu
 #endif
         I i_;
     };
+
+    /*!
+     * Atomic occupying a whole cache line, so that frequent updates from
+     * different CPUs don't invalidate the neighbouring fields. Alignment is
+     * not guaranteed for heap objects, but consecutive PaddedAtomics never
+     * share a line anyway.
+     */
+    template <typename I>
+    class PaddedAtomic : public Atomic<I>
+    {
+    public:
+        PaddedAtomic<I>(I i = 0) : Atomic<I>(i) { }
+
+        PaddedAtomic<I>& operator=(I i)
+        {
+            Atomic<I>::operator=(i);
+            return *this;
+        }
+
+    private:
+        char pad_[GU_CACHE_LINE_SIZE - sizeof(Atomic<I>)];
+    } __attribute__((aligned(GU_CACHE_LINE_SIZE)));
+
+    /*!
+     * Statistics counter for many writers and rare readers: updates go to
+     * a slot picked by the current CPU, reading sums all slots. Where the
+     * CPU number is unavailable it degenerates into a single PaddedAtomic.
+     */
+    class PerCpuCounter
+    {
+    public:
+        PerCpuCounter() : slots_() { }
+
+        long long operator()() const
+        {
+            long long ret(0);
+            for (int i(0); i < SLOTS; ++i) ret += slots_[i]();
+            return ret;
+        }
+
+        PerCpuCounter& operator+=(long long i)
+        {
+            slots_[slot()] += i;
+            return *this;
+        }
+
+        PerCpuCounter& operator++() { return operator+=(1); }
+
+    private:
+
+        static int const SLOTS = 16; // power of 2
+
+        static int slot()
+        {
+#if defined(__linux__)
+            return (sched_getcpu() & (SLOTS - 1)); // -1 on error is fine
+#else
+            return 0;
+#endif
+        }
+
+        PaddedAtomic<long long> slots_[SLOTS];
+    };
 }
 
 #endif // ::GU_ATOMIC_HPP
@@ -1,6 +1,64 @@
 //
-// Copyright (C) 2010 Codership Oy <info@codership.com>
+// Copyright (C) 2010-2017 Codership Oy <info@codership.com>
 //
 
 #include "gu_buffer.hpp"
 
+#include <cstdlib>
+#include <new>
+
+void
+gu::Buffer::grow(size_type const n)
+{
+    size_type const cap(std::max(n, 2 * cap_));
+
+    if (ptr_ == small_)
+    {
+        byte_t* const ptr(static_cast<byte_t*>(::malloc(cap)));
+        if (0 == ptr) throw std::bad_alloc();
+
+        ::memcpy(ptr, small_, size_);
+        ptr_ = ptr;
+    }
+    else
+    {
+        byte_t* const ptr(static_cast<byte_t*>(::realloc(ptr_, cap)));
+        if (0 == ptr) throw std::bad_alloc();
+
+        ptr_ = ptr;
+    }
+
+    cap_ = cap;
+}
+
+void
+gu::Buffer::swap(Buffer& other)
+{
+    if (ptr_ != small_ && other.ptr_ != other.small_)
+    {
+        std::swap(ptr_,  other.ptr_);
+        std::swap(size_, other.size_);
+        std::swap(cap_,  other.cap_);
+        return;
+    }
+
+    Buffer& s(ptr_ == small_ ? *this : other); // one that is small for sure
+    Buffer& o(&s == this ? other : *this);
+
+    if (o.ptr_ == o.small_)
+    {
+        byte_t tmp[SMALL];
+        ::memcpy(tmp, s.small_, s.size_);
+        ::memcpy(s.small_, o.small_, o.size_);
+        ::memcpy(o.small_, tmp, s.size_);
+        std::swap(s.size_, o.size_);
+        return;
+    }
+
+    // heap storage moves from o to s, small contents from s to o
+    ::memcpy(o.small_, s.small_, s.size_);
+    s.ptr_ = o.ptr_;
+    o.ptr_ = o.small_;
+    std::swap(s.size_, o.size_);
+    std::swap(s.cap_,  o.cap_);
+}
@@ -1,9 +1,18 @@
 /*
- * Copyright (C) 2009 Codership Oy <info@codership.com>
+ * Copyright (C) 2009-2017 Codership Oy <info@codership.com>
  */
 
 /*!
- * Byte buffer class. This is thin wrapper to std::vector
+ * Byte buffer class.
+ *
+ * Interface follows std::vector<byte_t>, except that growing the buffer
+ * with resize() or Buffer(n) leaves new bytes uninitialized: they are
+ * nearly always overwritten by serialization or a read right away. Use
+ * resize(n, 0) where zeroes are needed.
+ *
+ * Up to SMALL bytes are stored inside the object without heap allocation.
+ * Memory is never released by clear() or shrinking resize(), so a buffer
+ * can be reused without allocations.
  */
 
 #ifndef GU_BUFFER_HPP
@@ -12,11 +21,226 @@
 #include "gu_types.hpp" // for gu::byte_t
 
 #include <boost/shared_ptr.hpp>
-#include <vector>
+#include <boost/type_traits/is_integral.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <cstdlib>
+#include <cstring>
 
 namespace gu
 {
-    typedef std::vector<byte_t> Buffer;
+    class Buffer
+    {
+    public:
+
+        typedef byte_t         value_type;
+        typedef byte_t&        reference;
+        typedef const byte_t&  const_reference;
+        typedef byte_t*        pointer;
+        typedef const byte_t*  const_pointer;
+        typedef byte_t*        iterator;
+        typedef const byte_t*  const_iterator;
+        typedef size_t         size_type;
+        typedef ptrdiff_t      difference_type;
+
+        static size_type const SMALL = 40; // makes sizeof(Buffer) 64 on LP64
+
+        Buffer() : ptr_(small_), size_(0), cap_(SMALL) {}
+
+        explicit Buffer(size_type const n)
+            : ptr_(small_), size_(0), cap_(SMALL)
+        {
+            resize(n);
+        }
+
+        Buffer(size_type const n, byte_t const val)
+            : ptr_(small_), size_(0), cap_(SMALL)
+        {
+            resize(n, val);
+        }
+
+        template <typename I>
+        Buffer(I const first, I const last)
+            : ptr_(small_), size_(0), cap_(SMALL)
+        {
+            assign(first, last);
+        }
+
+        Buffer(const Buffer& b) : ptr_(small_), size_(0), cap_(SMALL)
+        {
+            assign(b.begin(), b.end());
+        }
+
+        ~Buffer() { if (ptr_ != small_) free(ptr_); }
+
+        Buffer& operator=(const Buffer& b)
+        {
+            if (this != &b) assign(b.begin(), b.end());
+            return *this;
+        }
+
+        iterator       begin()       { return ptr_; }
+        iterator       end()         { return ptr_ + size_; }
+        const_iterator begin() const { return ptr_; }
+        const_iterator end()   const { return ptr_ + size_; }
+
+        size_type size()     const { return size_; }
+        size_type capacity() const { return cap_; }
+        bool      empty()    const { return (0 == size_); }
+
+        reference       operator[](size_type i)       { return ptr_[i]; }
+        const_reference operator[](size_type i) const { return ptr_[i]; }
+
+        reference       front()       { return ptr_[0]; }
+        const_reference front() const { return ptr_[0]; }
+        reference       back()        { return ptr_[size_ - 1]; }
+        const_reference back()  const { return ptr_[size_ - 1]; }
+
+        pointer       data()       { return ptr_; }
+        const_pointer data() const { return ptr_; }
+
+        void reserve(size_type const n) { if (n > cap_) grow(n); }
+
+        /*! new bytes are left uninitialized */
+        void resize(size_type const n)
+        {
+            reserve(n);
+            size_ = n;
+        }
+
+        void resize(size_type const n, byte_t const val)
+        {
+            size_type const old(size_);
+            resize(n);
+            if (n > old) ::memset(ptr_ + old, val, n - old);
+        }
+
+        void clear() { size_ = 0; }
+
+        void push_back(byte_t const val)
+        {
+            if (size_ == cap_) grow(size_ + 1);
+            ptr_[size_++] = val;
+        }
+
+        void pop_back() { --size_; }
+
+        iterator insert(iterator const pos, byte_t const val)
+        {
+            return open(pos, 1, val);
+        }
+
+        void insert(iterator const pos, size_type const n, byte_t const val)
+        {
+            open(pos, n, val);
+        }
+
+        template <typename I>
+        void insert(iterator const pos, I const first, I const last)
+        {
+            insert_dispatch(pos, first, last, boost::is_integral<I>());
+        }
+
+        iterator erase(iterator const first, iterator const last)
+        {
+            ::memmove(first, last, end() - last);
+            size_ -= (last - first);
+            return first;
+        }
+
+        iterator erase(iterator const pos) { return erase(pos, pos + 1); }
+
+        template <typename I>
+        void assign(I const first, I const last)
+        {
+            assign_dispatch(first, last, boost::is_integral<I>());
+        }
+
+        void assign(size_type const n, byte_t const val)
+        {
+            clear();
+            resize(n, val);
+        }
+
+        void swap(Buffer& other);
+
+    private:
+
+        /* reallocates storage to hold at least n bytes, copying contents */
+        void grow(size_type n);
+
+        /* makes room for n bytes at pos and fills them with val,
+         * @return iterator to the first of them */
+        iterator open(iterator pos, size_type n, byte_t val)
+        {
+            iterator const ret(make_room(pos, n));
+            ::memset(ret, val, n);
+            return ret;
+        }
+
+        iterator make_room(iterator const pos, size_type const n)
+        {
+            size_type const off(pos - ptr_);
+            reserve(size_ + n);
+            ::memmove(ptr_ + off + n, ptr_ + off, size_ - off);
+            size_ += n;
+            return ptr_ + off;
+        }
+
+        template <typename I>
+        void insert_dispatch(iterator const pos, I const n, I const val,
+                             boost::true_type)
+        {
+            open(pos, n, val);
+        }
+
+        template <typename I>
+        void insert_dispatch(iterator const pos, I const first, I const last,
+                             boost::false_type)
+        {
+            size_type const n(std::distance(first, last));
+            std::copy(first, last, make_room(pos, n));
+        }
+
+        template <typename I>
+        void assign_dispatch(I const n, I const val, boost::true_type)
+        {
+            assign(size_type(n), byte_t(val));
+        }
+
+        template <typename I>
+        void assign_dispatch(I const first, I const last, boost::false_type)
+        {
+            clear();
+            insert_dispatch(begin(), first, last, boost::false_type());
+        }
+
+        byte_t*   ptr_;
+        size_type size_;
+        size_type cap_;
+        byte_t    small_[SMALL];
+    };
+
+    inline bool operator==(const Buffer& a, const Buffer& b)
+    {
+        return (a.size() == b.size() &&
+                0 == ::memcmp(a.data(), b.data(), a.size()));
+    }
+
+    inline bool operator!=(const Buffer& a, const Buffer& b)
+    {
+        return !(a == b);
+    }
+
+    inline bool operator<(const Buffer& a, const Buffer& b)
+    {
+        return std::lexicographical_compare(a.begin(), a.end(),
+                                            b.begin(), b.end());
+    }
+
+    inline void swap(Buffer& a, Buffer& b) { a.swap(b); }
+
     typedef boost::shared_ptr<Buffer> SharedBuffer;
 }
 
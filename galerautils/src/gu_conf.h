@@ -23,6 +23,9 @@ extern int gu_conf_self_tstamp_on   ();
 extern int gu_conf_self_tstamp_off  ();
 extern int gu_conf_debug_on         ();
 extern int gu_conf_debug_off        ();
+/* Makes log messages be passed to the callback by a background thread,
+ * size - max messages waiting, newer ones are dropped. 0 - synchronous log */
+extern int gu_conf_log_async        (long size);
 
 #ifdef __cplusplus
 }
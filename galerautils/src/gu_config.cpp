@@ -100,7 +100,37 @@ gu::Config::parse (const std::string& param_list)
     if (not_found) throw gu::NotFound();
 }
 
-gu::Config::Config() : params_() {}
+gu::Config::Config() : params_(), handles_() {}
+
+void
+gu::Config::update_handles (const std::string& key, const std::string& value)
+{
+    std::pair<handle_map_t::iterator, handle_map_t::iterator> const
+        range(handles_.equal_range(key));
+
+    for (handle_map_t::iterator i(range.first); i != range.second; ++i)
+    {
+        i->second->update(value);
+    }
+}
+
+void
+gu::Config::remove_handle (const std::string& key, HandleBase* const handle)
+{
+    std::pair<handle_map_t::iterator, handle_map_t::iterator> const
+        range(handles_.equal_range(key));
+
+    for (handle_map_t::iterator i(range.first); i != range.second; ++i)
+    {
+        if (i->second == handle)
+        {
+            handles_.erase(i);
+            return;
+        }
+    }
+
+    assert(0);
+}
 
 void
 gu::Config::set_longlong (const std::string& key, long long val)
@@ -15,6 +15,7 @@
 #include "gu_utils.hpp"
 #include "gu_throw.hpp"
 #include "gu_logger.hpp"
+#include "gu_atomic.h"
 #include <map>
 
 #include <climits>
@@ -36,6 +37,9 @@ public:
 
     Config ();
 
+    /* handles are bound to the original object and are not copied */
+    Config (const Config& other) : params_(other.params_), handles_() {}
+
     bool
     has (const std::string& key) const
     {
@@ -79,6 +83,7 @@ public:
 
         if (i != params_.end())
         {
+            update_handles(key, value); // throws if value can't be parsed
             i->second.set(value);
         }
         else
@@ -148,6 +153,65 @@ public:
     }
 
     void print (std::ostream& os, bool include_not_set = false) const;
+
+    class HandleBase
+    {
+    public:
+
+        virtual ~HandleBase() {}
+
+        /* parses and stores new value, throws if it can't be parsed */
+        virtual void update(const std::string& value) = 0;
+    };
+
+    /*! Typed and cached access to a parameter for hot paths.
+     *  The value is parsed once on construction and then again only when
+     *  the parameter is changed via Config::set(), so reading it costs an
+     *  atomic load. Handles must be created and destroyed while no Config
+     *  setter can run concurrently, e.g. on initialization.
+     *  T must be a type supported by atomic builtins: integer, bool, pointer.
+     *  @throws NotFound, NotSet */
+    template <typename T>
+    class Handle : public HandleBase
+    {
+    public:
+
+        Handle(Config& conf, const std::string& key)
+            : conf_(conf), key_(key), value_(conf.get<T>(key))
+        {
+            conf_.handles_.insert(std::make_pair(key_, this));
+        }
+
+        ~Handle() { conf_.remove_handle(key_, this); }
+
+        T operator()() const
+        {
+            T ret;
+            gu_atomic_get(&value_, &ret);
+            return ret;
+        }
+
+        /* sets the parameter in Config, which updates all its handles */
+        void set(const std::string& value) { conf_.set(key_, value); }
+
+        const std::string& key() const { return key_; }
+
+        void update(const std::string& value)
+        {
+            T const val(from_config<T>(value));
+            gu_atomic_set(&value_, &val);
+        }
+
+    private:
+
+        Handle(const Handle&);
+        Handle& operator=(const Handle&);
+
+        Config&           conf_;
+        std::string const key_;
+        T                 value_;
+    };
+
     /*! Convert string configuration values to other types.
      *  General template for integers, specialized templates follow below.
      *  @throw gu::Exception in case conversion failed */
@@ -218,7 +282,15 @@ private:
 
     void set_longlong (const std::string& key, long long value);
 
-    param_map_t params_;
+    void update_handles (const std::string& key, const std::string& value);
+    void remove_handle  (const std::string& key, HandleBase* handle);
+
+    typedef std::multimap<std::string, HandleBase*> handle_map_t;
+
+    param_map_t  params_;
+    handle_map_t handles_;
+
+    Config& operator= (const Config&);
 };
 
 
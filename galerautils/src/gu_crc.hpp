@@ -10,6 +10,9 @@
 #define GU_CRC_HPP
 
 #include "gu_crc32c.h"
+#include "gu_byteswap.hpp"
+
+#include <cstring>
 
 namespace gu
 {
@@ -29,6 +32,13 @@ public:
 
     uint32_t operator() () const { return get(); }
 
+    /* canonical (little-endian) byte order */
+    void gather4(void* const buf) const
+    {
+        uint32_t const res(htog<uint32_t>(get()));
+        ::memcpy (buf, &res, sizeof(res));
+    }
+
     static uint32_t digest(const void* const data, size_t const size)
     {
         return gu_crc32c(data, size);
@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2013 Codership Oy <info@codership.com>
+ * Copyright (C) 2013-2017 Codership Oy <info@codership.com>
  *
  * $Id$
  */
@@ -11,11 +11,32 @@
 
 CRC32CFunctionPtr gu_crc32c_func = crc32cSlicingBy8; // some sensible default
 
+int
+gu_crc32c_hardware()
+{
+#if defined(GU_CRC32C_HW3)
+    if (gu_crc32c_func == gu_crc32c_hw3) return 1;
+#endif /* GU_CRC32C_HW3 */
+#if !defined(CRC32C_NO_HARDWARE)
+    if (gu_crc32c_func == crc32cHardware64 ||
+        gu_crc32c_func == crc32cHardware32) return 1;
+#endif /* !CRC32C_NO_HARDWARE */
+    return 0;
+}
+
 void
 gu_crc32c_configure()
 {
     gu_crc32c_func = detectBestCRC32C();
 
+#if defined(GU_CRC32C_HW3)
+    if (gu_crc32c_hw3_init()) {
+        gu_crc32c_func = gu_crc32c_hw3;
+        gu_info ("CRC-32C: using 3-way hardware acceleration.");
+        return;
+    }
+#endif /* GU_CRC32C_HW3 */
+
 #if !defined(CRC32C_NO_HARDWARE)
     if (gu_crc32c_func == crc32cHardware64 ||
         gu_crc32c_func == crc32cHardware32) {
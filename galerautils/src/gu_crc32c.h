@@ -23,6 +23,28 @@ gu_crc32c_configure();
 
 extern CRC32CFunctionPtr gu_crc32c_func;
 
+/*! Returns non-zero if gu_crc32c_func uses CPU CRC instructions */
+extern int
+gu_crc32c_hardware();
+
+#if defined(CRC32C_x86_64) && !defined(CRC32C_NO_HARDWARE)
+#define GU_CRC32C_X86_64
+#elif defined(__aarch64__) && defined(__AARCH64EL__) && defined(__linux__)
+#define GU_CRC32C_ARM64
+#endif
+
+#if defined(GU_CRC32C_X86_64) || defined(GU_CRC32C_ARM64)
+#define GU_CRC32C_HW3
+/*! Checks for CPU support and prepares gu_crc32c_hw3(), returns 0 if
+ *  it can't be used */
+extern int
+gu_crc32c_hw3_init (void);
+
+/*! Hardware CRC-32C processing large buffers in 3 interleaved streams */
+extern uint32_t
+gu_crc32c_hw3 (uint32_t crc, const void* data, size_t length);
+#endif /* GU_CRC32C_HW3 */
+
 typedef uint32_t gu_crc32c_t;
 
 static gu_crc32c_t const GU_CRC32C_INIT = 0xFFFFFFFF;
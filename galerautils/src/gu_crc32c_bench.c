@@ -0,0 +1,87 @@
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+
+/*!
+ * @file Benchmark for CRC-32C implementations available on this host:
+ *       slicing-by-8, single stream hardware and 3-way hardware
+ *
+ * To compile on x86_64:
+  gcc -std=c99 -DHAVE_ENDIAN_H -DHAVE_BYTESWAP_H -DWITH_GALERA \
+  -O3 -msse4.2 -Wall -Werror -I../.. gu_crc32c_bench.c gu_crc32c_hw.c \
+  ../../www.evanjones.ca/crc32c.c -o gu_crc32c_bench
+ *
+ * on aarch64 replace -msse4.2 with -march=armv8-a+crc
+ *
+ * To run:
+ * gu_crc32c_bench <buffer size> <N loops>
+ */
+
+#include "gu_crc32c.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <errno.h>
+
+static int timer (const void* const buf, ssize_t const len,
+                  long long const loops, CRC32CFunctionPtr const func,
+                  const char* const alg)
+{
+    double begin, end;
+    struct timeval tv;
+    uint32_t volatile h = 0; // this variable serves to prevent compiler from
+                             // optimizing out the calls
+    long long i;
+
+    gettimeofday (&tv, NULL); begin = (double)tv.tv_sec + 1.e-6 * tv.tv_usec;
+
+    for (i = 0; i < loops; i++)
+    {
+        h += func (GU_CRC32C_INIT, buf, len);
+    }
+
+    gettimeofday (&tv, NULL); end   = (double)tv.tv_sec + 1.e-6 * tv.tv_usec;
+
+    end -= begin;
+    return printf ("%s: %lld loops, %6.3f seconds, %8.3f Mb/sec%s\n",
+                   alg, loops, end, (double)(loops * len)/end/1024/1024,
+                   h ? "" : " ");
+}
+
+int main (int argc, char* argv[])
+{
+    ssize_t buf_size = (1<<20); // 1Mb
+    long long loops = 10000;
+
+    if (argc > 1) buf_size = strtoll (argv[1], NULL, 10);
+    if (argc > 2) loops    = strtoll (argv[2], NULL, 10);
+
+    /* initialization of data buffer */
+    ssize_t buf_size_int = buf_size / sizeof(int) + 1;
+    int* buf = (int*) malloc (buf_size_int * sizeof(int));
+    if (!buf) return ENOMEM;
+    while (buf_size_int) buf[--buf_size_int] = rand();
+
+    timer (buf, buf_size, loops, crc32cSlicingBy8, "slicing-by-8");
+
+#if !defined(CRC32C_NO_HARDWARE)
+    if (detectBestCRC32C() != crc32cSlicingBy8)
+    {
+#if defined(CRC32C_x86_64)
+        timer (buf, buf_size, loops, crc32cHardware64, "hardware64");
+#else
+        timer (buf, buf_size, loops, crc32cHardware32, "hardware32");
+#endif
+    }
+#endif /* CRC32C_NO_HARDWARE */
+
+#if defined(GU_CRC32C_HW3)
+    if (gu_crc32c_hw3_init())
+    {
+        timer (buf, buf_size, loops, gu_crc32c_hw3, "hardware 3-way");
+    }
+#endif /* GU_CRC32C_HW3 */
+
+    free (buf);
+
+    return 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ *
+ * @file Hardware CRC-32C computed in three interleaved streams.
+ *
+ * CRC instructions on modern x86_64 and ARMv8 cores have a latency of
+ * about 3 cycles but a throughput of one per cycle, so a single dependency
+ * chain leaves the unit mostly idle. Large buffers are therefore split into
+ * three adjacent blocks which are checksummed in parallel, and the partial
+ * CRCs are combined by shifting them over the length of the following
+ * block with precomputed tables, see M. Adler's crc32c.c.
+ *
+ * $Id$
+ */
+
+#include "gu_crc32c.h"
+
+#if defined(GU_CRC32C_HW3)
+
+#include <string.h>
+
+#if defined(GU_CRC32C_ARM64)
+
+#if !defined(__ARM_FEATURE_CRC32)
+#error "ARMv8 CRC-32C support requires -march=armv8-a+crc"
+#endif
+
+#include <arm_acle.h>
+#include <sys/auxv.h>
+
+#ifndef HWCAP_CRC32
+#define HWCAP_CRC32 (1 << 7)
+#endif
+
+static inline uint32_t
+crc32c_u8 (uint32_t const crc, uint8_t const b)
+{
+    return __crc32cb (crc, b);
+}
+
+static inline uint32_t
+crc32c_u64 (uint32_t const crc, const uint8_t* const p)
+{
+    uint64_t v;
+    memcpy (&v, p, sizeof(v));
+    return __crc32cd (crc, v);
+}
+
+static int
+crc32c_hw_present (void)
+{
+    return (getauxval (AT_HWCAP) & HWCAP_CRC32) != 0;
+}
+
+#else /* GU_CRC32C_X86_64 */
+
+static inline uint32_t
+crc32c_u8 (uint32_t const crc, uint8_t const b)
+{
+    return __builtin_ia32_crc32qi (crc, b);
+}
+
+static inline uint32_t
+crc32c_u64 (uint32_t const crc, const uint8_t* const p)
+{
+    uint64_t v;
+    memcpy (&v, p, sizeof(v));
+    return (uint32_t)__builtin_ia32_crc32di (crc, v);
+}
+
+static int
+crc32c_hw_present (void)
+{
+    return (detectBestCRC32C() == crc32cHardware64);
+}
+
+#endif /* GU_CRC32C_X86_64 */
+
+/* Block sizes for three-way parallel computation, must be powers of 2 */
+#define CRC32C_LONG  8192
+#define CRC32C_SHORT 256
+
+/* tables to shift CRC over CRC32C_LONG and CRC32C_SHORT zero bytes */
+static uint32_t crc32c_long [4][256];
+static uint32_t crc32c_short[4][256];
+
+#define CRC32C_POLY 0x82f63b78 /* reflected */
+
+/* multiply matrix mat by vector vec over GF(2) */
+static uint32_t
+gf2_matrix_times (const uint32_t* mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+
+    while (vec)
+    {
+        if (vec & 1) sum ^= *mat;
+        vec >>= 1;
+        mat++;
+    }
+
+    return sum;
+}
+
+static void
+gf2_matrix_square (uint32_t* const square, const uint32_t* const mat)
+{
+    int n;
+    for (n = 0; n < 32; n++) square[n] = gf2_matrix_times (mat, mat[n]);
+}
+
+/* Construct in even the operator to apply len zero bytes to CRC,
+ * len must be a power of 2 */
+static void
+crc32c_zeros_op (uint32_t* const even, size_t len)
+{
+    uint32_t odd[32];
+    uint32_t row = 1;
+    int      n;
+
+    /* operator for one zero bit in odd */
+    odd[0] = CRC32C_POLY;
+    for (n = 1; n < 32; n++)
+    {
+        odd[n] = row;
+        row <<= 1;
+    }
+
+    gf2_matrix_square (even, odd); /* two zero bits in even */
+    gf2_matrix_square (odd, even); /* four zero bits in odd */
+
+    /* first square puts the operator for one zero byte in even, next
+     * one for two zero bytes in odd and so on until len is exhausted */
+    do
+    {
+        gf2_matrix_square (even, odd);
+        len >>= 1;
+        if (0 == len) return;
+        gf2_matrix_square (odd, even);
+        len >>= 1;
+    }
+    while (len);
+
+    memcpy (even, odd, sizeof(odd));
+}
+
+/* lookup tables to apply the operator byte by byte */
+static void
+crc32c_zeros (uint32_t zeros[4][256], size_t const len)
+{
+    uint32_t op[32];
+    uint32_t n;
+
+    crc32c_zeros_op (op, len);
+
+    for (n = 0; n < 256; n++)
+    {
+        zeros[0][n] = gf2_matrix_times (op, n);
+        zeros[1][n] = gf2_matrix_times (op, n << 8);
+        zeros[2][n] = gf2_matrix_times (op, n << 16);
+        zeros[3][n] = gf2_matrix_times (op, n << 24);
+    }
+}
+
+static inline uint32_t
+crc32c_shift (uint32_t zeros[4][256], uint32_t const crc)
+{
+    return zeros[0][crc & 0xff]         ^ zeros[1][(crc >> 8) & 0xff] ^
+           zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+int
+gu_crc32c_hw3_init (void)
+{
+    if (!crc32c_hw_present()) return 0;
+
+    crc32c_zeros (crc32c_long,  CRC32C_LONG);
+    crc32c_zeros (crc32c_short, CRC32C_SHORT);
+
+    return 1;
+}
+
+uint32_t
+gu_crc32c_hw3 (uint32_t crc, const void* const data, size_t len)
+{
+    const uint8_t* next = (const uint8_t*)data;
+    const uint8_t* end;
+    uint32_t crc1, crc2;
+
+    /* bring the data pointer to an 8-byte boundary */
+    while (len && ((uintptr_t)next & 7) != 0)
+    {
+        crc = crc32c_u8 (crc, *next);
+        next++;
+        len--;
+    }
+
+    while (len >= CRC32C_LONG*3)
+    {
+        crc1 = 0;
+        crc2 = 0;
+        end  = next + CRC32C_LONG;
+        do
+        {
+            crc  = crc32c_u64 (crc,  next);
+            crc1 = crc32c_u64 (crc1, next + CRC32C_LONG);
+            crc2 = crc32c_u64 (crc2, next + CRC32C_LONG*2);
+            next += 8;
+        }
+        while (next < end);
+        crc = crc32c_shift (crc32c_long, crc) ^ crc1;
+        crc = crc32c_shift (crc32c_long, crc) ^ crc2;
+        next += CRC32C_LONG*2;
+        len  -= CRC32C_LONG*3;
+    }
+
+    while (len >= CRC32C_SHORT*3)
+    {
+        crc1 = 0;
+        crc2 = 0;
+        end  = next + CRC32C_SHORT;
+        do
+        {
+            crc  = crc32c_u64 (crc,  next);
+            crc1 = crc32c_u64 (crc1, next + CRC32C_SHORT);
+            crc2 = crc32c_u64 (crc2, next + CRC32C_SHORT*2);
+            next += 8;
+        }
+        while (next < end);
+        crc = crc32c_shift (crc32c_short, crc) ^ crc1;
+        crc = crc32c_shift (crc32c_short, crc) ^ crc2;
+        next += CRC32C_SHORT*2;
+        len  -= CRC32C_SHORT*3;
+    }
+
+    end = next + (len - (len & 7));
+    while (next < end)
+    {
+        crc = crc32c_u64 (crc, next);
+        next += 8;
+    }
+    len &= 7;
+
+    while (len)
+    {
+        crc = crc32c_u8 (crc, *next);
+        next++;
+        len--;
+    }
+
+    return crc;
+}
+
+#endif /* GU_CRC32C_HW3 */
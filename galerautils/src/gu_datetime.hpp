@@ -139,6 +139,12 @@ namespace gu
              */
             static inline Date monotonic() { return gu_time_monotonic(); }
 
+            /*!
+             * @brief Get time from cheap monotonic clock, comparable only
+             *        with other fast() readings, see gu_time_fast().
+             */
+            static inline Date fast() { return gu_time_fast(); }
+
             /*!
              * @brief Get maximum representable timestamp.
              */
@@ -30,6 +30,10 @@
 #define GU_DBUG_SYNC_WAIT(_c)                     \
     GU_DBUG_EXECUTE(_c, gu_debug_sync_wait(_c);)
 
+// Cheap check whether any dbug keywords are set at all, allows to skip
+// preparations for GU_DBUG_SYNC_WAIT() like releasing locks
+#define GU_DBUG_SYNC_ENABLED() (_gu_db_on_ != 0)
+
 // Wait for sync signal identified by sync string
 void gu_debug_sync_wait(const std::string& sync);
 
@@ -42,6 +46,7 @@ std::string gu_debug_sync_waiters();
 #else
 
 #define GU_DBUG_SYNC_WAIT(_c)
+#define GU_DBUG_SYNC_ENABLED() (false)
 
 #endif // GU_DBUG_ON
 
@@ -6,6 +6,7 @@
 
 #include "gu_fdesc.hpp"
 
+#include "gu_io_uring.hpp"
 #include "gu_logger.hpp"
 #include "gu_throw.hpp"
 
@@ -17,8 +18,11 @@ extern "C" {
 #define _XOPEN_SOURCE 600
 #endif
 
+#include <algorithm> // std::min()
 #include <cerrno>
+#include <deque>
 #include <limits>
+#include <vector>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <fcntl.h>
@@ -200,28 +204,147 @@ namespace gu
         return true;
     }
 
-    /*! prealloc() fallback */
+    static off_t const write_chunk_size(1 << 20);
+
+    /* length of the write that starts at offset: up to the end of
+     * the chunk it falls into */
+    static inline size_t
+    write_len (off_t const start, off_t const offset, off_t const size)
+    {
+        off_t const chunk_end
+            (offset + write_chunk_size - (offset - start) % write_chunk_size);
+
+        return std::min(chunk_end, size) - offset;
+    }
+
+    /*! write_file() over io_uring: keeps several chunk writes in flight and
+     *  submits them with one system call. Returns false if io_uring is not
+     *  available or does not support writes to this file, then nothing
+     *  is in flight any more and write_file() must be done the usual way. */
+    bool
+    FileDescriptor::write_file_uring (off_t const start, const void* const buf)
+    {
+        static unsigned const depth(8);
+
+        bool ready(false);
+
+        try
+        {
+            IoUring ring(depth);
+            ready = true;
+
+            return write_uring_loop(ring, start, buf);
+        }
+        catch (Exception& e)
+        {
+            if (ready) throw;
+
+            log_debug << "Not using io_uring for '" << name_ << "': "
+                      << e.what();
+            return false;
+        }
+    }
+
+    bool
+    FileDescriptor::write_uring_loop (IoUring& ring, off_t const start,
+                                      const void* const buf)
+    {
+        std::deque<off_t> retry;
+        off_t             next(start);
+        int               err(0);
+        bool              supported(true);
+
+        while (ring.pending() > 0 ||
+               (0 == err && supported && (next < size_ || !retry.empty())))
+        {
+            while (0 == err && supported)
+            {
+                off_t const off(retry.empty() ? next : retry.front());
+
+                if (off >= size_) break;
+
+                size_t const len(write_len(start, off, size_));
+
+                if (!ring.write(fd_, buf, len, off, off)) break;
+
+                if (retry.empty()) next += len; else retry.pop_front();
+            }
+
+            ring.submit(1);
+
+            uint64_t tag;
+            int      res;
+
+            while (ring.reap(tag, res))
+            {
+                off_t  const off(tag);
+                size_t const len(write_len(start, off, size_));
+
+                if (res > 0)
+                {
+                    /* short write, remainder goes as a separate chunk */
+                    if (size_t(res) < len) retry.push_back(off + res);
+                }
+                else if (-EINTR == res || -EAGAIN == res)
+                {
+                    retry.push_back(off);
+                }
+                else if (-EINVAL == res || -EOPNOTSUPP == res)
+                {
+                    supported = false;
+                }
+                else if (0 == err)
+                {
+                    err = (0 == res ? EIO : -res);
+                }
+            }
+        }
+
+        if (0 != err) gu_throw_error (err) << "File preallocation failed";
+
+        if (!supported)
+        {
+            log_debug << "io_uring writes not supported for '" << name_ << '\'';
+        }
+
+        return supported;
+    }
+
+    /*! prealloc() fallback: fills the rest of the file with zeroes in large
+     *  chunks, one write() per page was unbearably slow on some filesystems */
     void
     FileDescriptor::write_file (off_t const start)
     {
-        // last byte of the start page
-        off_t offset = (start / GU_PAGE_SIZE + 1) * GU_PAGE_SIZE - 1;
-
         log_info << "Preallocating " << (size_ - start) << '/' << size_
                  << " bytes in '" << name_ << "'...";
 
-        while (offset < size_ && write_byte (offset))
-        {
-            offset += GU_PAGE_SIZE;
-        }
+        std::vector<byte_t> const zeroes
+            (std::min(write_chunk_size, size_ - start));
 
-        if (offset >= size_ && write_byte (size_ - 1))
+        if (write_file_uring(start, &zeroes[0]))
         {
             sync();
             return;
         }
 
-        gu_throw_error (errno) << "File preallocation failed";
+        off_t offset(start);
+
+        while (offset < size_)
+        {
+            size_t  const len(std::min(write_chunk_size, size_ - offset));
+            ssize_t const ret(pwrite(fd_, &zeroes[0], len, offset));
+
+            if (ret > 0)
+            {
+                offset += ret;
+            }
+            else if (0 == ret || EINTR != errno)
+            {
+                gu_throw_error (errno) << "File preallocation failed";
+            }
+        }
+
+        sync();
     }
 
     void
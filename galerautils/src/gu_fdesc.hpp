@@ -15,6 +15,8 @@
 namespace gu
 {
 
+class IoUring;
+
 class FileDescriptor
 {
 public:
@@ -48,6 +50,8 @@ private:
 
     bool write_byte (off_t offset);
     void write_file (off_t start = 0);
+    bool write_file_uring (off_t start, const void* zeroes);
+    bool write_uring_loop (IoUring& ring, off_t start, const void* zeroes);
     void prealloc   (off_t start = 0);
 
     void constructor_common();
@@ -18,6 +18,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdbool.h>
+#include <sys/mman.h>
 
 #include "gu_assert.h"
 #include "gu_limits.h"
@@ -39,6 +40,8 @@ struct gu_fifo
     ulong length;
     ulong length_mask;
     ulong alloc;
+    void* spare;     /* last freed row, kept to avoid churn at row boundary */
+    bool  row_mmap;  /* rows are mapped directly to return memory on free */
     long  get_wait;
     long  put_wait;
     long long q_len;
@@ -137,6 +140,7 @@ gu_fifo_t *gu_fifo_create (size_t length, size_t item_size)
             ret->item_size   = item_size;
             ret->row_size    = row_size;
             ret->alloc       = alloc_size;
+            ret->row_mmap    = (row_size >= gu_page_size());
             gu_mutex_init (&ret->lock, NULL);
             gu_cond_init  (&ret->get_cond, NULL);
             gu_cond_init  (&ret->put_cond, NULL);
@@ -303,14 +307,64 @@ static inline int fifo_lock_put (gu_fifo_t *q)
 /* unlock the queue after putting an item */
 static inline int fifo_unlock_put (gu_fifo_t *q)
 {
+    bool const wake = (q->get_wait > 0);
+    int        ret;
+
     assert (q->used > 0);
 
-    if (q->get_wait > 0) {
-        q->get_wait--;
-        gu_cond_signal (&q->get_cond);
+    if (wake) q->get_wait--;
+
+    ret = fifo_unlock(q);
+
+    /* Signal after unlocking, otherwise the woken getter would immediately
+     * block on the lock still held here. The waiter is already accounted
+     * for, so no wakeup can be lost, and putting concurrently with
+     * gu_fifo_destroy() is not allowed anyway. */
+    if (wake) gu_cond_signal (&q->get_cond);
+
+    return ret;
+}
+
+/* Rows that take whole pages are mapped directly, so that a drained backlog
+ * is returned to the OS right away instead of lingering in the heap. */
+static inline void*
+fifo_row_alloc (gu_fifo_t* q)
+{
+    void* ret = q->spare;
+
+    if (ret) {
+        q->spare = NULL;
+        return ret;
     }
 
-    return fifo_unlock(q);
+    if (q->row_mmap) {
+        ret = mmap (NULL, q->row_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (MAP_FAILED == ret) ret = NULL;
+    }
+    else {
+        ret = gu_malloc (q->row_size);
+    }
+
+    if (ret) q->alloc += q->row_size;
+
+    return ret;
+}
+
+static inline void
+fifo_row_unmap (gu_fifo_t* q, void* row)
+{
+    if (q->row_mmap) munmap (row, q->row_size);
+    else             gu_free (row);
+
+    q->alloc -= q->row_size;
+}
+
+static inline void
+fifo_row_free (gu_fifo_t* q, void* row)
+{
+    if (NULL == q->spare) q->spare = row;
+    else                  fifo_row_unmap (q, row);
 }
 
 #define FIFO_ROW(q,x) ((x) >> q->col_shift) /* div by row width */
@@ -345,9 +399,8 @@ void gu_fifo_pop_head (gu_fifo_t* q)
         /* removing last unit from the row */
         ulong row = FIFO_ROW (q, q->head);
         assert (q->rows[row] != NULL);
-        gu_free (q->rows[row]);
+        fifo_row_free (q, q->rows[row]);
         q->rows[row] = NULL;
-        q->alloc -= q->row_size;
     }
 
     q->head = FIFO_INC(q, q->head);
@@ -375,9 +428,9 @@ void* gu_fifo_get_tail (gu_fifo_t* q)
 
         // check if row is allocated and allocate if not.
         if (NULL == q->rows[row] &&
-            NULL == (q->alloc += q->row_size,
-                     q->rows[row] = gu_malloc(q->row_size))) {
-            q->alloc -= q->row_size;
+            NULL == (q->rows[row] = fifo_row_alloc(q))) {
+            gu_error ("Failed to allocate %lu bytes for FIFO row",
+                      q->row_size);
         }
         else {
             return ((uint8_t*)q->rows[row] +
@@ -425,6 +478,18 @@ long gu_fifo_length (gu_fifo_t* q)
     return q->used;
 }
 
+/*! returns how much memory the queue holds */
+size_t gu_fifo_memory (gu_fifo_t* q)
+{
+    size_t ret;
+
+    fifo_lock (q);
+    ret = q->alloc;
+    fifo_unlock (q);
+
+    return ret;
+}
+
 /*! returns how many items were in the queue per push_tail() */
 void gu_fifo_stats_get (gu_fifo_t* q, int* q_len, int* q_len_max,
                         int* q_len_min, double* q_len_avg)
@@ -502,12 +567,12 @@ void gu_fifo_destroy   (gu_fifo_t *queue)
         ulong row = FIFO_ROW(queue, queue->tail);
         if (queue->rows[row]) {
             assert (FIFO_COL(queue, queue->tail) != 0);
-            gu_free (queue->rows[row]);
-            queue->alloc -= queue->row_size;
+            fifo_row_unmap (queue, queue->rows[row]);
         }
         else {
             assert (FIFO_COL(queue, queue->tail) == 0);
         }
+        if (queue->spare) fifo_row_unmap (queue, queue->spare);
         gu_free (queue);
     }
 }
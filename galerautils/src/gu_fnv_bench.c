@@ -2,7 +2,8 @@
 
 /*!
  * @file Benchmark for different hash implementations:
- *       fnv32, fnv64, fnv128, mmh3, md5 from libssl and md5 from crypto++
+ *       fnv32, fnv64, fnv128, mmh3, xxh64, md5 from libssl and md5 from
+ *       crypto++
  *
  * To compile on Ubuntu:
   g++ -DHAVE_ENDIAN_H -DHAVE_BYTESWAP_H -DGALERA_LOG_H_ENABLE_CXX \
@@ -20,6 +21,7 @@
 #include "gu_fnv.h"
 #include "gu_mmh3.h"
 #include "gu_spooky.h"
+#include "gu_xxhash.h"
 #include "gu_hash.h"
 
 #include <stdio.h>
@@ -47,7 +49,10 @@ enum algs
     MD5SSL,
     MD5CPP,
     FAST128,
-    TABLE
+    TABLE,
+    XXH64,
+    XXH64M, /* multipart */
+    MMH128M /* multipart */
 };
 
 static int timer (const void* const buf, ssize_t const len,
@@ -200,6 +205,38 @@ static int timer (const void* const buf, ssize_t const len,
         INTERNAL_LOOP_END
         break;
     }
+    case XXH64:
+    {
+        alg = "xxh64";
+        INTERNAL_LOOP_BEGIN
+            h = gu_xxh64 (buf, len);
+        INTERNAL_LOOP_END
+        break;
+    }
+    case XXH64M:
+    {
+        alg = "xxh64 multipart";
+        INTERNAL_LOOP_BEGIN
+            gu_xxh64_ctx_t ctx;
+            gu_xxh64_init (&ctx);
+            gu_xxh64_append (&ctx, buf, len/2);
+            gu_xxh64_append (&ctx, (const char*)buf + len/2, len - len/2);
+            h = gu_xxh64_get (&ctx);
+        INTERNAL_LOOP_END
+        break;
+    }
+    case MMH128M:
+    {
+        alg = "mmh128 multipart";
+        INTERNAL_LOOP_BEGIN
+            gu_mmh128_ctx_t ctx;
+            gu_mmh128_init (&ctx);
+            gu_mmh128_append (&ctx, buf, len/2);
+            gu_mmh128_append (&ctx, (const char*)buf + len/2, len - len/2);
+            h = gu_mmh128_get64 (&ctx);
+        INTERNAL_LOOP_END
+        break;
+    }
     }
     EXTERNAL_LOOP_END
 
@@ -236,6 +273,9 @@ int main (int argc, char* argv[])
     timer (buf, buf_size, loops, FNV128);
     timer (buf, buf_size, loops, MMH32);
     timer (buf, buf_size, loops, MMH128);
+    timer (buf, buf_size, loops, MMH128M);
+    timer (buf, buf_size, loops, XXH64);
+    timer (buf, buf_size, loops, XXH64M);
 //    timer (buf, buf_size, loops, SPOOKYS);
     timer (buf, buf_size, loops, SPOOKY);
 //    timer (buf, buf_size, loops, MD5SSL);
@@ -11,6 +11,10 @@
  *                    inconsistent hash functions to be used only in local hash
  *                    tables. Only size_t variants defined.
  *
+ * In addition gu_xxh64 (gu_xxhash.h) provides a faster multipart 64-bit hash
+ * for the places where its use is negotiated with the peers, since its values
+ * differ from gu_hash.
+ *
  * 128-bit result is returned through void* parameter as a byte array in
  * canonical order.
  * 64/32-bit results are returned as uint64_t/uint32_t integers and thus in host
@@ -29,6 +33,7 @@ extern "C" {
 #include "gu_fnv.h"
 #include "gu_mmh3.h"
 #include "gu_spooky.h"
+#include "gu_xxhash.h"
 
 /*
  * General purpose globally consistent _fast_ hash, if in doubt use that.
@@ -11,17 +11,20 @@
 
 #include <sstream>
 #include <limits>
-#include <vector>
+#include <algorithm>
 
 gu::Histogram::Histogram(const std::string& vals)
     :
-    cnt_()
+    bins_(),
+    shards_(new Shard[SHARDS])
 {
     std::vector<std::string> varr = gu::strsplit(vals, ',');
 
     for (std::vector<std::string>::const_iterator
              i = varr.begin(); i != varr.end(); ++i)
     {
+        if (i->empty()) continue;
+
         double val;
 
         std::istringstream is(*i);
@@ -29,68 +32,185 @@ gu::Histogram::Histogram(const std::string& vals)
 
         if (is.fail())
         {
+            delete[] shards_;
             gu_throw_fatal << "Parse error";
         }
 
-        if (cnt_.insert(std::make_pair(val, 0)).second == false)
+        if (std::find(bins_.begin(), bins_.end(), val) != bins_.end())
         {
+            delete[] shards_;
             gu_throw_fatal << "Failed to insert value: " << val;
         }
+
+        bins_.push_back(val);
     }
+
+    std::sort(bins_.begin(), bins_.end());
+
+    memset(shards_, 0, SHARDS * sizeof(Shard));
 }
 
-void gu::Histogram::insert(const double val)
+gu::Histogram::~Histogram()
 {
-    if (val < 0.0)
+    delete[] shards_;
+}
+
+void gu::Histogram::insert(const double sec)
+{
+    if (sec < 0.0)
     {
-        log_warn << "Negative value (" << val << "), discarding";
+        log_warn << "Negative value (" << sec << "), discarding";
         return;
     }
 
-    // Returns element that has key greater to val,
-    // the correct bin is one below that
-    std::map<double, long long>::iterator i(cnt_.upper_bound(val));
+    insert_ns(sec < 1.0e9 ? static_cast<long long>(sec * 1.0e9) :
+              std::numeric_limits<long long>::max());
+}
 
-    if (i == cnt_.end())
+void gu::Histogram::merge(const Histogram& other)
+{
+    std::vector<long long> cnt;
+    long long sum;
+
+    other.collect(cnt, &sum);
+
+    Shard& s(shards_[shard()]);
+
+    for (int i(0); i < BUCKETS; ++i)
     {
-        ++cnt_.rbegin()->second;
+        if (cnt[i]) add(s.cnt[i], cnt[i]);
     }
-    else if (i == cnt_.begin())
+
+    add(s.sum, sum);
+}
+
+void gu::Histogram::clear()
+{
+    long long const zero(0);
+
+    for (int i(0); i < SHARDS; ++i)
     {
-        log_warn << "value " << val << " below histogram range, discarding";
+        Shard& s(shards_[i]);
+
+        for (int b(0); b < BUCKETS; ++b) gu_atomic_set(&s.cnt[b], &zero);
+
+        gu_atomic_set(&s.sum, &zero);
     }
-    else
+}
+
+long long
+gu::Histogram::collect(std::vector<long long>& cnt, long long* const sum)
+    const
+{
+    cnt.assign(BUCKETS, 0);
+
+    long long total(0);
+    long long s(0);
+
+    for (int i(0); i < SHARDS; ++i)
     {
-        --i;
-        ++i->second;
+        const Shard& sh(shards_[i]);
+        long long v;
+
+        for (int b(0); b < BUCKETS; ++b)
+        {
+            gu_atomic_get(&sh.cnt[b], &v);
+            cnt[b] += v;
+            total  += v;
+        }
+
+        gu_atomic_get(&sh.sum, &v);
+        s += v;
     }
+
+    if (sum) *sum = s;
+
+    return total;
 }
 
-void gu::Histogram::clear()
+long long gu::Histogram::count() const
+{
+    std::vector<long long> cnt;
+    return collect(cnt, 0);
+}
+
+double gu::Histogram::mean() const
+{
+    std::vector<long long> cnt;
+    long long sum;
+    long long const n(collect(cnt, &sum));
+
+    return (n > 0 ? double(sum)/n : 0.0);
+}
+
+static long long
+histogram_percentile(const std::vector<long long>& cnt, long long const n,
+                     double const p)
 {
-    for (std::map<double, long long>::iterator i = cnt_.begin();
-         i != cnt_.end(); ++i)
+    if (0 == n) return 0;
+
+    long long const target(std::max(1LL, static_cast<long long>(
+                                        std::ceil(p / 100.0 * n))));
+    long long sum(0);
+
+    for (int i(0); i < gu::Histogram::BUCKETS; ++i)
     {
-        i->second = 0;
+        sum += cnt[i];
+        if (sum >= target) return gu::Histogram::bucket_max(i);
     }
+
+    return gu::Histogram::bucket_max(gu::Histogram::BUCKETS - 1);
+}
+
+long long gu::Histogram::percentile(double const p) const
+{
+    std::vector<long long> cnt;
+    long long const n(collect(cnt, 0));
+
+    return histogram_percentile(cnt, n, p);
 }
 
 std::ostream& gu::operator<<(std::ostream& os, const Histogram& hs)
 {
-    std::map<double, long long>::const_iterator i, i_next;
+    std::vector<long long> cnt;
+    long long const norm(hs.collect(cnt, 0));
+
+    if (hs.bins_.empty())
+    {
+        static double const pct[] = { 50.0, 90.0, 99.0, 99.9 };
+        static const char*  const name[] = { "p50", "p90", "p99", "p999" };
+
+        os << "n:" << norm;
+
+        for (size_t i(0); i < sizeof(pct)/sizeof(pct[0]); ++i)
+        {
+            os << "," << name[i] << ":"
+               << double(histogram_percentile(cnt, norm, pct[i]))/1.0e9;
+        }
+
+        return os;
+    }
 
-    long long norm = 0;
-    for (i = hs.cnt_.begin(); i != hs.cnt_.end(); ++i)
+    /* fold buckets into bins by their greatest value, so a bin boundary is
+     * accurate to within a bucket, values below the first bin go to it */
+    std::vector<long long> bcnt(hs.bins_.size(), 0);
+
+    for (int i(0); i < Histogram::BUCKETS; ++i)
     {
-        norm += i->second;
+        if (0 == cnt[i]) continue;
+
+        double const v(double(Histogram::bucket_max(i))/1.0e9);
+        std::vector<double>::const_iterator const b
+            (std::upper_bound(hs.bins_.begin(), hs.bins_.end(), v));
+
+        size_t const idx(b == hs.bins_.begin() ? 0 : b - hs.bins_.begin() - 1);
+        bcnt[idx] += cnt[i];
     }
 
-    for (i = hs.cnt_.begin(); i != hs.cnt_.end(); i = i_next)
+    for (size_t i(0); i < hs.bins_.size(); ++i)
     {
-        i_next = i;
-        ++i_next;
-        os << i->first << ":" << std::fabs(double(i->second)/double(norm));
-        if (i_next != hs.cnt_.end()) os << ",";
+        if (i > 0) os << ",";
+        os << hs.bins_[i] << ":" << std::fabs(double(bcnt[i])/double(norm));
     }
 
     return os;
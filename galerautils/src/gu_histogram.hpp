@@ -2,10 +2,27 @@
  * Copyright (C) 2014 Codership Oy <info@codership.com>
  */
 
+/**
+ * @file Latency histogram.
+ *
+ * Values are nanoseconds, counted in fixed log-linear buckets: 32 linear
+ * sub-buckets per power of 2, which bounds the relative error of a reported
+ * percentile by 1/32. Counters are sharded by thread and updated with atomic
+ * adds, so insert() can be called concurrently without locking. Queries sum
+ * up the shards and are meant for status/reporting, not for the hot path.
+ */
+
 #ifndef _gu_histogram_hpp_
 #define _gu_histogram_hpp_
 
-#include <map>
+#include "gu_atomic.h"
+
+#include <pthread.h>
+#include <string.h> // memcpy()
+#include <stdint.h>
+
+#include <vector>
+#include <string>
 #include <ostream>
 
 namespace gu
@@ -13,13 +30,110 @@ namespace gu
     class Histogram
     {
     public:
-        Histogram(const std::string&);
-        void insert(const double);
+
+        /* vals is an optional comma-separated list of bin boundaries in
+         * seconds used by to_string()/operator<< to print the fraction of
+         * values in each bin. Without it percentiles are printed instead. */
+        explicit Histogram(const std::string& vals = "");
+        ~Histogram();
+
+        /* records a value in seconds */
+        void insert(double sec);
+
+        /* records a value in nanoseconds */
+        void insert_ns(long long nsec)
+        {
+            if (nsec < 0) nsec = 0;
+
+            Shard& s(shards_[shard()]);
+
+            add(s.cnt[bucket(nsec)], 1);
+            add(s.sum, nsec);
+        }
+
+        /* adds all values recorded in other */
+        void merge(const Histogram& other);
+
         void clear();
+
+        long long count() const;
+        double    mean()  const; // nanoseconds
+
+        /* returns upper bound of the bucket holding p-th percentile
+         * (0.0 < p <= 100.0) in nanoseconds, 0 if no values were recorded */
+        long long percentile(double p) const;
+
         friend std::ostream& operator<<(std::ostream&, const Histogram&);
         std::string to_string() const;
+
+        static int const SUB_BITS = 5;
+        static int const SUB      = 1 << SUB_BITS;
+        static int const MAX_BITS = 42; // values above 2^42ns (~73 min) clamp
+        static int const BUCKETS  = (MAX_BITS - SUB_BITS + 1) * SUB;
+        static int const SHARDS   = 8; // see shard()
+
+        static int bucket(long long v)
+        {
+            if (v < SUB) return static_cast<int>(v);
+
+            int const e(63 - __builtin_clzll(v)); // >= SUB_BITS
+
+            if (e >= MAX_BITS) return BUCKETS - 1;
+
+            int const m((v >> (e - SUB_BITS)) & (SUB - 1));
+
+            return (e - SUB_BITS + 1) * SUB + m;
+        }
+
+        /* returns the smallest value of the bucket */
+        static long long bucket_min(int idx)
+        {
+            if (idx < SUB) return idx;
+
+            int const e(idx / SUB + SUB_BITS - 1);
+            int const m(idx % SUB);
+
+            return static_cast<long long>(SUB + m) << (e - SUB_BITS);
+        }
+
+        /* returns the greatest value of the bucket */
+        static long long bucket_max(int idx)
+        {
+            return bucket_min(idx + 1) - 1;
+        }
+
     private:
-        std::map<double, long long> cnt_;
+
+        Histogram(const Histogram&);
+        Histogram& operator=(const Histogram&);
+
+        struct Shard
+        {
+            long long cnt[BUCKETS];
+            long long sum;
+        };
+
+        /* pthread_t is opaque, mix whatever bits it has */
+        static int shard()
+        {
+            pthread_t const self(pthread_self());
+            uint64_t id(0);
+            memcpy(&id, &self,
+                   sizeof(self) < sizeof(id) ? sizeof(self) : sizeof(id));
+
+            return static_cast<int>((id * 0x9E3779B97F4A7C15ULL) >> 61);
+        }
+
+        static void add(long long& c, long long const v)
+        {
+            gu_atomic_fetch_and_add(&c, v);
+        }
+
+        /* sums up the shards into cnt, returns total count */
+        long long collect(std::vector<long long>& cnt, long long* sum) const;
+
+        std::vector<double> bins_;
+        Shard*              shards_;
     };
 
     std::ostream& operator<<(std::ostream&, const Histogram&);
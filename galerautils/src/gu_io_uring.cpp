@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "gu_io_uring.hpp"
+
+#include "gu_throw.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if defined(HAVE_LINUX_IO_URING_H)
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* the rings are shared with the kernel */
+#define GU_URING_LOAD(p)     __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define GU_URING_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+
+template <typename T> static inline T*
+ring_ptr (void* const base, size_t const off)
+{
+    return reinterpret_cast<T*>(static_cast<char*>(base) + off);
+}
+
+static void*
+ring_mmap (int const fd, size_t const size, off_t const off)
+{
+    void* const ret(mmap(NULL, size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, fd, off));
+
+    if (MAP_FAILED == ret)
+    {
+        int const err(errno);
+        close(fd);
+        gu_throw_error(err) << "io_uring mmap() failed";
+    }
+
+    return ret;
+}
+
+gu::IoUring::IoUring (unsigned const entries)
+    :
+    fd_        (-1),
+    sq_ptr_    (NULL),
+    sq_size_   (0),
+    cq_ptr_    (NULL),
+    cq_size_   (0),
+    sqes_      (NULL),
+    sqes_size_ (0),
+    sq_head_   (NULL),
+    sq_tail_   (NULL),
+    sq_mask_   (0),
+    sq_entries_(0),
+    sq_array_  (NULL),
+    cq_head_   (NULL),
+    cq_tail_   (NULL),
+    cq_mask_   (0),
+    cqes_      (NULL),
+    to_submit_ (0),
+    iov_       (),
+    tags_      (),
+    free_      ()
+{
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+
+    fd_ = syscall(__NR_io_uring_setup, entries, &p);
+
+    if (fd_ < 0)
+    {
+        gu_throw_error(errno) << "io_uring_setup() failed";
+    }
+
+    sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+    bool const single(p.features & IORING_FEAT_SINGLE_MMAP);
+    if (single) sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+
+    sq_ptr_ = ring_mmap(fd_, sq_size_, IORING_OFF_SQ_RING);
+
+    if (single)
+    {
+        cq_ptr_ = sq_ptr_;
+    }
+    else
+    {
+        try { cq_ptr_ = ring_mmap(fd_, cq_size_, IORING_OFF_CQ_RING); }
+        catch (...) { munmap(sq_ptr_, sq_size_); throw; }
+    }
+
+    sqes_size_ = p.sq_entries * sizeof(struct io_uring_sqe);
+    try { sqes_ = ring_mmap(fd_, sqes_size_, IORING_OFF_SQES); }
+    catch (...)
+    {
+        if (!single) munmap(cq_ptr_, cq_size_);
+        munmap(sq_ptr_, sq_size_);
+        throw;
+    }
+
+    sq_head_    = ring_ptr<unsigned>(sq_ptr_, p.sq_off.head);
+    sq_tail_    = ring_ptr<unsigned>(sq_ptr_, p.sq_off.tail);
+    sq_mask_    = *ring_ptr<unsigned>(sq_ptr_, p.sq_off.ring_mask);
+    sq_entries_ = p.sq_entries;
+    sq_array_   = ring_ptr<unsigned>(sq_ptr_, p.sq_off.array);
+    cq_head_    = ring_ptr<unsigned>(cq_ptr_, p.cq_off.head);
+    cq_tail_    = ring_ptr<unsigned>(cq_ptr_, p.cq_off.tail);
+    cq_mask_    = *ring_ptr<unsigned>(cq_ptr_, p.cq_off.ring_mask);
+    cqes_       = ring_ptr<void>(cq_ptr_, p.cq_off.cqes);
+
+    /* the CQ ring is at least as large, completions can't overflow */
+    iov_.resize(sq_entries_);
+    tags_.resize(sq_entries_);
+    free_.reserve(sq_entries_);
+    for (unsigned i(sq_entries_); i > 0; --i) free_.push_back(i - 1);
+}
+
+gu::IoUring::~IoUring ()
+{
+    munmap(sqes_, sqes_size_);
+    if (cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_size_);
+    munmap(sq_ptr_, sq_size_);
+    close(fd_);
+}
+
+struct io_uring_sqe*
+gu::IoUring::next_sqe (unsigned& slot)
+{
+    if (free_.empty()) return NULL;
+
+    unsigned const tail(*sq_tail_); // only this thread writes it
+    unsigned const head(GU_URING_LOAD(sq_head_));
+
+    if (tail - head >= sq_entries_) return NULL;
+
+    unsigned const idx(tail & sq_mask_);
+    struct io_uring_sqe* const sqe
+        (static_cast<struct io_uring_sqe*>(sqes_) + idx);
+
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[idx] = idx;
+
+    slot = free_.back();
+    sqe->user_data = slot;
+
+    return sqe;
+}
+
+/* publishes the sqe obtained by next_sqe() */
+void
+gu::IoUring::push_sqe ()
+{
+    free_.pop_back();
+    GU_URING_STORE(sq_tail_, *sq_tail_ + 1);
+    ++to_submit_;
+}
+
+bool
+gu::IoUring::write (int const fd, const void* const buf, size_t const len,
+                    off_t const offset, uint64_t const tag)
+{
+    unsigned slot;
+    struct io_uring_sqe* const sqe(next_sqe(slot));
+
+    if (NULL == sqe) return false;
+
+    /* IORING_OP_WRITEV is supported since the first io_uring kernel,
+     * iovec must stay valid until completion on some of them */
+    iov_[slot].iov_base = const_cast<void*>(buf);
+    iov_[slot].iov_len  = len;
+    tags_[slot]         = tag;
+
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd     = fd;
+    sqe->off    = offset;
+    sqe->addr   = reinterpret_cast<uintptr_t>(&iov_[slot]);
+    sqe->len    = 1;
+
+    push_sqe();
+    return true;
+}
+
+bool
+gu::IoUring::fsync (int const fd, bool const datasync, uint64_t const tag)
+{
+    unsigned slot;
+    struct io_uring_sqe* const sqe(next_sqe(slot));
+
+    if (NULL == sqe) return false;
+
+    tags_[slot] = tag;
+
+    sqe->opcode      = IORING_OP_FSYNC;
+    sqe->fd          = fd;
+    sqe->fsync_flags = datasync ? IORING_FSYNC_DATASYNC : 0;
+
+    push_sqe();
+    return true;
+}
+
+void
+gu::IoUring::submit (unsigned const wait_nr)
+{
+    while (to_submit_ > 0 || wait_nr > 0)
+    {
+        int const ret(syscall(__NR_io_uring_enter, fd_, to_submit_, wait_nr,
+                              wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0,
+                              NULL, 0));
+        if (ret >= 0)
+        {
+            to_submit_ -= ret;
+            break;
+        }
+        else if (EINTR != errno)
+        {
+            gu_throw_error(errno) << "io_uring_enter() failed";
+        }
+    }
+}
+
+bool
+gu::IoUring::reap (uint64_t& tag, int& res)
+{
+    unsigned const head(*cq_head_);
+
+    if (head == GU_URING_LOAD(cq_tail_)) return false;
+
+    const struct io_uring_cqe& cqe
+        (static_cast<const struct io_uring_cqe*>(cqes_)[head & cq_mask_]);
+
+    unsigned const slot(cqe.user_data);
+    tag = tags_[slot];
+    res = cqe.res;
+
+    GU_URING_STORE(cq_head_, head + 1);
+    free_.push_back(slot);
+
+    return true;
+}
+
+#else /* HAVE_LINUX_IO_URING_H */
+
+gu::IoUring::IoUring (unsigned)
+    :
+    fd_(-1), sq_ptr_(NULL), sq_size_(0), cq_ptr_(NULL), cq_size_(0),
+    sqes_(NULL), sqes_size_(0), sq_head_(NULL), sq_tail_(NULL), sq_mask_(0),
+    sq_entries_(0), sq_array_(NULL), cq_head_(NULL), cq_tail_(NULL),
+    cq_mask_(0), cqes_(NULL), to_submit_(0), iov_(), tags_(), free_()
+{
+    gu_throw_error(ENOSYS) << "io_uring is not supported by this build";
+}
+
+gu::IoUring::~IoUring () {}
+
+struct io_uring_sqe* gu::IoUring::next_sqe (unsigned&) { return NULL; }
+
+void gu::IoUring::push_sqe () {}
+
+bool
+gu::IoUring::write (int, const void*, size_t, off_t, uint64_t)
+{
+    return false;
+}
+
+bool gu::IoUring::fsync (int, bool, uint64_t) { return false; }
+
+void gu::IoUring::submit (unsigned) {}
+
+bool gu::IoUring::reap (uint64_t&, int&) { return false; }
+
+#endif /* HAVE_LINUX_IO_URING_H */
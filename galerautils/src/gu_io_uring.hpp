@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+/*!
+ * @file Minimal io_uring submission/completion queue wrapper.
+ *
+ * Lets a thread queue several file operations and have them executed by
+ * the kernel with one system call, instead of one blocking call each.
+ * Uses raw system calls, so no liburing is needed. When the kernel does
+ * not support io_uring (or it is disabled), the constructor throws and
+ * the caller is expected to fall back to plain system calls.
+ */
+
+#ifndef __GU_IO_URING_HPP__
+#define __GU_IO_URING_HPP__
+
+#include "gu_exception.hpp"
+#include "gu_types.hpp"
+
+#include <vector>
+
+#include <stdint.h>
+#include <sys/uio.h>
+
+struct io_uring_sqe;
+
+namespace gu
+{
+
+class IoUring
+{
+public:
+
+    /*! @throws gu::Exception if io_uring can't be set up */
+    explicit IoUring (unsigned entries);
+
+    ~IoUring ();
+
+    /*! queues a write of len bytes at offset, the buffer must stay valid
+     *  until completion. Returns false if the submission queue is full. */
+    bool write (int fd, const void* buf, size_t len, off_t offset,
+                uint64_t tag);
+
+    /*! queues fsync(), fdatasync() if datasync is set */
+    bool fsync (int fd, bool datasync, uint64_t tag);
+
+    /*! submits all queued operations and waits for at least wait_nr
+     *  completions. @throws gu::Exception on io_uring_enter() failure */
+    void submit (unsigned wait_nr = 0);
+
+    /*! takes the next completion if there is one,
+     *  res is the operation result or -errno */
+    bool reap (uint64_t& tag, int& res);
+
+    /*! number of operations queued or submitted and not reaped yet */
+    unsigned pending () const { return iov_.size() - free_.size(); }
+
+private:
+
+    /* returns NULL if no more operations can be queued,
+     * slot is the index in iov_ and tags_ for this operation */
+    struct io_uring_sqe* next_sqe(unsigned& slot);
+    void                 push_sqe();
+
+    int                 fd_;
+    void*               sq_ptr_;
+    size_t              sq_size_;
+    void*               cq_ptr_;
+    size_t              cq_size_;
+    void*               sqes_;
+    size_t              sqes_size_;
+    unsigned*           sq_head_;
+    unsigned*           sq_tail_;
+    unsigned            sq_mask_;
+    unsigned            sq_entries_;
+    unsigned*           sq_array_;
+    unsigned*           cq_head_;
+    unsigned*           cq_tail_;
+    unsigned            cq_mask_;
+    void*               cqes_;
+    unsigned            to_submit_;
+
+    /* per operation in flight, completions come in any order, so these
+     * are not tied to the submission queue slots */
+    std::vector<struct iovec> iov_;
+    std::vector<uint64_t>     tags_;
+    std::vector<unsigned>     free_;
+
+    IoUring (const IoUring&);
+    IoUring& operator= (const IoUring&);
+};
+
+} /* namespace gu */
+
+#endif /* __GU_IO_URING_HPP__ */
@@ -13,8 +13,11 @@
 #include <time.h>
 #include <sys/time.h>
 #include <stdbool.h>
+#include <pthread.h>
+#include <errno.h>
 #include "gu_log.h"
 #include "gu_macros.h"
+#include "gu_atomic.h"
 
 /* Global configurable variables */
 static FILE*      gu_log_file        = NULL;
@@ -128,6 +131,195 @@ gu_conf_set_log_callback (gu_log_cb_t callback)
     return 0;
 }
 
+/*
+ * Asynchronous logging: messages are copied into a bounded lock-free
+ * multi-producer ring (D. Vyukov's design) and passed to gu_log_cb by a
+ * background thread, so that protocol threads never wait on log I/O.
+ * When the ring is full messages are dropped and counted, the count is
+ * reported by the background thread. FATAL messages are always logged
+ * synchronously since they precede abort().
+ * The ring is never freed or resized once allocated: a thread that has
+ * seen logging enabled may still be pushing into it.
+ */
+struct log_slot
+{
+    size_t seq; // == position when free, position + 1 when filled
+    int    severity;
+    char*  msg;
+};
+
+static struct log_slot* log_ring      = NULL;
+static size_t           log_ring_mask = 0;
+static size_t           log_head      = 0; // next position to fill
+static size_t           log_tail      = 0; // next position to drain
+static long             log_dropped   = 0;
+static bool             log_async     = false;
+static pthread_t        log_thd;
+static pthread_mutex_t  log_conf_mtx  = PTHREAD_MUTEX_INITIALIZER;
+
+static bool
+log_ring_push (int const severity, char* const msg)
+{
+    size_t pos;
+    gu_atomic_get (&log_head, &pos);
+
+    for (;;) {
+        struct log_slot* const slot = &log_ring[pos & log_ring_mask];
+        size_t seq;
+        gu_atomic_get (&slot->seq, &seq);
+
+        long const diff = (long)(seq - pos);
+
+        if (0 == diff) {
+            /* on failure pos is reloaded with the current head */
+            if (gu_atomic_cas (&log_head, &pos, pos + 1)) {
+                size_t const filled = pos + 1;
+                slot->severity = severity;
+                slot->msg      = msg;
+                gu_atomic_set (&slot->seq, &filled);
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            return false; // full
+        }
+        else {
+            gu_atomic_get (&log_head, &pos);
+        }
+    }
+}
+
+/* single consumer */
+static bool
+log_ring_pop (int* const severity, char** const msg)
+{
+    struct log_slot* const slot = &log_ring[log_tail & log_ring_mask];
+    size_t seq;
+    gu_atomic_get (&slot->seq, &seq);
+
+    if (seq != log_tail + 1) return false; // empty
+
+    *severity = slot->severity;
+    *msg      = slot->msg;
+
+    size_t const free_seq = log_tail + log_ring_mask + 1;
+    gu_atomic_set (&slot->seq, &free_seq);
+    log_tail++;
+
+    return true;
+}
+
+/* @return number of messages passed to gu_log_cb */
+static long
+log_drain (void)
+{
+    long  ret = 0;
+    int   severity;
+    char* msg;
+
+    while (log_ring_pop (&severity, &msg)) {
+        gu_log_cb (severity, msg);
+        free (msg);
+        ret++;
+    }
+
+    long dropped;
+    gu_atomic_get (&log_dropped, &dropped);
+
+    if (gu_unlikely(dropped > 0)) {
+        char buf[64];
+        gu_atomic_fetch_and_sub (&log_dropped, dropped);
+        snprintf (buf, sizeof(buf), "%s%ld log messages dropped",
+                  gu_log_cb_default == gu_log_cb ?
+                  gu_log_level_str[GU_LOG_WARN] : "", dropped);
+        gu_log_cb (GU_LOG_WARN, buf);
+        ret++;
+    }
+
+    return ret;
+}
+
+static void*
+log_thd_func (void* arg __attribute__((unused)))
+{
+    static struct timespec const idle = { 0, 10000000 }; // 10 ms
+    bool run;
+
+    do {
+        gu_atomic_get (&log_async, &run);
+        if (0 == log_drain() && run) nanosleep (&idle, NULL);
+    }
+    while (run);
+
+    return NULL;
+}
+
+int
+gu_conf_log_async (long const size)
+{
+    int  ret = 0;
+    bool const on = true, off = false;
+
+    pthread_mutex_lock (&log_conf_mtx);
+
+    if (size > 0 && !log_async) {
+        if (NULL == log_ring) {
+            size_t len = 1;
+            while (len < (size_t)size) len <<= 1;
+
+            log_ring = (struct log_slot*)calloc (len, sizeof(*log_ring));
+
+            if (log_ring) {
+                size_t i;
+                for (i = 0; i < len; i++) log_ring[i].seq = i;
+                log_ring_mask = len - 1;
+            }
+            else {
+                ret = -ENOMEM;
+            }
+        }
+
+        if (0 == ret) {
+            gu_atomic_set (&log_async, &on);
+            ret = -pthread_create (&log_thd, NULL, log_thd_func, NULL);
+            if (ret) gu_atomic_set (&log_async, &off);
+        }
+
+        if (0 == ret && log_ring_mask + 1 < (size_t)size) {
+            gu_info ("Asynchronous log is already allocated for %zu messages",
+                     log_ring_mask + 1);
+        }
+    }
+    else if (size <= 0 && log_async) {
+        gu_atomic_set (&log_async, &off);
+        pthread_join (log_thd, NULL);
+        log_drain(); // whatever was pushed after the thread has exited
+    }
+
+    pthread_mutex_unlock (&log_conf_mtx);
+
+    return ret;
+}
+
+void
+gu_log_emit (int const severity, const char* const msg)
+{
+    bool async;
+    gu_atomic_get (&log_async, &async);
+
+    if (gu_likely(!async) || GU_LOG_FATAL == severity) {
+        gu_log_cb (severity, msg);
+        return;
+    }
+
+    char* const copy = strdup (msg);
+
+    if (gu_unlikely(NULL == copy || !log_ring_push (severity, copy))) {
+        free (copy);
+        gu_atomic_fetch_and_add (&log_dropped, 1);
+    }
+}
+
 int
 gu_log (gu_log_severity_t severity,
         const char*       file,
@@ -175,7 +367,7 @@ gu_log (gu_log_severity_t severity,
     }
 
     /* actual logging */
-    gu_log_cb (severity, string);
+    gu_log_emit (severity, string);
 
     return 0;
 }
@@ -48,6 +48,11 @@ gu_log_severity_t;
  */
 typedef void (*gu_log_cb_t) (int severity, const char* msg);
 
+/** Passes formatted message to the log callback, directly or through
+ *  the asynchronous log if it is enabled, see gu_conf_log_async() */
+extern void
+gu_log_emit (int severity, const char* msg);
+
 /** Helper for macros defined below. Should not be called directly. */
 extern int
 gu_log (gu_log_severity_t severity,
@@ -54,10 +54,12 @@ namespace gu
         static bool        do_timestamp;
         static LogCallback logger;
         static void        default_logger  (int, const char*);
+#define emit_log           logger
 #else
 #define max_level          gu_log_max_level
 #define logger             gu_log_cb
 #define default_logger     gu_log_cb_default
+#define emit_log           gu_log_emit
 #endif
 
     protected:
@@ -71,7 +73,7 @@ namespace gu
             os     ()
         {}
 
-        virtual ~Logger() { logger (level, os.str().c_str()); }
+        virtual ~Logger() { emit_log (level, os.str().c_str()); }
 
         std::ostringstream& get(const char* file,
                                 const char* func,
@@ -7,6 +7,10 @@
  * in use. As more than half goes out of use they will be deallocated rather
  * than placed back in the pool.
  *
+ * Thread-safe version keeps a small per-thread cache (magazine) of buffers
+ * in front of the shared pool, so that most acquire()/recycle() calls don't
+ * touch the mutex. Buffers move between a magazine and the pool in batches.
+ *
  * $Id$
  */
 
@@ -14,9 +18,16 @@
 #define _GU_MEM_POOL_HPP_
 
 #include "gu_lock.hpp"
+#include "gu_macros.h"   // gu_unlikely()
 #include "gu_macros.hpp"
+#include "gu_mem_stats.hpp"
 
 #include <assert.h>
+#include <pthread.h>
+#include <stdlib.h> // posix_memalign()
+
+#include <cstddef>  // ptrdiff_t
+#include <new>      // std::bad_alloc
 
 #include <vector>
 #include <ostream>
@@ -137,17 +148,28 @@ namespace gu
             return ret;
         }
 
+        /* buffers are cache line aligned so that objects can place their
+         * hot fields within a single line */
         void* alloc()
         {
-            return (operator new(buf_size_));
+            void* ret;
+
+            if (gu_unlikely(posix_memalign(&ret, ALIGNMENT, buf_size_)))
+                throw std::bad_alloc();
+
+            MemStats::add(MemStats::MEM_POOL, buf_size_);
+            return ret;
         }
 
         void free(void* const buf)
         {
             assert(buf);
-            operator delete(buf);
+            ::free(buf);
+            MemStats::sub(MemStats::MEM_POOL, buf_size_);
         }
 
+        static size_t const ALIGNMENT = 64;
+
         friend class MemPool<true>;
 
     private:
@@ -169,24 +191,78 @@ namespace gu
     /* Thread-safe MemPool specialization.
      * Even though MemPool<true> technically IS-A MemPool<false>, the need to
      * overload nearly all public methods and practical uselessness of
-     * polymorphism in this case make inheritance undesirable. */
+     * polymorphism in this case make inheritance undesirable.
+     *
+     * Each thread gets a magazine of up to cache buffers. acquire() takes
+     * a buffer from it and refills it from the pool with cache/2 buffers
+     * when empty, recycle() returns the surplus to the pool when the
+     * magazine overflows. Magazine hits are added to pool stats in these
+     * batches and buffers sitting in magazines are reported as in use.
+     * cache == 0 disables magazines. */
     template <>
     class MemPool<true>
     {
     public:
 
         explicit
-        MemPool(int buf_size, int reserve = 0, const char* name = "")
-            : base_(buf_size, reserve, name), mtx_ () {}
+        MemPool(int buf_size, int reserve = 0, const char* name = "",
+                int cache = 8)
+            : base_(buf_size, reserve, name), mtx_ (), mags_(), key_(),
+              cache_(cache > 0 ? cache : 0)
+        {
+            if (cache_ > 0 && pthread_key_create(&key_, magazine_exit) != 0)
+            {
+                cache_ = 0;
+            }
+        }
 
-        ~MemPool() {}
+        ~MemPool()
+        {
+            if (0 == cache_) return;
+
+            pthread_key_delete(key_);
+
+            /* all buffers must be returned to pool before destruction,
+             * collect those still cached by other threads */
+            for (size_t i(0); i < mags_.size(); ++i)
+            {
+                Magazine* const m(mags_[i]);
+                flush(*m, 0);
+                free_from(*m, 0);
+                delete m;
+            }
+        }
 
         void* acquire()
         {
+            Magazine* const m(magazine());
+
+            if (m && !m->bufs.empty())
+            {
+                void* const ret(m->bufs.back());
+                m->bufs.pop_back();
+                ++m->hits;
+                return ret;
+            }
+
             void* ret;
 
             {
                 Lock lock(mtx_);
+
+                if (m)
+                {
+                    base_.hits_ += m->hits;
+                    m->hits = 0;
+
+                    /* these are counted as hits when taken from magazine */
+                    while (m->bufs.size() < cache_/2 && base_.pool_.size() > 0)
+                    {
+                        m->bufs.push_back(base_.pool_.back());
+                        base_.pool_.pop_back();
+                    }
+                }
+
                 ret = base_.from_pool();
             }
 
@@ -197,6 +273,26 @@ namespace gu
 
         void recycle(void* buf)
         {
+            Magazine* const m(magazine());
+
+            if (m)
+            {
+                if (m->bufs.size() >= cache_)
+                {
+                    size_t const keep(cache_/2);
+
+                    {
+                        Lock lock(mtx_);
+                        flush(*m, keep);
+                    }
+
+                    free_from(*m, keep);
+                }
+
+                m->bufs.push_back(buf);
+                return;
+            }
+
             bool pooled;
 
             {
@@ -211,14 +307,104 @@ namespace gu
         {
             Lock lock(mtx_);
             base_.print(os);
+            if (cache_ > 0) os << ", thread caches: " << mags_.size();
         }
 
         size_t buf_size() const { return base_.buf_size(); }
 
     private:
 
-        MemPool<false> base_;
-        Mutex          mtx_;
+        struct Magazine
+        {
+            explicit
+            Magazine(MemPool* p) : pool(p), bufs(), hits(0)
+            {
+                bufs.reserve(p->cache_);
+            }
+
+            MemPool* const pool;
+            MemPoolVector  bufs;
+            size_t         hits; // since last batch
+
+        private:
+
+            Magazine(const Magazine&);
+            Magazine& operator=(const Magazine&);
+        };
+
+        MemPool<false>         base_;
+        Mutex                  mtx_;
+        std::vector<Magazine*> mags_; // to collect buffers in destructor
+        pthread_key_t          key_;
+        size_t                 cache_;
+
+        Magazine* magazine()
+        {
+            if (0 == cache_) return NULL;
+
+            Magazine* m(static_cast<Magazine*>(pthread_getspecific(key_)));
+
+            if (gu_unlikely(NULL == m))
+            {
+                m = new Magazine(this);
+                {
+                    Lock lock(mtx_);
+                    mags_.push_back(m);
+                }
+                pthread_setspecific(key_, m);
+            }
+
+            return m;
+        }
+
+        /* Must be called under mtx_. Returns magazine buffers past keep
+         * to the pool and moves those the pool would not take right past
+         * keep, to be freed by free_from() outside critical section. */
+        void flush(Magazine& m, size_t const keep)
+        {
+            base_.hits_ += m.hits;
+            m.hits = 0;
+
+            size_t end(keep);
+            for (size_t i(keep); i < m.bufs.size(); ++i)
+            {
+                if (!base_.to_pool(m.bufs[i])) m.bufs[end++] = m.bufs[i];
+            }
+            m.bufs.resize(end);
+        }
+
+        void free_from(Magazine& m, size_t const keep)
+        {
+            for (size_t i(keep); i < m.bufs.size(); ++i) base_.free(m.bufs[i]);
+            m.bufs.resize(keep);
+        }
+
+        /* thread exit: return cached buffers to the pool */
+        static void magazine_exit(void* arg)
+        {
+            Magazine* const m(static_cast<Magazine*>(arg));
+            MemPool&        p(*m->pool);
+
+            {
+                Lock lock(p.mtx_);
+                p.flush(*m, 0);
+                for (size_t i(0); i < p.mags_.size(); ++i)
+                {
+                    if (p.mags_[i] == m)
+                    {
+                        p.mags_[i] = p.mags_.back();
+                        p.mags_.pop_back();
+                        break;
+                    }
+                }
+            }
+
+            p.free_from(*m, 0);
+            delete m;
+        }
+
+        MemPool (const MemPool&);
+        MemPool operator= (const MemPool&);
 
     }; /* class MemPool<true>: thread-safe */
 
@@ -232,6 +418,73 @@ namespace gu
     typedef MemPool<false> MemPoolUnsafe;
     typedef MemPool<true>  MemPoolSafe;
 
+    /* STL allocator which takes single objects from a process-wide
+     * MemPoolSafe of the object size and arrays from the heap. Meant for node
+     * based containers whose nodes are allocated and freed by the same
+     * thread: those are then reused from the thread magazine without
+     * locking or malloc(). */
+    template <typename T>
+    class PoolAllocator
+    {
+    public:
+
+        typedef size_t    size_type;
+        typedef ptrdiff_t difference_type;
+        typedef T*        pointer;
+        typedef const T*  const_pointer;
+        typedef T&        reference;
+        typedef const T&  const_reference;
+        typedef T         value_type;
+
+        template <typename U> struct rebind { typedef PoolAllocator<U> other; };
+
+        PoolAllocator() {}
+        PoolAllocator(const PoolAllocator&) {}
+        template <typename U> PoolAllocator(const PoolAllocator<U>&) {}
+        ~PoolAllocator() {}
+
+        pointer       address(reference x)       const { return &x; }
+        const_pointer address(const_reference x) const { return &x; }
+
+        pointer allocate(size_type const n, const void* = 0)
+        {
+            if (gu_likely(1 == n))
+                return static_cast<pointer>(pool().acquire());
+
+            if (gu_unlikely(n > max_size())) throw std::bad_alloc();
+
+            return static_cast<pointer>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(pointer const p, size_type const n)
+        {
+            if (gu_likely(1 == n))
+                pool().recycle(p);
+            else
+                ::operator delete(p);
+        }
+
+        size_type max_size() const { return size_type(-1) / sizeof(T); }
+
+        void construct(pointer const p, const T& val) { new (p) T(val); }
+        void destroy  (pointer const p)               { p->~T(); }
+
+        bool operator==(const PoolAllocator&) const { return true;  }
+        bool operator!=(const PoolAllocator&) const { return false; }
+
+    private:
+
+        /* never destroyed: containers may outlive static destructors */
+        static MemPoolSafe& pool()
+        {
+            static MemPoolSafe* const mp(new MemPoolSafe(sizeof(T), 0,
+                                                         "PoolAllocator"));
+            return *mp;
+        }
+
+        void operator=(const PoolAllocator&);
+    };
+
 } /* namespace gu */
 
 
@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "gu_mem_stats.hpp"
+
+gu::PerCpuCounter gu::MemStats::counters_[gu::MemStats::TAG_MAX];
+
+const char*
+gu::MemStats::name(Tag const t)
+{
+    static const char* const names[TAG_MAX] =
+    {
+        "mem_pool",
+        "alloc_heap",
+        "gcache_ram",
+        "gcache_rb",
+        "gcache_pages",
+        "cert_index",
+        "gcomm_send_q"
+    };
+
+    return (t < TAG_MAX ? names[t] : "unknown");
+}
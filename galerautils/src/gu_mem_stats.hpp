@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+/**
+ * @file Per-subsystem accounting of memory held by the provider.
+ *
+ * Owners of big or numerous allocations report them here as they are made
+ * and released, so that totals can be exported in status without walking
+ * the structures. Only what the subsystem actually allocates is counted,
+ * not allocator overhead.
+ */
+
+#ifndef _gu_mem_stats_hpp_
+#define _gu_mem_stats_hpp_
+
+#include "gu_atomic.hpp"
+
+namespace gu
+{
+    class MemStats
+    {
+    public:
+
+        typedef enum
+        {
+            MEM_POOL,     // gu::MemPool buffers
+            ALLOC_HEAP,   // gu::Allocator heap pages (writeset building)
+            GCACHE_RAM,   // gcache RAM store buffers
+            GCACHE_RB,    // gcache ring buffer mapping
+            GCACHE_PAGES, // gcache page store mappings
+            CERT_INDEX,   // certification index entries
+            GCOMM_SEND_Q, // gcomm socket send queues
+            TAG_MAX
+        } Tag;
+
+        static void add(Tag const t, long long const bytes)
+        {
+            counters_[t] += bytes;
+        }
+
+        static void sub(Tag const t, long long const bytes)
+        {
+            counters_[t] += -bytes;
+        }
+
+        static long long get(Tag const t) { return counters_[t](); }
+
+        static const char* name(Tag t);
+
+    private:
+
+        static PerCpuCounter counters_[TAG_MAX];
+    };
+}
+
+#endif /* _gu_mem_stats_hpp_ */
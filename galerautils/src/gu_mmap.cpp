@@ -13,7 +13,13 @@
 #include "gu_limits.h" // GU_PAGE_SIZE
 
 #include <cerrno>
+#include <vector>
+#include <algorithm>
 #include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h> // SYS_mbind
+#endif
 
 #if defined(__FreeBSD__) && defined(MAP_NORESERVE)
 /* FreeBSD has never implemented this flags and will deprecate it. */
@@ -79,6 +85,160 @@ namespace gu
         }
     }
 
+    void
+    MMap::will_need(const void* const addr, size_t const length) const
+    {
+        static uint64_t const PAGE_SIZE_MASK(~(GU_PAGE_SIZE - 1));
+
+        uint64_t const begin(uint64_t(addr) & PAGE_SIZE_MASK);
+        uint64_t const end  ((uint64_t(addr) + length + GU_PAGE_SIZE - 1) &
+                             PAGE_SIZE_MASK);
+
+        if (madvise(reinterpret_cast<char*>(begin), end - begin,
+                    MADV_WILLNEED))
+        {
+            log_warn << "Failed to set MADV_WILLNEED on " << addr << ": "
+                     << errno << " (" << strerror(errno) << ')';
+        }
+    }
+
+    void
+    MMap::dont_need(const void* const addr, size_t const length) const
+    {
+        static uint64_t const PAGE_SIZE_MASK(~(GU_PAGE_SIZE - 1));
+
+        uint64_t const begin((uint64_t(addr) + GU_PAGE_SIZE - 1) &
+                             PAGE_SIZE_MASK);
+        uint64_t const end  ((uint64_t(addr) + length) & PAGE_SIZE_MASK);
+
+        if (end <= begin) return;
+
+        if (madvise(reinterpret_cast<char*>(begin), end - begin,
+                    MADV_DONTNEED))
+        {
+            log_warn << "Failed to set MADV_DONTNEED on " << addr << ": "
+                     << errno << " (" << strerror(errno) << ')';
+        }
+    }
+
+    void
+    MMap::huge_pages() const
+    {
+#if defined(MADV_HUGEPAGE)
+        if (madvise(reinterpret_cast<char*>(ptr), size, MADV_HUGEPAGE))
+        {
+            log_warn << "Failed to set MADV_HUGEPAGE on " << ptr << ": "
+                     << errno << " (" << strerror(errno) << ')';
+        }
+#else
+        log_warn << "Huge pages are not supported on this platform";
+#endif
+    }
+
+    void
+    MMap::bind_node(int const node) const
+    {
+        if (node < 0) return;
+
+#if defined(__linux__) && defined(SYS_mbind)
+        /* from <numaif.h>, not to depend on libnuma for a single call */
+        static int      const MPOL_BIND_(2);
+        static unsigned const MPOL_MF_MOVE_(1 << 1);
+
+        size_t const bits(sizeof(unsigned long) * 8);
+        std::vector<unsigned long> mask(node / bits + 1, 0);
+        mask[node / bits] = 1UL << (node % bits);
+
+        /* kernel expects maxnode to be one more than the number of bits */
+        if (syscall(SYS_mbind, ptr, size, MPOL_BIND_, &mask[0],
+                    mask.size() * bits + 1, MPOL_MF_MOVE_))
+        {
+            log_warn << "Failed to bind " << ptr << " to NUMA node " << node
+                     << ": " << errno << " (" << strerror(errno) << ')';
+        }
+#else
+        log_warn << "NUMA binding is not supported on this platform";
+#endif
+    }
+
+    bool
+    MMap::lock(const void* const addr, size_t const length) const
+    {
+        static uint64_t const PAGE_SIZE_MASK(~(GU_PAGE_SIZE - 1));
+
+        uint64_t const begin(uint64_t(addr) & PAGE_SIZE_MASK);
+        uint64_t const end  ((uint64_t(addr) + length + GU_PAGE_SIZE - 1) &
+                             PAGE_SIZE_MASK);
+
+        if (mlock(reinterpret_cast<void*>(begin), end - begin))
+        {
+            log_warn << "Failed to lock " << addr << " (" << length
+                     << " bytes) in memory: " << errno << " ("
+                     << strerror(errno) << ')';
+            return false;
+        }
+
+        return true;
+    }
+
+    void
+    MMap::populate(const void* const addr, size_t const length) const
+    {
+#if defined(MADV_POPULATE_READ)
+        static uint64_t const PAGE_SIZE_MASK(~(GU_PAGE_SIZE - 1));
+
+        uint64_t const begin(uint64_t(addr) & PAGE_SIZE_MASK);
+        uint64_t const end  ((uint64_t(addr) + length + GU_PAGE_SIZE - 1) &
+                             PAGE_SIZE_MASK);
+
+        if (0 == madvise(reinterpret_cast<char*>(begin), end - begin,
+                         MADV_POPULATE_READ)) return;
+
+        if (EINVAL != errno) // not supported by the kernel
+        {
+            log_warn << "Failed to set MADV_POPULATE_READ on " << addr << ": "
+                     << errno << " (" << strerror(errno) << ')';
+            return;
+        }
+#endif
+        /* only starts reading pages in, good enough to avoid major faults */
+        will_need(addr, length);
+    }
+
+    size_t
+    MMap::resident() const
+    {
+#if defined(__FreeBSD__)
+        typedef char          vec_t;
+#else
+        typedef unsigned char vec_t;
+#endif
+        static size_t const VEC_LEN(4096); // pages per mincore() call
+
+        std::vector<vec_t> vec(VEC_LEN);
+        size_t ret(0);
+
+        for (size_t offset(0); offset < size; offset += VEC_LEN * GU_PAGE_SIZE)
+        {
+            size_t const len(std::min(size - offset, VEC_LEN * GU_PAGE_SIZE));
+
+            if (mincore(static_cast<char*>(ptr) + offset, len, &vec[0]))
+            {
+                log_warn << "mincore() on " << ptr << " failed: " << errno
+                         << " (" << strerror(errno) << ')';
+                return 0;
+            }
+
+            size_t const pages((len + GU_PAGE_SIZE - 1) / GU_PAGE_SIZE);
+            for (size_t i(0); i < pages; ++i)
+            {
+                if (vec[i] & 1) ret += GU_PAGE_SIZE;
+            }
+        }
+
+        return std::min(ret, size);
+    }
+
     void
     MMap::sync(void* const addr, size_t const length) const
     {
@@ -25,6 +25,33 @@ public:
     ~MMap ();
 
     void dont_need() const;
+
+    /* Hints for a sequential reader of the mapping: the range is about to be
+     * read or has been read and won't be needed soon. The former is extended
+     * and the latter trimmed to page boundaries. Failures are logged. */
+    void will_need(const void* addr, size_t length) const;
+    void dont_need(const void* addr, size_t length) const;
+
+    /* Ask for the mapping to be backed by transparent huge pages. Only has
+     * effect where the kernel supports THP for the mapped file system. */
+    void huge_pages() const;
+
+    /* Bind the mapping memory to NUMA node, moving pages already faulted in.
+     * Failures are logged, not thrown. */
+    void bind_node(int node) const;
+
+    /* Lock the range in memory, faulting it in. Returns false if the range
+     * could not be locked (e.g. RLIMIT_MEMLOCK is too low), error is logged.
+     * The range is extended to page boundaries. */
+    bool lock(const void* addr, size_t length) const;
+
+    /* Fault the range in without locking it, so that the following accesses
+     * don't go to disk. Failures are logged. */
+    void populate(const void* addr, size_t length) const;
+
+    /* Returns the number of bytes of the mapping currently in memory. */
+    size_t resident() const;
+
     void sync(void *addr, size_t length) const;
     void sync() const;
     void unmap();
@@ -0,0 +1,48 @@
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+
+/**
+ * @file Static tracepoints (USDT probes).
+ *
+ * When built with <sys/sdt.h> (HAVE_SYS_SDT_H) GU_PROBEn() macros place
+ * SystemTap/DTrace compatible probes into the "galera" provider. An unused
+ * probe is a single nop instruction, so they are safe on hot paths as long
+ * as arguments are cheap to compute. Without sdt.h they compile to nothing.
+ *
+ * Probes can be listed with e.g. `bpftrace -l 'usdt:libgalera_smm.so:*'`:
+ *
+ * galera ws_send      (trx_id, size)              write set sent to GCS
+ * galera ws_recv      (seqno_g, seqno_l, size)    write set delivered by GCS
+ * galera cert_pass    (seqno_g, depends_seqno)
+ * galera cert_fail    (seqno_g, is_local)
+ * galera apply_begin  (seqno_g, depends_seqno)    apply monitor entered
+ * galera apply_end    (seqno_g)                   apply monitor left
+ * galera fc_stop_sent (local_seqno, queue_len)
+ * galera fc_cont_sent (local_seqno, queue_len)
+ * galera fc_recv      (stop, stop_count)          FC event from the group
+ * galera evs_view     (view_seq, members)         EVS view installed
+ * galera page_create  (name, size)                gcache page created
+ * galera page_delete  (name)                      gcache page deleted
+ */
+
+#ifndef _gu_probe_h_
+#define _gu_probe_h_
+
+#if defined(HAVE_SYS_SDT_H)
+
+#include <sys/sdt.h>
+
+#define GU_PROBE0(name)             DTRACE_PROBE(galera, name)
+#define GU_PROBE1(name, a)          DTRACE_PROBE1(galera, name, a)
+#define GU_PROBE2(name, a, b)       DTRACE_PROBE2(galera, name, a, b)
+#define GU_PROBE3(name, a, b, c)    DTRACE_PROBE3(galera, name, a, b, c)
+
+#else /* !HAVE_SYS_SDT_H */
+
+#define GU_PROBE0(name)
+#define GU_PROBE1(name, a)
+#define GU_PROBE2(name, a, b)
+#define GU_PROBE3(name, a, b, c)
+
+#endif /* !HAVE_SYS_SDT_H */
+
+#endif /* _gu_probe_h_ */
@@ -47,7 +47,13 @@ RecordSetOutBase::post_append (bool const          new_page,
                                const byte_t* const ptr,
                                ssize_t const       size)
 {
-    check_.append (ptr, size);
+    switch (check_type_)
+    {
+    case CHECK_XXH64:  xxh_.append (ptr, size); break;
+    case CHECK_CRC32C: crc_.append (ptr, size); break;
+    default:           check_.append (ptr, size);
+    }
+
     post_alloc (new_page, ptr, size);
 }
 
@@ -61,6 +67,8 @@ check_size (RecordSet::CheckType const ct)
     case RecordSet::CHECK_MMH32:  return 4;
     case RecordSet::CHECK_MMH64:  return 8;
     case RecordSet::CHECK_MMH128: return 16;
+    case RecordSet::CHECK_XXH64:  return 8;
+    case RecordSet::CHECK_CRC32C: return 4;
 #define MAX_CHECKSUM_SIZE                16
     }
 
@@ -179,8 +187,21 @@ RecordSetOutBase::write_header (byte_t* const buf, ssize_t const size)
     if (check_type_ != CHECK_NONE)
     {
         assert (csize <= size - off);
-        check_.append (buf + hdr_offset, off - hdr_offset); /* append header */
-        check_.gather (buf + off, csize);
+        switch (check_type_)
+        {
+        case CHECK_XXH64:
+            xxh_.append (buf + hdr_offset, off - hdr_offset);
+            xxh_.gather (buf + off, csize);
+            break;
+        case CHECK_CRC32C:
+            assert (4 == csize);
+            crc_.append (buf + hdr_offset, off - hdr_offset);
+            crc_.gather4 (buf + off);
+            break;
+        default:
+            check_.append (buf + hdr_offset, off - hdr_offset); /* header */
+            check_.gather (buf + off, csize);
+        }
     }
 
     return hdr_offset;
@@ -242,6 +263,8 @@ RecordSetOutBase::RecordSetOutBase (byte_t*                 reserved,
 #endif
     alloc_      (base_name, reserved, reserved_size),
     check_      (),
+    xxh_        (),
+    crc_        (),
     bufs_       (),
     prev_stored_(true)
 {
@@ -286,6 +309,8 @@ ver1_check_type (const byte_t* buf, ssize_t const size)
     case RecordSet::CHECK_MMH32:  return RecordSet::CHECK_MMH32;
     case RecordSet::CHECK_MMH64:  return RecordSet::CHECK_MMH64;
     case RecordSet::CHECK_MMH128: return RecordSet::CHECK_MMH128;
+    case RecordSet::CHECK_XXH64:  return RecordSet::CHECK_XXH64;
+    case RecordSet::CHECK_CRC32C: return RecordSet::CHECK_CRC32C;
     }
 
     gu_throw_error (EPROTO) << "Unsupported RecordSet checksum type: " << ct;
@@ -376,14 +401,33 @@ RecordSetInBase::checksum() const
 
     if (cs > 0) /* checksum records */
     {
-        Hash check;
-
-        check.append (head_ + begin_, size_ - begin_); /* records */
-        check.append (head_, begin_ - cs);             /* header  */
-
         assert(cs <= MAX_CHECKSUM_SIZE);
         byte_t result[MAX_CHECKSUM_SIZE];
-        check.gather<sizeof(result)>(result);
+
+        if (CHECK_XXH64 == check_type_)
+        {
+            XXH64 check;
+
+            check.append (head_ + begin_, size_ - begin_); /* records */
+            check.append (head_, begin_ - cs);             /* header  */
+            check.gather<sizeof(result)>(result);
+        }
+        else if (CHECK_CRC32C == check_type_)
+        {
+            CRC32C check;
+
+            check.append (head_ + begin_, size_ - begin_); /* records */
+            check.append (head_, begin_ - cs);             /* header  */
+            check.gather4 (result);
+        }
+        else
+        {
+            Hash check;
+
+            check.append (head_ + begin_, size_ - begin_); /* records */
+            check.append (head_, begin_ - cs);             /* header  */
+            check.gather<sizeof(result)>(result);
+        }
 
         const byte_t* const stored_checksum(head_ + begin_ - cs);
 
@@ -423,7 +467,8 @@ RecordSetInBase::RecordSetInBase (const byte_t* const ptr,
     RecordSet   (),
     head_       (),
     next_       (),
-    begin_      ()
+    begin_      (),
+    index_      ()
 {
     init (ptr, size, check_now);
 }
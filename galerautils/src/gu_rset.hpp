@@ -16,12 +16,14 @@
 #include "gu_vector.hpp"
 #include "gu_alloc.hpp"
 #include "gu_digest.hpp"
+#include "gu_crc.hpp"
 
 #ifdef GU_RSET_CHECK_SIZE
 #  include "gu_throw.hpp"
 #endif
 
 #include <string>
+#include <vector>
 
 namespace gu {
 
@@ -42,7 +44,10 @@ public:
         CHECK_NONE   = 0,
         CHECK_MMH32,
         CHECK_MMH64,
-        CHECK_MMH128
+        CHECK_MMH128,
+        CHECK_XXH64, /* faster, but not understood by older peers */
+        CHECK_CRC32C /* fastest with CPU support, not understood by older
+                      * peers */
     };
 
     /*! return total size of a RecordSet */
@@ -191,6 +196,8 @@ private:
 
     Allocator     alloc_;
     Hash          check_;
+    XXH64         xxh_;    /* used instead of check_ for CHECK_XXH64 */
+    CRC32C        crc_;    /* used instead of check_ for CHECK_CRC32C */
     Vector<Buf, Allocator::INITIAL_VECTOR_SIZE> bufs_;
     bool          prev_stored_;
 
@@ -313,8 +320,52 @@ public:
         gu::Buf ret = { head_, size_ }; return ret;
     }
 
+    /*! whether record offset index has been built (see index()) */
+    bool indexed() const { return (index_.size() > 0 || 0 == count_); }
+
 protected:
 
+    /* walks all records once to store their offsets in index_,
+     * does not change the current iteration position */
+    template <class R>
+    void build_index () const
+    {
+        if (indexed()) return;
+
+        ssize_t const saved(next_);
+        std::vector<ssize_t> index;
+        index.reserve(count_ + 1);
+
+        next_ = begin_;
+        for (int i(0); i < count_; ++i)
+        {
+            index.push_back(next_);
+            (void)next_base<R>();
+        }
+        index.push_back(next_);
+
+        next_ = saved;
+        index_.swap(index);
+    }
+
+    /* positions iteration at record i, index must be built */
+    void seek_base (int const i) const
+    {
+        assert (indexed());
+        if (gu_unlikely(i < 0 || i >= count_)) throw_error (E_PERM);
+        next_ = index_[i];
+    }
+
+    /* returns buffer of record i without changing iteration position,
+     * index must be built */
+    void record_base (int const i, Buf& n) const
+    {
+        assert (indexed());
+        if (gu_unlikely(i < 0 || i >= count_)) throw_error (E_PERM);
+        n.ptr  = head_ + index_[i];
+        n.size = index_[i + 1] - index_[i];
+    }
+
     template <class R>
     void next_base (Buf& n) const
     {
@@ -369,6 +420,9 @@ private:
     short           begin_;       /* offset to first record   */
     /* size_ from parent class is offset past all records */
 
+    /* record offsets followed by size_, empty until built */
+    std::vector<ssize_t> mutable index_;
+
     /* takes total size of the supplied buffer */
     void parse_header_v1 (size_t size);
 
@@ -386,7 +440,8 @@ private:
     RecordSet   (r),
     head_       (r.head_),
     next_       (r.next_),
-    begin_      (r.begin_)
+    begin_      (r.begin_),
+    index_      (r.index_)
     {}
 
     RecordSetInBase& operator= (const RecordSetInBase r);
@@ -420,6 +475,19 @@ public:
     void next (Buf& n) const { next_base<R> (n); }
 
     R next () const { return next_base<R> (); }
+
+    /*!
+     * Builds record offset index for random access. Called implicitly by
+     * seek() and record(), but must be called explicitly before sharing
+     * the set between threads, which may then call record() concurrently.
+     */
+    void index () const { build_index<R> (); }
+
+    /*! positions the set so that the following next() returns record i */
+    void seek (int const i) const { index(); seek_base (i); }
+
+    /*! returns buffer of record i, does not affect next() */
+    void record (int const i, Buf& n) const { index(); record_base (i, n); }
 }; /* class RecordSetIn */
 
 #if defined(__GNUG__)
@@ -10,12 +10,10 @@
 #define GU_SERIALIZABLE_HPP
 
 #include "gu_types.hpp"
+#include "gu_buffer.hpp"
 #include "gu_throw.hpp"
 #include "gu_assert.hpp"
 
-#include <vector>
-#include <stdexcept> // for std::length_error
-
 namespace gu
 {
 
@@ -44,21 +42,17 @@ public:
     }
 
     /*!
-     * serializes this object into byte vector v, reallocating it if needed
+     * serializes this object into buffer v, reallocating it if needed
      * returns the size of serialized object
      */
-    ssize_t serialize_to (std::vector<byte_t>& v) const
+    ssize_t serialize_to (Buffer& v) const
     {
         size_t const old_size (v.size());
         size_t const new_size (serial_size() + old_size);
 
         try
         {
-            v.resize (new_size, 0);
-        }
-        catch (std::length_error& l)
-        {
-            gu_throw_error(EMSGSIZE) << "length_error: " << l.what();
+            v.resize (new_size);
         }
         catch (...)
         {
@@ -88,8 +82,8 @@ private:
     virtual ssize_t my_serialize_to (void* buf, ssize_t size) const = 0;
 };
 
-static inline std::vector<byte_t>&
-operator << (std::vector<byte_t>& out, const Serializable& s)
+static inline Buffer&
+operator << (Buffer& out, const Serializable& s)
 {
     s.serialize_to (out);
     return out;
@@ -115,7 +109,7 @@ public:
         return my_deserialize_from (buf, size);
     }
 
-    ssize_t deserialize_from (const std::vector<byte_t>& in,size_t const offset)
+    ssize_t deserialize_from (const Buffer& in, size_t const offset)
     {
         return deserialize_from (&in[offset], in.size() - offset);
     }
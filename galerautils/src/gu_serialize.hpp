@@ -57,42 +57,133 @@ namespace gu
     inline size_t serial_size(const uint64_t& b)
     { return sizeof(b); }
 
+    /*!
+     * Checks that there are len bytes available at offset.
+     *
+     * Fixed size headers can be checked once with this and then
+     * (un)serialized field by field with the *_unchecked() variants
+     * below, which leaves just the loads/stores and byte swaps.
+     */
+    GU_FORCE_INLINE void serial_check(size_t const buflen,
+                                      size_t const offset,
+                                      size_t const len)
+    {
+        if (gu_unlikely(offset + len > buflen))
+        {
+            gu_throw_error(EMSGSIZE) << offset + len << " > " << buflen;
+        }
+    }
+
     /* Should not be used directly! */
     template <typename TO, typename FROM>
-    inline size_t
-    __private_serialize(const FROM& f, void* const buf, size_t const buflen,
-                        size_t const offset)
+    GU_FORCE_INLINE size_t
+    __private_serialize_unchecked(const FROM& f, void* const buf,
+                                  size_t const offset)
     {
         GU_COMPILE_ASSERT(std::numeric_limits<TO>::is_integer, not_integer1);
         GU_COMPILE_ASSERT(std::numeric_limits<FROM>::is_integer, not_integer2);
         GU_COMPILE_ASSERT(sizeof(FROM) == sizeof(TO), size_differs);
-        size_t const ret = offset + sizeof(TO);
-        if (gu_unlikely(ret > buflen))
-        {
-            gu_throw_error(EMSGSIZE) << ret << " > " << buflen;
-        }
         void* const pos(reinterpret_cast<byte_t*>(buf) + offset);
         *reinterpret_cast<TO*>(pos) = htog<TO>(f);
-        return ret;
+        return offset + sizeof(TO);
     }
 
     /* Should not be used directly! */
     template <typename FROM, typename TO>
-    inline size_t
-    __private_unserialize(const void* const buf, size_t const buflen,
-                          size_t const offset, TO& t)
+    GU_FORCE_INLINE size_t
+    __private_unserialize_unchecked(const void* const buf, size_t const offset,
+                                    TO& t)
     {
         GU_COMPILE_ASSERT(std::numeric_limits<TO>::is_integer, not_integer1);
         GU_COMPILE_ASSERT(std::numeric_limits<FROM>::is_integer, not_integer2);
         GU_COMPILE_ASSERT(sizeof(FROM) == sizeof(TO), size_differs);
-        size_t const ret = offset + sizeof(t);
-        if (gu_unlikely(ret > buflen))
-        {
-            gu_throw_error(EMSGSIZE) << ret << " > " << buflen;
-        }
         const void* const pos(reinterpret_cast<const byte_t*>(buf) + offset);
         t = gtoh<FROM>(*reinterpret_cast<const FROM*>(pos));
-        return ret;
+        return offset + sizeof(t);
+    }
+
+    /* Should not be used directly! */
+    template <typename TO, typename FROM>
+    inline size_t
+    __private_serialize(const FROM& f, void* const buf, size_t const buflen,
+                        size_t const offset)
+    {
+        serial_check(buflen, offset, sizeof(TO));
+        return __private_serialize_unchecked<TO>(f, buf, offset);
+    }
+
+    /* Should not be used directly! */
+    template <typename FROM, typename TO>
+    inline size_t
+    __private_unserialize(const void* const buf, size_t const buflen,
+                          size_t const offset, TO& t)
+    {
+        serial_check(buflen, offset, sizeof(t));
+        return __private_unserialize_unchecked<FROM>(buf, offset, t);
+    }
+
+    template <typename T>
+    GU_FORCE_INLINE size_t serialize1_unchecked(const T&     t,
+                                                void*  const buf,
+                                                size_t const offset)
+    {
+        return __private_serialize_unchecked<uint8_t>(t, buf, offset);
+    }
+
+    template <typename T>
+    GU_FORCE_INLINE size_t unserialize1_unchecked(const void* const buf,
+                                                  size_t      const offset,
+                                                  T&                t)
+    {
+        return __private_unserialize_unchecked<uint8_t>(buf, offset, t);
+    }
+
+    template <typename T>
+    GU_FORCE_INLINE size_t serialize2_unchecked(const T&     t,
+                                                void*  const buf,
+                                                size_t const offset)
+    {
+        return __private_serialize_unchecked<uint16_t>(t, buf, offset);
+    }
+
+    template <typename T>
+    GU_FORCE_INLINE size_t unserialize2_unchecked(const void* const buf,
+                                                  size_t      const offset,
+                                                  T&                t)
+    {
+        return __private_unserialize_unchecked<uint16_t>(buf, offset, t);
+    }
+
+    template <typename T>
+    GU_FORCE_INLINE size_t serialize4_unchecked(const T&     t,
+                                                void*  const buf,
+                                                size_t const offset)
+    {
+        return __private_serialize_unchecked<uint32_t>(t, buf, offset);
+    }
+
+    template <typename T>
+    GU_FORCE_INLINE size_t unserialize4_unchecked(const void* const buf,
+                                                  size_t      const offset,
+                                                  T&                t)
+    {
+        return __private_unserialize_unchecked<uint32_t>(buf, offset, t);
+    }
+
+    template <typename T>
+    GU_FORCE_INLINE size_t serialize8_unchecked(const T&     t,
+                                                void*  const buf,
+                                                size_t const offset)
+    {
+        return __private_serialize_unchecked<uint64_t>(t, buf, offset);
+    }
+
+    template <typename T>
+    GU_FORCE_INLINE size_t unserialize8_unchecked(const void* const buf,
+                                                  size_t      const offset,
+                                                  T&                t)
+    {
+        return __private_unserialize_unchecked<uint64_t>(buf, offset, t);
     }
 
     template <typename T>
@@ -212,7 +303,7 @@ namespace gu
 
         offset = __private_serialize<ST>(static_cast<ST>(b.size()),
                                          buf, buflen, offset);
-        copy(b.begin(), b.end(), reinterpret_cast<byte_t*>(buf) + offset);
+        std::copy(b.begin(), b.end(), reinterpret_cast<byte_t*>(buf) + offset);
         return ret;
     }
 
@@ -235,7 +326,7 @@ namespace gu
 
         b.resize(len);
         const byte_t* const ptr(reinterpret_cast<const byte_t*>(buf));
-        copy(ptr + offset, ptr + ret, b.begin());
+        std::copy(ptr + offset, ptr + ret, b.begin());
 
         return ret;
     }
@@ -8,7 +8,9 @@
 #include "gu_string_utils.hpp"
 #include "gu_throw.hpp"
 
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <vector>
 
 static std::string const SCHED_OTHER_STR  ("other");
@@ -91,3 +93,47 @@ void gu::thread_set_schedparam(pthread_t thd, const gu::ThreadSchedparam& sp)
         gu_throw_error(err) << "Failed to set thread schedparams " << sp;
     }
 }
+
+void gu::thread_set_numa_node(pthread_t const thd, int const node)
+{
+    if (node < 0) return;
+
+#if defined(__linux__)
+    std::ostringstream path;
+    path << "/sys/devices/system/node/node" << node << "/cpulist";
+
+    std::ifstream in(path.str().c_str());
+    std::string   list;
+
+    if (!(in >> list))
+    {
+        gu_throw_error(EINVAL) << "Failed to read CPU list of NUMA node "
+                               << node << " from " << path.str();
+    }
+
+    /* cpulist has a form of "0-7,16-23" */
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    std::vector<std::string> const ranges(gu::strsplit(list, ','));
+    for (size_t i(0); i < ranges.size(); ++i)
+    {
+        std::vector<std::string> const r(gu::strsplit(ranges[i], '-'));
+        int const first(gu::from_string<int>(r[0]));
+        int const last (r.size() > 1 ? gu::from_string<int>(r[1]) : first);
+
+        for (int cpu(first); cpu <= last && cpu < CPU_SETSIZE; ++cpu)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    int const err(pthread_setaffinity_np(thd, sizeof(set), &set));
+    if (err != 0)
+    {
+        gu_throw_error(err) << "Failed to bind thread to NUMA node " << node;
+    }
+#else
+    gu_throw_error(ENOSYS) << "NUMA binding is not supported on this platform";
+#endif
+}
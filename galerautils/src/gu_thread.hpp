@@ -95,6 +95,15 @@ namespace gu
     //
     void thread_set_schedparam(gu_thread_t thread, const ThreadSchedparam&);
 
+    //
+    // Restrict given thread to the CPUs of NUMA node. Does nothing for
+    // negative node. Memory which the thread touches first is then
+    // allocated on that node too.
+    //
+    // Throws gu::Exception if binding fails or is not supported.
+    //
+    void thread_set_numa_node(gu_thread_t thread, int node);
+
     //
     // Insertion operator for ThreadSchedparam
     //
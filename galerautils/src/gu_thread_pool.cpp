@@ -0,0 +1,122 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "gu_thread_pool.hpp"
+#include "gu_logger.hpp"
+
+#include <unistd.h> // sysconf()
+#include <cstring>  // strerror()
+
+void
+gu::ThreadPool::Job::wait()
+{
+    Lock lock(mtx_);
+    while (!done_) lock.wait(cond_);
+}
+
+void
+gu::ThreadPool::Job::complete()
+{
+    Lock lock(mtx_);
+    done_ = true;
+    cond_.signal();
+}
+
+gu::ThreadPool::ThreadPool(int const threads)
+    :
+    mtx_    (),
+    cond_   (),
+    queue_  (),
+    threads_(),
+    stop_   (false)
+{
+    for (int i(0); i < threads; ++i)
+    {
+        gu_thread_t t;
+        int const err(gu_thread_create(&t, NULL, worker, this));
+
+        if (err)
+        {
+            log_warn << "Failed to start pool thread: " << err << " ("
+                     << strerror(err) << "), continuing with "
+                     << threads_.size() << " threads";
+            break;
+        }
+
+        threads_.push_back(t);
+    }
+}
+
+gu::ThreadPool::~ThreadPool()
+{
+    {
+        Lock lock(mtx_);
+        stop_ = true;
+        cond_.broadcast();
+    }
+
+    for (size_t i(0); i < threads_.size(); ++i)
+    {
+        gu_thread_join(threads_[i], NULL);
+    }
+
+    assert(queue_.empty());
+}
+
+bool
+gu::ThreadPool::submit(Job& job)
+{
+    if (threads_.empty()) return false;
+
+    {
+        Lock lock(job.mtx_);
+        assert(job.done_);
+        job.done_ = false;
+    }
+
+    Lock lock(mtx_);
+    queue_.push_back(&job);
+    cond_.signal();
+
+    return true;
+}
+
+void*
+gu::ThreadPool::worker(void* const arg)
+{
+    static_cast<ThreadPool*>(arg)->worker_loop();
+    return NULL;
+}
+
+void
+gu::ThreadPool::worker_loop()
+{
+    for (;;)
+    {
+        Job* job;
+
+        {
+            Lock lock(mtx_);
+
+            while (queue_.empty() && !stop_) lock.wait(cond_);
+
+            /* complete what was queued before stopping */
+            if (queue_.empty()) return;
+
+            job = queue_.front();
+            queue_.pop_front();
+        }
+
+        job->run();
+        job->complete();
+    }
+}
+
+gu::ThreadPool&
+gu::ThreadPool::checksum_pool()
+{
+    static long const ncpus(sysconf(_SC_NPROCESSORS_ONLN));
+    static ThreadPool pool(ncpus > 4 ? 4 : (ncpus > 1 ? ncpus : 1));
+    return pool;
+}
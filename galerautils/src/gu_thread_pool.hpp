@@ -0,0 +1,87 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+/**
+ * @file Pool of persistent worker threads for short CPU bound jobs.
+ *
+ * Jobs are queued in FIFO order and executed by the first idle worker.
+ * Submitter owns the Job object and must wait() for it before destroying.
+ */
+
+#ifndef GU_THREAD_POOL_HPP
+#define GU_THREAD_POOL_HPP
+
+#include "gu_threads.h"
+#include "gu_lock.hpp" // Mutex, Cond
+
+#include <deque>
+#include <vector>
+
+namespace gu
+{
+    class ThreadPool
+    {
+    public:
+
+        class Job
+        {
+        public:
+
+            Job() : mtx_(), cond_(), done_(true) {}
+            virtual ~Job() {}
+
+            /* blocks until the job is done, returns immediately if it was
+             * never submitted */
+            void wait();
+
+        protected:
+
+            /* must not throw */
+            virtual void run() = 0;
+
+        private:
+
+            friend class ThreadPool;
+
+            void complete();
+
+            Mutex mtx_;
+            Cond  cond_;
+            bool  done_;
+
+            Job(const Job&);
+            Job& operator=(const Job&);
+        };
+
+        /* threads == 0 makes submit() always fail */
+        explicit ThreadPool(int threads);
+        ~ThreadPool();
+
+        /* queues job for execution, returns false if there are no workers,
+         * then the caller should do the work itself */
+        bool submit(Job& job);
+
+        int threads() const { return threads_.size(); }
+
+        /* process-wide pool for checksumming large buffers, its size is
+         * the number of CPUs up to 4 */
+        static ThreadPool& checksum_pool();
+
+    private:
+
+        static void* worker(void* arg);
+        void         worker_loop();
+
+        Mutex                    mtx_;
+        Cond                     cond_;
+        std::deque<Job*>         queue_;
+        std::vector<gu_thread_t> threads_;
+        bool                     stop_;
+
+        ThreadPool(const ThreadPool&);
+        ThreadPool& operator=(const ThreadPool&);
+    };
+}
+
+#endif // GU_THREAD_POOL_HPP
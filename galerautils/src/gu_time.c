@@ -183,12 +183,107 @@ clock_gettime (clockid_t clk_id, struct timespec * tp)
 
 #endif /* !__LP64__ */
 
-#else /* !__APPLE__ */
+#endif /* __APPLE__ */
+
+#include "gu_time.h"
 
-#ifdef __GNUC__
-// error: ISO C forbids an empty translation unit
-int dummy_var_gu_time;
-#endif
+#ifdef GU_TIME_TSC
+#include <cpuid.h>
+#include <stdio.h>
+#include <string.h>
+#endif /* GU_TIME_TSC */
 
-#endif /* __APPLE__ */
+struct gu_time_tsc gu_time_tsc_clock = { 0, 0, 0, 0.0 };
+
+#ifdef GU_TIME_TSC
+
+#define TSC_CALIBRATION_PERIOD 100000000LL // 100ms
+
+enum
+{
+    TSC_UNAVAILABLE = -1,
+    TSC_INIT,
+    TSC_BUSY,
+    TSC_CALIBRATING,
+    TSC_READY
+};
+
+static long tsc_state = TSC_INIT;
+static long long tsc_start_ns;
+static long long tsc_start_tsc;
+
+/* TSC must be invariant (constant rate in all P-, C- and T-states) and,
+ * if we can tell, trusted by the kernel to be synchronized across CPUs */
+static int
+tsc_usable()
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid (0x80000007, &eax, &ebx, &ecx, &edx) ||
+        !(edx & (1 << 8))) return 0;
+
+    FILE* const f = fopen("/sys/devices/system/clocksource/clocksource0/"
+                          "current_clocksource", "r");
+    if (f)
+    {
+        char src[16] = { 0, };
+        int const ret = (fgets (src, sizeof(src), f) &&
+                         !strncmp (src, "tsc", 3));
+        fclose (f);
+        return ret;
+    }
+
+    return 1;
+}
+#endif /* GU_TIME_TSC */
+
+long long
+gu_time_fast_calibrate()
+{
+    long long const now = gu_time_monotonic();
+
+#ifdef GU_TIME_TSC
+    long state;
+    gu_atomic_get (&tsc_state, &state);
+
+    if (TSC_INIT == state || (TSC_CALIBRATING == state &&
+                              now - tsc_start_ns >= TSC_CALIBRATION_PERIOD))
+    {
+        long const busy = TSC_BUSY;
+
+        if (!gu_atomic_cas (&tsc_state, &state, busy)) return now;
+
+        if (TSC_INIT == state)
+        {
+            if (tsc_usable())
+            {
+                tsc_start_tsc = gu_time_rdtsc();
+                tsc_start_ns  = gu_time_monotonic();
+                state = TSC_CALIBRATING;
+            }
+            else
+            {
+                state = TSC_UNAVAILABLE;
+            }
+        }
+        else
+        {
+            long long const tsc = gu_time_rdtsc();
+            long long const ns  = gu_time_monotonic();
+            long long const ready = 1;
+
+            gu_time_tsc_clock.tsc   = tsc;
+            gu_time_tsc_clock.ns    = ns;
+            gu_time_tsc_clock.scale =
+                (double)(ns - tsc_start_ns) / (double)(tsc - tsc_start_tsc);
+            gu_atomic_set (&gu_time_tsc_clock.ready, &ready);
+            state = TSC_READY;
+        }
+
+        gu_atomic_set (&tsc_state, &state);
+    }
+#endif /* GU_TIME_TSC */
+
+    return now;
+}
 
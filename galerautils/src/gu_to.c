@@ -21,10 +21,15 @@
 #include "gu_assert.h"
 #include "gu_mem.h"
 #include "gu_threads.h"
+#include "gu_atomic.h"
 #include "gu_to.h"
 
 #define TO_USE_SIGNAL 1
 
+/* upper bound on the number of polls skipped between two reads of TO seqno
+ * while spinning, keeps the cache line from bouncing between spinners */
+#define TO_SPIN_BACKOFF_MAX 64
+
 typedef enum  {
   HOLDER = 0, //!< current TO holder
   WAIT,       //!< actively waiting in the queue
@@ -52,6 +57,7 @@ struct gu_to
     size_t               qmask;
     to_waiter_t*         queue;
     gu_mutex_t           lock;
+    long                 spin; /* see gu_to_set_spin() */
 };
 
 /** Returns pointer to the waiter with the given seqno */
@@ -152,6 +158,46 @@ long gu_to_destroy (gu_to_t** to)
     return 0;
 }
 
+void gu_to_set_spin (gu_to_t* to, long spin)
+{
+    gu_mutex_lock   (&to->lock);
+    to->spin = spin > 0 ? spin : 0;
+    gu_mutex_unlock (&to->lock);
+}
+
+static inline void
+to_cpu_relax (void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#else
+    __asm__ __volatile__ ("" ::: "memory");
+#endif
+}
+
+/* Polls TO seqno without the lock for at most to->spin iterations with
+ * exponential backoff. This is only a hint: the caller rechecks the state
+ * under the lock and blocks as usual if its turn has not come yet. */
+static inline void
+to_spin_wait (gu_to_t* to, gu_seqno_t seqno)
+{
+    long const spin    = to->spin;
+    long       backoff = 1;
+    long       i;
+
+    for (i = 0; i < spin; i += backoff) {
+        gu_seqno_t cur;
+        long       j;
+
+        gu_atomic_get (&to->seqno, &cur);
+        if (cur >= seqno) return;
+
+        for (j = 0; j < backoff; j++) to_cpu_relax();
+
+        if (backoff < TO_SPIN_BACKOFF_MAX) backoff <<= 1;
+    }
+}
+
 long gu_to_grab (gu_to_t* to, gu_seqno_t seqno)
 {
     long err;
@@ -159,6 +205,8 @@ long gu_to_grab (gu_to_t* to, gu_seqno_t seqno)
 
     assert (seqno >= 0);
 
+    if (to->spin > 0 && seqno > to->seqno) to_spin_wait (to, seqno);
+
     if ((err = gu_mutex_lock(&to->lock))) {
         gu_fatal("Mutex lock failed (%d): %s", err, strerror(err));
         abort();
@@ -257,7 +305,9 @@ static inline void
 to_release_and_wake_next (gu_to_t* to, to_waiter_t* w) {
     w->state = RELEASED;
     /* 
-     * Iterate over CANCELED waiters and set states as RELEASED
+     * Iterate over CANCELED waiters and set states as RELEASED in one pass,
+     * only the first non-canceled waiter needs to be woken. Waiters that are
+     * still spinning (state RELEASED) will see seqno change by themselves.
      * We look for waiter in the head of queue, which guarantees that
      * to_get_waiter() will always return a valid waiter pointer
      */
@@ -47,6 +47,17 @@ extern gu_to_t* gu_to_create (int len, gu_seqno_t seqno);
  */
 extern long gu_to_destroy (gu_to_t** to);
 
+/*! @brief Sets the number of times gu_to_grab() polls TO seqno before
+ * blocking on a condition variable.
+ * Spinning saves a sleep/wakeup cycle per seqno when the holders release TO
+ * fast, but wastes CPU otherwise, so it should be set only when there are
+ * enough cores for all competing threads. Polls are done with exponential
+ * backoff, so spin is an upper bound on busy iterations.
+ * @param to   A pointer to TO object.
+ * @param spin Number of polls, 0 (default) to block right away.
+ */
+extern void gu_to_set_spin (gu_to_t* to, long spin);
+
 /*! @brief Grabs TO resource in the specified order.
  * On successful return the mutex associated with specified TO is locked.
  * Must be released gu_to_release(). @see gu_to_release
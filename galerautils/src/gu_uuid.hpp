@@ -10,12 +10,41 @@
 #include "gu_assert.hpp"
 #include "gu_buffer.hpp"
 #include "gu_throw.hpp"
+#include "gu_byteswap.h"
 
 #include <iostream>
+#include <cstring> // memcpy()
+
+/* Inline equivalents of gu_uuid_compare(): UUIDs are map keys in gcomm and
+ * are compared on every message, two 64-bit word operations are much
+ * cheaper than an out of line memcmp() call. */
+inline uint64_t gu_uuid_word(const gu_uuid_t& u, int const i)
+{
+    uint64_t ret;
+    ::memcpy(&ret, u.data + i * sizeof(ret), sizeof(ret));
+    return ret;
+}
+
+inline bool gu_uuid_equal(const gu_uuid_t& a, const gu_uuid_t& b)
+{
+    return (((gu_uuid_word(a, 0) ^ gu_uuid_word(b, 0)) |
+             (gu_uuid_word(a, 1) ^ gu_uuid_word(b, 1))) == 0);
+}
+
+/* same order as memcmp() */
+inline bool gu_uuid_less(const gu_uuid_t& a, const gu_uuid_t& b)
+{
+    uint64_t const a0(gu_be64(gu_uuid_word(a, 0)));
+    uint64_t const b0(gu_be64(gu_uuid_word(b, 0)));
+
+    if (a0 != b0) return (a0 < b0);
+
+    return (gu_be64(gu_uuid_word(a, 1)) < gu_be64(gu_uuid_word(b, 1)));
+}
 
 inline bool operator==(const gu_uuid_t& a, const gu_uuid_t& b)
 {
-    return gu_uuid_compare(&a, &b) == 0;
+    return gu_uuid_equal(a, b);
 }
 
 inline bool operator!=(const gu_uuid_t& a, const gu_uuid_t& b)
@@ -122,12 +151,12 @@ public:
 
     bool operator<(const UUID& cmp) const
     {
-        return (gu_uuid_compare(&uuid_, &cmp.uuid_) < 0);
+        return gu_uuid_less(uuid_, cmp.uuid_);
     }
 
     bool operator==(const UUID& cmp) const
     {
-        return (gu_uuid_compare(&uuid_, &cmp.uuid_) == 0);
+        return gu_uuid_equal(uuid_, cmp.uuid_);
     }
 
     bool operator!=(const UUID& cmp) const
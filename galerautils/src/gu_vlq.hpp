@@ -134,6 +134,26 @@ namespace gu
         if (gu_unlikely(offset >= buflen)) gu_throw_fatal;
 #endif
 
+        // fast path: record lengths and counts mostly fit in 1-2 bytes
+        byte_t const b0(buf[offset]);
+
+        if (gu_likely((b0 & 0x80) == 0))
+        {
+            value = b0;
+            return offset + 1;
+        }
+
+        if (sizeof(UI) >= 2 && gu_likely(offset + 1 < buflen))
+        {
+            byte_t const b1(buf[offset + 1]);
+
+            if (gu_likely((b1 & 0x80) == 0))
+            {
+                value = UI(b0 & 0x7f) | (UI(b1) << 7);
+                return offset + 2;
+            }
+        }
+
 #ifdef GU_VLQ_ALEX
         value = buf[offset] & 0x7f;
         size_t shift(0);
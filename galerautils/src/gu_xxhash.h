@@ -0,0 +1,265 @@
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+
+/**
+ * @file xxHash64 header
+ *
+ * This code is based on the reference C implementation of XXH64 by its
+ * author Yann Collet, released under BSD 2-clause license.
+ *
+ * XXH64 consumes 32-byte stripes in four independent accumulators, so on
+ * modern superscalar CPUs it runs at several times the speed of MMH3-128,
+ * which has a single dependency chain per block. Its output is different from
+ * gu_hash, so it is only used where the peer is known to understand it,
+ * see RecordSet::CHECK_XXH64.
+ *
+ * $Id$
+ */
+
+#ifndef _gu_xxhash_h_
+#define _gu_xxhash_h_
+
+#include "gu_byteswap.h"
+
+#include <string.h> // for memcpy()
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static uint64_t const _xxh64_p1 = GU_ULONG_LONG(0x9E3779B185EBCA87);
+static uint64_t const _xxh64_p2 = GU_ULONG_LONG(0xC2B2AE3D27D4EB4F);
+static uint64_t const _xxh64_p3 = GU_ULONG_LONG(0x165667B19E3779F9);
+static uint64_t const _xxh64_p4 = GU_ULONG_LONG(0x85EBCA77C2B2AE63);
+static uint64_t const _xxh64_p5 = GU_ULONG_LONG(0x27D4EB2F165667C5);
+
+static GU_FORCE_INLINE uint64_t
+_xxh64_read64 (const void* const p)
+{
+    uint64_t v;
+    memcpy (&v, p, sizeof(v));
+    return gu_le64(v);
+}
+
+static GU_FORCE_INLINE uint32_t
+_xxh64_read32 (const void* const p)
+{
+    uint32_t v;
+    memcpy (&v, p, sizeof(v));
+    return gu_le32(v);
+}
+
+static GU_FORCE_INLINE uint64_t
+_xxh64_round (uint64_t acc, uint64_t const input)
+{
+    acc += input * _xxh64_p2;
+    acc  = GU_ROTL64(acc, 31);
+    acc *= _xxh64_p1;
+    return acc;
+}
+
+static GU_FORCE_INLINE uint64_t
+_xxh64_merge (uint64_t acc, uint64_t const val)
+{
+    acc ^= _xxh64_round (0, val);
+    acc  = acc * _xxh64_p1 + _xxh64_p4;
+    return acc;
+}
+
+/* processes as many whole 32-byte stripes as there are in len,
+ * returns the number of bytes consumed */
+static GU_FORCE_INLINE size_t
+_xxh64_stripes (uint64_t* const v, const uint8_t* p, size_t const len)
+{
+    const uint8_t* const begin = p;
+    const uint8_t* const limit = p + (len & ~((size_t)31));
+
+    uint64_t v1 = v[0], v2 = v[1], v3 = v[2], v4 = v[3];
+
+    while (p < limit)
+    {
+        v1 = _xxh64_round (v1, _xxh64_read64 (p));      p += 8;
+        v2 = _xxh64_round (v2, _xxh64_read64 (p));      p += 8;
+        v3 = _xxh64_round (v3, _xxh64_read64 (p));      p += 8;
+        v4 = _xxh64_round (v4, _xxh64_read64 (p));      p += 8;
+    }
+
+    v[0] = v1; v[1] = v2; v[2] = v3; v[3] = v4;
+
+    return p - begin;
+}
+
+static GU_FORCE_INLINE uint64_t
+_xxh64_converge (const uint64_t* const v)
+{
+    uint64_t h = GU_ROTL64(v[0], 1)  + GU_ROTL64(v[1], 7) +
+                 GU_ROTL64(v[2], 12) + GU_ROTL64(v[3], 18);
+
+    h = _xxh64_merge (h, v[0]);
+    h = _xxh64_merge (h, v[1]);
+    h = _xxh64_merge (h, v[2]);
+    h = _xxh64_merge (h, v[3]);
+
+    return h;
+}
+
+/* digests the remaining (less than 32) bytes and finalizes the hash */
+static GU_FORCE_INLINE uint64_t
+_xxh64_tail (uint64_t h, const uint8_t* p, size_t len)
+{
+    while (len >= 8)
+    {
+        h ^= _xxh64_round (0, _xxh64_read64 (p));
+        h  = GU_ROTL64(h, 27) * _xxh64_p1 + _xxh64_p4;
+        p += 8; len -= 8;
+    }
+
+    if (len >= 4)
+    {
+        h ^= (uint64_t)_xxh64_read32 (p) * _xxh64_p1;
+        h  = GU_ROTL64(h, 23) * _xxh64_p2 + _xxh64_p3;
+        p += 4; len -= 4;
+    }
+
+    while (len > 0)
+    {
+        h ^= (*p) * _xxh64_p5;
+        h  = GU_ROTL64(h, 11) * _xxh64_p1;
+        p++; len--;
+    }
+
+    h ^= h >> 33;
+    h *= _xxh64_p2;
+    h ^= h >> 29;
+    h *= _xxh64_p3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+static GU_FORCE_INLINE void
+_xxh64_init_lanes (uint64_t* const v, uint64_t const seed)
+{
+    v[0] = seed + _xxh64_p1 + _xxh64_p2;
+    v[1] = seed + _xxh64_p2;
+    v[2] = seed;
+    v[3] = seed - _xxh64_p1;
+}
+
+/*! XXH64 of a whole message with a given seed (reference signature),
+ *  returns hash as an integer, in host byte-order */
+static GU_INLINE uint64_t
+gu_xxh64_seed (const void* const msg, size_t const len, uint64_t const seed)
+{
+    const uint8_t* p = (const uint8_t*)msg;
+    uint64_t h;
+
+    if (len >= 32)
+    {
+        uint64_t v[4];
+        _xxh64_init_lanes (v, seed);
+        p += _xxh64_stripes (v, p, len);
+        h  = _xxh64_converge (v);
+    }
+    else
+    {
+        h = seed + _xxh64_p5;
+    }
+
+    h += len;
+
+    return _xxh64_tail (h, p, len & 31);
+}
+
+/* Galera uses zero seed, as no existing hash output depends on it */
+#define GU_XXH64_SEED 0
+
+/*! returns hash as an integer, in host byte-order */
+static GU_FORCE_INLINE uint64_t
+gu_xxh64 (const void* const msg, size_t const len)
+{
+    return gu_xxh64_seed (msg, len, GU_XXH64_SEED);
+}
+
+/*
+ * Functions to hash message by parts
+ */
+
+typedef struct gu_xxh64_ctx
+{
+    uint64_t lanes[4];
+    uint64_t tail[4];
+    uint64_t seed;
+    size_t   length;
+} gu_xxh64_ctx_t;
+
+/*! Initialize/reset XXH64 context with a particular seed. */
+static GU_INLINE void
+gu_xxh64_init_seed (gu_xxh64_ctx_t* const xxh, uint64_t const seed)
+{
+    _xxh64_init_lanes (xxh->lanes, seed);
+    xxh->seed   = seed;
+    xxh->length = 0;
+}
+
+/*! Initialize XXH64 context with a default Galera seed. */
+#define gu_xxh64_init(_xxh) gu_xxh64_init_seed (_xxh, GU_XXH64_SEED)
+
+/*! Append message part to hash context */
+static GU_INLINE void
+gu_xxh64_append (gu_xxh64_ctx_t* const xxh,
+                 const void*           part,
+                 size_t                len)
+{
+    size_t const tail_len = xxh->length & 31;
+    const uint8_t* p = (const uint8_t*)part;
+
+    xxh->length += len;
+
+    if (tail_len) /* there's something in the tail */
+    {
+        size_t const to_fill  = 32 - tail_len;
+        uint8_t* const tail_end = (uint8_t*)xxh->tail + tail_len;
+
+        if (len < to_fill)
+        {
+            memcpy (tail_end, p, len);
+            return;
+        }
+
+        memcpy (tail_end, p, to_fill);
+        _xxh64_stripes (xxh->lanes, (const uint8_t*)xxh->tail, 32);
+        p   += to_fill;
+        len -= to_fill;
+    }
+
+    p   += _xxh64_stripes (xxh->lanes, p, len);
+
+    /* save possible trailing bytes to tail */
+    memcpy (xxh->tail, p, len & 31);
+}
+
+/*! Get the accumulated message hash (does not change the context) */
+static GU_INLINE uint64_t
+gu_xxh64_get (const gu_xxh64_ctx_t* const xxh)
+{
+    uint64_t h;
+
+    if (xxh->length >= 32)
+    {
+        h = _xxh64_converge (xxh->lanes);
+    }
+    else
+    {
+        h = xxh->seed + _xxh64_p5;
+    }
+
+    h += xxh->length;
+
+    return _xxh64_tail (h, (const uint8_t*)xxh->tail, xxh->length & 31);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _gu_xxhash_h_ */
@@ -82,10 +82,49 @@ START_TEST (basic)
 }
 END_TEST
 
+/* heap pages of subsequent allocators in the same thread are reused */
+START_TEST (heap_cache)
+{
+    TestBaseName test_name("gu_alloc_test");
+    gu::byte_t* first(0);
+    bool n;
+
+    gu::Allocator::set_heap_cache(4);
+
+    for (int i(0); i < 3; ++i)
+    {
+        gu::Allocator a(test_name, 0, 0, 1 << 20, 1 << 16);
+
+        gu::byte_t* const p(a.alloc(16, n));
+        fail_if (0 == p);
+        fail_if (!n);
+
+        if (0 == i) first = p;
+        else fail_if (p != first, "heap page was not reused: %p != %p",
+                      p, first);
+    }
+
+    gu::Allocator::set_heap_cache(0);
+
+    {
+        gu::Allocator a(test_name, 0, 0, 1 << 20, 1 << 16);
+        fail_if (0 == a.alloc(16, n)); // page is taken from the cache
+    }
+
+    {
+        gu::Allocator a(test_name, 0, 0, 1 << 20, 1 << 16);
+        fail_if (0 == a.alloc(16, n));
+    }
+
+    gu::Allocator::set_heap_cache(16);
+}
+END_TEST
+
 Suite* gu_alloc_suite ()
 {
     TCase* t = tcase_create ("Allocator");
     tcase_add_test (t, basic);
+    tcase_add_test (t, heap_cache);
 
     Suite* s = suite_create ("gu::Allocator");
     suite_add_tcase (s, t);
@@ -52,6 +52,20 @@ START_TEST(test_sanity_cxx)
 }
 END_TEST
 
+START_TEST(test_padded)
+{
+    gu::PaddedAtomic<int64_t> a[2];
+
+    fail_if(sizeof(a[0]) != GU_CACHE_LINE_SIZE);
+    fail_if(reinterpret_cast<char*>(&a[1]) - reinterpret_cast<char*>(&a[0])
+            < GU_CACHE_LINE_SIZE);
+
+    a[1] = 5; ++a[1]; a[1] += 2;
+    fail_if(a[0]() != 0);
+    fail_if(a[1]() != 8);
+}
+END_TEST
+
 // we want it sufficiently long to test above least 4 bytes, but sufficiently
 // short to avoid overflow
 static long long const increment(333333333333LL);
@@ -138,14 +152,50 @@ START_TEST(test_concurrency)
 }
 END_TEST
 
+static void* counter_loop(void* arg)
+{
+    gu::PerCpuCounter* const cnt(static_cast<gu::PerCpuCounter*>(arg));
+
+    for (int i(0); i < iterations; ++i)
+    {
+        ++(*cnt);
+        *cnt += 2;
+    }
+
+    return NULL;
+}
+
+START_TEST(test_per_cpu_counter)
+{
+    gu::PerCpuCounter cnt;
+    pthread_t threads[n_threads];
+
+    fail_if(cnt() != 0);
+
+    for (int i(0); i < n_threads; ++i)
+    {
+        fail_if(pthread_create(&threads[i], NULL, counter_loop, &cnt));
+    }
+
+    for (int i(0); i < n_threads; ++i)
+    {
+        fail_if(pthread_join(threads[i], NULL));
+    }
+
+    fail_if(cnt() != 3LL * iterations * n_threads, "%lld", cnt());
+}
+END_TEST
+
 Suite* gu_atomic_suite()
 {
     TCase* t1 = tcase_create ("sanity");
     tcase_add_test (t1, test_sanity_c);
     tcase_add_test (t1, test_sanity_cxx);
+    tcase_add_test (t1, test_padded);
 
     TCase* t2 = tcase_create ("concurrency");
     tcase_add_test (t2, test_concurrency);
+    tcase_add_test (t2, test_per_cpu_counter);
     tcase_set_timeout(t2, 60);
 
     Suite* s = suite_create ("gu::Atomic");
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ *
+ * Hashing, checksumming and VLQ microbenchmark.
+ *
+ * Measures the primitives the write set and network code are built on:
+ *   mmh128  - gu::Hash (the RecordSet/TrxHandle checksum) over a buffer,
+ *   xxh64   - gu::XXH64 over a buffer,
+ *   crc32c  - gu_crc32c() with the implementation picked for this host,
+ *   fast64  - gu_fast_hash64() over short key-sized inputs,
+ *   vlq_enc - gu::uleb128_encode() of random 64-bit values,
+ *   vlq_dec - gu::uleb128_decode() of the same values.
+ * Input is generated with a fixed seed before the measurement starts.
+ *
+ * Usage: gu_bench [-n loops] [-s buffer size] [-k key size]
+ *                 [-v VLQ values]
+ */
+
+#include "gu_digest.hpp"
+#include "gu_vlq.hpp"
+#include "gu_crc32c.h"
+#include "gu_time.h"
+
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        Options()
+            :
+            loops (10000),
+            size  (4096),
+            key   (16),
+            values(1 << 20)
+        {}
+
+        long loops;
+        long size;
+        long key;
+        long values;
+    };
+
+    void usage(const char* const name)
+    {
+        fprintf(stderr, "Usage: %s [-n loops] [-s buffer size] [-k key size]"
+                " [-v VLQ values]\n", name);
+    }
+
+    /* simple LCG to be independent of libc rand() */
+    class Rand
+    {
+    public:
+        Rand() : x_(0x1234567ULL) {}
+        unsigned long long operator()()
+        {
+            x_ = x_ * 6364136223846793005ULL + 1442695040888963407ULL;
+            return x_;
+        }
+    private:
+        unsigned long long x_;
+    };
+
+    /* this variable serves to prevent compiler from optimizing out the
+     * calls */
+    unsigned long long volatile sink(0);
+
+    void report(const char* const what, long long const ns, double const bytes,
+                double const ops)
+    {
+        printf("%-12s %8.1f ns/op, %8.1f MB/s\n", what, ns / ops,
+               bytes / (1 << 20) / (ns / 1.0e9));
+    }
+
+    void bench_digest(const Options& opt, const std::vector<gu::byte_t>& buf)
+    {
+        double const bytes(double(opt.loops) * buf.size());
+        unsigned long long h(0);
+
+        long long t0(gu_time_monotonic());
+        for (long i(0); i < opt.loops; ++i)
+        {
+            gu::Hash hash;
+            hash.append(&buf[0], buf.size());
+            h += hash.gather8();
+        }
+        report("mmh128:", gu_time_monotonic() - t0, bytes, opt.loops);
+
+        t0 = gu_time_monotonic();
+        for (long i(0); i < opt.loops; ++i)
+        {
+            gu::XXH64 hash;
+            hash.append(&buf[0], buf.size());
+            h += hash.gather8();
+        }
+        report("xxh64:", gu_time_monotonic() - t0, bytes, opt.loops);
+
+        t0 = gu_time_monotonic();
+        for (long i(0); i < opt.loops; ++i)
+        {
+            h += gu_crc32c(&buf[0], buf.size());
+        }
+        report("crc32c:", gu_time_monotonic() - t0, bytes, opt.loops);
+
+        sink += h;
+    }
+
+    void bench_fast_hash(const Options& opt, const std::vector<gu::byte_t>& buf)
+    {
+        /* walk the buffer with overlapping key-sized windows */
+        long const keys(buf.size() - opt.key + 1);
+        long const total(opt.loops * keys);
+        unsigned long long h(0);
+
+        long long const t0(gu_time_monotonic());
+        for (long i(0); i < opt.loops; ++i)
+        {
+            for (long k(0); k < keys; ++k)
+            {
+                h += gu_fast_hash64(&buf[k], opt.key);
+            }
+        }
+        report("fast64:", gu_time_monotonic() - t0, double(total) * opt.key,
+               total);
+
+        sink += h;
+    }
+
+    void bench_vlq(const Options& opt)
+    {
+        Rand rnd;
+        std::vector<unsigned long long> values(opt.values);
+        for (size_t i(0); i < values.size(); ++i)
+        {
+            /* spread over all encoded lengths */
+            values[i] = rnd() >> (rnd() % 64);
+        }
+
+        std::vector<gu::byte_t> buf(values.size() * 10);
+
+        long long t0(gu_time_monotonic());
+        size_t offset(0);
+        for (size_t i(0); i < values.size(); ++i)
+        {
+            offset = gu::uleb128_encode(values[i], &buf[0], buf.size(),
+                                        offset);
+        }
+        long long const enc_ns(gu_time_monotonic() - t0);
+
+        t0 = gu_time_monotonic();
+        size_t const end(offset);
+        unsigned long long h(0);
+        offset = 0;
+        while (offset < end)
+        {
+            unsigned long long v;
+            offset = gu::uleb128_decode(&buf[0], end, offset, v);
+            h += v;
+        }
+        long long const dec_ns(gu_time_monotonic() - t0);
+
+        report("vlq_enc:", enc_ns, end, values.size());
+        report("vlq_dec:", dec_ns, end, values.size());
+
+        sink += h;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:s:k:v:")) != -1)
+    {
+        long const val(optarg ? strtol(optarg, NULL, 10) : 0);
+
+        switch (c)
+        {
+        case 'n': opt.loops  = val; break;
+        case 's': opt.size   = val; break;
+        case 'k': opt.key    = val; break;
+        case 'v': opt.values = val; break;
+        default:  usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (opt.loops <= 0 || opt.size <= 0 || opt.key <= 0 ||
+        opt.key > opt.size || opt.values <= 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gu_crc32c_configure();
+
+    Rand rnd;
+    std::vector<gu::byte_t> buf(opt.size);
+    for (size_t b(0); b < buf.size(); ++b)
+    {
+        buf[b] = static_cast<gu::byte_t>(rnd() >> 56);
+    }
+
+    printf("loops: %ld, buffer: %ld bytes, key: %ld bytes, VLQ values: %ld, "
+           "CRC-32C hardware: %d\n", opt.loops, opt.size, opt.key, opt.values,
+           gu_crc32c_hardware());
+
+    bench_digest(opt, buf);
+    bench_fast_hash(opt, buf);
+    bench_vlq(opt);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+
+#include "../src/gu_buffer.hpp"
+
+#include "gu_buffer_test.hpp"
+
+#include <string>
+
+START_TEST (simple_test)
+{
+    gu::Buffer b;
+    fail_if (!b.empty());
+    fail_if (b.capacity() != gu::Buffer::SMALL);
+
+    const gu::byte_t* const small(b.data());
+
+    b.push_back(1);
+    b.resize(10, 2);
+    fail_if (b.size() != 10);
+    fail_if (b[0] != 1 || b[9] != 2);
+    fail_if (b.data() != small); // still inside the object
+
+    const gu::byte_t abc[] = { 'a', 'b', 'c' };
+    b.insert(b.begin() + 1, abc, abc + sizeof(abc));
+    fail_if (b.size() != 13);
+    fail_if (b[0] != 1 || b[1] != 'a' || b[3] != 'c' || b[4] != 2);
+
+    b.erase(b.begin(), b.begin() + 4);
+    fail_if (b.size() != 9);
+    fail_if (b[0] != 2);
+
+    b.insert(b.end(), 3, 7);
+    fail_if (b.size() != 12 || b.back() != 7);
+
+    b.resize(gu::Buffer::SMALL + 1);
+    fail_if (b.data() == small); // moved to heap
+    fail_if (b[0] != 2 || b[11] != 7);
+
+    size_t const cap(b.capacity());
+    b.clear();
+    fail_if (!b.empty());
+    fail_if (b.capacity() != cap); // memory is kept for reuse
+
+    gu::Buffer c(abc, abc + sizeof(abc));
+    fail_if (c.size() != sizeof(abc));
+
+    gu::Buffer d(c);
+    fail_if (d != c);
+    d.push_back('d');
+    fail_if (d == c);
+    fail_if (!(c < d));
+
+    gu::Buffer z(5, 0);
+    fail_if (z.size() != 5 || z[4] != 0);
+
+    std::string const str("string");
+    gu::Buffer s(str.begin(), str.end());
+    fail_if (std::string(s.begin(), s.end()) != str);
+}
+END_TEST
+
+START_TEST (swap_test)
+{
+    gu::Buffer small1(3, 1);
+    gu::Buffer small2(5, 2);
+    gu::Buffer heap1(100, 3);
+    gu::Buffer heap2(200, 4);
+
+    const gu::byte_t* const heap1_ptr(heap1.data());
+    const gu::byte_t* const heap2_ptr(heap2.data());
+
+    small1.swap(small2);
+    fail_if (small1.size() != 5 || small1[4] != 2);
+    fail_if (small2.size() != 3 || small2[2] != 1);
+
+    heap1.swap(heap2);
+    fail_if (heap1.data() != heap2_ptr || heap1.size() != 200);
+    fail_if (heap2.data() != heap1_ptr || heap2.size() != 100);
+
+    // heap storage changes hands without copying
+    small1.swap(heap1);
+    fail_if (small1.data() != heap2_ptr || small1.size() != 200);
+    fail_if (heap1.size() != 5 || heap1[4] != 2);
+
+    heap2.swap(small2);
+    fail_if (small2.data() != heap1_ptr || small2.size() != 100);
+    fail_if (heap2.size() != 3 || heap2[2] != 1);
+    fail_if (heap2.capacity() != gu::Buffer::SMALL);
+
+    gu::Buffer copy(small1);
+    copy = heap2;
+    fail_if (copy != heap2);
+    copy = copy;
+    fail_if (copy != heap2);
+}
+END_TEST
+
+Suite*
+gu_buffer_suite(void)
+{
+    TCase* t = tcase_create ("simple_test");
+    tcase_add_test (t, simple_test);
+    tcase_add_test (t, swap_test);
+
+    Suite* s = suite_create ("gu::Buffer");
+    suite_add_tcase (s, t);
+
+    return s;
+}
@@ -58,6 +58,51 @@ START_TEST (gu_config_test)
 }
 END_TEST
 
+START_TEST (gu_config_handle_test)
+{
+    gu::Config cnf;
+
+    cnf.add(key, "1K");
+    cnf.add(another_key, "yes");
+
+    {
+        gu::Config::Handle<long long> ih(cnf, key);
+        gu::Config::Handle<int>       ih2(cnf, key);
+        gu::Config::Handle<bool>      bh(cnf, another_key);
+
+        fail_if(ih()  != 1024, "ih: %lld", ih());
+        fail_if(ih2() != 1024, "ih2: %d", ih2());
+        fail_if(bh()  != true);
+
+        cnf.set(key, 2048);
+        fail_if(ih()  != 2048, "ih: %lld", ih());
+        fail_if(ih2() != 2048, "ih2: %d", ih2());
+
+        bh.set("no");
+        fail_if(bh() != false);
+        fail_if(cnf.get<bool>(another_key) != false);
+
+        // unparseable value must leave both config and handle intact
+        try { cnf.set(another_key, "maybe"); fail("gu::Exception expected"); }
+        catch (gu::Exception&) {}
+        fail_if(bh() != false);
+        fail_if(cnf.get(another_key) != "no");
+
+        // copy does not carry handles
+        gu::Config copy(cnf);
+        copy.set(key, 1);
+        fail_if(ih() != 2048, "ih: %lld", ih());
+    }
+
+    // handles are gone, anything goes
+    cnf.set(another_key, "maybe");
+
+    cnf.add("unset_key");
+    try { gu::Config::Handle<int> h(cnf, "unset_key"); fail("NotSet expected"); }
+    catch (gu::NotSet&) {}
+}
+END_TEST
+
 Suite *gu_config_suite(void)
 {
   Suite *s  = suite_create("gu::Config");
@@ -65,6 +110,7 @@ Suite *gu_config_suite(void)
 
   suite_add_tcase (s, tc);
   tcase_add_test  (tc, gu_config_test);
+  tcase_add_test  (tc, gu_config_handle_test);
   return s;
 }
 
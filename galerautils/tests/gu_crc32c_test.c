@@ -9,6 +9,7 @@
 #include "gu_crc32c_test.h"
 
 #include <string.h>
+#include <stdlib.h>
 
 #define long_input                     \
     "0123456789abcdef0123456789ABCDEF" \
@@ -129,6 +130,45 @@ START_TEST(test_hardware)
 }
 END_TEST
 
+#if defined(GU_CRC32C_HW3)
+/* compare to slicing-by-8 on lengths and offsets crossing 3-way blocks */
+START_TEST(test_hw3)
+{
+    if (!gu_crc32c_hw3_init()) return; /* no CPU support */
+
+    gu_crc32c_func = gu_crc32c_hw3;
+    test_function();
+
+    static size_t const buf_size = 3*8192*2 + 3*256 + 64;
+    unsigned char* const buf = malloc(buf_size);
+    size_t i;
+
+    fail_if(NULL == buf);
+    for (i = 0; i < buf_size; i++) buf[i] = rand();
+
+    static size_t const lens[] = { 0, 1, 7, 8, 9, 767, 768, 769, 1000,
+                                   3*8192 - 1, 3*8192, 3*8192 + 3*256 + 13,
+                                   3*8192*2 + 3*256 };
+    size_t l;
+    for (l = 0; l < sizeof(lens)/sizeof(lens[0]); l++)
+    {
+        size_t off;
+        for (off = 0; off < 16; off++)
+        {
+            uint32_t const sw = crc32cSlicingBy8(GU_CRC32C_INIT,
+                                                 buf + off, lens[l]);
+            uint32_t const hw = gu_crc32c_hw3(GU_CRC32C_INIT,
+                                              buf + off, lens[l]);
+            fail_if (sw != hw, "len %zu, offset %zu: %#08x, expected %#08x",
+                     lens[l], off, hw, sw);
+        }
+    }
+
+    free(buf);
+}
+END_TEST
+#endif /* GU_CRC32C_HW3 */
+
 Suite *gu_crc32c_suite(void)
 {
     Suite *suite = suite_create("CRC32C implementation");
@@ -143,6 +183,9 @@ Suite *gu_crc32c_suite(void)
     TCase *hw = tcase_create("test_hw");
     suite_add_tcase (suite, hw);
     tcase_add_test  (hw, test_hardware);
+#if defined(GU_CRC32C_HW3)
+    tcase_add_test  (hw, test_hw3);
+#endif
 
     return suite;
 }
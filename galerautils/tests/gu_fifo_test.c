@@ -208,6 +208,46 @@ START_TEST(gu_fifo_cancel_test)
 }
 END_TEST
 
+START_TEST(gu_fifo_memory_test)
+{
+#define MEM_FIFO_LENGTH (1L << 20)
+    gu_fifo_t* q = gu_fifo_create (MEM_FIFO_LENGTH, sizeof(size_t));
+    fail_if (q == NULL);
+
+    size_t const base = gu_fifo_memory (q);
+    long i;
+    int  err;
+
+    for (i = 0; i < MEM_FIFO_LENGTH; i++) {
+        size_t* item = gu_fifo_get_tail (q);
+        fail_if (item == NULL, "could not get item %ld", i);
+        *item = i;
+        gu_fifo_push_tail (q);
+    }
+
+    size_t const full = gu_fifo_memory (q);
+    fail_if (full < base + MEM_FIFO_LENGTH * sizeof(size_t),
+             "full queue holds %zu bytes, base %zu", full, base);
+
+    for (i = 0; i < MEM_FIFO_LENGTH; i++) {
+        size_t* item = gu_fifo_get_head (q, &err);
+        fail_if (item == NULL, "could not get item %ld", i);
+        fail_if (*item != (size_t)i, "got %zu, expected %ld", *item, i);
+        gu_fifo_pop_head (q);
+    }
+
+    /* drained queue keeps at most one spare row */
+    size_t const drained = gu_fifo_memory (q);
+    fail_if (drained - base > (full - base) / 8,
+             "drained queue holds %zu bytes, full %zu, base %zu",
+             drained, full, base);
+
+    gu_fifo_close   (q);
+    gu_fifo_destroy (q);
+#undef MEM_FIFO_LENGTH
+}
+END_TEST
+
 Suite *gu_fifo_suite(void)
 {
     Suite *s  = suite_create("Galera FIFO functions");
@@ -216,6 +256,7 @@ Suite *gu_fifo_suite(void)
     suite_add_tcase (s, tc);
     tcase_add_test  (tc, gu_fifo_test);
     tcase_add_test  (tc, gu_fifo_cancel_test);
+    tcase_add_test  (tc, gu_fifo_memory_test);
     return s;
 }
 
@@ -5,6 +5,7 @@
 #include "../src/gu_histogram.hpp"
 #include "../src/gu_logger.hpp"
 #include <cstdlib>
+#include <pthread.h>
 
 #include "gu_histogram_test.hpp"
 
@@ -31,10 +32,93 @@ START_TEST(test_histogram)
 }
 END_TEST
 
+START_TEST(test_histogram_buckets)
+{
+    /* buckets are contiguous and relative error is bounded by 1/SUB */
+    for (int i = 1; i < Histogram::BUCKETS; ++i)
+    {
+        fail_if(Histogram::bucket_min(i) != Histogram::bucket_max(i - 1) + 1,
+                "bucket %d min %lld, previous max %lld", i,
+                Histogram::bucket_min(i), Histogram::bucket_max(i - 1));
+        fail_if(Histogram::bucket(Histogram::bucket_min(i)) != i);
+        fail_if(Histogram::bucket(Histogram::bucket_max(i)) != i);
+        fail_if(Histogram::bucket_max(i) - Histogram::bucket_min(i) >
+                Histogram::bucket_min(i) / Histogram::SUB);
+    }
+
+    fail_if(Histogram::bucket(1LL << 62) != Histogram::BUCKETS - 1);
+}
+END_TEST
+
+START_TEST(test_histogram_percentile)
+{
+    Histogram hs;
+
+    fail_if(hs.count()         != 0);
+    fail_if(hs.percentile(50.) != 0);
+
+    for (long long i = 1; i <= 1000; ++i) hs.insert_ns(i * 1000);
+
+    fail_if(hs.count() != 1000);
+    fail_if(hs.mean()  != 500500.0, "mean %f", hs.mean());
+
+    long long const p50(hs.percentile(50.0));
+    fail_if(p50 < 500000 || p50 > 500000 + 500000/Histogram::SUB,
+            "p50 %lld", p50);
+
+    long long const p999(hs.percentile(99.9));
+    fail_if(p999 < 999000 || p999 > 999000 + 999000/Histogram::SUB,
+            "p999 %lld", p999);
+
+    Histogram other;
+    other.insert(1.0); // seconds
+    hs.merge(other);
+
+    fail_if(hs.count() != 1001);
+    fail_if(hs.percentile(100.0) < 1000000000LL);
+
+    log_info << hs;
+
+    hs.clear();
+    fail_if(hs.count() != 0);
+}
+END_TEST
+
+static void* histogram_thread(void* arg)
+{
+    Histogram* const hs(static_cast<Histogram*>(arg));
+
+    for (long long i = 0; i < 100000; ++i) hs->insert_ns(i % 4096);
+
+    return 0;
+}
+
+START_TEST(test_histogram_threads)
+{
+    Histogram hs;
+    pthread_t th[4];
+
+    for (size_t i = 0; i < sizeof(th)/sizeof(th[0]); ++i)
+    {
+        fail_if(pthread_create(&th[i], 0, histogram_thread, &hs));
+    }
+
+    for (size_t i = 0; i < sizeof(th)/sizeof(th[0]); ++i)
+    {
+        pthread_join(th[i], 0);
+    }
+
+    fail_if(hs.count() != 400000, "count %lld", hs.count());
+}
+END_TEST
+
 Suite* gu_histogram_suite()
 {
     TCase* t = tcase_create ("test_histogram");
     tcase_add_test (t, test_histogram);
+    tcase_add_test (t, test_histogram_buckets);
+    tcase_add_test (t, test_histogram_percentile);
+    tcase_add_test (t, test_histogram_threads);
 
     Suite* s = suite_create ("gu::Histogram");
     suite_add_tcase (s, t);
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "../src/gu_io_uring.hpp"
+#include "../src/gu_logger.hpp"
+
+#include "gu_io_uring_test.hpp"
+
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+START_TEST(test_io_uring_write)
+{
+    gu::IoUring* ring(NULL);
+
+    try { ring = new gu::IoUring(4); }
+    catch (gu::Exception& e)
+    {
+        log_info << "io_uring not available, skipping: " << e.what();
+        return;
+    }
+
+    char name[] = "gu_io_uring_test.XXXXXX";
+    int const fd(mkstemp(name));
+    fail_if(fd < 0);
+    unlink(name);
+
+    static size_t const chunk(4096);
+    static int    const chunks(10);
+
+    std::vector<char> bufs[chunks];
+    for (int i(0); i < chunks; ++i) bufs[i].assign(chunk, 'a' + i);
+
+    int queued(0);
+    int done(0);
+
+    while (done < chunks)
+    {
+        /* more chunks than ring entries, write() must refuse when full */
+        while (queued < chunks &&
+               ring->write(fd, &bufs[queued][0], chunk, queued * chunk,
+                           queued)) ++queued;
+
+        fail_if(ring->pending() > 4, "pending: %u", ring->pending());
+
+        ring->submit(1);
+
+        uint64_t tag;
+        int      res;
+        while (ring->reap(tag, res))
+        {
+            fail_if(tag >= uint64_t(chunks), "tag: %llu",
+                    static_cast<unsigned long long>(tag));
+            fail_if(res != int(chunk), "res: %d", res);
+            ++done;
+        }
+    }
+
+    fail_if(ring->pending() != 0);
+
+    fail_unless(ring->fsync(fd, true, 100));
+    ring->submit(1);
+
+    uint64_t tag;
+    int      res;
+    fail_unless(ring->reap(tag, res));
+    fail_if(tag != 100);
+    fail_if(res != 0, "fsync res: %d", res);
+
+    for (int i(0); i < chunks; ++i)
+    {
+        std::vector<char> check(chunk);
+        fail_if(pread(fd, &check[0], chunk, i * chunk) != ssize_t(chunk));
+        fail_if(check != bufs[i], "chunk %d mismatch", i);
+    }
+
+    close(fd);
+    delete ring;
+}
+END_TEST
+
+Suite *gu_io_uring_suite(void)
+{
+    Suite *s  = suite_create("gu::IoUring");
+    TCase *tc = tcase_create("test_io_uring");
+
+    suite_add_tcase (s, tc);
+    tcase_add_test  (tc, test_io_uring_write);
+
+    return s;
+}
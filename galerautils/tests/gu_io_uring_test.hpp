@@ -0,0 +1,12 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#ifndef __gu_io_uring_test__
+#define __gu_io_uring_test__
+
+#include <check.h>
+
+extern Suite *gu_io_uring_suite(void);
+
+#endif // __gu_io_uring_test__
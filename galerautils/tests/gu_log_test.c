@@ -0,0 +1,95 @@
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+
+// $Id$
+
+#include <check.h>
+#include <string.h>
+
+#include "gu_log_test.h"
+#include "../src/gu_conf.h"
+#include "../src/gu_atomic.h"
+
+#define MAX_MSGS 16
+
+static char msgs[MAX_MSGS][64];
+static int  msgs_num = 0;
+
+static int  in_cb   = 0; // callback was entered
+static int  hold_cb = 0; // callback should wait
+
+static void
+test_log_cb (int severity, const char* msg)
+{
+    int const one = 1;
+    int hold;
+
+    gu_atomic_set (&in_cb, &one);
+
+    do {
+        gu_atomic_get (&hold_cb, &hold);
+    } while (hold);
+
+    if (msgs_num < MAX_MSGS) {
+        strncpy (msgs[msgs_num], msg, sizeof(msgs[0]) - 1);
+        msgs_num++;
+    }
+}
+
+/* messages carry location prefix when debug is on */
+static int
+ends_with (const char* const str, const char* const end)
+{
+    size_t const str_len = strlen(str);
+    size_t const end_len = strlen(end);
+
+    return (str_len >= end_len && !strcmp (str + str_len - end_len, end));
+}
+
+START_TEST (gu_log_async_test)
+{
+    int const zero = 0, one = 1;
+    int entered = 0;
+    int i;
+
+    gu_conf_set_log_callback (test_log_cb);
+
+    fail_if (gu_conf_log_async (2) != 0);
+
+    /* first message blocks the background thread in the callback */
+    gu_atomic_set (&hold_cb, &one);
+    gu_info ("msg 0");
+
+    while (!entered) gu_atomic_get (&in_cb, &entered);
+
+    /* 2 fit into the ring, the rest are dropped */
+    for (i = 1; i <= 10; i++) gu_info ("msg %d", i);
+
+    gu_atomic_set (&hold_cb, &zero);
+    fail_if (gu_conf_log_async (0) != 0);
+
+    gu_conf_set_log_callback (NULL);
+
+    fail_if (msgs_num != 4, "Expected 4 messages, got %d", msgs_num);
+    fail_if (!ends_with (msgs[0], "msg 0"), "Got '%s'", msgs[0]);
+    fail_if (!ends_with (msgs[1], "msg 1"), "Got '%s'", msgs[1]);
+    fail_if (!ends_with (msgs[2], "msg 2"), "Got '%s'", msgs[2]);
+    fail_if (strcmp (msgs[3], "8 log messages dropped"), "Got '%s'", msgs[3]);
+
+    /* synchronous again */
+    msgs_num = 0;
+    gu_conf_set_log_callback (test_log_cb);
+    gu_info ("sync");
+    gu_conf_set_log_callback (NULL);
+    fail_if (msgs_num != 1);
+}
+END_TEST
+
+Suite *gu_log_suite(void)
+{
+    Suite *s  = suite_create("Galera log functions");
+    TCase *tc = tcase_create("gu_log");
+
+    suite_add_tcase (s, tc);
+    tcase_add_test  (tc, gu_log_async_test);
+    return s;
+}
@@ -0,0 +1,12 @@
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+
+// $Id$
+
+#ifndef __gu_log_test__
+#define __gu_log_test__
+
+#include <check.h>
+
+extern Suite *gu_log_suite(void);
+
+#endif /* __gu_log_test__ */
@@ -8,6 +8,13 @@
 
 #include "gu_mem_pool_test.hpp"
 
+#include <map>
+#include <vector>
+
+#include <pthread.h>
+#include <string.h>
+#include <stdint.h> // uintptr_t
+
 START_TEST (unsafe)
 {
     gu::MemPoolUnsafe mp(10, 1, "unsafe");
@@ -19,6 +26,10 @@ START_TEST (unsafe)
     fail_if(NULL == buf1);
     fail_if(buf0 == buf1);
 
+    /* buffers are cache line aligned */
+    fail_if(reinterpret_cast<uintptr_t>(buf0) % 64);
+    fail_if(reinterpret_cast<uintptr_t>(buf1) % 64);
+
     mp.recycle(buf0);
 
     void* const buf2(mp.acquire());
@@ -56,6 +67,111 @@ START_TEST (safe)
 }
 END_TEST
 
+static void* safe_thread(void* arg)
+{
+    gu::MemPoolSafe& mp(*static_cast<gu::MemPoolSafe*>(arg));
+    void* bufs[TEST_SIZE/64];
+
+    for (int n(0); n < TEST_SIZE; ++n)
+    {
+        /* vary the number of buffers held to cross magazine boundaries */
+        int const num(1 + n % (sizeof(bufs)/sizeof(bufs[0])));
+
+        for (int i(0); i < num; ++i)
+        {
+            bufs[i] = mp.acquire();
+            if (NULL == bufs[i]) return arg;
+            memset(bufs[i], n, mp.buf_size());
+        }
+
+        for (int i(0); i < num; ++i) mp.recycle(bufs[i]);
+    }
+
+    return NULL;
+}
+
+START_TEST (safe_threads)
+{
+    gu::MemPoolSafe* const mp(new gu::MemPoolSafe(10, 1, "threads", 4));
+
+    /* buffer recycled by this thread is reused by it */
+    void* const buf0(mp->acquire());
+    mp->recycle(buf0);
+    fail_if(buf0 != mp->acquire());
+
+    pthread_t threads[8];
+    int const n_threads(sizeof(threads)/sizeof(threads[0]));
+
+    for (int i(0); i < n_threads; ++i)
+    {
+        fail_if(pthread_create(&threads[i], NULL, safe_thread, mp) != 0);
+    }
+
+    /* threads return their magazines on exit */
+    for (int i(0); i < n_threads; ++i)
+    {
+        void* ret;
+        fail_if(pthread_join(threads[i], &ret) != 0);
+        fail_if(ret != NULL);
+    }
+
+    log_info << *mp;
+
+    mp->recycle(buf0);
+
+    /* collects this thread's magazine and asserts that all buffers
+     * are accounted for */
+    delete mp;
+}
+END_TEST
+
+START_TEST (allocator)
+{
+    typedef std::map<int, int, std::less<int>,
+                     gu::PoolAllocator<std::pair<const int, int> > > Map;
+    Map m;
+
+    m.insert(std::make_pair(1, 1));
+    const void* const node(&*m.find(1));
+    m.erase(1);
+
+    /* node freed by this thread is reused by it */
+    m.insert(std::make_pair(2, 2));
+    fail_if(node != &*m.find(2));
+
+    for (int i(0); i < TEST_SIZE; ++i) m.insert(std::make_pair(i, i));
+    fail_if(m.size() != TEST_SIZE);
+    for (int i(0); i < TEST_SIZE; ++i) fail_if(m[i] != i);
+
+    /* arrays bypass the pool */
+    std::vector<int, gu::PoolAllocator<int> > v(TEST_SIZE, 1);
+    fail_if(v[TEST_SIZE - 1] != 1);
+}
+END_TEST
+
+START_TEST (mem_stats)
+{
+    long long const base(gu::MemStats::get(gu::MemStats::MEM_POOL));
+
+    {
+        gu::MemPoolUnsafe mp(100, 1, "stats");
+
+        void* const buf0(mp.acquire());
+        void* const buf1(mp.acquire());
+        void* const buf2(mp.acquire());
+        fail_if(gu::MemStats::get(gu::MemStats::MEM_POOL) != base + 300);
+
+        mp.recycle(buf0);
+        mp.recycle(buf1);
+        mp.recycle(buf2);
+        fail_if(gu::MemStats::get(gu::MemStats::MEM_POOL) > base + 300);
+    }
+
+    fail_if(gu::MemStats::get(gu::MemStats::MEM_POOL) != base);
+    fail_if(strcmp(gu::MemStats::name(gu::MemStats::MEM_POOL), "mem_pool"));
+}
+END_TEST
+
 Suite *gu_mem_pool_suite(void)
 {
     Suite *s = suite_create("gu::MemPool");
@@ -64,6 +180,9 @@ Suite *gu_mem_pool_suite(void)
     suite_add_tcase (s, tc_mem);
     tcase_add_test(tc_mem, unsafe);
     tcase_add_test(tc_mem, safe);
+    tcase_add_test(tc_mem, safe_threads);
+    tcase_add_test(tc_mem, allocator);
+    tcase_add_test(tc_mem, mem_stats);
 
     return s;
 }
@@ -319,6 +319,31 @@ START_TEST (ver0)
         fail("%s", e.what());
     }
 
+    /* test random access */
+    for (ssize_t i = rset_in.count() - 1; i >= 0; --i)
+    {
+        rset_in.seek(i);
+        TestRecord const rin(rset_in.next());
+        fail_if (rin != *records[i], "Record %d failed: expected %s, found %s",
+                 i, records[i]->c_str(), rin.c_str());
+
+        gu::Buf rbuf;
+        rset_in.record(i, rbuf);
+        TestRecord const rrec(static_cast<const gu::byte_t*>(rbuf.ptr),
+                              rbuf.size);
+        fail_if (rrec != *records[i], "Record %d failed: expected %s, found %s",
+                 i, records[i]->c_str(), rrec.c_str());
+    }
+    fail_if (!rset_in.indexed());
+
+    try {
+        rset_in.seek(rset_in.count());
+        fail("seek() beyond the last record did not throw");
+    }
+    catch (gu::Exception& e) {}
+
+    rset_in.rewind();
+
     /* test buf() method */
     gu::RecordSetIn<TestRecord> const rset_in_buf(rset_in.buf().ptr,
                                                   rset_in.buf().size);
@@ -366,6 +391,67 @@ START_TEST (ver0)
 }
 END_TEST
 
+/* round trip and corruption detection with check type ct */
+static void
+check_type_test (gu::RecordSet::CheckType const ct)
+{
+    TestRecord rout0(120,  "abc0");
+    TestRecord rout1(1000, "abc1");
+
+    gu::byte_t reserved[1024];
+    TestBaseName str("gu_rset_test");
+    gu::RecordSetOut<TestRecord> rset_out(reserved, sizeof(reserved), str,
+                                          ct, gu::RecordSet::VER1);
+    rset_out.append (rout0);
+    rset_out.append (rout1);
+
+    gu::RecordSet::GatherVector out_bufs;
+    size_t const out_size (rset_out.gather (out_bufs));
+
+    std::vector<gu::byte_t> in_buf;
+    for (size_t i = 0; i < out_bufs->size(); ++i)
+    {
+        const gu::byte_t* const begin
+            (reinterpret_cast<const gu::byte_t*>(out_bufs[i].ptr));
+        in_buf.insert (in_buf.end(), begin, begin + out_bufs[i].size);
+    }
+    fail_if (in_buf.size() != out_size);
+
+    gu::RecordSetIn<TestRecord> const rset_in(in_buf.data(), in_buf.size());
+    fail_if (rset_in.count() != 2);
+
+    try {
+        rset_in.checksum();
+    }
+    catch (std::exception& e)
+    {
+        fail("%s", e.what());
+    }
+
+    fail_if (rset_in.next() != rout0);
+    fail_if (rset_in.next() != rout1);
+
+    in_buf[in_buf.size() - 10] ^= 1;
+
+    try {
+        rset_in.checksum();
+        fail("checksum() didn't throw on corrupted set");
+    }
+    catch (std::exception& e) {}
+}
+
+START_TEST (xxh64)
+{
+    check_type_test (gu::RecordSet::CHECK_XXH64);
+}
+END_TEST
+
+START_TEST (crc32c_checksum)
+{
+    check_type_test (gu::RecordSet::CHECK_CRC32C);
+}
+END_TEST
+
 START_TEST (empty)
 {
     gu::RecordSetIn<TestRecord> const rset_in(0, 0);
@@ -387,6 +473,8 @@ Suite* gu_rset_suite ()
 {
     TCase* t = tcase_create ("RecordSet");
     tcase_add_test (t, ver0);
+    tcase_add_test (t, xxh64);
+    tcase_add_test (t, crc32c_checksum);
     tcase_add_test (t, empty);
     tcase_set_timeout(t, 60);
 
@@ -12,6 +12,7 @@
 
 #include "gu_atomic_test.hpp"
 #include "gu_vector_test.hpp"
+#include "gu_buffer_test.hpp"
 #include "gu_string_test.hpp"
 #include "gu_vlq_test.hpp"
 #include "gu_digest_test.hpp"
@@ -26,6 +27,8 @@
 #include "gu_histogram_test.hpp"
 #include "gu_stats_test.hpp"
 #include "gu_thread_test.hpp"
+#include "gu_thread_pool_test.hpp"
+#include "gu_io_uring_test.hpp"
 
 typedef Suite *(*suite_creator_t)(void);
 
@@ -33,6 +36,7 @@ static suite_creator_t suites[] =
 {
     gu_atomic_suite,
     gu_vector_suite,
+    gu_buffer_suite,
     gu_string_suite,
     gu_vlq_suite,
     gu_digest_suite,
@@ -47,6 +51,8 @@ static suite_creator_t suites[] =
     gu_histogram_suite,
     gu_stats_suite,
     gu_thread_suite,
+    gu_thread_pool_suite,
+    gu_io_uring_suite,
     0
 };
 
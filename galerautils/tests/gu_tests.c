@@ -15,6 +15,7 @@
 #include "gu_fnv_test.h"
 #include "gu_mmh3_test.h"
 #include "gu_spooky_test.h"
+#include "gu_xxhash_test.h"
 #include "gu_crc32c_test.h"
 #include "gu_hash_test.h"
 #include "gu_dbug_test.h"
@@ -24,6 +25,7 @@
 #include "gu_lock_step_test.h"
 #include "gu_str_test.h"
 #include "gu_utils_test.h"
+#include "gu_log_test.h"
 
 typedef Suite *(*suite_creator_t)(void);
 
@@ -35,6 +37,7 @@ static suite_creator_t suites[] =
         gu_fnv_suite,
         gu_mmh3_suite,
         gu_spooky_suite,
+        gu_xxhash_suite,
         gu_crc32c_suite,
         gu_hash_suite,
         gu_dbug_suite,
@@ -44,6 +47,7 @@ static suite_creator_t suites[] =
         gu_lock_step_suite,
         gu_str_suite,
         gu_utils_suite,
+        gu_log_suite,
         NULL
     };
 
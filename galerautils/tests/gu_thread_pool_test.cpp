@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "../src/gu_thread_pool.hpp"
+#include "../src/gu_atomic.hpp"
+
+#include "gu_thread_pool_test.hpp"
+
+class CountJob : public gu::ThreadPool::Job
+{
+public:
+
+    CountJob() : Job(), cnt_(NULL), runs_(0) {}
+
+    void set(gu::Atomic<int>& cnt) { cnt_ = &cnt; }
+    int  runs() const { return runs_; }
+
+protected:
+
+    void run() { ++runs_; ++(*cnt_); }
+
+private:
+
+    gu::Atomic<int>* cnt_;
+    int              runs_;
+};
+
+START_TEST(test_thread_pool)
+{
+    gu::ThreadPool pool(3);
+    fail_if(pool.threads() != 3, "threads: %d", pool.threads());
+
+    gu::Atomic<int> cnt(0);
+    CountJob jobs[16];
+
+    for (int round(0); round < 100; ++round)
+    {
+        for (size_t i(0); i < sizeof(jobs)/sizeof(jobs[0]); ++i)
+        {
+            jobs[i].set(cnt);
+            fail_if(!pool.submit(jobs[i]));
+        }
+
+        for (size_t i(0); i < sizeof(jobs)/sizeof(jobs[0]); ++i)
+        {
+            jobs[i].wait();
+        }
+
+        fail_if(cnt() != (round + 1) * 16, "cnt: %d", cnt());
+    }
+
+    for (size_t i(0); i < sizeof(jobs)/sizeof(jobs[0]); ++i)
+    {
+        fail_if(jobs[i].runs() != 100, "job %zu runs: %d", i, jobs[i].runs());
+    }
+
+    /* never submitted job must not block */
+    CountJob idle;
+    idle.wait();
+}
+END_TEST
+
+START_TEST(test_thread_pool_empty)
+{
+    gu::ThreadPool pool(0);
+    fail_if(pool.threads() != 0);
+
+    CountJob job;
+    fail_if(pool.submit(job));
+    job.wait();
+
+    fail_if(gu::ThreadPool::checksum_pool().threads() < 1);
+}
+END_TEST
+
+Suite* gu_thread_pool_suite()
+{
+    TCase* t = tcase_create ("test_thread_pool");
+    tcase_add_test (t, test_thread_pool);
+    tcase_add_test (t, test_thread_pool_empty);
+
+    Suite* s = suite_create ("gu::ThreadPool");
+    suite_add_tcase (s, t);
+
+    return s;
+}
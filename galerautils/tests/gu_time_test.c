@@ -3,6 +3,7 @@
 // $Id$
 
 #include <math.h>
+#include <stdlib.h> // llabs()
 #include <check.h>
 #include "gu_time_test.h"
 #include "../src/gu_time.h"
@@ -22,6 +23,26 @@ START_TEST (gu_time_test)
 }
 END_TEST
 
+START_TEST (gu_time_fast_test)
+{
+    long long const start = gu_time_monotonic();
+    long long prev = gu_time_fast();
+    long long now;
+
+    /* past calibration period */
+    do {
+        long long const t = gu_time_fast();
+        fail_if (t < prev, "gu_time_fast() went back: %lld -> %lld", prev, t);
+        prev = t;
+        now = gu_time_monotonic();
+    } while (now - start < 200000000LL);
+
+    prev = gu_time_fast();
+    fail_if (llabs(prev - now) > 1000000LL, /* 1ms */
+             "gu_time_fast(): %lld, gu_time_monotonic(): %lld", prev, now);
+}
+END_TEST
+
 Suite *gu_time_suite(void)
 {
   Suite *s  = suite_create("Galera time functions");
@@ -29,6 +50,7 @@ Suite *gu_time_suite(void)
 
   suite_add_tcase (s, tc);
   tcase_add_test  (tc, gu_time_test);
+  tcase_add_test  (tc, gu_time_fast_test);
   return s;
 }
 
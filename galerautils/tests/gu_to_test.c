@@ -11,7 +11,7 @@
 #include <stdlib.h>   // strtol(), exit(), EXIT_SUCCESS, EXIT_FAILURE
 #include <errno.h>    // errno
 #include <sys/time.h> // gettimeofday()
-#include <unistd.h>   // usleep()
+#include <unistd.h>   // usleep(), sysconf()
 #include <check.h>
 
 #include <galerautils.h>
@@ -161,17 +161,104 @@ void* run_thread(void* ctx)
     return NULL;
 }
 
+/* runs the test with the given TO spin count, returns wall clock seconds */
+static double
+run_test (ulong to_len, long spin)
+{
+    long i, ret;
+    clock_t start_clock, stop_clock;
+    struct timeval start_time, stop_time;
+    double time_spent, cpu_spent;
+    struct thread_ctx thread[thread_max];
+
+    to = gu_to_create (to_len, 0);
+    if (to != NULL) {
+        printf ("Created TO monitor of length %lu, spin %ld\n", to_len, spin);
+    }
+    else {
+        exit (-ENOMEM);
+    }
+
+    gu_to_set_spin (to, spin);
+
+    gu_mutex_lock (&start); {
+        /* initialize threads */
+        for (i = 0; (ulong)i < thread_max; i++) {
+            thread[i].thread_id    = i;
+            thread[i].stat_grabs   = 0;
+            thread[i].stat_cancels = 0;
+            thread[i].stat_fails   = 0;
+            thread[i].stat_self    = 0;
+            ret = pthread_create(&(thread[i].thread), NULL, run_thread,
+                                 &thread[i]);
+            if (ret) {
+                fprintf (stderr, "Failed to create thread %ld: %s",
+                         i, strerror(ret));
+                exit (EXIT_FAILURE);
+            }
+        }
+        start_clock = clock();
+        gettimeofday (&start_time, NULL);
+    } gu_mutex_unlock (&start); // release threads
+
+    /* wait for threads to complete and accumulate statistics */
+    gu_thread_join (thread[0].thread, NULL);
+    for (i = 1; (ulong)i < thread_max; i++) {
+        pthread_join (thread[i].thread, NULL);
+        thread[0].stat_grabs   += thread[i].stat_grabs;
+        thread[0].stat_cancels += thread[i].stat_cancels;
+        thread[0].stat_fails   += thread[i].stat_fails;
+        thread[0].stat_self    += thread[i].stat_self;
+    }
+    stop_clock = clock();
+    gettimeofday (&stop_time, NULL);
+    cpu_spent  = gu_clock_diff (stop_clock,start_clock);
+    time_spent = (stop_time.tv_sec - start_time.tv_sec) +
+        (stop_time.tv_usec - start_time.tv_usec) * 1.0e-6;
+
+    /* print statistics */
+    printf ("%llu seqnos in %.3f seconds (%.3f seqno/sec), CPU %.3f sec\n",
+            (unsigned long long)seqno_max, time_spent,
+            ((double) seqno_max)/time_spent, cpu_spent);
+    printf ("Overhead at 10000 actions/second: %.2f%%\n",
+            (cpu_spent * 10000 * 100/* for % */)/seqno_max);
+    printf ("Grabbed:        %9lu\n"
+            "Failed:         %9lu\n"
+            "Self-cancelled: %9lu\n"
+            "Canceled:       %9lu (can exceed total number of seqnos)\n",
+            thread[0].stat_grabs,   thread[0].stat_fails,
+            thread[0].stat_self, thread[0].stat_cancels
+        );
+    if (seqno_max !=
+        (thread[0].stat_grabs+thread[0].stat_fails+thread[0].stat_self)) {
+        fprintf (stderr, "Error: total number of grabbed, failed and "
+                 "self-cancelled waiters does not match total seqnos.\n");
+        exit (EXIT_FAILURE);
+    }
+
+    if (gu_to_destroy (&to)) {
+        fprintf (stderr, "Error: failed to destroy TO monitor.\n");
+        exit (EXIT_FAILURE);
+    }
+
+    return time_spent;
+}
+
 int main (int argc, char* argv[])
 {
     // minimum to length required by internal logic
     ulong to_len = cancel(0xffffffff) * cancel_offset(0xffffffff);
+    // spin count to compare blocking TO with, spinning on a single CPU
+    // only steals time from the TO holder
+    long  spin   = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 10000 : 0;
 
     errno = 0;
     if (argc > 1) seqno_max  = (1 << atol(argv[0]));
     if (argc > 2) thread_max = (1 << atol(argv[1]));
+    if (argc > 3) spin       = atol(argv[2]);
     if (errno) {
-        fprintf (stderr, "Usage: %s [seqno [threads]]\nBoth seqno and threads"
-                 "are exponents of 2^n.\n", argv[0]);
+        fprintf (stderr, "Usage: %s [seqno [threads [spin]]]\nBoth seqno and "
+                 "threads are exponents of 2^n.\n", argv[0]);
         exit(errno);
     }
     printf ("Starting with %lu threads and %llu maximum seqno.\n",
@@ -180,71 +267,18 @@ int main (int argc, char* argv[])
     /* starting with 0, enough space for all threads and cancels */
     // 4 is a magic number to get it working without excessive sleep on amd64
     to_len = to_len > thread_max ? to_len : thread_max; to_len *= 4;
-    to = gu_to_create (to_len, 0);
-    if (to != NULL) {
-        printf ("Created TO monitor of length %lu\n", to_len);
-    }
-    else {
-        exit (-ENOMEM);
-    }
 
-    /* main block */
+    /* same workload with blocking and with spinning waiters */
     {
-        long i, ret;
-        clock_t start_clock, stop_clock;
-        double time_spent;
-        struct thread_ctx thread[thread_max];
-
-        gu_mutex_lock (&start); {
-            /* initialize threads */
-            for (i = 0; (ulong)i < thread_max; i++) {
-                thread[i].thread_id    = i;
-                thread[i].stat_grabs   = 0;
-                thread[i].stat_cancels = 0;
-                thread[i].stat_fails   = 0;
-                thread[i].stat_self    = 0;
-                ret = pthread_create(&(thread[i].thread), NULL, run_thread,
-                                     &thread[i]);
-                if (ret) {
-                    fprintf (stderr, "Failed to create thread %ld: %s",
-                             i, strerror(ret));
-                    exit (EXIT_FAILURE);
-                }
-            }
-            start_clock = clock();
-        } gu_mutex_unlock (&start); // release threads
-
-        /* wait for threads to complete and accumulate statistics */
-        gu_thread_join (thread[0].thread, NULL);
-        for (i = 1; (ulong)i < thread_max; i++) {
-            pthread_join (thread[i].thread, NULL);
-            thread[0].stat_grabs   += thread[i].stat_grabs;
-            thread[0].stat_cancels += thread[i].stat_cancels;
-            thread[0].stat_fails   += thread[i].stat_fails;
-            thread[0].stat_self    += thread[i].stat_self;
-        }
-        stop_clock = clock();
-        time_spent = gu_clock_diff (stop_clock,start_clock);
-
-        /* print statistics */
-        printf ("%llu seqnos in %.3f seconds (%.3f seqno/sec)\n",
-                (unsigned long long)seqno_max, time_spent,
-                ((double) seqno_max)/time_spent);
-        printf ("Overhead at 10000 actions/second: %.2f%%\n",
-                (time_spent * 10000 * 100/* for % */)/seqno_max);
-        printf ("Grabbed:        %9lu\n"
-                "Failed:         %9lu\n"
-                "Self-cancelled: %9lu\n"
-                "Canceled:       %9lu (can exceed total number of seqnos)\n",
-                thread[0].stat_grabs,   thread[0].stat_fails,
-                thread[0].stat_self, thread[0].stat_cancels
-            );
-        if (seqno_max !=
-            (thread[0].stat_grabs+thread[0].stat_fails+thread[0].stat_self)) {
-            fprintf (stderr, "Error: total number of grabbed, failed and "
-                     "self-cancelled waiters does not match total seqnos.\n");
-            exit (EXIT_FAILURE);
+        double const block_time = run_test (to_len, 0);
+
+        if (spin > 0) {
+            double const spin_time = run_test (to_len, spin);
+
+            printf ("Spinning/blocking wall clock ratio: %.3f\n",
+                    spin_time/block_time);
         }
     }
+
     return 0;
 }
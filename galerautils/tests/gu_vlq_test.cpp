@@ -107,6 +107,29 @@ START_TEST(test_uleb128_decode)
 END_TEST
 
 
+START_TEST(test_uleb128_decode_truncated)
+{
+    // continuation bit set in the last available byte
+    for (size_t i(0); i < SizeOfArray(valarr); ++i)
+    {
+        if (valarr[i].size < 2) continue;
+
+        std::vector<gu::byte_t> buf(valarr[i].size);
+        (void)gu::uleb128_encode(valarr[i].val, &buf[0], buf.size(), 0);
+
+        unsigned long long val;
+        try
+        {
+            (void)gu::uleb128_decode(&buf[0], buf.size() - 1, 0, val);
+            fail("Decoding truncated encoding of size %zu did not throw",
+                 valarr[i].size);
+        }
+        catch (gu::Exception& e) {}
+    }
+}
+END_TEST
+
+
 START_TEST(test_uleb128_misc)
 {
     std::vector<gu::byte_t> buf(10);
@@ -272,6 +295,10 @@ Suite* gu_vlq_suite()
     tcase_add_test(tc, test_uleb128_decode);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("test_uleb128_decode_truncated");
+    tcase_add_test(tc, test_uleb128_decode_truncated);
+    suite_add_tcase(s, tc);
+
     tc = tcase_create("test_uleb128_misc");
     tcase_add_test(tc, test_uleb128_misc);
     suite_add_tcase(s, tc);
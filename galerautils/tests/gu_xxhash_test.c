@@ -0,0 +1,79 @@
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+
+// $Id$
+
+#include "gu_xxhash_test.h"
+
+#include "../src/gu_xxhash.h"
+
+#include <string.h>
+
+/* reference values from the xxHash distribution */
+static const struct
+{
+    const char* msg;
+    uint64_t    hash;
+}
+test_vectors[] =
+{
+    { "",                                        0xef46db3751d8e999ULL },
+    { "a",                                       0xd24ec4f1a98c6e5bULL },
+    { "abc",                                     0x44bc2cf5ad770999ULL },
+    { "Nobody inspects the spammish repetition", 0xfbcea83c8a378bf1ULL }
+};
+
+START_TEST (gu_xxh64_test)
+{
+    size_t i;
+
+    for (i = 0; i < sizeof(test_vectors)/sizeof(test_vectors[0]); i++)
+    {
+        const char* const msg = test_vectors[i].msg;
+        uint64_t const res = gu_xxh64 (msg, strlen(msg));
+
+        fail_if (res != test_vectors[i].hash,
+                 "%zu: expected: 0x%016llx, found: 0x%016llx", i,
+                 (unsigned long long)test_vectors[i].hash,
+                 (unsigned long long)res);
+    }
+}
+END_TEST
+
+/* multipart hash must match one-shot hash for any split of the message */
+START_TEST (gu_xxh64_parts_test)
+{
+    uint8_t buf[130];
+    size_t  len, split;
+
+    for (len = 0; len < sizeof(buf); len++) buf[len] = (uint8_t)(len * 7 + 3);
+
+    for (len = 0; len <= sizeof(buf); len++)
+    {
+        uint64_t const expected = gu_xxh64 (buf, len);
+
+        for (split = 0; split <= len; split++)
+        {
+            gu_xxh64_ctx_t ctx;
+
+            gu_xxh64_init (&ctx);
+            gu_xxh64_append (&ctx, buf, split);
+            gu_xxh64_append (&ctx, buf + split, len - split);
+
+            fail_if (gu_xxh64_get (&ctx) != expected,
+                     "len: %zu, split: %zu", len, split);
+        }
+    }
+}
+END_TEST
+
+Suite *gu_xxhash_suite(void)
+{
+  Suite *s  = suite_create("xxHash");
+  TCase *tc = tcase_create("gu_xxhash");
+
+  suite_add_tcase (s, tc);
+  tcase_add_test (tc, gu_xxh64_test);
+  tcase_add_test (tc, gu_xxh64_parts_test);
+
+  return s;
+}
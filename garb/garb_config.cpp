@@ -1,4 +1,4 @@
-/* Copyright (C) 2011-2013 Codership Oy <info@codership.com> */
+/* Copyright (C) 2011-2017 Codership Oy <info@codership.com> */
 
 #include "garb_config.hpp"
 #include "garb_logger.hpp"
@@ -33,9 +33,10 @@ namespace garb
 
 Config::Config (int argc, char* argv[])
     : daemon_  (false),
+      ist_     (false),
       name_    (GCS_ARBITRATOR_NAME),
-      address_ (),
-      group_   ("my_test_cluster"),
+      addresses_(),
+      groups_  (),
       sst_     (DEFAULT_SST),
       donor_   (),
       options_ (),
@@ -53,9 +54,12 @@ Config::Config (int argc, char* argv[])
     po::options_description config ("Configuration");
     config.add_options()
         ("daemon,d", "Become daemon")
+        ("ist",      "Store write sets in gcache and donate IST")
         ("name,n",   po::value<std::string>(&name_),    "Node name")
-        ("address,a",po::value<std::string>(&address_), "Group address")
-        ("group,g",  po::value<std::string>(&group_),   "Group name")
+        ("address,a",po::value<std::vector<std::string> >(&addresses_),
+         "Group address, can be repeated to join several groups")
+        ("group,g",  po::value<std::vector<std::string> >(&groups_),
+         "Group name, one for each group address")
         ("sst",      po::value<std::string>(&sst_),     "SST request string")
         ("donor",    po::value<std::string>(&donor_),   "SST donor name")
         ("options,o",po::value<std::string>(&options_), "GCS/GCOMM option list")
@@ -82,7 +86,8 @@ Config::Config (int argc, char* argv[])
 
     if (vm.count("help"))
     {
-        std::cerr << "\nUsage: " << argv[0] << " [options] [group address]\n"
+        std::cerr << "\nUsage: " << argv[0]
+                  << " [options] [group address...]\n"
                   << cmdline_opts << std::endl;
         exit_= true;
         return;
@@ -120,18 +125,42 @@ Config::Config (int argc, char* argv[])
         gu_throw_error(EDESTADDRREQ) << "Group name not specified";
     }
 
+    if (groups_.size() != addresses_.size())
+    {
+        gu_throw_error(EINVAL) << groups_.size() << " group names given for "
+                               << addresses_.size() << " group addresses";
+    }
+
+    for (size_t i(0); i < groups_.size(); ++i)
+    {
+        strip_quotes(groups_[i]);
+        strip_quotes(addresses_[i]);
+
+        for (size_t j(0); j < i; ++j)
+        {
+            if (groups_[j] == groups_[i])
+            {
+                gu_throw_error(EINVAL) << "Group '" << groups_[i]
+                                       << "' specified more than once";
+            }
+        }
+    }
+
     if (vm.count("daemon"))
     {
         daemon_ = true;
     }
 
+    if (vm.count("ist"))
+    {
+        ist_ = true;
+    }
+
     /* Seeing how https://svn.boost.org/trac/boost/ticket/850 is fixed long and
      * hard, it becomes clear what an undercooked piece of... cake(?) boost is.
      * - need to strip quotes manually if used in config file.
      * (which is done in a very simplistic manner, but should work for most) */
     strip_quotes(name_);
-    strip_quotes(address_);
-    strip_quotes(group_);
     strip_quotes(sst_);
     strip_quotes(donor_);
     strip_quotes(options_);
@@ -160,10 +189,16 @@ Config::Config (int argc, char* argv[])
 std::ostream& operator << (std::ostream& os, const Config& c)
 {
     os << "\n\tdaemon:  " << c.daemon()
-       << "\n\tname:    " << c.name()
-       << "\n\taddress: " << c.address()
-       << "\n\tgroup:   " << c.group()
-       << "\n\tsst:     " << c.sst()
+       << "\n\tist:     " << c.ist()
+       << "\n\tname:    " << c.name();
+
+    for (size_t i(0); i < c.groups(); ++i)
+    {
+        os << "\n\taddress: " << c.address(i)
+           << "\n\tgroup:   " << c.group(i);
+    }
+
+    os << "\n\tsst:     " << c.sst()
        << "\n\tdonor:   " << c.donor()
        << "\n\toptions: " << c.options()
        << "\n\tcfg:     " << c.cfg()
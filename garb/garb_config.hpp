@@ -1,9 +1,10 @@
-/* Copyright (C) 2011-2013 Codership Oy <info@codership.com> */
+/* Copyright (C) 2011-2017 Codership Oy <info@codership.com> */
 
 #ifndef _GARB_CONFIG_HPP_
 #define _GARB_CONFIG_HPP_
 
 #include <string>
+#include <vector>
 #include <iostream>
 
 namespace garb
@@ -19,9 +20,13 @@ public:
     ~Config () {}
 
     bool               daemon()  const { return daemon_ ; }
+    bool               ist()     const { return ist_    ; }
     const std::string& name()    const { return name_   ; }
-    const std::string& address() const { return address_; }
-    const std::string& group()   const { return group_  ; }
+
+    /* number of groups to join, i-th group name goes with i-th address */
+    size_t             groups()  const { return groups_.size(); }
+    const std::string& address(size_t i = 0) const { return addresses_[i]; }
+    const std::string& group  (size_t i = 0) const { return groups_[i];    }
     const std::string& sst()     const { return sst_    ; }
     const std::string& donor()   const { return donor_  ; }
     const std::string& options() const { return options_; }
@@ -32,9 +37,10 @@ public:
 private:
 
     bool        daemon_;
+    bool        ist_;
     std::string name_;
-    std::string address_;
-    std::string group_;
+    std::vector<std::string> addresses_;
+    std::vector<std::string> groups_;
     std::string sst_;
     std::string donor_;
     std::string options_;
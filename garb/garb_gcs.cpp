@@ -1,5 +1,5 @@
 /*
- * Copyright (C) 2011-2014 Codership Oy <info@codership.com>
+ * Copyright (C) 2011-2017 Codership Oy <info@codership.com>
  */
 
 #include "garb_gcs.hpp"
@@ -11,13 +11,14 @@ static int const REPL_PROTO_VER(127);
 static int const APPL_PROTO_VER(127);
 
 Gcs::Gcs (gu::Config&        gconf,
+          gcache_t*          gcache,
           const std::string& name,
           const std::string& address,
           const std::string& group)
 :
     closed_ (true),
     gcs_ (gcs_create (reinterpret_cast<gu_config_t*>(&gconf),
-                      NULL,
+                      gcache,
                       name.c_str(),
                       "",
                       REPL_PROTO_VER, APPL_PROTO_VER))
@@ -110,7 +111,7 @@ Gcs::request_state_transfer (const std::string& request,
         gcs_seqno_t ist_seqno = GCS_SEQNO_ILL;
         // for garb we use the lowest str_version.
         ret = gcs_request_state_transfer (gcs_, 0, req_str, req_len, donor.c_str(),
-                                          &ist_uuid, ist_seqno,
+                                          &ist_uuid, ist_seqno, 1,
                                           &order);
     }
     while (-EAGAIN == ret && (usleep(1000000), true));
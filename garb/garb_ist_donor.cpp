@@ -0,0 +1,438 @@
+/* Copyright (C) 2017 Codership Oy <info@codership.com> */
+
+#include "garb_ist_donor.hpp"
+
+#include <ist.hpp>
+
+#include <gu_byteswap.h>
+#include <gu_logger.hpp>
+#include <gu_serialize.hpp>
+#include <gu_throw.hpp>
+
+#include <wsrep_api.h>
+
+#include <sstream>
+
+#include <string.h>
+#include <signal.h>   // pthread_sigmask()
+#include <sys/wait.h> // waitpid()
+#include <unistd.h>   // fork(), execvp()
+
+namespace garb
+{
+
+static const char* const GCACHE_DIR("gcache.dir");
+
+void
+IstDonor::register_params(gu::Config& cnf)
+{
+    gcache::GCache::register_params(cnf);
+    galera::Certification::register_params(cnf);
+    galera::ist::register_params(cnf);
+}
+
+IstDonor::IstDonor (gu::Config& cnf)
+    :
+    conf_       (cnf),
+    gcache_     (cnf, ""),
+    dummy_gcs_  (),
+    service_thd_(dummy_gcs_, gcache_),
+    cert_       (cnf, service_thd_),
+    slave_pool_ (sizeof(galera::TrxHandle), 1024, "SlaveTrxHandle"),
+    uuid_       (),
+    seqno_      (GCS_SEQNO_ILL),
+    cc_seqno_   (GCS_SEQNO_ILL),
+    version_    (-1),
+    thd_        (),
+    gcs_        (0),
+    sst_        (),
+    peer_       (),
+    ist_uuid_   (),
+    first_      (GCS_SEQNO_ILL),
+    last_       (GCS_SEQNO_ILL),
+    donor_seq_  (GCS_SEQNO_ILL),
+    donors_     (1),
+    running_    (false)
+{
+    log_info << "Storing write sets in gcache to donate IST";
+}
+
+IstDonor::~IstDonor ()
+{
+    wait();
+}
+
+/* as in ReplicatorSMM::establish_protocol_versions() */
+static int
+trx_proto_ver (int const repl_proto_ver)
+{
+    switch (repl_proto_ver)
+    {
+    case 1:
+    case 2: return 1;
+    case 3:
+    case 4: return 2;
+    case 5:
+    case 6:
+    case 7:
+    case 8:
+    case 9:
+    case 10: return 3;
+    }
+
+    gu_throw_error(EPROTO) << "Unsupported replication protocol version: "
+                           << repl_proto_ver;
+    GU_DEBUG_NORETURN;
+}
+
+void
+IstDonor::conf (const gcs_act_conf_t& cc)
+{
+    if (cc.conf_id < 0) return; // non-primary
+
+    gu_uuid_t u;
+    memcpy(&u, cc.uuid, sizeof(u));
+    gu::UUID const uuid(u);
+
+    if (uuid != uuid_ || cc.seqno != seqno_)
+    {
+        /* history is discontinued, can't send from it anymore */
+        wait();
+        gcache_.seqno_reset(uuid, cc.seqno);
+        uuid_  = uuid;
+        seqno_ = cc.seqno;
+    }
+
+    /* cert index is reset on every primary configuration on every node */
+    cert_.assign_initial_position(cc.seqno, trx_proto_ver(cc.repl_proto_ver));
+    service_thd_.flush();
+
+    cc_seqno_ = cc.seqno;
+    version_  = cc.repl_proto_ver;
+}
+
+void
+IstDonor::tordered (const gcs_action& act)
+{
+    assert(act.seqno_g > seqno_);
+
+    galera::TrxHandle* const trx(galera::TrxHandle::New(slave_pool_));
+
+    try
+    {
+        galera::TrxHandleLock lock(*trx);
+
+        trx->unserialize(static_cast<const gu::byte_t*>(act.buf), act.size, 0);
+        trx->set_received(act.buf, act.seqno_l, act.seqno_g);
+        trx->set_state(galera::TrxHandle::S_REPLICATING);
+        trx->set_state(galera::TrxHandle::S_CERTIFYING);
+
+        galera::Certification::prepare(trx);
+        (void)cert_.append_trx(trx); // failed trx gets depends seqno -1
+        (void)cert_.set_trx_committed(trx); // nothing to apply here
+
+        trx->verify_checksum();
+
+        gcache_.seqno_assign(act.buf, act.seqno_g, trx->depends_seqno());
+    }
+    catch (...)
+    {
+        trx->unref();
+        throw;
+    }
+
+    seqno_ = act.seqno_g;
+    trx->unref();
+}
+
+void
+IstDonor::commit_cut (const gcs_action& act)
+{
+    gcs_seqno_t seq;
+    gu::unserialize8(static_cast<const gu::byte_t*>(act.buf), act.size, 0,
+                     seq);
+
+    /* see ReplicatorSMM::process_commit_cut() */
+    if (seq >= cc_seqno_) cert_.schedule_purge(seq);
+}
+
+/* Splits state request v1 as composed by ReplicatorSMM:
+ * "STRv1\0" | sst_len (4 bytes) | sst request | ist_len (4 bytes) | ist */
+static bool
+parse_state_request (const void* const req, size_t const len,
+                     std::string& sst, std::string& ist)
+{
+    static std::string const MAGIC("STRv1");
+
+    const char* const str(static_cast<const char*>(req));
+    size_t off(MAGIC.length() + 1);
+    uint32_t l;
+
+    if (len < off + 2 * sizeof(l) || strncmp(str, MAGIC.c_str(), off))
+    {
+        return false; // no IST part in older requests
+    }
+
+    memcpy(&l, str + off, sizeof(l));
+    off += sizeof(l);
+    if (off + gtohl(l) + sizeof(l) > len) return false;
+    sst.assign(str + off, gtohl(l));
+    off += gtohl(l);
+
+    memcpy(&l, str + off, sizeof(l));
+    off += sizeof(l);
+    if (off + gtohl(l) != len) return false;
+    ist.assign(str + off, gtohl(l));
+
+    return true;
+}
+
+int
+IstDonor::donate (Gcs& gcs, const gcs_action& act)
+{
+    std::string sst, ist;
+
+    /* arbitrator is never chosen to help, but may be the donor of split IST */
+    const void* req(act.buf);
+    ssize_t     req_len(act.size);
+    int         share;
+    int const   donors(gcs_state_req_split(&req, &req_len, &share));
+
+    if (!parse_state_request(req, req_len, sst, ist))
+    {
+        log_info << "State request does not allow IST, can't donate SST.";
+        return -ENOSYS;
+    }
+
+    std::string const method(sst.c_str());
+
+    if (method == WSREP_STATE_TRANSFER_TRIVIAL ||
+        method == WSREP_STATE_TRANSFER_NONE)
+    {
+        gcs.join(act.seqno_g); // nothing to transfer
+        return 0;
+    }
+
+    if (ist.empty())
+    {
+        log_info << "No IST request, can't donate SST.";
+        return -ENOSYS;
+    }
+
+    /* formatted as "uuid:last_applied-group_seqno|peer" */
+    std::istringstream is(ist);
+    gu::UUID      uuid;
+    gcs_seqno_t   last_applied, group_seqno;
+    std::string   peer;
+    char          c;
+
+    is >> uuid >> c >> last_applied >> c >> group_seqno >> c >> peer;
+
+    if (is.fail() || uuid != uuid_)
+    {
+        log_info << "IST request '" << ist << "' does not match history "
+                 << uuid_ << ", can't donate SST.";
+        return -ENOSYS;
+    }
+
+    try
+    {
+        gcache_.seqno_lock(last_applied + 1);
+    }
+    catch (gu::NotFound&)
+    {
+        log_info << "IST first seqno " << last_applied + 1
+                 << " not found in cache, can't donate SST.";
+        return -ENOSYS;
+    }
+
+    wait(); // for the previous donation to finish reporting
+
+    gcs_       = &gcs;
+    sst_       = sst;
+    peer_      = peer;
+    ist_uuid_  = uuid;
+    first_     = last_applied + 1;
+    last_      = cc_seqno_; // the rest joiner receives from the group
+    donor_seq_ = act.seqno_g;
+    donors_    = donors;
+
+    int const err(gu_thread_create(&thd_, NULL, run, this));
+
+    if (err)
+    {
+        gcache_.seqno_unlock();
+        log_error << "Failed to start IST donor thread: " << err << " ("
+                  << strerror(err) << ')';
+        return -err;
+    }
+
+    running_ = true;
+
+    return 0;
+}
+
+void
+IstDonor::free (const gcs_action& act)
+{
+    switch (act.type)
+    {
+    case GCS_ACT_TORDERED:
+        break; // stays in gcache until released
+    case GCS_ACT_STATE_REQ:
+        gcache_.free(const_cast<void*>(act.buf));
+        break;
+    default:
+        ::free(const_cast<void*>(act.buf));
+        break;
+    }
+}
+
+void*
+IstDonor::run (void* arg)
+{
+    static_cast<IstDonor*>(arg)->send();
+    return NULL;
+}
+
+/* Joiner's application is waiting for SST: run its SST script in donor
+ * bypass mode, the same way the application on a database donor does, to
+ * just tell it which state to expect. */
+static int
+sst_bypass (const std::string& sst, const std::string& dir,
+            const gu::UUID& uuid, gcs_seqno_t const seqno)
+{
+    size_t const m(strlen(sst.c_str()));
+    std::string const method(sst, 0, m);
+    std::string const address(m + 1 < sst.length() ?
+                              sst.c_str() + m + 1 : "");
+
+    if (method.empty() ||
+        method.find_first_not_of("abcdefghijklmnopqrstuvwxyz"
+                                 "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                 "0123456789_-") != std::string::npos)
+    {
+        log_error << "Bad SST method '" << method << "'";
+        return -EINVAL;
+    }
+
+    std::string const cmd("wsrep_sst_" + method);
+    std::ostringstream gtid;
+    gtid << uuid << ':' << seqno;
+    std::string const gtid_str(gtid.str());
+
+    const char* const argv[] = {
+        cmd.c_str(),
+        "--role",    "donor",
+        "--address", address.c_str(),
+        "--datadir", dir.c_str(),
+        "--gtid",    gtid_str.c_str(),
+        "--bypass",
+        NULL
+    };
+
+    log_info << "Bypassing SST: " << cmd << " --address " << address
+             << " --gtid " << gtid_str;
+
+    pid_t const pid(fork());
+
+    if (pid < 0)
+    {
+        int const err(errno);
+        log_error << "Failed to fork SST script: " << err << " ("
+                  << strerror(err) << ')';
+        return -err;
+    }
+
+    if (0 == pid)
+    {
+        /* garbd handles signals in a dedicated thread, see garb_main.cpp */
+        sigset_t set;
+        sigemptyset(&set);
+        pthread_sigmask(SIG_SETMASK, &set, NULL);
+
+        execvp(argv[0], const_cast<char* const*>(argv));
+        _exit(127);
+    }
+
+    int status;
+
+    while (waitpid(pid, &status, 0) < 0)
+    {
+        if (EINTR != errno)
+        {
+            int const err(errno);
+            log_error << "Failed to wait for SST script: " << err << " ("
+                      << strerror(err) << ')';
+            return -err;
+        }
+    }
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        log_error << cmd << " failed, status: " << status;
+        return -ECANCELED;
+    }
+
+    return 0;
+}
+
+void
+IstDonor::send ()
+{
+    int  err(0);
+    bool locked(true);
+
+    if (!sst_.empty())
+    {
+        std::string const dir(conf_.get(GCACHE_DIR));
+        err = sst_bypass(sst_, dir.empty() ? "." : dir, ist_uuid_, first_ - 1);
+    }
+
+    if (0 == err && first_ <= last_)
+    {
+        try
+        {
+            galera::ist::Sender sender(conf_, gcache_, peer_, version_);
+            locked = false; // sender unlocks history when done
+
+            sender.set_share(0, donors_);
+
+            log_info << "Donating IST " << first_ << '-' << last_ << " to "
+                     << peer_;
+
+            sender.send(first_, last_);
+
+            log_info << "IST to " << peer_ << " complete";
+        }
+        catch (gu::Exception& e)
+        {
+            log_error << "IST to " << peer_ << " failed: " << e.what();
+            err = -e.get_errno();
+            if (0 == err) err = -ECANCELED;
+        }
+    }
+
+    if (locked) gcache_.seqno_unlock();
+
+    try
+    {
+        gcs_->join(err < 0 ? err : donor_seq_);
+    }
+    catch (gu::Exception& e)
+    {
+        log_error << "Failed to join after IST: " << e.what();
+    }
+}
+
+void
+IstDonor::wait ()
+{
+    if (running_)
+    {
+        gu_thread_join(thd_, NULL);
+        running_ = false;
+    }
+}
+
+} /* namespace garb */
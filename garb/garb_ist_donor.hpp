@@ -0,0 +1,101 @@
+/* Copyright (C) 2017 Codership Oy <info@codership.com> */
+
+#ifndef _GARB_IST_DONOR_HPP_
+#define _GARB_IST_DONOR_HPP_
+
+#include "garb_gcs.hpp"
+
+#include <certification.hpp>
+#include <galera_gcs.hpp>
+#include <galera_service_thd.hpp>
+#include <trx_handle.hpp>
+
+#include <GCache.hpp>
+#include <gu_lock.hpp>
+
+#include <string>
+
+namespace garb
+{
+
+/*!
+ * Keeps received write sets in gcache and donates IST from there.
+ *
+ * Write sets are certified like on any other node, so that rolled back ones
+ * are sent to the joiner as such. SST is never donated: if the joiner's
+ * application is waiting for one, it is only notified that SST is bypassed
+ * by running its SST script in donor bypass mode.
+ */
+class IstDonor
+{
+public:
+
+    static void register_params(gu::Config&);
+
+    explicit IstDonor (gu::Config&);
+
+    ~IstDonor ();
+
+    /*! cache to be used by GCS to allocate action buffers */
+    gcache_t* gcache() { return reinterpret_cast<gcache_t*>(&gcache_); }
+
+    /*! resets cached history if the new primary configuration does not
+     *  continue it */
+    void conf (const gcs_act_conf_t&);
+
+    /*! certifies write set and assigns it a seqno in gcache */
+    void tordered (const gcs_action&);
+
+    /*! releases history up to commit cut */
+    void commit_cut (const gcs_action&);
+
+    /*!
+     * Starts donating IST to the joiner in a background thread, which joins
+     * the group when done.
+     *
+     * @return 0 if donation was started, negative error code to join with
+     *         otherwise
+     */
+    int donate (Gcs&, const gcs_action&);
+
+    /*! frees action buffer, actions are allocated in gcache */
+    void free (const gcs_action&);
+
+private:
+
+    static void* run (void*);
+
+    void send ();
+    void wait ();
+
+    gu::Config&                conf_;
+    gcache::GCache             gcache_;
+    galera::DummyGcs           dummy_gcs_; // service thread reports nowhere
+    galera::ServiceThd         service_thd_;
+    galera::Certification      cert_;
+    galera::TrxHandle::SlavePool slave_pool_;
+    gu::UUID                   uuid_;      // history UUID
+    gcs_seqno_t                seqno_;     // last seqno in history
+    gcs_seqno_t                cc_seqno_;  // seqno of the last primary conf
+    int                        version_;   // replication protocol version
+
+    /* current donation */
+    gu_thread_t                thd_;
+    Gcs*                       gcs_;
+    std::string                sst_;
+    std::string                peer_;
+    gu::UUID                   ist_uuid_;
+    gcs_seqno_t                first_;
+    gcs_seqno_t                last_;
+    gcs_seqno_t                donor_seq_;
+    int                        donors_;    // IST is split between
+    bool                       running_;
+
+    IstDonor (const IstDonor&);
+    IstDonor& operator= (const IstDonor&);
+
+}; /* class IstDonor */
+
+} /* namespace garb */
+
+#endif /* _GARB_IST_DONOR_HPP_ */
@@ -4,12 +4,15 @@
 #include "garb_recv_loop.hpp"
 
 #include <gu_throw.hpp>
+#include <gu_threads.h>
 
 #include <iostream>
+#include <vector>
 
 #include <stdlib.h> // exit()
 #include <unistd.h> // setsid(), chdir()
 #include <fcntl.h>  // open()
+#include <signal.h> // sigwait()
 
 namespace garb
 {
@@ -76,6 +79,81 @@ become_daemon ()
     }
 }
 
+/* SIGTERM and SIGINT are blocked in all threads and are handled here */
+static void*
+signal_thread (void* arg)
+{
+    const sigset_t* const set(static_cast<const sigset_t*>(arg));
+    int signum;
+
+    while (0 == sigwait(set, &signum))
+    {
+        log_info << "Received signal " << signum;
+        RecvLoop::close_all();
+    }
+
+    return NULL;
+}
+
+static void
+handle_signals (sigset_t& set)
+{
+    sigemptyset(&set);
+    sigaddset(&set, SIGTERM);
+    sigaddset(&set, SIGINT);
+
+    int err(pthread_sigmask(SIG_BLOCK, &set, NULL));
+    if (err)
+    {
+        gu_throw_error(err) << "Failed to block signals";
+    }
+
+    gu_thread_t thd;
+    err = gu_thread_create(&thd, NULL, signal_thread, &set);
+    if (err)
+    {
+        gu_throw_error(err) << "Failed to create signal handling thread";
+    }
+}
+
+struct GroupLoop
+{
+    const Config* config_;
+    size_t        group_;
+    gu_thread_t   thd_;
+    bool          failed_;
+};
+
+static bool
+run_loop (const Config& config, size_t const group)
+{
+    try
+    {
+        RecvLoop loop (config, group);
+        return true;
+    }
+    catch (std::exception& e)
+    {
+        log_fatal << "Exception in receive loop of group '"
+                  << config.group(group) << "': " << e.what();
+    }
+    catch (...)
+    {
+        log_fatal << "Exception in receive loop of group '"
+                  << config.group(group) << "'.";
+    }
+
+    return false;
+}
+
+static void*
+group_thread (void* arg)
+{
+    GroupLoop* const gl(static_cast<GroupLoop*>(arg));
+    gl->failed_ = !run_loop(*gl->config_, gl->group_);
+    return NULL;
+}
+
 int
 main (int argc, char* argv[])
 {
@@ -86,21 +164,47 @@ main (int argc, char* argv[])
 
     if (config.daemon()) become_daemon();
 
-    try
+    static sigset_t signals; // must outlive the signal thread
+    handle_signals(signals);
+
+    if (1 == config.groups())
     {
-        RecvLoop loop (config);
-        return 0;
+        return (run_loop(config, 0) ? 0 : EXIT_FAILURE);
     }
-    catch (std::exception& e)
+
+    /* Every group runs its own receive loop in a separate thread, failure
+     * to join one of them does not affect the others. */
+    std::vector<GroupLoop> loops(config.groups());
+
+    for (size_t i(0); i < loops.size(); ++i)
     {
-        log_fatal << "Exception in creating receive loop: " << e.what();
+        GroupLoop& gl(loops[i]);
+
+        gl.config_ = &config;
+        gl.group_  = i;
+        gl.failed_ = true;
+
+        int const err(gu_thread_create(&gl.thd_, NULL, group_thread, &gl));
+        if (err)
+        {
+            log_fatal << "Failed to create thread for group '"
+                      << config.group(i) << "': " << err
+                      << " (" << strerror(err) << ")";
+            RecvLoop::close_all();
+            loops.resize(i);
+            break;
+        }
     }
-    catch (...)
+
+    bool failed(loops.size() < config.groups());
+
+    for (size_t i(0); i < loops.size(); ++i)
     {
-        log_fatal << "Exception in creating receive loop.";
+        gu_thread_join(loops[i].thd_, NULL);
+        failed = failed || loops[i].failed_;
     }
 
-    return EXIT_FAILURE;
+    return (failed ? EXIT_FAILURE : 0);
 }
 
 } /* namespace garb */
@@ -1,52 +1,77 @@
-/* Copyright (C) 2011-2014 Codership Oy <info@codership.com> */
+/* Copyright (C) 2011-2017 Codership Oy <info@codership.com> */
 
 #include "garb_recv_loop.hpp"
 
-#include <signal.h>
+#include <gu_lock.hpp>
+
+#include <set>
 
 namespace garb
 {
 
-static Gcs*
-global_gcs(0);
+static const char* const GCACHE_NAME("gcache.name");
+
+/* connections of running receive loops, for close_all() */
+static gu::Mutex      loops_mtx;
+static std::set<Gcs*> loops_gcs;
+static bool           loops_closed(false);
 
 void
-signal_handler (int signum)
+RecvLoop::close_all()
 {
-    log_info << "Received signal " << signum;
-    global_gcs->close();
+    gu::Lock lock(loops_mtx);
+
+    loops_closed = true;
+
+    for (std::set<Gcs*>::iterator i(loops_gcs.begin()); i != loops_gcs.end();
+         ++i)
+    {
+        (*i)->close();
+    }
 }
 
+RecvLoop::ParseOptions::ParseOptions(gu::Config&   cnf,
+                                     const Config& config,
+                                     size_t const  group)
+{
+    cnf.parse(config.options());
 
-RecvLoop::RecvLoop (const Config& config)
+    /* groups must not share the cache file */
+    if (config.groups() > 1 && config.ist() && !cnf.is_set(GCACHE_NAME))
+    {
+        cnf.set(GCACHE_NAME, config.group(group) + ".cache");
+    }
+}
+
+RecvLoop::RecvLoop (const Config& config, size_t const group)
     :
     config_(config),
+    group_ (group),
     gconf_ (),
     params_(gconf_),
-    parse_ (gconf_, config_.options()),
-    gcs_   (gconf_, config_.name(), config_.address(), config_.group())
+    parse_ (gconf_, config_, group_),
+    ist_   (gconf_, config_.ist()),
+    gcs_   (gconf_, ist_.ptr_ ? ist_.ptr_->gcache() : NULL,
+            config_.name(), config_.address(group_), config_.group(group_)),
+    reg_   (gcs_)
 {
-    /* set up signal handlers */
-    global_gcs = &gcs_;
-
-    struct sigaction sa;
+    loop();
+}
 
-    memset (&sa, 0, sizeof(sa));
-    sa.sa_handler = signal_handler;
+RecvLoop::Registration::Registration(Gcs& gcs) : gcs_(gcs)
+{
+    gu::Lock lock(loops_mtx);
 
-    if (sigaction (SIGTERM, &sa, NULL))
-    {
-        gu_throw_error(errno) << "Falied to install signal hadler for signal "
-                              << "SIGTERM";
-    }
+    loops_gcs.insert(&gcs_);
 
-    if (sigaction (SIGINT, &sa, NULL))
-    {
-        gu_throw_error(errno) << "Falied to install signal hadler for signal "
-                              << "SIGINT";
-    }
+    /* close_all() was called while we were connecting */
+    if (loops_closed) gcs_.close();
+}
 
-    loop();
+RecvLoop::Registration::~Registration()
+{
+    gu::Lock lock(loops_mtx);
+    loops_gcs.erase(&gcs_);
 }
 
 void
@@ -61,22 +86,30 @@ RecvLoop::loop()
         switch (act.type)
         {
         case GCS_ACT_TORDERED:
-            if (gu_unlikely(!(act.seqno_g & 127)))
-                /* == report_interval_ of 128 */
+            if (ist_.ptr_) ist_.ptr_->tordered (act);
+
+            if (gu_unlikely(!(act.seqno_g % GCS_ARBITRATOR_REPORT_INTERVAL)))
             {
                 gcs_.set_last_applied (act.seqno_g);
             }
             break;
         case GCS_ACT_COMMIT_CUT:
+            if (ist_.ptr_) ist_.ptr_->commit_cut (act);
             break;
         case GCS_ACT_STATE_REQ:
-            gcs_.join (-ENOSYS); /* we can't donate state */
+        {
+            /* we can't donate state, only IST from cache */
+            int const err(ist_.ptr_ ? ist_.ptr_->donate (gcs_, act) : -ENOSYS);
+            if (err < 0) gcs_.join (err);
             break;
+        }
         case GCS_ACT_CONF:
         {
             const gcs_act_conf_t* const cc
                 (reinterpret_cast<const gcs_act_conf_t*>(act.buf));
 
+            if (ist_.ptr_) ist_.ptr_->conf (*cc);
+
             if (cc->conf_id > 0) /* PC */
             {
                 if (GCS_NODE_STATE_PRIM == cc->my_state)
@@ -87,7 +120,8 @@ RecvLoop::loop()
             }
             else if (cc->memb_num == 0) // SELF-LEAVE after closing connection
             {
-                log_info << "Exiting main loop";
+                log_info << "Exiting main loop of group '"
+                         << config_.group(group_) << "'";
                 return;
             }
 
@@ -110,7 +144,10 @@ RecvLoop::loop()
 
         if (act.buf)
         {
-            free (const_cast<void*>(act.buf));
+            if (ist_.ptr_)
+                ist_.ptr_->free (act);
+            else
+                free (const_cast<void*>(act.buf));
         }
     }
 }
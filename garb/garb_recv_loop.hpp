@@ -1,10 +1,11 @@
-/* Copyright (C) 2011-2014 Codership Oy <info@codership.com> */
+/* Copyright (C) 2011-2017 Codership Oy <info@codership.com> */
 
 #ifndef _GARB_RECV_LOOP_HPP_
 #define _GARB_RECV_LOOP_HPP_
 
 #include "garb_gcs.hpp"
 #include "garb_config.hpp"
+#include "garb_ist_donor.hpp"
 
 #include <gu_throw.hpp>
 #include <gu_asio.hpp>
@@ -14,19 +15,29 @@
 namespace garb
 {
 
+/*!
+ * Joins the group with the given index in config and runs until leaving it.
+ * Every group gets its own receive loop with its own configuration,
+ * several of them can run in the same process in separate threads.
+ */
 class RecvLoop
 {
 public:
 
-    RecvLoop (const Config&);
+    RecvLoop (const Config&, size_t group = 0);
 
     ~RecvLoop () {}
 
+    /*! Closes group connections of all receive loops in the process,
+     *  including those that are yet to connect. */
+    static void close_all();
+
 private:
 
     void loop();
 
     const Config& config_;
+    size_t const  group_;
     gu::Config    gconf_;
 
     struct RegisterParams
@@ -38,20 +49,46 @@ private:
             {
                 gu_throw_fatal << "Error initializing GCS parameters";
             }
+            IstDonor::register_params(cnf);
         }
     }
         params_;
 
     struct ParseOptions
     {
-        ParseOptions(gu::Config& cnf, const std::string& opt)
-        {
-            cnf.parse(opt);
-        }
+        ParseOptions(gu::Config& cnf, const Config& config, size_t group);
     }
         parse_;
 
+    /* must outlive gcs_ which allocates actions in its gcache */
+    struct Donor
+    {
+        Donor(gu::Config& cnf, bool enable)
+            : ptr_(enable ? new IstDonor(cnf) : 0) {}
+        ~Donor() { delete ptr_; }
+        IstDonor* const ptr_;
+    private:
+        Donor(const Donor&);
+        Donor& operator=(const Donor&);
+    }
+        ist_;
+
     Gcs           gcs_;
+
+    /* makes gcs_ reachable by close_all() while it exists */
+    struct Registration
+    {
+        Registration(Gcs& gcs);
+        ~Registration();
+        Gcs& gcs_;
+    private:
+        Registration(const Registration&);
+        Registration& operator=(const Registration&);
+    }
+        reg_;
+
+    RecvLoop (const RecvLoop&);
+    RecvLoop& operator= (const RecvLoop&);
 }; /* RecvLoop */
 
 } /* namespace garb */
@@ -7,6 +7,7 @@
 
 #include <gu_logger.hpp>
 
+#include <algorithm>
 #include <cerrno>
 #include <unistd.h>
 
@@ -15,14 +16,23 @@ namespace gcache
     void
     GCache::reset()
     {
+        unpacked_clear();
+        discard_page_buffers();
+
         mem.reset();
         rb.reset();
         ps.reset();
 
         mallocs  = 0;
         reallocs = 0;
+        rb_overflows = 0;
+        large_buffers = 0;
 
+        seqno_pins.clear();
+        seqno_release_pending = SEQNO_NONE;
+        seqno_param_pin = SEQNO_NONE;
         seqno_locked   = SEQNO_NONE;
+        seqno_read_next= SEQNO_NONE;
         seqno_max      = SEQNO_NONE;
         seqno_released = SEQNO_NONE;
         gid            = gu::UUID();
@@ -44,38 +54,215 @@ namespace gcache
         gid       (),
         mem       (params.mem_size(), seqno2ptr),
         rb        (params.rb_name(), params.rb_size(), seqno2ptr, gid,
-                   params.recover()),
+                   params.recover(), params.huge_pages(), params.numa_node(),
+                   params.recover() && params.recover_bg()),
         ps        (params.dir_name(),
                    params.keep_pages_size(),
                    params.page_size(),
                    /* keep last page if PS is the only storage */
-                   !((params.mem_size() + params.rb_size()) > 0)),
+                   !((params.mem_size() + params.rb_size()) > 0),
+                   params.page_prealloc(),
+                   params.page_flush()),
         mallocs   (0),
         reallocs  (0),
         frees     (0),
+        rb_overflows(0),
+        large_buffers(0),
+        recovery_thd(),
+        recovery_thd_started(false),
+        recovery_cond(),
+        recovering(params.recover() && params.recover_bg()),
+        reset_pending(false),
+        reset_gid (),
+        reset_seqno(SEQNO_NONE),
+        lock_thd  (),
+        lock_thd_started(false),
+        lock_stop (false),
+        rb_locked (0),
+        seqno_pins(),
+        seqno_release_pending(SEQNO_NONE),
+        seqno_param_pin(SEQNO_NONE),
         seqno_locked(SEQNO_NONE),
+        seqno_read_next(SEQNO_NONE),
         seqno_max   (seqno2ptr.empty() ?
                      SEQNO_NONE : seqno2ptr.rbegin()->first),
         seqno_released(seqno_max)
 #ifndef NDEBUG
         ,buf_tracker()
 #endif
-    {}
+        ,zbuf     ()
+        ,unpacked ()
+    {
+        if (recovering)
+        {
+            log_info << "Recovering GCache ring buffer in the background";
+            int const err(gu_thread_create(&recovery_thd, NULL, recovery_func,
+                                           this));
+            if (err)
+            {
+                log_warn << "Failed to start GCache recovery thread: " << err
+                         << " (" << strerror(err) << "), recovering in place";
+                recovery_func(this);
+            }
+            else
+            {
+                recovery_thd_started = true;
+            }
+        }
+
+        if (params.lock_in_memory())
+        {
+            rb.lock_in_memory();
+
+            int const err(gu_thread_create(&lock_thd, NULL, lock_func, this));
+            if (err)
+            {
+                log_warn << "Failed to start GCache locking thread: " << err
+                         << " (" << strerror(err) << "), locking in place";
+                lock_func(this);
+            }
+            else
+            {
+                lock_thd_started = true;
+            }
+        }
+    }
+
+    void*
+    GCache::lock_func (void* arg)
+    {
+        GCache* const gc(static_cast<GCache*>(arg));
+
+        static size_t const CHUNK(64 << 20); // to check for shutdown and report
+
+        size_t const total(gc->rb.mmap_size());
+        bool         lock(true);
+        size_t       reported(0); // progress reported, tenths
+
+        log_info << "Locking GCache ring buffer in memory, " << total
+                 << " bytes";
+
+        for (size_t offset(0); offset < total; offset += CHUNK)
+        {
+            size_t const len(std::min(total - offset, CHUNK));
+
+            if (!gc->rb.lock_chunk(offset, len, lock) && lock)
+            {
+                log_warn << "GCache ring buffer will only be faulted in, not "
+                         << "locked: consider raising RLIMIT_MEMLOCK";
+                lock = false;
+            }
+
+            gu::Lock l(gc->mtx);
+
+            if (gc->lock_stop) break;
+
+            gc->rb_locked = offset + len;
+
+            size_t const progress(gc->rb_locked * 10 / total);
+            if (progress > reported)
+            {
+                reported = progress;
+                log_info << "GCache ring buffer " << (lock ? "locked" :
+                                                      "faulted in")
+                         << ": " << progress * 10 << '%';
+            }
+        }
+
+        return 0;
+    }
+
+    void*
+    GCache::recovery_func (void* arg)
+    {
+        GCache* const gc(static_cast<GCache*>(arg));
+
+        try
+        {
+            gc->rb.open(true);
+        }
+        catch (std::exception& e)
+        {
+            log_warn << "GCache ring buffer recovery failed: " << e.what();
+        }
+
+        gu::Lock lock(gc->mtx);
+
+        gc->seqno_max = gc->seqno2ptr.empty() ?
+            SEQNO_NONE : gc->seqno2ptr.rbegin()->first;
+        gc->seqno_released = gc->seqno_max;
+        gc->recovering = false;
+
+        log_info << "GCache ring buffer recovery done, seqnos "
+                 << (gc->seqno2ptr.empty() ? SEQNO_NONE :
+                     gc->seqno2ptr.begin()->first)
+                 << " - " << gc->seqno_max;
+
+        if (gc->reset_pending)
+        {
+            gc->reset_pending = false;
+            gc->seqno_reset_locked(gc->reset_gid, gc->reset_seqno);
+        }
+
+        gc->recovery_cond.broadcast();
+
+        return 0;
+    }
 
     GCache::~GCache ()
     {
+        if (recovery_thd_started) gu_thread_join(recovery_thd, NULL);
+
+        if (lock_thd_started)
+        {
+            {
+                gu::Lock lock(mtx);
+                lock_stop = true;
+            }
+            gu_thread_join(lock_thd, NULL);
+        }
+
         gu::Lock lock(mtx);
+
+        unpacked_clear();
+        discard_page_buffers(); // let page store remove the files
+
         log_debug << "\n" << "GCache mallocs : " << mallocs
                   << "\n" << "GCache reallocs: " << reallocs
                   << "\n" << "GCache frees   : " << frees;
     }
 
+    void
+    GCache::stats_get (Stats& stats) const
+    {
+        /* the mapping does not change, this may take a while */
+        stats.rb_resident  = rb.resident();
+
+        gu::Lock lock(mtx);
+
+        /* don't wait for recovery, stats are polled by monitoring */
+        stats.rb_free      = recovering ? 0 : rb.size_free();
+        stats.rb_used      = recovering ? 0 : rb.size_used();
+        stats.rb_trail     = recovering ? 0 : rb.size_trail();
+        stats.pages        = ps.total_pages();
+        stats.pages_bytes  = ps.total_size();
+        stats.evicted      = recovering ? 0 : seqno2ptr.erased();
+        stats.rb_overflows = rb_overflows;
+        stats.large_buffers= large_buffers;
+        stats.rb_locked    = rb_locked;
+    }
+
     /*! prints object properties */
     void print (std::ostream& os) {}
 }
 
 #include "gcache.h"
 
+void gcache_register_params (gu_config_t* conf)
+{
+    gcache::GCache::register_params(*reinterpret_cast<gu::Config*>(conf));
+}
+
 gcache_t* gcache_create (gu_config_t* conf, const char* data_dir)
 {
     gcache::GCache* gc = new gcache::GCache (
@@ -13,12 +13,13 @@
 #include <gu_types.hpp>
 #include <gu_lock.hpp> // for gu::Mutex and gu::Cond
 #include <gu_config.hpp>
+#include <gu_threads.h>
 
 #include <string>
 #include <iostream>
-#ifndef NDEBUG
+#include <vector>
+#include <map>
 #include <set>
-#endif
 #include <stdint.h>
 
 namespace gcache
@@ -78,7 +79,7 @@ namespace gcache
         int64_t seqno_min() const
         {
             gu::Lock lock(mtx);
-            if (gu_likely(!seqno2ptr.empty()))
+            if (gu_likely(!seqno2ptr.empty() && !recovering))
                 return seqno2ptr.begin()->first;
             else
                 return -1;
@@ -86,10 +87,25 @@ namespace gcache
 
         /*!
          * Move lock to a given seqno.
-         * @throws gu::NotFound if seqno is not in the cache.
+         * @throws gu::NotFound if seqno is not in the cache or the cache
+         *         is still being recovered.
          */
         void  seqno_lock (int64_t const seqno_g);
 
+        /*!
+         * Pins history from seqno_g on: buffers with this and greater seqnos
+         * are not released, and so can't be discarded, until seqno_unpin().
+         * Unlike seqno_lock() any number of pins can be held at a time,
+         * e.g. by online backups that replay history from their snapshot
+         * seqno while the node keeps applying.
+         * Releases requested past the lowest pin are carried out on unpin.
+         * @throws gu::NotFound if seqno_g has been released already
+         */
+        void  seqno_pin (int64_t seqno_g);
+
+        /*! Drops one pin taken by seqno_pin(seqno_g). */
+        void  seqno_unpin (int64_t seqno_g);
+
         /*!          DEPRECATED
          * Get pointer to buffer identified by seqno.
          * Moves lock to the given seqno.
@@ -155,6 +171,10 @@ namespace gcache
          * until either vector length or seqno map is exhausted.
          * Moves seqno lock to start.
          *
+         * Consecutive calls are treated as a sequential scan: ring buffer
+         * pages of the returned buffers are read ahead and those of the
+         * previous batch are let go, seqno_unlock() ends the scan.
+         *
          * @retval number of buffers filled (<= v.size())
          */
         size_t seqno_get_buffers (std::vector<Buffer>& v, int64_t start);
@@ -167,6 +187,30 @@ namespace gcache
         /*! @throws NotFound */
         void param_set (const std::string& key, const std::string& val);
 
+        struct Stats
+        {
+            size_t    rb_free;      // ring buffer bytes free
+            size_t    rb_used;      // ring buffer bytes in use
+            size_t    rb_trail;     // unused ring buffer tail after wrap
+            size_t    pages;        // page store pages
+            size_t    pages_bytes;  // page store size on disk
+            long long evicted;      // seqnos dropped from history
+            long long rb_overflows; // allocations ring buffer could not fit
+            long long large_buffers;// allocations put in pages by size
+            size_t    rb_locked;    // ring buffer bytes locked or faulted in
+            size_t    rb_resident;  // ring buffer bytes in memory
+        };
+
+        void stats_get (Stats& stats) const;
+
+        /*! true while the ring buffer is recovered in the background:
+         *  history is not available for IST, other calls block until done */
+        bool recovering_bg() const
+        {
+            gu::Lock lock(mtx);
+            return recovering;
+        }
+
         static size_t const PREAMBLE_LEN;
 
     private:
@@ -192,11 +236,23 @@ namespace gcache
             size_t rb_size()             const { return rb_size_;         }
             size_t page_size()           const { return page_size_;       }
             size_t keep_pages_size()     const { return keep_pages_size_; }
+            size_t page_prealloc()       const { return page_prealloc_;   }
+            bool   page_flush()          const { return page_flush_;      }
+            bool   page_compression()    const { return page_compression_;}
+            bool   huge_pages()          const { return huge_pages_;      }
+            bool   lock_in_memory()      const { return lock_in_memory_;  }
+            int    numa_node()           const { return numa_node_;       }
             bool   recover()             const { return recover_;         }
+            bool   recover_bg()          const { return recover_bg_;      }
+            size_t large_buffer_size()   const { return large_buffer_size_;}
 
             void mem_size        (size_t s) { mem_size_        = s; }
             void page_size       (size_t s) { page_size_       = s; }
             void keep_pages_size (size_t s) { keep_pages_size_ = s; }
+            void page_prealloc   (size_t n) { page_prealloc_   = n; }
+            void page_flush      (bool   b) { page_flush_      = b; }
+            void page_compression(bool   b) { page_compression_= b; }
+            void large_buffer_size(size_t s) { large_buffer_size_ = s; }
 
         private:
 
@@ -206,10 +262,22 @@ namespace gcache
             size_t      const rb_size_;
             size_t            page_size_;
             size_t            keep_pages_size_;
+            size_t            page_prealloc_;
+            bool              page_flush_;
+            bool              page_compression_;
+            bool        const huge_pages_;
+            bool        const lock_in_memory_;
+            int         const numa_node_;
             bool        const recover_;
+            bool        const recover_bg_;
+            size_t            large_buffer_size_;
         }
             params;
 
+        /* Local write sets are not allocated in the cache: buffers come from
+         * the GCS receive thread only. Beyond that mtx is taken by seqno
+         * assignment (serialized by the local monitor), the service thread
+         * (seqno_release() in batches) and IST senders. */
         gu::Mutex       mtx;
         gu::Cond        cond;
 
@@ -223,8 +291,46 @@ namespace gcache
         long long       mallocs;
         long long       reallocs;
         long long       frees;
+        long long       rb_overflows;
+        long long       large_buffers;
+
+        /* gcache.recover_background: ring buffer is opened and recovered in
+         * recovery_thd, seqno_reset() coming in the meantime is deferred */
+        gu_thread_t     recovery_thd;
+        bool            recovery_thd_started;
+        gu::Cond        recovery_cond;
+        bool            recovering;
+        bool            reset_pending;
+        gu::UUID        reset_gid;
+        seqno_t         reset_seqno;
+
+        void recovery_wait (gu::Lock& lock) const
+        {
+            while (gu_unlikely(recovering)) lock.wait(recovery_cond);
+        }
+
+        void seqno_reset_locked (const gu::UUID& gid, seqno_t seqno);
+        bool seqno_truncate     (seqno_t seqno);
+
+        static void* recovery_func (void*);
+
+        /* gcache.lock_in_memory: ring buffer is faulted in and locked in
+         * lock_thd, rb_locked bytes so far */
+        gu_thread_t     lock_thd;
+        bool            lock_thd_started;
+        bool            lock_stop;
+        size_t          rb_locked;
+
+        static void* lock_func (void*);
+
+        /* seqno_pin() holders; seqno_release() stops short of the lowest
+         * pin and remembers how far it was asked to go */
+        std::multiset<seqno_t> seqno_pins;
+        seqno_t                seqno_release_pending;
+        seqno_t                seqno_param_pin; // set by gcache.pin_seqno
 
         int64_t         seqno_locked;
+        int64_t         seqno_read_next; // where sequential history read goes
         int64_t         seqno_max;
         int64_t         seqno_released;
 
@@ -235,6 +341,33 @@ namespace gcache
         /* returns true when successfully discards all seqnos up to s */
         bool discard_seqno (int64_t s);
 
+        /* buffers of gcache.large_buffer_size and up bypass the ring buffer,
+         * go to pages and are kept there like compressed ones, within
+         * gcache.keep_pages_size or, if that is 0, gcache.size */
+        bool large_buffer (size_type const size) const
+        {
+            return (params.large_buffer_size() > 0 &&
+                    size >= params.large_buffer_size());
+        }
+
+        /* With gcache.page_compression released page buffers are not
+         * discarded right away but deflated and kept for IST while the page
+         * store stays within gcache.keep_pages_size. Readers get inflated
+         * copies which live in unpacked until the seqno lock moves past them
+         * (so, like the lock itself, this assumes one history reader at a
+         * time). All of the below must be called with mtx locked. */
+        typedef std::map<seqno_t, BufferHeader*> unpacked_t;
+
+        std::vector<uint8_t> zbuf;     // scratch space for compression
+        unpacked_t           unpacked; // inflated copies of page buffers
+
+        void        keep_page_buffer    (BufferHeader* bh, size_t limit);
+        void        compress_page_buffer(BufferHeader* bh);
+        void        discard_page_buffers();
+        const void* unpack_buffer       (const void* ptr);
+        void        unpacked_trim       (seqno_t s); // frees copies below s
+        void        unpacked_clear      ();
+
         // disable copying
         GCache (const GCache&);
         GCache& operator = (const GCache&);
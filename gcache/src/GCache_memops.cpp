@@ -4,7 +4,10 @@
 
 #include "GCache.hpp"
 
+#include <zlib.h>
+
 #include <cassert>
+#include <cstring>
 
 namespace gcache
 {
@@ -45,6 +48,84 @@ namespace gcache
         return true;
     }
 
+    void
+    GCache::compress_page_buffer (BufferHeader* const bh)
+    {
+        assert(BH_is_released(bh));
+        assert(!BH_is_compressed(bh));
+
+        /* compressed buffer payload: uint64_t original size + deflate data */
+        uLong const raw_size(bh->size - sizeof(BufferHeader));
+        uLongf      z_size(compressBound(raw_size));
+
+        if (zbuf.size() < z_size) zbuf.resize(z_size);
+
+        if (Z_OK != compress2(&zbuf[0], &z_size,
+                              reinterpret_cast<const Bytef*>(bh + 1), raw_size,
+                              Z_BEST_SPEED))
+        {
+            return;
+        }
+
+        size_type const size(sizeof(BufferHeader) + sizeof(uint64_t) + z_size);
+
+        if (size >= bh->size) return; /* not worth it */
+
+        uint8_t* const ptr(static_cast<uint8_t*>(ps.malloc(size)));
+
+        if (0 == ptr) return;
+
+        BufferHeader* const zbh(ptr2BH(ptr));
+        uint64_t const      orig_size(raw_size);
+
+        zbh->seqno_g = bh->seqno_g;
+        zbh->seqno_d = bh->seqno_d;
+        zbh->flags  |= BUFFER_RELEASED | BUFFER_COMPRESSED;
+
+        ::memcpy(ptr, &orig_size, sizeof(orig_size));
+        ::memcpy(ptr + sizeof(orig_size), &zbuf[0], z_size);
+
+        seqno2ptr[bh->seqno_g] = ptr;
+
+        bh->seqno_g = SEQNO_ILL;
+        ps.discard (bh);
+    }
+
+    void
+    GCache::keep_page_buffer (BufferHeader* const bh, size_t const limit)
+    {
+        seqno_t const seqno(bh->seqno_g);
+
+        if (params.page_compression()) compress_page_buffer (bh);
+
+        /* make room by dropping the oldest history, but don't go past the
+         * buffer being freed: the caller may still iterate over the rest */
+        while (ps.total_size() > limit &&
+               !seqno2ptr.empty() && seqno2ptr.begin()->first <= seqno &&
+               discard_seqno (seqno2ptr.begin()->first))
+        {}
+    }
+
+    void
+    GCache::discard_page_buffers ()
+    {
+        for (seqno2ptr_iter_t i(seqno2ptr.begin()); i != seqno2ptr.end();)
+        {
+            BufferHeader* const bh(ptr2BH(i->second));
+
+            if (BUFFER_IN_PAGE == bh->store && BH_is_released(bh))
+            {
+                seqno2ptr.erase (i++);
+                bh->seqno_g = SEQNO_ILL;
+                ps.discard (bh);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
     void*
     GCache::malloc (ssize_type const s)
     {
@@ -57,14 +138,27 @@ namespace gcache
             size_type const size(s + sizeof(BufferHeader));
 
             gu::Lock lock(mtx);
+            recovery_wait(lock);
 
             mallocs++;
 
             ptr = mem.malloc(size);
 
+            /* a single huge buffer in the ring would push out the history of
+             * thousands of small ones and leave a big trail on wrap */
+            if (0 == ptr && large_buffer(size))
+            {
+                ptr = ps.malloc(size);
+                if (0 != ptr) large_buffers++;
+            }
+
             if (0 == ptr) ptr = rb.malloc(size);
 
-            if (0 == ptr) ptr = ps.malloc(size);
+            if (0 == ptr)
+            {
+                rb_overflows++;
+                ptr = ps.malloc(size);
+            }
 
 #ifndef NDEBUG
             if (0 != ptr) buf_tracker.insert (ptr);
@@ -113,7 +207,23 @@ namespace gcache
         case BUFFER_IN_PAGE:
             if (gu_likely(bh->seqno_g > 0))
             {
-                discard_seqno (bh->seqno_g);
+                if (large_buffer(bh->size))
+                {
+                    /* keep it until the ring history passes it, so that
+                     * the history has no hole in the middle */
+                    keep_page_buffer (bh, params.keep_pages_size() > 0 ?
+                                      params.keep_pages_size() :
+                                      params.rb_size());
+                }
+                else if (params.page_compression() &&
+                         params.keep_pages_size() > 0)
+                {
+                    keep_page_buffer (bh, params.keep_pages_size());
+                }
+                else
+                {
+                    discard_seqno (bh->seqno_g);
+                }
             }
             else
             {
@@ -5,8 +5,13 @@
 #include "gcache_bh.hpp"
 #include "GCache.hpp"
 
+#include <zlib.h>
+
+#include <algorithm> // std::min()
 #include <cerrno>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 
 #include <sched.h> // sched_yeild()
 
@@ -21,16 +26,62 @@ namespace gcache
     {
         gu::Lock lock(mtx);
 
+        if (recovering && !reset_pending)
+        {
+            /* whether history survives depends on what is recovered,
+             * let recovery thread decide */
+            reset_pending = true;
+            reset_gid     = g;
+            reset_seqno   = s;
+            return;
+        }
+
+        recovery_wait(lock);
+        seqno_reset_locked(g, s);
+    }
+
+    void
+    GCache::seqno_reset_locked (const gu::UUID& g, seqno_t const s)
+    {
         assert(seqno2ptr.empty() || seqno_max == seqno2ptr.rbegin()->first);
 
         if (g == gid && s == seqno_max) return;
 
+        if (g == gid && !seqno2ptr.empty() &&
+            s >= seqno2ptr.begin()->first && s < seqno_max &&
+            seqno_truncate(s)) return;
+
         log_info << "GCache history reset: " << gid << ':' << seqno_max
                  << " -> " << g << ':' << s;
 
+        if (gu_unlikely(!seqno_pins.empty()))
+        {
+            log_warn << "History reset invalidates " << seqno_pins.size()
+                     << " seqno pin(s), lowest: " << *seqno_pins.begin();
+
+            seqno_pins.clear();
+            seqno_param_pin = SEQNO_NONE;
+
+            /* carry out releases deferred by the pins: all seqno'd buffers
+             * must be released before the stores can be reset */
+            for (seqno2ptr_iter_t i(seqno2ptr.upper_bound(seqno_released));
+                 i != seqno2ptr.end() && i->first <= seqno_release_pending;)
+            {
+                BufferHeader* const bh(ptr2BH(i->second));
+                ++i; /* free_common() may erase current element */
+                if (!BH_is_released(bh)) free_common(bh);
+            }
+        }
+
+        seqno_release_pending = SEQNO_NONE;
+
         seqno_released = SEQNO_NONE;
+        seqno_read_next= SEQNO_NONE;
         gid = g;
 
+        unpacked_clear();
+        discard_page_buffers();
+
         /* order is significant here */
         rb.seqno_reset();
         mem.seqno_reset();
@@ -39,6 +90,55 @@ namespace gcache
         seqno_max = SEQNO_NONE;
     }
 
+    /* Drops history past s when the new position is within the same
+     * history, the rest stays available for IST. Returns false when some
+     * buffer past s is still in use, then full reset is needed. */
+    bool
+    GCache::seqno_truncate (seqno_t const s)
+    {
+        if (seqno_locked != SEQNO_NONE && seqno_locked > s) return false;
+        if (!seqno_pins.empty() && *seqno_pins.rbegin() > s) return false;
+
+        for (seqno2ptr_iter_t i(seqno2ptr.upper_bound(s));
+             i != seqno2ptr.end(); ++i)
+        {
+            if (!BH_is_released(ptr2BH(i->second))) return false;
+        }
+
+        unpacked_clear();
+
+        for (seqno2ptr_iter_t i(seqno2ptr.upper_bound(s));
+             i != seqno2ptr.end(); ++i)
+        {
+            BufferHeader* const bh(ptr2BH(i->second));
+
+            bh->seqno_g = SEQNO_ILL;
+
+            switch (bh->store)
+            {
+            case BUFFER_IN_MEM:  mem.discard (bh); break;
+            case BUFFER_IN_RB:   rb.discard  (bh); break;
+            case BUFFER_IN_PAGE: ps.discard  (bh); break;
+            default:
+                log_fatal << "Corrupt buffer header: " << bh;
+                abort();
+            }
+        }
+
+        seqno2ptr.erase_after(s);
+
+        log_info << "GCache history truncated: " << gid << ':' << seqno_max
+                 << " -> " << s << ", keeping " << seqno2ptr.begin()->first
+                 << '-' << s;
+
+        seqno_max = s;
+        if (seqno_released > s)        seqno_released = s;
+        if (seqno_release_pending > s) seqno_release_pending = s;
+        seqno_read_next = SEQNO_NONE;
+
+        return true;
+    }
+
     /*!
      * Assign sequence number to buffer pointed to by ptr
      */
@@ -48,6 +148,7 @@ namespace gcache
                           int64_t     const seqno_d)
     {
         gu::Lock lock(mtx);
+        recovery_wait(lock);
 
         BufferHeader* bh = ptr2BH(ptr);
 
@@ -79,7 +180,7 @@ namespace gcache
     }
 
     void
-    GCache::seqno_release (int64_t const seqno)
+    GCache::seqno_release (int64_t seqno)
     {
         assert (seqno > 0);
         /* The number of buffers scheduled for release is unpredictable, so
@@ -102,8 +203,19 @@ namespace gcache
             if (loop) sched_yield();
 
             gu::Lock lock(mtx);
+            recovery_wait(lock);
+
+            if (gu_unlikely(!seqno_pins.empty()))
+            {
+                /* don't release pinned history, finish it in seqno_unpin() */
+                if (seqno > seqno_release_pending)
+                    seqno_release_pending = seqno;
+
+                seqno = std::min(seqno, *seqno_pins.begin() - 1);
+            }
 
-            assert(seqno >= seqno_released);
+            /* deferred release from seqno_unpin() may race with regular one */
+            if (gu_unlikely(seqno <= seqno_released)) return;
 
             seqno2ptr_iter_t it(seqno2ptr.upper_bound(seqno_released));
 
@@ -175,7 +287,8 @@ namespace gcache
     {
         gu::Lock lock(mtx);
 
-        if (seqno2ptr.find(seqno_g) == seqno2ptr.end()) throw gu::NotFound();
+        if (recovering || seqno2ptr.find(seqno_g) == seqno2ptr.end())
+            throw gu::NotFound();
 
         if (seqno_locked != SEQNO_NONE)
         {
@@ -184,6 +297,45 @@ namespace gcache
         seqno_locked = seqno_g;
     }
 
+    void GCache::seqno_pin (int64_t const seqno_g)
+    {
+        gu::Lock lock(mtx);
+        recovery_wait(lock);
+
+        /* released buffers may be gone any moment, can't protect those */
+        if (seqno_g <= seqno_released || seqno_g <= SEQNO_NONE)
+            throw gu::NotFound();
+
+        seqno_pins.insert(seqno_g);
+    }
+
+    void GCache::seqno_unpin (int64_t const seqno_g)
+    {
+        int64_t release(SEQNO_NONE);
+
+        {
+            gu::Lock lock(mtx);
+
+            std::multiset<seqno_t>::iterator const i(seqno_pins.find(seqno_g));
+
+            if (i == seqno_pins.end())
+            {
+                log_warn << "Attempt to unpin seqno " << seqno_g
+                         << " which is not pinned";
+                return;
+            }
+
+            bool const lowest(i == seqno_pins.begin());
+
+            seqno_pins.erase(i);
+
+            if (lowest) release = seqno_release_pending;
+            if (seqno_pins.empty()) seqno_release_pending = SEQNO_NONE;
+        }
+
+        if (release > SEQNO_NONE) seqno_release(release);
+    }
+
     /*!
      * Get pointer to buffer identified by seqno.
      * Moves lock to the given seqno.
@@ -197,6 +349,7 @@ namespace gcache
 
         {
             gu::Lock lock(mtx);
+            recovery_wait(lock);
 
             seqno2ptr_iter_t p = seqno2ptr.find(seqno_g);
 
@@ -207,8 +360,9 @@ namespace gcache
                     cond.signal();
                 }
                 seqno_locked = seqno_g;
+                unpacked_trim(seqno_locked);
 
-                ptr = p->second;
+                ptr = unpack_buffer(p->second);
             }
             else
             {
@@ -235,8 +389,13 @@ namespace gcache
 
         size_t found(0);
 
+        const void* rb_first(0);
+        const void* rb_last (0);
+        bool        sequential(false);
+
         {
             gu::Lock lock(mtx);
+            recovery_wait(lock);
 
             seqno2ptr_iter_t p = seqno2ptr.find(start);
 
@@ -248,18 +407,35 @@ namespace gcache
                 }
 
                 seqno_locked = start;
+                unpacked_trim(seqno_locked);
 
                 do {
                     assert (p->first == int64_t(start + found));
                     assert (p->second);
-                    v[found].set_ptr(p->second);
+
+                    if (rb.contains(p->second))
+                    {
+                        if (0 == rb_first) rb_first = p->second;
+                        rb_last = p->second;
+                    }
+
+                    v[found].set_ptr(unpack_buffer(p->second));
                 }
                 while (++found < max && ++p != seqno2ptr.end() &&
                        p->first == int64_t(start + found));
                 /* the latter condition ensures seqno continuty, #643 */
+
+                sequential      = (start == seqno_read_next);
+                seqno_read_next = start + found;
             }
         }
 
+        /* let the kernel read the batch in while it is being sent and
+         * drop the previous one if this is a continuation. The range stays
+         * mapped and read-ahead state belongs to the (single) history reader,
+         * so madvise() does not need to hold up replication on mtx. */
+        if (rb_first) rb.read_ahead(rb_first, rb_last, sequential);
+
         // the following may cause IO
         for (size_t i(0); i < found; ++i)
         {
@@ -282,7 +458,93 @@ namespace gcache
     void GCache::seqno_unlock ()
     {
         gu::Lock lock(mtx);
+        recovery_wait(lock);
         seqno_locked = SEQNO_NONE;
+        unpacked_clear();
+
+        if (seqno_read_next != SEQNO_NONE)
+        {
+            rb.read_done();
+            seqno_read_next = SEQNO_NONE;
+        }
+
         cond.signal();
     }
+
+    const void*
+    GCache::unpack_buffer (const void* const ptr)
+    {
+        /* only page store buffers can be compressed, don't touch RB ones
+         * here: that might block on IO with the lock held */
+        if (gu_likely(rb.contains(ptr))) return ptr;
+
+        const BufferHeader* const bh(ptr2BH(ptr));
+
+        if (gu_likely(!BH_is_compressed(bh))) return ptr;
+
+        unpacked_t::const_iterator const u(unpacked.find(bh->seqno_g));
+
+        if (u != unpacked.end()) return (u->second + 1);
+
+        const uint8_t* const zptr(static_cast<const uint8_t*>(ptr));
+        uint64_t             raw_size;
+
+        ::memcpy(&raw_size, zptr, sizeof(raw_size));
+
+        BufferHeader* const ubh(static_cast<BufferHeader*>(
+                                    ::malloc(sizeof(BufferHeader) + raw_size)));
+
+        if (0 == ubh)
+        {
+            gu_throw_error(ENOMEM) << "Failed to allocate " << raw_size
+                                   << " bytes to inflate buffer "
+                                   << bh->seqno_g;
+        }
+
+        uLongf    len(raw_size);
+        int const err(uncompress(reinterpret_cast<Bytef*>(ubh + 1), &len,
+                                 zptr + sizeof(raw_size),
+                                 bh->size - sizeof(BufferHeader)
+                                 - sizeof(raw_size)));
+
+        if (Z_OK != err || len != raw_size)
+        {
+            ::free(ubh);
+            gu_throw_fatal << "Failed to inflate buffer " << bh->seqno_g
+                           << ": " << err << ", " << len << '/' << raw_size
+                           << " bytes";
+        }
+
+        *ubh        = *bh;
+        ubh->size   = sizeof(BufferHeader) + raw_size;
+        ubh->flags &= ~BUFFER_COMPRESSED;
+
+        unpacked.insert(std::make_pair(ubh->seqno_g, ubh));
+
+        return (ubh + 1);
+    }
+
+    void
+    GCache::unpacked_trim (seqno_t const s)
+    {
+        unpacked_t::iterator const end(unpacked.lower_bound(s));
+
+        for (unpacked_t::iterator i(unpacked.begin()); i != end; ++i)
+        {
+            ::free(i->second);
+        }
+
+        unpacked.erase(unpacked.begin(), end);
+    }
+
+    void
+    GCache::unpacked_clear ()
+    {
+        for (unpacked_t::iterator i(unpacked.begin()); i != unpacked.end(); ++i)
+        {
+            ::free(i->second);
+        }
+
+        unpacked.clear();
+    }
 }
@@ -18,6 +18,8 @@ extern "C" {
 
 typedef struct _gcache gcache_t;
 
+extern void      gcache_register_params (gu_config_t* conf);
+
 extern gcache_t* gcache_create  (gu_config_t* conf, const char* data_dir);
 extern void      gcache_destroy (gcache_t* gc);
 
@@ -69,6 +69,7 @@ MemStore::seqno_reset()
             allocd_.erase (tmp);
 
             size_ -= bh->size;
+            gu::MemStats::sub(gu::MemStats::GCACHE_RAM, bh->size);
             ::free (bh);
         }
     }
@@ -12,6 +12,8 @@
 #include "gcache_types.hpp"
 #include "gcache_limits.hpp"
 
+#include <gu_mem_stats.hpp>
+
 #include <string>
 #include <set>
 
@@ -37,6 +39,7 @@ namespace gcache
             }
 
             allocd_.clear();
+            gu::MemStats::sub(gu::MemStats::GCACHE_RAM, size_);
             size_ = 0;
         }
 
@@ -64,6 +67,7 @@ namespace gcache
                 bh->ctx     = this;
 
                 size_ += size;
+                gu::MemStats::add(gu::MemStats::GCACHE_RAM, size);
 
                 return (bh + 1);
             }
@@ -112,6 +116,7 @@ namespace gcache
                 bh->size  = size;
 
                 size_ += diff_size;
+                gu::MemStats::add(gu::MemStats::GCACHE_RAM, diff_size);
 
                 return (bh + 1);
             }
@@ -124,6 +129,7 @@ namespace gcache
             assert (BH_is_released(bh));
 
             size_ -= bh->size;
+            gu::MemStats::sub(gu::MemStats::GCACHE_RAM, bh->size);
             ::free (bh);
             allocd_.erase(bh);
         }
@@ -9,6 +9,7 @@
 
 #include <gu_throw.hpp>
 #include <gu_logger.hpp>
+#include <gu_limits.h>
 
 // for posix_fadvise()
 #if !defined(_XOPEN_SOURCE)
@@ -28,6 +29,7 @@ gcache::Page::reset ()
 
     space_ = mmap_.size;
     next_  = static_cast<uint8_t*>(mmap_.ptr);
+    BH_clear (BH_cast(next_));
 }
 
 void
@@ -46,18 +48,40 @@ gcache::Page::drop_fs_cache() const
 #endif
 }
 
-gcache::Page::Page (void* ps, const std::string& name, size_t size)
+void
+gcache::Page::flush() const
+{
+    /* dirty pages would be skipped by fadvise(), write them out first */
+    mmap_.sync(mmap_.ptr, mmap_.size);
+    mmap_.dont_need(mmap_.ptr, mmap_.size);
+    drop_fs_cache();
+}
+
+gcache::Page::Page (void* ps, const std::string& name, size_t size,
+                    bool const prealloc)
     :
-    fd_   (name, size, false, false),
+    fd_   (name, size, prealloc, false),
     mmap_ (fd_),
     ps_   (ps),
     next_ (static_cast<uint8_t*>(mmap_.ptr)),
     space_(mmap_.size),
     used_ (0)
 {
+    if (prealloc)
+    {
+        /* fault in the mapping so that the first writes don't have to */
+        size_t const os_page(GU_PAGE_SIZE);
+        volatile const uint8_t* const p(next_);
+        uint8_t sum(0);
+        for (size_t off(0); off < space_; off += os_page) sum += p[off];
+        (void)sum;
+    }
+
     log_info << "Created page " << name << " of size " << space_
              << " bytes";
     BH_clear (reinterpret_cast<BufferHeader*>(next_));
+
+    gu::MemStats::add(gu::MemStats::GCACHE_PAGES, mmap_.size);
 }
 
 void*
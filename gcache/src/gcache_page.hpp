@@ -12,6 +12,7 @@
 
 #include "gu_fdesc.hpp"
 #include "gu_mmap.hpp"
+#include "gu_mem_stats.hpp"
 
 #include <string>
 
@@ -21,8 +22,14 @@ namespace gcache
     {
     public:
 
-        Page (void* ps, const std::string& name, size_t size);
-        ~Page () {}
+        /* with prealloc set the file space is allocated and the mapping
+         * is faulted in right away, otherwise both happen on first write */
+        Page (void* ps, const std::string& name, size_t size,
+              bool prealloc = false);
+        ~Page ()
+        {
+            gu::MemStats::sub(gu::MemStats::GCACHE_PAGES, mmap_.size);
+        }
 
         void* malloc  (size_type size);
 
@@ -51,6 +58,10 @@ namespace gcache
         /* Drop filesystem cache on the file */
         void drop_fs_cache() const;
 
+        /* Write the mapping back to disk and drop it from memory. Slow,
+         * for the page store worker thread. */
+        void flush() const;
+
         void* parent() const { return ps_; }
 
     private:
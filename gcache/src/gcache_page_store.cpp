@@ -10,11 +10,14 @@
 
 #include <gu_logger.hpp>
 #include <gu_throw.hpp>
+#include <gu_probe.h>
 
 #include <cstdio>
 #include <cstring>
 #include <pthread.h>
 
+#include <algorithm>
+
 #include <iomanip>
 
 static const std::string base_name ("gcache.page.");
@@ -47,33 +50,104 @@ make_page_name (const std::string& base_name, size_t count)
     return os.str();
 }
 
-static void*
-remove_file (void* __restrict__ arg)
+static void
+remove_file (const std::string& file_name)
 {
-    char* const file_name (static_cast<char*>(arg));
+    GU_PROBE1(page_delete, file_name.c_str());
 
-    if (NULL != file_name)
+    if (remove (file_name.c_str()))
     {
-        if (remove (file_name))
-        {
-            int err = errno;
+        int err = errno;
 
-            log_error << "Failed to remove page file '" << file_name << "': "
-                      << err << " (" << strerror(err) << ")";
-        }
-        else
-        {
-            log_info << "Deleted page " << file_name;
-        }
+        log_error << "Failed to remove page file '" << file_name << "': "
+                  << err << " (" << strerror(err) << ")";
+    }
+    else
+    {
+        log_info << "Deleted page " << file_name;
+    }
+}
 
-        free (file_name);
+/* must be called with worker_mtx_ locked */
+void
+gcache::PageStore::unlink_page (Page* const page)
+{
+    std::string const file_name(page->name());
+
+    delete page;
+
+    if (worker_started_ && !worker_stop_)
+    {
+        unlink_.push_back(file_name);
+        worker_cond_.signal();
     }
     else
     {
-        log_error << "Null file name in " << __FUNCTION__;
+        remove_file(file_name);
+    }
+}
+
+bool
+gcache::PageStore::recycle_page (Page* const page)
+{
+    gu::Lock lock(worker_mtx_);
+
+    /* odd sized pages were made for a particular buffer, don't keep them */
+    if (worker_stop_ || page->size() != prealloc_size_) return false;
+
+    if (spare_.size() < prealloc_pages_ ||
+        spare_size_ + page->size() <= keep_size_)
+    {
+        page->reset();
+        spare_.push_back(page);
+        spare_size_ += page->size();
+        log_debug << "Recycled page " << page->name();
+        return true;
     }
 
-    pthread_exit(NULL);
+    return false;
+}
+
+/* must be called with worker_mtx_ locked */
+void
+gcache::PageStore::trim_spare_pages ()
+{
+    while (spare_.size() > prealloc_pages_ && spare_size_ > keep_size_)
+    {
+        Page* const page(spare_.back());
+        spare_.pop_back();
+        spare_size_ -= page->size();
+        unlink_page(page);
+    }
+}
+
+/* queues full page for flushing, returns false if it can't be done */
+bool
+gcache::PageStore::flush_page (Page* const page)
+{
+    gu::Lock lock(worker_mtx_);
+
+    if (!flush_pages_ || !worker_started_ || worker_stop_) return false;
+
+    if (std::find(flush_.begin(), flush_.end(), page) == flush_.end())
+    {
+        flush_.push_back(page);
+        worker_cond_.signal();
+    }
+
+    return true;
+}
+
+/* makes sure the worker is done with the page before it goes */
+void
+gcache::PageStore::forget_page (Page* const page)
+{
+    gu::Lock lock(worker_mtx_);
+
+    flush_.erase(std::remove(flush_.begin(), flush_.end(), page),
+                 flush_.end());
+
+    while (flushing_ == page) lock.wait(flush_cond_);
 }
 
 bool
@@ -85,26 +159,16 @@ gcache::PageStore::delete_page ()
 
     pages_.pop_front();
 
-    char* const file_name(strdup(page->name().c_str()));
-
     total_size_ -= page->size();
 
     if (current_ == page) current_ = 0;
 
-    delete page;
-
-#ifdef GCACHE_DETACH_THREAD
-    pthread_t delete_thr_;
-#else
-    if (delete_thr_ != pthread_t(-1)) pthread_join (delete_thr_, NULL);
-#endif /* GCACHE_DETACH_THERAD */
+    forget_page(page);
 
-    int err = pthread_create (&delete_thr_, &delete_page_attr_, remove_file,
-                              file_name);
-    if (0 != err)
+    if (!recycle_page(page))
     {
-        delete_thr_ = pthread_t(-1);
-        gu_throw_error(err) << "Failed to create page file deletion thread";
+        gu::Lock lock(worker_mtx_);
+        unlink_page(page);
     }
 
     return true;
@@ -128,21 +192,236 @@ gcache::PageStore::reset ()
     while (pages_.size() > 0 && delete_page()) {};
 }
 
+std::string
+gcache::PageStore::next_page_name ()
+{
+    gu::Lock lock(worker_mtx_);
+    return make_page_name (base_name_, name_count_++);
+}
+
+gcache::Page*
+gcache::PageStore::get_spare_page (size_type const size)
+{
+    gu::Lock lock(worker_mtx_);
+
+    if (spare_.empty() || spare_.front()->size() < size) return 0;
+
+    Page* const ret(spare_.front());
+    spare_.pop_front();
+    spare_size_ -= ret->size();
+    worker_cond_.signal(); // make a replacement
+
+    return ret;
+}
+
 inline void
 gcache::PageStore::new_page (size_type size)
 {
-    Page* const page(new Page(this, make_page_name (base_name_, count_), size));
+    Page* page(get_spare_page(size));
+
+    if (0 == page)
+    {
+        page = new Page(this, next_page_name(), size);
+        GU_PROBE2(page_create, page->name().c_str(), page->size());
+    }
 
     pages_.push_back (page);
     total_size_ += page->size();
     current_ = page;
     count_++;
+
+    /* the first page is a sign that more are likely to follow */
+    if (!worker_started_ && !worker_stop_) start_worker();
+}
+
+void*
+gcache::PageStore::worker_thread (void* arg)
+{
+    static_cast<PageStore*>(arg)->worker_loop();
+    return NULL;
+}
+
+void
+gcache::PageStore::worker_loop ()
+{
+    while (true)
+    {
+        std::string file_name;
+        size_t      size(0);
+        Page*       flush(0);
+
+        {
+            gu::Lock lock(worker_mtx_);
+
+            while (!worker_stop_ && unlink_.empty() && flush_.empty() &&
+                   spare_.size() >= prealloc_pages_)
+            {
+                lock.wait(worker_cond_);
+            }
+
+            if (!unlink_.empty())
+            {
+                /* freeing space goes first */
+                file_name = unlink_.front();
+                unlink_.pop_front();
+            }
+            else if (worker_stop_)
+            {
+                return;
+            }
+            else if (!flush_.empty())
+            {
+                flush = flush_.front();
+                flush_.pop_front();
+                flushing_ = flush;
+            }
+            else
+            {
+                size      = prealloc_size_;
+                file_name = make_page_name (base_name_, name_count_++);
+            }
+        }
+
+        if (flush)
+        {
+            try
+            {
+                flush->flush();
+            }
+            catch (gu::Exception& e)
+            {
+                log_warn << "Failed to flush cache page " << flush->name()
+                         << ": " << e.what();
+            }
+
+            gu::Lock lock(worker_mtx_);
+            flushing_ = 0;
+            flush_cond_.broadcast();
+            continue;
+        }
+
+        if (0 == size)
+        {
+            remove_file(file_name);
+            continue;
+        }
+
+        Page* page(0);
+
+        try
+        {
+            page = new Page(this, file_name, size, true);
+            GU_PROBE2(page_create, page->name().c_str(), page->size());
+        }
+        catch (gu::Exception& e)
+        {
+            log_warn << "Failed to preallocate cache page: " << e.what()
+                     << ". New pages will be created on demand.";
+
+            /* most likely out of space, don't retry until reconfigured */
+            gu::Lock lock(worker_mtx_);
+            prealloc_pages_ = 0;
+            continue;
+        }
+
+        gu::Lock lock(worker_mtx_);
+
+        spare_.push_back(page);
+        spare_size_ += page->size();
+
+        /* might have been reconfigured while the page was being created */
+        trim_spare_pages();
+    }
+}
+
+void
+gcache::PageStore::start_worker ()
+{
+    gu::Lock lock(worker_mtx_);
+
+    int const err(pthread_create (&worker_thr_, NULL, worker_thread, this));
+
+    if (0 != err)
+    {
+        log_warn << "Failed to start page store worker thread: " << err
+                 << " (" << strerror(err) << "). "
+                 << "Page files will be created and removed on demand.";
+
+        prealloc_pages_ = 0;
+        worker_stop_    = true;
+        return;
+    }
+
+    worker_started_ = true;
+}
+
+void
+gcache::PageStore::stop_worker ()
+{
+    {
+        gu::Lock lock(worker_mtx_);
+        worker_stop_ = true;
+        worker_cond_.signal();
+    }
+
+    if (worker_started_)
+    {
+        pthread_join (worker_thr_, NULL); // removes queued files
+        worker_started_ = false;
+    }
+
+    while (!spare_.empty())
+    {
+        unlink_page(spare_.front());
+        spare_.pop_front();
+    }
+
+    spare_size_ = 0;
+}
+
+void
+gcache::PageStore::set_page_size (size_t const size)
+{
+    page_size_ = size;
+
+    gu::Lock lock(worker_mtx_);
+    prealloc_size_ = size;
+}
+
+void
+gcache::PageStore::set_keep_size (size_t const size)
+{
+    keep_size_ = size;
+
+    gu::Lock lock(worker_mtx_);
+    trim_spare_pages();
+}
+
+void
+gcache::PageStore::set_flush (bool const flush)
+{
+    gu::Lock lock(worker_mtx_);
+
+    flush_pages_ = flush;
+    if (!flush_pages_) flush_.clear();
+}
+
+void
+gcache::PageStore::set_prealloc (size_t const pages)
+{
+    gu::Lock lock(worker_mtx_);
+
+    prealloc_pages_ = pages;
+    trim_spare_pages();
+    worker_cond_.signal();
 }
 
 gcache::PageStore::PageStore (const std::string& dir_name,
                               size_t             keep_size,
                               size_t             page_size,
-                              bool               keep_page)
+                              bool               keep_page,
+                              size_t             prealloc_pages,
+                              bool               flush_pages)
     :
     base_name_ (make_base_name(dir_name)),
     keep_size_ (keep_size),
@@ -152,39 +431,30 @@ gcache::PageStore::PageStore (const std::string& dir_name,
     pages_     (),
     current_   (0),
     total_size_(0),
-    delete_page_attr_()
-#ifndef GCACHE_DETACH_THREAD
-    , delete_thr_(pthread_t(-1))
-#endif /* GCACHE_DETACH_THREAD */
-{
-    int err = pthread_attr_init (&delete_page_attr_);
-
-    if (0 != err)
-    {
-        gu_throw_error(err) << "Failed to initialize page file deletion "
-                            << "thread attributes";
-    }
-
-#ifdef GCACHE_DETACH_THREAD
-    err = pthread_attr_setdetachstate (&delete_page_attr_,
-                                       PTHREAD_CREATE_DETACHED);
-    if (0 != err)
-    {
-        pthread_attr_destroy (&delete_page_attr_);
-        gu_throw_error(err) << "Failed to set DETACHED attribute to "
-                            << "page file deletion thread";
-    }
-#endif /* GCACHE_DETACH_THREAD */
-}
+    worker_mtx_     (),
+    worker_cond_    (),
+    flush_cond_     (),
+    spare_          (),
+    unlink_         (),
+    flush_          (),
+    flushing_       (0),
+    flush_pages_    (flush_pages),
+    spare_size_     (0),
+    prealloc_pages_ (prealloc_pages),
+    prealloc_size_  (page_size),
+    name_count_     (0),
+    worker_thr_     (),
+    worker_started_ (false),
+    worker_stop_    (false)
+{}
 
 gcache::PageStore::~PageStore ()
 {
     try
     {
         while (pages_.size() && delete_page()) {};
-#ifndef GCACHE_DETACH_THREAD
-        if (delete_thr_ != pthread_t(-1)) pthread_join (delete_thr_, NULL);
-#endif /* GCACHE_DETACH_THREAD */
+
+        stop_worker();
     }
     catch (gu::Exception& e)
     {
@@ -196,8 +466,6 @@ gcache::PageStore::~PageStore ()
         log_error << "Could not delete " << pages_.size()
                   << " page files: some buffers are still \"mmapped\".";
     }
-
-    pthread_attr_destroy (&delete_page_attr_);
 }
 
 inline void*
@@ -234,7 +502,7 @@ gcache::PageStore::malloc (size_type const size)
 
         if (gu_likely(0 != ret)) return ret;
 
-        current_->drop_fs_cache();
+        if (!flush_page(current_)) current_->drop_fs_cache();
     }
 
     return malloc_new (size);
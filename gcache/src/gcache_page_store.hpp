@@ -11,6 +11,8 @@
 #include "gcache_page.hpp"
 #include "gcache_seqno.hpp"
 
+#include <gu_lock.hpp>
+
 #include <string>
 #include <deque>
 
@@ -23,7 +25,9 @@ namespace gcache
         PageStore (const std::string& dir_name,
                    size_t             keep_size,
                    size_t             page_size,
-                   bool               keep_page);
+                   bool               keep_page,
+                   size_t             prealloc_pages = 0,
+                   bool               flush_pages    = false);
 
         ~PageStore ();
 
@@ -47,14 +51,25 @@ namespace gcache
 
         void  reset();
 
-        void  set_page_size (size_t size) { page_size_ = size; }
+        void  set_page_size (size_t size);
 
-        void  set_keep_size (size_t size) { keep_size_ = size; }
+        /* how many spare pages to keep created in advance */
+        void  set_prealloc (size_t pages);
+
+        void  set_keep_size (size_t size);
+
+        /* whether to write full pages back and drop them from memory */
+        void  set_flush (bool flush);
 
-        /* for unit tests */
         size_t count()       const { return count_;        }
         size_t total_pages() const { return pages_.size(); }
         size_t total_size()  const { return total_size_;   }
+        /* for unit tests */
+        size_t spare_pages() const
+        {
+            gu::Lock lock(worker_mtx_);
+            return spare_.size();
+        }
 
     private:
 
@@ -66,10 +81,41 @@ namespace gcache
         std::deque<Page*> pages_;
         Page*             current_;
         size_t            total_size_;
-        pthread_attr_t    delete_page_attr_;
-#ifndef GCACHE_DETACH_THREAD
-        pthread_t         delete_thr_;
-#endif /* GCACHE_DETACH_THREAD */
+
+        /* Spare pages are created ahead of time and page files are removed
+         * by worker_thr_, so that neither file creation nor unlinking has to
+         * happen in malloc(). Pages released by cleanup() go to the spare
+         * pool too, within prealloc_pages_ or keep_size_, which ever allows
+         * more. With flush_pages_ full pages are also written back and
+         * dropped from memory there, so that the page store does not
+         * compete for RAM. Members below are protected by worker_mtx_. */
+        gu::Mutex               worker_mtx_;
+        gu::Cond                worker_cond_;
+        gu::Cond                flush_cond_;     /* flushing_ is done     */
+        std::deque<Page*>       spare_;          /* ready to use pages    */
+        std::deque<std::string> unlink_;         /* page files to remove  */
+        std::deque<Page*>       flush_;          /* full pages to flush   */
+        Page*                   flushing_;       /* page being flushed    */
+        bool                    flush_pages_;
+        size_t                  spare_size_;     /* total size of spare_  */
+        size_t                  prealloc_pages_; /* how many spares to make */
+        size_t                  prealloc_size_;  /* size of the next spare */
+        size_t                  name_count_;     /* page file name sequence */
+        pthread_t               worker_thr_;
+        bool                    worker_started_;
+        bool                    worker_stop_;
+
+        static void* worker_thread(void* arg);
+        void         worker_loop();
+        void         start_worker();
+        void         stop_worker();
+        Page*        get_spare_page(size_type size);
+        bool         recycle_page(Page* page);
+        void         trim_spare_pages();
+        void         unlink_page(Page* page);
+        bool         flush_page(Page* page);
+        void         forget_page(Page* page);
+        std::string  next_page_name();
 
         void new_page    (size_type size);
 
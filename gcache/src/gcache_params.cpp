@@ -16,8 +16,26 @@ static const std::string GCACHE_PARAMS_PAGE_SIZE  ("gcache.page_size");
 static const std::string GCACHE_DEFAULT_PAGE_SIZE (GCACHE_DEFAULT_RB_SIZE);
 static const std::string GCACHE_PARAMS_KEEP_PAGES_SIZE("gcache.keep_pages_size");
 static const std::string GCACHE_DEFAULT_KEEP_PAGES_SIZE("0");
+static const std::string GCACHE_PARAMS_PAGE_PREALLOC ("gcache.page_prealloc");
+static const std::string GCACHE_DEFAULT_PAGE_PREALLOC("1");
+static const std::string GCACHE_PARAMS_PAGE_FLUSH ("gcache.page_flush");
+static const std::string GCACHE_DEFAULT_PAGE_FLUSH("no");
+static const std::string GCACHE_PARAMS_PAGE_COMPRESSION ("gcache.page_compression");
+static const std::string GCACHE_DEFAULT_PAGE_COMPRESSION("no");
+static const std::string GCACHE_PARAMS_HUGE_PAGES ("gcache.huge_pages");
+static const std::string GCACHE_DEFAULT_HUGE_PAGES("no");
+static const std::string GCACHE_PARAMS_LOCK       ("gcache.lock_in_memory");
+static const std::string GCACHE_DEFAULT_LOCK      ("no");
+static const std::string GCACHE_PARAMS_NUMA_NODE  ("gcache.numa_node");
+static const std::string GCACHE_DEFAULT_NUMA_NODE ("-1");
 static const std::string GCACHE_PARAMS_RECOVER    ("gcache.recover");
 static const std::string GCACHE_DEFAULT_RECOVER   ("no");
+static const std::string GCACHE_PARAMS_RECOVER_BG ("gcache.recover_background");
+static const std::string GCACHE_DEFAULT_RECOVER_BG("no");
+static const std::string GCACHE_PARAMS_PIN_SEQNO  ("gcache.pin_seqno");
+static const std::string GCACHE_PARAMS_LARGE_BUFFER_SIZE ("gcache.large_buffer_size");
+static const std::string GCACHE_DEFAULT_LARGE_BUFFER_SIZE("0");
+static const std::string GCACHE_DEFAULT_PIN_SEQNO ("-1");
 
 void
 gcache::GCache::Params::register_params(gu::Config& cfg)
@@ -28,7 +46,16 @@ gcache::GCache::Params::register_params(gu::Config& cfg)
     cfg.add(GCACHE_PARAMS_RB_SIZE,         GCACHE_DEFAULT_RB_SIZE);
     cfg.add(GCACHE_PARAMS_PAGE_SIZE,       GCACHE_DEFAULT_PAGE_SIZE);
     cfg.add(GCACHE_PARAMS_KEEP_PAGES_SIZE, GCACHE_DEFAULT_KEEP_PAGES_SIZE);
+    cfg.add(GCACHE_PARAMS_PAGE_PREALLOC,   GCACHE_DEFAULT_PAGE_PREALLOC);
+    cfg.add(GCACHE_PARAMS_PAGE_FLUSH,      GCACHE_DEFAULT_PAGE_FLUSH);
+    cfg.add(GCACHE_PARAMS_PAGE_COMPRESSION,GCACHE_DEFAULT_PAGE_COMPRESSION);
+    cfg.add(GCACHE_PARAMS_HUGE_PAGES,      GCACHE_DEFAULT_HUGE_PAGES);
+    cfg.add(GCACHE_PARAMS_LOCK,            GCACHE_DEFAULT_LOCK);
+    cfg.add(GCACHE_PARAMS_NUMA_NODE,       GCACHE_DEFAULT_NUMA_NODE);
     cfg.add(GCACHE_PARAMS_RECOVER,         GCACHE_DEFAULT_RECOVER);
+    cfg.add(GCACHE_PARAMS_RECOVER_BG,      GCACHE_DEFAULT_RECOVER_BG);
+    cfg.add(GCACHE_PARAMS_PIN_SEQNO,       GCACHE_DEFAULT_PIN_SEQNO);
+    cfg.add(GCACHE_PARAMS_LARGE_BUFFER_SIZE,GCACHE_DEFAULT_LARGE_BUFFER_SIZE);
 }
 
 static const std::string&
@@ -64,7 +91,15 @@ gcache::GCache::Params::Params (gu::Config& cfg, const std::string& data_dir)
     rb_size_  (cfg.get<size_t>(GCACHE_PARAMS_RB_SIZE)),
     page_size_(cfg.get<size_t>(GCACHE_PARAMS_PAGE_SIZE)),
     keep_pages_size_(cfg.get<size_t>(GCACHE_PARAMS_KEEP_PAGES_SIZE)),
-    recover_  (cfg.get<bool>(GCACHE_PARAMS_RECOVER))
+    page_prealloc_(cfg.get<size_t>(GCACHE_PARAMS_PAGE_PREALLOC)),
+    page_flush_(cfg.get<bool>(GCACHE_PARAMS_PAGE_FLUSH)),
+    page_compression_(cfg.get<bool>(GCACHE_PARAMS_PAGE_COMPRESSION)),
+    huge_pages_(cfg.get<bool>(GCACHE_PARAMS_HUGE_PAGES)),
+    lock_in_memory_(cfg.get<bool>(GCACHE_PARAMS_LOCK)),
+    numa_node_(cfg.get<int>(GCACHE_PARAMS_NUMA_NODE)),
+    recover_  (cfg.get<bool>(GCACHE_PARAMS_RECOVER)),
+    recover_bg_(cfg.get<bool>(GCACHE_PARAMS_RECOVER_BG)),
+    large_buffer_size_(cfg.get<size_t>(GCACHE_PARAMS_LARGE_BUFFER_SIZE))
 {}
 
 void
@@ -118,11 +153,80 @@ gcache::GCache::param_set (const std::string& key, const std::string& val)
         params.keep_pages_size(tmp_size);
         ps.set_keep_size(params.keep_pages_size());
     }
-    else if (key == GCACHE_PARAMS_RECOVER)
+    else if (key == GCACHE_PARAMS_PAGE_PREALLOC)
+    {
+        size_t tmp_pages = gu::Config::from_config<size_t>(val);
+
+        gu::Lock lock(mtx);
+        /* locking here serves two purposes: ensures atomic setting of config
+         * and params.page_prealloc and syncs with malloc() method */
+
+        config.set<size_t>(key, tmp_pages);
+        params.page_prealloc(tmp_pages);
+        ps.set_prealloc(params.page_prealloc());
+    }
+    else if (key == GCACHE_PARAMS_PAGE_FLUSH)
+    {
+        bool const tmp_bool = gu::Config::from_config<bool>(val);
+
+        gu::Lock lock(mtx);
+        /* locking here syncs with malloc() method */
+
+        config.set<bool>(key, tmp_bool);
+        params.page_flush(tmp_bool);
+        ps.set_flush(params.page_flush());
+    }
+    else if (key == GCACHE_PARAMS_PAGE_COMPRESSION)
+    {
+        bool const tmp_bool = gu::Config::from_config<bool>(val);
+
+        gu::Lock lock(mtx);
+        /* locking here syncs with free_common(), already compressed buffers
+         * stay compressed */
+
+        config.set<bool>(key, tmp_bool);
+        params.page_compression(tmp_bool);
+    }
+    else if (key == GCACHE_PARAMS_LARGE_BUFFER_SIZE)
+    {
+        size_t const tmp_size = gu::Config::from_config<size_t>(val);
+
+        gu::Lock lock(mtx);
+        /* locking here syncs with malloc() and free_common() */
+
+        config.set<size_t>(key, tmp_size);
+        params.large_buffer_size(tmp_size);
+    }
+    else if (key == GCACHE_PARAMS_HUGE_PAGES ||
+             key == GCACHE_PARAMS_LOCK       ||
+             key == GCACHE_PARAMS_NUMA_NODE)
+    {
+        gu_throw_error(EPERM) << "Can't change ring buffer backing in runtime.";
+    }
+    else if (key == GCACHE_PARAMS_RECOVER ||
+             key == GCACHE_PARAMS_RECOVER_BG)
     {
         gu_throw_error(EINVAL) << "'" << key
                                << "' has a meaning only on startup.";
     }
+    else if (key == GCACHE_PARAMS_PIN_SEQNO)
+    {
+        /* lets a backup tool pin history through provider options:
+         * seqno > 0 moves the pin there, -1 drops it */
+        seqno_t const seqno(gu::Config::from_config<int64_t>(val));
+
+        if (seqno > 0) seqno_pin(seqno); // throws NotFound if released
+
+        seqno_t old;
+        {
+            gu::Lock lock(mtx);
+            old = seqno_param_pin;
+            seqno_param_pin = seqno > 0 ? seqno : SEQNO_NONE;
+            config.set<int64_t>(key, seqno > 0 ? seqno : -1);
+        }
+
+        if (old > 0) seqno_unpin(old);
+    }
     else
     {
         throw gu::NotFound();
@@ -12,8 +12,110 @@
 #include <gu_progress.hpp>
 #include <gu_hexdump.hpp>
 #include <gu_hash.h>
+#include <gu_limits.h>
+#include <gu_atomic.hpp>
+#include <gu_mem_stats.hpp>
 
 #include <cassert>
+#include <algorithm>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace
+{
+    /*
+     * Faults the ring buffer file in from several threads ahead of scan().
+     * The scan itself has to follow the buffer chain, but with a cold page
+     * cache it spends nearly all of its time waiting for disk reads, and
+     * those can be issued in parallel. Chunks are handed out in the scan
+     * order, starting at from and wrapping around at end.
+     */
+    class Prefetcher
+    {
+    public:
+
+        Prefetcher(const uint8_t* begin, const uint8_t* from,
+                   const uint8_t* end)
+            :
+            begin_  (begin),
+            size_   (end - begin),
+            from_   (from - begin),
+            chunks_ ((size_ + CHUNK - 1) / CHUNK),
+            next_   (0),
+            threads_()
+        {
+            long const cpus(sysconf(_SC_NPROCESSORS_ONLN));
+            size_t n(cpus > 1 ? cpus : 1);
+            if (n > MAX_THREADS) n = MAX_THREADS;
+            if (n > chunks_)     n = chunks_;
+
+            /* not worth it for a small cache or a single core */
+            if (n < 2) return;
+
+            threads_.reserve(n);
+            for (size_t i(0); i < n; ++i)
+            {
+                pthread_t t;
+                if (pthread_create(&t, NULL, run, this)) break;
+                threads_.push_back(t);
+            }
+
+            log_info << "Prefetching GCache ring buffer with "
+                     << threads_.size() << " threads";
+        }
+
+        ~Prefetcher()
+        {
+            next_ = chunks_; // stop
+            for (size_t i(0); i < threads_.size(); ++i)
+            {
+                pthread_join(threads_[i], NULL);
+            }
+        }
+
+    private:
+
+        static size_t const CHUNK       = 1 << 24; // 16M
+        static size_t const MAX_THREADS = 16;
+
+        const uint8_t* const   begin_;
+        size_t const           size_;
+        size_t const           from_;
+        size_t const           chunks_;
+        gu::Atomic<size_t>     next_;
+        std::vector<pthread_t> threads_;
+
+        static void* run(void* arg)
+        {
+            static_cast<Prefetcher*>(arg)->prefetch();
+            return NULL;
+        }
+
+        void prefetch()
+        {
+            size_t const page(GU_PAGE_SIZE);
+            uint8_t sum(0);
+
+            size_t n;
+            while ((n = next_.fetch_and_add(1)) < chunks_)
+            {
+                size_t const off((from_ + n * CHUNK) % size_);
+                size_t const len(std::min(size_t(CHUNK), size_ - off));
+
+                /* reading only, the scanner may modify the same memory,
+                 * but we don't care about the value */
+                volatile const uint8_t* const p(begin_ + off);
+                for (size_t i(0); i < len; i += page) sum += p[i];
+            }
+
+            (void)sum;
+        }
+
+        Prefetcher(const Prefetcher&);
+        Prefetcher& operator=(const Prefetcher&);
+    };
+}
 
 namespace gcache
 {
@@ -36,6 +138,9 @@ namespace gcache
         size_used_ = 0;
         size_trail_= 0;
 
+        ra_begin_  = 0;
+        ra_end_    = 0;
+
 //        mallocs_  = 0;
 //        reallocs_ = 0;
     }
@@ -47,7 +152,10 @@ namespace gcache
                             size_t             size,
                             seqno2ptr_t&       seqno2ptr,
                             gu::UUID&          gid,
-                            bool const         recover)
+                            bool const         recover,
+                            bool const         huge_pages,
+                            int  const         numa_node,
+                            bool const         defer_open)
     :
         fd_        (name, check_size(size)),
         mmap_      (fd_),
@@ -65,15 +173,32 @@ namespace gcache
         size_trail_(0),
 //        mallocs_   (0),
 //        reallocs_  (0),
-        open_      (true)
+        open_      (true),
+        ra_begin_  (0),
+        ra_end_    (0),
+        locked_    (false)
     {
         constructor_common ();
+
+        /* before anything is faulted in by preamble reading and recovery */
+        if (huge_pages) mmap_.huge_pages();
+        mmap_.bind_node(numa_node);
+
+        if (!defer_open) open(recover);
+
+        gu::MemStats::add(gu::MemStats::GCACHE_RB, mmap_.size);
+    }
+
+    void
+    RingBuffer::open (bool const recover)
+    {
         open_preamble(recover);
         BH_clear (BH_cast(next_));
     }
 
     RingBuffer::~RingBuffer ()
     {
+        gu::MemStats::sub(gu::MemStats::GCACHE_RB, mmap_.size);
         close_preamble();
         open_ = false;
         mmap_.sync();
@@ -513,6 +638,75 @@ namespace gcache
         /* this is needed to avoid rescanning from start_ on recovery */
     }
 
+    void
+    RingBuffer::advise_range (const uint8_t* const begin,
+                              const uint8_t* const end,
+                              bool           const will_need) const
+    {
+        assert(begin >= start_ && begin < end_);
+        assert(end   >  start_ && end  <= end_);
+
+        if (begin < end)
+        {
+            if (will_need)     mmap_.will_need(begin, end - begin);
+            else if (!locked_) mmap_.dont_need(begin, end - begin);
+        }
+        else /* range wraps around */
+        {
+            advise_range(begin,  end_, will_need);
+            advise_range(start_, end,  will_need);
+        }
+    }
+
+    bool
+    RingBuffer::lock_chunk (size_t const offset,
+                            size_t const length,
+                            bool   const lock) const
+    {
+        assert(offset + length <= mmap_.size);
+
+        const uint8_t* const ptr(static_cast<const uint8_t*>(mmap_.ptr) +
+                                 offset);
+
+        if (lock && mmap_.lock(ptr, length)) return true;
+
+        mmap_.populate(ptr, length);
+        return false;
+    }
+
+    void
+    RingBuffer::read_ahead (const void* const first,
+                            const void* const last,
+                            bool        const sequential)
+    {
+        assert(contains(first));
+        assert(contains(last));
+
+        const uint8_t* const begin(reinterpret_cast<const uint8_t*>
+                                   (ptr2BH(first)));
+        const uint8_t* const end  (reinterpret_cast<const uint8_t*>
+                                   (BH_next(ptr2BH(last))));
+
+        if (sequential && ra_begin_ != 0)
+        {
+            advise_range(ra_begin_, ra_end_, false);
+        }
+
+        advise_range(begin, end, true);
+
+        ra_begin_ = begin;
+        ra_end_   = end;
+    }
+
+    void
+    RingBuffer::read_done ()
+    {
+        if (ra_begin_ != 0) advise_range(ra_begin_, ra_end_, false);
+
+        ra_begin_ = 0;
+        ra_end_   = 0;
+    }
+
     void
     RingBuffer::print (std::ostream& os) const
     {
@@ -632,7 +826,10 @@ namespace gcache
 
                 try
                 {
-                    recover(offset - (start_ - preamble));
+                    if (!synced || !load_index(offset, seqno_min, seqno_max))
+                    {
+                        recover(offset - (start_ - preamble));
+                    }
                 }
                 catch (gu::Exception& e)
                 {
@@ -654,9 +851,201 @@ namespace gcache
     void
     RingBuffer::close_preamble()
     {
+        try
+        {
+            write_index();
+        }
+        catch (gu::Exception& e)
+        {
+            /* not fatal, next start will have to scan */
+            log_warn << "Failed to write GCache seqno index: " << e.what();
+            ::unlink(index_name().c_str());
+        }
+
         write_preamble(true);
     }
 
+    /*
+     * Seqno index file layout, int64_t words in host byte order:
+     * [0] hash of the rest of the file, [1] magic, [2-3] history UUID,
+     * [4] first_, [5] next_, [6] size_trail_, [7] number of entries,
+     * followed by {seqno_g, offset} pair for every buffer between first_ and
+     * next_ in the buffer chain order. Offsets are relative to start_.
+     */
+    static int64_t const INDEX_MAGIC   = 0x3130584449434721LL; // "!GCIDX01"
+    static size_t  const INDEX_HDR_LEN = 8;
+
+    static uint64_t
+    index_hash(const int64_t* const idx, size_t const len)
+    {
+        return gu_fast_hash64(idx + 1, (len - 1) * sizeof(int64_t));
+    }
+
+    void
+    RingBuffer::write_index()
+    {
+        std::vector<int64_t> idx(INDEX_HDR_LEN, 0);
+
+        BufferHeader* bh(BH_cast(first_));
+        while (bh != BH_cast(next_))
+        {
+            if (gu_unlikely(0 == bh->size))
+            {
+                bh = BH_cast(start_); // rollover
+                continue;
+            }
+
+            idx.push_back(bh->seqno_g);
+            idx.push_back(reinterpret_cast<uint8_t*>(bh) - start_);
+
+            bh = BH_next(bh);
+        }
+
+        idx[1] = INDEX_MAGIC;
+        ::memcpy(&idx[2], gid_.uuid_ptr(), sizeof(gu_uuid_t));
+        idx[4] = first_ - start_;
+        idx[5] = next_  - start_;
+        idx[6] = size_trail_;
+        idx[7] = (idx.size() - INDEX_HDR_LEN) / 2;
+        idx[0] = index_hash(&idx[0], idx.size());
+
+        size_t const len(idx.size() * sizeof(int64_t));
+        gu::FileDescriptor fd(index_name(), len, false, true);
+        gu::MMap           mmap(fd);
+
+        ::memcpy(mmap.ptr, &idx[0], len);
+        mmap.sync();
+
+        log_info << "Wrote GCache seqno index of " << idx[7] << " entries";
+    }
+
+    /* Restores the same state recover() would arrive at by scanning,
+     * but touches only the buffer headers. Returns false if the index can't
+     * be used for whatever reason, the state is intact then. */
+    bool
+    RingBuffer::load_index(off_t const offset, seqno_t const seqno_min,
+                           seqno_t const seqno_max)
+    {
+        std::string const name(index_name());
+
+        if (::access(name.c_str(), R_OK)) return false;
+
+        gu::FileDescriptor fd(name, false);
+
+        if (fd.size() % sizeof(int64_t) != 0 ||
+            size_t(fd.size()) < INDEX_HDR_LEN * sizeof(int64_t))
+        {
+            log_info << "GCache seqno index is truncated";
+            return false;
+        }
+
+        size_t const len(fd.size() / sizeof(int64_t));
+
+        gu::MMap mmap(fd);
+        const int64_t* const idx(static_cast<const int64_t*>(mmap.ptr));
+        const int64_t* const entries(idx + INDEX_HDR_LEN);
+
+        size_t    const count((len - INDEX_HDR_LEN) / 2);
+        ptrdiff_t const cache_len(end_ - start_);
+
+        if (uint64_t(idx[0]) != index_hash(idx, len) ||
+            idx[1] != INDEX_MAGIC ||
+            ::memcmp(&idx[2], gid_.uuid_ptr(), sizeof(gu_uuid_t)) ||
+            (len - INDEX_HDR_LEN) % 2 != 0 || size_t(idx[7]) != count ||
+            idx[4] < 0 || idx[4] >= cache_len ||
+            idx[5] < 0 || idx[5] >= cache_len ||
+            /* preamble offset is relative to the start of the file */
+            idx[4] + (start_ - reinterpret_cast<uint8_t*>(preamble_)) != offset)
+        {
+            log_info << "GCache seqno index does not match the cache";
+            return false;
+        }
+
+        /* validate the entries before changing anything */
+        size_t  first(count); // first entry to keep
+        size_t  last(count);  // last entry with seqno
+        seqno_t min(SEQNO_NONE), max(SEQNO_NONE);
+        size_t  seqnos(0);
+
+        for (size_t i(0); i < count; ++i)
+        {
+            seqno_t const s(entries[2*i]);
+            int64_t const o(entries[2*i + 1]);
+
+            if (o < 0 || o + ptrdiff_t(sizeof(BufferHeader)) > cache_len)
+                return false;
+
+            const BufferHeader* const bh(BH_cast(start_ + o));
+
+            if (!BH_test(bh) || bh->seqno_g != s) return false;
+
+            if (first == count && s != SEQNO_ILL) first = i;
+
+            if (s > 0)
+            {
+                if (seqnos == 0 || s < min) min = s;
+                if (seqnos == 0 || s > max) max = s;
+                last = i;
+                ++seqnos;
+            }
+        }
+
+        /* only a gapless sequence can be restored without scanning */
+        if (0 == seqnos || seqno_t(seqnos) != max - min + 1 ||
+            min != seqno_min || max != seqno_max)
+        {
+            log_info << "GCache seqno index does not match the preamble";
+            return false;
+        }
+
+        for (size_t i(0); i < count; ++i)
+        {
+            seqno_t const s(entries[2*i]);
+            BufferHeader* const bh(BH_cast(start_ + entries[2*i + 1]));
+
+            if (s > 0 &&
+                false == seqno2ptr_.insert(seqno2ptr_pair_t(s, bh + 1)).second)
+            {
+                /* duplicate seqno, leave it to recover() */
+                seqno2ptr_.clear();
+                return false;
+            }
+        }
+
+        for (size_t i(0); i < count; ++i)
+        {
+            BufferHeader* const bh(BH_cast(start_ + entries[2*i + 1]));
+            bh->flags |= BUFFER_RELEASED;
+            bh->ctx    = this;
+        }
+
+        /* trim like recover() does: from the first non-discarded buffer to
+         * the end of the last buffer with seqno */
+        first_ = start_ + entries[2*first + 1];
+        next_  = reinterpret_cast<uint8_t*>
+            (BH_next(BH_cast(start_ + entries[2*last + 1])));
+        size_trail_ = (first_ < next_ ? 0 : idx[6]);
+
+        estimate_space();
+
+        for (size_t i(first); i <= last; ++i)
+        {
+            if (SEQNO_ILL == entries[2*i])
+            {
+                discard(BH_cast(start_ + entries[2*i + 1]));
+            }
+        }
+
+        assert_sizes();
+
+        log_info << "Recovered GCache ring buffer from seqno index: seqnos "
+                 << min << '-' << max;
+
+        return true;
+    }
+
+
+
     int64_t
     RingBuffer::scan(off_t const offset)
     {
@@ -680,6 +1069,8 @@ namespace gcache
                 segment_scans = 1;
         }
 
+        Prefetcher const prefetcher(start_, segment_start, end_);
+
         gu::Progress<ptrdiff_t> progress("GCache::RingBuffer initial scan",
                                          " bytes", end_ - start_, 1<<22 /*4Mb*/);
 
@@ -27,10 +27,18 @@ namespace gcache
                     size_t             size,
                     seqno2ptr_t&       seqno2ptr,
                     gu::UUID&          gid,
-                    bool               recover);
+                    bool               recover,
+                    bool               huge_pages = false,
+                    int                numa_node  = -1,
+                    bool               defer_open = false);
 
         ~RingBuffer ();
 
+        /*! Reads the preamble and recovers the contents if requested. Called
+         *  from the constructor unless defer_open was given, then must be
+         *  called before anything else. */
+        void  open (bool recover);
+
         void* malloc  (size_type size);
 
         void  free    (BufferHeader* bh);
@@ -49,6 +57,10 @@ namespace gcache
 
         size_t rb_size   () const { return fd_.size(); }
 
+        size_t size_free () const { return size_free_;  }
+        size_t size_used () const { return size_used_;  }
+        size_t size_trail() const { return size_trail_; }
+
         const std::string& rb_name() const { return fd_.name(); }
 
         void  reset();
@@ -67,6 +79,32 @@ namespace gcache
 
         void print (std::ostream& os) const;
 
+        bool contains (const void* const ptr) const
+        {
+            return (ptr > start_ && ptr < end_);
+        }
+
+        /* Read-ahead hints for a sequential history reader (IST): buffers
+         * from first to last are about to be read. If sequential, they follow
+         * the previously advised ones, which won't be needed any more. */
+        void read_ahead (const void* first, const void* last, bool sequential);
+
+        /* reader is done with the last advised range */
+        void read_done ();
+
+        /* gcache.lock_in_memory: the whole mapping is to be kept in memory,
+         * read-ahead hints stop dropping pages already read */
+        void   lock_in_memory () { locked_ = true; }
+
+        /* Faults in and, if lock is true, locks the part of the mapping
+         * at offset. Returns false if locking failed. */
+        bool   lock_chunk (size_t offset, size_t length, bool lock) const;
+
+        size_t mmap_size () const { return mmap_.size; }
+
+        /* bytes of the mapping currently in memory */
+        size_t resident  () const { return mmap_.resident(); }
+
         static size_t pad_size()
         {
             RingBuffer* rb(0);
@@ -135,6 +173,14 @@ namespace gcache
 
         bool               open_;
 
+        const uint8_t*     ra_begin_; // last read_ahead() range
+        const uint8_t*     ra_end_;
+
+        bool               locked_;
+
+        void          advise_range (const uint8_t* begin, const uint8_t* end,
+                                    bool will_need) const;
+
         BufferHeader* get_new_buffer (size_type size);
 
         void          constructor_common();
@@ -151,6 +197,13 @@ namespace gcache
         void          open_preamble(bool recover);
         void          close_preamble();
 
+        /* seqno index sidecar file written on clean shutdown, lets
+         * open_preamble() skip the scan */
+        std::string   index_name() const { return fd_.name() + ".index"; }
+        void          write_index();
+        bool          load_index(off_t offset, seqno_t seqno_min,
+                                 seqno_t seqno_max);
+
         // returns lower bound (not inclusive) of valid seqno range
         int64_t       scan(off_t offset);
         void          recover(off_t offset);
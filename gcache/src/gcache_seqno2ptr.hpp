@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+/*!
+ * @file seqno -> buffer pointer index.
+ *
+ * Seqnos are assigned to cached buffers densely and released from the front,
+ * so instead of a tree the index is kept in a deque addressed by
+ * (seqno - front seqno). The interface mimics the subset of std::map that
+ * GCache uses: iterators dereference to std::pair<seqno_t, const void*> and
+ * skip absent seqnos.
+ *
+ * Iterators hold a seqno rather than a position, so they stay valid across
+ * insertions and across erasure of other elements. Erasing the front element
+ * trims any absent seqnos that follow it, erasing elsewhere just leaves a hole.
+ */
+
+#ifndef __GCACHE_SEQNO2PTR__
+#define __GCACHE_SEQNO2PTR__
+
+#include "gcache_seqno.hpp"
+
+#include <deque>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <cassert>
+
+namespace gcache
+{
+    class Seqno2Ptr
+    {
+    public:
+
+        typedef seqno_t                          key_type;
+        typedef const void*                      mapped_type;
+        typedef std::pair<seqno_t, const void*>  value_type;
+        typedef size_t                           size_type;
+
+    private:
+
+        typedef std::deque<value_type> Base;
+
+        template <typename C, typename V>
+        class Iterator
+        {
+        public:
+
+            typedef std::bidirectional_iterator_tag iterator_category;
+            typedef Seqno2Ptr::value_type           value_type;
+            typedef ptrdiff_t                       difference_type;
+            typedef V*                              pointer;
+            typedef V&                              reference;
+
+            Iterator() : c_(0), s_(SEQNO_NONE) {}
+
+            Iterator(const Iterator& i) : c_(i.c_), s_(i.s_) {}
+
+            Iterator& operator= (const Iterator& i)
+            {
+                c_ = i.c_; s_ = i.s_; return *this;
+            }
+
+            /* conversion from non-const iterator */
+            template <typename C1, typename V1>
+            Iterator(const Iterator<C1, V1>& i) : c_(i.c_), s_(i.s_) {}
+
+            reference operator*  () const { return c_->at(s_); }
+            pointer   operator-> () const { return &c_->at(s_); }
+
+            Iterator& operator++ ()
+            {
+                seqno_t const end(c_->index_end());
+                do { ++s_; } while (s_ < end && c_->hole(s_));
+                return *this;
+            }
+
+            Iterator& operator-- ()
+            {
+                do { --s_; } while (c_->hole(s_));
+                return *this;
+            }
+
+            Iterator operator++ (int) { Iterator t(*this); ++*this; return t; }
+            Iterator operator-- (int) { Iterator t(*this); --*this; return t; }
+
+            bool operator== (const Iterator& o) const { return s_ == o.s_; }
+            bool operator!= (const Iterator& o) const { return s_ != o.s_; }
+
+        private:
+
+            friend class Seqno2Ptr;
+            template <typename C1, typename V1> friend class Iterator;
+
+            Iterator(C* c, seqno_t s) : c_(c), s_(s) {}
+
+            C*      c_;
+            seqno_t s_;
+        };
+
+    public:
+
+        typedef Iterator<Seqno2Ptr, value_type>             iterator;
+        typedef Iterator<const Seqno2Ptr, const value_type> const_iterator;
+        typedef std::reverse_iterator<iterator>             reverse_iterator;
+        typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        Seqno2Ptr() : base_(), begin_(SEQNO_NONE), size_(0), erased_(0) {}
+
+        bool      empty() const { return 0 == size_; }
+        size_type size()  const { return size_; }
+
+        iterator       begin()       { return iterator(this, begin_); }
+        const_iterator begin() const { return const_iterator(this, begin_); }
+        iterator       end()         { return iterator(this, index_end()); }
+        const_iterator end()   const { return const_iterator(this,index_end());}
+
+        reverse_iterator rbegin() { return reverse_iterator(end()); }
+        reverse_iterator rend()   { return reverse_iterator(begin()); }
+        const_reverse_iterator rbegin() const
+        { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const
+        { return const_reverse_iterator(begin()); }
+
+        iterator find(seqno_t const s)
+        {
+            return (in_range(s) && !hole(s)) ? iterator(this, s) : end();
+        }
+
+        const_iterator find(seqno_t const s) const
+        {
+            return (in_range(s) && !hole(s)) ? const_iterator(this, s) : end();
+        }
+
+        /* inserts NULL pointer for s if not present */
+        mapped_type& operator[] (seqno_t const s)
+        {
+            value_type const v(s, static_cast<const void*>(0));
+            return insert(v).first->second;
+        }
+
+        /* first element with seqno greater than s */
+        iterator upper_bound(seqno_t const s)
+        {
+            if (s < begin_) return begin();
+            if (s >= index_end()) return end();
+            return ++iterator(this, s);
+        }
+
+        std::pair<iterator, bool> insert(const value_type& v)
+        {
+            seqno_t const s(v.first);
+
+            assert(s != SEQNO_NONE);
+
+            if (base_.empty())
+            {
+                begin_ = s;
+                base_.push_back(v);
+            }
+            else if (s >= index_end())
+            {
+                base_.resize(s - begin_, hole_value());
+                base_.push_back(v);
+            }
+            else if (s < begin_)
+            {
+                base_.insert(base_.begin(), begin_ - s - 1, hole_value());
+                base_.push_front(v);
+                begin_ = s;
+            }
+            else if (hole(s))
+            {
+                at(s) = v;
+            }
+            else
+            {
+                return std::pair<iterator, bool>(iterator(this, s), false);
+            }
+
+            ++size_;
+            return std::pair<iterator, bool>(iterator(this, s), true);
+        }
+
+        /* hint is ignored, provided for std::map compatibility */
+        iterator insert(iterator, const value_type& v)
+        {
+            return insert(v).first;
+        }
+
+        void erase(iterator const i)
+        {
+            assert(i.c_ == this);
+            assert(!hole(i.s_));
+
+            at(i.s_) = hole_value();
+            --size_;
+            ++erased_;
+
+            if (i.s_ == begin_) trim_front();
+        }
+
+        void erase(iterator i, iterator const last)
+        {
+            while (i != last) erase(i++);
+        }
+
+        /* erases all elements past s along with the holes before them */
+        void erase_after(seqno_t const s)
+        {
+            while (!base_.empty() &&
+                   (index_end() - 1 > s || SEQNO_NONE == base_.back().first))
+            {
+                if (SEQNO_NONE != base_.back().first)
+                {
+                    --size_;
+                    ++erased_;
+                }
+                base_.pop_back();
+            }
+        }
+
+        void clear()
+        {
+            base_.clear();
+            begin_ = SEQNO_NONE;
+            size_  = 0;
+        }
+
+        /* total number of elements ever erased, clear() does not count */
+        unsigned long long erased() const { return erased_; }
+
+        seqno_t index_begin() const { return begin_; }
+        seqno_t index_end()   const { return begin_ + base_.size(); }
+
+    private:
+
+        Base      base_;
+        seqno_t   begin_; // seqno of base_.front()
+        size_type size_;  // number of non-hole elements
+        unsigned long long erased_;
+
+        static value_type hole_value()
+        {
+            return value_type(SEQNO_NONE, static_cast<const void*>(0));
+        }
+
+        bool in_range(seqno_t const s) const
+        {
+            return (s >= begin_ && s < index_end());
+        }
+
+        value_type&       at(seqno_t const s)
+        {
+            assert(in_range(s));
+            return base_[s - begin_];
+        }
+
+        const value_type& at(seqno_t const s) const
+        {
+            assert(in_range(s));
+            return base_[s - begin_];
+        }
+
+        bool hole(seqno_t const s) const
+        {
+            return (SEQNO_NONE == at(s).first);
+        }
+
+        /* pop front holes, keeping index_end() intact */
+        void trim_front()
+        {
+            while (!base_.empty() && SEQNO_NONE == base_.front().first)
+            {
+                base_.pop_front();
+                ++begin_;
+            }
+        }
+    };
+
+} /* namespace gcache */
+
+#endif /* __GCACHE_SEQNO2PTR__ */
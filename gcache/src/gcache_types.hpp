@@ -5,12 +5,11 @@
 #ifndef __GCACHE_TYPES__
 #define __GCACHE_TYPES__
 
-#include "gcache_seqno.hpp"
-#include <map>
+#include "gcache_seqno2ptr.hpp"
 
 namespace gcache
 {
-    typedef std::map<seqno_t, const void*>  seqno2ptr_t;
+    typedef Seqno2Ptr                       seqno2ptr_t;
     typedef seqno2ptr_t::iterator           seqno2ptr_iter_t;
     typedef std::pair<seqno_t, const void*> seqno2ptr_pair_t;
 
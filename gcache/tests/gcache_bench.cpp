@@ -0,0 +1,209 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ *
+ * GCache allocation and recovery microbenchmark.
+ *
+ * Drives the cache the way the replicator does for every write set:
+ * malloc(), seqno_assign(), free() after applying and seqno_release()
+ * every release interval buffers, with sizes picked with a fixed seed
+ * around the given average, and measures, separately:
+ *   alloc   - the above cycle, the ring buffer wraps many times over,
+ *   recover - reopening the cache with gcache.recover=yes and rebuilding
+ *             the seqno index from the ring buffer left behind.
+ *
+ * Usage: gcache_bench [-n buffers] [-s average buffer size]
+ *                     [-S ring buffer size] [-r release interval]
+ */
+
+#include "GCache.hpp"
+
+#include "gu_config.hpp"
+#include "gu_time.h"
+
+#include <algorithm>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct Options
+    {
+        Options()
+            :
+            bufs   (200000),
+            size   (1024),
+            rb_size(64 << 20),
+            release(128)
+        {}
+
+        long bufs;
+        long size;
+        long rb_size;
+        long release;
+    };
+
+    void usage(const char* const name)
+    {
+        fprintf(stderr, "Usage: %s [-n buffers] [-s average buffer size]"
+                " [-S ring buffer size] [-r release interval]\n", name);
+    }
+
+    /* simple LCG to be independent of libc rand() */
+    class Rand
+    {
+    public:
+        Rand() : x_(0x1234567ULL) {}
+        long operator()(long const n)
+        {
+            x_ = x_ * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<long>((x_ >> 33) % n);
+        }
+    private:
+        unsigned long long x_;
+    };
+
+    class GCacheFile
+    {
+    public:
+        GCacheFile(gu::Config& conf, const Options& opt)
+            : name_("gcache_bench.cache")
+        {
+            gcache::GCache::register_params(conf);
+            conf.set("gcache.name", name_);
+            conf.set("gcache.size", gu::to_string(opt.rb_size));
+            conf.set("gcache.page_prealloc", "0");
+            cleanup();
+        }
+
+        ~GCacheFile() { cleanup(); }
+
+    private:
+
+        void cleanup()
+        {
+            ::unlink(name_.c_str());
+            ::unlink((name_ + ".index").c_str());
+            ::unlink("gcache.page.000000");
+        }
+
+        std::string const name_;
+    };
+
+    void report(const char* const what, long long const ns, double const bytes,
+                long const bufs)
+    {
+        printf("%-12s %8.1f ns/buf, %8.1f MB/s\n", what, double(ns) / bufs,
+               bytes / (1 << 20) / (ns / 1.0e9));
+    }
+
+    long long alloc(const Options& opt, const std::vector<long>& sizes,
+                    gu::Config& conf)
+    {
+        gu::UUID const gid(NULL, 0);
+        gcache::GCache gc(conf, "");
+        gc.seqno_reset(gid, 0);
+
+        long long const t0(gu_time_monotonic());
+
+        for (long i(0); i < opt.bufs; ++i)
+        {
+            int64_t const seqno(i + 1);
+            void* const ptr(gc.malloc(sizes[i]));
+            ::memset(ptr, 0, sizeof(int64_t)); // touch it like a copy would
+            gc.seqno_assign(ptr, seqno, seqno - 1);
+            gc.free(ptr);
+
+            if (0 == seqno % opt.release) gc.seqno_release(seqno);
+        }
+
+        return gu_time_monotonic() - t0;
+    }
+
+    long long recover(const Options& opt, gu::Config& conf, long& recovered)
+    {
+        conf.set("gcache.recover", "yes");
+
+        long long const t0(gu_time_monotonic());
+        gcache::GCache gc(conf, "");
+        long long const ns(gu_time_monotonic() - t0);
+
+        int64_t const seqno_min(gc.seqno_min());
+        recovered = seqno_min > 0 ? opt.bufs - seqno_min + 1 : 0;
+
+        return ns;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options opt;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:s:S:r:")) != -1)
+    {
+        long const val(optarg ? strtol(optarg, NULL, 10) : 0);
+
+        switch (c)
+        {
+        case 'n': opt.bufs    = val; break;
+        case 's': opt.size    = val; break;
+        case 'S': opt.rb_size = val; break;
+        case 'r': opt.release = val; break;
+        default:  usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (opt.bufs <= 0 || opt.size < long(sizeof(int64_t)) ||
+        opt.rb_size < 16 * opt.size || opt.release <= 0)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gu_conf_self_tstamp_on();
+
+    /* sizes between 1/2 and 3/2 of the average */
+    Rand rnd;
+    std::vector<long> sizes(opt.bufs);
+    double bytes(0);
+    for (long i(0); i < opt.bufs; ++i)
+    {
+        sizes[i] = opt.size / 2 + rnd(opt.size + 1);
+        bytes += sizes[i];
+    }
+
+    try
+    {
+        gu::Config conf;
+        GCacheFile file(conf, opt);
+
+        long long const alloc_ns(alloc(opt, sizes, conf));
+
+        long recovered(0);
+        long long const recover_ns(recover(opt, conf, recovered));
+
+        double recovered_bytes(0);
+        for (long i(opt.bufs - recovered); i < opt.bufs; ++i)
+        {
+            recovered_bytes += sizes[i];
+        }
+
+        printf("buffers: %ld, size: %ld bytes avg, ring buffer: %ld bytes, "
+               "release interval: %ld, recovered: %ld\n",
+               opt.bufs, opt.size, opt.rb_size, opt.release, recovered);
+        report("alloc:", alloc_ns, bytes, opt.bufs);
+        report("recover:", recover_ns, recovered_bytes,
+               std::max(recovered, 1L));
+    }
+    catch (gu::Exception& e)
+    {
+        fprintf(stderr, "%s\n", e.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -4,10 +4,14 @@
  * $Id$
  */
 
+#include "GCache.hpp"
 #include "gcache_page_store.hpp"
 #include "gcache_bh.hpp"
 #include "gcache_page_test.hpp"
 
+#include <unistd.h> // usleep()
+#include <cstdio>   // remove()
+
 using namespace gcache;
 
 void ps_free (void* ptr)
@@ -115,6 +119,293 @@ START_TEST(test3) // check that all page size is efficiently used
 }
 END_TEST
 
+static void wait_spare_pages(const gcache::PageStore& ps, size_t const n)
+{
+    for (int i(0); i < 1000 && ps.spare_pages() != n; ++i) usleep(1000);
+}
+
+START_TEST(test4) // page preallocation
+{
+    const char* const dir_name = "";
+    ssize_t const keep_size = 1;
+    ssize_t const page_size = 1024;
+
+    gcache::PageStore ps (dir_name, keep_size, page_size, false, 1);
+
+    fail_if(ps.spare_pages() != 0, "no pages should be created before use");
+
+    void* ptr1 = ps.malloc (page_size);
+    fail_if (0 == ptr1);
+    fail_if(ps.count() != 1, "expected count 1, got %zu", ps.count());
+
+    wait_spare_pages(ps, 1);
+    fail_if(ps.spare_pages() != 1, "expected 1 spare page, got %zu",
+            ps.spare_pages());
+    fail_if(ps.total_pages() != 1,"expected 1 pages, got %zu",ps.total_pages());
+
+    void* ptr2 = ps.malloc (page_size); // should take the spare page
+    fail_if (0 == ptr2);
+    fail_if(ps.count()       != 2,"expected count 2, got %zu",ps.count());
+    fail_if(ps.total_pages() != 2,"expected 2 pages, got %zu",ps.total_pages());
+
+    wait_spare_pages(ps, 1);
+    fail_if(ps.spare_pages() != 1, "expected 1 spare page, got %zu",
+            ps.spare_pages());
+
+    void* ptr3 = ps.malloc (2 * page_size); // too big for the spare page
+    fail_if (0 == ptr3);
+    fail_if(ps.count()       != 3,"expected count 3, got %zu",ps.count());
+    fail_if(ps.spare_pages() != 1, "expected 1 spare page, got %zu",
+            ps.spare_pages());
+
+    ps.set_prealloc(0);
+    fail_if(ps.spare_pages() != 0, "expected 0 spare pages, got %zu",
+            ps.spare_pages());
+
+    ps_free(ptr1); ps.discard(ptr2BH(ptr1));
+    ps_free(ptr2); ps.discard(ptr2BH(ptr2));
+    ps_free(ptr3); ps.discard(ptr2BH(ptr3));
+}
+END_TEST
+
+START_TEST(test5) // page recycling
+{
+    const char* const dir_name = "";
+    ssize_t const page_size = 1024;
+    ssize_t const keep_size = page_size;
+
+    gcache::PageStore ps (dir_name, keep_size, page_size, false, 0);
+
+    void* ptr1 = ps.malloc (page_size);
+    fail_if (0 == ptr1);
+    void* ptr2 = ps.malloc (page_size);
+    fail_if (0 == ptr2);
+    fail_if(ps.count()       != 2,"expected count 2, got %zu",ps.count());
+    fail_if(ps.total_pages() != 2,"expected 2 pages, got %zu",ps.total_pages());
+
+    ps_free(ptr1); ps.discard(ptr2BH(ptr1)); // first page goes to spares
+
+    fail_if(ps.total_pages() != 1,"expected 1 pages, got %zu",ps.total_pages());
+    fail_if(ps.spare_pages() != 1, "expected 1 spare page, got %zu",
+            ps.spare_pages());
+
+    void* ptr3 = ps.malloc (page_size); // reuses the first page
+    fail_if (0 == ptr3);
+    fail_if (ptr3 != ptr1, "expected the page to be reused: %p, got %p",
+             ptr1, ptr3);
+    fail_if(ps.count()       != 3,"expected count 3, got %zu",ps.count());
+    fail_if(ps.total_pages() != 2,"expected 2 pages, got %zu",ps.total_pages());
+    fail_if(ps.spare_pages() != 0, "expected 0 spare pages, got %zu",
+            ps.spare_pages());
+
+    ps.set_keep_size(0);
+    ps_free(ptr2); ps.discard(ptr2BH(ptr2)); // pool is full, page is deleted
+    fail_if(ps.total_pages() != 1,"expected 1 pages, got %zu",ps.total_pages());
+    fail_if(ps.spare_pages() != 0, "expected 0 spare pages, got %zu",
+            ps.spare_pages());
+
+    ps_free(ptr3); ps.discard(ptr2BH(ptr3));
+}
+END_TEST
+
+START_TEST(test7) // flushing full pages
+{
+    const char* const dir_name = "";
+    ssize_t const page_size = 1 << 16;
+    ssize_t const keep_size = 0;
+
+    gcache::PageStore ps (dir_name, keep_size, page_size, false, 0, true);
+
+    void* const ptr1 = ps.malloc (page_size);
+    fail_if (0 == ptr1);
+    ::memset(ptr1, 'a', page_size - sizeof(BufferHeader));
+
+    void* const ptr2 = ps.malloc (page_size); // first page gets flushed
+    fail_if (0 == ptr2);
+    ::memset(ptr2, 'b', page_size - sizeof(BufferHeader));
+
+    void* const ptr3 = ps.malloc (page_size); // second page gets flushed
+    fail_if (0 == ptr3);
+    fail_if(ps.total_pages() != 3,"expected 3 pages, got %zu",ps.total_pages());
+
+    usleep(100000);
+
+    // flushed pages must read back the same
+    for (size_t i(0); i < page_size - sizeof(BufferHeader); ++i)
+    {
+        fail_if (static_cast<char*>(ptr1)[i] != 'a', "at %zu", i);
+    }
+
+    ps_free(ptr1); ps.discard(ptr2BH(ptr1));
+    ps_free(ptr2); ps.discard(ptr2BH(ptr2)); // may be still in flush queue
+    fail_if(ps.total_pages() != 1,"expected 1 pages, got %zu",ps.total_pages());
+
+    ps.set_flush(false);
+    ps_free(ptr3); ps.discard(ptr2BH(ptr3));
+}
+END_TEST
+
+static void fill_page_buf(void* const ptr, ssize_t const size, int const seed)
+{
+    uint8_t* const buf(static_cast<uint8_t*>(ptr));
+    for (ssize_t i(0); i < size; ++i) buf[i] = seed + (i & 0x0f);
+}
+
+START_TEST(test6) // compressed page history
+{
+    const char* const rb_name = "gcache_page_test.cache";
+    ssize_t const buf_size = 1 << 18;
+    int64_t const n_bufs = 8;
+
+    gu::Config conf;
+    gcache::GCache::register_params(conf);
+    conf.set("gcache.name", rb_name);
+    conf.set("gcache.size", "0");
+    conf.set("gcache.page_size", "1M");
+    conf.set("gcache.keep_pages_size", "16M");
+    conf.set("gcache.page_compression", "yes");
+
+    {
+        gcache::GCache gc(conf, "");
+        gc.seqno_reset(gu::UUID(0, 0), 0);
+
+        for (int64_t s(1); s <= n_bufs; ++s)
+        {
+            void* const ptr(gc.malloc(buf_size));
+            fail_if(0 == ptr);
+            fail_if(BUFFER_IN_PAGE != ptr2BH(ptr)->store);
+            fill_page_buf(ptr, buf_size, s);
+            gc.seqno_assign(ptr, s, s - 1);
+            gc.free(ptr);
+        }
+
+        /* released buffers must be kept */
+        fail_if(gc.seqno_min() != 1, "expected seqno_min 1, got %lld",
+                static_cast<long long>(gc.seqno_min()));
+
+        std::vector<gcache::GCache::Buffer> v(n_bufs);
+        fail_if(gc.seqno_get_buffers(v, 1) != size_t(n_bufs));
+
+        for (int64_t s(1); s <= n_bufs; ++s)
+        {
+            const gcache::GCache::Buffer& b(v[s - 1]);
+            fail_if(b.seqno_g() != s);
+            fail_if(b.seqno_d() != s - 1);
+            fail_if(b.size() != buf_size, "expected size %zd, got %zd",
+                    buf_size, ssize_t(b.size()));
+            fail_if(BH_is_compressed(ptr2BH(b.ptr())));
+
+            std::vector<uint8_t> expected(buf_size);
+            fill_page_buf(&expected[0], buf_size, s);
+            fail_if(memcmp(&expected[0], b.ptr(), buf_size),
+                    "buffer %lld contents mismatch", static_cast<long long>(s));
+        }
+
+        int64_t seqno_d;
+        ssize_t size;
+        fail_if(gc.seqno_get_ptr(n_bufs, seqno_d, size) == 0);
+        fail_if(seqno_d != n_bufs - 1);
+        fail_if(size != buf_size);
+
+        gc.seqno_unlock();
+
+        /* without compression page buffers are discarded on release,
+         * and so is all the history before them */
+        gc.param_set("gcache.page_compression", "no");
+
+        void* const ptr(gc.malloc(buf_size));
+        fail_if(0 == ptr);
+        gc.seqno_assign(ptr, n_bufs + 1, n_bufs);
+        gc.free(ptr);
+
+        fail_if(gc.seqno_min() != -1, "expected empty history, got %lld",
+                static_cast<long long>(gc.seqno_min()));
+
+        gcache::GCache::Stats stats;
+        gc.stats_get(stats);
+        fail_if(stats.rb_overflows != n_bufs + 1, "expected %lld overflows, "
+                "got %lld", static_cast<long long>(n_bufs + 1),
+                stats.rb_overflows);
+        fail_if(stats.evicted != n_bufs + 1, "expected %lld evicted, got %lld",
+                static_cast<long long>(n_bufs + 1), stats.evicted);
+        fail_if(stats.pages == 0); // kept within keep_pages_size
+        fail_if(stats.pages_bytes > (16 << 20), "pages bytes %zu",
+                stats.pages_bytes);
+    }
+
+    ::remove(rb_name);
+    ::remove((std::string(rb_name) + ".index").c_str());
+}
+END_TEST
+
+START_TEST(test8) // large buffers bypass the ring buffer
+{
+    const char* const rb_name = "gcache_page_test.cache";
+    ssize_t const small_size = 1 << 10;
+    ssize_t const large_size = 1 << 18;
+
+    gu::Config conf;
+    gcache::GCache::register_params(conf);
+    conf.set("gcache.name", rb_name);
+    conf.set("gcache.size", "1M");
+    conf.set("gcache.page_size", "1M");
+    conf.set("gcache.large_buffer_size", "64K");
+
+    {
+        gcache::GCache gc(conf, "");
+        gc.seqno_reset(gu::UUID(0, 0), 0);
+
+        int64_t const n_bufs(21);
+        int64_t const large_seqno(11);
+
+        for (int64_t s(1); s <= n_bufs; ++s)
+        {
+            ssize_t const size(s == large_seqno ? large_size : small_size);
+            void* const ptr(gc.malloc(size));
+            fail_if(0 == ptr);
+            fail_if((s == large_seqno ? BUFFER_IN_PAGE : BUFFER_IN_RB) !=
+                    ptr2BH(ptr)->store, "seqno %lld in wrong store",
+                    static_cast<long long>(s));
+            gc.seqno_assign(ptr, s, s - 1);
+            gc.free(ptr);
+        }
+
+        /* released large buffer stays in history along with small ones */
+        fail_if(gc.seqno_min() != 1, "expected seqno_min 1, got %lld",
+                static_cast<long long>(gc.seqno_min()));
+
+        std::vector<gcache::GCache::Buffer> v(n_bufs);
+        fail_if(gc.seqno_get_buffers(v, 1) != size_t(n_bufs));
+        fail_if(v[large_seqno - 1].size() != large_size);
+        gc.seqno_unlock();
+
+        gcache::GCache::Stats stats;
+        gc.stats_get(stats);
+        fail_if(stats.large_buffers != 1, "large buffers: %lld",
+                stats.large_buffers);
+        fail_if(stats.rb_overflows != 0, "overflows: %lld",
+                stats.rb_overflows);
+        fail_if(stats.pages != 1, "pages: %zu", stats.pages);
+
+        /* once the ring wraps past it, the large buffer goes too */
+        for (int64_t s(n_bufs + 1); s <= n_bufs + 2048; ++s)
+        {
+            void* const ptr(gc.malloc(small_size));
+            fail_if(0 == ptr);
+            fail_if(BUFFER_IN_RB != ptr2BH(ptr)->store);
+            gc.seqno_assign(ptr, s, s - 1);
+            gc.free(ptr);
+        }
+
+        fail_if(gc.seqno_min() <= large_seqno, "seqno_min %lld",
+                static_cast<long long>(gc.seqno_min()));
+    }
+
+    ::remove(rb_name);
+    ::remove((std::string(rb_name) + ".index").c_str());
+}
+END_TEST
+
 Suite* gcache_page_suite()
 {
     Suite* s = suite_create("gcache::PageStore");
@@ -124,6 +415,11 @@ Suite* gcache_page_suite()
     tcase_add_test(tc, test1);
     tcase_add_test(tc, test2);
     tcase_add_test(tc, test3);
+    tcase_add_test(tc, test4);
+    tcase_add_test(tc, test5);
+    tcase_add_test(tc, test6);
+    tcase_add_test(tc, test7);
+    tcase_add_test(tc, test8);
     suite_add_tcase(s, tc);
 
     return s;
@@ -6,12 +6,15 @@
 
 #define GCACHE_RB_UNIT_TEST
 
+#include "GCache.hpp"
 #include "gcache_rb_store.hpp"
 #include "gcache_bh.hpp"
 #include "gcache_rb_test.hpp"
 
 #include "gu_logger.hpp"
 
+#include <unistd.h> // usleep()
+
 using namespace gcache;
 
 static gu::UUID    const GID(NULL, 0);
@@ -25,10 +28,11 @@ static size_type ALLOC_SIZE(size_type s) { return (s + BH_SIZE); }
 START_TEST(test1)
 {
     ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
 
     size_t const rb_size(ALLOC_SIZE(2) * 2);
 
-    std::map<int64_t, const void*> s2p;
+    seqno2ptr_t s2p;
     gu::UUID   gid(GID);
     RingBuffer rb(RB_NAME, rb_size, s2p, gid, false);
 
@@ -400,6 +404,7 @@ START_TEST(recovery)
     }
 
     ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
 
     /* test for singe segment in the middle */
     void* third_buffer(NULL);
@@ -488,9 +493,315 @@ START_TEST(recovery)
     }
 
     ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
+}
+END_TEST
+
+START_TEST(read_ahead)
+{
+    ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
+
+    size_type const buf_size(1 << 16);
+    size_t    const rb_size(ALLOC_SIZE(buf_size) * 2 + buf_size / 2);
+
+    {
+        seqno2ptr_t s2p;
+        gu::UUID   gid(GID);
+        RingBuffer rb(RB_NAME, rb_size, s2p, gid, false);
+
+        void* const buf1(rb.malloc(ALLOC_SIZE(buf_size) + BH_SIZE));
+        fail_if (NULL == buf1);
+        void* const buf2(rb.malloc(ALLOC_SIZE(buf_size)));
+        fail_if (NULL == buf2);
+        ::memset(buf2, 'x', buf_size);
+
+        BH_release(ptr2BH(buf1));
+        rb.free(ptr2BH(buf1));
+
+        // should wrap around to the start of the ring
+        void* const buf3(rb.malloc(ALLOC_SIZE(buf_size)));
+        fail_if (NULL == buf3);
+        fail_if (buf3 >= buf2, "buf3 %p expected before buf2 %p", buf3, buf2);
+        ::memset(buf3, 'y', buf_size);
+
+        rb.read_ahead(buf2, buf3, false); // wrapped range
+        rb.read_ahead(buf3, buf3, true);  // buf2 is not needed any more
+        rb.read_done();
+
+        // hints must not affect contents
+        for (size_type i(0); i < buf_size; ++i)
+        {
+            fail_if (static_cast<char*>(buf2)[i] != 'x', "at %zu", size_t(i));
+            fail_if (static_cast<char*>(buf3)[i] != 'y', "at %zu", size_t(i));
+        }
+
+        BH_release(ptr2BH(buf2));
+        rb.free(ptr2BH(buf2));
+        BH_release(ptr2BH(buf3));
+        rb.free(ptr2BH(buf3));
+    }
+
+    ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
+}
+END_TEST
+
+START_TEST(recovery_background)
+{
+    ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
+
+    int64_t const n_bufs(16);
+
+    gu::Config conf;
+    GCache::register_params(conf);
+    conf.set("gcache.name", RB_NAME);
+    conf.set("gcache.size", "1M");
+    conf.set("gcache.page_size", "1M");
+    conf.set("gcache.recover", "yes");
+
+    gu::UUID const gid(NULL, 0);
+
+    {
+        GCache gc(conf, "");
+        gc.seqno_reset(gid, 0);
+
+        for (int64_t s(1); s <= n_bufs; ++s)
+        {
+            void* const ptr(gc.malloc(128));
+            fail_if (NULL == ptr);
+            ::memset(ptr, int(s), 128);
+            gc.seqno_assign(ptr, s, s - 1);
+            gc.free(ptr);
+        }
+    }
+
+    conf.set("gcache.recover_background", "yes");
+
+    {
+        GCache gc(conf, "");
+
+        /* history must not be advertised until recovered */
+        if (gc.recovering_bg()) fail_if (gc.seqno_min() != -1);
+
+        /* the same call ReplicatorSMM makes on startup, must not block */
+        gc.seqno_reset(gid, n_bufs);
+
+        std::vector<GCache::Buffer> v(n_bufs);
+        fail_if (gc.seqno_get_buffers(v, 1) != size_t(n_bufs));
+        fail_if (gc.recovering_bg());
+        fail_if (gc.seqno_min() != 1, "expected seqno_min 1, got %lld",
+                 static_cast<long long>(gc.seqno_min()));
+
+        for (int64_t s(1); s <= n_bufs; ++s)
+        {
+            const GCache::Buffer& b(v[s - 1]);
+            fail_if (b.seqno_g() != s);
+            fail_if (b.size() != 128);
+            fail_if (b.ptr()[0] != gu::byte_t(s));
+        }
+    }
+
+    ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
 }
 END_TEST
 
+START_TEST(pin)
+{
+    ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
+
+    ssize_t const buf_size(1 << 16);
+    int64_t const n_bufs(32); // twice the ring buffer size
+
+    gu::Config conf;
+    GCache::register_params(conf);
+    conf.set("gcache.name", RB_NAME);
+    conf.set("gcache.size", "1M");
+    conf.set("gcache.page_size", "1M");
+
+    {
+        GCache gc(conf, "");
+        gc.seqno_reset(GID, 0);
+
+        gc.seqno_pin(1);
+        gc.param_set("gcache.pin_seqno", "1"); // second pin, through param
+
+        for (int64_t s(1); s <= n_bufs; ++s)
+        {
+            void* const ptr(gc.malloc(buf_size));
+            fail_if (NULL == ptr);
+            gc.seqno_assign(ptr, s, s - 1);
+            gc.seqno_release(s);
+        }
+
+        /* all history must be there in spite of ring buffer overflow */
+        fail_if (gc.seqno_min() != 1, "expected seqno_min 1, got %lld",
+                 static_cast<long long>(gc.seqno_min()));
+        std::vector<GCache::Buffer> v(n_bufs);
+        fail_if (gc.seqno_get_buffers(v, 1) != size_t(n_bufs));
+        gc.seqno_unlock();
+
+        gc.seqno_unpin(1);
+        fail_if (gc.seqno_min() != 1); // still pinned by param
+
+        gc.param_set("gcache.pin_seqno", "-1");
+
+        /* deferred release done: history can't be pinned and gets
+         * discarded to make room */
+        try
+        {
+            gc.seqno_pin(1);
+            fail("pinning released seqno must fail");
+        }
+        catch (gu::NotFound&) {}
+
+        for (int64_t s(n_bufs + 1); s <= 2 * n_bufs; ++s)
+        {
+            void* const ptr(gc.malloc(buf_size));
+            fail_if (NULL == ptr);
+            gc.seqno_assign(ptr, s, s - 1);
+            gc.seqno_release(s);
+        }
+
+        fail_if (gc.seqno_min() <= n_bufs, "expected seqno_min > %lld, "
+                 "got %lld", static_cast<long long>(n_bufs),
+                 static_cast<long long>(gc.seqno_min()));
+    }
+
+    ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
+}
+END_TEST
+
+START_TEST(truncate)
+{
+    ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
+
+    ssize_t const buf_size(1 << 12);
+    int64_t const n_bufs(10);
+    int64_t const reset_seqno(7);
+
+    gu::Config conf;
+    GCache::register_params(conf);
+    conf.set("gcache.name", RB_NAME);
+    conf.set("gcache.size", "1M");
+    conf.set("gcache.page_size", "1M");
+
+    {
+        GCache gc(conf, "");
+        gc.seqno_reset(GID, 0);
+
+        for (int64_t s(1); s <= n_bufs; ++s)
+        {
+            void* const ptr(gc.malloc(buf_size));
+            fail_if (NULL == ptr);
+            gc.seqno_assign(ptr, s, s - 1);
+            gc.seqno_release(s);
+        }
+
+        /* position within the same history: only the tail goes */
+        gc.seqno_reset(GID, reset_seqno);
+        fail_if (gc.seqno_min() != 1, "expected seqno_min 1, got %lld",
+                 static_cast<long long>(gc.seqno_min()));
+
+        int64_t seqno_d;
+        ssize_t size;
+        fail_if (gc.seqno_get_ptr(reset_seqno, seqno_d, size) == NULL);
+        gc.seqno_unlock();
+
+        try
+        {
+            gc.seqno_get_ptr(reset_seqno + 1, seqno_d, size);
+            fail("seqno %lld must be gone",
+                 static_cast<long long>(reset_seqno + 1));
+        }
+        catch (gu::NotFound&) {}
+
+        GCache::Stats stats;
+        gc.stats_get(stats);
+        fail_if (stats.evicted != n_bufs - reset_seqno, "evicted: %lld",
+                 stats.evicted);
+
+        /* history continues from the new position */
+        for (int64_t s(reset_seqno + 1); s <= n_bufs + 2; ++s)
+        {
+            void* const ptr(gc.malloc(buf_size));
+            fail_if (NULL == ptr);
+            gc.seqno_assign(ptr, s, s - 1);
+            gc.seqno_release(s);
+        }
+
+        std::vector<GCache::Buffer> v(n_bufs + 2);
+        fail_if (gc.seqno_get_buffers(v, 1) != size_t(n_bufs + 2));
+        gc.seqno_unlock();
+
+        /* different history is discarded completely */
+        gc.seqno_reset(gu::UUID(0, 0), reset_seqno);
+        fail_if (gc.seqno_min() != -1, "expected empty history, got %lld",
+                 static_cast<long long>(gc.seqno_min()));
+    }
+
+    ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
+}
+END_TEST
+
+START_TEST(lock_in_memory)
+{
+    ::unlink(RB_NAME.c_str());
+
+    gu::Config conf;
+    GCache::register_params(conf);
+    conf.set("gcache.name", RB_NAME);
+    conf.set("gcache.size", "4M");
+    conf.set("gcache.page_size", "1M");
+    conf.set("gcache.lock_in_memory", "yes");
+
+    {
+        GCache gc(conf, "");
+        gc.seqno_reset(GID, 0);
+
+        /* locking goes on in the background, allocations work meanwhile */
+        void* const ptr(gc.malloc(128));
+        fail_if (NULL == ptr);
+        ::memset(ptr, 1, 128);
+        gc.seqno_assign(ptr, 1, 0);
+        gc.free(ptr);
+
+        GCache::Stats stats;
+        for (int i(0); i < 100; ++i)
+        {
+            gc.stats_get(stats);
+            if (stats.rb_locked >= 4 << 20) break;
+            usleep(100000);
+        }
+
+        fail_if (stats.rb_locked < 4 << 20, "locked %zu bytes",
+                 stats.rb_locked);
+        fail_if (stats.rb_resident < 4 << 20, "resident %zu bytes",
+                 stats.rb_resident);
+        fail_if (stats.rb_resident > stats.rb_locked, "resident %zu bytes",
+                 stats.rb_resident);
+
+        try
+        {
+            gc.param_set("gcache.lock_in_memory", "no");
+            fail("gcache.lock_in_memory was changed in runtime");
+        }
+        catch (gu::Exception& e)
+        {
+            fail_if (e.get_errno() != EPERM);
+        }
+    }
+
+    ::unlink(RB_NAME.c_str());
+    ::unlink((RB_NAME + ".index").c_str());
+}
+END_TEST
 
 Suite* gcache_rb_suite()
 {
@@ -507,5 +818,35 @@ Suite* gcache_rb_suite()
     tcase_add_test(tc, recovery);
     suite_add_tcase(ts, tc);
 
+    tc = tcase_create("read_ahead");
+
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, read_ahead);
+    suite_add_tcase(ts, tc);
+
+    tc = tcase_create("recovery_background");
+
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, recovery_background);
+    suite_add_tcase(ts, tc);
+
+    tc = tcase_create("pin");
+
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, pin);
+    suite_add_tcase(ts, tc);
+
+    tc = tcase_create("truncate");
+
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, truncate);
+    suite_add_tcase(ts, tc);
+
+    tc = tcase_create("lock_in_memory");
+
+    tcase_set_timeout(tc, 60);
+    tcase_add_test(tc, lock_in_memory);
+    suite_add_tcase(ts, tc);
+
     return ts;
 }
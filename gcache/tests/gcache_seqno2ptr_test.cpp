@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ */
+
+#include "gcache_types.hpp"
+#include "gcache_seqno2ptr_test.hpp"
+
+using namespace gcache;
+
+static const void* ptr(seqno_t const s)
+{
+    return reinterpret_cast<const void*>(s << 4);
+}
+
+START_TEST(test_basic)
+{
+    seqno2ptr_t s2p;
+
+    fail_if(!s2p.empty());
+    fail_if(s2p.begin() != s2p.end());
+    fail_if(s2p.find(1) != s2p.end());
+    fail_if(s2p.upper_bound(0) != s2p.end());
+
+    for (seqno_t s(5); s <= 10; ++s)
+    {
+        s2p.insert(s2p.end(), seqno2ptr_pair_t(s, ptr(s)));
+    }
+
+    fail_if(s2p.size() != 6);
+    fail_if(s2p.begin()->first != 5);
+    fail_if(s2p.rbegin()->first != 10);
+    fail_if(s2p.find(7)->second != ptr(7));
+    fail_if(s2p.find(11) != s2p.end());
+    fail_if(s2p.find(4)  != s2p.end());
+
+    /* duplicate */
+    std::pair<seqno2ptr_iter_t, bool> res
+        (s2p.insert(seqno2ptr_pair_t(7, ptr(8))));
+    fail_if(res.second);
+    fail_if(res.first->second != ptr(7));
+
+    /* gaps on both sides */
+    fail_if(!s2p.insert(seqno2ptr_pair_t(13, ptr(13))).second);
+    fail_if(!s2p.insert(seqno2ptr_pair_t(2,  ptr(2))).second);
+    fail_if(s2p.size() != 8);
+    fail_if(s2p.find(12) != s2p.end());
+    fail_if(s2p.find(3)  != s2p.end());
+    fail_if(s2p.upper_bound(10)->first != 13);
+    fail_if(s2p.upper_bound(2)->first  != 5);
+    fail_if(s2p.upper_bound(1)->first  != 2);
+    fail_if(s2p.upper_bound(13) != s2p.end());
+
+    /* iteration skips gaps in both directions */
+    seqno_t const expect[] = { 2, 5, 6, 7, 8, 9, 10, 13 };
+    size_t n(0);
+    for (seqno2ptr_t::iterator i(s2p.begin()); i != s2p.end(); ++i, ++n)
+    {
+        fail_if(i->first != expect[n], "expected %lld, got %lld",
+                static_cast<long long>(expect[n]),
+                static_cast<long long>(i->first));
+        fail_if(i->second != ptr(i->first));
+    }
+    fail_if(n != s2p.size());
+
+    for (seqno2ptr_t::reverse_iterator r(s2p.rbegin()); r != s2p.rend(); ++r)
+    {
+        fail_if(r->first != expect[--n]);
+    }
+    fail_if(n != 0);
+
+    /* erase in the middle leaves a gap, erase at front trims the gaps */
+    s2p.erase(s2p.find(8));
+    fail_if(s2p.find(8) != s2p.end());
+    fail_if(s2p.upper_bound(7)->first != 9);
+
+    seqno2ptr_iter_t i(s2p.begin());
+    s2p.erase(i++);
+    fail_if(i->first != 5);
+    fail_if(s2p.begin()->first != 5);
+    fail_if(s2p.index_begin() != 5);
+
+    s2p.erase(s2p.begin(), s2p.find(10));
+    fail_if(s2p.begin()->first != 10);
+    fail_if(s2p.size() != 2);
+
+    /* end() is stable when erasing up to the last element */
+    seqno2ptr_iter_t const end(s2p.end());
+    s2p.erase(s2p.begin(), s2p.end());
+    fail_if(!s2p.empty());
+    fail_if(s2p.end() != end);
+
+    s2p[20] = ptr(20);
+    fail_if(s2p.size() != 1);
+    fail_if(s2p.begin()->first != 20);
+    fail_if(s2p[20] != ptr(20));
+
+    /* erase_after() cuts the tail, gaps included */
+    for (seqno_t s(21); s <= 25; ++s) s2p[s] = ptr(s);
+    s2p.erase(s2p.find(23));
+    s2p.erase_after(23);
+    fail_if(s2p.size() != 3, "size: %zu", s2p.size());
+    fail_if(s2p.rbegin()->first != 22);
+    fail_if(s2p.index_end() != 23);
+    s2p.erase_after(19);
+    fail_if(!s2p.empty());
+
+    s2p.clear();
+    fail_if(!s2p.empty());
+    fail_if(s2p.begin() != s2p.end());
+}
+END_TEST
+
+Suite* gcache_seqno2ptr_suite()
+{
+    Suite* s = suite_create("gcache::seqno2ptr");
+    TCase* tc;
+
+    tc = tcase_create("test");
+    tcase_add_test(tc, test_basic);
+    suite_add_tcase(s, tc);
+
+    return s;
+}
@@ -13,28 +13,48 @@
 #include "gcomm/conf.hpp"
 
 #include "gu_logger.hpp"
+#include "gu_thread.hpp"
 
 #include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
 
 #include <fstream>
+#include <cstring>
 
 
 gcomm::AsioProtonet::AsioProtonet(gu::Config& conf, int version)
     :
     gcomm::Protonet(conf, "asio", version),
     mutex_(),
+    lock_depth_(0),
     poll_until_(gu::datetime::Date::max()),
     io_service_(),
     timer_(io_service_),
 #ifdef HAVE_ASIO_SSL_HPP
     ssl_context_(io_service_, asio::ssl::context::sslv23),
+    hs_io_service_(),
+    hs_work_(0),
+    hs_threads_(),
 #endif // HAVE_ASIO_SSL_HPP
     mtu_(1 << 15),
     checksum_(NetHeader::checksum_type(
                   conf.get<int>(gcomm::Conf::SocketChecksum,
-                                NetHeader::CS_CRC32C)))
+                                NetHeader::CS_CRC32C))),
+    recv_pool_(new BufferPool()),
+    io_mtx_(),
+    io_cond_(),
+    io_threads_(),
+    io_gen_(0),
+    io_open_(false),
+    io_running_(0),
+    io_stop_(false),
+    io_error_(),
+    io_errno_(0),
+    timer_cond_(),
+    timer_thd_(),
+    timer_running_(false),
+    timer_stop_(false)
 {
     conf.set(gcomm::Conf::SocketChecksum, checksum_);
 #ifdef HAVE_ASIO_SSL_HPP
@@ -55,22 +75,332 @@ gcomm::AsioProtonet::AsioProtonet(gu::Config& conf, int version)
         gu::ssl_prepare_context(conf_, ssl_context_);
     }
 #endif // HAVE_ASIO_SSL_HPP
+
+    int const io_threads(conf_.get<int>(gcomm::Conf::ProtonetIoThreads, 1));
+    if (io_threads < 1)
+    {
+        gu_throw_error(EINVAL) << "invalid value " << io_threads << " for "
+                               << gcomm::Conf::ProtonetIoThreads;
+    }
+    start_io_threads(io_threads - 1);
+
+#ifdef HAVE_ASIO_SSL_HPP
+    int const hs_threads(conf_.get<int>(gcomm::Conf::ProtonetHandshakeThreads,
+                                        0));
+    if (hs_threads < 0)
+    {
+        stop_io_threads();
+        gu_throw_error(EINVAL) << "invalid value " << hs_threads << " for "
+                               << gcomm::Conf::ProtonetHandshakeThreads;
+    }
+    if (use_ssl == true) start_hs_threads(hs_threads);
+#endif // HAVE_ASIO_SSL_HPP
+
+    try
+    {
+        start_timer_thread(conf_.get(gcomm::Conf::ProtonetTimerThreadPrio,
+                                     ""));
+    }
+    catch (...)
+    {
+#ifdef HAVE_ASIO_SSL_HPP
+        stop_hs_threads();
+#endif // HAVE_ASIO_SSL_HPP
+        stop_io_threads();
+        throw;
+    }
 }
 
 gcomm::AsioProtonet::~AsioProtonet()
 {
+    stop_timer_thread();
+#ifdef HAVE_ASIO_SSL_HPP
+    stop_hs_threads();
+#endif // HAVE_ASIO_SSL_HPP
+    stop_io_threads();
+}
+
+#ifdef HAVE_ASIO_SSL_HPP
+void gcomm::AsioProtonet::start_hs_threads(int const n)
+{
+    if (n == 0) return;
+
+    hs_work_ = new asio::io_service::work(hs_io_service_);
 
+    for (int i(0); i < n; ++i)
+    {
+        pthread_t t;
+        int const err(pthread_create(&t, NULL, hs_thread, this));
+
+        if (0 != err)
+        {
+            log_warn << "Failed to start protonet handshake thread: " << err
+                     << " (" << strerror(err) << "). Running with "
+                     << hs_threads_.size() << " handshake threads.";
+            break;
+        }
+
+        hs_threads_.push_back(t);
+    }
+
+    if (hs_threads_.empty() == false)
+    {
+        log_info << "protonet running with " << hs_threads_.size()
+                 << " SSL handshake threads";
+    }
+    else
+    {
+        delete hs_work_;
+        hs_work_ = 0;
+    }
+}
+
+void gcomm::AsioProtonet::stop_hs_threads()
+{
+    delete hs_work_;
+    hs_work_ = 0;
+    // don't wait for handshakes with peers that went silent
+    hs_io_service_.stop();
+
+    for (size_t i(0); i < hs_threads_.size(); ++i)
+    {
+        pthread_join(hs_threads_[i], NULL);
+    }
+    hs_threads_.clear();
+}
+
+void* gcomm::AsioProtonet::hs_thread(void* arg)
+{
+    AsioProtonet* const pnet(static_cast<AsioProtonet*>(arg));
+    while (true)
+    {
+        try
+        {
+            pnet->hs_io_service_.run();
+            break;
+        }
+        catch (std::exception& e)
+        {
+            // keep serving the other handshakes
+            log_warn << "exception in protonet handshake thread: "
+                     << e.what();
+        }
+    }
+    return NULL;
+}
+#endif // HAVE_ASIO_SSL_HPP
+
+void gcomm::AsioProtonet::start_io_threads(int const n)
+{
+    for (int i(0); i < n; ++i)
+    {
+        pthread_t t;
+        int const err(pthread_create(&t, NULL, io_thread, this));
+
+        if (0 != err)
+        {
+            log_warn << "Failed to start protonet I/O thread: " << err
+                     << " (" << strerror(err) << "). Running with "
+                     << io_threads_.size() + 1 << " I/O threads.";
+            break;
+        }
+
+        io_threads_.push_back(t);
+    }
+
+    if (io_threads_.empty() == false)
+    {
+        log_info << "protonet running with " << io_threads_.size() + 1
+                 << " I/O threads";
+    }
+}
+
+void gcomm::AsioProtonet::stop_io_threads()
+{
+    {
+        gu::Lock lock(io_mtx_);
+        io_stop_ = true;
+        io_cond_.broadcast();
+    }
+
+    for (size_t i(0); i < io_threads_.size(); ++i)
+    {
+        pthread_join(io_threads_[i], NULL);
+    }
+    io_threads_.clear();
+}
+
+void* gcomm::AsioProtonet::io_thread(void* arg)
+{
+    static_cast<AsioProtonet*>(arg)->io_loop();
+    return NULL;
+}
+
+// Helper threads enter io_service_.run() once per event_loop() round.
+// The round is closed by event_loop() before the next io_service_.reset(),
+// late comers wait for the next round.
+void gcomm::AsioProtonet::io_loop()
+{
+    long long gen(0);
+
+    while (true)
+    {
+        {
+            gu::Lock lock(io_mtx_);
+            while (io_stop_ == false && (io_open_ == false || io_gen_ == gen))
+            {
+                lock.wait(io_cond_);
+            }
+            if (io_stop_ == true) return;
+            gen = io_gen_;
+            ++io_running_;
+        }
+
+        io_run();
+
+        {
+            gu::Lock lock(io_mtx_);
+            --io_running_;
+            io_cond_.broadcast();
+        }
+    }
+}
+
+void gcomm::AsioProtonet::io_run()
+{
+    std::string what;
+    int         err(0);
+
+    try
+    {
+        io_service_.run();
+        return;
+    }
+    catch (gu::Exception& e)
+    {
+        what = e.what();
+        err  = e.get_errno();
+    }
+    catch (asio::system_error& e)
+    {
+        what = e.what();
+        err  = e.code().value();
+    }
+
+    // let event_loop() rethrow it in the protonet thread
+    io_service_.stop();
+    gu::Lock lock(io_mtx_);
+    if (io_error_.empty() == true)
+    {
+        io_error_ = what;
+        io_errno_ = err;
+    }
+}
+
+void gcomm::AsioProtonet::start_timer_thread(const std::string& prio)
+{
+    if (prio.empty() == true) return;
+
+    // throws on malformed value
+    gu::ThreadSchedparam const sp(prio);
+
+    int const err(pthread_create(&timer_thd_, NULL, timer_thread, this));
+    if (0 != err)
+    {
+        log_warn << "Failed to start protonet timer thread: " << err
+                 << " (" << strerror(err) << "). Timers are handled by "
+                 << "I/O threads only.";
+        return;
+    }
+    timer_running_ = true;
+
+    try
+    {
+        gu::thread_set_schedparam(timer_thd_, sp);
+        log_info << "protonet timer thread running with " << sp;
+    }
+    catch (gu::Exception& e)
+    {
+        log_warn << "Failed to set protonet timer thread priority to " << sp
+                 << ": " << e.what() << ". Running with default priority.";
+    }
+}
+
+void gcomm::AsioProtonet::stop_timer_thread()
+{
+    if (timer_running_ == false) return;
+
+    {
+        gu::Lock lock(io_mtx_);
+        timer_stop_ = true;
+        timer_cond_.signal();
+    }
+
+    pthread_join(timer_thd_, NULL);
+    timer_running_ = false;
+}
+
+void* gcomm::AsioProtonet::timer_thread(void* arg)
+{
+    static_cast<AsioProtonet*>(arg)->timer_loop();
+    return NULL;
+}
+
+// Runs expired timers and sleeps until the next one is due. Timers set
+// meanwhile by protocol processing are picked up within max_sleep, they are
+// also handled by event_loop() as before.
+void gcomm::AsioProtonet::timer_loop()
+{
+    static gu::datetime::Period const max_sleep(gu::datetime::Sec/10);
+
+    gu::datetime::Date next(gu::datetime::Date::now());
+
+    while (true)
+    {
+        {
+            gu::Lock lock(io_mtx_);
+            while (timer_stop_ == false && gu::datetime::Date::now() < next)
+            {
+                try
+                {
+                    lock.wait(timer_cond_, next);
+                }
+                catch (gu::Exception& e)
+                {
+                    if (e.get_errno() != ETIMEDOUT) throw;
+                }
+            }
+            if (timer_stop_ == true) return;
+        }
+
+        try
+        {
+            next = handle_timers();
+        }
+        catch (std::exception& e)
+        {
+            // leave it to event_loop() to run into it again and
+            // propagate it from the protonet thread
+            log_warn << "exception in protonet timer thread: " << e.what()
+                     << ", timers are handled by I/O threads only";
+            return;
+        }
+
+        next = std::min(next, gu::datetime::Date::now() + max_sleep);
+    }
 }
 
 void gcomm::AsioProtonet::enter()
 {
     mutex_.lock();
+    ++lock_depth_;
 }
 
 
 
 void gcomm::AsioProtonet::leave()
 {
+    --lock_depth_;
     mutex_.unlock();
 }
 
@@ -118,7 +448,64 @@ void gcomm::AsioProtonet::event_loop(const gu::datetime::Period& period)
     timer_.expires_from_now(boost::posix_time::nanosec(p.get_nsecs()));
     timer_.async_wait(boost::bind(&AsioProtonet::handle_wait, this,
                                   asio::placeholders::error));
-    io_service_.run();
+
+    // Handlers in helper threads would block on mutex_ if the caller
+    // holds it (like PC::connect() does), run such rounds in this thread.
+    enter();
+    bool const nested(lock_depth_ > 1);
+    leave();
+
+    if (io_threads_.empty() == true || nested == true)
+    {
+        io_service_.run();
+        return;
+    }
+
+    {
+        gu::Lock lock(io_mtx_);
+        ++io_gen_;
+        io_open_ = true;
+        io_cond_.broadcast();
+    }
+
+    try
+    {
+        io_service_.run();
+    }
+    catch (...)
+    {
+        io_service_.stop();
+        close_io_round();
+        throw;
+    }
+
+    int err(0);
+    std::string const what(close_io_round(err));
+
+    if (what.empty() == false)
+    {
+        gu_throw_error(err) << what;
+    }
+}
+
+// Waits until helper threads have left io_service_.run(), returns and clears
+// the first exception message they caught.
+std::string gcomm::AsioProtonet::close_io_round(int& err)
+{
+    gu::Lock lock(io_mtx_);
+    io_open_ = false;
+    while (io_running_ > 0) lock.wait(io_cond_);
+
+    std::string ret;
+    ret.swap(io_error_);
+    err = io_errno_;
+    return ret;
+}
+
+void gcomm::AsioProtonet::close_io_round()
+{
+    int err;
+    close_io_round(err);
 }
 
 
@@ -7,9 +7,13 @@
 
 #include "gcomm/protonet.hpp"
 #include "socket.hpp"
+#include "buffer_pool.hpp"
 
 #include "gu_monitor.hpp"
 #include "gu_asio.hpp"
+#include "gu_lock.hpp"
+
+#include <pthread.h>
 
 #include <vector>
 #include <deque>
@@ -47,19 +51,77 @@ private:
     friend class AsioTcpAcceptor;
     friend class AsioUdpSocket;
     AsioProtonet(const AsioProtonet&);
+    AsioProtonet& operator=(const AsioProtonet&);
 
     void handle_wait(const asio::error_code& ec);
 
+    // With protonet.io_threads > 1 helper threads join each event_loop()
+    // round in io_service_.run(). Socket handlers are serialized per
+    // socket by strands and take mutex_ for protocol processing.
+    static void* io_thread(void* arg);
+    void io_loop();
+    void io_run();
+    void start_io_threads(int n);
+    void stop_io_threads();
+    std::string close_io_round(int& err);
+    void close_io_round();
+    // true if handlers may be running in helper threads right now
+    bool io_round_open() const
+    {
+        gu::Lock lock(io_mtx_);
+        return io_open_;
+    }
+
+#ifdef HAVE_ASIO_SSL_HPP
+    // With protonet.handshake_threads > 0 SSL handshakes run in
+    // hs_io_service_ by dedicated threads, see AsioTcpSocket::handshake()
+    static void* hs_thread(void* arg);
+    void start_hs_threads(int n);
+    void stop_hs_threads();
+    bool hs_offload() const { return (hs_threads_.empty() == false); }
+#endif /* HAVE_ASIO_SSL_HPP */
+
+    // With protonet.timer_thread_prio set protocol timers (EVS keepalives,
+    // inactivity checks) are also handled by a dedicated thread with that
+    // scheduling priority, so they are not held back by socket handlers in
+    // the I/O threads. Timers still run under mutex_.
+    static void* timer_thread(void* arg);
+    void timer_loop();
+    void start_timer_thread(const std::string& prio);
+    void stop_timer_thread();
+
     gu::RecursiveMutex          mutex_;
+    int                         lock_depth_; // protected by mutex_
     gu::datetime::Date          poll_until_;
     asio::io_service            io_service_;
     asio::deadline_timer        timer_;
 #ifdef HAVE_ASIO_SSL_HPP
     asio::ssl::context          ssl_context_;
+    asio::io_service            hs_io_service_;
+    asio::io_service::work*     hs_work_;    // keeps hs threads running
+    std::vector<pthread_t>      hs_threads_;
 #endif /* HAVE_ASIO_SSL_HPP */
     size_t                      mtu_;
 
     NetHeader::checksum_t       checksum_;
+
+    // received datagram payloads
+    boost::shared_ptr<BufferPool> recv_pool_;
+
+    gu::Mutex                   io_mtx_;
+    gu::Cond                    io_cond_;
+    std::vector<pthread_t>      io_threads_;
+    long long                   io_gen_;     // event_loop() round
+    bool                        io_open_;    // helpers may join the round
+    int                         io_running_; // helpers inside run()
+    bool                        io_stop_;
+    std::string                 io_error_;   // first helper exception
+    int                         io_errno_;
+
+    gu::Cond                    timer_cond_; // protected by io_mtx_
+    pthread_t                   timer_thd_;
+    bool                        timer_running_;
+    bool                        timer_stop_;
 };
 
 #endif // GCOMM_ASIO_PROTONET_HPP
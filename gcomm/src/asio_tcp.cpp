@@ -6,6 +6,14 @@
 #include "gcomm/util.hpp"
 #include "gcomm/common.hpp"
 
+#include <gu_mem_stats.hpp>
+
+#include <netinet/in.h>
+#include <netinet/tcp.h> // TCP_MAXSEG, TCP_INFO
+#include <sys/socket.h>
+
+#include <algorithm>
+
 
 #define FAILED_HANDLER(_e) failed_handler(_e, __FUNCTION__, __LINE__)
 
@@ -13,13 +21,30 @@ gcomm::AsioTcpSocket::AsioTcpSocket(AsioProtonet& net, const gu::URI& uri)
     :
     Socket       (uri),
     net_         (net),
+    strand_      (net.io_service_),
     socket_      (net.io_service_),
 #ifdef HAVE_ASIO_SSL_HPP
     ssl_socket_  (0),
+    ktls_tx_     (false),
+    hs_strand_   (net.hs_io_service_),
+    hs_offload_  (false),
 #endif /* HAVE_ASIO_SSL_HPP */
     send_q_      (),
+    send_q_bytes_(0),
+    send_q_high_ (0),
+    send_q_low_  (0),
+    congested_   (false),
+    bytes_sent_  (0),
+    bytes_received_(0),
+#ifdef HAVE_ASIO_SSL_HPP
+    ssl_send_buf_(),
+#endif /* HAVE_ASIO_SSL_HPP */
     recv_buf_    (net_.mtu() + NetHeader::serial_size_),
     recv_offset_ (0),
+    deflate_     (0),
+    deflate_threshold_(0),
+    inflate_     (),
+    inflate_buf_ (),
     state_       (S_CLOSED),
     local_addr_  (),
     remote_addr_ ()
@@ -30,11 +55,13 @@ gcomm::AsioTcpSocket::AsioTcpSocket(AsioProtonet& net, const gu::URI& uri)
 gcomm::AsioTcpSocket::~AsioTcpSocket()
 {
     log_debug << "dtor for " << id();
+    gu::MemStats::sub(gu::MemStats::GCOMM_SEND_Q, send_q_bytes_);
     close_socket();
 #ifdef HAVE_ASIO_SSL_HPP
     delete ssl_socket_;
     ssl_socket_ = 0;
 #endif /* HAVE_ASIO_SSL_HPP */
+    delete deflate_;
 }
 
 void gcomm::AsioTcpSocket::failed_handler(const asio::error_code& ec,
@@ -66,8 +93,44 @@ void gcomm::AsioTcpSocket::failed_handler(const asio::error_code& ec,
 }
 
 #ifdef HAVE_ASIO_SSL_HPP
+void gcomm::AsioTcpSocket::handshake(
+    asio::ssl::stream_base::handshake_type const type)
+{
+    if (net_.hs_offload() == false)
+    {
+        ssl_socket_->async_handshake(
+            type,
+            strand_.wrap(boost::bind(&AsioTcpSocket::handshake_handler,
+                                     shared_from_this(),
+                                     asio::placeholders::error)));
+    }
+    else
+    {
+        // Intermediate steps of a composed operation run through the
+        // completion handler strand, so with hs_strand_ the handshake
+        // computations run in handshake threads. Only the result is
+        // handed back to strand_.
+        hs_offload_ = true;
+        ssl_socket_->async_handshake(
+            type,
+            hs_strand_.wrap(boost::bind(&AsioTcpSocket::handshake_done,
+                                        shared_from_this(),
+                                        asio::placeholders::error)));
+    }
+}
+
+void gcomm::AsioTcpSocket::handshake_done(const asio::error_code& ec)
+{
+    strand_.post(boost::bind(&AsioTcpSocket::handshake_handler,
+                             shared_from_this(), ec));
+}
+
 void gcomm::AsioTcpSocket::handshake_handler(const asio::error_code& ec)
 {
+    Critical<AsioProtonet> crit(net_);
+
+    hs_offload_ = false;
+
     if (ec)
     {
         if (ec.category() == asio::error::get_ssl_category() &&
@@ -93,11 +156,20 @@ void gcomm::AsioTcpSocket::handshake_handler(const asio::error_code& ec)
         return;
     }
 
+    if (state() != S_CONNECTING)
+    {
+        // closed while the result was on its way from handshake thread
+        log_debug << "handshake completed for socket " << id()
+                  << " in state " << state();
+        return;
+    }
+
     log_info << "SSL handshake successful, "
              << "remote endpoint " << remote_addr()
              << " local endpoint " << local_addr()
              << " cipher: " << gu::cipher(*ssl_socket_)
              << " compression: " << gu::compression(*ssl_socket_);
+    ktls_tx_ = gu::ssl_enable_ktls_tx(*ssl_socket_);
     state_ = S_CONNECTED;
     net_.dispatch(id(), Datagram(), ProtoUpMeta(ec.value()));
     async_receive();
@@ -126,12 +198,7 @@ void gcomm::AsioTcpSocket::connect_handler(const asio::error_code& ec)
                 log_debug << "socket " << id() << " connected, remote endpoint "
                           << remote_addr() << " local endpoint "
                           << local_addr();
-                ssl_socket_->async_handshake(
-                    asio::ssl::stream<asio::ip::tcp::socket>::client,
-                    boost::bind(&AsioTcpSocket::handshake_handler,
-                                shared_from_this(),
-                                asio::placeholders::error)
-                    );
+                handshake(asio::ssl::stream<asio::ip::tcp::socket>::client);
             }
             else
             {
@@ -177,9 +244,9 @@ void gcomm::AsioTcpSocket::connect(const gu::URI& uri)
             );
 
             ssl_socket_->lowest_layer().async_connect(
-                *i, boost::bind(&AsioTcpSocket::connect_handler,
-                                shared_from_this(),
-                                asio::placeholders::error)
+                *i, strand_.wrap(boost::bind(&AsioTcpSocket::connect_handler,
+                                             shared_from_this(),
+                                             asio::placeholders::error))
             );
         }
         else
@@ -194,9 +261,10 @@ void gcomm::AsioTcpSocket::connect(const gu::URI& uri)
                     0);
                 socket_.bind(ep);
             }
-            socket_.async_connect(*i, boost::bind(&AsioTcpSocket::connect_handler,
+            socket_.async_connect(*i, strand_.wrap(
+                                      boost::bind(&AsioTcpSocket::connect_handler,
                                                   shared_from_this(),
-                                                  asio::placeholders::error));
+                                                  asio::placeholders::error)));
 #ifdef HAVE_ASIO_SSL_HPP
         }
 #endif /* HAVE_ASIO_SSL_HPP */
@@ -222,7 +290,25 @@ void gcomm::AsioTcpSocket::close()
 
     if (send_q_.empty() == true || state() != S_CONNECTED)
     {
-        close_socket();
+#ifdef HAVE_ASIO_SSL_HPP
+        if (hs_offload_ == true)
+        {
+            // handshake thread may be using the socket
+            hs_strand_.dispatch(boost::bind(&AsioTcpSocket::close_socket,
+                                            shared_from_this()));
+        }
+        else
+#endif /* HAVE_ASIO_SSL_HPP */
+        if (net_.io_round_open() == false)
+        {
+            close_socket();
+        }
+        else
+        {
+            // socket may be in use by a handler in another I/O thread
+            strand_.dispatch(boost::bind(&AsioTcpSocket::close_socket,
+                                         shared_from_this()));
+        }
         state_ = S_CLOSED;
     }
     else
@@ -253,27 +339,30 @@ void gcomm::AsioTcpSocket::write_handler(const asio::error_code& ec,
     if (!ec)
     {
         gcomm_assert(send_q_.empty() == false);
-        gcomm_assert(send_q_.front().len() >= bytes_transferred);
+
+        bytes_sent_ += bytes_transferred;
 
         while (send_q_.empty() == false &&
                bytes_transferred >= send_q_.front().len())
         {
             const Datagram& dg(send_q_.front());
             bytes_transferred -= dg.len();
+            send_q_bytes_     -= dg.len();
+            gu::MemStats::sub(gu::MemStats::GCOMM_SEND_Q, dg.len());
             send_q_.pop_front();
         }
         gcomm_assert(bytes_transferred == 0);
 
+        if (congested_ == true && send_q_bytes_ <= send_q_low_)
+        {
+            log_debug << "send queue of " << id() << " drained to "
+                      << send_q_bytes_ << " bytes";
+            congested_ = false;
+        }
+
         if (send_q_.empty() == false)
         {
-            const Datagram& dg(send_q_.front());
-            boost::array<asio::const_buffer, 2> cbs;
-            cbs[0] = asio::const_buffer(dg.header()
-                                        + dg.header_offset(),
-                                        dg.header_len());
-            cbs[1] = asio::const_buffer(&dg.payload()[0],
-                                        dg.payload().size());
-            write_one(cbs);
+            write_queued();
         }
         else if (state_ == S_CLOSING)
         {
@@ -307,6 +396,21 @@ void gcomm::AsioTcpSocket::set_option(const std::string& key,
             (key, llval);
 #endif
     }
+    else if (key == Socket::OptDeflateThreshold)
+    {
+        deflate_threshold_ = gu::from_string<size_t>(val);
+    }
+    else if (key == Socket::OptDeflate)
+    {
+        int const level(gu::from_string<int>(val));
+
+        // the peer keeps inflating with the same stream, so once enabled
+        // compression stays on until the connection is closed
+        if (deflate_ == 0 && level != 0)
+        {
+            deflate_ = new LinkDeflate(level);
+        }
+    }
 }
 
 namespace gcomm
@@ -321,17 +425,11 @@ namespace gcomm
         { }
         void operator()()
         {
+            Critical<AsioProtonet> crit(socket_->net_);
             if (socket_->state() == gcomm::Socket::S_CONNECTED &&
                 socket_->send_q_.empty() == false)
             {
-                const gcomm::Datagram& dg(socket_->send_q_.front());
-                boost::array<asio::const_buffer, 2> cbs;
-                cbs[0] = asio::const_buffer(dg.header()
-                                            + dg.header_offset(),
-                                            dg.header_len());
-                cbs[1] = asio::const_buffer(&dg.payload()[0],
-                                            dg.payload().size());
-                socket_->write_one(cbs);
+                socket_->write_queued();
             }
         }
     private:
@@ -348,16 +446,41 @@ int gcomm::AsioTcpSocket::send(const Datagram& dg)
         return ENOTCONN;
     }
 
-    NetHeader hdr(static_cast<uint32_t>(dg.len()), net_.version_);
+    // datagrams which could not fit in peer receive buffer once
+    // compressed are sent as they are
+    bool const compress(deflate_ != 0 && dg.len() >= deflate_threshold_ &&
+                        deflate_->bound(dg.len()) <= net_.mtu());
 
-    if (net_.checksum_ != NetHeader::CS_NONE)
+    if (compress)
     {
-        hdr.set_crc32(crc32(net_.checksum_, dg), net_.checksum_);
+        gu::SharedBuffer buf(new gu::Buffer);
+        try
+        {
+            deflate_->compress(dg, *buf);
+        }
+        catch (gu::Exception& e)
+        {
+            log_warn << "compressing datagram failed: " << e.what();
+            return e.get_errno();
+        }
+        send_q_.push_back(Datagram(buf));
+    }
+    else
+    {
+        send_q_.push_back(dg); // makes copy of dg
     }
-
-    send_q_.push_back(dg); // makes copy of dg
     Datagram& priv_dg(send_q_.back());
 
+    NetHeader hdr(static_cast<uint32_t>(priv_dg.len()), net_.version_);
+
+    if (compress) hdr.set_deflate();
+
+    NetHeader::checksum_t const checksum(checksum_type());
+    if (checksum != NetHeader::CS_NONE)
+    {
+        hdr.set_crc32(crc32(checksum, priv_dg), checksum);
+    }
+
     priv_dg.set_header_offset(priv_dg.header_offset() -
                               NetHeader::serial_size_);
     serialize(hdr,
@@ -365,21 +488,41 @@ int gcomm::AsioTcpSocket::send(const Datagram& dg)
               priv_dg.header_size(),
               priv_dg.header_offset());
 
+    send_q_bytes_ += priv_dg.len();
+    gu::MemStats::add(gu::MemStats::GCOMM_SEND_Q, priv_dg.len());
+    if (congested_ == false && send_q_high_ > 0 &&
+        send_q_bytes_ > send_q_high_)
+    {
+        log_debug << "send queue of " << id() << " reached "
+                  << send_q_bytes_ << " bytes";
+        congested_ = true;
+    }
+
     if (send_q_.size() == 1)
     {
-        net_.io_service_.post(AsioPostForSendHandler(shared_from_this()));
+        strand_.post(AsioPostForSendHandler(shared_from_this()));
     }
     return 0;
 }
 
 
+// Receiver verifies checksum only if it is present in the header, so it can
+// be left out on both ends where TLS protects message integrity anyway.
+gcomm::NetHeader::checksum_t gcomm::AsioTcpSocket::checksum_type() const
+{
+#ifdef HAVE_ASIO_SSL_HPP
+    if (ssl_socket_ != 0) return NetHeader::CS_NONE;
+#endif // HAVE_ASIO_SSL_HPP
+    return net_.checksum_;
+}
+
 void gcomm::AsioTcpSocket::read_handler(const asio::error_code& ec,
                                         const size_t bytes_transferred)
 {
-    Critical<AsioProtonet> crit(net_);
-
     if (ec)
     {
+        Critical<AsioProtonet> crit(net_);
+
         if (ec.category() == asio::error::get_ssl_category() &&
             gu::exclude_ssl_error(ec) == false)
         {
@@ -390,36 +533,34 @@ void gcomm::AsioTcpSocket::read_handler(const asio::error_code& ec,
         return;
     }
 
-    if (state() != S_CONNECTED && state() != S_CLOSING)
-    {
-        log_debug << "read handler for " << id()
-                  << " state " << state();
-        return;
-    }
-
     recv_offset_ += bytes_transferred;
 
-    while (recv_offset_ >= NetHeader::serial_size_)
+    // Messages are framed and checksums verified before taking the protonet
+    // lock: recv_buf_ is accessed only by the handlers of this socket,
+    // which are serialized by strand_.
+    std::vector<Datagram> dgs;
+    asio::error_code      err;
+    size_t                offset(0);
+
+    while (recv_offset_ - offset >= NetHeader::serial_size_)
     {
         NetHeader hdr;
         try
         {
-            unserialize(&recv_buf_[0], recv_buf_.size(), 0, hdr);
+            unserialize(&recv_buf_[0] + offset, recv_buf_.size() - offset, 0,
+                        hdr);
         }
         catch (gu::Exception& e)
         {
-            FAILED_HANDLER(asio::error_code(e.get_errno(),
-                                            asio::error::system_category));
-            return;
+            err = asio::error_code(e.get_errno(), asio::error::system_category);
+            break;
         }
-        if (recv_offset_ >= hdr.len() + NetHeader::serial_size_)
+        if (recv_offset_ - offset >= hdr.len() + NetHeader::serial_size_)
         {
-            Datagram dg(
-                gu::SharedBuffer(
-                    new gu::Buffer(&recv_buf_[0] + NetHeader::serial_size_,
-                                   &recv_buf_[0] + NetHeader::serial_size_
-                                   + hdr.len())));
-            if (net_.checksum_ != NetHeader::CS_NONE)
+            const gu::byte_t* const begin(&recv_buf_[0] + offset
+                                          + NetHeader::serial_size_);
+            Datagram dg(net_.recv_pool_->get(begin, begin + hdr.len()));
+            if (checksum_type() != NetHeader::CS_NONE)
             {
 #ifdef TEST_NET_CHECKSUM_ERROR
                 long rnd(rand());
@@ -435,22 +576,35 @@ void gcomm::AsioTcpSocket::read_handler(const asio::error_code& ec,
                              << " has_crc32="  << hdr.has_crc32()
                              << " has_crc32c=" << hdr.has_crc32c()
                              << " crc32=" << hdr.crc32();
-                    FAILED_HANDLER(asio::error_code(
-                                       EPROTO,
-                                       asio::error::system_category));
-                    return;
+                    err = asio::error_code(EPROTO,
+                                           asio::error::system_category);
+                    break;
                 }
             }
-            ProtoUpMeta um;
-            net_.dispatch(id(), dg, um);
-            recv_offset_ -= NetHeader::serial_size_ + hdr.len();
-
-            if (recv_offset_ > 0)
+            if (hdr.has_deflate())
+            {
+                try
+                {
+                    inflate_.decompress(begin, begin + hdr.len(),
+                                        inflate_buf_);
+                }
+                catch (gu::Exception& e)
+                {
+                    log_warn << "decompressing datagram failed: " << e.what();
+                    err = asio::error_code(e.get_errno(),
+                                           asio::error::system_category);
+                    break;
+                }
+                dgs.push_back(Datagram(net_.recv_pool_->get(
+                                           &inflate_buf_[0],
+                                           &inflate_buf_[0]
+                                           + inflate_buf_.size())));
+            }
+            else
             {
-                memmove(&recv_buf_[0],
-                        &recv_buf_[0] + NetHeader::serial_size_ + hdr.len(),
-                        recv_offset_);
+                dgs.push_back(dg);
             }
+            offset += NetHeader::serial_size_ + hdr.len();
         }
         else
         {
@@ -458,6 +612,36 @@ void gcomm::AsioTcpSocket::read_handler(const asio::error_code& ec,
         }
     }
 
+    recv_offset_ -= offset;
+    if (offset > 0 && recv_offset_ > 0)
+    {
+        memmove(&recv_buf_[0], &recv_buf_[0] + offset, recv_offset_);
+    }
+
+    Critical<AsioProtonet> crit(net_);
+
+    bytes_received_ += offset;
+
+    if (state() != S_CONNECTED && state() != S_CLOSING)
+    {
+        log_debug << "read handler for " << id()
+                  << " state " << state();
+        return;
+    }
+
+    for (std::vector<Datagram>::const_iterator i(dgs.begin());
+         i != dgs.end(); ++i)
+    {
+        ProtoUpMeta um;
+        net_.dispatch(id(), *i, um);
+    }
+
+    if (err)
+    {
+        FAILED_HANDLER(err);
+        return;
+    }
+
     boost::array<asio::mutable_buffer, 1> mbs;
     mbs[0] = asio::mutable_buffer(&recv_buf_[0] + recv_offset_,
                                   recv_buf_.size() - recv_offset_);
@@ -518,6 +702,19 @@ void gcomm::AsioTcpSocket::async_receive()
 
     gcomm_assert(state() == S_CONNECTED);
 
+    if (net_.io_round_open() == false)
+    {
+        read_first();
+    }
+    else
+    {
+        strand_.dispatch(boost::bind(&AsioTcpSocket::read_first,
+                                     shared_from_this()));
+    }
+}
+
+void gcomm::AsioTcpSocket::read_first()
+{
     boost::array<asio::mutable_buffer, 1> mbs;
 
     mbs[0] = asio::mutable_buffer(&recv_buf_[0], recv_buf_.size());
@@ -529,6 +726,64 @@ size_t gcomm::AsioTcpSocket::mtu() const
     return net_.mtu();
 }
 
+size_t gcomm::AsioTcpSocket::mss() const
+{
+    int fd(const_cast<AsioTcpSocket*>(this)->socket().native());
+    int mss(0);
+    socklen_t len(sizeof(mss));
+
+    if (::getsockopt(fd, IPPROTO_TCP, TCP_MAXSEG, &mss, &len) != 0 || mss < 0)
+    {
+        return 0;
+    }
+    return mss;
+}
+
+#if defined(__linux__)
+static bool get_tcp_info(int const fd, struct tcp_info& ti)
+{
+    socklen_t len(sizeof(ti));
+    return (::getsockopt(fd, IPPROTO_TCP, TCP_INFO, &ti, &len) == 0);
+}
+#endif /* __linux__ */
+
+long long gcomm::AsioTcpSocket::rtt() const
+{
+#if defined(__linux__)
+    int fd(const_cast<AsioTcpSocket*>(this)->socket().native());
+    struct tcp_info ti;
+
+    if (get_tcp_info(fd, ti) == true)
+    {
+        return ti.tcpi_rtt;
+    }
+#endif /* __linux__ */
+    return 0;
+}
+
+gcomm::Socket::Stats gcomm::AsioTcpSocket::stats() const
+{
+    Stats ret;
+
+#if defined(__linux__)
+    int fd(const_cast<AsioTcpSocket*>(this)->socket().native());
+    struct tcp_info ti;
+
+    if (get_tcp_info(fd, ti) == true)
+    {
+        ret.rtt     = ti.tcpi_rtt;
+        ret.rtt_var = ti.tcpi_rttvar;
+        ret.retrans = ti.tcpi_total_retrans;
+    }
+#endif /* __linux__ */
+
+    ret.bytes_sent     = bytes_sent_;
+    ret.bytes_received = bytes_received_;
+    ret.send_q_bytes   = send_q_bytes_;
+
+    return ret;
+}
+
 
 
 std::string gcomm::AsioTcpSocket::local_addr() const
@@ -567,6 +822,10 @@ void gcomm::AsioTcpSocket::set_socket_options()
     sock.get_option(option);
     log_debug << "socket recv buf size " << option.value();
 #endif
+
+    send_q_high_ = net_.conf().get<size_t>(gcomm::Conf::SocketSendQHighWater);
+    send_q_low_  = std::min(send_q_high_,
+                   net_.conf().get<size_t>(gcomm::Conf::SocketSendQLowWater));
 }
 
 void gcomm::AsioTcpSocket::read_one(boost::array<asio::mutable_buffer, 1>& mbs)
@@ -579,10 +838,11 @@ void gcomm::AsioTcpSocket::read_one(boost::array<asio::mutable_buffer, 1>& mbs)
                                shared_from_this(),
                                asio::placeholders::error,
                                asio::placeholders::bytes_transferred),
-                   boost::bind(&AsioTcpSocket::read_handler,
-                               shared_from_this(),
-                               asio::placeholders::error,
-                               asio::placeholders::bytes_transferred));
+                   strand_.wrap(
+                       boost::bind(&AsioTcpSocket::read_handler,
+                                   shared_from_this(),
+                                   asio::placeholders::error,
+                                   asio::placeholders::bytes_transferred)));
     }
     else
     {
@@ -592,36 +852,104 @@ void gcomm::AsioTcpSocket::read_one(boost::array<asio::mutable_buffer, 1>& mbs)
                                shared_from_this(),
                                asio::placeholders::error,
                                asio::placeholders::bytes_transferred),
-                   boost::bind(&AsioTcpSocket::read_handler,
-                               shared_from_this(),
-                               asio::placeholders::error,
-                               asio::placeholders::bytes_transferred));
+                   strand_.wrap(
+                       boost::bind(&AsioTcpSocket::read_handler,
+                                   shared_from_this(),
+                                   asio::placeholders::error,
+                                   asio::placeholders::bytes_transferred)));
 #ifdef HAVE_ASIO_SSL_HPP
     }
 #endif /* HAVE_ASIO_SSL_HPP */
 }
 
 
-void gcomm::AsioTcpSocket::write_one(
-    const boost::array<asio::const_buffer, 2>& cbs)
+// Maximum number of queued datagrams to pass in a single write
+static size_t const max_write_batch(64);
+
+#ifdef HAVE_ASIO_SSL_HPP
+// Maximum TLS record payload. SSL stream writes one buffer per record,
+// so smaller datagrams are copied together to fill records.
+static size_t const ssl_record_size(1 << 14);
+#endif /* HAVE_ASIO_SSL_HPP */
+
+// Writes out as many datagrams from the head of send_q_ as fit the batch.
+// write_handler() pops the datagrams which have been fully transferred.
+void gcomm::AsioTcpSocket::write_queued()
 {
+    gcomm_assert(send_q_.empty() == false);
+
 #ifdef HAVE_ASIO_SSL_HPP
-    if (ssl_socket_ != 0)
+    if (ssl_socket_ != 0 && ktls_tx_ == false &&
+        send_q_.front().len() < ssl_record_size)
+    {
+        ssl_send_buf_.clear();
+
+        for (std::deque<Datagram>::const_iterator i(send_q_.begin());
+             i != send_q_.end() &&
+                 ssl_send_buf_.size() + i->len() <= ssl_record_size; ++i)
+        {
+            const gu::byte_t* const hdr(i->header() + i->header_offset());
+            ssl_send_buf_.insert(ssl_send_buf_.end(),
+                                 hdr, hdr + i->header_len());
+            ssl_send_buf_.insert(ssl_send_buf_.end(),
+                                 i->payload().begin(), i->payload().end());
+        }
+
+        async_write(*ssl_socket_, asio::buffer(ssl_send_buf_.data(),
+                                              ssl_send_buf_.size()),
+                    strand_.wrap(
+                        boost::bind(&AsioTcpSocket::write_handler,
+                                    shared_from_this(),
+                                    asio::placeholders::error,
+                                    asio::placeholders::bytes_transferred)));
+        return;
+    }
+#endif /* HAVE_ASIO_SSL_HPP */
+
+    std::vector<asio::const_buffer> cbs;
+    cbs.reserve(2 * std::min(send_q_.size(), max_write_batch));
+
+    for (std::deque<Datagram>::const_iterator i(send_q_.begin());
+         i != send_q_.end() && cbs.size() < 2 * max_write_batch; ++i)
+    {
+        cbs.push_back(asio::const_buffer(i->header() + i->header_offset(),
+                                         i->header_len()));
+        cbs.push_back(asio::const_buffer(&i->payload()[0],
+                                         i->payload().size()));
+#ifdef HAVE_ASIO_SSL_HPP
+        // large datagram goes alone unless the kernel does the encryption
+        if (ssl_socket_ != 0 && ktls_tx_ == false) break;
+#endif /* HAVE_ASIO_SSL_HPP */
+    }
+
+#ifdef HAVE_ASIO_SSL_HPP
+    if (ssl_socket_ != 0 && ktls_tx_ == true)
+    {
+        async_write(ssl_socket_->next_layer(), cbs,
+                    strand_.wrap(
+                        boost::bind(&AsioTcpSocket::write_handler,
+                                    shared_from_this(),
+                                    asio::placeholders::error,
+                                    asio::placeholders::bytes_transferred)));
+    }
+    else if (ssl_socket_ != 0)
     {
         async_write(*ssl_socket_, cbs,
-                    boost::bind(&AsioTcpSocket::write_handler,
-                                shared_from_this(),
-                                asio::placeholders::error,
-                                asio::placeholders::bytes_transferred));
+                    strand_.wrap(
+                        boost::bind(&AsioTcpSocket::write_handler,
+                                    shared_from_this(),
+                                    asio::placeholders::error,
+                                    asio::placeholders::bytes_transferred)));
     }
     else
     {
 #endif /* HAVE_ASIO_SSL_HPP */
         async_write(socket_, cbs,
-                    boost::bind(&AsioTcpSocket::write_handler,
-                                shared_from_this(),
-                                asio::placeholders::error,
-                                asio::placeholders::bytes_transferred));
+                    strand_.wrap(
+                        boost::bind(&AsioTcpSocket::write_handler,
+                                    shared_from_this(),
+                                    asio::placeholders::error,
+                                    asio::placeholders::bytes_transferred)));
 #ifdef HAVE_ASIO_SSL_HPP
     }
 #endif /* HAVE_ASIO_SSL_HPP */
@@ -725,6 +1053,8 @@ void gcomm::AsioTcpAcceptor::accept_handler(
     SocketPtr socket,
     const asio::error_code& error)
 {
+    Critical<AsioProtonet> crit(net_);
+
     if (!error)
     {
         AsioTcpSocket* s(static_cast<AsioTcpSocket*>(socket.get()));
@@ -740,11 +1070,7 @@ void gcomm::AsioTcpAcceptor::accept_handler(
                           << s->id() << " connected, remote endpoint "
                           << s->remote_addr() << " local endpoint "
                           << s->local_addr();
-                s->ssl_socket_->async_handshake(
-                    asio::ssl::stream<asio::ip::tcp::socket>::server,
-                    boost::bind(&AsioTcpSocket::handshake_handler,
-                                s->shared_from_this(),
-                                asio::placeholders::error));
+                s->handshake(asio::ssl::stream<asio::ip::tcp::socket>::server);
                 s->state_ = Socket::S_CONNECTING;
             }
             else
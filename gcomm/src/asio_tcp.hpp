@@ -7,6 +7,7 @@
 
 #include "socket.hpp"
 #include "asio_protonet.hpp"
+#include "link_deflate.hpp"
 
 #include <boost/bind.hpp>
 #include <boost/array.hpp>
@@ -43,6 +44,8 @@ public:
     ~AsioTcpSocket();
     void failed_handler(const asio::error_code& ec, const std::string& func, int line);
 #ifdef HAVE_ASIO_SSL_HPP
+    void handshake(asio::ssl::stream_base::handshake_type type);
+    void handshake_done(const asio::error_code& ec);
     void handshake_handler(const asio::error_code& ec);
 #endif // HAVE_ASIO_SSL_HPP
     void connect_handler(const asio::error_code& ec);
@@ -59,6 +62,10 @@ public:
                       const size_t bytes_transferred);
     void async_receive();
     size_t mtu() const;
+    size_t mss() const;
+    long long rtt() const;
+    Stats stats() const;
+    bool congested() const { return congested_; }
     std::string local_addr() const;
     std::string remote_addr() const;
     State state() const { return state_; }
@@ -71,14 +78,17 @@ private:
     void operator=(const AsioTcpSocket&);
 
     void set_socket_options();
+    void read_first();
     void read_one(boost::array<asio::mutable_buffer, 1>& mbs);
-    void write_one(const boost::array<asio::const_buffer, 2>& cbs);
+    void write_queued();
     void close_socket();
 
     // call to assign local/remote addresses at the point where it
     // is known that underlying socket is live
     void assign_local_addr();
     void assign_remote_addr();
+    // checksum algorithm for messages of this connection
+    NetHeader::checksum_t checksum_type() const;
 
     // returns real socket to use
     typedef asio::basic_socket<asio::ip::tcp,
@@ -88,13 +98,35 @@ private:
     socket() { return (ssl_socket_ ? ssl_socket_->lowest_layer() : socket_); }
 
     AsioProtonet&                             net_;
+    // serializes handlers of this socket when protonet runs several
+    // I/O threads
+    asio::io_service::strand                  strand_;
     asio::ip::tcp::socket                     socket_;
 #ifdef HAVE_ASIO_SSL_HPP
     asio::ssl::stream<asio::ip::tcp::socket>* ssl_socket_;
+    bool                                      ktls_tx_; // kernel encrypts
+    // serializes handshake steps running in protonet handshake threads
+    asio::io_service::strand                  hs_strand_;
+    bool                                      hs_offload_; // hs_strand_ owns
+                                                           // the socket
 #endif // HAVE_ASIO_SSL_HPP
     std::deque<Datagram>                      send_q_;
-    std::vector<gu::byte_t>                   recv_buf_;
+    size_t                                    send_q_bytes_;
+    size_t                                    send_q_high_;
+    size_t                                    send_q_low_;
+    bool                                      congested_;
+    long long                                 bytes_sent_;
+    long long                                 bytes_received_;
+#ifdef HAVE_ASIO_SSL_HPP
+    gu::Buffer                                ssl_send_buf_;
+#endif // HAVE_ASIO_SSL_HPP
+    gu::Buffer                                recv_buf_;
     size_t                                    recv_offset_;
+    // link compression, see Socket::OptDeflate
+    LinkDeflate*                              deflate_;
+    size_t                                    deflate_threshold_;
+    LinkInflate                               inflate_;
+    gu::Buffer                                inflate_buf_;
     State                                     state_;
     // Querying addresses from failed socket does not work,
     // so need to maintain copy for diagnostics logging
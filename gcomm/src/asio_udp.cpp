@@ -192,11 +192,16 @@ void gcomm::AsioUdpSocket::read_handler(const asio::error_code& ec,
         else
         {
             Datagram dg(
-                gu::SharedBuffer(
-                    new gu::Buffer(&recv_buf_[0] + NetHeader::serial_size_,
-                                   &recv_buf_[0] + NetHeader::serial_size_
-                                   + hdr.len())));
-            if (net_.checksum_ == true && check_cs(hdr, dg))
+                net_.recv_pool_->get(&recv_buf_[0] + NetHeader::serial_size_,
+                                     &recv_buf_[0] + NetHeader::serial_size_
+                                     + hdr.len()));
+            if (hdr.has_deflate())
+            {
+                // link compression is a stream over TCP connection
+                log_warn << "dropping compressed datagram of " << hdr.len()
+                         << " bytes";
+            }
+            else if (net_.checksum_ == true && check_cs(hdr, dg))
             {
                 log_warn << "checksum failed, hdr: len=" << hdr.len()
                          << " has_crc32="  << hdr.has_crc32()
@@ -234,6 +239,16 @@ size_t gcomm::AsioUdpSocket::mtu() const
     return (1 << 15);
 }
 
+size_t gcomm::AsioUdpSocket::mss() const
+{
+    return 0;
+}
+
+long long gcomm::AsioUdpSocket::rtt() const
+{
+    return 0;
+}
+
 std::string gcomm::AsioUdpSocket::local_addr() const
 {
     return uri_string(gu::scheme::udp,
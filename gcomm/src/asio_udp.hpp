@@ -41,6 +41,10 @@ public:
     void read_handler(const asio::error_code&, size_t);
     void async_receive();
     size_t mtu() const;
+    size_t mss() const;
+    long long rtt() const;
+    bool congested() const { return false; }
+    Stats stats() const { return Stats(); }
     std::string local_addr() const;
     std::string remote_addr() const;
     State state() const { return state_; }
@@ -52,7 +56,7 @@ private:
     asio::ip::udp::socket    socket_;
     asio::ip::udp::endpoint  target_ep_;
     asio::ip::udp::endpoint  source_ep_;
-    std::vector<gu::byte_t>  recv_buf_;
+    gu::Buffer               recv_buf_;
 };
 
 #if defined(__GNUG__)
@@ -0,0 +1,102 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "buffer_pool.hpp"
+
+#include "gu_lock.hpp"
+
+gcomm::BufferPool::BufferPool(size_t const max_cached)
+    :
+    mtx_       (),
+    free_      (max_class_ - min_class_ + 1),
+    max_cached_(max_cached)
+{ }
+
+gcomm::BufferPool::~BufferPool()
+{
+    for (size_t i(0); i < free_.size(); ++i)
+    {
+        for (size_t j(0); j < free_[i].size(); ++j)
+        {
+            delete free_[i][j];
+        }
+    }
+}
+
+gu::SharedBuffer
+gcomm::BufferPool::get(const gu::byte_t* const begin,
+                       const gu::byte_t* const end)
+{
+    size_t const size(end - begin);
+    size_t cls(min_class_);
+
+    while ((size_t(1) << cls) < size) ++cls;
+
+    if (cls > max_class_)
+    {
+        return gu::SharedBuffer(new gu::Buffer(begin, end));
+    }
+
+    gu::Buffer* buf(0);
+    {
+        gu::Lock lock(mtx_);
+        std::vector<gu::Buffer*>& fl(free_[cls - min_class_]);
+        if (fl.empty() == false)
+        {
+            buf = fl.back();
+            fl.pop_back();
+        }
+    }
+
+    if (buf == 0)
+    {
+        buf = new gu::Buffer();
+        try
+        {
+            buf->reserve(size_t(1) << cls);
+        }
+        catch (...)
+        {
+            delete buf;
+            throw;
+        }
+    }
+
+    // assign() keeps the capacity, so the buffer stays in its class
+    buf->assign(begin, end);
+
+    // on failure shared_ptr calls Release, which takes the buffer back
+    return gu::SharedBuffer(buf, Release(shared_from_this(), cls));
+}
+
+void
+gcomm::BufferPool::put(gu::Buffer* const buf, size_t const cls)
+{
+    buf->clear();
+
+    {
+        gu::Lock lock(mtx_);
+        std::vector<gu::Buffer*>& fl(free_[cls - min_class_]);
+        if (fl.size() < max_cached_)
+        {
+            try
+            {
+                fl.push_back(buf);
+                return;
+            }
+            catch (...) {}
+        }
+    }
+
+    delete buf;
+}
+
+size_t
+gcomm::BufferPool::cached() const
+{
+    gu::Lock lock(mtx_);
+    size_t ret(0);
+    for (size_t i(0); i < free_.size(); ++i) ret += free_[i].size();
+    return ret;
+}
@@ -0,0 +1,73 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+//!
+// @file buffer_pool.hpp Size classed pool of datagram payload buffers.
+//
+// Buffers are handed out as gu::SharedBuffer and go back to the pool
+// when the last reference to them is dropped, wherever that happens.
+// The pool must be owned by boost::shared_ptr and stays alive as long as
+// any of its buffers does.
+//
+
+#ifndef GCOMM_BUFFER_POOL_HPP
+#define GCOMM_BUFFER_POOL_HPP
+
+#include "gu_buffer.hpp"
+#include "gu_mutex.hpp"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/enable_shared_from_this.hpp>
+
+#include <vector>
+
+namespace gcomm
+{
+    class BufferPool;
+}
+
+class gcomm::BufferPool : public boost::enable_shared_from_this<BufferPool>
+{
+public:
+
+    //! @param max_cached max number of free buffers kept per size class
+    explicit BufferPool(size_t max_cached = 64);
+    ~BufferPool();
+
+    //! Returns buffer holding a copy of [begin, end).
+    gu::SharedBuffer get(const gu::byte_t* begin, const gu::byte_t* end);
+
+    //! Number of free buffers in the pool
+    size_t cached() const;
+
+private:
+
+    // Returns buffer to the pool instead of deleting it
+    class Release
+    {
+    public:
+        Release(const boost::shared_ptr<BufferPool>& pool, size_t cls)
+            : pool_(pool), cls_(cls) { }
+        void operator()(gu::Buffer* buf) const { pool_->put(buf, cls_); }
+    private:
+        boost::shared_ptr<BufferPool> pool_;
+        size_t                        cls_;
+    };
+
+    void put(gu::Buffer* buf, size_t cls);
+
+    // Size classes are powers of two from 256 bytes to 64KiB, larger
+    // buffers are allocated and freed as usual.
+    static const size_t min_class_ = 8;
+    static const size_t max_class_ = 16;
+
+    gu::Mutex                              mtx_;
+    std::vector<std::vector<gu::Buffer*> > free_;
+    size_t const                           max_cached_;
+
+    BufferPool(const BufferPool&);
+    void operator=(const BufferPool&);
+};
+
+#endif // GCOMM_BUFFER_POOL_HPP
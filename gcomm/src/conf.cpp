@@ -13,6 +13,11 @@ static std::string const Delim = ".";
 // Protonet
 std::string const gcomm::Conf::ProtonetBackend("protonet.backend");
 std::string const gcomm::Conf::ProtonetVersion("protonet.version");
+std::string const gcomm::Conf::ProtonetIoThreads("protonet.io_threads");
+std::string const gcomm::Conf::ProtonetHandshakeThreads(
+    "protonet.handshake_threads");
+std::string const gcomm::Conf::ProtonetTimerThreadPrio(
+    "protonet.timer_thread_prio");
 
 // TCP
 static std::string const SocketPrefix("socket" + Delim);
@@ -22,6 +27,10 @@ std::string const gcomm::Conf::SocketChecksum =
     SocketPrefix + "checksum";
 std::string const gcomm::Conf::SocketRecvBufSize =
     SocketPrefix + "recv_buf_size";
+std::string const gcomm::Conf::SocketSendQHighWater =
+    SocketPrefix + "send_q_high_water";
+std::string const gcomm::Conf::SocketSendQLowWater =
+    SocketPrefix + "send_q_low_water";
 
 // GMCast
 std::string const gcomm::Conf::GMCastScheme = "gmcast";
@@ -38,6 +47,8 @@ std::string const gcomm::Conf::GMCastMCastPort =
     GMCastPrefix + "mcast_port";
 std::string const gcomm::Conf::GMCastMCastTTL =
     GMCastPrefix + "mcast_ttl";
+std::string const gcomm::Conf::GMCastMCastMtu =
+    GMCastPrefix + "mcast_mtu";
 std::string const gcomm::Conf::GMCastTimeWait =
     GMCastPrefix + "time_wait";
 std::string const gcomm::Conf::GMCastPeerTimeout =
@@ -50,6 +61,14 @@ std::string const gcomm::Conf::GMCastIsolate =
     GMCastPrefix + "isolate";
 std::string const gcomm::Conf::GMCastSegment =
     GMCastPrefix + "segment";
+std::string const gcomm::Conf::GMCastSegmentFanout =
+    GMCastPrefix + "segment_fanout";
+std::string const gcomm::Conf::GMCastConnsPerPeer =
+    GMCastPrefix + "conns_per_peer";
+std::string const gcomm::Conf::GMCastSegmentCompress =
+    GMCastPrefix + "segment_compress";
+std::string const gcomm::Conf::GMCastSegmentCompressThreshold =
+    GMCastPrefix + "segment_compress_threshold";
 
 // EVS
 std::string const gcomm::Conf::EvsScheme = "evs";
@@ -82,6 +101,16 @@ std::string const gcomm::Conf::EvsUserSendWindow =
     EvsPrefix + "user_send_window";
 std::string const gcomm::Conf::EvsUseAggregate =
     EvsPrefix + "use_aggregate";
+std::string const gcomm::Conf::EvsAggregateHold =
+    EvsPrefix + "aggregate_hold";
+std::string const gcomm::Conf::EvsAckBatch =
+    EvsPrefix + "ack_batch";
+std::string const gcomm::Conf::EvsAckDelay =
+    EvsPrefix + "ack_delay";
+std::string const gcomm::Conf::EvsAdaptiveWindow =
+    EvsPrefix + "adaptive_window";
+std::string const gcomm::Conf::EvsAggregateLinger =
+    EvsPrefix + "aggregate_linger";
 std::string const gcomm::Conf::EvsCausalKeepalivePeriod =
     EvsPrefix + "causal_keepalive_period";
 std::string const gcomm::Conf::EvsMaxInstallTimeouts =
@@ -125,10 +154,15 @@ gcomm::Conf::register_params(gu::Config& cnf)
 
     GCOMM_CONF_ADD_DEFAULT(ProtonetBackend);
     GCOMM_CONF_ADD_DEFAULT(ProtonetVersion);
+    GCOMM_CONF_ADD_DEFAULT(ProtonetIoThreads);
+    GCOMM_CONF_ADD_DEFAULT(ProtonetHandshakeThreads);
+    GCOMM_CONF_ADD_DEFAULT(ProtonetTimerThreadPrio);
 
     GCOMM_CONF_ADD        (TcpNonBlocking);
     GCOMM_CONF_ADD_DEFAULT(SocketChecksum);
     GCOMM_CONF_ADD_DEFAULT(SocketRecvBufSize);
+    GCOMM_CONF_ADD_DEFAULT(SocketSendQHighWater);
+    GCOMM_CONF_ADD_DEFAULT(SocketSendQLowWater);
 
     GCOMM_CONF_ADD_DEFAULT(GMCastVersion);
     GCOMM_CONF_ADD        (GMCastGroup);
@@ -136,6 +170,7 @@ gcomm::Conf::register_params(gu::Config& cnf)
     GCOMM_CONF_ADD        (GMCastMCastAddr);
     GCOMM_CONF_ADD        (GMCastMCastPort);
     GCOMM_CONF_ADD        (GMCastMCastTTL);
+    GCOMM_CONF_ADD        (GMCastMCastMtu);
     GCOMM_CONF_ADD        (GMCastMCastAddr);
     GCOMM_CONF_ADD        (GMCastTimeWait);
     GCOMM_CONF_ADD        (GMCastPeerTimeout);
@@ -143,6 +178,10 @@ gcomm::Conf::register_params(gu::Config& cnf)
     GCOMM_CONF_ADD        (GMCastPeerAddr);
     GCOMM_CONF_ADD        (GMCastIsolate);
     GCOMM_CONF_ADD_DEFAULT(GMCastSegment);
+    GCOMM_CONF_ADD_DEFAULT(GMCastSegmentFanout);
+    GCOMM_CONF_ADD_DEFAULT(GMCastConnsPerPeer);
+    GCOMM_CONF_ADD_DEFAULT(GMCastSegmentCompress);
+    GCOMM_CONF_ADD_DEFAULT(GMCastSegmentCompressThreshold);
 
     GCOMM_CONF_ADD        (EvsVersion);
     GCOMM_CONF_ADD_DEFAULT(EvsViewForgetTimeout);
@@ -158,6 +197,11 @@ gcomm::Conf::register_params(gu::Config& cnf)
     GCOMM_CONF_ADD_DEFAULT(EvsSendWindow);
     GCOMM_CONF_ADD_DEFAULT(EvsUserSendWindow);
     GCOMM_CONF_ADD        (EvsUseAggregate);
+    GCOMM_CONF_ADD        (EvsAggregateHold);
+    GCOMM_CONF_ADD_DEFAULT(EvsAckBatch);
+    GCOMM_CONF_ADD_DEFAULT(EvsAckDelay);
+    GCOMM_CONF_ADD_DEFAULT(EvsAdaptiveWindow);
+    GCOMM_CONF_ADD_DEFAULT(EvsAggregateLinger);
     GCOMM_CONF_ADD        (EvsCausalKeepalivePeriod);
     GCOMM_CONF_ADD_DEFAULT(EvsMaxInstallTimeouts);
     GCOMM_CONF_ADD_DEFAULT(EvsDelayMargin);
@@ -15,11 +15,20 @@ namespace gcomm
 #endif /* HAVE_ASIO_HPP */
 
     std::string const Defaults::ProtonetVersion         = "0";
+    std::string const Defaults::ProtonetIoThreads       = "1";
+    std::string const Defaults::ProtonetHandshakeThreads = "0";
+    std::string const Defaults::ProtonetTimerThreadPrio  = "";
     std::string const Defaults::SocketChecksum          = "2";
     std::string const Defaults::SocketRecvBufSize       = "212992";
+    std::string const Defaults::SocketSendQHighWater    = "16777216";
+    std::string const Defaults::SocketSendQLowWater     = "8388608";
     std::string const Defaults::GMCastVersion           = "0";
     std::string const Defaults::GMCastTcpPort           = BASE_PORT_DEFAULT;
     std::string const Defaults::GMCastSegment           = "0";
+    std::string const Defaults::GMCastSegmentFanout     = "0";
+    std::string const Defaults::GMCastConnsPerPeer      = "1";
+    std::string const Defaults::GMCastSegmentCompress   = "0";
+    std::string const Defaults::GMCastSegmentCompressThreshold = "512";
     std::string const Defaults::GMCastTimeWait          = "PT5S";
     std::string const Defaults::GMCastPeerTimeout       = "PT3S";
     std::string const Defaults::EvsViewForgetTimeout    = "PT24H";
@@ -39,6 +48,11 @@ namespace gcomm
     std::string const Defaults::EvsUserSendWindow       = "2";
     std::string const Defaults::EvsUserSendWindowMin    = "1";
     std::string const Defaults::EvsMaxInstallTimeouts   = "3";
+    std::string const Defaults::EvsAckBatch             = "1";
+    std::string const Defaults::EvsAckDelay             = "PT0.005S";
+    std::string const Defaults::EvsAdaptiveWindow       = "false";
+    std::string const Defaults::EvsAggregateLinger      = "PT0S";
+    std::string const Defaults::EvsAggregateLingerMax   = "PT0.01S";
     std::string const Defaults::EvsDelayMargin          = "PT1S";
     std::string const Defaults::EvsDelayedKeepPeriod    = "PT30S";
     std::string const Defaults::EvsAutoEvict            = "0";
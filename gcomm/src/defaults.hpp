@@ -13,11 +13,20 @@ namespace gcomm
     {
         static std::string const ProtonetBackend          ;
         static std::string const ProtonetVersion          ;
+        static std::string const ProtonetIoThreads        ;
+        static std::string const ProtonetHandshakeThreads ;
+        static std::string const ProtonetTimerThreadPrio  ;
         static std::string const SocketChecksum           ;
         static std::string const SocketRecvBufSize        ;
+        static std::string const SocketSendQHighWater     ;
+        static std::string const SocketSendQLowWater      ;
         static std::string const GMCastVersion            ;
         static std::string const GMCastTcpPort            ;
         static std::string const GMCastSegment            ;
+        static std::string const GMCastSegmentFanout      ;
+        static std::string const GMCastConnsPerPeer       ;
+        static std::string const GMCastSegmentCompress    ;
+        static std::string const GMCastSegmentCompressThreshold;
         static std::string const GMCastTimeWait           ;
         static std::string const GMCastPeerTimeout        ;
         static std::string const EvsViewForgetTimeout     ;
@@ -37,6 +46,11 @@ namespace gcomm
         static std::string const EvsUserSendWindow        ;
         static std::string const EvsUserSendWindowMin     ;
         static std::string const EvsMaxInstallTimeouts    ;
+        static std::string const EvsAckBatch              ;
+        static std::string const EvsAckDelay              ;
+        static std::string const EvsAdaptiveWindow        ;
+        static std::string const EvsAggregateLinger       ;
+        static std::string const EvsAggregateLingerMax    ;
         static std::string const EvsDelayMargin           ;
         static std::string const EvsDelayedKeepPeriod     ;
         static std::string const EvsAutoEvict             ;
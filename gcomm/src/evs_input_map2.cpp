@@ -113,6 +113,10 @@ std::ostream& gcomm::evs::operator<<(std::ostream& os, const InputMap& im)
 //////////////////////////////////////////////////////////////////////////
 
 
+gcomm::evs::InputMapMsgIndex::pos_t const
+gcomm::evs::InputMapMsgIndex::end_pos;
+
+
 gcomm::evs::InputMap::InputMap() :
     window_         (-1),
     safe_seq_       (-1),
@@ -147,6 +151,8 @@ void gcomm::evs::InputMap::reset(const size_t nodes, const seqno_t window)
     node_index_->clear();
 
     window_ = window;
+    msg_index_->set_nodes(nodes);
+    recovery_index_->set_nodes(nodes);
     log_debug << " size " << node_index_->size();
     gu_trace(node_index_->resize(nodes, InputMapNode()));
     for (size_t i = 0; i < nodes; ++i)
@@ -194,15 +200,20 @@ void gcomm::evs::InputMap::set_safe_seq(const size_t uuid, const seqno_t seq)
     gcomm_assert(seq >= node.safe_seq())
         << "node.safe_seq=" << node.safe_seq()
         << " seq=" << seq;
+    const bool held_safe(node.safe_seq() == safe_seq_);
     node.set_safe_seq(seq);
 
     // Update global safe seq which must be monotonically increasing.
-    InputMapNodeIndex::const_iterator min =
-        min_element(node_index_->begin(), node_index_->end(),
-                    NodeIndexSafeSeqCmpOp());
-    const seqno_t minval = min->safe_seq();
-    gcomm_assert(minval >= safe_seq_);
-    safe_seq_ = minval;
+    // It can only move if this node was holding the minimum.
+    if (held_safe)
+    {
+        InputMapNodeIndex::const_iterator min =
+            min_element(node_index_->begin(), node_index_->end(),
+                        NodeIndexSafeSeqCmpOp());
+        const seqno_t minval = min->safe_seq();
+        gcomm_assert(minval >= safe_seq_);
+        safe_seq_ = minval;
+    }
 
     // Global safe seq must always be smaller than equal to aru seq
     gcomm_assert(safe_seq_ <= aru_seq_);
@@ -327,16 +338,19 @@ gcomm::evs::InputMap::insert(const size_t uuid,
         }
     }
 
+    // Only the node(s) holding the minimum lowest unseen can move aru_seq_,
+    // skip the scan over all nodes otherwise.
+    const bool held_aru(node.range().lu() - 1 == aru_seq_ &&
+                        range.lu() != node.range().lu());
     node.set_range(range);
-    update_aru();
+    if (held_aru) update_aru();
     return range;
 }
 
 
 void gcomm::evs::InputMap::erase(iterator i)
 {
-    gu_trace(recovery_index_->insert_unique(*i));
-    gu_trace(msg_index_->erase(i));
+    gu_trace(msg_index_->transfer(i, *recovery_index_));
 }
 
 
@@ -24,6 +24,8 @@
 #include "gcomm/datagram.hpp"
 
 #include <vector>
+#include <deque>
+#include <iterator>
 
 
 namespace gcomm
@@ -92,31 +94,279 @@ private:
 };
 
 
-#if defined(GALERA_USE_BOOST_POOL_ALLOC)
+/*
+ * Message index. Seqnos of each node are dense within the window, so
+ * instead of a tree messages are kept in a deque of slots addressed by
+ * (seq * nodes + index) relative to the first slot. Iteration order is the
+ * same as with std::map keyed by InputMapMsgKey: by seq first, then by node
+ * index, skipping empty slots.
+ *
+ * Iterators hold a slot position instead of a pointer, so they stay valid
+ * across insertions and across erasure of other elements. end() compares
+ * greater than any position and stays end() when messages are appended.
+ */
+class gcomm::evs::InputMapMsgIndex
+{
+public:
+
+    typedef InputMapMsgKey                               key_type;
+    typedef InputMapMsg                                  mapped_type;
+    typedef std::pair<const InputMapMsgKey, InputMapMsg> value_type;
+
+private:
+
+    typedef std::deque<value_type*> Slots;
+    typedef long long               pos_t;
+
+    static pos_t const end_pos = 0x7fffffffffffffffLL;
+
+    template <typename C, typename V>
+    class Iterator
+    {
+    public:
+
+        typedef std::forward_iterator_tag     iterator_category;
+        typedef InputMapMsgIndex::value_type  value_type;
+        typedef ptrdiff_t                     difference_type;
+        typedef V*                            pointer;
+        typedef V&                            reference;
+
+        Iterator() : c_(0), pos_(end_pos) { }
+
+        Iterator(const Iterator& i) : c_(i.c_), pos_(i.pos_) { }
+
+        Iterator& operator=(const Iterator& i)
+        {
+            c_ = i.c_; pos_ = i.pos_; return *this;
+        }
+
+        /* conversion from non-const iterator */
+        template <typename C1, typename V1>
+        Iterator(const Iterator<C1, V1>& i) : c_(i.c_), pos_(i.pos_) { }
+
+        reference operator* () const { return *c_->slot(pos_); }
+        pointer   operator->() const { return c_->slot(pos_);  }
+
+        Iterator& operator++() { pos_ = c_->next(pos_); return *this; }
+        Iterator  operator++(int) { Iterator t(*this); ++*this; return t; }
+
+        bool operator==(const Iterator& o) const { return pos_ == o.pos_; }
+        bool operator!=(const Iterator& o) const { return pos_ != o.pos_; }
+
+    private:
+
+        friend class InputMapMsgIndex;
+        template <typename C1, typename V1> friend class Iterator;
+
+        Iterator(C* c, pos_t pos) : c_(c), pos_(pos) { }
+
+        C*    c_;
+        pos_t pos_;
+    };
+
+public:
+
+    typedef Iterator<InputMapMsgIndex, value_type>             iterator;
+    typedef Iterator<const InputMapMsgIndex, const value_type> const_iterator;
+
+    InputMapMsgIndex() : slots_(), begin_(0), nodes_(0), size_(0) { }
+
+    ~InputMapMsgIndex() { clear(); }
+
+    /* number of nodes must be set while the index is empty */
+    void set_nodes(size_t const n)
+    {
+        gcomm_assert(empty());
+        nodes_ = n;
+    }
+
+    bool   empty() const { return 0 == size_; }
+    size_t size()  const { return size_; }
+
+    iterator       begin()       { return iterator(this, first()); }
+    const_iterator begin() const { return const_iterator(this, first()); }
+    iterator       end()         { return iterator(this, end_pos); }
+    const_iterator end()   const { return const_iterator(this, end_pos); }
+
+    iterator find(const InputMapMsgKey& k)
+    {
+        return iterator(this, find_pos(k));
+    }
+
+    const_iterator find(const InputMapMsgKey& k) const
+    {
+        return const_iterator(this, find_pos(k));
+    }
+
+    iterator find_checked(const InputMapMsgKey& k)
+    {
+        iterator ret(find(k));
+        if (ret == end())
+        {
+            gu_throw_fatal << "element " << k << " not found";
+        }
+        return ret;
+    }
+
+    /* first element not less than k */
+    iterator lower_bound(const InputMapMsgKey& k)
+    {
+        pos_t const pos(to_pos(k));
+        if (pos <= begin_) return begin();
+        if (pos >= slots_end()) return end();
+        return iterator(this, slot(pos) ? pos : next(pos));
+    }
+
+    iterator insert_unique(const value_type& v)
+    {
+        return iterator(this, place(new value_type(v)));
+    }
+
+    void erase(iterator i)
+    {
+        delete take(i.pos_);
+    }
+
+    void erase(iterator i, iterator const last)
+    {
+        while (i != last) erase(i++);
+    }
+
+    /* moves element from this index to another one without copying */
+    iterator transfer(iterator i, InputMapMsgIndex& to)
+    {
+        return iterator(&to, to.place(take(i.pos_)));
+    }
+
+    void clear()
+    {
+        for (Slots::iterator i(slots_.begin()); i != slots_.end(); ++i)
+        {
+            delete *i;
+        }
+        slots_.clear();
+        size_ = 0;
+    }
+
+    static const InputMapMsgKey& key(const_iterator i) { return i->first; }
+    static const InputMapMsg& value(const_iterator i) { return i->second; }
+    static const InputMapMsg& value(iterator i) { return i->second; }
+
+private:
+
+    InputMapMsgIndex(const InputMapMsgIndex&);
+    void operator=(const InputMapMsgIndex&);
+
+    pos_t to_pos(const InputMapMsgKey& k) const
+    {
+        gcomm_assert(k.index() < nodes_);
+        return (k.seq() * static_cast<pos_t>(nodes_) + k.index());
+    }
+
+    pos_t slots_end() const { return begin_ + slots_.size(); }
+    pos_t first()     const { return (slots_.empty() ? end_pos : begin_); }
+
+    value_type* slot(pos_t const pos) const
+    {
+        assert(pos >= begin_ && pos < slots_end());
+        return slots_[pos - begin_];
+    }
 
-#include <boost/pool/pool_alloc.hpp>
+    pos_t next(pos_t pos) const
+    {
+        pos_t const end(slots_end());
+        do { ++pos; } while (pos < end && slot(pos) == 0);
+        return (pos < end ? pos : end_pos);
+    }
+
+    pos_t find_pos(const InputMapMsgKey& k) const
+    {
+        pos_t const pos(to_pos(k));
+        return ((pos >= begin_ && pos < slots_end() && slot(pos) != 0) ?
+                pos : end_pos);
+    }
 
-class gcomm::evs::InputMapMsgIndex :
-    public Map<InputMapMsgKey, InputMapMsg,
-               std::map<InputMapMsgKey,
-                        InputMapMsg,
-                        std::less<InputMapMsgKey>,
-                        boost::fast_pool_allocator<
-                            std::pair<const InputMapMsgKey, InputMapMsg>,
-                            boost::default_user_allocator_new_delete,
-                            boost::details::pool::null_mutex
-                            >
-                        >
-               >
-{};
+    /* takes ownership of v */
+    pos_t place(value_type* const v)
+    {
+        pos_t const pos(to_pos(v->first));
+
+        if (slots_.empty())
+        {
+            begin_ = pos;
+            slots_.push_back(v);
+        }
+        else if (pos >= slots_end())
+        {
+            slots_.resize(pos - begin_, 0);
+            slots_.push_back(v);
+        }
+        else if (pos < begin_)
+        {
+            slots_.insert(slots_.begin(), begin_ - pos - 1,
+                          static_cast<value_type*>(0));
+            slots_.push_front(v);
+            begin_ = pos;
+        }
+        else if (slots_[pos - begin_] == 0)
+        {
+            slots_[pos - begin_] = v;
+        }
+        else
+        {
+            InputMapMsgKey const k(v->first);
+            delete v;
+            gu_throw_fatal << "duplicate entry key=" << k;
+        }
+
+        ++size_;
+        return pos;
+    }
 
-#else /* GALERA_USE_BOOST_POOL_ALLOC */
+    /* releases ownership of element at pos */
+    value_type* take(pos_t const pos)
+    {
+        value_type* const ret(slot(pos));
+        gcomm_assert(ret != 0);
+
+        slots_[pos - begin_] = 0;
+        --size_;
+
+        while (!slots_.empty() && slots_.front() == 0)
+        {
+            slots_.pop_front();
+            ++begin_;
+        }
+        while (!slots_.empty() && slots_.back() == 0)
+        {
+            slots_.pop_back();
+        }
+
+        return ret;
+    }
 
-class gcomm::evs::InputMapMsgIndex :
-    public Map<InputMapMsgKey, InputMapMsg>
-{};
+    Slots  slots_;
+    pos_t  begin_;  // position of slots_.front()
+    size_t nodes_;
+    size_t size_;   // number of occupied slots
+};
 
-#endif /* GALERA_USE_BOOST_POOL_ALLOC */
+namespace gcomm
+{
+    namespace evs
+    {
+        inline std::ostream& operator<<(std::ostream& os,
+                                        const InputMapMsgIndex& mi)
+        {
+            for (InputMapMsgIndex::const_iterator i(mi.begin());
+                 i != mi.end(); ++i)
+            {
+                os << "\t" << i->first << "," << i->second << "\n";
+            }
+            return os;
+        }
+    }
+}
 
 /* Internal node representation */
 class gcomm::evs::InputMapNode
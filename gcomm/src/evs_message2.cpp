@@ -166,11 +166,12 @@ size_t gcomm::evs::Message::serialize(gu::byte_t* const buf,
     uint8_t b = static_cast<uint8_t>(zeroversion
                                      | (type_ << 2)
                                      | (order_ << 5));
-    gu_trace(offset = gu::serialize1(b, buf, buflen, offset));
-    gu_trace(offset = gu::serialize1(flags_, buf, buflen, offset));
-    gu_trace(offset = gu::serialize1(version_, buf, buflen, offset));
-    gu_trace(offset = gu::serialize1(uint8_t(0), buf, buflen, offset));
-    gu_trace(offset = gu::serialize8(fifo_seq_, buf, buflen, offset));
+    gu_trace(gu::serial_check(buflen, offset, 4 + sizeof(fifo_seq_)));
+    offset = gu::serialize1_unchecked(b, buf, offset);
+    offset = gu::serialize1_unchecked(flags_, buf, offset);
+    offset = gu::serialize1_unchecked(version_, buf, offset);
+    offset = gu::serialize1_unchecked(uint8_t(0), buf, offset);
+    offset = gu::serialize8_unchecked(fifo_seq_, buf, offset);
     if (flags_ & F_SOURCE)
     {
         gu_trace(offset = source_.serialize(buf, buflen, offset));
@@ -184,8 +185,10 @@ size_t gcomm::evs::Message::unserialize(const gu::byte_t* const buf,
                                         size_t            const buflen,
                                         size_t                  offset)
 {
+    gu_trace(gu::serial_check(buflen, offset, 4 + sizeof(fifo_seq_)));
+
     uint8_t b;
-    gu_trace(offset = gu::unserialize1(buf, buflen, offset, b));
+    offset = gu::unserialize1_unchecked(buf, offset, b);
 
     // The message version will be read from offset 16 regardless what is
     // the zeroversion value. The only purpose of zeroversion is to
@@ -204,8 +207,8 @@ size_t gcomm::evs::Message::unserialize(const gu::byte_t* const buf,
                                     << order_;
     }
 
-    gu_trace(offset = gu::unserialize1(buf, buflen, offset, flags_));
-    gu_trace(offset = gu::unserialize1(buf, buflen, offset, version_));
+    offset = gu::unserialize1_unchecked(buf, offset, flags_);
+    offset = gu::unserialize1_unchecked(buf, offset, version_);
     switch (type_)
     {
     case T_JOIN:
@@ -223,9 +226,9 @@ size_t gcomm::evs::Message::unserialize(const gu::byte_t* const buf,
         break;
     }
     uint8_t reserved;
-    gu_trace(offset = gu::unserialize1(buf, buflen, offset, reserved));
+    offset = gu::unserialize1_unchecked(buf, offset, reserved);
 
-    gu_trace(offset = gu::unserialize8(buf, buflen, offset, fifo_seq_));
+    offset = gu::unserialize8_unchecked(buf, offset, fifo_seq_);
 
     if (flags_ & F_SOURCE)
     {
@@ -253,14 +256,16 @@ size_t gcomm::evs::UserMessage::serialize(gu::byte_t* const buf,
                                           size_t            offset) const
 {
     gu_trace(offset = Message::serialize(buf, buflen, offset));
-    gu_trace(offset = gu::serialize1(user_type_, buf, buflen, offset));
+    gu_trace(gu::serial_check(buflen, offset,
+                              4 + sizeof(seq_) + sizeof(aru_seq_)));
+    offset = gu::serialize1_unchecked(user_type_, buf, offset);
 
     gcomm_assert(seq_range_ <= seqno_t(0xff));
     uint8_t b = static_cast<uint8_t>(seq_range_);
-    gu_trace(offset = gu::serialize1(b, buf, buflen, offset));
-    gu_trace(offset = gu::serialize2(uint16_t(0), buf, buflen, offset));
-    gu_trace(offset = gu::serialize8(seq_, buf, buflen, offset));
-    gu_trace(offset = gu::serialize8(aru_seq_, buf, buflen, offset));
+    offset = gu::serialize1_unchecked(b, buf, offset);
+    offset = gu::serialize2_unchecked(uint16_t(0), buf, offset);
+    offset = gu::serialize8_unchecked(seq_, buf, offset);
+    offset = gu::serialize8_unchecked(aru_seq_, buf, offset);
 
     return offset;
 }
@@ -274,18 +279,20 @@ size_t gcomm::evs::UserMessage::unserialize(const gu::byte_t* const buf,
     {
         gu_trace(offset = Message::unserialize(buf, buflen, offset));
     }
-    gu_trace(offset = gu::unserialize1(buf, buflen, offset, user_type_));
+    gu_trace(gu::serial_check(buflen, offset,
+                              4 + sizeof(seq_) + sizeof(aru_seq_)));
+    offset = gu::unserialize1_unchecked(buf, offset, user_type_);
     uint8_t b;
-    gu_trace(offset = gu::unserialize1(buf, buflen, offset, b));
+    offset = gu::unserialize1_unchecked(buf, offset, b);
     seq_range_ = b;
     uint16_t pad;
-    gu_trace(offset = gu::unserialize2(buf, buflen, offset, pad));
+    offset = gu::unserialize2_unchecked(buf, offset, pad);
     if (pad != 0)
     {
         log_warn << "invalid pad: " << pad;
     }
-    gu_trace(offset = gu::unserialize8(buf, buflen, offset, seq_));
-    gu_trace(offset = gu::unserialize8(buf, buflen, offset, aru_seq_));
+    offset = gu::unserialize8_unchecked(buf, offset, seq_);
+    offset = gu::unserialize8_unchecked(buf, offset, aru_seq_);
 
     return offset;
 }
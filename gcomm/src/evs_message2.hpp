@@ -119,7 +119,8 @@ private:
 };
 
 class gcomm::evs::MessageNodeList :
-    public gcomm::Map<gcomm::UUID, MessageNode>
+    public gcomm::Map<gcomm::UUID, MessageNode,
+                      gcomm::FlatMap<gcomm::UUID, MessageNode> >
 {
 };
 
@@ -48,7 +48,9 @@ gcomm::evs::Node::Node(const Node& n)
     tstamp_          (n.tstamp_),
     seen_tstamp_     (n.seen_tstamp_),
     fifo_seq_        (n.fifo_seq_),
-    segment_         (n.segment_)
+    segment_         (n.segment_),
+    gap_request_     (n.gap_request_),
+    gap_request_tstamp_(n.gap_request_tstamp_)
 { }
 
 
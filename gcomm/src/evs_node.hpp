@@ -51,7 +51,9 @@ public:
         tstamp_            (gu::datetime::Date::now()),
         seen_tstamp_       (tstamp_),
         fifo_seq_          (-1),
-        segment_           (0)
+        segment_           (0),
+        gap_request_       (),
+        gap_request_tstamp_(gu::datetime::Date::zero())
     {}
 
     Node(const Node& n);
@@ -103,6 +105,15 @@ public:
     int64_t fifo_seq() const { return fifo_seq_; }
     SegmentId segment() const { return segment_; }
 
+    void set_gap_request(const Range& range, const gu::datetime::Date& t)
+    {
+        gap_request_        = range;
+        gap_request_tstamp_ = t;
+    }
+    const Range& gap_request() const { return gap_request_; }
+    const gu::datetime::Date& gap_request_tstamp() const
+    { return gap_request_tstamp_; }
+
     bool is_inactive() const;
     bool is_suspected() const;
 
@@ -138,6 +149,10 @@ private:
     gu::datetime::Date seen_tstamp_;
     int64_t fifo_seq_;
     SegmentId segment_;
+    // Range of the last retransmission request sent to the node and
+    // the time it was sent, used to merge subsequent gap requests.
+    Range gap_request_;
+    gu::datetime::Date gap_request_tstamp_;
 };
 
 class gcomm::evs::NodeMap : public Map<UUID, Node> { };
@@ -18,6 +18,8 @@
 
 #include "defaults.hpp"
 
+#include "gu_probe.h"
+
 #include <cmath>
 
 #include <stdexcept>
@@ -76,6 +78,7 @@ gcomm::evs::Proto::Proto(gu::Config&    conf,
     input_map_prof_    ("input_map"),
     delivery_prof_     ("delivery"),
     delivering_(false),
+    up_batch_(),
     my_uuid_(my_uuid),
     segment_(segment),
     known_(),
@@ -187,6 +190,32 @@ gcomm::evs::Proto::Proto(gu::Config&    conf,
     max_output_size_(128),
     mtu_(mtu),
     use_aggregate_(param<bool>(conf, uri, Conf::EvsUseAggregate, "true")),
+    aggregate_hold_(param<bool>(conf, uri, Conf::EvsAggregateHold, "false")),
+    ack_batch_(check_range(Conf::EvsAckBatch,
+                           param<int>(conf, uri, Conf::EvsAckBatch,
+                                      Defaults::EvsAckBatch),
+                           1, std::numeric_limits<int>::max())),
+    ack_delay_(check_range(Conf::EvsAckDelay,
+                           param<gu::datetime::Period>(
+                               conf, uri, Conf::EvsAckDelay,
+                               Defaults::EvsAckDelay),
+                           gu::datetime::Period(0),
+                           gu::datetime::Period::max())),
+    acks_pending_(0),
+    adaptive_window_(param<bool>(conf, uri, Conf::EvsAdaptiveWindow,
+                                 Defaults::EvsAdaptiveWindow)),
+    cur_window_(user_send_window_),
+    window_mark_(user_send_window_ - 1),
+    loss_mark_(-1),
+    aggregate_linger_(check_range(Conf::EvsAggregateLinger,
+                                  param<gu::datetime::Period>(
+                                      conf, uri, Conf::EvsAggregateLinger,
+                                      Defaults::EvsAggregateLinger),
+                                  gu::datetime::Period(0),
+                                  gu::datetime::Period(
+                                      Defaults::EvsAggregateLingerMax))),
+    last_user_msg_(gu::datetime::Date::zero()),
+    lingering_(false),
     self_loopback_(false),
     state_(S_CLOSED),
     shift_to_rfcnt_(0),
@@ -194,7 +223,8 @@ gcomm::evs::Proto::Proto(gu::Config&    conf,
     isolation_end_(gu::datetime::Date::zero()),
     delayed_list_(),
     auto_evict_(param<size_t>(conf, uri, Conf::EvsAutoEvict,
-                              Defaults::EvsAutoEvict))
+                              Defaults::EvsAutoEvict)),
+    member_addrs_()
 {
     log_info << "EVS version " << version_;
 
@@ -213,6 +243,11 @@ gcomm::evs::Proto::Proto(gu::Config&    conf,
     conf.set(Conf::EvsSendWindow, gu::to_string(send_window_));
     conf.set(Conf::EvsUserSendWindow, gu::to_string(user_send_window_));
     conf.set(Conf::EvsUseAggregate, gu::to_string(use_aggregate_));
+    conf.set(Conf::EvsAggregateHold, gu::to_string(aggregate_hold_));
+    conf.set(Conf::EvsAckBatch, gu::to_string(ack_batch_));
+    conf.set(Conf::EvsAckDelay, gu::to_string(ack_delay_));
+    conf.set(Conf::EvsAdaptiveWindow, gu::to_string(adaptive_window_));
+    conf.set(Conf::EvsAggregateLinger, gu::to_string(aggregate_linger_));
     conf.set(Conf::EvsDebugLogMask, gu::to_string(debug_mask_, std::hex));
     conf.set(Conf::EvsInfoLogMask, gu::to_string(info_mask_, std::hex));
     conf.set(Conf::EvsMaxInstallTimeouts, gu::to_string(max_install_timeouts_));
@@ -280,6 +315,7 @@ gcomm::evs::Proto::set_param(const std::string& key, const std::string& val)
             gu::from_string<seqno_t>(Defaults::EvsUserSendWindowMin),
             send_window_ + 1);
         conf_.set(Conf::EvsUserSendWindow, gu::to_string(user_send_window_));
+        cur_window_ = std::min(cur_window_, user_send_window_);
         return true;
     }
     else if (key == gcomm::Conf::EvsMaxInstallTimeouts)
@@ -386,6 +422,48 @@ gcomm::evs::Proto::set_param(const std::string& key, const std::string& val)
         conf_.set(Conf::EvsUseAggregate, gu::to_string(use_aggregate_));
         return true;
     }
+    else if (key == Conf::EvsAggregateHold)
+    {
+        aggregate_hold_ = gu::from_string<bool>(val);
+        conf_.set(Conf::EvsAggregateHold, gu::to_string(aggregate_hold_));
+        return true;
+    }
+    else if (key == Conf::EvsAckBatch)
+    {
+        ack_batch_ = check_range(Conf::EvsAckBatch,
+                                 gu::from_string<int>(val),
+                                 1, std::numeric_limits<int>::max());
+        conf_.set(Conf::EvsAckBatch, gu::to_string(ack_batch_));
+        return true;
+    }
+    else if (key == Conf::EvsAckDelay)
+    {
+        ack_delay_ = check_range(Conf::EvsAckDelay,
+                                 gu::from_string<gu::datetime::Period>(val),
+                                 gu::datetime::Period(0),
+                                 gu::datetime::Period::max());
+        conf_.set(Conf::EvsAckDelay, gu::to_string(ack_delay_));
+        reset_timer(T_ACK);
+        return true;
+    }
+    else if (key == Conf::EvsAdaptiveWindow)
+    {
+        adaptive_window_ = gu::from_string<bool>(val);
+        conf_.set(Conf::EvsAdaptiveWindow, gu::to_string(adaptive_window_));
+        cur_window_  = user_send_window_;
+        window_mark_ = last_sent_ + cur_window_;
+        return true;
+    }
+    else if (key == Conf::EvsAggregateLinger)
+    {
+        aggregate_linger_ = check_range(
+            Conf::EvsAggregateLinger,
+            gu::from_string<gu::datetime::Period>(val),
+            gu::datetime::Period(0),
+            gu::datetime::Period(Defaults::EvsAggregateLingerMax));
+        conf_.set(Conf::EvsAggregateLinger, gu::to_string(aggregate_linger_));
+        return true;
+    }
     else if (key == Conf::EvsDelayMargin)
     {
         delay_margin_ = gu::from_string<gu::datetime::Period>(val);
@@ -445,6 +523,7 @@ void gcomm::evs::Proto::handle_get_status(gu::Status& status) const
 {
     status.insert("evs_state", to_string(state_));
     status.insert("evs_repl_latency", safe_deliv_latency_.to_string());
+    status.insert("evs_send_window", gu::to_string(user_window()));
     std::string delayed_list_str;
     for (DelayedList::const_iterator i(delayed_list_.begin());
          i != delayed_list_.end(); ++i)
@@ -627,11 +706,9 @@ void gcomm::evs::Proto::handle_retrans_timer()
                 install_message_->source() == uuid())
             {
                 evs_log_debug(D_INSTALL_MSGS) << "retrans install";
-                gu::Buffer buf;
                 install_message_->set_flags(
                     install_message_->flags() | Message::F_RETRANS);
-                (void)serialize(*install_message_, buf);
-                Datagram dg(buf);
+                Datagram dg(serialize_datagram(*install_message_));
                 // Must not be sent as delegate, newly joining node
                 // will filter them out in handle_msg().
                 gu_trace(send_down(dg, ProtoDownMeta()));
@@ -662,8 +739,19 @@ void gcomm::evs::Proto::handle_retrans_timer()
     {
         const seqno_t prev_last_sent(last_sent_);
         evs_log_debug(D_TIMERS) << "send user timer, last_sent=" << last_sent_;
-        Datagram dg;
-        gu_trace((void)send_user(dg, 0xff, O_DROP, -1, -1));
+        // Messages may have been held for aggregation while
+        // acknowledgements got lost, sending them works as keepalive too.
+        while (output_.empty() == false)
+        {
+            int err;
+            gu_trace(err = send_user(send_window()));
+            if (err != 0) break;
+        }
+        if (prev_last_sent == last_sent_)
+        {
+            Datagram dg;
+            gu_trace((void)send_user(dg, 0xff, O_DROP, -1, -1));
+        }
         if (prev_last_sent == last_sent_)
         {
             log_warn << "could not send keepalive";
@@ -779,6 +867,41 @@ void gcomm::evs::Proto::handle_install_timer()
     install_timeout_count_++;
 }
 
+void gcomm::evs::Proto::handle_ack_timer()
+{
+    evs_log_debug(D_TIMERS) << "ack timer, pending " << acks_pending_;
+    if (state() != S_OPERATIONAL || acks_pending_ == 0)
+    {
+        acks_pending_ = 0;
+        return;
+    }
+
+    const seqno_t max_hs(input_map_->max_hs());
+    if (output_.empty() == true && last_sent_ < max_hs)
+    {
+        gu_trace(complete_user(max_hs));
+    }
+    else
+    {
+        profile_enter(send_gap_prof_);
+        gu_trace(send_gap(EVS_CALLER, UUID::nil(), current_view_.id(),
+                          Range()));
+        profile_leave(send_gap_prof_);
+    }
+}
+
+void gcomm::evs::Proto::handle_linger_timer()
+{
+    evs_log_debug(D_TIMERS) << "linger timer, queued " << output_.size();
+    lingering_ = false;
+    while (state() == S_OPERATIONAL && output_.empty() == false)
+    {
+        int err;
+        gu_trace(err = send_user(send_window()));
+        if (err != 0) break;
+    }
+}
+
 void gcomm::evs::Proto::handle_stats_timer()
 {
     reset_stats();
@@ -799,19 +922,6 @@ void gcomm::evs::Proto::handle_stats_timer()
 
 
 
-class TimerSelectOp
-{
-public:
-    TimerSelectOp(const gcomm::evs::Proto::Timer t_) : t(t_) { }
-    bool operator()(const gcomm::evs::Proto::TimerList::value_type& vt) const
-    {
-        return (gcomm::evs::Proto::TimerList::value(vt) == t);
-    }
-private:
-    gcomm::evs::Proto::Timer const t;
-};
-
-
 gu::datetime::Date gcomm::evs::Proto::next_expiration(const Timer t) const
 {
     gcomm_assert(state() != S_CLOSED);
@@ -844,34 +954,25 @@ gu::datetime::Date gcomm::evs::Proto::next_expiration(const Timer t) const
         }
     case T_STATS:
         return (now + stats_report_period_);
+    case T_ACK:
+        return (acks_pending_ > 0 ? now + ack_delay_ :
+                gu::datetime::Date::max());
+    case T_LINGER:
+        return (lingering_ == true ? now + aggregate_linger_ :
+                gu::datetime::Date::max());
     }
     gu_throw_fatal;
 }
 
 
-void timer_list_erase_by_type(gcomm::evs::Proto::TimerList& timer_list,
-                              gcomm::evs::Proto::Timer timer)
-{
-    gcomm::evs::Proto::TimerList::iterator i, i_next;
-    for (i = timer_list.begin(); i != timer_list.end(); i = i_next)
-    {
-        i_next = i, ++i_next;
-        if (gcomm::evs::Proto::TimerList::value(i) == timer)
-        {
-            timer_list.erase(i);
-        }
-    }
-}
-
 void gcomm::evs::Proto::reset_timer(Timer t)
 {
-    timer_list_erase_by_type(timers_, t);
-    timers_.insert(std::make_pair(next_expiration(t), t));
+    timers_.set(t, next_expiration(t));
 }
 
 void gcomm::evs::Proto::cancel_timer(Timer t)
 {
-    timer_list_erase_by_type(timers_, t);
+    timers_.cancel(t);
 }
 
 gu::datetime::Date gcomm::evs::Proto::handle_timers()
@@ -879,10 +980,10 @@ gu::datetime::Date gcomm::evs::Proto::handle_timers()
     gu::datetime::Date now(gu::datetime::Date::now());
 
     while (timers_.empty() == false &&
-           TimerList::key(timers_.begin()) <= now)
+           timers_.expiry(timers_.next()) <= now)
     {
-        Timer t(TimerList::value(timers_.begin()));
-        timers_.erase(timers_.begin());
+        Timer t(timers_.next());
+        timers_.cancel(t);
         switch (t)
         {
         case T_INACTIVITY:
@@ -897,6 +998,12 @@ gu::datetime::Date gcomm::evs::Proto::handle_timers()
         case T_STATS:
             handle_stats_timer();
             break;
+        case T_ACK:
+            handle_ack_timer();
+            break;
+        case T_LINGER:
+            handle_linger_timer();
+            break;
         }
         if (state() == S_CLOSED)
         {
@@ -910,7 +1017,7 @@ gu::datetime::Date gcomm::evs::Proto::handle_timers()
         evs_log_debug(D_TIMERS) << "no timers set";
         return gu::datetime::Date::max();
     }
-    return TimerList::key(timers_.begin());
+    return timers_.expiry(timers_.next());
 }
 
 
@@ -1259,6 +1366,7 @@ void gcomm::evs::Proto::deliver_reg_view(const InstallMessage& im,
         << "with the same view id";
 
     set_stable_view(view);
+    GU_PROBE2(evs_view, view.id().seq(), view.members().size());
     ProtoUpMeta up_meta(UUID::nil(), ViewId(), &view);
     send_up(Datagram(), up_meta);
 }
@@ -1462,6 +1570,14 @@ bool gcomm::evs::Proto::is_flow_control(const seqno_t seq, const seqno_t win) co
     {
         return true;
     }
+
+    // Transport send queues are backed up: keep new messages in output_
+    // while own messages are in flight, whatever completes them will flush
+    // the output queue (see aggregate_hold()).
+    if (seq > base + 1 && is_congested() == true)
+    {
+        return true;
+    }
     return false;
 }
 
@@ -1566,6 +1682,7 @@ int gcomm::evs::Proto::send_user(Datagram& dg,
     }
     gu_trace(pop_header(msg, dg));
     sent_msgs_[Message::T_USER]++;
+    ack_sent();
 
     if (delivering_ == false)
     {
@@ -1601,6 +1718,61 @@ size_t gcomm::evs::Proto::aggregate_len() const
     return (is_aggregate == true ? ret : 0);
 }
 
+// Small message can be held back if there are own messages in flight:
+// whatever completes them (acks or user messages from other members)
+// will flush the output queue, see handle_user() and handle_gap().
+bool gcomm::evs::Proto::aggregate_hold(const Datagram& dg) const
+{
+    return (aggregate_hold_ == true &&
+            use_aggregate_  == true &&
+            2*(dg.len() + AggregateMessage().serial_size()) <= mtu() &&
+            input_map_->aru_seq() < last_sent_);
+}
+
+// Small message can be held for a while if it follows the previous one
+// closely, more are likely to follow and go out in the same aggregate.
+// Linger timer flushes the output queue.
+bool gcomm::evs::Proto::aggregate_linger(const Datagram& dg,
+                                         const gu::datetime::Date& now) const
+{
+    return (aggregate_linger_ > gu::datetime::Period(0) &&
+            use_aggregate_ == true &&
+            2*(dg.len() + AggregateMessage().serial_size()) <= mtu() &&
+            now < last_user_msg_ + aggregate_linger_);
+}
+
+// Grows adaptive window by one message when a window worth of own
+// messages sent since the last change has become safe.
+void gcomm::evs::Proto::grow_window()
+{
+    if (adaptive_window_ == false || cur_window_ >= user_send_window_)
+    {
+        return;
+    }
+
+    if (input_map_->safe_seq(NodeMap::value(self_i_).index()) >= window_mark_)
+    {
+        ++cur_window_;
+        window_mark_ = last_sent_ + cur_window_;
+        evs_log_debug(D_USER_MSGS) << "send window grown to " << cur_window_;
+    }
+}
+
+// Halves adaptive window on retransmission request for own messages
+// sent after the previous decrease, so one loss burst halves it once.
+void gcomm::evs::Proto::shrink_window(const Range& range)
+{
+    if (adaptive_window_ == false || range.hs() <= loss_mark_)
+    {
+        return;
+    }
+
+    cur_window_  = std::max(seqno_t(1), cur_window_ / 2);
+    loss_mark_   = last_sent_;
+    window_mark_ = last_sent_ + cur_window_;
+    evs_log_debug(D_RETRANS) << "send window shrunk to " << cur_window_;
+}
+
 int gcomm::evs::Proto::send_user(const seqno_t win)
 {
     gcomm_assert(output_.empty() == false);
@@ -1685,6 +1857,40 @@ void gcomm::evs::Proto::complete_user(const seqno_t high_seq)
 }
 
 
+// Returns true if acknowledging received message may be left for later:
+// until ack_batch_ messages are pending, ack_delay_ has passed or
+// the acknowledgement is piggybacked on a user or gap message.
+bool gcomm::evs::Proto::defer_ack()
+{
+    if (ack_batch_ <= 1 || state() != S_OPERATIONAL)
+    {
+        return false;
+    }
+
+    if (++acks_pending_ >= ack_batch_)
+    {
+        return false;
+    }
+
+    if (acks_pending_ == 1)
+    {
+        reset_timer(T_ACK);
+    }
+
+    return true;
+}
+
+// Own aru and last sent seqno went out, nothing to acknowledge.
+void gcomm::evs::Proto::ack_sent()
+{
+    if (acks_pending_ > 0)
+    {
+        acks_pending_ = 0;
+        cancel_timer(T_ACK);
+    }
+}
+
+
 int gcomm::evs::Proto::send_delegate(Datagram& wb)
 {
     DelegateMessage dm(version_, uuid(), current_view_.id(),
@@ -1728,15 +1934,17 @@ void gcomm::evs::Proto::send_gap(EVS_CALLER_ARG,
                   flags);
 
     evs_log_debug(D_GAP_MSGS) << EVS_LOG_METHOD << gm;
-    gu::Buffer buf;
-    serialize(gm, buf);
-    Datagram dg(buf);
+    Datagram dg(serialize_datagram(gm));
     int err = send_down(dg, ProtoDownMeta());
     if (err != 0)
     {
         log_debug << "send failed: " << strerror(err);
     }
     sent_msgs_[Message::T_GAP]++;
+    if (source_view_id == current_view_.id())
+    {
+        ack_sent();
+    }
     gu_trace(handle_gap(gm, self_i_));
 }
 
@@ -1884,9 +2092,7 @@ void gcomm::evs::Proto::send_join(bool handle)
 
     JoinMessage jm(create_join());
 
-    gu::Buffer buf;
-    serialize(jm, buf);
-    Datagram dg(buf);
+    Datagram dg(serialize_datagram(jm));
     int err = send_down(dg, ProtoDownMeta());
 
     if (err != 0)
@@ -1937,9 +2143,7 @@ void gcomm::evs::Proto::send_leave(bool handle)
 
     evs_log_debug(D_LEAVE_MSGS) << "sending leave msg " << lm;
 
-    gu::Buffer buf;
-    serialize(lm, buf);
-    Datagram dg(buf);
+    Datagram dg(serialize_datagram(lm));
     int err = send_down(dg, ProtoDownMeta());
     if (err != 0)
     {
@@ -2023,9 +2227,7 @@ void gcomm::evs::Proto::send_install(EVS_CALLER_ARG)
     evs_log_info(I_STATE) << "sending install message" << imsg;
     gcomm_assert(consensus_.is_consistent(imsg));
 
-    gu::Buffer buf;
-    serialize(imsg, buf);
-    Datagram dg(buf);
+    Datagram dg(serialize_datagram(imsg));
     int err = send_down(dg, ProtoDownMeta());
     if (err != 0)
     {
@@ -2045,9 +2247,7 @@ void gcomm::evs::Proto::send_delayed_list()
     {
         elm.add(i->first, i->second.state_change_cnt());
     }
-    gu::Buffer buf;
-    serialize(elm, buf);
-    Datagram dg(buf);
+    Datagram dg(serialize_datagram(elm));
     (void)send_down(dg, ProtoDownMeta());
     handle_delayed_list(elm, self_i_);
 }
@@ -2067,6 +2267,8 @@ void gcomm::evs::Proto::resend(const UUID& gap_source, const Range range)
         return;
     }
 
+    shrink_window(range);
+
     evs_log_debug(D_RETRANS) << " retrans requested by "
                              << gap_source
                              << " "
@@ -2247,6 +2449,28 @@ void gcomm::evs::Proto::handle_foreign(const Message& msg)
                  std::make_pair(source, Node(*this))));
     assert(NodeMap::value(i).operational() == true);
 
+    // A restarted node shows up with a new UUID from the address of its
+    // previous incarnation, which will never respond again. Once transport
+    // has handed the address over to the new UUID, declare the old one
+    // inactive right away instead of waiting out suspect and inactive
+    // timeouts in the gather round below.
+    const std::string addr(get_address(source));
+    for (AddrMap::const_iterator ai(member_addrs_.begin());
+         addr.empty() == false && ai != member_addrs_.end(); ++ai)
+    {
+        NodeMap::iterator ni;
+        if (ai->second == addr && ai->first != source &&
+            get_address(ai->first) != addr &&
+            (ni = known_.find(ai->first)) != known_.end() &&
+            NodeMap::value(ni).operational() == true)
+        {
+            log_info << self_string() << " node " << ai->first
+                     << " at " << addr << " restarted as " << source
+                     << ", declaring previous incarnation inactive";
+            set_inactive(ai->first);
+        }
+    }
+
     if (state() == S_JOINING || state() == S_GATHER ||
         state() == S_OPERATIONAL)
     {
@@ -2614,14 +2838,28 @@ int gcomm::evs::Proto::handle_down(Datagram& wb, const ProtoDownMeta& dm)
     ++n_send_queue_s_;
 
     int ret = 0;
+    const gu::datetime::Date now(gu::datetime::Date::now());
+    const bool linger(aggregate_linger(wb, now));
+    last_user_msg_ = now;
 
-    if (output_.empty() == true)
+    if (output_.empty() == true && aggregate_hold(wb) == true)
+    {
+        output_.push_back(std::make_pair(wb, dm));
+    }
+    else if (output_.empty() == true && linger == true)
+    {
+        output_.push_back(std::make_pair(wb, dm));
+        lingering_ = true;
+        reset_timer(T_LINGER);
+    }
+    else if (output_.empty() == true)
     {
         int err;
+        grow_window();
         err = send_user(wb,
                         dm.user_type(),
                         dm.order(),
-                        user_send_window_,
+                        user_window(),
                         -1);
 
         switch (err)
@@ -2876,6 +3114,8 @@ void gcomm::evs::Proto::shift_to(const State s, const bool send_j)
             {
                 current_view_.add_member(uuid, NodeMap::value(nmi).segment());
                 NodeMap::value(nmi).set_index(idx++);
+                NodeMap::value(nmi).set_gap_request(
+                    Range(), gu::datetime::Date::zero());
             }
             else
             {
@@ -2893,8 +3133,21 @@ void gcomm::evs::Proto::shift_to(const State s, const bool send_j)
                 << previous_view_ << " current view " << current_view_;
         }
 
+        member_addrs_.clear();
+        for (NodeList::const_iterator i(current_view_.members().begin());
+             i != current_view_.members().end(); ++i)
+        {
+            const std::string addr(get_address(NodeList::key(i)));
+            if (NodeList::key(i) != uuid() && addr.empty() == false)
+            {
+                member_addrs_.insert(std::make_pair(NodeList::key(i), addr));
+            }
+        }
+
         input_map_->reset(current_view_.members().size());
         last_sent_ = -1;
+        window_mark_ = cur_window_ - 1;
+        loss_mark_ = -1;
         state_ = S_OPERATIONAL;
         deliver_reg_view(*install_message_, previous_view_);
 
@@ -2999,23 +3252,13 @@ void gcomm::evs::Proto::deliver_finish(const InputMapMsg& msg)
         if (msg.msg().order() != O_DROP)
         {
             gu_trace(validate_reg_msg(msg.msg()));
-            profile_enter(delivery_prof_);
             ProtoUpMeta um(msg.msg().source(),
                            msg.msg().source_view_id(),
                            0,
                            msg.msg().user_type(),
                            msg.msg().order(),
                            msg.msg().seq());
-            try
-            {
-                send_up(msg.rb(), um);
-            }
-            catch (...)
-            {
-                log_info << msg.msg() << " " << msg.rb().len();
-                throw;
-            }
-            profile_leave(delivery_prof_);
+            up_batch_.push_back(msg.rb(), um);
         }
     }
     else
@@ -3045,13 +3288,37 @@ void gcomm::evs::Proto::deliver_finish(const InputMapMsg& msg)
                            am.user_type(),
                            msg.msg().order(),
                            msg.msg().seq());
-            gu_trace(send_up(dg, um));
+            up_batch_.push_back(dg, um);
             offset += am.serial_size() + am.len();
         }
         gcomm_assert(offset == msg.rb().len());
     }
 }
 
+// Passes messages collected by deliver_finish() up in one call.
+// Must be called with delivering_ set, so that upper layers sending
+// from handle_up() don't trigger recursive delivery.
+void gcomm::evs::Proto::deliver_up_batch()
+{
+    if (up_batch_.empty() == true) return;
+
+    profile_enter(delivery_prof_);
+    try
+    {
+        send_up_batch(up_batch_);
+    }
+    catch (...)
+    {
+        log_info << "failed to deliver batch of " << up_batch_.size()
+                 << " messages";
+        up_batch_.clear();
+        throw;
+    }
+    up_batch_.clear();
+    profile_leave(delivery_prof_);
+}
+
+
 void gcomm::evs::Proto::deliver()
 {
     if (delivering_ == true)
@@ -3099,6 +3366,7 @@ void gcomm::evs::Proto::deliver()
             break;
         }
     }
+    gu_trace(deliver_up_batch());
     delivering_ = false;
 
     assert(input_map_->begin() == input_map_->end() ||
@@ -3185,6 +3453,7 @@ void gcomm::evs::Proto::deliver_trans()
             gu_trace(input_map_->erase(i));
         }
     }
+    gu_trace(deliver_up_batch());
 
     // Sanity check:
     // There must not be any messages left that
@@ -3394,18 +3663,39 @@ void gcomm::evs::Proto::handle_user(const UserMessage& msg,
 
     profile_leave(input_map_prof_);
 
-    // Check for missing messages
+    // Check for missing messages. Messages which follow a gap would
+    // request the same range over and over again, so while the previous
+    // request for the same lowest unseen seqno is younger than retrans
+    // period only the part beyond it is requested, and only if this
+    // message left a new hole.
     if (range.hs()                         >  range.lu() &&
         (msg.flags() & Message::F_RETRANS) == 0                 )
     {
-        evs_log_debug(D_RETRANS) << " requesting retrans from "
-                                 << msg.source() << " "
-                                 << range
-                                 << " due to input map gap, aru "
-                                 << input_map_->aru_seq();
-        profile_enter(send_gap_prof_);
-        gu_trace(send_gap(EVS_CALLER, msg.source(), current_view_.id(), range));
-        profile_leave(send_gap_prof_);
+        const gu::datetime::Date now(gu::datetime::Date::now());
+        const Range& prev_req(inst.gap_request());
+        Range req(range);
+
+        if (prev_req.lu() == range.lu() &&
+            now < inst.gap_request_tstamp() + retrans_period_)
+        {
+            req = Range(prev_req.hs() + 1, msg.seq() - 1);
+        }
+
+        if (req.lu() <= req.hs())
+        {
+            evs_log_debug(D_RETRANS) << " requesting retrans from "
+                                     << msg.source() << " "
+                                     << req
+                                     << " due to input map gap, aru "
+                                     << input_map_->aru_seq();
+            profile_enter(send_gap_prof_);
+            gu_trace(send_gap(EVS_CALLER, msg.source(), current_view_.id(),
+                              req));
+            profile_leave(send_gap_prof_);
+        }
+
+        inst.set_gap_request(range, (req == range ?
+                                     now : inst.gap_request_tstamp()));
     }
 
     // Seqno range completion and acknowledgement
@@ -3417,16 +3707,23 @@ void gcomm::evs::Proto::handle_user(const UserMessage& msg,
     {
         // Message not originated from this instance, output queue is empty
         // and last_sent seqno should be advanced
-        gu_trace(complete_user(max_hs));
+        if (defer_ack() == false)
+        {
+            gu_trace(complete_user(max_hs));
+        }
     }
     else if (output_.empty()           == true  &&
              input_map_->aru_seq() != prev_aru)
     {
         // Output queue empty and aru changed, send gap to inform others
-        evs_log_debug(D_GAP_MSGS) << "sending empty gap";
-        profile_enter(send_gap_prof_);
-        gu_trace(send_gap(EVS_CALLER, UUID::nil(), current_view_.id(), Range()));
-        profile_leave(send_gap_prof_);
+        if (defer_ack() == false)
+        {
+            evs_log_debug(D_GAP_MSGS) << "sending empty gap";
+            profile_enter(send_gap_prof_);
+            gu_trace(send_gap(EVS_CALLER, UUID::nil(), current_view_.id(),
+                              Range()));
+            profile_leave(send_gap_prof_);
+        }
     }
 
     // Send messages
@@ -3436,7 +3733,7 @@ void gcomm::evs::Proto::handle_user(const UserMessage& msg,
         while (output_.empty() == false)
         {
             int err;
-            gu_trace(err = send_user(send_window_));
+            gu_trace(err = send_user(send_window()));
             if (err != 0)
             {
                 break;
@@ -3628,7 +3925,7 @@ void gcomm::evs::Proto::handle_gap(const GapMessage& msg, NodeMap::iterator ii)
             while (output_.empty() == false)
             {
                 int err;
-                gu_trace(err = send_user(send_window_));
+                gu_trace(err = send_user(send_window()));
                 if (err != 0)
                     break;
             }
@@ -3637,7 +3934,7 @@ void gcomm::evs::Proto::handle_gap(const GapMessage& msg, NodeMap::iterator ii)
         else
         {
             const seqno_t max_hs(input_map_->max_hs());
-            if (last_sent_ <  max_hs)
+            if (last_sent_ <  max_hs && defer_ack() == false)
             {
                 gu_trace(complete_user(max_hs));
             }
@@ -3744,9 +4041,7 @@ void gcomm::evs::Proto::retrans_leaves(const MessageNodeList& node_list)
                                      lm.fifo_seq(),
                                      Message::F_RETRANS | Message::F_SOURCE);
 
-                gu::Buffer buf;
-                serialize(send_lm, buf);
-                Datagram dg(buf);
+                Datagram dg(serialize_datagram(send_lm));
                 gu_trace(send_delegate(dg));
             }
         }
@@ -3863,17 +4158,15 @@ void gcomm::evs::Proto::asymmetry_elimination()
     // Allow some time to pass from setting install timers to get
     // join messages accumulated.
     const gu::datetime::Date now(gu::datetime::Date::now());
-    TimerList::const_iterator ti(
-        find_if(timers_.begin(), timers_.end(), TimerSelectOp(T_INSTALL)));
-
-    assert(ti != timers_.end());
-    if (ti == timers_.end())
+    assert(timers_.is_set(T_INSTALL));
+    if (timers_.is_set(T_INSTALL) == false)
     {
         log_warn << "install timer not set in asymmetry_elimination()";
         return;
     }
 
-    if (install_timeout_ - suspect_timeout_ < TimerList::key(ti) - now)
+    if (install_timeout_ - suspect_timeout_ <
+        timers_.expiry(T_INSTALL) - now)
     {
         // No check yet
         return;
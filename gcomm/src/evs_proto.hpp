@@ -159,12 +159,27 @@ public:
                   size_t n_aggregated = 1);
     size_t mtu() const { return mtu_; }
     size_t aggregate_len() const;
+    bool   aggregate_hold(const Datagram&) const;
+    bool   aggregate_linger(const Datagram&, const gu::datetime::Date&) const;
     int send_user(const seqno_t);
     void complete_user(const seqno_t);
+    // Effective send windows, adapted if evs.adaptive_window is set
+    seqno_t user_window() const
+    {
+        return (adaptive_window_ ? cur_window_ : user_send_window_);
+    }
+    seqno_t send_window() const
+    {
+        return (send_window_ - user_send_window_ + user_window());
+    }
+    void grow_window();
+    void shrink_window(const Range&);
     int send_delegate(Datagram&);
     void send_gap(EVS_CALLER_ARG,
                   const UUID&, const ViewId&, const Range,
                   bool commit = false, bool req_all = false);
+    bool defer_ack();
+    void ack_sent();
     const JoinMessage& create_join();
     void send_join(bool tval = true);
     void set_join(const JoinMessage&, const UUID&);
@@ -192,6 +207,7 @@ public:
 
     void validate_reg_msg(const UserMessage&);
     void deliver_finish(const InputMapMsg&);
+    void deliver_up_batch();
     void deliver();
     void deliver_local(bool trans = false);
     void deliver_causal(uint8_t user_type, seqno_t seqno, const Datagram&);
@@ -318,12 +334,77 @@ public:
         T_INACTIVITY,
         T_RETRANS,
         T_INSTALL,
-        T_STATS
+        T_STATS,
+        T_ACK,
+        T_LINGER
     };
     /*!
      * Internal timer list
+     *
+     * There is at most one pending expiration per timer type, so instead of
+     * an ordered map the list keeps a deadline slot per type and caches the
+     * earliest one. Setting or canceling a timer is constant time and the
+     * next expiration is available without a scan. Unset timers hold
+     * Date::max().
      */
-    typedef MultiMap<gu::datetime::Date, Timer> TimerList;
+    class TimerList
+    {
+    public:
+        TimerList() : next_(T_INACTIVITY) { clear(); }
+
+        void set(Timer const t, const gu::datetime::Date& expiry)
+        {
+            expiry_[t] = expiry;
+            if (expiry < expiry_[next_]) next_ = t;
+            else if (t == next_) update_next();
+        }
+
+        void cancel(Timer const t)
+        {
+            expiry_[t] = gu::datetime::Date::max();
+            if (t == next_) update_next();
+        }
+
+        void clear()
+        {
+            for (size_t i(0); i < n_timers; ++i)
+            {
+                expiry_[i] = gu::datetime::Date::max();
+            }
+            next_ = T_INACTIVITY;
+        }
+
+        bool is_set(Timer const t) const
+        {
+            return (expiry_[t] < gu::datetime::Date::max());
+        }
+
+        bool empty() const { return (is_set(next_) == false); }
+
+        const gu::datetime::Date& expiry(Timer const t) const
+        {
+            return expiry_[t];
+        }
+
+        /* timer which expires first, meaningful only if !empty() */
+        Timer next() const { return next_; }
+
+    private:
+        static size_t const n_timers = T_LINGER + 1;
+
+        void update_next()
+        {
+            size_t n(0);
+            for (size_t i(1); i < n_timers; ++i)
+            {
+                if (expiry_[i] < expiry_[n]) n = i;
+            }
+            next_ = static_cast<Timer>(n);
+        }
+
+        gu::datetime::Date expiry_[n_timers];
+        Timer              next_;
+    };
 private:
     TimerList timers_;
 public:
@@ -332,6 +413,8 @@ public:
     void handle_retrans_timer();
     void handle_install_timer();
     void handle_stats_timer();
+    void handle_ack_timer();
+    void handle_linger_timer();
     gu::datetime::Date next_expiration(const Timer) const;
     void reset_timer(Timer);
     void cancel_timer(Timer);
@@ -396,6 +479,7 @@ private:
     prof::Profile input_map_prof_;
     prof::Profile delivery_prof_;
     bool delivering_;
+    ProtoUpBatch up_batch_; // messages collected by deliver_finish()
     UUID my_uuid_;
     SegmentId segment_;
     //
@@ -484,10 +568,24 @@ private:
     seqno_t user_send_window_;
     // Output message queue
     std::deque<std::pair<Datagram, ProtoDownMeta> > output_;
-    std::vector<gu::byte_t> send_buf_;
+    gu::Buffer send_buf_;
     uint32_t max_output_size_;
     size_t mtu_;
     bool use_aggregate_;
+    bool aggregate_hold_;
+    // Acknowledgement coalescing, see evs.ack_batch and evs.ack_delay
+    int ack_batch_;
+    gu::datetime::Period ack_delay_;
+    int acks_pending_;
+    // Send window adaptation, see evs.adaptive_window
+    bool adaptive_window_;
+    seqno_t cur_window_;  // current user send window
+    seqno_t window_mark_; // grow window when own safe seq reaches this
+    seqno_t loss_mark_;   // last sent seq at previous window decrease
+    // Aggregation linger, see evs.aggregate_linger
+    gu::datetime::Period aggregate_linger_;
+    gu::datetime::Date last_user_msg_; // time of previous upper layer message
+    bool lingering_;
     bool self_loopback_;
     State state_;
     int shift_to_rfcnt_;
@@ -546,6 +644,11 @@ private:
     DelayedList delayed_list_;
     size_t      auto_evict_;
 
+    // Addresses of current view members, used to recognize a restarted
+    // node by its previous incarnation
+    typedef std::map<UUID, std::string> AddrMap;
+    AddrMap member_addrs_;
+
     // non-copyable
     Proto(const Proto&);
     void operator=(const Proto&);
@@ -47,6 +47,35 @@ namespace gcomm
         static std::string const ProtonetBackend;
         static std::string const ProtonetVersion;
 
+        /*!
+         * @brief Number of threads running socket I/O handlers
+         *        ("protonet.io_threads")
+         *
+         * Socket reads, writes, checksums and SSL processing of different
+         * peers may run in parallel, protocol processing stays serialized.
+         */
+        static std::string const ProtonetIoThreads;
+
+        /*!
+         * @brief Number of threads running SSL handshakes
+         *        ("protonet.handshake_threads")
+         *
+         * With non-zero value handshake processing is taken off the
+         * I/O threads, established streams are handed back to them.
+         */
+        static std::string const ProtonetHandshakeThreads;
+
+        /*!
+         * @brief Scheduling priority of the protonet timer thread
+         *        ("protonet.timer_thread_prio")
+         *
+         * When set, EVS keepalives and inactivity checks also run in a
+         * dedicated thread with this priority (policy:priority, e.g.
+         * "rr:2"), so peers are not suspected because of CPU bursts in
+         * socket handlers. Empty value (default) disables the thread.
+         */
+        static std::string const ProtonetTimerThreadPrio;
+
         /*!
          * @brief TCP non-blocking flag ("socket.non_blocking")
          *
@@ -60,6 +89,10 @@ namespace gcomm
          * 0 - none    (backward compatible)
          * 1 - CRC-32  (backward compatible)
          * 2 - CRC-32C (optimized and potentially HW-accelerated on Intel CPUs)
+         *
+         * Messages sent over SSL connections are not checksummed, TLS
+         * already protects their integrity. Receivers verify checksum
+         * only if the sender has set one, so this is backward compatible.
          */
         static std::string const SocketChecksum;
 
@@ -68,6 +101,17 @@ namespace gcomm
          */
         static std::string const SocketRecvBufSize;
 
+        /*!
+         * @brief Send queue size in bytes at which lower protocol layers
+         *        report congestion to EVS, 0 disables.
+         */
+        static std::string const SocketSendQHighWater;
+
+        /*!
+         * @brief Send queue size in bytes at which congestion is cleared.
+         */
+        static std::string const SocketSendQLowWater;
+
         /*!
          * @brief GMCast scheme for transport URI ("gmcast")
          */
@@ -125,6 +169,17 @@ namespace gcomm
          */
         static std::string const GMCastMCastTTL;
 
+        /*!
+         * @brief GMCast multicast MTU ("gmcast.mcast_mtu")
+         *
+         * Maximum size of datagrams sent to multicast address. When
+         * multicast is used, it limits message size for the whole stack,
+         * so that GCS fragments actions into datagrams which do not need
+         * IP fragmentation and are recovered one by one by EVS
+         * retransmission if lost. Defaults to protonet MTU.
+         */
+        static std::string const GMCastMCastMtu;
+
         static std::string const GMCastTimeWait;
         static std::string const GMCastPeerTimeout;
 
@@ -160,6 +215,49 @@ namespace gcomm
          */
         static std::string const GMCastSegment;
 
+        /*!
+         * @brief Relay tree fan-out for messages entering the local
+         *        segment ("gmcast.segment_fanout")
+         *
+         * By default the node which receives a message from a remote
+         * segment relays it to every other node of the local segment.
+         * If set to a positive value, it relays to at most this many
+         * nodes which in turn forward it further along a tree spanning
+         * the segment ordered by UUID. All nodes of the
+         * segment must run a version which supports this option.
+         */
+        static std::string const GMCastSegmentFanout;
+
+        /*!
+         * @brief Number of TCP connections to keep to each peer
+         *        ("gmcast.conns_per_peer")
+         *
+         * If greater than one, the node with smaller UUID opens additional
+         * connections to the peer and datagrams are sent over them in
+         * round robin fashion. Must have the same value on all nodes.
+         */
+        static std::string const GMCastConnsPerPeer;
+
+        /*!
+         * @brief Compression level for connections to other segments
+         *        ("gmcast.segment_compress")
+         *
+         * If non-zero (1-9, zlib level), datagrams sent to nodes of other
+         * segments are compressed as a stream per connection. Compression
+         * is used only if both ends of the connection have it enabled,
+         * nodes which don't support it are not affected. Connections
+         * inside segment are never compressed. Note that over SSL
+         * connections compression may leak information about the message
+         * contents through their size. Default is 0 (disabled).
+         */
+        static std::string const GMCastSegmentCompress;
+
+        /*!
+         * @brief Smallest datagram in bytes to compress
+         *        ("gmcast.segment_compress_threshold")
+         */
+        static std::string const GMCastSegmentCompressThreshold;
+
 
         /*!
          * @brief EVS scheme for transport URI ("evs")
@@ -296,6 +394,67 @@ namespace gcomm
          */
         static std::string const EvsUseAggregate;
 
+        /*!
+         * @brief Hold small user messages for aggregation
+         *        ("evs.aggregate_hold")
+         *
+         * When enabled, small user messages are not sent right away while
+         * previously sent ones have not been acknowledged by all members.
+         * They are aggregated and sent when the acknowledgements arrive,
+         * like Nagle's algorithm does in TCP. This trades up to a round
+         * trip of latency for fewer messages when there are many small
+         * writesets. Has no effect if Conf::EvsUseAggregate is disabled.
+         * Default is false.
+         */
+        static std::string const EvsAggregateHold;
+
+        /*!
+         * @brief Number of received messages which may be left
+         *        unacknowledged ("evs.ack_batch")
+         *
+         * When no own messages are queued for sending, by default every
+         * received user message which advances the input map state is
+         * acknowledged right away by an empty user or gap message. With
+         * a value greater than 1 about that many messages are
+         * acknowledged at once, outgoing user messages carry the
+         * acknowledgement too. Pending acknowledgements are sent after
+         * Conf::EvsAckDelay at the latest. This trades some latency for
+         * fewer control messages. Default is 1.
+         */
+        static std::string const EvsAckBatch;
+
+        /*!
+         * @brief Maximum time acknowledgement is left pending
+         *        ("evs.ack_delay")
+         *
+         * Has no effect unless Conf::EvsAckBatch is greater than 1.
+         */
+        static std::string const EvsAckDelay;
+
+        /*!
+         * @brief Adapt user send window ("evs.adaptive_window")
+         *
+         * If enabled, the window for messages from the upper layer starts
+         * at Conf::EvsUserSendWindow, is halved when other nodes request
+         * retransmission of own messages and grows back by one message
+         * per window worth of own messages becoming safe, like TCP
+         * congestion avoidance. Conf::EvsSendWindow is kept the same
+         * distance above it. Default is false.
+         */
+        static std::string const EvsAdaptiveWindow;
+
+        /*!
+         * @brief Time to wait for more messages to aggregate
+         *        ("evs.aggregate_linger")
+         *
+         * If greater than zero, a small message from the upper layer
+         * which arrives within this period from the previous one is
+         * held for up to this period, so that the following messages
+         * can be sent in the same aggregate. Requires
+         * Conf::EvsUseAggregate. Default is 0 (disabled).
+         */
+        static std::string const EvsAggregateLinger;
+
         /*!
          * @brief Period to generate keepalives for causal messages
          *
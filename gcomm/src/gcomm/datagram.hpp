@@ -24,8 +24,12 @@ namespace gcomm
     //
     // Header structure is the following (MSB first)
     //
-    // | version(4) | reserved(2) | F_CRC(2) | len(24) |
-    // |                   CRC(32)                     |
+    // | version(4) | reserved(1) | F_DEFLATE(1) | F_CRC(2) | len(24) |
+    // |                          CRC(32)                             |
+    //
+    // F_DEFLATE is set on datagrams compressed with LinkDeflate, len and
+    // CRC then refer to the compressed payload. It is sent only to peers
+    // which have announced in the GMCast handshake that they accept it.
     //
     class NetHeader
     {
@@ -68,6 +72,9 @@ namespace gcomm
         bool has_crc32()  const { return (len_ & F_CRC32);  }
         bool has_crc32c() const { return (len_ & F_CRC32C); }
 
+        void set_deflate()        { len_ |= F_DEFLATE; }
+        bool has_deflate() const  { return (len_ & F_DEFLATE); }
+
         uint32_t crc32()  const { return crc32_; }
 
         int version() const
@@ -95,8 +102,9 @@ namespace gcomm
 
         enum
         {
-            F_CRC32  = 1 << 24, /* backward compatible */
-            F_CRC32C = 1 << 25
+            F_CRC32   = 1 << 24, /* backward compatible */
+            F_CRC32C  = 1 << 25,
+            F_DEFLATE = 1 << 26
         };
 
         uint32_t len_;
@@ -121,7 +129,8 @@ namespace gcomm
         {
         case 0:
             if ((hdr.len_ & NetHeader::flags_mask_) &
-                ~(NetHeader::F_CRC32 | NetHeader::F_CRC32C))
+                ~(NetHeader::F_CRC32 | NetHeader::F_CRC32C |
+                  NetHeader::F_DEFLATE))
             {
                 gu_throw_error(EPROTO)
                     << "invalid flags "
@@ -216,6 +225,9 @@ namespace gcomm
 
         void normalize()
         {
+            // already normalized, keep sharing the payload
+            if (header_len() == 0 && offset_ == 0) return;
+
             const gu::SharedBuffer old_payload(payload_);
             payload_ = gu::SharedBuffer(new gu::Buffer);
             payload_->reserve(header_len() + old_payload->size() - offset_);
@@ -6,7 +6,8 @@
  * @file map.hpp
  *
  * This file contains templates that are thin wrappers for std::map
- * and std::multimap with some extra functionality.
+ * and std::multimap with some extra functionality, and FlatMap sorted
+ * vector container which can be used in place of std::map.
  */
 
 #ifndef GCOMM_MAP_HPP
@@ -16,6 +17,8 @@
 
 #include <utility>
 #include <iterator>
+#include <algorithm>
+#include <vector>
 #include <map>
 
 #include "gcomm/exception.hpp"
@@ -23,6 +26,131 @@
 
 namespace gcomm
 {
+    /*!
+     * Sorted vector with std::map interface, for small maps which are
+     * mostly built in key order, copied, compared and iterated over.
+     *
+     * Unlike std::map, insert() and erase() invalidate all iterators and
+     * references, and value_type key is not const.
+     */
+    template<typename K, typename V>
+    class FlatMap
+    {
+        typedef std::vector<std::pair<K, V> > VectorType;
+
+    public:
+
+        typedef K                                       key_type;
+        typedef V                                       mapped_type;
+        typedef typename VectorType::value_type         value_type;
+        typedef typename VectorType::reference          reference;
+        typedef typename VectorType::const_reference    const_reference;
+        typedef typename VectorType::iterator           iterator;
+        typedef typename VectorType::const_iterator     const_iterator;
+        typedef typename VectorType::reverse_iterator   reverse_iterator;
+        typedef typename VectorType::const_reverse_iterator
+                                                        const_reverse_iterator;
+        typedef typename VectorType::size_type          size_type;
+
+        FlatMap() : vec_() {}
+
+        iterator       begin()       { return vec_.begin(); }
+        iterator       end()         { return vec_.end();   }
+        const_iterator begin() const { return vec_.begin(); }
+        const_iterator end()   const { return vec_.end();   }
+
+        reverse_iterator       rbegin()       { return vec_.rbegin(); }
+        reverse_iterator       rend()         { return vec_.rend();   }
+        const_reverse_iterator rbegin() const { return vec_.rbegin(); }
+        const_reverse_iterator rend()   const { return vec_.rend();   }
+
+        size_type size()  const { return vec_.size();  }
+        bool      empty() const { return vec_.empty(); }
+        void      clear()       { vec_.clear(); }
+
+        void reserve(size_type const n) { vec_.reserve(n); }
+
+        iterator lower_bound(const K& k)
+        {
+            return std::lower_bound(vec_.begin(), vec_.end(), k, KeyLess());
+        }
+
+        const_iterator lower_bound(const K& k) const
+        {
+            return std::lower_bound(vec_.begin(), vec_.end(), k, KeyLess());
+        }
+
+        iterator find(const K& k)
+        {
+            iterator const i(lower_bound(k));
+            return ((i != vec_.end() && !(k < i->first)) ? i : vec_.end());
+        }
+
+        const_iterator find(const K& k) const
+        {
+            const_iterator const i(lower_bound(k));
+            return ((i != vec_.end() && !(k < i->first)) ? i : vec_.end());
+        }
+
+        std::pair<iterator, bool> insert(const value_type& vt)
+        {
+            // fast path for elements coming in key order
+            if (vec_.empty() || vec_.back().first < vt.first)
+            {
+                vec_.push_back(vt);
+                return std::make_pair(vec_.end() - 1, true);
+            }
+
+            iterator const i(lower_bound(vt.first));
+            if (i != vec_.end() && !(vt.first < i->first))
+            {
+                return std::make_pair(i, false);
+            }
+            return std::make_pair(vec_.insert(i, vt), true);
+        }
+
+        template <class InputIterator>
+        void insert(InputIterator first, InputIterator const last)
+        {
+            for (; first != last; ++first) insert(*first);
+        }
+
+        mapped_type& operator[](const K& k)
+        {
+            return insert(value_type(k, V())).first->second;
+        }
+
+        void erase(iterator const i)                   { vec_.erase(i); }
+        void erase(iterator const i, iterator const j) { vec_.erase(i, j); }
+
+        size_type erase(const K& k)
+        {
+            iterator const i(find(k));
+            if (i == vec_.end()) return 0;
+            vec_.erase(i);
+            return 1;
+        }
+
+        void swap(FlatMap& other) { vec_.swap(other.vec_); }
+
+        bool operator==(const FlatMap& other) const
+        {
+            return (vec_ == other.vec_);
+        }
+
+    private:
+
+        struct KeyLess
+        {
+            bool operator()(const value_type& vt, const K& k) const
+            {
+                return (vt.first < k);
+            }
+        };
+
+        VectorType vec_;
+    };
+
     template<typename K, typename V, typename C>
     class MapBase
     {
@@ -201,7 +329,8 @@ namespace gcomm
     std::ostream& operator<<(std::ostream& os, const MapBase<K, V, C>& map)
     {
         std::copy(map.begin(), map.end(),
-                  std::ostream_iterator<const std::pair<const K, V> >(os, ""));
+                  std::ostream_iterator<const typename MapBase<K, V, C>::value_type>(
+                      os, ""));
         return os;
     }
 
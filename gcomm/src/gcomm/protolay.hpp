@@ -27,6 +27,7 @@
 
 #include <cerrno>
 
+#include <deque>
 #include <list>
 #include <utility>
 
@@ -41,6 +42,13 @@ namespace gcomm
     class ProtoUpMeta;
     std::ostream& operator<<(std::ostream&, const ProtoUpMeta&);
 
+    /*!
+     * @class ProtoUpBatch
+     *
+     * Sequence of messages passed upwards in protocol stack at once.
+     */
+    class ProtoUpBatch;
+
     /*!
      * @class ProtoDownMeta
      *
@@ -164,6 +172,36 @@ inline std::ostream& gcomm::operator<<(std::ostream& os, const ProtoUpMeta& um)
     return os;
 }
 
+/* consecutive messages with their contexts to pass up in one call */
+class gcomm::ProtoUpBatch
+{
+public:
+    ProtoUpBatch() : msgs_() { }
+
+    void push_back(const Datagram& dg, const ProtoUpMeta& um)
+    {
+        msgs_.push_back(Msg(dg, um));
+    }
+
+    size_t             size()             const { return msgs_.size();   }
+    bool               empty()            const { return msgs_.empty();  }
+    const Datagram&    dg(const size_t i) const { return msgs_[i].dg_;   }
+    const ProtoUpMeta& um(const size_t i) const { return msgs_[i].um_;   }
+
+    void clear() { msgs_.clear(); }
+
+private:
+    struct Msg
+    {
+        Msg(const Datagram& dg, const ProtoUpMeta& um) : dg_(dg), um_(um) { }
+        Datagram    dg_;
+        ProtoUpMeta um_;
+    };
+
+    /* deque since ProtoUpMeta is not assignable */
+    std::deque<Msg> msgs_;
+};
+
 /* message context to pass down? */
 class gcomm::ProtoDownMeta
 {
@@ -204,6 +242,16 @@ public:
     virtual int  handle_down (Datagram&, const ProtoDownMeta&) = 0;
     virtual void handle_up   (const void*, const Datagram&, const ProtoUpMeta&) = 0;
 
+    /* handles messages delivered from lower layer as a batch, layers that
+     * can amortize per-message work over the batch override this */
+    virtual void handle_up_batch(const void* id, const ProtoUpBatch& batch)
+    {
+        for (size_t i(0); i < batch.size(); ++i)
+        {
+            handle_up(id, batch.dg(i), batch.um(i));
+        }
+    }
+
     void set_up_context(Protolay *up)
     {
         if (std::find(up_context_.begin(),
@@ -267,6 +315,22 @@ public:
         }
     }
 
+    /* passes a batch of messages to the upper layer in one call */
+    void send_up_batch(const ProtoUpBatch& batch)
+    {
+        if (up_context_.empty() == true)
+        {
+            gu_throw_fatal << this << " up context(s) not set";
+        }
+
+        CtxList::iterator i, i_next;
+        for (i = up_context_.begin(); i != up_context_.end(); i = i_next)
+        {
+            i_next = i, ++i_next;
+            (*i)->handle_up_batch(this, batch);
+        }
+    }
+
     /* apparently passes data buffer to lower layer, what is return value? */
     int send_down(Datagram& dg, const ProtoDownMeta& down_meta)
     {
@@ -371,6 +435,24 @@ public:
     }
 
 
+    //! True if some layer below can't keep up with sending
+    bool is_congested() const
+    {
+        if (handle_is_congested() == true) return true;
+        for (CtxList::const_iterator i(down_context_.begin());
+             i != down_context_.end(); ++i)
+        {
+            if ((*i)->is_congested() == true) return true;
+        }
+        return false;
+    }
+
+    virtual bool handle_is_congested() const
+    {
+        return false;
+    }
+
+
     virtual gu::datetime::Date handle_timers()
     {
         return gu::datetime::Date::max();
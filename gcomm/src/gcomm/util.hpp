@@ -45,6 +45,17 @@ namespace gcomm
     }
 
 
+    // Serializes message straight into the payload of a new datagram,
+    // the payload is shared by the datagram and its copies.
+    template <class C>
+    Datagram serialize_datagram(const C& c)
+    {
+        gu::SharedBuffer buf(new gu::Buffer());
+        serialize(c, *buf);
+        return Datagram(buf);
+    }
+
+
     template <class C>
     size_t unserialize(const gu::Buffer& buf, size_t offset, C& c)
     {
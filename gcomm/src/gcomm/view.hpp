@@ -143,7 +143,7 @@ namespace gcomm
     }
 
 
-    class NodeList : public gcomm::Map<UUID, Node> { };
+    class NodeList : public gcomm::Map<UUID, Node, FlatMap<UUID, Node> > { };
 
     class View
     {
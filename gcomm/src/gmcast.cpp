@@ -14,6 +14,8 @@
 #include "gu_resolver.hpp"
 #include "gu_asio.hpp" // gu::conf::use_ssl
 
+#include <algorithm>
+
 using namespace std::rel_ops;
 
 using gcomm::gmcast::Proto;
@@ -56,6 +58,27 @@ gcomm::GMCast::GMCast(Protonet& net, const gu::URI& uri,
     segment_ (check_range(Conf::GMCastSegment,
                           param<int>(conf_, uri, Conf::GMCastSegment, "0"),
                           0, 255)),
+    segment_fanout_(check_range(Conf::GMCastSegmentFanout,
+                                param<int>(conf_, uri,
+                                           Conf::GMCastSegmentFanout,
+                                           Defaults::GMCastSegmentFanout),
+                                0, 256)),
+    conns_per_peer_(check_range(Conf::GMCastConnsPerPeer,
+                                param<int>(conf_, uri,
+                                           Conf::GMCastConnsPerPeer,
+                                           Defaults::GMCastConnsPerPeer),
+                                1, 17)),
+    segment_compress_(check_range(Conf::GMCastSegmentCompress,
+                                  param<int>(conf_, uri,
+                                             Conf::GMCastSegmentCompress,
+                                             Defaults::GMCastSegmentCompress),
+                                  0, 10)),
+    segment_compress_threshold_(
+        check_range(Conf::GMCastSegmentCompressThreshold,
+                    param<size_t>(conf_, uri,
+                                  Conf::GMCastSegmentCompressThreshold,
+                                  Defaults::GMCastSegmentCompressThreshold),
+                    size_t(1), std::numeric_limits<size_t>::max())),
     my_uuid_      (my_uuid ? *my_uuid : UUID(0, 0)),
     use_ssl_      (param<bool>(conf_, uri, gu::conf::use_ssl, "false")),
     // @todo: technically group name should be in path component
@@ -71,6 +94,11 @@ gcomm::GMCast::GMCast(Protonet& net, const gu::URI& uri,
                        Conf::GMCastMCastTTL,
                        param<int>(conf_, uri, Conf::GMCastMCastTTL, "1"),
                        1, 256)),
+    mcast_mtu_    (check_range(
+                       Conf::GMCastMCastMtu,
+                       param<size_t>(conf_, uri, Conf::GMCastMCastMtu,
+                                     gu::to_string(pnet().mtu())),
+                       size_t(1024), pnet().mtu() + 1)),
     listener_     (0),
     mcast_        (),
     pending_addrs_(),
@@ -82,6 +110,8 @@ gcomm::GMCast::GMCast(Protonet& net, const gu::URI& uri,
     relay_set_    (),
     segment_map_  (),
     self_index_   (std::numeric_limits<size_t>::max()),
+    segment_tree_ (),
+    stripes_      (),
     time_wait_    (param<gu::datetime::Period>(
                        conf_, uri,
                        Conf::GMCastTimeWait, Defaults::GMCastTimeWait)),
@@ -190,15 +220,21 @@ gcomm::GMCast::GMCast(Protonet& net, const gu::URI& uri,
 
     log_info << self_string() << " listening at " << listen_addr_;
     log_info << self_string() << " multicast: " << mcast_addr_
-             << ", ttl: " << mcast_ttl_;
+             << ", ttl: " << mcast_ttl_ << ", mtu: " << mcast_mtu_;
 
     conf_.set(Conf::GMCastListenAddr, listen_addr_);
     conf_.set(Conf::GMCastMCastAddr, mcast_addr_);
     conf_.set(Conf::GMCastVersion, gu::to_string(version_));
     conf_.set(Conf::GMCastTimeWait, gu::to_string(time_wait_));
     conf_.set(Conf::GMCastMCastTTL, gu::to_string(mcast_ttl_));
+    conf_.set(Conf::GMCastMCastMtu, gu::to_string(mcast_mtu_));
     conf_.set(Conf::GMCastPeerTimeout, gu::to_string(peer_timeout_));
     conf_.set(Conf::GMCastSegment, gu::to_string<int>(segment_));
+    conf_.set(Conf::GMCastSegmentFanout, gu::to_string(segment_fanout_));
+    conf_.set(Conf::GMCastConnsPerPeer, gu::to_string(conns_per_peer_));
+    conf_.set(Conf::GMCastSegmentCompress, gu::to_string(segment_compress_));
+    conf_.set(Conf::GMCastSegmentCompressThreshold,
+              gu::to_string(segment_compress_threshold_));
 }
 
 gcomm::GMCast::~GMCast()
@@ -348,6 +384,8 @@ void gcomm::GMCast::close(bool force)
     listener_ = 0;
 
     segment_map_.clear();
+    segment_tree_.clear();
+    stripes_.clear();
     for (ProtoMap::iterator
              i = proto_map_->begin(); i != proto_map_->end(); ++i)
     {
@@ -371,6 +409,15 @@ void gcomm::GMCast::erase_proto(gmcast::ProtoMap::iterator i)
     {
         relay_set_.erase(si);
     }
+    for (StripeMap::iterator sti(stripes_.begin()); sti != stripes_.end();
+         ++sti)
+    {
+        std::vector<Socket*>& sockets(sti->second.sockets);
+        sockets.erase(std::remove(sockets.begin(), sockets.end(),
+                                  p->socket().get()),
+                      sockets.end());
+        sti->second.next = 0;
+    }
     proto_map_->erase(i);
     delete p;
 }
@@ -546,6 +593,22 @@ void gcomm::GMCast::handle_connected(Proto* rp)
     }
 }
 
+namespace
+{
+    // orders duplicate connections by descending handshake uuid
+    class DupCmp
+    {
+    public:
+        bool operator()(const std::pair<gcomm::UUID,
+                                        ProtoMap::iterator>& a,
+                        const std::pair<gcomm::UUID,
+                                        ProtoMap::iterator>& b) const
+        {
+            return (b.first < a.first);
+        }
+    };
+}
+
 void gcomm::GMCast::handle_established(Proto* est)
 {
     log_info << self_string() << " connection established to "
@@ -637,45 +700,45 @@ void gcomm::GMCast::handle_established(Proto* est)
     AddrList::value(i).set_retry_cnt(-1);
     AddrList::value(i).set_max_retries(max_initial_reconnect_attempts_);
 
-    // Cleanup all previously established entries with same
+    // Cleanup all but conns_per_peer_ established entries with same
     // remote uuid. It is assumed that the most recent connection
-    // is usually the healthiest one.
-    ProtoMap::iterator j, j_next;
-    for (j = proto_map_->begin(); j != proto_map_->end(); j = j_next)
+    // is usually the healthiest one. Both ends see the same handshake
+    // uuids, so they agree on which connections to keep.
+    std::vector<std::pair<UUID, ProtoMap::iterator> > dups;
+    for (ProtoMap::iterator j(proto_map_->begin()); j != proto_map_->end();
+         ++j)
     {
-        j_next = j, ++j_next;
-
         Proto* p(ProtoMap::value(j));
 
         if (p->remote_uuid() == est->remote_uuid())
         {
-            if (p->handshake_uuid() < est->handshake_uuid())
-            {
-                log_debug << self_string()
-                          << " cleaning up duplicate "
-                          << p->socket()
-                          << " after established "
-                          << est->socket();
-                erase_proto(j);
-            }
-            else if (p->handshake_uuid() > est->handshake_uuid())
-            {
-                log_debug << self_string()
-                          << " cleaning up established "
-                          << est->socket()
-                          << " which is duplicate of "
-                          << p->socket();
-                erase_proto(proto_map_->find_checked(est->socket()->id()));
-                update_addresses();
-                return;
-            }
-            else
-            {
-                assert(p == est);
-            }
+            dups.push_back(std::make_pair(p->handshake_uuid(), j));
         }
     }
 
+    std::sort(dups.begin(), dups.end(), DupCmp());
+    for (size_t k(conns_per_peer_); k < dups.size(); ++k)
+    {
+        Proto* p(ProtoMap::value(dups[k].second));
+        if (p == est)
+        {
+            log_debug << self_string()
+                      << " cleaning up established "
+                      << est->socket()
+                      << " which is duplicate of "
+                      << ProtoMap::value(dups[0].second)->socket();
+            erase_proto(dups[k].second);
+            update_addresses();
+            return;
+        }
+        log_debug << self_string()
+                  << " cleaning up duplicate "
+                  << p->socket()
+                  << " after established "
+                  << est->socket();
+        erase_proto(dups[k].second);
+    }
+
     AddrList::iterator ali(find_if(remote_addrs_.begin(),
                                    remote_addrs_.end(),
                                    AddrListUUIDCmp(est->remote_uuid())));
@@ -752,6 +815,25 @@ bool gcomm::GMCast::is_connected(const std::string& addr, const UUID& uuid) cons
     return false;
 }
 
+int gcomm::GMCast::connection_count(const std::string& addr,
+                                    const UUID& uuid) const
+{
+    int ret(0);
+    for (ProtoMap::const_iterator i = proto_map_->begin();
+         i != proto_map_->end(); ++i)
+    {
+        Proto* conn = ProtoMap::value(i);
+
+        if (addr == conn->remote_addr() ||
+            uuid == conn->remote_uuid())
+        {
+            ++ret;
+        }
+    }
+
+    return ret;
+}
+
 
 void gcomm::GMCast::insert_address (const std::string& addr,
                              const UUID&   uuid,
@@ -779,7 +861,7 @@ void gcomm::GMCast::insert_address (const std::string& addr,
 void gcomm::GMCast::update_addresses()
 {
     LinkMap link_map;
-    std::set<UUID> uuids;
+    std::map<UUID, int> uuids;
     /* Add all established connections into uuid_map and update
      * list of remote addresses */
 
@@ -809,14 +891,15 @@ void gcomm::GMCast::update_addresses()
                                remote_addrs_);
             }
 
-            if (uuids.insert(rp->remote_uuid()).second == false)
+            int const conns(++uuids[rp->remote_uuid()]);
+            if (conns > conns_per_peer_)
             {
                 // Duplicate entry, drop this one
                 // @todo Deeper inspection about the connection states
                 log_debug << self_string() << " dropping duplicate entry";
                 erase_proto(i);
             }
-            else
+            else if (conns == 1)
             {
                 link_map.insert(Link(rp->remote_uuid(),
                                      rp->remote_addr(),
@@ -898,6 +981,9 @@ void gcomm::GMCast::update_addresses()
     // Build multicast tree
     log_debug << self_string() << " --- mcast tree begin ---";
     segment_map_.clear();
+    segment_tree_.clear();
+    stripes_.clear();
+    segment_tree_.push_back(std::make_pair(uuid(), static_cast<Socket*>(0)));
 
     Segment& local_segment(segment_map_[segment_]);
 
@@ -908,6 +994,7 @@ void gcomm::GMCast::update_addresses()
     }
 
     self_index_ = 0;
+    std::map<UUID, Socket*> peers;
     for (ProtoMap::const_iterator i(proto_map_->begin()); i != proto_map_->end();
          ++i)
     {
@@ -915,6 +1002,17 @@ void gcomm::GMCast::update_addresses()
 
         log_debug << "Proto: " << p;
 
+        if (p.state() == Proto::S_OK)
+        {
+            // the first established connection represents the peer,
+            // further ones are only used for striping
+            std::pair<std::map<UUID, Socket*>::iterator, bool> ret(
+                peers.insert(std::make_pair(p.remote_uuid(),
+                                            p.socket().get())));
+            stripes_[ret.first->second].sockets.push_back(p.socket().get());
+            if (ret.second == false) continue;
+        }
+
         if (p.remote_segment() == segment_)
         {
             if (p.state() == Proto::S_OK &&
@@ -922,6 +1020,8 @@ void gcomm::GMCast::update_addresses()
                  p.mcast_addr() != mcast_addr_))
             {
                 local_segment.push_back(p.socket().get());
+                segment_tree_.push_back(
+                    std::make_pair(p.remote_uuid(), p.socket().get()));
                 if (p.remote_uuid() < uuid())
                 {
                     ++self_index_;
@@ -937,6 +1037,7 @@ void gcomm::GMCast::update_addresses()
             }
         }
     }
+    std::sort(segment_tree_.begin(), segment_tree_.end());
     log_debug << self_string() << " self index: " << self_index_;
     log_debug << self_string() << " --- mcast tree end ---";
 }
@@ -989,8 +1090,10 @@ void gcomm::GMCast::reconnect()
 
         gcomm_assert(remote_uuid != uuid());
 
-        if (is_connected(remote_addr, remote_uuid) == false &&
-            ae.next_reconnect()                <= now)
+        int const conns(connection_count(remote_addr, remote_uuid));
+
+        if (conns                == 0 &&
+            ae.next_reconnect()  <= now)
         {
             if (ae.retry_cnt() > ae.max_retries())
             {
@@ -1015,6 +1118,18 @@ void gcomm::GMCast::reconnect()
                 //
             }
         }
+        else if (conns > 0 && conns < conns_per_peer_ && uuid() < remote_uuid)
+        {
+            // additional connections for striping are opened by the
+            // node with smaller uuid only to avoid connect races
+            log_debug << self_string() << " opening "
+                      << conns_per_peer_ - conns
+                      << " additional connections to " << remote_uuid;
+            for (int n(conns); n < conns_per_peer_; ++n)
+            {
+                gmcast_connect(remote_addr);
+            }
+        }
     }
 }
 
@@ -1152,7 +1267,9 @@ void gcomm::GMCast::check_liveness()
              ++i)
         {
             Proto* p(ProtoMap::value(i));
-            if (p->state() == Proto::S_OK)
+            if (p->state() == Proto::S_OK &&
+                (conns_per_peer_ == 1 ||
+                 stripes_.find(p->socket().get()) != stripes_.end()))
             {
                 proto_set.insert(p);
             }
@@ -1223,7 +1340,8 @@ void gcomm::GMCast::relay(const Message& msg,
 
     // reset all relay flags from message to be relayed
     relay_msg.set_flags(relay_msg.flags() &
-                        ~(Message::F_RELAY | Message::F_SEGMENT_RELAY));
+                        ~(Message::F_RELAY | Message::F_SEGMENT_RELAY |
+                          Message::F_TREE_RELAY));
 
     // if F_RELAY is set in received message, relay to all peers except
     // the originator
@@ -1236,9 +1354,9 @@ void gcomm::GMCast::relay(const Message& msg,
             Segment& segment(i->second);
             for (Segment::iterator j(segment.begin()); j != segment.end(); ++j)
             {
-                if ((*j)->id() != exclude_id)
+                if (is_peer_socket(*j, exclude_id) == false)
                 {
-                    send(*j, relay_dg);
+                    send(stripe(*j), relay_dg);
                 }
             }
         }
@@ -1254,7 +1372,7 @@ void gcomm::GMCast::relay(const Message& msg,
             for (std::set<Socket*>::iterator ri(relay_set_.begin());
                  ri != relay_set_.end(); ++ri)
             {
-                send(*ri, relay_dg);
+                send(stripe(*ri), relay_dg);
             }
             gu_trace(pop_header(relay_msg, relay_dg));
             relay_msg.set_flags(relay_msg.flags() & ~Message::F_RELAY);
@@ -1267,19 +1385,78 @@ void gcomm::GMCast::relay(const Message& msg,
         }
 
         // Relay to local segment
+        if (segment_fanout_ > 0 && mcast_ == 0)
+        {
+            relay_msg.set_relay_uuid(uuid());
+            tree_relay(relay_msg, relay_dg);
+            return;
+        }
+
         gu_trace(push_header(relay_msg, relay_dg));
         Segment& segment(segment_map_[segment_]);
         for (Segment::iterator i(segment.begin()); i != segment.end(); ++i)
         {
-            send(*i, relay_dg);
+            send(stripe(*i), relay_dg);
         }
     }
+    else if (msg.flags() & Message::F_TREE_RELAY)
+    {
+        tree_relay(relay_msg, relay_dg);
+    }
     else
     {
         log_warn << "GMCast::relay() called without relay flags set";
     }
 }
 
+// Local segment members are numbered from the root in UUID order and
+// member k forwards to members k*fanout + 1 ... k*fanout + fanout. Members
+// may temporarily disagree on the segment during membership changes, EVS
+// recovers from missed and duplicate messages.
+void gcomm::GMCast::tree_relay(Message& msg, Datagram& dg)
+{
+    const UUID& root(msg.relay_uuid());
+    size_t const n(segment_tree_.size());
+    size_t root_idx(n);
+    size_t self_idx(n);
+
+    for (size_t i(0); i < n; ++i)
+    {
+        if (segment_tree_[i].first == root)   root_idx = i;
+        if (segment_tree_[i].first == uuid()) self_idx = i;
+    }
+
+    if (root_idx == n || self_idx == n)
+    {
+        // root is not known here, cover the rest of the tree by
+        // relaying to the whole segment
+        log_debug << self_string() << " relay tree root " << root
+                  << " not in local segment";
+        msg.set_flags(msg.flags() & ~Message::F_TREE_RELAY);
+        gu_trace(push_header(msg, dg));
+        for (size_t i(0); i < n; ++i)
+        {
+            if (segment_tree_[i].second != 0 &&
+                segment_tree_[i].first  != root)
+            {
+                send(stripe(segment_tree_[i].second), dg);
+            }
+        }
+        return;
+    }
+
+    msg.set_flags(msg.flags() | Message::F_TREE_RELAY);
+    gu_trace(push_header(msg, dg));
+
+    size_t const fanout(segment_fanout_);
+    size_t const first((self_idx + n - root_idx) % n * fanout + 1);
+
+    for (size_t k(first); k < first + fanout && k < n; ++k)
+    {
+        send(stripe(segment_tree_[(root_idx + k) % n].second), dg);
+    }
+}
+
 void gcomm::GMCast::handle_up(const void*        id,
                        const Datagram&    dg,
                        const ProtoUpMeta& um)
@@ -1368,7 +1545,8 @@ void gcomm::GMCast::handle_up(const void*        id,
                     return;
                 }
                 if (msg.flags() &
-                    (Message::F_RELAY | Message::F_SEGMENT_RELAY))
+                    (Message::F_RELAY | Message::F_SEGMENT_RELAY |
+                     Message::F_TREE_RELAY))
                 {
                     relay(msg,
                           Datagram(dg, dg.offset() + msg.serial_size()),
@@ -1443,6 +1621,34 @@ void gcomm::GMCast::handle_up(const void*        id,
 }
 
 
+gcomm::Socket* gcomm::GMCast::stripe(Socket* s)
+{
+    if (conns_per_peer_ > 1)
+    {
+        StripeMap::iterator i(stripes_.find(s));
+        if (i != stripes_.end() && i->second.sockets.empty() == false)
+        {
+            Stripe& st(i->second);
+            st.next = (st.next + 1) % st.sockets.size();
+            return st.sockets[st.next];
+        }
+    }
+    return s;
+}
+
+bool gcomm::GMCast::is_peer_socket(Socket* s, const void* id) const
+{
+    if (s->id() == id) return true;
+    StripeMap::const_iterator i(stripes_.find(s));
+    if (i == stripes_.end()) return false;
+    for (std::vector<Socket*>::const_iterator j(i->second.sockets.begin());
+         j != i->second.sockets.end(); ++j)
+    {
+        if ((*j)->id() == id) return true;
+    }
+    return false;
+}
+
 int gcomm::GMCast::handle_down(Datagram& dg, const ProtoDownMeta& dm)
 {
     Message msg(version_, Message::T_USER_BASE, uuid(), 1, segment_);
@@ -1455,7 +1661,7 @@ int gcomm::GMCast::handle_down(Datagram& dg, const ProtoDownMeta& dm)
         for (std::set<Socket*>::iterator ri(relay_set_.begin());
              ri != relay_set_.end(); ++ri)
         {
-            send(*ri, dg);
+            send(stripe(*ri), dg);
         }
         gu_trace(pop_header(msg, dg));
         msg.set_flags(msg.flags() & ~Message::F_RELAY);
@@ -1478,7 +1684,7 @@ int gcomm::GMCast::handle_down(Datagram& dg, const ProtoDownMeta& dm)
                 relay_set_.find(segment[target_idx]) == relay_set_.end())
             {
                 gu_trace(push_header(msg, dg));
-                send(segment[target_idx], dg);
+                send(stripe(segment[target_idx]), dg);
                 gu_trace(pop_header(msg, dg));
             }
         }
@@ -1493,7 +1699,7 @@ int gcomm::GMCast::handle_down(Datagram& dg, const ProtoDownMeta& dm)
                 if (relay_set_.empty() == true ||
                     relay_set_.find(*i) == relay_set_.end())
                 {
-                    send(*i, dg);
+                    send(stripe(*i), dg);
                 }
             }
             gu_trace(pop_header(msg, dg));
@@ -1634,6 +1840,59 @@ std::string gcomm::GMCast::handle_get_address(const UUID& uuid) const
     return (ali == remote_addrs_.end() ? "" : AddrList::key(ali));
 }
 
+// Reports the worst path over established links: the smallest MSS and
+// the largest RTT, and statistics of every established link as
+// comma separated list of
+// uuid:rtt:rtt_var:retrans:bytes_sent:bytes_received:send_q_bytes:addr
+void gcomm::GMCast::handle_get_status(gu::Status& status) const
+{
+    size_t    mss(0);
+    long long rtt(0);
+    std::ostringstream links;
+
+    for (ProtoMap::const_iterator i = proto_map_->begin();
+         i != proto_map_->end(); ++i)
+    {
+        const Proto* p(ProtoMap::value(i));
+
+        if (p->state() != Proto::S_OK) continue;
+
+        size_t const m(p->socket()->mss());
+
+        if (m > 0 && (mss == 0 || m < mss)) mss = m;
+
+        Socket::Stats const st(p->socket()->stats());
+
+        rtt = std::max(rtt, st.rtt);
+
+        if (links.tellp() > 0) links << ",";
+        links << p->remote_uuid().full_str() << ":"
+              << st.rtt << ":" << st.rtt_var << ":" << st.retrans << ":"
+              << st.bytes_sent << ":" << st.bytes_received << ":"
+              << st.send_q_bytes << ":" << p->socket()->remote_addr();
+    }
+
+    status.insert("gmcast_path_mss", gu::to_string(mss));
+    status.insert("gmcast_path_rtt", gu::to_string(rtt));
+    status.insert("gmcast_links", links.str());
+}
+
+bool gcomm::GMCast::handle_is_congested() const
+{
+    for (ProtoMap::const_iterator i = proto_map_->begin();
+         i != proto_map_->end(); ++i)
+    {
+        const Proto* p(ProtoMap::value(i));
+
+        if (p->state() == Proto::S_OK && p->socket()->congested() == true)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 void gcomm::GMCast::add_or_del_addr(const std::string& val)
 {
     if (val.compare(0, 4, "add:") == 0)
@@ -1726,6 +1985,8 @@ bool gcomm::GMCast::set_param(const std::string& key, const std::string& val)
                     erase_proto(pi);
                 }
                 segment_map_.clear();
+                segment_tree_.clear();
+                stripes_.clear();
             }
             return true;
         }
@@ -1749,9 +2010,14 @@ bool gcomm::GMCast::set_param(const std::string& key, const std::string& val)
                  key == Conf::GMCastMCastAddr   ||
                  key == Conf::GMCastMCastPort   ||
                  key == Conf::GMCastMCastTTL    ||
+                 key == Conf::GMCastMCastMtu    ||
                  key == Conf::GMCastTimeWait    ||
                  key == Conf::GMCastPeerTimeout ||
-                 key == Conf::GMCastSegment)
+                 key == Conf::GMCastSegment     ||
+                 key == Conf::GMCastSegmentFanout ||
+                 key == Conf::GMCastConnsPerPeer ||
+                 key == Conf::GMCastSegmentCompress ||
+                 key == Conf::GMCastSegmentCompressThreshold)
         {
             gu_throw_error(EPERM) << "can't change value during runtime";
         }
@@ -18,6 +18,7 @@
 
 
 #include <set>
+#include <algorithm>
 
 #ifndef GCOMM_GMCAST_MAX_VERSION
 #define GCOMM_GMCAST_MAX_VERSION 0
@@ -45,10 +46,16 @@ namespace gcomm
         void handle_stable_view(const View& view);
         void handle_evict(const UUID& uuid);
         std::string handle_get_address(const UUID& uuid) const;
+        void handle_get_status(gu::Status& status) const;
+        bool handle_is_congested() const;
         bool set_param(const std::string& key, const std::string& val);
         // Transport interface
         const UUID& uuid() const { return my_uuid_; }
         SegmentId segment() const { return segment_; }
+        // zlib level for connections to other segments, 0 if disabled
+        int    segment_compress()           const { return segment_compress_; }
+        size_t segment_compress_threshold() const
+        { return segment_compress_threshold_; }
         void connect_precheck(bool start_prim);
         void connect();
         void connect(const gu::URI&);
@@ -79,7 +86,9 @@ namespace gcomm
 
         size_t mtu() const
         {
-            return pnet_.mtu() - (4 + UUID::serial_size());
+            size_t const mtu(mcast_addr_.empty() ?
+                             pnet_.mtu() : std::min(pnet_.mtu(), mcast_mtu_));
+            return mtu - (4 + UUID::serial_size());
         }
 
         void remove_viewstate_file() const
@@ -169,6 +178,10 @@ namespace gcomm
         int               version_;
         static const int  max_version_ = GCOMM_GMCAST_MAX_VERSION;
         uint8_t           segment_;
+        int               segment_fanout_;
+        int               conns_per_peer_;
+        int               segment_compress_;
+        size_t            segment_compress_threshold_;
         UUID              my_uuid_;
         bool              use_ssl_;
         std::string       group_name_;
@@ -177,6 +190,7 @@ namespace gcomm
         std::string       mcast_addr_;
         std::string       bind_ip_;
         int               mcast_ttl_;
+        size_t            mcast_mtu_;
         Acceptor*         listener_;
         SocketPtr         mcast_;
         AddrList          pending_addrs_;
@@ -193,6 +207,21 @@ namespace gcomm
         SegmentMap segment_map_;
         // self index in local segment when ordered by UUID
         size_t self_index_;
+        // local segment members including self ordered by UUID, used
+        // to relay messages from remote segments if segment_fanout_ > 0
+        typedef std::vector<std::pair<UUID, Socket*> > SegmentTree;
+        SegmentTree segment_tree_;
+        // established connections to each peer keyed by the socket which
+        // represents the peer in segment_map_ and relay_set_, datagrams
+        // are striped over them if conns_per_peer_ > 1
+        struct Stripe
+        {
+            Stripe() : sockets(), next(0) { }
+            std::vector<Socket*> sockets;
+            size_t               next;
+        };
+        typedef std::map<Socket*, Stripe> StripeMap;
+        StripeMap stripes_;
         gu::datetime::Period time_wait_;
         gu::datetime::Period check_period_;
         gu::datetime::Period peer_timeout_;
@@ -220,6 +249,12 @@ namespace gcomm
         // Check if there exists connection that matches to either
         // remote addr or uuid
         bool is_connected(const std::string& addr, const UUID& uuid) const;
+        // Number of connections that match to either remote addr or uuid
+        int connection_count(const std::string& addr, const UUID& uuid) const;
+        // Socket to send next datagram to the peer represented by s
+        Socket* stripe(Socket* s);
+        // Check if socket id belongs to the peer represented by s
+        bool is_peer_socket(Socket* s, const void* id) const;
         // Inset address to address list
         void insert_address(const std::string& addr, const UUID& uuid, AddrList&);
         // Scan through proto entries and update address lists
@@ -228,6 +263,9 @@ namespace gcomm
         void check_liveness();
         void relay(const gmcast::Message& msg, const Datagram& dg,
                    const void* exclude_id);
+        // Forward to own children in the segment tree rooted at
+        // msg.relay_uuid()
+        void tree_relay(gmcast::Message& msg, Datagram& dg);
         // Reconnecting
         void reconnect();
 
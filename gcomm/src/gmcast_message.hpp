@@ -33,7 +33,15 @@ public:
         // and to all other segments except source segment
         F_RELAY                   = 1 << 5,
         // relay message to all peers in the same segment
-        F_SEGMENT_RELAY           = 1 << 6
+        F_SEGMENT_RELAY           = 1 << 6,
+        // relay message down the local segment relay tree rooted at
+        // relay_uuid (see gmcast.segment_fanout)
+        F_TREE_RELAY              = 1 << 7,
+        // in handshake response and ok messages only: sender accepts
+        // compressed datagrams on this connection (gmcast.segment_compress).
+        // Relay flags are not looked at in handshake messages, so older
+        // nodes ignore it.
+        F_DEFLATE                 = F_SEGMENT_RELAY
     };
 
     enum Type
@@ -50,7 +58,7 @@ public:
         T_MAX                = 255
     };
 
-    class NodeList : public Map<UUID, Node> { };
+    class NodeList : public Map<UUID, Node, FlatMap<UUID, Node> > { };
 
 private:
 
@@ -60,6 +68,7 @@ private:
     gu::byte_t        segment_id_;
     gcomm::UUID       handshake_uuid_;
     gcomm::UUID       source_uuid_;
+    gcomm::UUID       relay_uuid_;
     gcomm::String<64> node_address_or_error_;
     gcomm::String<32> group_name_;
 
@@ -97,6 +106,7 @@ public:
         segment_id_            (msg.segment_id_),
         handshake_uuid_        (msg.handshake_uuid_),
         source_uuid_           (msg.source_uuid_),
+        relay_uuid_            (msg.relay_uuid_),
         node_address_or_error_ (msg.node_address_or_error_),
         group_name_            (msg.group_name_),
         node_list_             (msg.node_list_)
@@ -111,6 +121,7 @@ public:
         segment_id_            (0),
         handshake_uuid_        (),
         source_uuid_           (),
+        relay_uuid_            (),
         node_address_or_error_ (),
         group_name_            (),
         node_list_             ()
@@ -129,6 +140,7 @@ public:
         segment_id_            (segment_id),
         handshake_uuid_        (handshake_uuid),
         source_uuid_           (source_uuid),
+        relay_uuid_            (),
         node_address_or_error_ (),
         group_name_            (),
         node_list_             ()
@@ -151,6 +163,7 @@ public:
         segment_id_            (segment_id),
         handshake_uuid_        (),
         source_uuid_           (source_uuid),
+        relay_uuid_            (),
         node_address_or_error_ (error),
         group_name_            (),
         node_list_             ()
@@ -174,6 +187,7 @@ public:
         segment_id_            (segment_id),
         handshake_uuid_        (),
         source_uuid_           (source_uuid),
+        relay_uuid_            (),
         node_address_or_error_ (),
         group_name_            (),
         node_list_             ()
@@ -199,6 +213,7 @@ public:
         segment_id_            (segment_id),
         handshake_uuid_        (handshake_uuid),
         source_uuid_           (source_uuid),
+        relay_uuid_            (),
         node_address_or_error_ (node_address),
         group_name_            (group_name),
         node_list_             ()
@@ -221,6 +236,7 @@ public:
         segment_id_            (0),
         handshake_uuid_        (),
         source_uuid_           (source_uuid),
+        relay_uuid_            (),
         node_address_or_error_ (),
         group_name_            (group_name),
         node_list_             (nodes)
@@ -249,6 +265,11 @@ public:
             gu_trace(off = handshake_uuid_.serialize(buf, buflen, off));
         }
 
+        if (flags_ & F_TREE_RELAY)
+        {
+            gu_trace(off = relay_uuid_.serialize(buf, buflen, off));
+        }
+
         if (flags_ & F_NODE_ADDRESS_OR_ERROR)
         {
             gu_trace (off = node_address_or_error_.serialize(buf, buflen, off));
@@ -296,6 +317,11 @@ public:
             gu_trace(off = handshake_uuid_.unserialize(buf, buflen, off));
         }
 
+        if (flags_ & F_TREE_RELAY)
+        {
+            gu_trace(off = relay_uuid_.unserialize(buf, buflen, off));
+        }
+
         if (flags_ & F_NODE_ADDRESS_OR_ERROR)
         {
             gu_trace (off = node_address_or_error_.unserialize(buf, buflen, off));
@@ -333,6 +359,8 @@ public:
         return 4 /* Common header: version, type, flags, segment_id */
             + source_uuid_.serial_size()
             + (flags_ & F_HANDSHAKE_UUID ? handshake_uuid_.serial_size() : 0)
+            /* Relay tree root if set */
+            + (flags_ & F_TREE_RELAY ? relay_uuid_.serial_size() : 0)
             /* GMCast address if set */
             + (flags_ & F_NODE_ADDRESS_OR_ERROR ?
                node_address_or_error_.serial_size() : 0)
@@ -354,6 +382,9 @@ public:
 
     const UUID&     source_uuid()  const { return source_uuid_;  }
 
+    void set_relay_uuid(const UUID& uuid) { relay_uuid_ = uuid; }
+    const UUID&     relay_uuid()   const { return relay_uuid_;   }
+
     const std::string&   node_address() const { return node_address_or_error_.to_string(); }
     const std::string&   error() const { return node_address_or_error_.to_string(); }
 
@@ -68,9 +68,7 @@ void gcomm::gmcast::Proto:: set_state(State new_state)
 
 void gcomm::gmcast::Proto::send_msg(const Message& msg)
 {
-    gu::Buffer buf;
-    gu_trace(serialize(msg, buf));
-    Datagram dg(buf);
+    Datagram dg(serialize_datagram(msg));
     int ret = tp_->send(dg);
 
     // @todo: This can happen during congestion, figure out how to
@@ -122,6 +120,10 @@ void gcomm::gmcast::Proto::handle_handshake(const Message& hs)
                  local_addr_,
                  group_name_,
                  local_segment_);
+    if (deflate_wanted())
+    {
+        hsr.set_flags(hsr.flags() | Message::F_DEFLATE);
+    }
     send_msg(hsr);
 
     set_state(S_HANDSHAKE_RESPONSE_SENT);
@@ -167,9 +169,16 @@ void gcomm::gmcast::Proto::handle_handshake_response(const Message& hs)
             }
 
             propagate_remote_ = true;
+            bool const deflate(deflate_wanted() &&
+                               (hs.flags() & Message::F_DEFLATE));
             Message ok(version_, Message::T_OK, gmcast_.uuid(),
                        local_segment_, "");
+            if (deflate)
+            {
+                ok.set_flags(ok.flags() | Message::F_DEFLATE);
+            }
             send_msg(ok);
+            if (deflate) enable_deflate();
             set_state(S_OK);
         }
         catch (std::exception& e)
@@ -190,10 +199,33 @@ void gcomm::gmcast::Proto::handle_ok(const Message& hs)
     {
         log_debug << "handshake ok: " << *this;
     }
+    if (deflate_wanted() && (hs.flags() & Message::F_DEFLATE))
+    {
+        enable_deflate();
+    }
     propagate_remote_ = true;
     set_state(S_OK);
 }
 
+bool gcomm::gmcast::Proto::deflate_wanted() const
+{
+    return (gmcast_.segment_compress() > 0 &&
+            remote_segment_ != local_segment_);
+}
+
+// Called when the peer has announced that it accepts compressed datagrams,
+// which it does only if it compresses the other direction as well.
+void gcomm::gmcast::Proto::enable_deflate()
+{
+    log_info << "compressing datagrams to " << remote_uuid_
+             << " in segment " << static_cast<int>(remote_segment_);
+
+    tp_->set_option(Socket::OptDeflateThreshold,
+                    gu::to_string(gmcast_.segment_compress_threshold()));
+    tp_->set_option(Socket::OptDeflate,
+                    gu::to_string(gmcast_.segment_compress()));
+}
+
 void gcomm::gmcast::Proto::handle_failed(const Message& hs)
 {
     log_warn << "handshake with " << remote_uuid_ << " "
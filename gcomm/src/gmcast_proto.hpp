@@ -132,6 +132,10 @@ private:
     Proto(const Proto&);
     void operator=(const Proto&);
 
+    // true if datagrams to remote segment should be compressed
+    bool deflate_wanted() const;
+    void enable_deflate();
+
     int version_;
     gcomm::UUID       handshake_uuid_;
     gcomm::UUID       remote_uuid_;
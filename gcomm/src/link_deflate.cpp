@@ -0,0 +1,138 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+#include "link_deflate.hpp"
+
+#include "gu_serialize.hpp"
+#include "gu_throw.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+static size_t const LINK_DEFLATE_LEN_SIZE = 4;  // original length
+static size_t const LINK_DEFLATE_FLUSH    = 16; // sync flush marker margin
+
+gcomm::LinkDeflate::LinkDeflate(int const level)
+    :
+    strm_()
+{
+    memset(&strm_, 0, sizeof(strm_));
+
+    if (Z_OK != deflateInit(&strm_, level))
+    {
+        gu_throw_error(ENOMEM) << "deflateInit() failed, level " << level;
+    }
+}
+
+gcomm::LinkDeflate::~LinkDeflate()
+{
+    deflateEnd(&strm_);
+}
+
+size_t
+gcomm::LinkDeflate::bound(size_t const len)
+{
+    return (LINK_DEFLATE_LEN_SIZE + deflateBound(&strm_, len) +
+            LINK_DEFLATE_FLUSH);
+}
+
+void
+gcomm::LinkDeflate::feed(const gu::byte_t* const data, size_t const len,
+                         int const flush, gu::Buffer& buf, size_t& offset)
+{
+    strm_.next_in  = const_cast<Bytef*>(data);
+    strm_.avail_in = len;
+
+    do
+    {
+        if (buf.size() - offset < LINK_DEFLATE_FLUSH)
+        {
+            buf.resize(buf.size() + std::max(len, size_t(1024)));
+        }
+
+        strm_.next_out  = &buf[0] + offset;
+        strm_.avail_out = buf.size() - offset;
+
+        int const err(::deflate(&strm_, flush));
+        if (Z_OK != err && Z_BUF_ERROR != err)
+        {
+            gu_throw_error(EPROTO) << "deflate() failed: " << err;
+        }
+
+        offset = buf.size() - strm_.avail_out;
+    }
+    while (strm_.avail_in > 0 || strm_.avail_out == 0);
+}
+
+void
+gcomm::LinkDeflate::compress(const Datagram& dg, gu::Buffer& buf)
+{
+    buf.resize(bound(dg.len()));
+
+    size_t offset(gu::serialize4(static_cast<uint32_t>(dg.len()),
+                                 &buf[0], buf.size(), 0));
+
+    feed(dg.header() + dg.header_offset(), dg.header_len(), Z_NO_FLUSH,
+         buf, offset);
+
+    const gu::Buffer& payload(dg.payload());
+    feed(payload.empty() ? 0 : &payload[0], payload.size(), Z_SYNC_FLUSH,
+         buf, offset);
+
+    buf.resize(offset);
+}
+
+gcomm::LinkInflate::LinkInflate()
+    :
+    strm_(),
+    init_(false)
+{
+    memset(&strm_, 0, sizeof(strm_));
+}
+
+gcomm::LinkInflate::~LinkInflate()
+{
+    if (init_) inflateEnd(&strm_);
+}
+
+void
+gcomm::LinkInflate::decompress(const gu::byte_t* const begin,
+                               const gu::byte_t* const end,
+                               gu::Buffer&             buf)
+{
+    if (!init_)
+    {
+        if (Z_OK != inflateInit(&strm_))
+        {
+            gu_throw_error(ENOMEM) << "inflateInit() failed";
+        }
+        init_ = true;
+    }
+
+    uint32_t len;
+    size_t const offset(gu::unserialize4(begin, end - begin, 0, len));
+
+    // one byte extra to tell a longer message from the one which
+    // fills the buffer exactly
+    buf.resize(len + 1);
+
+    strm_.next_in   = const_cast<Bytef*>(begin + offset);
+    strm_.avail_in  = (end - begin) - offset;
+    strm_.next_out  = &buf[0];
+    strm_.avail_out = buf.size();
+
+    int const err(inflate(&strm_, Z_SYNC_FLUSH));
+    if (Z_OK != err && Z_BUF_ERROR != err)
+    {
+        gu_throw_error(EPROTO) << "inflate() failed: " << err;
+    }
+
+    if (strm_.avail_in != 0 || buf.size() - strm_.avail_out != len)
+    {
+        gu_throw_error(EPROTO) << "compressed datagram of " << len
+                               << " bytes is corrupted";
+    }
+
+    buf.resize(len);
+}
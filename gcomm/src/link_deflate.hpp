@@ -0,0 +1,78 @@
+//
+// Copyright (C) 2017 Codership Oy <info@codership.com>
+//
+
+//!
+// @file link_deflate.hpp Streaming compression of datagrams sent over
+//       a single connection.
+//
+// Every compressed datagram is flushed with Z_SYNC_FLUSH, so it can be
+// decompressed as soon as it arrives, while the dictionary carries over
+// from one datagram to the next. Therefore the receiver must inflate all
+// compressed datagrams of the connection in the order they were sent,
+// datagrams sent uncompressed do not go through the stream.
+//
+// Compressed payload is the original length (4 bytes) followed by
+// deflate output.
+//
+
+#ifndef GCOMM_LINK_DEFLATE_HPP
+#define GCOMM_LINK_DEFLATE_HPP
+
+#include "gcomm/datagram.hpp"
+
+#include <zlib.h>
+
+namespace gcomm
+{
+    class LinkDeflate;
+    class LinkInflate;
+}
+
+class gcomm::LinkDeflate
+{
+public:
+
+    //! @throws gu::Exception if the stream could not be initialized
+    explicit LinkDeflate(int level);
+    ~LinkDeflate();
+
+    //! Largest compressed payload size for input of len bytes
+    size_t bound(size_t len);
+
+    //! Replaces buf contents with compressed header and payload of dg
+    void compress(const Datagram& dg, gu::Buffer& buf);
+
+private:
+
+    LinkDeflate(const LinkDeflate&);
+    void operator=(const LinkDeflate&);
+
+    void feed(const gu::byte_t* data, size_t len, int flush,
+              gu::Buffer& buf, size_t& offset);
+
+    z_stream strm_;
+};
+
+class gcomm::LinkInflate
+{
+public:
+
+    LinkInflate();
+    ~LinkInflate();
+
+    //! Replaces buf contents with decompressed data of [begin, end)
+    //! @throws gu::Exception with EPROTO if the data is corrupted
+    void decompress(const gu::byte_t* begin, const gu::byte_t* end,
+                    gu::Buffer& buf);
+
+private:
+
+    LinkInflate(const LinkInflate&);
+    void operator=(const LinkInflate&);
+
+    z_stream strm_;
+    bool     init_; // stream is initialized on first use
+};
+
+#endif // GCOMM_LINK_DEFLATE_HPP
@@ -34,6 +34,21 @@ void gcomm::PC::handle_up(const void* cid, const Datagram& rb,
 }
 
 
+void gcomm::PC::handle_up_batch(const void* cid, const ProtoUpBatch& batch)
+{
+    for (size_t i(0); i < batch.size(); ++i)
+    {
+        if (batch.um(i).has_view() == true)
+        {
+            // views may need to be saved, go one by one
+            Protolay::handle_up_batch(cid, batch);
+            return;
+        }
+    }
+    send_up_batch(batch);
+}
+
+
 int gcomm::PC::handle_down(Datagram& wb, const ProtoDownMeta& dm)
 {
     if (wb.len() == 0)
@@ -33,6 +33,7 @@ namespace gcomm
         void close(bool force = false);
 
         void handle_up(const void*, const Datagram&, const ProtoUpMeta&);
+        void handle_up_batch(const void*, const ProtoUpBatch&);
         int  handle_down(Datagram&, const ProtoDownMeta&);
 
         const UUID& uuid() const;
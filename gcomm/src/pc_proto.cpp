@@ -145,9 +145,7 @@ void gcomm::pc::Proto::send_state()
     log_debug << self_id() << " local to seq " << to_seq();
     log_debug << self_id() << " sending state: " << pcs;
 
-    gu::Buffer buf;
-    serialize(pcs, buf);
-    Datagram dg(buf);
+    Datagram dg(serialize_datagram(pcs));
 
     if (send_down(dg, ProtoDownMeta()))
     {
@@ -195,9 +193,7 @@ void gcomm::pc::Proto::send_install(bool bootstrap, int weight)
         log_debug << self_id() << " sending install: " << pci;
     }
 
-    gu::Buffer buf;
-    serialize(pci, buf);
-    Datagram dg(buf);
+    Datagram dg(serialize_datagram(pci));
     int ret = send_down(dg, ProtoDownMeta());
     if (ret != 0)
     {
@@ -227,6 +223,8 @@ void gcomm::pc::Proto::deliver_view(bool bootstrap)
 
     ProtoUpMeta um(UUID::nil(), ViewId(), &v);
     log_info << v;
+    // user messages collected so far must be delivered in the old view
+    deliver_up_batch();
     send_up(Datagram(), um);
     set_stable_view(v);
 
@@ -421,91 +419,80 @@ void gcomm::pc::Proto::handle_first_trans(const View& view)
     shift_to(S_TRANS);
 }
 
-// Compute weighted sum of members in node list. If member cannot be found
-// from node_map its weight is assumed to be zero.
+// Weighted sum of members in node list. If member cannot be found from
+// node_map its weight is assumed to be zero. Weight -1 means that member
+// has not announced its weight, in that case weighted is cleared to fall
+// back to backwards compatibility mode during upgrade (all weights are
+// assumed to be one). Both are computed in one pass over the list.
 static size_t weighted_sum(const gcomm::NodeList& node_list,
-                           const gcomm::pc::NodeMap& node_map)
+                           const gcomm::pc::NodeMap& node_map,
+                           bool& weighted)
 {
     size_t sum(0);
     for (gcomm::NodeList::const_iterator i(node_list.begin());
          i != node_list.end(); ++i)
     {
-        int weight(0);
         gcomm::pc::NodeMap::const_iterator node_i(
             node_map.find(gcomm::NodeList::key(i)));
         if (node_i != node_map.end())
         {
             const gcomm::pc::Node& node(gcomm::pc::NodeMap::value(node_i));
-            gcomm_assert(node.weight() >= 0 &&
+            gcomm_assert(node.weight() >= -1 &&
                          node.weight() <= 0xff);
-            weight = node.weight();
-        }
-        else
-        {
-            weight = 0;
+            if (node.weight() == -1)
+            {
+                weighted = false;
+            }
+            else
+            {
+                sum += node.weight();
+            }
         }
-        sum += weight;
     }
     return sum;
 }
 
-// Check if all members in node_list have weight associated. This is needed
-// to fall back to backwards compatibility mode during upgrade (all weights are
-// assumed to be one). See have_quorum() and have_split_brain() below.
-static bool have_weights(const gcomm::NodeList& node_list,
-                         const gcomm::pc::NodeMap& node_map)
+namespace
 {
-    for (gcomm::NodeList::const_iterator i(node_list.begin());
-         i != node_list.end(); ++i)
-    {
-        gcomm::pc::NodeMap::const_iterator node_i(
-            node_map.find(gcomm::NodeList::key(i)));
-        if (node_i != node_map.end())
+    // Members*2 + left compared to previous primary component members,
+    // weighted if weights of all nodes are known. See have_quorum() and
+    // have_split_brain() below.
+    struct QuorumSums
+    {
+        QuorumSums(const gcomm::View&        view,
+                   const gcomm::View&        pc_view,
+                   const gcomm::pc::NodeMap& node_map)
+            :
+            weighted(true),
+            view_sum(weighted_sum(view.members(), node_map, weighted) * 2
+                     + weighted_sum(view.left(), node_map, weighted)),
+            pc_sum  (weighted_sum(pc_view.members(), node_map, weighted))
         {
-            const gcomm::pc::Node& node(gcomm::pc::NodeMap::value(node_i));
-            if (node.weight() == -1)
+            if (weighted == false)
             {
-                return false;
+                view_sum = view.members().size()*2 + view.left().size();
+                pc_sum   = pc_view.members().size();
             }
         }
-    }
-    return true;
+
+        bool   weighted;
+        size_t view_sum;
+        size_t pc_sum;
+    };
 }
 
 
 bool gcomm::pc::Proto::have_quorum(const View& view, const View& pc_view) const
 {
-    if (have_weights(view.members(), instances_) &&
-        have_weights(view.left(), instances_)    &&
-        have_weights(pc_view.members(), instances_))
-    {
-        return (weighted_sum(view.members(), instances_) * 2
-                + weighted_sum(view.left(), instances_) >
-                weighted_sum(pc_view.members(), instances_));
-    }
-    else
-    {
-        return (view.members().size()*2 + view.left().size() >
-                pc_view.members().size());
-    }
+    QuorumSums const sums(view, pc_view, instances_);
+    return (sums.view_sum > sums.pc_sum);
 }
 
 
 bool gcomm::pc::Proto::have_split_brain(const View& view) const
 {
-    if (have_weights(view.members(), instances_)  &&
-        have_weights(view.left(), instances_)     &&
-        have_weights(pc_view_.members(), instances_))
-    {
-        return (weighted_sum(view.members(), instances_) * 2
-                + weighted_sum(view.left(), instances_) ==
-                weighted_sum(pc_view_.members(), instances_));
-    }
-    else
-    {
-        return (view.members().size()*2 + view.left().size() ==
-                pc_view_.members().size());
-    }
+    QuorumSums const sums(view, pc_view_, instances_);
+    return (sums.view_sum == sums.pc_sum);
 }
 
 
@@ -1402,13 +1389,30 @@ void gcomm::pc::Proto::handle_user(const Message& msg, const Datagram& dg,
     }
 
     Datagram up_dg(dg, dg.offset() + msg.serial_size());
-    gu_trace(send_up(up_dg,
-                     ProtoUpMeta(um.source(),
-                                 pc_view_.id(),
-                                 0,
-                                 um.user_type(),
-                                 um.order(),
-                                 curr_to_seq)));
+    ProtoUpMeta const up_um(um.source(),
+                            pc_view_.id(),
+                            0,
+                            um.user_type(),
+                            um.order(),
+                            curr_to_seq);
+    if (batching_ == true)
+    {
+        up_batch_.push_back(up_dg, up_um);
+    }
+    else
+    {
+        gu_trace(send_up(up_dg, up_um));
+    }
+}
+
+
+void gcomm::pc::Proto::deliver_up_batch()
+{
+    if (up_batch_.empty() == false)
+    {
+        gu_trace(send_up_batch(up_batch_));
+        up_batch_.clear();
+    }
 }
 
 
@@ -1536,6 +1540,29 @@ void gcomm::pc::Proto::handle_up(const void* cid,
 }
 
 
+void gcomm::pc::Proto::handle_up_batch(const void* cid,
+                                       const ProtoUpBatch& batch)
+{
+    gcomm_assert(batching_ == false);
+    batching_ = true;
+    try
+    {
+        for (size_t i(0); i < batch.size(); ++i)
+        {
+            handle_up(cid, batch.dg(i), batch.um(i));
+        }
+    }
+    catch (...)
+    {
+        batching_ = false;
+        up_batch_.clear();
+        throw;
+    }
+    batching_ = false;
+    deliver_up_batch();
+}
+
+
 int gcomm::pc::Proto::handle_down(Datagram& dg, const ProtoDownMeta& dm)
 {
     switch (state())
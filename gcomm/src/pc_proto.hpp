@@ -91,7 +91,9 @@ public:
                                     param<int>(conf, uri, Conf::PcWeight,
                                                Defaults::PcWeight),
                                     0, 0xff)),
-        rst_view_      ()
+        rst_view_      (),
+        batching_      (false),
+        up_batch_      ()
     {
         set_weight(weight_);
         NodeMap::value(self_i_).set_segment(segment);
@@ -162,6 +164,7 @@ public:
                       const ProtoUpMeta&);
     void handle_up   (const void*, const Datagram&,
                       const ProtoUpMeta&);
+    void handle_up_batch(const void*, const ProtoUpBatch&);
     int  handle_down (Datagram&, const ProtoDownMeta&);
 
     void connect(bool first)
@@ -208,6 +211,7 @@ private:
     void handle_user(const Message&, const Datagram&,
                      const ProtoUpMeta&);
     void deliver_view(bool bootstrap = false);
+    void deliver_up_batch();
 
     UUID   const      my_uuid_;       // Node uuid
     bool              start_prim_;    // Is allowed to start in prim comp
@@ -228,6 +232,8 @@ private:
     size_t            mtu_;           // Maximum transmission unit
     int               weight_;        // Node weight in voting
     View*             rst_view_;      // restored PC view
+    bool              batching_;      // Collecting user msgs in up_batch_
+    ProtoUpBatch      up_batch_;      // User msgs to deliver as a batch
 };
 
 
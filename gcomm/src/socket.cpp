@@ -11,3 +11,6 @@ const std::string gcomm::Socket::OptIfAddr      = SocketOptPrefix + "if_addr";
 const std::string gcomm::Socket::OptIfLoop      = SocketOptPrefix + "if_loop";
 const std::string gcomm::Socket::OptCRC32       = SocketOptPrefix + "crc32";
 const std::string gcomm::Socket::OptMcastTTL    = SocketOptPrefix + "mcast_ttl";
+const std::string gcomm::Socket::OptDeflate     = SocketOptPrefix + "deflate";
+const std::string gcomm::Socket::OptDeflateThreshold =
+    SocketOptPrefix + "deflate_threshold";
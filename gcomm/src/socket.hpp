@@ -46,6 +46,11 @@ public:
     static const std::string OptIfLoop;      /*! socket.if_loop      */
     static const std::string OptCRC32;       /*! socket.crc32        */
     static const std::string OptMcastTTL;    /*! socket.mcast_ttl    */
+    /*! socket.deflate: compression level for datagrams sent over the socket,
+     *  may be set only if the peer has agreed to receive them */
+    static const std::string OptDeflate;
+    /*! socket.deflate_threshold: smallest datagram to compress */
+    static const std::string OptDeflateThreshold;
 
     Socket(const gu::URI& uri)
         :
@@ -61,6 +66,29 @@ public:
     virtual void async_receive() = 0;
 
     virtual size_t mtu() const = 0;
+    //! Path MSS and smoothed RTT (microseconds) as seen by the kernel,
+    //! zero if not known
+    virtual size_t    mss() const = 0;
+    virtual long long rtt() const = 0;
+    //! True after queued send data has exceeded the high watermark
+    //! and until it drains down to the low watermark
+    virtual bool congested() const = 0;
+
+    //! Link statistics, fields which are not known are zero
+    struct Stats
+    {
+        Stats()
+            : rtt(0), rtt_var(0), retrans(0),
+              bytes_sent(0), bytes_received(0), send_q_bytes(0)
+        { }
+        long long rtt;            //!< smoothed RTT, microseconds
+        long long rtt_var;        //!< RTT mean deviation, microseconds
+        long long retrans;        //!< segments retransmitted by the kernel
+        long long bytes_sent;     //!< bytes written to the link
+        long long bytes_received; //!< bytes of complete received messages
+        size_t    send_q_bytes;   //!< bytes queued for sending
+    };
+    virtual Stats stats() const = 0;
     virtual std::string local_addr() const = 0;
     virtual std::string remote_addr() const = 0;
     virtual State state() const = 0;
@@ -404,6 +404,84 @@ START_TEST(test_input_map_random_insert)
 }
 END_TEST
 
+START_TEST(test_input_map_iterators)
+{
+    log_info << "START";
+    InputMap im;
+    UUID uuid1(1), uuid2(2);
+    ViewId view(V_REG, uuid1, 1);
+
+    im.reset(2);
+    im.insert(0, UserMessage(0, uuid1, view, 0));
+    im.insert(1, UserMessage(0, uuid2, view, 0));
+
+    InputMap::iterator i(im.find(1, 0));
+    InputMap::iterator i_next(i);
+    ++i_next;
+    fail_unless(i_next == im.end());
+
+    // appending messages must not turn end iterator into a valid one
+    im.insert(0, UserMessage(0, uuid1, view, 1));
+    fail_unless(i_next == im.end());
+
+    // erasing other messages must not invalidate iterator
+    im.erase(im.find(0, 0));
+    fail_unless(InputMapMsgIndex::value(i).msg().source() == uuid2);
+    fail_unless(InputMapMsgIndex::value(i).msg().seq() == 0);
+
+    // iteration goes by seq first, then by node index
+    im.insert(1, UserMessage(0, uuid2, view, 1));
+    i_next = i;
+    ++i_next;
+    fail_unless(InputMapMsgIndex::value(i_next).msg().source() == uuid1);
+    ++i_next;
+    fail_unless(InputMapMsgIndex::value(i_next).msg().source() == uuid2);
+    fail_unless(InputMapMsgIndex::value(i_next).msg().seq() == 1);
+    ++i_next;
+    fail_unless(i_next == im.end());
+    fail_unless(im.begin() == i);
+}
+END_TEST
+
+
+START_TEST(test_timer_list)
+{
+    log_info << "START";
+    Proto::TimerList tl;
+    fail_unless(tl.empty() == true);
+
+    const Date now(Date::now());
+    tl.set(Proto::T_STATS, now + Sec);
+    tl.set(Proto::T_RETRANS, now + MSec);
+    tl.set(Proto::T_INACTIVITY, now + 10*MSec);
+    fail_unless(tl.empty() == false);
+    fail_unless(tl.next() == Proto::T_RETRANS);
+    fail_unless(tl.is_set(Proto::T_INSTALL) == false);
+
+    // moving the earliest timer later must select the new earliest one
+    tl.set(Proto::T_RETRANS, now + 2*Sec);
+    fail_unless(tl.next() == Proto::T_INACTIVITY);
+    fail_unless(tl.expiry(Proto::T_INACTIVITY) == now + 10*MSec);
+
+    tl.cancel(Proto::T_INACTIVITY);
+    fail_unless(tl.next() == Proto::T_STATS);
+
+    // setting to Date::max() is the same as canceling
+    tl.set(Proto::T_INSTALL, Date::max());
+    fail_unless(tl.is_set(Proto::T_INSTALL) == false);
+    fail_unless(tl.next() == Proto::T_STATS);
+
+    tl.cancel(Proto::T_STATS);
+    tl.cancel(Proto::T_RETRANS);
+    fail_unless(tl.empty() == true);
+
+    tl.set(Proto::T_INSTALL, now);
+    fail_unless(tl.next() == Proto::T_INSTALL);
+    tl.clear();
+    fail_unless(tl.empty() == true);
+}
+END_TEST
+
 
 
 
@@ -1415,6 +1493,157 @@ START_TEST(test_aggreg)
 }
 END_TEST
 
+START_TEST(test_aggreg_hold)
+{
+    log_info << "START (aggreg_hold)";
+    const size_t n_nodes(3);
+    PropagationMatrix prop;
+    vector<DummyNode*> dn;
+    const string suspect_timeout("PT0.31S");
+    const string inactive_timeout("PT0.31S");
+    const string retrans_period("PT0.1S");
+
+    for (size_t i = 1; i <= n_nodes; ++i)
+    {
+        gu_trace(dn.push_back(
+                     create_dummy_node(i, 0, suspect_timeout,
+                                       inactive_timeout, retrans_period)));
+    }
+
+    for (size_t i = 0; i < n_nodes; ++i)
+    {
+        gu_trace(join_node(&prop, dn[i], i == 0 ? true : false));
+        set_cvi(dn, 0, i, i + 1);
+        gu_trace(prop.propagate_until_cvi(false));
+    }
+
+    for (size_t i = 0; i < n_nodes; ++i)
+    {
+        fail_unless(evs_from_dummy(dn[i])->set_param("evs.aggregate_hold",
+                                                      "true") == true);
+    }
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        gu_trace(send_n(dn[i % n_nodes], 4));
+        gu_trace(prop.propagate_n(2));
+    }
+
+    gu_trace(prop.propagate_until_empty());
+    gu_trace(check_trace(dn));
+
+    for_each(dn.begin(), dn.end(), DeleteObject());
+}
+END_TEST
+
+// Congested transport holds user messages while own messages are in
+// flight, but lets them through one at a time as previous ones complete.
+START_TEST(test_congestion)
+{
+    log_info << "START (congestion)";
+    const size_t n_nodes(2);
+    PropagationMatrix prop;
+    vector<DummyNode*> dn;
+
+    for (size_t i = 1; i <= n_nodes; ++i)
+    {
+        gu_trace(dn.push_back(create_dummy_node(i, 0)));
+    }
+
+    for (size_t i = 0; i < n_nodes; ++i)
+    {
+        gu_trace(join_node(&prop, dn[i], i == 0 ? true : false));
+        set_cvi(dn, 0, i, i + 1);
+        gu_trace(prop.propagate_until_cvi(false));
+    }
+
+    DummyTransport* tp(static_cast<DummyTransport*>(dn[0]->protos().front()));
+    tp->set_congested(true);
+    fail_unless(evs_from_dummy(dn[0])->is_congested() == true);
+
+    // two messages fit in the default user send window
+    gu_trace(send_n(dn[0], 2));
+    fail_if(evs_from_dummy(dn[0])->is_output_empty() == true);
+
+    gu_trace(prop.propagate_until_empty());
+    fail_unless(evs_from_dummy(dn[0])->is_output_empty() == true);
+
+    tp->set_congested(false);
+    gu_trace(send_n(dn[0], 4));
+    gu_trace(prop.propagate_until_empty());
+    fail_unless(evs_from_dummy(dn[0])->is_output_empty() == true);
+    gu_trace(check_trace(dn));
+
+    for_each(dn.begin(), dn.end(), DeleteObject());
+}
+END_TEST
+
+START_TEST(test_ack_batch)
+{
+    log_info << "START (ack_batch)";
+    const size_t n_nodes(3);
+    PropagationMatrix prop;
+    vector<DummyNode*> dn;
+    const string suspect_timeout("PT0.31S");
+    const string inactive_timeout("PT0.31S");
+    const string retrans_period("PT0.1S");
+
+    for (size_t i = 1; i <= n_nodes; ++i)
+    {
+        gu_trace(dn.push_back(
+                     create_dummy_node(i, 0, suspect_timeout,
+                                       inactive_timeout, retrans_period)));
+    }
+
+    for (size_t i = 0; i < n_nodes; ++i)
+    {
+        gu_trace(join_node(&prop, dn[i], i == 0 ? true : false));
+        set_cvi(dn, 0, i, i + 1);
+        gu_trace(prop.propagate_until_cvi(false));
+    }
+
+    vector<size_t> delivered;
+    for (size_t i = 0; i < n_nodes; ++i)
+    {
+        fail_unless(evs_from_dummy(dn[i])->set_param("evs.ack_batch",
+                                                      "8") == true);
+        fail_unless(evs_from_dummy(dn[i])->set_param("evs.ack_delay",
+                                                      "PT0.02S") == true);
+        delivered.push_back(dn[i]->trace().current_view_trace().msgs().size());
+    }
+
+    // less messages than ack batch, pending acknowledgements are
+    // sent by ack timer
+    gu_trace(send_n(dn[0], 4));
+    gu_trace(prop.propagate_until_empty());
+    for (size_t i = 0; i < 3; ++i)
+    {
+        usleep(30000);
+        gu_trace(prop.expire_timers());
+        gu_trace(prop.propagate_until_empty());
+    }
+
+    for (size_t i = 0; i < n_nodes; ++i)
+    {
+        fail_unless(dn[i]->trace().current_view_trace().msgs().size() ==
+                    delivered[i] + 4);
+    }
+
+    for (size_t i = 0; i < 16; ++i)
+    {
+        gu_trace(send_n(dn[i % n_nodes], 4));
+        gu_trace(prop.propagate_n(2));
+    }
+    gu_trace(prop.propagate_until_empty());
+    usleep(30000);
+    gu_trace(prop.expire_timers());
+    gu_trace(prop.propagate_until_empty());
+    gu_trace(check_trace(dn));
+
+    for_each(dn.begin(), dn.end(), DeleteObject());
+}
+END_TEST
+
 START_TEST(test_trac_538)
 {
     gu_conf_self_tstamp_on();
@@ -2116,6 +2345,14 @@ Suite* evs2_suite()
         tcase_add_test(tc, test_input_map_random_insert);
         suite_add_tcase(s, tc);
 
+        tc = tcase_create("test_input_map_iterators");
+        tcase_add_test(tc, test_input_map_iterators);
+        suite_add_tcase(s, tc);
+
+        tc = tcase_create("test_timer_list");
+        tcase_add_test(tc, test_timer_list);
+        suite_add_tcase(s, tc);
+
 
         tc = tcase_create("test_proto_single_join");
         tcase_add_test(tc, test_proto_single_join);
@@ -2198,6 +2435,18 @@ Suite* evs2_suite()
             tc = tcase_create("test_aggreg");
             tcase_add_test(tc, test_aggreg);
             suite_add_tcase(s, tc);
+
+            tc = tcase_create("test_aggreg_hold");
+            tcase_add_test(tc, test_aggreg_hold);
+            suite_add_tcase(s, tc);
+
+            tc = tcase_create("test_ack_batch");
+            tcase_add_test(tc, test_ack_batch);
+            suite_add_tcase(s, tc);
+
+            tc = tcase_create("test_congestion");
+            tcase_add_test(tc, test_congestion);
+            suite_add_tcase(s, tc);
         }
 
         if (run_all_evs_tests() == true)
@@ -65,119 +65,141 @@ START_TEST(test_gmcast_multicast)
 END_TEST
 
 
-START_TEST(test_gmcast_w_user_messages)
+namespace
+{
+class User : public Toplay
 {
-    class User : public Toplay
+    Transport* tp_;
+    size_t recvd_;
+    Protostack pstack_;
+    explicit User(const User&);
+    void operator=(User&);
+
+public:
+
+    User(Protonet& pnet,
+         const std::string& listen_addr,
+         const std::string& remote_addr,
+         const std::string& opts = "") :
+        Toplay(pnet.conf()),
+        tp_(0),
+        recvd_(0),
+        pstack_()
     {
-        Transport* tp_;
-        size_t recvd_;
-        Protostack pstack_;
-        explicit User(const User&);
-        void operator=(User&);
-
-    public:
-
-        User(Protonet& pnet,
-             const std::string& listen_addr,
-             const std::string& remote_addr) :
-            Toplay(pnet.conf()),
-            tp_(0),
-            recvd_(0),
-            pstack_()
+        string uri("gmcast://");
+        uri += remote_addr; // != 0 ? remote_addr : "";
+        uri += "?";
+        uri += "tcp.non_blocking=1";
+        uri += "&";
+        uri += "gmcast.group=testgrp";
+        uri += "&gmcast.time_wait=PT0.5S";
+        if (test_multicast == true)
         {
-            string uri("gmcast://");
-            uri += remote_addr; // != 0 ? remote_addr : "";
-            uri += "?";
-            uri += "tcp.non_blocking=1";
-            uri += "&";
-            uri += "gmcast.group=testgrp";
-            uri += "&gmcast.time_wait=PT0.5S";
-            if (test_multicast == true)
-            {
-                uri += "&" + mcast_param;
-            }
-            uri += "&gmcast.listen_addr=tcp://";
-            uri += listen_addr;
-
-            tp_ = Transport::create(pnet, uri);
+            uri += "&" + mcast_param;
         }
+        uri += "&gmcast.listen_addr=tcp://";
+        uri += listen_addr;
+        uri += opts;
+
+        tp_ = Transport::create(pnet, uri);
+    }
 
-        ~User()
+    ~User()
+    {
+        delete tp_;
+    }
+
+    void start(const std::string& peer = "")
+    {
+        if (peer == "")
         {
-            delete tp_;
+            tp_->connect();
         }
-
-        void start(const std::string& peer = "")
+        else
         {
-            if (peer == "")
-            {
-                tp_->connect();
-            }
-            else
-            {
-                tp_->connect(peer);
-            }
-            pstack_.push_proto(tp_);
-            pstack_.push_proto(this);
+            tp_->connect(peer);
         }
+        pstack_.push_proto(tp_);
+        pstack_.push_proto(this);
+    }
 
 
-        void stop()
-        {
-            pstack_.pop_proto(this);
-            pstack_.pop_proto(tp_);
-            tp_->close();
-        }
+    void stop()
+    {
+        pstack_.pop_proto(this);
+        pstack_.pop_proto(tp_);
+        tp_->close();
+    }
 
-        void handle_timer()
-        {
-            byte_t buf[16];
-            memset(buf, 0xa5, sizeof(buf));
+    void handle_timer()
+    {
+        byte_t buf[16];
+        memset(buf, 0xa5, sizeof(buf));
 
-            Datagram dg(Buffer(buf, buf + sizeof(buf)));
+        Datagram dg(Buffer(buf, buf + sizeof(buf)));
 
-            send_down(dg, ProtoDownMeta());
-        }
+        send_down(dg, ProtoDownMeta());
+    }
 
-        void handle_up(const void* cid, const Datagram& rb,
-                       const ProtoUpMeta& um)
+    void handle_up(const void* cid, const Datagram& rb,
+                   const ProtoUpMeta& um)
+    {
+        if (rb.len() < rb.offset() + 16)
         {
-            if (rb.len() < rb.offset() + 16)
-            {
-                gu_throw_fatal << "offset error";
-            }
-            char buf[16];
-            memset(buf, 0xa5, sizeof(buf));
-            // cppcheck-suppress uninitstring
-            if (memcmp(buf, &rb.payload()[0] + rb.offset(), 16) != 0)
-            {
-                gu_throw_fatal << "content mismatch";
-            }
-            recvd_++;
+            gu_throw_fatal << "offset error";
         }
-
-        size_t recvd() const
+        char buf[16];
+        memset(buf, 0xa5, sizeof(buf));
+        // cppcheck-suppress uninitstring
+        if (memcmp(buf, &rb.payload()[0] + rb.offset(), 16) != 0)
         {
-            return recvd_;
+            gu_throw_fatal << "content mismatch";
         }
+        recvd_++;
+    }
 
-        void set_recvd(size_t val)
-        {
-            recvd_ = val;
-        }
+    size_t recvd() const
+    {
+        return recvd_;
+    }
+
+    void set_recvd(size_t val)
+    {
+        recvd_ = val;
+    }
+
+    Protostack& pstack() { return pstack_; }
 
-        Protostack& pstack() { return pstack_; }
+    std::string listen_addr() const
+    {
+        return tp_->listen_addr();
+    }
 
-        std::string listen_addr() const
+    // number of established links reported by gmcast_links status
+    size_t links() const
+    {
+        gu::Status status;
+        tp_->get_status(status);
+        for (gu::Status::const_iterator i(status.begin());
+             i != status.end(); ++i)
         {
-            return tp_->listen_addr();
+            if (i->first == "gmcast_links" && i->second.empty() == false)
+            {
+                return gu::strsplit(i->second, ',').size();
+            }
         }
-    };
+        return 0;
+    }
+};
+}
 
+static void gmcast_w_user_messages(const std::string& io_threads)
+{
     log_info << "START";
     gu::Config conf;
     gu::ssl_register_params(conf);
     gcomm::Conf::register_params(conf);
+    conf.set(gcomm::Conf::ProtonetIoThreads, io_threads);
     mark_point();
     auto_ptr<Protonet> pnet(Protonet::create(conf));
     mark_point();
@@ -269,7 +291,125 @@ START_TEST(test_gmcast_w_user_messages)
     u4.stop();
 
     pnet->event_loop(0);
+}
+
+START_TEST(test_gmcast_w_user_messages)
+{
+    gmcast_w_user_messages("1");
+}
+END_TEST
+
+// socket handlers run in a pool of I/O threads
+START_TEST(test_gmcast_w_user_messages_io_threads)
+{
+    gmcast_w_user_messages("4");
+}
+END_TEST
+
+// messages from remote segment are forwarded via relay tree
+START_TEST(test_gmcast_segment_relay_tree)
+{
+    log_info << "START";
+    gu::Config conf;
+    gu::ssl_register_params(conf);
+    gcomm::Conf::register_params(conf);
+    auto_ptr<Protonet> pnet(Protonet::create(conf));
+
+    std::string const seg1("&gmcast.segment=1&gmcast.segment_fanout=2");
+    User u0(*pnet, "127.0.0.1:0", "");
+    pnet->insert(&u0.pstack());
+    u0.start();
+    std::string const peer(u0.listen_addr().erase(0, strlen("tcp://")));
+
+    std::vector<User*> seg;
+    for (size_t i(0); i < 5; ++i)
+    {
+        seg.push_back(new User(*pnet, "127.0.0.1:0", peer, seg1));
+        pnet->insert(&seg.back()->pstack());
+        seg.back()->start();
+    }
+
+    // let full mesh form
+    for (size_t n(0); n < 100; ++n)
+    {
+        u0.handle_timer();
+        pnet->event_loop(Sec/10);
+        size_t min_recvd(seg[0]->recvd());
+        for (size_t i(1); i < seg.size(); ++i)
+        {
+            min_recvd = std::min(min_recvd, seg[i]->recvd());
+        }
+        if (n > 20 && min_recvd > 0) break;
+    }
+
+    for (size_t i(0); i < seg.size(); ++i) seg[i]->set_recvd(0);
+
+    for (size_t n(0); n < 20; ++n)
+    {
+        u0.handle_timer();
+        pnet->event_loop(Sec/100);
+    }
+    pnet->event_loop(Sec/2);
+
+    for (size_t i(0); i < seg.size(); ++i)
+    {
+        fail_unless(seg[i]->recvd() == 20, "user %zu recvd %zu",
+                    i, seg[i]->recvd());
+    }
+
+    for (size_t i(0); i < seg.size(); ++i)
+    {
+        pnet->erase(&seg[i]->pstack());
+        seg[i]->stop();
+        delete seg[i];
+    }
+    pnet->erase(&u0.pstack());
+    u0.stop();
+    pnet->event_loop(0);
+}
+END_TEST
+
+START_TEST(test_gmcast_conns_per_peer)
+{
+    log_info << "START";
+    gu::Config conf;
+    gu::ssl_register_params(conf);
+    gcomm::Conf::register_params(conf);
+    auto_ptr<Protonet> pnet(Protonet::create(conf));
+
+    std::string const opts("&gmcast.conns_per_peer=3");
+    User u1(*pnet, "127.0.0.1:0", "", opts);
+    pnet->insert(&u1.pstack());
+    u1.start();
+    User u2(*pnet, "127.0.0.1:0",
+            u1.listen_addr().erase(0, strlen("tcp://")), opts);
+    pnet->insert(&u2.pstack());
+    u2.start();
+
+    for (size_t n(0); n < 50 && (u1.links() < 3 || u2.links() < 3); ++n)
+    {
+        pnet->event_loop(Sec/10);
+    }
+    fail_unless(u1.links() == 3, "u1 links %zu", u1.links());
+    fail_unless(u2.links() == 3, "u2 links %zu", u2.links());
 
+    // striped datagrams must be delivered exactly once
+    for (size_t n(0); n < 30; ++n)
+    {
+        u1.handle_timer();
+        u2.handle_timer();
+        pnet->event_loop(Sec/100);
+    }
+    pnet->event_loop(Sec/2);
+    fail_unless(u1.recvd() == 30, "u1 recvd %zu", u1.recvd());
+    fail_unless(u2.recvd() == 30, "u2 recvd %zu", u2.recvd());
+    fail_unless(u1.links() == 3, "u1 links %zu", u1.links());
+
+    pnet->erase(&u2.pstack());
+    pnet->erase(&u1.pstack());
+    u2.stop();
+    u1.stop();
+    pnet->event_loop(0);
 }
 END_TEST
 
@@ -310,6 +450,68 @@ END_TEST
 
 
 
+START_TEST(test_gmcast_path_status)
+{
+    log_info << "START";
+    gu::Config conf;
+    gu::ssl_register_params(conf);
+    gcomm::Conf::register_params(conf);
+    auto_ptr<Protonet> pnet(Protonet::create(conf));
+    Transport* tp1 = Transport::create(*pnet, "gmcast://"
+                    "?gmcast.group=test&gmcast.listen_addr=tcp://127.0.0.1:0");
+    pnet->insert(&tp1->pstack());
+    tp1->connect();
+
+    Transport* tp2 = Transport::create(*pnet,
+                                       std::string("gmcast://")
+                                       + tp1->listen_addr().erase(
+                                           0, strlen("tcp://"))
+                  + "?gmcast.group=test&gmcast.listen_addr=tcp://127.0.0.1:0");
+    pnet->insert(&tp2->pstack());
+    tp2->connect();
+
+    pnet->event_loop(Sec);
+
+    gu::Status status;
+    tp1->get_status(status);
+
+    long long mss(-1), rtt(-1);
+    std::string links;
+    for (gu::Status::const_iterator i(status.begin()); i != status.end(); ++i)
+    {
+        if (i->first == "gmcast_path_mss")
+            mss = gu::from_string<long long>(i->second);
+        else if (i->first == "gmcast_path_rtt")
+            rtt = gu::from_string<long long>(i->second);
+        else if (i->first == "gmcast_links")
+            links = i->second;
+    }
+    fail_unless(mss > 0, "mss: %lld", mss);
+    fail_unless(rtt >= 0, "rtt: %lld", rtt);
+
+    // single link to tp2:
+    // uuid:rtt:rtt_var:retrans:bytes_sent:bytes_received:send_q_bytes:addr
+    std::vector<std::string> fields(gu::strsplit(links, ':'));
+    fail_unless(fields.size() >= 8, "links: '%s'", links.c_str());
+    fail_unless(fields[0] == tp2->uuid().full_str(), "links: '%s'",
+                links.c_str());
+    fail_unless(gu::from_string<long long>(fields[4]) > 0, "links: '%s'",
+                links.c_str());
+    fail_unless(gu::from_string<long long>(fields[5]) > 0, "links: '%s'",
+                links.c_str());
+
+    pnet->erase(&tp2->pstack());
+    pnet->erase(&tp1->pstack());
+
+    tp1->close();
+    tp2->close();
+    delete tp1;
+    delete tp2;
+
+    pnet->event_loop(0);
+}
+END_TEST
+
 START_TEST(test_gmcast_forget)
 {
     gu_conf_self_tstamp_on();
@@ -456,11 +658,30 @@ Suite* gmcast_suite()
         tcase_set_timeout(tc, 30);
         suite_add_tcase(s, tc);
 
+        tc = tcase_create("test_gmcast_w_user_messages_io_threads");
+        tcase_add_test(tc, test_gmcast_w_user_messages_io_threads);
+        tcase_set_timeout(tc, 30);
+        suite_add_tcase(s, tc);
+
+        tc = tcase_create("test_gmcast_segment_relay_tree");
+        tcase_add_test(tc, test_gmcast_segment_relay_tree);
+        tcase_set_timeout(tc, 30);
+        suite_add_tcase(s, tc);
+
+        tc = tcase_create("test_gmcast_conns_per_peer");
+        tcase_add_test(tc, test_gmcast_conns_per_peer);
+        tcase_set_timeout(tc, 20);
+        suite_add_tcase(s, tc);
+
         // not run by default, hard coded port
         tc = tcase_create("test_gmcast_auto_addr");
         tcase_add_test(tc, test_gmcast_auto_addr);
         suite_add_tcase(s, tc);
 
+        tc = tcase_create("test_gmcast_path_status");
+        tcase_add_test(tc, test_gmcast_path_status);
+        suite_add_tcase(s, tc);
+
         tc = tcase_create("test_gmcast_forget");
         tcase_add_test(tc, test_gmcast_forget);
         tcase_set_timeout(tc, 20);
@@ -170,6 +170,7 @@ namespace gcomm
         UUID uuid_;
         std::deque<Datagram*> out_;
         bool queue_;
+        bool congested_;
 
     public:
 
@@ -179,7 +180,8 @@ namespace gcomm
                       (Protonet::create(check_trace_conf())), uri),
             uuid_(uuid),
             out_(),
-            queue_(queue)
+            queue_(queue),
+            congested_(false)
         {}
 
         ~DummyTransport()
@@ -191,6 +193,9 @@ namespace gcomm
 
         size_t mtu() const { return (1U << 31); }
 
+        void set_congested(bool val) { congested_ = val; }
+        bool handle_is_congested() const { return congested_; }
+
         void connect(bool first) { }
 
         void close(bool force) { }
@@ -545,10 +550,9 @@ namespace gcomm
         void propagate_n(size_t n);
         void propagate_until_empty();
         void propagate_until_cvi(bool handle_timers);
+        void expire_timers();
         friend std::ostream& operator<<(std::ostream&,const PropagationMatrix&);
     private:
-        void expire_timers();
-
 
         size_t count_channel_msgs() const;
         bool all_in_cvi() const;
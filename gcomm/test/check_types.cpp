@@ -47,6 +47,24 @@ START_TEST(test_uuid)
     fail_unless(full.compare(0, 8, os.str()) == 0,
                 "%s != %s", full.c_str(), os.str().c_str());
 
+    // word-wise comparison must order the same way as memcmp() for
+    // a difference in any byte
+    for (size_t i(0); i < sizeof(gu_uuid_t); ++i)
+    {
+        gu_uuid_t a(*uuid1.uuid_ptr());
+        gu_uuid_t b(a);
+
+        fail_unless(gu_uuid_equal(a, b));
+        fail_if(gu_uuid_less(a, b) || gu_uuid_less(b, a));
+
+        a.data[i] = 0x01;
+        b.data[i] = 0xfe;
+
+        fail_if(gu_uuid_equal(a, b), "byte %zu", i);
+        fail_unless(gu_uuid_less(a, b), "byte %zu", i);
+        fail_if(gu_uuid_less(b, a), "byte %zu", i);
+        fail_unless((memcmp(&a, &b, sizeof(a)) < 0) == gu_uuid_less(a, b));
+    }
 }
 END_TEST
 
@@ -103,6 +121,68 @@ START_TEST(test_view)
 }
 END_TEST
 
+typedef Map<UUID, UUID> RefMap;
+typedef Map<UUID, UUID, FlatMap<UUID, UUID> > FlatTestMap;
+
+static bool flat_map_equal(const FlatTestMap& flat, const RefMap& ref)
+{
+    if (flat.size() != ref.size()) return false;
+
+    RefMap::const_iterator j(ref.begin());
+    for (FlatTestMap::const_iterator i(flat.begin()); i != flat.end();
+         ++i, ++j)
+    {
+        if (FlatTestMap::key(i) != RefMap::key(j) ||
+            FlatTestMap::value(i) != RefMap::value(j)) return false;
+    }
+    return true;
+}
+
+START_TEST(test_flat_map)
+{
+    RefMap      ref;
+    FlatTestMap flat;
+
+    const int keys[] = { 5, 3, 9, 1, 7, 3, 2, 8, 4, 6, 9 };
+    for (size_t i = 0; i < sizeof(keys)/sizeof(keys[0]); ++i)
+    {
+        const UUID key(keys[i]);
+        const UUID val(static_cast<int>(i) + 1);
+        fail_unless(ref.insert(std::make_pair(key, val)).second ==
+                    flat.insert(std::make_pair(key, val)).second);
+    }
+
+    fail_unless(flat.size() == 9);
+    fail_unless(flat_map_equal(flat, ref));
+
+    fail_unless(flat.find(UUID(10)) == flat.end());
+    fail_unless(FlatTestMap::key(flat.find(UUID(4))) == UUID(4));
+    fail_unless(FlatTestMap::key(flat.lower_bound(UUID(4))) == UUID(4));
+
+    flat.erase(UUID(4));
+    ref.erase(UUID(4));
+    flat.erase(flat.begin());
+    ref.erase(ref.begin());
+    fail_unless(flat_map_equal(flat, ref));
+
+    flat[UUID(11)] = UUID(12);
+    ref[UUID(11)] = UUID(12);
+    fail_unless(flat_map_equal(flat, ref));
+
+    FlatTestMap flat2;
+    flat2.insert(flat.rbegin(), flat.rend());
+    fail_unless(flat2 == flat);
+
+    gu::Buffer buf(flat.serial_size());
+    fail_unless(flat.serialize(&buf[0], buf.size(), 0) == buf.size());
+    flat2.clear();
+    fail_unless(flat2.empty());
+    fail_unless(flat2 != flat);
+    fail_unless(flat2.unserialize(&buf[0], buf.size(), 0) == buf.size());
+    fail_unless(flat2 == flat);
+}
+END_TEST
+
 
 Suite* types_suite()
 {
@@ -117,5 +197,9 @@ Suite* types_suite()
     tcase_add_test(tc, test_view);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("test_flat_map");
+    tcase_add_test(tc, test_flat_map);
+    suite_add_tcase(s, tc);
+
     return s;
 }
@@ -6,6 +6,10 @@
 #include "gcomm/protonet.hpp"
 #include "gcomm/datagram.hpp"
 #include "gcomm/conf.hpp"
+#include "gcomm/protolay.hpp"
+
+#include "buffer_pool.hpp"
+#include "link_deflate.hpp"
 
 #ifdef HAVE_ASIO_HPP
 #include "asio_protonet.hpp"
@@ -177,6 +181,181 @@ START_TEST(test_protonet)
 }
 END_TEST
 
+START_TEST(test_buffer_pool)
+{
+    byte_t b[1000];
+    for (size_t i(0); i < sizeof(b); ++i) b[i] = static_cast<byte_t>(i);
+
+    boost::shared_ptr<BufferPool> pool(new BufferPool(2));
+    fail_unless(pool->cached() == 0);
+
+    const gu::byte_t* p;
+    {
+        gu::SharedBuffer sb(pool->get(b, b + sizeof(b)));
+        fail_unless(sb->size() == sizeof(b));
+        fail_unless(memcmp(&(*sb)[0], b, sizeof(b)) == 0);
+        p = &(*sb)[0];
+
+        // buffer is returned to pool when last reference is dropped
+        gu::SharedBuffer sb2(sb);
+        sb.reset();
+        fail_unless(pool->cached() == 0);
+    }
+    fail_unless(pool->cached() == 1);
+
+    // same size class reuses the cached buffer
+    {
+        gu::SharedBuffer sb(pool->get(b, b + 600));
+        fail_unless(pool->cached() == 0);
+        fail_unless(&(*sb)[0] == p);
+        fail_unless(sb->size() == 600);
+        fail_unless(memcmp(&(*sb)[0], b, 600) == 0);
+    }
+
+    // no more than max_cached free buffers per class are kept
+    {
+        gu::SharedBuffer sb1(pool->get(b, b + 1000));
+        gu::SharedBuffer sb2(pool->get(b, b + 1000));
+        gu::SharedBuffer sb3(pool->get(b, b + 1000));
+    }
+    fail_unless(pool->cached() == 2);
+
+    // buffers keep the pool alive
+    gu::SharedBuffer sb(pool->get(b, b + 10));
+    pool.reset();
+    fail_unless(memcmp(&(*sb)[0], b, 10) == 0);
+}
+END_TEST
+
+START_TEST(test_link_deflate)
+{
+    LinkDeflate deflate(1);
+    LinkInflate inflate;
+
+    Buffer msg(2000);
+    for (size_t i(0); i < msg.size(); ++i)
+    {
+        msg[i] = static_cast<byte_t>(i % 37);
+    }
+
+    Buffer buf;
+    Buffer out;
+    size_t prev(0);
+
+    // dictionary carries over from one datagram to the next
+    for (size_t n(0); n < 3; ++n)
+    {
+        Datagram dg(msg);
+        dg.set_header_offset(dg.header_offset() - 3);
+        memcpy(dg.header() + dg.header_offset(), "hdr", 3);
+
+        deflate.compress(dg, buf);
+        fail_unless(buf.size() <= deflate.bound(dg.len()));
+        fail_unless(buf.size() < dg.len() / 4, "size %zu", buf.size());
+        fail_if(n == 1 && buf.size() >= prev, "size %zu", buf.size());
+        prev = buf.size();
+
+        inflate.decompress(&buf[0], &buf[0] + buf.size(), out);
+        fail_unless(out.size() == dg.len());
+        fail_unless(memcmp(&out[0], "hdr", 3) == 0);
+        fail_unless(memcmp(&out[3], &msg[0], msg.size()) == 0);
+    }
+
+    // uncompressible payload
+    for (size_t i(0); i < msg.size(); ++i)
+    {
+        msg[i] = static_cast<byte_t>(rand());
+    }
+    deflate.compress(Datagram(msg), buf);
+    fail_unless(buf.size() <= deflate.bound(msg.size()));
+    inflate.decompress(&buf[0], &buf[0] + buf.size(), out);
+    fail_unless(out == msg);
+
+    // corrupted data
+    deflate.compress(Datagram(msg), buf);
+    buf[0] ^= 1; // original length
+    try
+    {
+        inflate.decompress(&buf[0], &buf[0] + buf.size(), out);
+        fail("corrupted datagram was not detected");
+    }
+    catch (gu::Exception& e)
+    {
+        fail_unless(e.get_errno() == EPROTO);
+    }
+}
+END_TEST
+
+namespace
+{
+    class UpBatchLayer : public Protolay
+    {
+    public:
+        UpBatchLayer(gu::Config& conf, bool batching)
+            :
+            Protolay(conf), batching_(batching), msgs_(0), batches_(0)
+        { }
+
+        void handle_up(const void*, const Datagram&, const ProtoUpMeta&)
+        {
+            ++msgs_;
+        }
+
+        void handle_up_batch(const void* id, const ProtoUpBatch& batch)
+        {
+            if (batching_ == false)
+            {
+                Protolay::handle_up_batch(id, batch);
+                return;
+            }
+            ++batches_;
+            msgs_ += batch.size();
+        }
+
+        int handle_down(Datagram&, const ProtoDownMeta&) { return 0; }
+
+        size_t msgs()    const { return msgs_;    }
+        size_t batches() const { return batches_; }
+
+    private:
+        bool   batching_;
+        size_t msgs_;
+        size_t batches_;
+    };
+}
+
+START_TEST(test_up_batch)
+{
+    gu::Config conf;
+    UpBatchLayer bottom(conf, false);
+    UpBatchLayer unrolling(conf, false);
+    UpBatchLayer batching(conf, true);
+
+    gcomm::connect(&bottom, &unrolling);
+    gcomm::connect(&bottom, &batching);
+
+    ProtoUpBatch batch;
+    for (int i(0); i < 3; ++i)
+    {
+        batch.push_back(Datagram(), ProtoUpMeta(UUID(1), ViewId(), 0, 0xff,
+                                                O_SAFE, i));
+    }
+    fail_unless(batch.size() == 3);
+    fail_unless(batch.um(2).to_seq() == 2);
+
+    bottom.send_up_batch(batch);
+
+    // default implementation unrolls batch into handle_up() calls
+    fail_unless(unrolling.msgs() == 3);
+    fail_unless(unrolling.batches() == 0);
+    fail_unless(batching.msgs() == 3);
+    fail_unless(batching.batches() == 1);
+
+    gcomm::disconnect(&bottom, &unrolling);
+    gcomm::disconnect(&bottom, &batching);
+}
+END_TEST
+
 START_TEST(test_view_state)
 {
     // compare view.
@@ -250,6 +429,18 @@ Suite* util_suite()
     tcase_add_test(tc, test_protonet);
     suite_add_tcase(s, tc);
 
+    tc = tcase_create("test_buffer_pool");
+    tcase_add_test(tc, test_buffer_pool);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_link_deflate");
+    tcase_add_test(tc, test_link_deflate);
+    suite_add_tcase(s, tc);
+
+    tc = tcase_create("test_up_batch");
+    tcase_add_test(tc, test_up_batch);
+    suite_add_tcase(s, tc);
+
     tc = tcase_create("test_view_state");
     tcase_add_test(tc, test_view_state);
     suite_add_tcase(s, tc);
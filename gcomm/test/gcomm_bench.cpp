@@ -0,0 +1,269 @@
+/* Copyright (C) 2017 Codership Oy <info@codership.com> */
+
+/*
+ * Loopback throughput/latency benchmark for complete gcomm stacks.
+ *
+ * Runs the requested number of PC/EVS/GMCast stacks in one process over
+ * real sockets on 127.0.0.1. Every node sends the given number of O_SAFE
+ * messages and total order delivery is measured on every node: message
+ * throughput over the sending period and latency from send_down() to
+ * delivery.
+ */
+
+#include "gcomm/protonet.hpp"
+#include "gcomm/transport.hpp"
+#include "gcomm/util.hpp"
+#include "gcomm/conf.hpp"
+
+#include "gu_asio.hpp"
+#include "gu_serialize.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include <pthread.h>
+#include <unistd.h>
+
+using gu::datetime::Date;
+using gu::datetime::Period;
+
+class Node : public gcomm::Toplay
+{
+public:
+    Node(gcomm::Protonet& pnet, const std::string& uri)
+        :
+        gcomm::Toplay(pnet.conf()),
+        tp_         (gcomm::Transport::create(pnet, uri)),
+        view_size_  (0),
+        delivered_  (0),
+        latencies_  ()
+    {
+        gcomm::connect(tp_, this);
+    }
+
+    ~Node()
+    {
+        gcomm::disconnect(tp_, this);
+        delete tp_;
+    }
+
+    void connect(bool bootstrap) { tp_->connect(bootstrap); }
+    void close()                 { tp_->close(true); }
+
+    int send(size_t const size)
+    {
+        gcomm::Datagram dg;
+        dg.payload().resize(std::max(size, sizeof(long long)));
+        gu::serialize8(Date::monotonic().get_utc(), &dg.payload()[0],
+                       dg.payload().size(), 0);
+        return send_down(dg, gcomm::ProtoDownMeta(0, gcomm::O_SAFE));
+    }
+
+    size_t view_size() const { return view_size_; }
+    size_t delivered() const { return delivered_; }
+    const std::vector<long long>& latencies() const { return latencies_; }
+
+    void handle_up(const void* id, const gcomm::Datagram& dg,
+                   const gcomm::ProtoUpMeta& um)
+    {
+        if (um.err_no() != 0)
+        {
+            gu_throw_error(um.err_no()) << "gcomm stack failed";
+        }
+        else if (um.has_view() == true)
+        {
+            view_size_ = um.view().type() == gcomm::V_PRIM ?
+                um.view().members().size() : 0;
+        }
+        else
+        {
+            long long sent;
+            gu::unserialize8(gcomm::begin(dg), gcomm::available(dg), 0, sent);
+            latencies_.push_back(Date::monotonic().get_utc() - sent);
+            ++delivered_;
+        }
+    }
+
+private:
+    Node(const Node&);
+    void operator=(const Node&);
+
+    gcomm::Transport*      tp_;
+    size_t                 view_size_;
+    size_t                 delivered_;
+    std::vector<long long> latencies_;
+};
+
+
+static volatile bool terminated(false);
+
+static void* event_loop(void* arg)
+{
+    gcomm::Protonet* const pnet(static_cast<gcomm::Protonet*>(arg));
+
+    while (terminated == false)
+    {
+        pnet->event_loop(gu::datetime::Sec);
+    }
+
+    return 0;
+}
+
+
+static void usage(const char* prog)
+{
+    std::cerr << "usage: " << prog << " [-n nodes] [-s msg size] "
+              << "[-m msgs per node] [-g segments] [-p base port] "
+              << "[-c conf]" << std::endl
+              << "  conf is a ';' separated list of gcomm/socket options, "
+              << "e.g. 'socket.ssl_key=...;socket.ssl_cert=...'" << std::endl;
+}
+
+
+int main(int argc, char* argv[])
+{
+    size_t      nodes(3);
+    size_t      msg_size(100);
+    size_t      msgs(10000);
+    size_t      segments(1);
+    int         base_port(10001);
+    std::string options;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:m:g:p:c:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': nodes     = gu::from_string<size_t>(optarg); break;
+        case 's': msg_size  = gu::from_string<size_t>(optarg); break;
+        case 'm': msgs      = gu::from_string<size_t>(optarg); break;
+        case 'g': segments  = gu::from_string<size_t>(optarg); break;
+        case 'p': base_port = gu::from_string<int>(optarg);    break;
+        case 'c': options   = optarg;                          break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (nodes == 0 || msgs == 0 || segments == 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    gu::Config conf;
+    gu::ssl_register_params(conf);
+    gcomm::Conf::register_params(conf);
+    if (options.empty() == false) conf.parse(options);
+    gu::ssl_init_options(conf);
+
+    std::auto_ptr<gcomm::Protonet> pnet(gcomm::Protonet::create(conf));
+
+    std::vector<Node*> group;
+    for (size_t i(0); i < nodes; ++i)
+    {
+        std::ostringstream uri;
+        uri << "gcomm://" << (i == 0 ? "" : "127.0.0.1:")
+            << (i == 0 ? "" : gu::to_string(base_port))
+            << "?gmcast.listen_addr=127.0.0.1:" << base_port + i
+            << "&gmcast.segment=" << i % segments;
+        group.push_back(new Node(*pnet, uri.str()));
+        group.back()->connect(i == 0);
+    }
+
+    /* connect() returns on the first primary view, wait for the full one */
+    for (bool formed(false); formed == false; )
+    {
+        pnet->event_loop(gu::datetime::Sec/10);
+        formed = true;
+        for (size_t i(0); i < nodes; ++i)
+        {
+            formed = formed && group[i]->view_size() == nodes;
+        }
+    }
+
+    pthread_t thd;
+    pthread_create(&thd, 0, &event_loop, pnet.get());
+
+    size_t const total(nodes * msgs);
+    Date const start(Date::monotonic());
+
+    for (size_t m(0); m < msgs; ++m)
+    {
+        for (size_t i(0); i < nodes; ++i)
+        {
+            int err;
+            do
+            {
+                {
+                    gcomm::Critical<gcomm::Protonet> crit(*pnet);
+                    err = group[i]->send(msg_size);
+                }
+                if (err == EAGAIN) usleep(100);
+            }
+            while (err == EAGAIN);
+
+            if (err != 0)
+            {
+                gu_throw_error(err) << "send failed";
+            }
+        }
+    }
+
+    Date const sent(Date::monotonic());
+
+    for (bool done(false); done == false; )
+    {
+        usleep(1000);
+        gcomm::Critical<gcomm::Protonet> crit(*pnet);
+        done = true;
+        for (size_t i(0); i < nodes; ++i)
+        {
+            done = done && group[i]->delivered() == total;
+        }
+    }
+
+    Date const stop(Date::monotonic());
+
+    {
+        gcomm::Critical<gcomm::Protonet> crit(*pnet);
+        terminated = true;
+        pnet->interrupt();
+    }
+    pthread_join(thd, 0);
+
+    std::vector<long long> lat;
+    for (size_t i(0); i < nodes; ++i)
+    {
+        lat.insert(lat.end(), group[i]->latencies().begin(),
+                   group[i]->latencies().end());
+    }
+    std::sort(lat.begin(), lat.end());
+
+    double const secs(double((stop - start).get_nsecs()) / gu::datetime::Sec);
+    double const usec(gu::datetime::USec);
+
+    std::cout << "nodes: " << nodes << ", segments: " << segments
+              << ", msg size: " << msg_size << ", msgs: " << total
+              << std::endl
+              << "send time: "
+              << double((sent - start).get_nsecs()) / gu::datetime::Sec
+              << " s, delivery time: " << secs << " s" << std::endl
+              << "throughput: " << total / secs << " msg/s, "
+              << total * msg_size / secs / (1 << 20) << " MiB/s" << std::endl
+              << "latency (us): p50 " << lat[lat.size() / 2] / usec
+              << ", p90 " << lat[lat.size() * 9 / 10] / usec
+              << ", p99 " << lat[lat.size() * 99 / 100] / usec
+              << ", max " << lat.back() / usec << std::endl;
+
+    for (size_t i(nodes); i > 0; --i)
+    {
+        group[i - 1]->close();
+        delete group[i - 1];
+    }
+
+    return 0;
+}
@@ -16,6 +16,7 @@
 #include <assert.h>
 
 #include <galerautils.h>
+#include <gu_probe.h>
 
 #include "gcs_priv.hpp"
 #include "gcs_params.hpp"
@@ -26,6 +27,9 @@
 #include "gcs_sm.hpp"
 #include "gcs_gcache.hpp"
 
+#include <gu_utils.hpp> // gu::to_string()
+#include <gu_thread.hpp> // gu::thread_set_numa_node()
+
 const char* gcs_node_state_to_str (gcs_node_state_t state)
 {
     static const char* str[GCS_NODE_STATE_MAX + 1] =
@@ -92,14 +96,6 @@ static const char* gcs_conn_state_str[GCS_CONN_STATE_MAX] =
 static bool const GCS_FC_STOP = true;
 static bool const GCS_FC_CONT = false;
 
-/** Flow control message */
-struct gcs_fc_event
-{
-    uint32_t conf_id; // least significant part of configuraiton seqno
-    uint32_t stop;    // boolean value
-}
-__attribute__((__packed__));
-
 struct gcs_conn
 {
     long  my_idx;
@@ -163,6 +159,7 @@ struct gcs_conn
     }
     long         stop_count;          // counts stop requests received
     long         queue_len;           // slave queue length
+    long         fc_queue;            // slave queue in gcs.fc_units
     long         upper_limit;         // upper slave queue limit
     long         lower_limit;         // lower slave queue limit
     long         fc_offset;           // offset for catchup phase
@@ -170,7 +167,10 @@ struct gcs_conn
     long         stats_fc_stop_sent;  // FC stats counters
     long         stats_fc_cont_sent;  //
     long         stats_fc_received;   //
+    long         stats_fc_stop_queue; // queue length at last FC_STOP sent
     gcs_fc_t     stfc; // state transfer FC object
+    gcs_fcr_t    fcr;  // slave queue controller for GCS_FC_MODE_RATE
+    gcs_fcc_t    fcc;  // group lag controller for GCS_FC_MODE_COORD
 
     /* #603, #606 join control */
     bool        volatile need_to_join;
@@ -300,7 +300,9 @@ gcs_create (gu_config_t* const conf, gcache_t* const gcache,
     }
 
     {
-        size_t recv_q_len = gu_avphys_bytes() / sizeof(struct gcs_recv_act) / 4;
+        size_t recv_q_len = conn->params.recv_q_length > 0 ?
+            conn->params.recv_q_length :
+            gu_avphys_bytes() / sizeof(struct gcs_recv_act) / 4;
 
         gu_debug ("Requesting recv queue len: %zu", recv_q_len);
         conn->recv_q = gu_fifo_create (recv_q_len, sizeof(struct gcs_recv_act));
@@ -317,11 +319,16 @@ gcs_create (gu_config_t* const conf, gcache_t* const gcache,
         goto sm_create_failed;
     }
 
+    gcs_sm_set_budget (conn->sm, conn->params.sm_budget);
+
     conn->state        = GCS_CONN_CLOSED;
     conn->my_idx       = -1;
     conn->local_act_id = GCS_SEQNO_FIRST;
     conn->global_seqno = 0;
     conn->fc_offset    = 0;
+    conn->fc_queue     = 0;
+    gcs_fcr_reset (&conn->fcr, 0.0);
+    gcs_fcc_reset (&conn->fcc, 0);
     conn->timeout      = GU_TIME_ETERNITY;
     conn->gcache       = gcache;
     conn->max_fc_state = conn->params.sync_donor ?
@@ -406,15 +413,31 @@ gcs_send_fc_event (gcs_conn_t* conn, bool stop)
     return gcs_core_send_fc (conn->core, &fc, sizeof(fc));
 }
 
+/* Weight of an action in gcs.fc_units */
+static inline long
+gcs_fc_weight (const gcs_conn_t* const conn, ssize_t const act_size)
+{
+    return (GCS_FC_UNITS_BYTES == conn->params.fc_units ? act_size : 1);
+}
+
 /* To be called under slave queue lock. Returns true if FC_STOP must be sent */
 static inline bool
-gcs_fc_stop_begin (gcs_conn_t* conn)
+gcs_fc_stop_begin (gcs_conn_t* conn, ssize_t const act_size)
 {
     long err = 0;
 
+    bool const over_limit
+        (GCS_FC_MODE_RATE == conn->params.fc_mode ?
+         gcs_fcr_account (&conn->fcr, conn->fc_queue - conn->fc_offset,
+                          true, gcs_fc_weight (conn, act_size)) > 0.0 :
+         GCS_FC_MODE_COORD == conn->params.fc_mode ?
+         conn->fc_queue > (GCS_FCC_HARD_FACTOR * conn->upper_limit +
+                           conn->fc_offset) :
+         conn->fc_queue > (conn->upper_limit + conn->fc_offset));
+
     bool ret = (conn->stop_count <= 0                                     &&
                 conn->stop_sent_ <= 0                                     &&
-                conn->queue_len  >  (conn->upper_limit + conn->fc_offset) &&
+                over_limit                                                &&
                 conn->state      <= conn->max_fc_state                    &&
                 !(err = gu_mutex_lock (&conn->fc_lock)));
 
@@ -447,6 +470,8 @@ gcs_fc_stop_end (gcs_conn_t* conn)
         if (ret >= 0) {
             ret = 0;
             conn->stats_fc_stop_sent++;
+            conn->stats_fc_stop_queue = conn->queue_len;
+            GU_PROBE2(fc_stop_sent, conn->local_act_id, conn->queue_len);
         }
         else {
             assert (conn->stop_sent() > 0);
@@ -471,15 +496,23 @@ gcs_fc_stop_end (gcs_conn_t* conn)
 
 /* To be called under slave queue lock. Returns true if FC_CONT must be sent */
 static inline bool
-gcs_fc_cont_begin (gcs_conn_t* conn)
+gcs_fc_cont_begin (gcs_conn_t* conn, ssize_t const act_size)
 {
     long err = 0;
 
-    bool queue_decreased = (conn->fc_offset > conn->queue_len &&
-                            (conn->fc_offset = conn->queue_len, true));
+    bool queue_decreased = (conn->fc_offset > conn->fc_queue &&
+                            (conn->fc_offset = conn->fc_queue, true));
+
+    bool const under_limit
+        (GCS_FC_MODE_RATE == conn->params.fc_mode ?
+         gcs_fcr_account (&conn->fcr, conn->fc_queue - conn->fc_offset,
+                          false, gcs_fc_weight (conn, act_size)) <= 0.0 :
+         GCS_FC_MODE_COORD == conn->params.fc_mode ?
+         conn->upper_limit >= conn->fc_queue :
+         conn->lower_limit >= conn->fc_queue);
 
     bool ret = (conn->stop_sent_  >  0                                    &&
-                (conn->lower_limit >= conn->queue_len || queue_decreased) &&
+                (under_limit || queue_decreased)                          &&
                 conn->state        <= conn->max_fc_state                  &&
                 !(err = gu_mutex_lock (&conn->fc_lock)));
 
@@ -510,6 +543,7 @@ gcs_fc_cont_end (gcs_conn_t* conn)
         if (gu_likely (ret >= 0)) {
             ret = 0;
             conn->stats_fc_cont_sent++;
+            GU_PROBE2(fc_cont_sent, conn->local_act_id, conn->queue_len);
         }
         else {
             /* restore counter */
@@ -536,7 +570,7 @@ static inline bool
 gcs_send_sync_begin (gcs_conn_t* conn)
 {
     if (gu_unlikely(GCS_CONN_JOINED == conn->state)) {
-        if (conn->lower_limit >= conn->queue_len && !conn->sync_sent()) {
+        if (conn->lower_limit >= conn->fc_queue && !conn->sync_sent()) {
             // tripped lower slave queue limit, send SYNC message
             conn->sync_sent(true);
 #if 0
@@ -793,7 +827,7 @@ gcs_become_joined (gcs_conn_t* conn)
 
     /* See also gcs_handle_act_conf () for a case of cluster bootstrapping */
     if (gcs_shift_state (conn, GCS_CONN_JOINED)) {
-        conn->fc_offset    = conn->queue_len;
+        conn->fc_offset    = conn->fc_queue;
         conn->need_to_join = false;
         gu_debug("Become joined, FC offset %ld", conn->fc_offset);
         /* One of the cases when the node can become SYNCED */
@@ -831,8 +865,28 @@ _set_fc_limits (gcs_conn_t* conn)
     conn->upper_limit = conn->params.fc_base_limit * fn + .5;
     conn->lower_limit = conn->upper_limit * conn->params.fc_resume_factor + .5;
 
-    gu_info ("Flow-control interval: [%ld, %ld]",
-             conn->lower_limit, conn->upper_limit);
+    if (GCS_FC_MODE_RATE == conn->params.fc_mode)
+    {
+        /* aim at the middle of the interval */
+        gcs_fcr_reset (&conn->fcr, 0.5*(conn->lower_limit + conn->upper_limit));
+
+        gu_info ("Flow-control target queue length: %.1f",
+                 conn->fcr.target);
+    }
+    else
+    {
+        gu_info ("Flow-control interval: [%ld, %ld] %s",
+                 conn->lower_limit, conn->upper_limit,
+                 gcs_fc_units_str (conn->params.fc_units));
+
+        if (GCS_FC_MODE_COORD == conn->params.fc_mode &&
+            GCS_FC_UNITS_ACTIONS != conn->params.fc_units)
+        {
+            gu_warn ("Group lag is counted in actions, but flow-control "
+                     "limits are in %s.",
+                     gcs_fc_units_str (conn->params.fc_units));
+        }
+    }
 }
 
 /*! Handles flow control events
@@ -849,6 +903,8 @@ gcs_handle_flow_control (gcs_conn_t*                conn,
     conn->stop_count += ((fc->stop != 0) << 1) - 1; // +1 if !0, -1 if 0
     conn->stats_fc_received += (fc->stop != 0);
 
+    GU_PROBE2(fc_recv, int(fc->stop != 0), conn->stop_count);
+
     if (1 == conn->stop_count) {
         gcs_sm_pause (conn->sm);    // first STOP request
     }
@@ -872,6 +928,23 @@ _reset_pkt_size(gcs_conn_t* conn)
     }
 }
 
+/* Picks packet size for the new primary component, gcs.max_packet_size
+ * being the upper bound. Unlike _reset_pkt_size() this is safe under load. */
+static void
+_tune_pkt_size(gcs_conn_t* conn)
+{
+    int const ret(gcs_core_tune_pkt_size (conn->core,
+                                          conn->params.max_packet_size));
+
+    if (-ENODATA == ret) {
+        gu_info ("Path properties are not known to backend, "
+                 "keeping packet size.");
+    }
+    else if (ret < 0) {
+        gu_warn ("Failed to tune packet size: %d (%s)", ret, strerror(-ret));
+    }
+}
+
 static long
 _join (gcs_conn_t* conn, gcs_seqno_t seqno)
 {
@@ -912,6 +985,7 @@ gcs_handle_act_conf (gcs_conn_t* conn, const void* action)
             conn->stop_count  = 0;
             conn->conf_id     = conf->conf_id;
             conn->memb_num    = conf->memb_num;
+            gcs_fcc_reset (&conn->fcc, conf->seqno);
 
             _set_fc_limits (conn);
 
@@ -971,6 +1045,7 @@ gcs_handle_act_conf (gcs_conn_t* conn, const void* action)
     /* at this point we have established protocol version,
      * so can set packet size */
 // Ticket #600: commented out as unsafe under load    _reset_pkt_size(conn);
+    if (conn->params.auto_pkt_size) _tune_pkt_size(conn);
 
     const gcs_conn_state_t old_state = conn->state;
     switch (conf->my_state) {
@@ -1029,7 +1104,9 @@ gcs_handle_act_state_req (gcs_conn_t*          conn,
         if (rcvd->id >= 0) {
             gcs_become_joiner (conn);
         }
-        return 1; // pass to gcs_request_state_transfer() caller.
+        // pass to gcs_request_state_transfer() caller or, if it is a foreign
+        // request, to IST helper application, see gcs_state_req_split()
+        return 1;
     }
 }
 
@@ -1306,6 +1383,26 @@ static void *gcs_recv_thread (void *arg)
             if (gu_likely(ret <= 0)) continue; // not for application
         }
 
+#ifdef GCS_FOR_GARB
+        /* Arbitrator without a cache only tracks seqnos of ordered actions,
+         * so only those it reports as last applied are delivered. This saves
+         * a recv_q slot and an application thread wakeup per write set. */
+        if (NULL == conn->gcache && GCS_ACT_TORDERED == rcvd.act.type &&
+            NULL == rcvd.local && rcvd.id > 0)
+        {
+            assert (NULL == rcvd.act.buf);
+            conn->global_seqno = rcvd.id;
+            if (rcvd.id % GCS_ARBITRATOR_REPORT_INTERVAL) continue;
+        }
+#endif /* GCS_FOR_GARB */
+
+        if (gu_unlikely(GCS_ACT_COMMIT_CUT == rcvd.act.type)) {
+            gu_mutex_lock   (&conn->fc_lock);
+            gcs_fcc_cut (&conn->fcc, gcs_seqno_gtoh(
+                             *(const gcs_seqno_t*)rcvd.act.buf));
+            gu_mutex_unlock (&conn->fc_lock);
+        }
+
         /* deliver to application (note matching assert in the bottom-half of
          * gcs_repl()) */
         if (gu_likely (rcvd.act.type != GCS_ACT_TORDERED ||
@@ -1350,7 +1447,10 @@ static void *gcs_recv_thread (void *arg)
                 recv_act->local_id = this_act_id;
 
                 conn->queue_len = gu_fifo_length (conn->recv_q) + 1;
-                bool const send_stop(gcs_fc_stop_begin(conn));
+                conn->fc_queue  = GCS_FC_UNITS_BYTES == conn->params.fc_units ?
+                    conn->recv_q_size + rcvd.act.buf_len : conn->queue_len;
+                bool const send_stop(gcs_fc_stop_begin(conn,
+                                                       rcvd.act.buf_len));
 
                 // release queue
                 GCS_FIFO_PUSH_TAIL (conn, rcvd.act.buf_len);
@@ -1413,6 +1513,22 @@ static void *gcs_recv_thread (void *arg)
     return NULL;
 }
 
+static void
+_bind_numa_node (gu_thread_t const thread, long const node)
+{
+    if (node < 0) return;
+
+    try
+    {
+        gu::thread_set_numa_node (thread, node);
+        gu_info ("GCS receive thread bound to NUMA node %ld", node);
+    }
+    catch (std::exception& e)
+    {
+        gu_warn ("%s", e.what());
+    }
+}
+
 /* Opens connection to group */
 long gcs_open (gcs_conn_t* conn, const char* channel, const char* url,
                bool const bootstrap)
@@ -1438,6 +1554,7 @@ long gcs_open (gcs_conn_t* conn, const char* channel, const char* url,
 
             if (!(ret = gu_thread_create (&conn->recv_thread, NULL,
                                           gcs_recv_thread, conn))) {
+                _bind_numa_node (conn->recv_thread, conn->params.numa_node);
                 gcs_fifo_lite_open(conn->repl_q);
                 gu_fifo_open(conn->recv_q);
                 gcs_shift_state (conn, GCS_CONN_OPEN);
@@ -1558,7 +1675,36 @@ long gcs_destroy (gcs_conn_t *conn)
     return 0;
 }
 
+/* Send monitor priority class of an action */
+static inline gcs_sm_class_t
+_sm_class (const gcs_conn_t* conn, size_t act_size, gcs_act_type_t act_type)
+{
+    if (GCS_ACT_TORDERED != act_type) return GCS_SM_CLASS_CTRL;
+
+    return (act_size <= (size_t)conn->params.sm_small_size ?
+            GCS_SM_CLASS_SMALL : GCS_SM_CLASS_LARGE);
+}
+
 /* Puts action in the send queue and returns */
+/* In GCS_FC_MODE_COORD delays a local action according to group lag */
+static void
+_fcc_throttle (gcs_conn_t* const conn)
+{
+    gcs_seqno_t ordered;
+    gu_atomic_get (&conn->global_seqno, &ordered);
+
+    gu_mutex_lock   (&conn->fc_lock);
+    long long const delay(gcs_fcc_delay (&conn->fcc, ordered,
+                                         conn->lower_limit, conn->upper_limit));
+    gu_mutex_unlock (&conn->fc_lock);
+
+    if (delay > 0) {
+        struct timespec const ts = { time_t(delay / 1000000000LL),
+                                     long(delay % 1000000000LL) };
+        nanosleep (&ts, NULL);
+    }
+}
+
 long gcs_sendv (gcs_conn_t*          const conn,
                 const struct gu_buf* const act_bufs,
                 size_t               const act_size,
@@ -1567,6 +1713,9 @@ long gcs_sendv (gcs_conn_t*          const conn,
 {
     if (gu_unlikely(act_size > GCS_MAX_ACT_SIZE)) return -EMSGSIZE;
 
+    if (GCS_FC_MODE_COORD == conn->params.fc_mode &&
+        GCS_ACT_TORDERED  == act_type) _fcc_throttle (conn);
+
     long ret = -ENOTCONN;
 
     /*! locking connection here to avoid race with gcs_close()
@@ -1575,11 +1724,12 @@ long gcs_sendv (gcs_conn_t*          const conn,
     gu_cond_t tmp_cond;
     gu_cond_init (&tmp_cond, NULL);
 
-    if (!(ret = gcs_sm_enter (conn->sm, &tmp_cond, scheduled, true)))
+    if (!(ret = gcs_sm_enter (conn->sm, &tmp_cond, scheduled, true,
+                              _sm_class (conn, act_size, act_type), act_size)))
     {
         while ((GCS_CONN_OPEN >= conn->state) &&
                (ret = gcs_core_send (conn->core, act_bufs,
-                                     act_size, act_type)) == -ERESTART);
+                                     act_size, act_type, false)) == -ERESTART);
         gcs_sm_leave (conn->sm);
         gu_cond_destroy (&tmp_cond);
     }
@@ -1606,7 +1756,9 @@ gcs_seqno_t gcs_caused(gcs_conn_t* conn)
 long gcs_replv (gcs_conn_t*          const conn,      //!<in
                 const struct gu_buf* const act_in,    //!<in
                 struct gcs_action*   const act,       //!<inout
-                bool                 const scheduled) //!<in
+                bool                 const scheduled, //!<in
+                bool                 const cached,    //!<in
+                bool                 const bulk)      //!<in
 {
     if (gu_unlikely((size_t)act->size > GCS_MAX_ACT_SIZE)) return -EMSGSIZE;
 
@@ -1618,6 +1770,9 @@ long gcs_replv (gcs_conn_t*          const conn,      //!<in
     act->seqno_l = GCS_SEQNO_ILL;
     act->seqno_g = GCS_SEQNO_ILL;
 
+    if (GCS_FC_MODE_COORD == conn->params.fc_mode &&
+        GCS_ACT_TORDERED  == act->type) _fcc_throttle (conn);
+
     /* This is good - we don't have to do a copy because we wait */
     struct gcs_repl_act repl_act(act_in, act);
 
@@ -1632,7 +1787,12 @@ long gcs_replv (gcs_conn_t*          const conn,      //!<in
         // 1. serializes gcs_core_send() access between gcs_repl() and
         //    gcs_send()
         // 2. avoids race with gcs_close() and gcs_destroy()
-        if (!(ret = gcs_sm_enter (conn->sm, &repl_act.wait_cond, scheduled, true)))
+        gcs_sm_class_t const cls(bulk && GCS_ACT_TORDERED == act->type ?
+                                 GCS_SM_CLASS_LARGE :
+                                 _sm_class (conn, act->size, act->type));
+
+        if (!(ret = gcs_sm_enter (conn->sm, &repl_act.wait_cond, scheduled, true,
+                                  cls, act->size)))
         {
             struct gcs_repl_act** act_ptr;
 
@@ -1645,7 +1805,7 @@ long gcs_replv (gcs_conn_t*          const conn,      //!<in
             // if (conn->state >= GCS_CONN_CLOSE) or (act_ptr == NULL)
             // ret will be -ENOTCONN
             if ((ret = -EAGAIN,
-                 conn->upper_limit >= conn->queue_len ||
+                 conn->upper_limit >= conn->fc_queue  ||
                  act->type         != GCS_ACT_TORDERED)         &&
                 (ret = -ENOTCONN, GCS_CONN_OPEN >= conn->state) &&
                 (act_ptr = (struct gcs_repl_act**)gcs_fifo_lite_get_tail (conn->repl_q)))
@@ -1655,7 +1815,8 @@ long gcs_replv (gcs_conn_t*          const conn,      //!<in
 
                 // Keep on trying until something else comes out
                 while ((ret = gcs_core_send (conn->core, act_in, act->size,
-                                             act->type)) == -ERESTART) {}
+                                             act->type, cached)) == -ERESTART)
+                {}
 
                 if (ret < 0) {
                     /* remove item from the queue, it will never be delivered */
@@ -1681,7 +1842,14 @@ long gcs_replv (gcs_conn_t*          const conn,      //!<in
             /* now we can go waiting for action delivery */
             if (ret >= 0) {
                 gu_cond_wait (&repl_act.wait_cond, &repl_act.wait_mutex);
-#ifndef GCS_FOR_GARB
+#ifdef GCS_FOR_GARB
+                /* arbitrator gets action buffers only if it has a cache */
+                if (NULL == conn->gcache)
+                {
+                    assert (act->buf == 0);
+                }
+                else
+#endif /* GCS_FOR_GARB */
                 /* assert (act->buf != 0); */
                 if (act->buf == 0)
                 {
@@ -1689,9 +1857,6 @@ long gcs_replv (gcs_conn_t*          const conn,      //!<in
                     ret = -ENOTCONN;
                     goto out;
                 }
-#else
-                assert (act->buf == 0);
-#endif /* GCS_FOR_GARB */
 
                 if (act->seqno_g < 0) {
                     assert (GCS_SEQNO_ILL    == act->seqno_l ||
@@ -1699,7 +1864,7 @@ long gcs_replv (gcs_conn_t*          const conn,      //!<in
 
                     if (act->seqno_g == GCS_SEQNO_ILL) {
                         /* action was not replicated for some reason */
-                        assert (orig_buf == act->buf);
+                        assert (orig_buf == act->buf || cached);
                         ret = -EINTR;
                     }
                     else {
@@ -1711,17 +1876,18 @@ long gcs_replv (gcs_conn_t*          const conn,      //!<in
 
                     if (orig_buf != act->buf) // action was allocated in gcache
                     {
-                        gu_debug("Freeing gcache buffer %p after receiving %d",
-                                 act->buf, ret);
-                        gcs_gcache_free (conn->gcache, act->buf);
+                        if (!cached) // otherwise it is caller's buffer
+                        {
+                            gu_debug("Freeing gcache buffer %p after "
+                                     "receiving %d", act->buf, ret);
+                            gcs_gcache_free (conn->gcache, act->buf);
+                        }
                         act->buf = orig_buf;
                     }
                 }
             }
         }
-#ifndef GCS_FOR_GARB
     out:
-#endif /* GCS_FOR_GARB */
         gu_mutex_unlock  (&repl_act.wait_mutex);
     }
     gu_mutex_destroy (&repl_act.wait_mutex);
@@ -1742,11 +1908,12 @@ long gcs_request_state_transfer (gcs_conn_t  *conn,
                                  const char  *donor,
                                  const gu_uuid_t* ist_uuid,
                                  gcs_seqno_t ist_seqno,
+                                 int          ist_donors,
                                  gcs_seqno_t *local)
 {
     long   ret       = -ENOMEM;
     size_t donor_len = strlen(donor) + 1; // include terminating \0
-    size_t rst_size  = size + donor_len + sizeof(*ist_uuid) + sizeof(ist_seqno) + 2;
+    size_t rst_size  = size + donor_len + sizeof(*ist_uuid) + sizeof(ist_seqno) + 3;
     // for simplicity, allocate maximum space what we need here.
     char*  rst       = (char*)gu_malloc (rst_size);
 
@@ -1788,6 +1955,19 @@ long gcs_request_state_transfer (gcs_conn_t  *conn,
             offset += sizeof(*ist_uuid);
             *(gcs_seqno_t*) (rst + offset) = gcs_seqno_htog(ist_seqno);
             offset += sizeof(ist_seqno);
+
+            // version 3 (split IST)
+            // RST format: |...|ist_seqno|ist_donors|app_request|
+            if (version >= 3) {
+                if (ist_donors < 1) ist_donors = 1;
+                if (ist_donors > GCS_IST_DONORS_MAX)
+                    ist_donors = GCS_IST_DONORS_MAX;
+                rst[offset++] = (char)ist_donors;
+            }
+            else {
+                rst_size--;
+            }
+
             memcpy (rst + offset, req, size);
         }
 
@@ -1806,10 +1986,11 @@ long gcs_request_state_transfer (gcs_conn_t  *conn,
             assert (action.buf != rst);
 #ifndef GCS_FOR_GARB
             assert (action.buf != NULL);
-            gcs_gcache_free (conn->gcache, action.buf);
 #else
-            assert (action.buf == NULL);
+            assert ((action.buf != NULL) == (conn->gcache != NULL));
+            if (action.buf != NULL)
 #endif
+            gcs_gcache_free (conn->gcache, action.buf);
             assert (ret == (ssize_t)rst_size);
             assert (action.seqno_g >= 0);
             assert (action.seqno_l >  0);
@@ -1826,6 +2007,28 @@ long gcs_request_state_transfer (gcs_conn_t  *conn,
     return ret;
 }
 
+int gcs_state_req_split (const void** req, ssize_t* req_len, int* rank)
+{
+    const char* const buf = (const char*)*req;
+
+    *rank = 0;
+
+    if (*req_len < (ssize_t)GCS_IST_SPLIT_HDR_LEN ||
+        memcmp (buf, GCS_IST_SPLIT_TAG, sizeof(GCS_IST_SPLIT_TAG))) {
+        return 1;
+    }
+
+    *rank     = (uint8_t)buf[sizeof(GCS_IST_SPLIT_TAG)];
+    int const donors = (uint8_t)buf[sizeof(GCS_IST_SPLIT_TAG) + 1];
+
+    *req      = buf + GCS_IST_SPLIT_HDR_LEN;
+    *req_len -= GCS_IST_SPLIT_HDR_LEN;
+
+    assert (*rank < donors);
+
+    return donors;
+}
+
 long gcs_desync (gcs_conn_t* conn, gcs_seqno_t* local)
 {
     gu_uuid_t ist_uuid = {{0, }};
@@ -1833,7 +2036,7 @@ long gcs_desync (gcs_conn_t* conn, gcs_seqno_t* local)
     // for desync operation we use the lowest str_version.
     long ret = gcs_request_state_transfer (conn, 0,
                                            "", 1, GCS_DESYNC_REQ,
-                                           &ist_uuid, ist_seqno,
+                                           &ist_uuid, ist_seqno, 1,
                                            local);
 
     if (ret >= 0) {
@@ -1863,8 +2066,12 @@ long gcs_recv (gcs_conn_t*        conn,
 
     if ((recv_act = (struct gcs_recv_act*)gu_fifo_get_head (conn->recv_q, &err)))
     {
+        ssize_t const act_size(recv_act->rcvd.act.buf_len);
+
         conn->queue_len = gu_fifo_length (conn->recv_q) - 1;
-        bool send_cont  = gcs_fc_cont_begin   (conn);
+        conn->fc_queue  = GCS_FC_UNITS_BYTES == conn->params.fc_units ?
+            conn->recv_q_size - act_size : conn->queue_len;
+        bool send_cont  = gcs_fc_cont_begin   (conn, act_size);
         bool send_sync  = gcs_send_sync_begin (conn);
 
         action->buf     = (void*)recv_act->rcvd.act.buf;
@@ -1954,7 +2161,7 @@ long
 gcs_wait (gcs_conn_t* conn)
 {
     if (gu_likely(GCS_CONN_SYNCED == conn->state)) {
-       return (conn->stop_count > 0 || (conn->queue_len > conn->upper_limit));
+       return (conn->stop_count > 0 || (conn->fc_queue > conn->upper_limit));
     }
     else {
         switch (conn->state) {
@@ -1983,7 +2190,8 @@ gcs_set_last_applied (gcs_conn_t* conn, gcs_seqno_t seqno)
     gu_cond_t cond;
     gu_cond_init (&cond, NULL);
 
-    long ret = gcs_sm_enter (conn->sm, &cond, false, false);
+    long ret = gcs_sm_enter (conn->sm, &cond, false, false,
+                             GCS_SM_CLASS_CTRL);
 
     if (!ret) {
         ret = gcs_core_set_last_applied (conn->core, seqno);
@@ -2049,6 +2257,26 @@ void gcs_get_status(gcs_conn_t* conn, gu::Status& status)
     {
         gcs_core_get_status(conn->core, status);
     }
+
+    status.insert("flow_control_mode", gcs_fc_mode_str(conn->params.fc_mode));
+    status.insert("flow_control_units",
+                  gcs_fc_units_str(conn->params.fc_units));
+    status.insert("flow_control_stop_queue",
+                  gu::to_string(conn->stats_fc_stop_queue));
+
+    if (GCS_FC_MODE_RATE == conn->params.fc_mode)
+    {
+        gcs_fcr_t fcr;
+
+        gu_fifo_lock (conn->recv_q);
+        fcr = conn->fcr;
+        gu_fifo_release (conn->recv_q);
+
+        status.insert("flow_control_target",    gu::to_string(fcr.target));
+        status.insert("flow_control_in_rate",   gu::to_string(fcr.in_rate));
+        status.insert("flow_control_out_rate",  gu::to_string(fcr.out_rate));
+        status.insert("flow_control_output",    gu::to_string(fcr.output));
+    }
 }
 
 static long
@@ -2138,6 +2366,67 @@ _set_fc_debug (gcs_conn_t* conn, const char* value)
     }
 }
 
+static long
+_set_fc_mode (gcs_conn_t* conn, const char* value)
+{
+    gcs_fc_mode_t mode;
+
+    if (gcs_fc_mode_parse (value, &mode)) return -EINVAL;
+
+    if (conn->params.fc_mode == mode) return 0;
+
+    gu_fifo_lock(conn->recv_q);
+    {
+        if (!gu_mutex_lock (&conn->fc_lock)) {
+            conn->params.fc_mode = mode;
+            _set_fc_limits (conn);
+            gu_config_set_string (conn->config, GCS_PARAMS_FC_MODE,
+                                  gcs_fc_mode_str (mode));
+            gu_mutex_unlock (&conn->fc_lock);
+        }
+        else {
+            gu_fatal ("Failed to lock mutex.");
+            abort();
+        }
+    }
+    gu_fifo_release (conn->recv_q);
+
+    return 0;
+}
+
+/* gcs.fc_limit keeps its value, but is now interpreted in the new units */
+static long
+_set_fc_units (gcs_conn_t* conn, const char* value)
+{
+    gcs_fc_units_t units;
+
+    if (gcs_fc_units_parse (value, &units)) return -EINVAL;
+
+    if (conn->params.fc_units == units) return 0;
+
+    gu_fifo_lock(conn->recv_q);
+    {
+        if (!gu_mutex_lock (&conn->fc_lock)) {
+            conn->params.fc_units = units;
+            conn->fc_queue = GCS_FC_UNITS_BYTES == units ?
+                conn->recv_q_size : gu_fifo_length (conn->recv_q);
+            /* catchup offset was measured in old units, start it over */
+            if (conn->fc_offset > 0) conn->fc_offset = conn->fc_queue;
+            _set_fc_limits (conn);
+            gu_config_set_string (conn->config, GCS_PARAMS_FC_UNITS,
+                                  gcs_fc_units_str (units));
+            gu_mutex_unlock (&conn->fc_lock);
+        }
+        else {
+            gu_fatal ("Failed to lock mutex.");
+            abort();
+        }
+    }
+    gu_fifo_release (conn->recv_q);
+
+    return 0;
+}
+
 static long
 _set_sync_donor (gcs_conn_t* conn, const char* value)
 {
@@ -2155,6 +2444,57 @@ _set_sync_donor (gcs_conn_t* conn, const char* value)
     return 0;
 }
 
+static long
+_set_auto_pkt_size (gcs_conn_t* conn, const char* value)
+{
+    bool aps;
+    const char* const endptr = gu_str2bool (value, &aps);
+
+    if (endptr[0] != '\0') return -EINVAL;
+
+    conn->params.auto_pkt_size = aps;
+    gu_config_set_bool (conn->config, GCS_PARAMS_AUTO_PKT_SIZE, aps);
+
+    return 0;
+}
+
+static long
+_set_sm_small_size (gcs_conn_t* conn, const char* value)
+{
+    long long sz;
+    const char* const endptr = gu_str2ll (value, &sz);
+
+    if (sz >= 0 && sz <= LONG_MAX && *endptr == '\0') {
+
+        gu_config_set_int64 (conn->config, GCS_PARAMS_SM_SMALL_SIZE, sz);
+        conn->params.sm_small_size = sz;
+
+        return 0;
+    }
+    else {
+        return -EINVAL;
+    }
+}
+
+static long
+_set_sm_budget (gcs_conn_t* conn, const char* value)
+{
+    long long b;
+    const char* const endptr = gu_str2ll (value, &b);
+
+    if (b >= 0 && b <= LONG_MAX && *endptr == '\0') {
+
+        gu_config_set_int64 (conn->config, GCS_PARAMS_SM_BUDGET, b);
+        conn->params.sm_budget = b;
+        gcs_sm_set_budget (conn->sm, b);
+
+        return 0;
+    }
+    else {
+        return -EINVAL;
+    }
+}
+
 static long
 _set_pkt_size (gcs_conn_t* conn, const char* value)
 {
@@ -2263,12 +2603,27 @@ long gcs_param_set  (gcs_conn_t* conn, const char* key, const char *value)
     else if (!strcmp (key, GCS_PARAMS_FC_DEBUG)) {
         return _set_fc_debug (conn, value);
     }
+    else if (!strcmp (key, GCS_PARAMS_FC_MODE)) {
+        return _set_fc_mode (conn, value);
+    }
+    else if (!strcmp (key, GCS_PARAMS_FC_UNITS)) {
+        return _set_fc_units (conn, value);
+    }
     else if (!strcmp (key, GCS_PARAMS_SYNC_DONOR)) {
         return _set_sync_donor (conn, value);
     }
     else if (!strcmp (key, GCS_PARAMS_MAX_PKT_SIZE)) {
         return _set_pkt_size (conn, value);
     }
+    else if (!strcmp (key, GCS_PARAMS_AUTO_PKT_SIZE)) {
+        return _set_auto_pkt_size (conn, value);
+    }
+    else if (!strcmp (key, GCS_PARAMS_SM_SMALL_SIZE)) {
+        return _set_sm_small_size (conn, value);
+    }
+    else if (!strcmp (key, GCS_PARAMS_SM_BUDGET)) {
+        return _set_sm_budget (conn, value);
+    }
     else if (!strcmp (key, GCS_PARAMS_RECV_Q_HARD_LIMIT)) {
         return _set_recv_q_hard_limit (conn, value);
     }
@@ -35,7 +35,8 @@ static const gcs_seqno_t GCS_SEQNO_NIL   =  0;
 static const gcs_seqno_t GCS_SEQNO_FIRST =  1;
 /*! @def @brief history UUID length */
 #define GCS_UUID_LEN 16
-/*! @def @brief maximum supported size of an action (2GB - 1) */
+/*! @def @brief maximum supported size of an action (2GB - 1)
+ *  Matches WriteSetNG::MAX_SIZE, so raising it alone gains nothing. */
 #define GCS_MAX_ACT_SIZE 0x7FFFFFFF
 
 /*! Connection handle type */
@@ -210,13 +211,20 @@ struct gcs_action {
  * @param act_in    action buffer vector (total size is passed in action)
  * @param action    action struct
  * @param scheduled whether the call was preceded by gcs_schedule()
+ * @param cached    act_in is a single buffer allocated in gcache. Then upon
+ *                  delivery action->buf points to that buffer (no copy is
+ *                  made). On error it stays with the caller.
+ * @param bulk      send action in the large send monitor class regardless
+ *                  of its size, so that it yields to small actions
  * @return          negative error code, action size in case of success
  * @retval -EINTR:  thread was interrupted while waiting to enter the monitor
  */
 extern long gcs_replv (gcs_conn_t*          conn,
                        const struct gu_buf* act_in,
                        struct gcs_action*   action,
-                       bool                 scheduled);
+                       bool                 scheduled,
+                       bool                 cached,
+                       bool                 bulk);
 
 /*! A wrapper for single buffer communication */
 static inline long gcs_repl (gcs_conn_t*        const conn,
@@ -224,7 +232,7 @@ static inline long gcs_repl (gcs_conn_t*        const conn,
                              bool               const scheduled)
 {
     struct gu_buf const buf = { action->buf, action->size };
-    return gcs_replv (conn, &buf, action, scheduled);
+    return gcs_replv (conn, &buf, action, scheduled, false, false);
 }
 
 /*! @brief Receives an action from group.
@@ -244,6 +252,12 @@ static inline long gcs_repl (gcs_conn_t*        const conn,
 extern long gcs_recv (gcs_conn_t*        conn,
                       struct gcs_action* action);
 
+#ifdef GCS_FOR_GARB
+/*! Arbitrator without gcache receives only every Nth ordered action, with
+ *  global seqno a multiple of N, to report it as last applied. */
+#define GCS_ARBITRATOR_REPORT_INTERVAL 128
+#endif /* GCS_FOR_GARB */
+
 /*!
  * @brief Schedules entry to CGS send monitor.
  * Locks send monitor and should be quickly followed by gcs_repl()/gcs_send()
@@ -295,6 +309,8 @@ extern gcs_seqno_t gcs_caused(gcs_conn_t* conn);
  * @param size  request size
  * @param donor desired state transfer donor name. Supply empty string to
  *              choose automatically.
+ * @param ist_donors maximum number of donors to split IST between
+ *              (STR version 3 and above), see gcs_state_req_split()
  * @param seqno response to request was ordered with this seqno.
  *              Must be skipped in local queues.
  * @return negative error code, index of state transfer donor in case of success
@@ -308,8 +324,26 @@ extern long gcs_request_state_transfer (gcs_conn_t  *conn,
                                         const char  *donor,
                                         const gu_uuid_t* ist_uuid,
                                         gcs_seqno_t ist_seqno,
+                                        int          ist_donors,
                                         gcs_seqno_t *seqno);
 
+/*! @brief Checks if state request is a share of a split IST
+ * When the joiner allows it, IST is split between the donor and other synced
+ * members which have the requested history in cache. Each of them receives
+ * the state request with a header that tells its rank among the donors.
+ * Rank 0 is the state transfer donor, the rest are IST helpers: their
+ * request is delivered with GCS_SEQNO_ILL global seqno and they must not
+ * join. Donor of rank r sends every write set that is r write sets away from
+ * the first one modulo the number of donors.
+ *
+ * @param req     state request, header is skipped if present
+ * @param req_len request length, adjusted accordingly
+ * @param rank    rank of this node among the donors
+ * @return number of donors, 1 if IST is not split
+ */
+extern int gcs_state_req_split (const void** req, ssize_t* req_len,
+                                int* rank);
+
 /*! @brief Turns off flow control on the node.
  * Effectively desynchronizes the node from the cluster (while the node keeps on
  * receiving all the actions). Requires gcs_join() to return to normal.
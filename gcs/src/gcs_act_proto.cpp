@@ -98,8 +98,8 @@ gcs_act_proto_read (gcs_act_frag_t* frag, const void* buf, size_t buf_len)
         return -EPROTO; // this fragment should be dropped
     }
 
-    ((uint8_t*)buf)[PROTO_PV_OFFSET] = 0x0;
-    frag->act_id   = gu_be64(*(uint64_t*)buf);
+    /* buf may be lent by the backend, so mask PV out instead of zeroing it */
+    frag->act_id   = gu_be64(*(const uint64_t*)buf) & 0x00FFFFFFFFFFFFFFULL;
     frag->act_size = gtohl  (((uint32_t*)buf)[2]);
     frag->frag_no  = gtohl  (((uint32_t*)buf)[3]);
     frag->act_type = static_cast<gcs_act_type_t>(
@@ -93,6 +93,11 @@ long fn (gcs_backend_t* const backend,    \
  *        OR
  *        the length of the message, so if it is bigger
  *        than len, it has to be reread with a bigger buffer
+ *
+ * Instead of copying a message into the supplied buffer the backend may
+ * point msg->buf (and msg->buf_len) to its own read-only memory which stays
+ * valid until the next recv call. The caller must restore its buffer
+ * before that call.
  */
 #define GCS_BACKEND_RECV_FN(fn)                 \
 long fn (gcs_backend_t*  const backend,         \
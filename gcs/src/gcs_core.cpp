@@ -21,6 +21,7 @@
 #include "gcs_gcache.hpp"
 
 #include "gu_debug_sync.hpp"
+#include "gu_utils.hpp" // gu::from_string()
 
 #include <string.h> // for mempcpy
 #include <errno.h>
@@ -64,14 +65,25 @@ struct gcs_core
 
     void*           send_buf;
     size_t          send_buf_len;
+    int             send_buf_next; // msg size for the next action, 0 - keep
     gcs_seqno_t     send_act_no;
 
     /* recv part */
     gcs_recv_msg_t  recv_msg;
+    void*           recv_buf;     // recv_msg.buf may be lent by backend,
+    int             recv_buf_len; // this is the one we own
 
     /* local action FIFO */
     gcs_fifo_lite_t* fifo;
 
+    /* concurrent gcs_core_caused() callers share causal messages */
+    gu_mutex_t      causal_lock;
+    gu_cond_t       causal_cond;
+    long long       causal_next;   // request generation new callers join
+    long long       causal_done;   // last completed request generation
+    gcs_seqno_t     causal_seqno;  // result of causal_done
+    bool            causal_sending;// request of causal_next-1 is in flight
+
     /* group context */
     gcs_group_t     group;
 
@@ -91,6 +103,7 @@ typedef struct core_act
     gcs_seqno_t sent_act_id;
     const void* action;
     size_t      action_size;
+    bool        cached;
 }
 core_act_t;
 
@@ -121,10 +134,12 @@ gcs_core_create (gu_config_t* const conf,
         core->cache  = cache;
 
         // Need to allocate something, otherwise Spread 3.17.3 freaks out.
-        core->recv_msg.buf = gu_malloc(CORE_INIT_BUF_SIZE);
-        if (core->recv_msg.buf) {
+        core->recv_buf = gu_malloc(CORE_INIT_BUF_SIZE);
+        if (core->recv_buf) {
 
-            core->recv_msg.buf_len = CORE_INIT_BUF_SIZE;
+            core->recv_buf_len     = CORE_INIT_BUF_SIZE;
+            core->recv_msg.buf     = core->recv_buf;
+            core->recv_msg.buf_len = core->recv_buf_len;
 
             core->send_buf = GU_CALLOC(CORE_INIT_BUF_SIZE, char);
             if (core->send_buf) {
@@ -135,6 +150,12 @@ gcs_core_create (gu_config_t* const conf,
                                                    sizeof (core_act_t));
                 if (core->fifo) {
                     gu_mutex_init  (&core->send_lock, NULL);
+                    gu_mutex_init  (&core->causal_lock, NULL);
+                    gu_cond_init   (&core->causal_cond, NULL);
+                    core->causal_next    = 1;
+                    core->causal_done    = 0;
+                    core->causal_seqno   = GCS_SEQNO_ILL;
+                    core->causal_sending = false;
                     core->proto_ver = -1; // shall be bumped in gcs_group_act_conf()
                     gcs_group_init (&core->group, cache, node_name, inc_addr,
                                     GCS_PROTO_MAX, repl_proto_ver,
@@ -151,7 +172,7 @@ gcs_core_create (gu_config_t* const conf,
                 gu_free (core->send_buf);
             }
 
-            gu_free (core->recv_msg.buf);
+            gu_free (core->recv_buf);
         }
 
         gu_free (core);
@@ -299,11 +320,81 @@ core_msg_send_retry (gcs_core_t*    core,
     return ret;
 }
 
+/* Returns message size resulting from the requested packet size */
+static int
+core_msg_size (gcs_core_t* core, int const pkt_size, int const hdr_size)
+{
+    int const min_msg_size(hdr_size + 1);
+
+    int msg_size(core->backend.msg_size(&core->backend, pkt_size));
+    if (msg_size < min_msg_size) {
+        gu_warn ("Requested packet size %d is too small, "
+                 "using smallest possible: %d",
+                 pkt_size, pkt_size + (min_msg_size - msg_size));
+        msg_size = min_msg_size;
+    }
+
+    /* even if backend may not support limiting packet size force max message
+     * size at this level */
+    msg_size = std::min(std::max(min_msg_size, pkt_size), msg_size);
+
+    gu_info ("Changing maximum packet size to %d, resulting msg size: %d",
+             pkt_size, msg_size);
+
+    return msg_size;
+}
+
+/* Must be called with send_lock held */
+static int
+core_resize_send_buf (gcs_core_t* core, int const msg_size, int const hdr_size)
+{
+    int ret(msg_size - hdr_size); // message payload
+    assert(ret > 0);
+
+    if (core->send_buf_len == (size_t)msg_size) return ret;
+
+    if (core->state != CORE_DESTROYED) {
+        void* new_send_buf(gu_realloc(core->send_buf, msg_size));
+        if (new_send_buf) {
+            core->send_buf     = new_send_buf;
+            core->send_buf_len = msg_size;
+            memset (core->send_buf, 0, hdr_size); // to pacify valgrind
+            gu_debug ("Message payload (action fragment size): %d", ret);
+        }
+        else {
+            ret = -ENOMEM;
+        }
+    }
+    else {
+        ret =  -EBADFD;
+    }
+
+    return ret;
+}
+
+/* Applies send buffer size set by gcs_core_tune_pkt_size(). In between
+ * gcs_core_send() calls (serialized by the caller) send_buf is not in use. */
+static inline bool
+core_send_buf_resize_pending (gcs_core_t* core, int const hdr_size)
+{
+    bool err(false);
+
+    if (gu_mutex_lock (&core->send_lock)) abort();
+    if (gu_unlikely(core->send_buf_next > 0)) {
+        err = core_resize_send_buf (core, core->send_buf_next, hdr_size) < 0;
+        core->send_buf_next = 0;
+    }
+    gu_mutex_unlock (&core->send_lock);
+
+    return err;
+}
+
 ssize_t
 gcs_core_send (gcs_core_t*          const conn,
                const struct gu_buf* const action,
                size_t                     act_size,
-               gcs_act_type_t       const act_type)
+               gcs_act_type_t       const act_type,
+               bool                 const cached)
 {
     ssize_t        ret  = 0;
     ssize_t        sent = 0;
@@ -316,6 +407,7 @@ gcs_core_send (gcs_core_t*          const conn,
 
     assert (action != NULL);
     assert (act_size > 0);
+    assert (!cached || (size_t)action[0].size == act_size);
 
     /*
      * Action header will be replicated with every message.
@@ -330,11 +422,15 @@ gcs_core_send (gcs_core_t*          const conn,
     frg.frag_no   = 0;
     frg.proto_ver = proto_ver;
 
+    if (gu_unlikely(core_send_buf_resize_pending (conn, hdr_size)))
+        return -ENOMEM;
+
     if ((ret = gcs_act_proto_write (&frg, conn->send_buf, conn->send_buf_len)))
         return ret;
 
     if ((local_act = (core_act_t*)gcs_fifo_lite_get_tail (conn->fifo))) {
-        *local_act = (core_act_t){ conn->send_act_no, action, act_size };
+        *local_act = (core_act_t){ conn->send_act_no, action, act_size,
+                                   cached };
         gcs_fifo_lite_push_tail (conn->fifo);
     }
     else {
@@ -460,24 +556,31 @@ out:
  * Deals with fetching complete message from backend
  * and reallocates recv buf if needed */
 static inline long
-core_msg_recv (gcs_backend_t* backend, gcs_recv_msg_t* recv_msg,
-               long long timeout)
+core_msg_recv (gcs_core_t* core, long long timeout)
 {
+    gcs_backend_t*  const backend  = &core->backend;
+    gcs_recv_msg_t* const recv_msg = &core->recv_msg;
     long ret;
 
+    /* previous message memory might have been lent by backend */
+    recv_msg->buf     = core->recv_buf;
+    recv_msg->buf_len = core->recv_buf_len;
+
     ret = backend->recv (backend, recv_msg, timeout);
 
     while (gu_unlikely(ret > recv_msg->buf_len)) {
         /* recv_buf too small, reallocate */
         /* sometimes - like in case of component message, we may need to
          * do reallocation 2 times. This should be fixed in backend */
-        void* msg = gu_realloc (recv_msg->buf, ret);
+        void* msg = gu_realloc (core->recv_buf, ret);
         gu_debug ("Reallocating buffer from %d to %d bytes",
-                  recv_msg->buf_len, ret);
+                  core->recv_buf_len, ret);
         if (msg) {
             /* try again */
-            recv_msg->buf     = msg;
-            recv_msg->buf_len = ret;
+            core->recv_buf     = msg;
+            core->recv_buf_len = ret;
+            recv_msg->buf      = msg;
+            recv_msg->buf_len  = ret;
 
             ret = backend->recv (backend, recv_msg, timeout);
 
@@ -499,6 +602,30 @@ core_msg_recv (gcs_backend_t* backend, gcs_recv_msg_t* recv_msg,
     return ret;
 }
 
+/*!
+ * Own actions are received in the order they were sent, so the FIFO head
+ * describes the action that starts with frg. If it was sent from a gcache
+ * buffer, let it be received right there.
+ */
+static inline void
+core_set_local_preset (gcs_core_t* core, const gcs_act_frag_t* frg)
+{
+    const void* buf = NULL;
+    core_act_t* const local_act =
+        (core_act_t*)gcs_fifo_lite_get_head (core->fifo);
+
+    if (local_act) {
+        if (local_act->cached                       &&
+            local_act->sent_act_id == frg->act_id   &&
+            local_act->action_size == (size_t)frg->act_size) {
+            buf = ((const struct gu_buf*)local_act->action)->ptr;
+        }
+        gcs_fifo_lite_release (core->fifo);
+    }
+
+    gcs_group_set_local_preset (&core->group, buf);
+}
+
 /*!
  * Helper for gcs_core_recv(). Handles GCS_MSG_ACTION.
  *
@@ -544,6 +671,12 @@ core_handle_act_msg (gcs_core_t*          core,
             return -ENOTRECOVERABLE;
         }
 
+#ifndef GCS_FOR_GARB
+        if (my_msg && 0 == frg.frag_no && GCS_ACT_SERVICE != frg.act_type) {
+            core_set_local_preset (core, &frg);
+        }
+#endif
+
         ret = gcs_group_handle_act_msg (group, &frg, msg, act,
                                         commonly_supported_version);
 
@@ -552,7 +685,7 @@ core_handle_act_msg (gcs_core_t*          core,
 #ifndef GCS_FOR_GARB
             assert (NULL != act->act.buf);
 #else
-            assert (NULL == act->act.buf);
+            assert ((NULL != act->act.buf) == (NULL != core->cache));
 #endif
             act->sender_idx = msg->sender_idx;
 
@@ -609,20 +742,27 @@ core_handle_act_msg (gcs_core_t*          core,
                             // act->id != GCS_SEQNO_ILL (most likely act->id == -EAGAIN)
                             core->state == CORE_PRIMARY)) {
 #ifdef GCS_FOR_GARB
-            /* ignoring state requests from other nodes (not allocated) */
-            if (my_msg) {
-                if (act->act.buf_len != act->local[0].size) {
-                    gu_fatal ("Protocol violation: state request is fragmented."
-                              " Aborting.");
-                    abort();
+            /* ignoring state requests from other nodes (not allocated),
+             * unless actions are stored in cache to donate IST from */
+            bool const stored(NULL != core->cache);
+            if (stored || my_msg) {
+                if (!stored) {
+                    if (act->act.buf_len != act->local[0].size) {
+                        gu_fatal ("Protocol violation: state request is "
+                                  "fragmented. Aborting.");
+                        abort();
+                    }
+                    act->act.buf = act->local[0].ptr;
                 }
-                act->act.buf = act->local[0].ptr;
 #endif
                 ret = gcs_group_handle_state_request (group, act);
                 assert (ret <= 0 || ret == act->act.buf_len);
 #ifdef GCS_FOR_GARB
-                if (ret < 0) gu_fatal ("Handling state request failed: %d",ret);
-                act->act.buf = NULL;
+                if (!stored) {
+                    if (ret < 0) gu_fatal ("Handling state request failed: %d",
+                                           ret);
+                    act->act.buf = NULL;
+                }
             }
             else {
                 act->act.buf_len = 0;
@@ -971,6 +1111,7 @@ core_msg_to_action (gcs_core_t*          core,
 
         switch (msg->type) {
         case GCS_MSG_FLOW: // most frequent
+            gcs_group_handle_flow_msg (group, msg);
             ret = 1;
             act_type = GCS_ACT_FLOW;
             break;
@@ -1070,7 +1211,7 @@ ssize_t gcs_core_recv (gcs_core_t*          conn,
         assert (recv_act->id          == GCS_SEQNO_ILL);
         assert (recv_act->sender_idx  == -1);
 
-        ret = core_msg_recv (&conn->backend, recv_msg, timeout);
+        ret = core_msg_recv (conn, timeout);
         if (gu_unlikely (ret <= 0)) {
             goto out; /* backend error while receiving message */
         }
@@ -1197,6 +1338,8 @@ long gcs_core_destroy (gcs_core_t* core)
 
     /* after that we must be able to destroy mutexes */
     while (gu_mutex_destroy (&core->send_lock));
+    gu_cond_destroy  (&core->causal_cond);
+    gu_mutex_destroy (&core->causal_lock);
     /* now noone will interfere */
     while ((tmp = (core_act_t*)gcs_fifo_lite_get_head (core->fifo))) {
         // whatever is in tmp.action is allocated by app., just forget it.
@@ -1206,7 +1349,7 @@ long gcs_core_destroy (gcs_core_t* core)
     gcs_group_free (&core->group);
 
     /* free buffers */
-    gu_free (core->recv_msg.buf);
+    gu_free (core->recv_buf);
     gu_free (core->send_buf);
 
 #ifdef GCS_CORE_TESTING
@@ -1235,49 +1378,81 @@ gcs_core_set_pkt_size (gcs_core_t* core, int const pkt_size)
     int const hdr_size(gcs_act_proto_hdr_size(core->proto_ver));
     if (hdr_size < 0) return hdr_size;
 
-    int const min_msg_size(hdr_size + 1);
+    int const msg_size(core_msg_size(core, pkt_size, hdr_size));
 
-    int msg_size(core->backend.msg_size(&core->backend, pkt_size));
-    if (msg_size < min_msg_size) {
-        gu_warn ("Requested packet size %d is too small, "
-                 "using smallest possible: %d",
-                 pkt_size, pkt_size + (min_msg_size - msg_size));
-        msg_size = min_msg_size;
+    if (core->send_buf_len == (size_t)msg_size) return msg_size - hdr_size;
+
+    int ret;
+
+    if (gu_mutex_lock (&core->send_lock)) abort();
+    {
+        ret = core_resize_send_buf(core, msg_size, hdr_size);
+        core->send_buf_next = 0;
     }
+    gu_mutex_unlock (&core->send_lock);
 
-    /* even if backend may not support limiting packet size force max message
-     * size at this level */
-    msg_size = std::min(std::max(min_msg_size, pkt_size), msg_size);
+    return ret;
+}
 
-    gu_info ("Changing maximum packet size to %d, resulting msg size: %d",
-             pkt_size, msg_size);
+/* Packet size tuning parameters: a packet on a low latency path spans
+ * CORE_PKT_MIN_SEGS segments and grows by as much with every
+ * CORE_PKT_RTT_STEP microseconds of RTT. CORE_PKT_HDR_ALLOWANCE is left
+ * for the backend headers to keep the packet within whole segments. */
+static long long const CORE_PKT_MIN_SEGS      = 4;
+static long long const CORE_PKT_RTT_STEP      = 1000;
+static long long const CORE_PKT_HDR_ALLOWANCE = 128;
 
-    int ret(msg_size - hdr_size); // message payload
-    assert(ret > 0);
+int
+gcs_core_tune_pkt_size (gcs_core_t* core, int const max_pkt_size)
+{
+    if (core->state >= CORE_CLOSED) return -EBADFD;
 
-    if (core->send_buf_len == (size_t)msg_size) return ret;
+    long long mss(0);
+    long long rtt(-1);
 
-    if (gu_mutex_lock (&core->send_lock)) abort();
+    try
     {
-        if (core->state != CORE_DESTROYED) {
-            void* new_send_buf(gu_realloc(core->send_buf, msg_size));
-            if (new_send_buf) {
-                core->send_buf     = new_send_buf;
-                core->send_buf_len = msg_size;
-                memset (core->send_buf, 0, hdr_size); // to pacify valgrind
-                gu_debug ("Message payload (action fragment size): %d", ret);
-            }
-            else {
-                ret = -ENOMEM;
-            }
-        }
-        else {
-            ret =  -EBADFD;
+        gu::Status status;
+        core->backend.status_get(&core->backend, status);
+
+        for (gu::Status::const_iterator i(status.begin()); i != status.end();
+             ++i)
+        {
+            if (i->first == "gmcast_path_mss")
+                mss = gu::from_string<long long>(i->second);
+            else if (i->first == "gmcast_path_rtt")
+                rtt = gu::from_string<long long>(i->second);
         }
     }
+    catch (gu::Exception& e)
+    {
+        return -e.get_errno();
+    }
+
+    if (mss <= 0 || rtt < 0) return -ENODATA; // not known to backend
+
+    long long const segs(CORE_PKT_MIN_SEGS * (1 + rtt / CORE_PKT_RTT_STEP));
+    long long const pkt_size(std::min<long long>(max_pkt_size,
+                                                 segs * mss -
+                                                 CORE_PKT_HDR_ALLOWANCE));
+
+    gu_info ("Path MSS: %lld, RTT: %lld us, packet size: %lld",
+             mss, rtt, pkt_size);
+
+    int const hdr_size(gcs_act_proto_hdr_size(core->proto_ver));
+    if (hdr_size < 0) return hdr_size;
+
+    int const msg_size(core_msg_size(core, pkt_size, hdr_size));
+
+    /* gcs_core_send() may be halfway through an action using send_buf,
+     * so the new size is applied by the next gcs_core_send() */
+    if (gu_mutex_lock (&core->send_lock)) abort();
+    {
+        core->send_buf_next = msg_size;
+    }
     gu_mutex_unlock (&core->send_lock);
 
-    return ret;
+    return msg_size - hdr_size;
 }
 
 static inline long
@@ -1324,8 +1499,8 @@ gcs_core_send_fc (gcs_core_t* core, const void* fc, size_t fc_size)
     return ret;
 }
 
-gcs_seqno_t
-gcs_core_caused(gcs_core_t* core)
+static gcs_seqno_t
+core_caused_send(gcs_core_t* core)
 {
     long         ret;
     gcs_seqno_t  act_id = GCS_SEQNO_ILL;
@@ -1356,6 +1531,48 @@ gcs_core_caused(gcs_core_t* core)
     return act_id;
 }
 
+/* A caller can use the result of any causal message sent after it arrived.
+ * So callers arriving while a message is in flight wait for it to return
+ * and then one of them sends the next message for all of them: there is at
+ * most one causal message outstanding no matter how many callers. */
+gcs_seqno_t
+gcs_core_caused(gcs_core_t* core)
+{
+    gcs_seqno_t ret;
+
+    gu_mutex_lock (&core->causal_lock);
+
+    long long const gen(core->causal_next);
+
+    while (core->causal_done < gen) {
+
+        if (!core->causal_sending) {
+            assert (core->causal_next == gen);
+
+            core->causal_sending = true;
+            core->causal_next++;
+            gu_mutex_unlock (&core->causal_lock);
+
+            ret = core_caused_send (core);
+
+            gu_mutex_lock (&core->causal_lock);
+            core->causal_sending = false;
+            core->causal_done    = gen;
+            core->causal_seqno   = ret;
+            gu_cond_broadcast (&core->causal_cond);
+            break;
+        }
+
+        gu_cond_wait (&core->causal_cond, &core->causal_lock);
+    }
+
+    ret = core->causal_seqno;
+
+    gu_mutex_unlock (&core->causal_lock);
+
+    return ret;
+}
+
 long
 gcs_core_param_set (gcs_core_t* core, const char* key, const char* value)
 {
@@ -98,12 +98,16 @@ gcs_core_destroy (gcs_core_t* conn);
  *
  * NOTE: Successful return code here does not guarantee delivery to group.
  *       The real status of action is determined only in gcs_core_recv() call.
+ *
+ * If cached is true, act is a single buffer allocated in gcache. Then it is
+ * returned by gcs_core_recv() in place of a copy of the received action.
  */
 extern ssize_t
 gcs_core_send (gcs_core_t*          core,
                const struct gu_buf* act,
                size_t               act_size,
-               gcs_act_type_t       act_type);
+               gcs_act_type_t       act_type,
+               bool                 cached);
 
 /*
  * gcs_core_recv() blocks until some action is received from group.
@@ -138,6 +142,13 @@ gcs_core_group_protocol_version (const gcs_core_t* conn);
 extern int
 gcs_core_set_pkt_size (gcs_core_t* conn, int pkt_size);
 
+/* Picks packet size from the backend path MSS and RTT, bounded by
+ * max_pkt_size. The new size takes effect with the next action sent.
+ * Returns resulting message payload size or negative error code,
+ * -ENODATA if backend does not know path properties. */
+extern int
+gcs_core_tune_pkt_size (gcs_core_t* conn, int max_pkt_size);
+
 /* sends this node's last applied value to group */
 extern long
 gcs_core_set_last_applied (gcs_core_t* core, gcs_seqno_t seqno);
@@ -23,6 +23,22 @@
         }                                                       \
     } while (0)
 
+/* Local action may come in a buffer preallocated by the sender,
+ * see gcs_defrag_set_preset() */
+#define DF_ALLOC_PRESET()                                       \
+    do {                                                        \
+        if (local && df->preset != NULL) {                      \
+            df->head   = df->preset;                            \
+            df->tail   = df->head;                              \
+            df->cached = true;                                  \
+        }                                                       \
+        else {                                                  \
+            df->cached = false;                                 \
+            DF_ALLOC();                                         \
+        }                                                       \
+        df->preset = NULL;                                      \
+    } while (0)
+
 /*!
  * Handle action fragment
  *
@@ -65,20 +81,25 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
                 df->tail     = df->head;
                 df->reset    = false;
 
-                if (df->size != frg->act_size) {
+                /* preset buffer of the aborted action could have been
+                 * already released by the sender, never reuse it */
+                if (df->size != frg->act_size || df->cached || df->preset) {
 
                     df->size = frg->act_size;
 
-#ifndef GCS_FOR_GARB
-                    if (df->cache !=NULL) {
-                        gcache_free (df->cache, df->head);
-                    }
-                    else {
-                        free ((void*)df->head);
+                    if (gcs_defrag_stores(df)) {
+                        if (df->cached) {
+                            /* belongs to sender, nothing to free */
+                        }
+                        else if (df->cache !=NULL) {
+                            gcache_free (df->cache, df->head);
+                        }
+                        else {
+                            free ((void*)df->head);
+                        }
+
+                        DF_ALLOC_PRESET();
                     }
-
-                    DF_ALLOC();
-#endif /* GCS_FOR_GARB */
                 }
             }
             else if (frg->act_id == df->sent_id && frg->frag_no < df->frag_no) {
@@ -109,13 +130,14 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
             df->sent_id = frg->act_id;
             df->reset   = false;
 
-#ifndef GCS_FOR_GARB
-            DF_ALLOC();
-#else
-            /* we don't store actions locally at all */
-            df->head = NULL;
-            df->tail = df->head;
-#endif
+            if (gu_likely(gcs_defrag_stores(df))) {
+                DF_ALLOC_PRESET();
+            }
+            else {
+                /* we don't store actions locally at all */
+                df->head = NULL;
+                df->tail = df->head;
+            }
         }
         else {
             /* not a first fragment */
@@ -127,12 +149,12 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
                 return 0;
             }
             else {
-                ((char*)frg->frag)[frg->frag_len - 1] = '\0';
                 gu_error ("Unordered fragment received. Protocol error.");
                 gu_error ("Expected: any:0(first), received: %lld:%ld",
                           frg->act_id, frg->frag_no);
-                gu_error ("Contents: '%s', local: %s, reset: %s",
-                          (char*)frg->frag, local ? "yes" : "no",
+                gu_error ("Contents: '%.*s', local: %s, reset: %s",
+                          (int)frg->frag_len, (const char*)frg->frag,
+                          local ? "yes" : "no",
                           df->reset ? "yes" : "no");
                 assert(0);
                 return -EPROTO;
@@ -143,15 +165,19 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
     df->received += frg->frag_len;
     assert (df->received <= df->size);
 
-#ifndef GCS_FOR_GARB
-    assert (df->tail);
-    memcpy (df->tail, frg->frag, frg->frag_len);
-    df->tail += frg->frag_len;
-#else
-    /* we skip memcpy since have not allocated any buffer */
-    assert (NULL == df->tail);
-    assert (NULL == df->head);
-#endif
+    if (gu_likely(gcs_defrag_stores(df))) {
+        assert (df->tail);
+        if (gu_likely(!df->cached)) {
+            memcpy (df->tail, frg->frag, frg->frag_len);
+        }
+        /* else sender has put the action there already */
+        df->tail += frg->frag_len;
+    }
+    else {
+        /* we skip memcpy since have not allocated any buffer */
+        assert (NULL == df->tail);
+        assert (NULL == df->head);
+    }
 
 #if 1
     if (df->received == df->size) {
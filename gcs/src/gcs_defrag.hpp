@@ -28,10 +28,25 @@ typedef struct gcs_defrag
     size_t         size;
     size_t         received;
     ulong          frag_no; // number of fragment received
+    uint8_t*       preset;  // buffer preallocated by sender for next action
     bool           reset;
+    bool           cached;  // head is a preset buffer, owned by sender
 }
 gcs_defrag_t;
 
+/*! Arbitrator does not store actions unless it has a cache to donate IST
+ *  from, in which case it handles them like a regular node */
+static inline bool
+gcs_defrag_stores (const gcs_defrag_t* df)
+{
+#ifdef GCS_FOR_GARB
+    return (df->cache != NULL);
+#else
+    (void)df;
+    return true;
+#endif
+}
+
 static inline void
 gcs_defrag_init (gcs_defrag_t* df, gcache_t* cache)
 {
@@ -53,6 +68,18 @@ gcs_defrag_handle_frag (gcs_defrag_t*         df,
                         struct gcs_act*       act,
                         bool                  local);
 
+/*!
+ * Make next local action to be received into buffer preallocated in gcache
+ * which already holds the whole action (or NULL to allocate as usual).
+ * Fragments are then only accounted, not copied, and the buffer is returned
+ * as is. It remains owned by the sender until the action is delivered.
+ */
+static inline void
+gcs_defrag_set_preset (gcs_defrag_t* df, const void* buf)
+{
+    df->preset = static_cast<uint8_t*>(const_cast<void*>(buf));
+}
+
 /*! Deassociate, but don't deallocate action resources */
 static inline void
 gcs_defrag_forget (gcs_defrag_t* df)
@@ -64,14 +91,12 @@ gcs_defrag_forget (gcs_defrag_t* df)
 static inline void
 gcs_defrag_free (gcs_defrag_t* df)
 {
-#ifndef GCS_FOR_GARB
-    if (df->head) {
+    assert (gcs_defrag_stores(df) || NULL == df->head);
+
+    if (df->head && !df->cached) {
         gcs_gcache_free (df->cache, df->head);
         // df->head, df->tail will be zeroed in gcs_defrag_init() below
     }
-#else
-    assert(NULL == df->head);
-#endif
 
     gcs_defrag_init (df, df->cache);
 }
@@ -11,6 +11,7 @@
 
 #include <galerautils.h>
 #include <string.h>
+#include <strings.h> // strcasecmp()
 
 double const gcs_fc_hard_limit_fix = 0.9; //! allow for some overhead
 
@@ -204,3 +205,163 @@ gcs_fc_process (gcs_fc_t* fc, ssize_t act_size)
 }
 
 void gcs_fc_debug (gcs_fc_t* fc, long debug_level) { fc->debug = debug_level; }
+
+static const char* const fc_mode_str[] = { "limit", "rate", "coord" };
+
+const char*
+gcs_fc_mode_str (gcs_fc_mode_t const mode)
+{
+    assert (mode >= GCS_FC_MODE_LIMIT && mode <= GCS_FC_MODE_COORD);
+    return fc_mode_str[mode];
+}
+
+int
+gcs_fc_mode_parse (const char* const str, gcs_fc_mode_t* const mode)
+{
+    for (int m = GCS_FC_MODE_LIMIT; m <= GCS_FC_MODE_COORD; ++m)
+    {
+        if (!strcasecmp (str, fc_mode_str[m]))
+        {
+            *mode = gcs_fc_mode_t(m);
+            return 0;
+        }
+    }
+
+    return -EINVAL;
+}
+
+static const char* const fc_units_str[] = { "actions", "bytes" };
+
+const char*
+gcs_fc_units_str (gcs_fc_units_t const units)
+{
+    assert (units >= GCS_FC_UNITS_ACTIONS && units <= GCS_FC_UNITS_BYTES);
+    return fc_units_str[units];
+}
+
+int
+gcs_fc_units_parse (const char* const str, gcs_fc_units_t* const units)
+{
+    for (int u = GCS_FC_UNITS_ACTIONS; u <= GCS_FC_UNITS_BYTES; ++u)
+    {
+        if (!strcasecmp (str, fc_units_str[u]))
+        {
+            *units = gcs_fc_units_t(u);
+            return 0;
+        }
+    }
+
+    return -EINVAL;
+}
+
+static double const fcr_sample   = 0.01; //! rate sampling period (s)
+static double const fcr_smooth   = 0.1;  //! rate smoothing time constant (s)
+static double const fcr_horizon  = 0.05; //! how far ahead to project (s)
+static double const fcr_integral = 1.0;  //! integral time constant (s)
+
+void
+gcs_fcr_reset (gcs_fcr_t* const fc, double const target)
+{
+    assert (fc != NULL);
+    assert (target >= 0.0);
+
+    memset (fc, 0, sizeof(*fc));
+
+    fc->target = target;
+    fc->start  = gu_time_monotonic();
+}
+
+/*
+ * This is a PID controller over slave queue length error
+ *
+ *     e = queue_len - target
+ *
+ * where the derivative term is not computed from consecutive samples of e
+ * (which are too noisy with sporadic appliers), but as the difference of
+ * smoothed incoming and drain rates. Proportional and derivative terms
+ * together give the queue length projected fcr_horizon seconds ahead, so
+ * FC_STOP goes out before the queue overshoots the target, accounting for
+ * actions that are already on their way, and FC_CONT goes out before
+ * appliers run dry. Integral term compensates for systematic bias, e.g.
+ * when pause takes longer than fcr_horizon to take effect. It is clamped
+ * so that it can't move the target by more than its own value.
+ */
+double
+gcs_fcr_account (gcs_fcr_t* const fc, long const queue_len, bool const in,
+                 long const units)
+{
+    fc->in  += in  ? units : 0;
+    fc->out += !in ? units : 0;
+
+    long long const now = gu_time_monotonic();
+    double const interval = (now - fc->start) * 1.0e-9;
+    double const error = queue_len - fc->target;
+
+    if (interval >= fcr_sample)
+    {
+        double const a = interval / (interval + fcr_smooth);
+
+        fc->in_rate  += a * (fc->in  / interval - fc->in_rate);
+        fc->out_rate += a * (fc->out / interval - fc->out_rate);
+
+        double const max_integral = fc->target * fcr_integral;
+
+        fc->integral += error * interval;
+        if (fc->integral >  max_integral) fc->integral =  max_integral;
+        if (fc->integral < -max_integral) fc->integral = -max_integral;
+
+        fc->start = now;
+        fc->in    = 0;
+        fc->out   = 0;
+    }
+
+    fc->output = error + fcr_horizon * (fc->in_rate - fc->out_rate)
+        + fc->integral / fcr_integral;
+
+    return fc->output;
+}
+
+static double    const fcc_smooth    = 0.25;         //! period EWMA weight
+static long long const fcc_max_delay = 100000000LL; //! 100 ms
+
+void
+gcs_fcc_reset (gcs_fcc_t* const fc, long long const cut)
+{
+    assert (fc != NULL);
+
+    fc->cut      = cut;
+    fc->cut_time = gu_time_monotonic();
+    fc->period   = 0.0;
+}
+
+void
+gcs_fcc_cut (gcs_fcc_t* const fc, long long const cut)
+{
+    if (cut <= fc->cut) return;
+
+    long long const now = gu_time_monotonic();
+    double const sample = double(now - fc->cut_time) / (cut - fc->cut);
+
+    if (fc->period > 0.0)
+        fc->period += fcc_smooth * (sample - fc->period);
+    else
+        fc->period  = sample; // first sample after reset
+    fc->cut      = cut;
+    fc->cut_time = now;
+}
+
+long long
+gcs_fcc_delay (const gcs_fcc_t* const fc, long long const ordered,
+               long const lower, long const upper)
+{
+    long long const lag = ordered - fc->cut;
+
+    if (lag <= lower) return 0;
+
+    double const ramp = (lag >= upper || upper <= lower) ? 1.0 :
+        double(lag - lower) / (upper - lower);
+
+    long long const delay = ramp * fc->period;
+
+    return (delay < fcc_max_delay ? delay : fcc_max_delay);
+}
@@ -13,6 +13,15 @@
 #include <time.h>
 #include <unistd.h>
 #include <errno.h>
+#include <stdint.h>
+
+/** Flow control message */
+struct gcs_fc_event
+{
+    uint32_t conf_id; // least significant part of configuraiton seqno
+    uint32_t stop;    // boolean value
+}
+__attribute__((__packed__));
 
 typedef struct gcs_fc
 {
@@ -56,4 +65,105 @@ gcs_fc_process (gcs_fc_t* fc, ssize_t act_size);
 extern void
 gcs_fc_debug (gcs_fc_t* fc, long debug_level);
 
+/*! Slave queue flow control modes (gcs.fc_mode) */
+typedef enum gcs_fc_mode
+{
+    GCS_FC_MODE_LIMIT, //! FC_STOP above upper limit, FC_CONT below lower limit
+    GCS_FC_MODE_RATE,  //! FC_STOP/FC_CONT as told by gcs_fcr_t controller
+    GCS_FC_MODE_COORD  //! senders slow down as told by gcs_fcc_t, FC_STOP
+                       //! only above GCS_FCC_HARD_FACTOR * upper limit
+}
+gcs_fc_mode_t;
+
+extern const char* gcs_fc_mode_str (gcs_fc_mode_t mode);
+
+/*! Parses mode name.
+ *  @return 0 on success or -EINVAL if the name is not recognized. */
+extern int
+gcs_fc_mode_parse (const char* str, gcs_fc_mode_t* mode);
+
+/*! Slave queue flow control units (gcs.fc_units) */
+typedef enum gcs_fc_units
+{
+    GCS_FC_UNITS_ACTIONS, //! queue is measured in actions
+    GCS_FC_UNITS_BYTES    //! queue is measured in bytes of actions
+}
+gcs_fc_units_t;
+
+extern const char* gcs_fc_units_str (gcs_fc_units_t units);
+
+/*! Parses units name.
+ *  @return 0 on success or -EINVAL if the name is not recognized. */
+extern int
+gcs_fc_units_parse (const char* str, gcs_fc_units_t* units);
+
+/*! Rate based slave queue controller. Instead of waiting for the queue to
+ *  cross a limit it watches incoming and drain rates and asks to pause once
+ *  queue is projected to outgrow the target, and to resume once it is
+ *  projected to drain to it. Should be protected by slave queue lock. */
+typedef struct gcs_fcr
+{
+    double    target;   // target slave queue length
+    double    in_rate;  // smoothed incoming rate (units/s)
+    double    out_rate; // smoothed drain rate (units/s)
+    double    integral; // integral of queue length error (unit*s)
+    double    output;   // last controller output
+    long long start;    // beginning of the sampling interval (nanosec)
+    long      in;       // units queued during sampling interval
+    long      out;      // units drained during sampling interval
+}
+gcs_fcr_t;
+
+/*! Resets rate history and sets new target queue length */
+extern void
+gcs_fcr_reset (gcs_fcr_t* fc, double target);
+
+/*! Accounts for an action of weight units queued (in == true) or drained
+ *  from the slave queue, queue_len being the resulting length in the same
+ *  units.
+ *  @return controller output: positive value calls for FC_STOP,
+ *          non-positive - for FC_CONT */
+extern double
+gcs_fcr_account (gcs_fcr_t* fc, long queue_len, bool in, long units);
+
+/*! Same as gcs_fcr_account() for queue measured in actions */
+static inline double
+gcs_fcr_update (gcs_fcr_t* fc, long queue_len, bool in)
+{
+    return gcs_fcr_account (fc, queue_len, in, 1);
+}
+
+/*! In GCS_FC_MODE_COORD a member sends FC_STOP only when its queue exceeds
+ *  this many upper limits, and FC_CONT when it drains below one. */
+#define GCS_FCC_HARD_FACTOR 2
+
+/*! Coordinated flow control. Every member knows the group commit cut from
+ *  the LAST messages all members send anyway, so group lag - the distance
+ *  between the last ordered action and the cut - is the queue depth of the
+ *  slowest member, no extra messages needed. Each sender delays its own
+ *  actions by a fraction of the time the slowest member takes to apply one
+ *  action, growing from 0 at the lower limit to the full period at the upper
+ *  limit. Should be protected by FC lock. */
+typedef struct gcs_fcc
+{
+    long long cut;      // last group commit cut
+    long long cut_time; // when it advanced (nanosec, monotonic)
+    double    period;   // smoothed group apply time per action (nanosec)
+}
+gcs_fcc_t;
+
+/*! Forgets apply rate history, cut is where the group is now */
+extern void
+gcs_fcc_reset (gcs_fcc_t* fc, long long cut);
+
+/*! Accounts for a new group commit cut */
+extern void
+gcs_fcc_cut (gcs_fcc_t* fc, long long cut);
+
+/*! @return nanoseconds to delay the next local action when the last ordered
+ *          action is ordered, lower and upper being the lag limits */
+extern long long
+gcs_fcc_delay (const gcs_fcc_t* fc, long long ordered,
+               long lower, long upper);
+
 #endif /* _gcs_fc_h_ */
@@ -10,6 +10,14 @@
  * access methods - protected and unprotected. Unprotected
  * methods assume that calling routines implement their own
  * protection, and thus are simplified for speed.
+ *
+ * In GCS the FIFO has a single consumer (receiving thread) and producers
+ * serialized by the caller (core send lock, send monitor), but the lock is
+ * still needed: a producer that failed to send an action takes it back with
+ * gcs_fifo_lite_remove() while the consumer may be looking at the same item
+ * through gcs_fifo_lite_get_head(), e.g. after receiving its first fragment.
+ * The lock keeps the item intact until the consumer releases or pops it,
+ * so a removed slot is never rewritten under the consumer's feet.
  */
 
 #ifndef _GCS_FIFO_LITE_H_
@@ -16,6 +16,7 @@
 // We access data comp msg struct directly
 #define GCS_COMP_MSG_ACCESS 1
 #include "gcs_comp_msg.hpp"
+#include "gcs_params.hpp" // GCS_PARAMS_NUMA_NODE
 
 #include <gcomm/transport.hpp>
 #include <gcomm/util.hpp>
@@ -28,12 +29,14 @@
 #endif // PROFILE_GCS_GCOMM
 #include <profile.hpp>
 
+#include <gu_asio.hpp>
 #include <gu_backtrace.hpp>
 #include <gu_throw.hpp>
 #include <gu_logger.hpp>
 #include <gu_prodcons.hpp>
 #include <gu_barrier.hpp>
 #include <gu_thread.hpp>
+#include <gu_atomic.hpp>
 
 #include <deque>
 
@@ -45,6 +48,7 @@ using namespace gcomm;
 using namespace prof;
 
 static const std::string gcomm_thread_schedparam_opt("gcomm.thread_prio");
+static const std::string gcomm_recv_spin_opt("gcomm.recv_spin");
 
 class RecvBufData
 {
@@ -86,6 +90,13 @@ typedef deque<RecvBufData>
 
 RecvBufQueue;
 
+/* Messages are pushed by the GCommConn thread into queue_ and consumed by
+ * the GCS receive thread. The consumer takes the whole queue at once and
+ * serves messages from its private batch_ without locking until it runs
+ * out, so a busy receive path locks once per batch, not per message, and
+ * the producer signals only when the consumer actually waits. With spin
+ * set the consumer first polls for a new message for that many
+ * iterations, so a steady message stream causes no sleeps and wakeups. */
 class RecvBuf
 {
 private:
@@ -101,7 +112,10 @@ private:
 
 public:
 
-    RecvBuf() : mutex_(), cond_(), queue_(), waiting_(false) { }
+    explicit RecvBuf(long spin = 0) :
+        mutex_(), cond_(), queue_(), batch_(), spin_(spin), pushed_(0),
+        waiting_(false), kept_(false)
+    { }
 
     void push_back(const RecvBufData& p)
     {
@@ -109,43 +123,106 @@ public:
 
         queue_.push_back(p);
 
+        if (spin_ > 0) { ++pushed_; }
+
         if (waiting_ == true) { cond_.signal(); }
     }
 
-    const RecvBufData& front(const Date& timeout)
+    /* appends the whole batch under a single lock */
+    void push_back(const RecvBufQueue& q)
     {
+        if (q.empty()) return;
+
         Lock lock(mutex_);
 
-        while (queue_.empty())
+        // not insert(): RecvBufData is not assignable
+        for (RecvBufQueue::const_iterator i(q.begin()); i != q.end(); ++i)
         {
-            Waiting w(waiting_);
-            if (gu_likely (timeout == GU_TIME_ETERNITY))
-            {
-                lock.wait(cond_);
-            }
-            else
+            queue_.push_back(*i);
+        }
+
+        if (spin_ > 0) { pushed_ += q.size(); }
+
+        if (waiting_ == true) { cond_.signal(); }
+    }
+
+    /* drops the element kept by keep_front() since the caller is done
+     * with it by now */
+    const RecvBufData& front(const Date& timeout)
+    {
+        if (kept_)
+        {
+            assert(batch_.empty() == false);
+            batch_.pop_front();
+            kept_ = false;
+        }
+
+        if (batch_.empty())
+        {
+            if (spin_ > 0) spin_wait();
+
+            Lock lock(mutex_);
+
+            while (queue_.empty())
             {
-                lock.wait(cond_, timeout);
+                Waiting w(waiting_);
+                if (gu_likely (timeout == GU_TIME_ETERNITY))
+                {
+                    lock.wait(cond_);
+                }
+                else
+                {
+                    lock.wait(cond_, timeout);
+                }
             }
+            assert (false == waiting_);
+
+            batch_.swap(queue_);
         }
-        assert (false == waiting_);
 
-        return queue_.front();
+        return batch_.front();
     }
 
+    /* the calls below are for the consumer only, they don't lock */
+
     void pop_front()
     {
-        Lock lock(mutex_);
-        assert(queue_.empty() == false);
-        queue_.pop_front();
+        assert(batch_.empty() == false);
+        batch_.pop_front();
+    }
+
+    /* the front element payload was lent to the caller, keep it alive
+     * until the next call to front() */
+    void keep_front()
+    {
+        assert(batch_.empty() == false);
+        assert(false == kept_);
+        kept_ = true;
     }
 
 private:
 
+    // poll for a push for at most spin_ iterations
+    void spin_wait()
+    {
+        long const pushed(pushed_());
+
+        {
+            Lock lock(mutex_);
+            if (queue_.empty() == false) return;
+        }
+
+        for (long i(0); i < spin_ && pushed_() == pushed; ++i) {}
+    }
+
     Mutex mutex_;
     Cond cond_;
-    RecvBufQueue queue_;
+    RecvBufQueue queue_;  // producer side, protected by mutex_
+    RecvBufQueue batch_;  // consumer side
+    long const spin_;
+    gu::Atomic<long> pushed_; // push counter for spinning consumer
     bool waiting_;
+    bool kept_;
 };
 
 
@@ -182,6 +259,8 @@ public:
         uuid_(),
         thd_(),
         schedparam_(conf_.get(gcomm_thread_schedparam_opt)),
+        numa_node_(conf_.has(GCS_PARAMS_NUMA_NODE) ?
+                   conf_.get<int>(GCS_PARAMS_NUMA_NODE) : -1),
         barrier_(2),
         uri_(u),
         net_(Protonet::create(conf_)),
@@ -190,7 +269,7 @@ public:
         refcnt_(0),
         terminated_(false),
         error_(0),
-        recv_buf_(),
+        recv_buf_(conf_.get<long>(gcomm_recv_spin_opt)),
         current_view_(),
         prof_("gcs_gcomm")
     {
@@ -245,6 +324,19 @@ public:
         log_info << "gcomm thread scheduling priority set to "
                  << thread_get_schedparam(thd_) << " ";
 
+        if (numa_node_ >= 0)
+        {
+            try
+            {
+                thread_set_numa_node(thd_, numa_node_);
+                log_info << "gcomm thread bound to NUMA node " << numa_node_;
+            }
+            catch (gu::Exception& e)
+            {
+                log_warn << e.what();
+            }
+        }
+
         uri_.set_option("gmcast.group", channel);
         tp_ = Transport::create(*net_, uri_);
         gcomm::connect(tp_, this);
@@ -332,6 +424,8 @@ public:
                         const Datagram&    dg,
                         const ProtoUpMeta& um);
 
+    void handle_up_batch(const void* id, const ProtoUpBatch& batch);
+
     void queue_and_wait(const Message& msg, Message* ack);
 
     RecvBuf&    get_recv_buf()            { return recv_buf_; }
@@ -396,6 +490,9 @@ private:
     GCommConn(const GCommConn&);
     void operator=(const GCommConn&);
 
+    /* index of the source in the current view */
+    size_t source_idx(const gcomm::UUID& source) const;
+
     GCommConn* ref(const bool unsetting)
     {
         return this;
@@ -407,6 +504,7 @@ private:
     gcomm::UUID       uuid_;
     pthread_t         thd_;
     ThreadSchedparam  schedparam_;
+    int const         numa_node_;
     Barrier           barrier_;
     URI               uri_;
     Protonet*         net_;
@@ -442,21 +540,61 @@ GCommConn::handle_up(const void* id, const Datagram& dg, const ProtoUpMeta& um)
     }
     else
     {
-        size_t idx(0);
-        for (NodeList::const_iterator i = current_view_.members().begin();
-             i != current_view_.members().end(); ++i)
+        size_t const idx(source_idx(um.source()));
+        if (idx < current_view_.members().size())
         {
-            if (NodeList::key(i) == um.source())
+            profile_enter(prof_);
+            recv_buf_.push_back(RecvBufData(idx, dg, um));
+            profile_leave(prof_);
+        }
+    }
+}
+
+
+void
+GCommConn::handle_up_batch(const void* id, const ProtoUpBatch& batch)
+{
+    RecvBufQueue q;
+
+    for (size_t i(0); i < batch.size(); ++i)
+    {
+        const ProtoUpMeta& um(batch.um(i));
+
+        if (um.err_no() != 0 || um.has_view() == true)
+        {
+            // keep the order with respect to the messages collected so far
+            recv_buf_.push_back(q);
+            q.clear();
+            handle_up(id, batch.dg(i), um);
+        }
+        else
+        {
+            size_t const idx(source_idx(um.source()));
+            if (idx < current_view_.members().size())
             {
-                profile_enter(prof_);
-                recv_buf_.push_back(RecvBufData(idx, dg, um));
-                profile_leave(prof_);
-                break;
+                q.push_back(RecvBufData(idx, batch.dg(i), um));
             }
-            ++idx;
         }
-        assert(idx < current_view_.members().size());
     }
+
+    profile_enter(prof_);
+    recv_buf_.push_back(q);
+    profile_leave(prof_);
+}
+
+
+size_t
+GCommConn::source_idx(const gcomm::UUID& source) const
+{
+    size_t idx(0);
+    for (NodeList::const_iterator i = current_view_.members().begin();
+         i != current_view_.members().end(); ++i)
+    {
+        if (NodeList::key(i) == source) break;
+        ++idx;
+    }
+    assert(idx < current_view_.members().size());
+    return idx; // members().size() if not found
 }
 
 
@@ -685,11 +823,20 @@ static GCS_BACKEND_RECV_FN(gcomm_recv)
             const ssize_t pload_len(gcomm::available(dg));
 
             msg->size = pload_len;
+            msg->type = static_cast<gcs_msg_type_t>(um.user_type());
 
-            if (gu_likely(pload_len <= msg->buf_len))
+            if (gu_likely(GCS_MSG_ACTION == msg->type))
+            {
+                /* action fragments are parsed and copied into gcache
+                 * before the next recv call, lend the payload instead of
+                 * copying it here once more */
+                msg->buf     = const_cast<byte_t*>(b);
+                msg->buf_len = pload_len;
+                recv_buf.keep_front();
+            }
+            else if (gu_likely(pload_len <= msg->buf_len))
             {
                 memcpy(msg->buf, b, pload_len);
-                msg->type = static_cast<gcs_msg_type_t>(um.user_type());
                 recv_buf.pop_front();
             }
             else
@@ -939,7 +1086,10 @@ GCS_BACKEND_REGISTER_FN(gcs_gcomm_register)
     try
     {
         reinterpret_cast<gu::Config*>(cnf)->add(gcomm_thread_schedparam_opt, "");
+        reinterpret_cast<gu::Config*>(cnf)->add(gcomm_recv_spin_opt, "0");
         gcomm::Conf::register_params(*reinterpret_cast<gu::Config*>(cnf));
+        // protonet reads socket.ssl* options on creation
+        gu::ssl_register_params(*reinterpret_cast<gu::Config*>(cnf));
         return false;
     }
     catch (...)
@@ -7,8 +7,10 @@
 #include "gcs_group.hpp"
 #include "gcs_gcache.hpp"
 #include "gcs_priv.hpp"
+#include "gcs_fc.hpp" // struct gcs_fc_event
 
 #include <errno.h>
+#include <sstream>
 
 const char* gcs_group_state_str[GCS_GROUP_STATE_MAX] =
 {
@@ -29,6 +31,7 @@ gcs_group_init (gcs_group_t* group, gcache_t* const cache,
     group->act_id_      = GCS_SEQNO_ILL;
     group->conf_id      = GCS_SEQNO_ILL;
     group->state_uuid   = GU_UUID_NIL;
+    group->state_msgs   = 0;
     group->group_uuid   = GU_UUID_NIL;
     group->num          = 1; // this must be removed (#474)
     group->my_idx       = 0; // this must be -1 (#474)
@@ -37,6 +40,9 @@ gcs_group_init (gcs_group_t* group, gcache_t* const cache,
     group->state        = GCS_GROUP_NON_PRIMARY;
     group->last_applied = GCS_SEQNO_ILL; // mark for recalculation
     group->last_node    = -1;
+    group->cut_tree     = NULL;
+    group->cut_leaves   = 0;
+    group->cut_dirty    = true;
     group->frag_reset   = true; // just in case
     group->nodes        = GU_CALLOC(group->num, gcs_node_t); // this must be removed (#474)
 
@@ -143,6 +149,7 @@ gcs_group_free (gcs_group_t* group)
     if (group->my_name)    free ((char*)group->my_name);
     if (group->my_address) free ((char*)group->my_address);
     group_nodes_free (group);
+    if (group->cut_tree) gu_free (group->cut_tree);
 }
 
 /* Reset nodes array without breaking the statistics */
@@ -163,53 +170,143 @@ group_nodes_reset (gcs_group_t* group)
     group->frag_reset = true;
 }
 
-/* Find node with the smallest last_applied */
-static inline void
-group_redo_last_applied (gcs_group_t* group)
+/* Whether node last_applied counts towards the commit cut */
+static inline bool
+group_node_counted (const gcs_group_t* group, const gcs_node_t* node)
 {
-    long       n;
-    long       last_node    = -1;
-    gu_seqno_t last_applied = GU_LLONG_MAX;
+    if (gu_unlikely (0 == group->last_applied_proto_ver)) {
+        /* @note: this may be removed after quorum v1 is phased out */
+        return (GCS_NODE_STATE_SYNCED == node->status ||
+                GCS_NODE_STATE_DONOR  == node->status);
+    }
+
+    /* NOTE: It is crucial for consistency that last_applied algorithm
+     *       is absolutely identical on all nodes. Therefore for the
+     *       generality sake and future compatibility we have to assume
+     *       non-blocking donor.
+     *       GCS_BLOCKING_DONOR should never be defined unless in some
+     *       very custom builds. Commenting it out for safety sake. */
+//#ifdef GCS_BLOCKING_DONOR
+//    if (GCS_NODE_STATE_DONOR == node->status) return false; /* ignore donor */
+//#endif
+    return node->count_last_applied;
+}
 
-    for (n = 0; n < group->num; n++) {
-        const gcs_node_t* const node = &group->nodes[n];
-        gcs_seqno_t const seqno = node->last_applied;
-        bool count = node->count_last_applied;
-
-        if (gu_unlikely (0 == group->last_applied_proto_ver)) {
-            /* @note: this may be removed after quorum v1 is phased out */
-            count = (GCS_NODE_STATE_SYNCED == node->status ||
-                     GCS_NODE_STATE_DONOR  == node->status);
-        }
+/* Of two tree entries (node index or -1) returns the one with the smallest
+ * last_applied. a is always the left one, so on a tie the lower node index
+ * wins, exactly the node a linear scan would pick. */
+static inline long
+group_cut_min (const gcs_group_t* group, long const a, long const b)
+{
+    if (a < 0) return b;
+    if (b < 0) return a;
 
-//        gu_debug ("last_applied[%ld]: %lld", n, seqno);
-
-        /* NOTE: It is crucial for consistency that last_applied algorithm
-         *       is absolutely identical on all nodes. Therefore for the
-         *       generality sake and future compatibility we have to assume
-         *       non-blocking donor.
-         *       GCS_BLOCKING_DONOR should never be defined unless in some
-         *       very custom builds. Commenting it out for safety sake. */
-//#ifndef GCS_BLOCKING_DONOR
-        if (count
-//#else
-//        if ((GCS_NODE_STATE_SYNCED == node->status) /* ignore donor */
-//#endif
-            && (seqno < last_applied)) {
-            assert (seqno >= 0);
-            last_applied = seqno;
-            last_node    = n;
+    assert (a < b);
+
+    return (group->nodes[b].last_applied < group->nodes[a].last_applied ?
+            b : a);
+}
+
+static inline long
+group_cut_leaf (const gcs_group_t* group, long const n)
+{
+    if (n < group->num && group_node_counted (group, &group->nodes[n])) {
+        assert (group->nodes[n].last_applied >= 0);
+        return n;
+    }
+
+    return -1;
+}
+
+/* Rebuilds commit cut tree over all nodes: cut_tree[1] is the root,
+ * children of i are 2i and 2i+1, leaf of node n is cut_leaves + n. */
+static void
+group_cut_rebuild (gcs_group_t* group)
+{
+    long leaves = 1;
+    long i;
+
+    while (leaves < group->num) leaves <<= 1;
+
+    if (leaves != group->cut_leaves) {
+        long* const tree = GU_REALLOC (group->cut_tree, 2 * leaves, long);
+
+        if (!tree) {
+            gu_fatal ("Failed to allocate commit cut tree for %ld nodes",
+                      group->num);
+            gu_abort();
         }
-        // extra diagnostic, ignore
-        //else if (!count) { gu_warn("not counting %d", n); }
+
+        group->cut_tree   = tree;
+        group->cut_leaves = leaves;
+    }
+
+    for (i = 0; i < leaves; i++) {
+        group->cut_tree[leaves + i] = group_cut_leaf (group, i);
+    }
+
+    for (i = leaves - 1; i > 0; i--) {
+        group->cut_tree[i] = group_cut_min (group, group->cut_tree[2*i],
+                                            group->cut_tree[2*i + 1]);
+    }
+
+    group->cut_tree[0] = -1; // unused
+    group->cut_dirty   = false;
+}
+
+/* Updates commit cut tree after last_applied change of node n:
+ * O(log(nodes)) unless node states changed since the last rebuild */
+static inline void
+group_cut_update (gcs_group_t* group, long const n)
+{
+    if (gu_unlikely (group->cut_dirty || group->cut_leaves < group->num)) {
+        group_cut_rebuild (group);
+        return;
     }
 
+    long i = group->cut_leaves + n;
+
+    group->cut_tree[i] = group_cut_leaf (group, n);
+
+    for (i >>= 1; i > 0; i >>= 1) {
+        group->cut_tree[i] = group_cut_min (group, group->cut_tree[2*i],
+                                            group->cut_tree[2*i + 1]);
+    }
+}
+
+/* Sets group last_applied from the node with the smallest last_applied
+ * among those counted, according to the commit cut tree */
+static inline void
+group_cut_publish (gcs_group_t* group)
+{
+    long const last_node = group->cut_tree[1];
+
+#ifndef NDEBUG
+    /* the tree must give the same node as a linear scan */
+    long n, scan = -1;
+    for (n = 0; n < group->num; n++) {
+        if (group_node_counted (group, &group->nodes[n]) &&
+            (scan < 0 ||
+             group->nodes[n].last_applied < group->nodes[scan].last_applied))
+            scan = n;
+    }
+    assert (scan == last_node);
+#endif
+
     if (gu_likely (last_node >= 0)) {
-        group->last_applied = last_applied;
+        group->last_applied = group->nodes[last_node].last_applied;
         group->last_node    = last_node;
     }
 }
 
+/* Find node with the smallest last_applied, O(nodes) */
+static inline void
+group_redo_last_applied (gcs_group_t* group)
+{
+    group_cut_rebuild (group);
+    group_cut_publish (group);
+}
+
 static void
 group_go_non_primary (gcs_group_t* group)
 {
@@ -218,6 +315,7 @@ group_go_non_primary (gcs_group_t* group)
         assert(group->nodes);
 
         group->nodes[group->my_idx].status = GCS_NODE_STATE_NON_PRIM;
+        group->cut_dirty = true;
         //@todo: Perhaps the same has to be applied to the rest of the nodes[]?
     }
     else {
@@ -307,6 +405,8 @@ group_post_state_exchange (gcs_group_t* group)
         gcs_node_update_status (&group->nodes[i], quorum);
     }
 
+    group->cut_dirty = true;
+
     if (quorum->primary) {
         // primary configuration
         if (new_exchange) {
@@ -501,12 +601,21 @@ gcs_group_handle_comp_msg (gcs_group_t* group, const gcs_comp_msg_t* comp)
         new_memb |= (old_idx == group->num);
     }
 
+    /* FC state and applier reports are reset on configuration change, so
+     * that new members see the same load as the rest (group_node_load()) */
+    long long const now(gu_time_monotonic());
+    for (new_idx = 0; new_idx < new_nodes_num; new_idx++) {
+        gcs_node_reset_fc (&new_nodes[new_idx], now);
+        new_nodes[new_idx].last_reported = false;
+    }
+
     /* free old nodes array */
     group_nodes_free (group);
 
-    group->my_idx = new_my_idx;
-    group->num    = new_nodes_num;
-    group->nodes  = new_nodes;
+    group->my_idx    = new_my_idx;
+    group->num       = new_nodes_num;
+    group->nodes     = new_nodes;
+    group->cut_dirty = true;
 
     if (gcs_comp_msg_primary(comp) || bootstrap) {
         /* TODO: for now pretend that we always have new nodes and perform
@@ -521,6 +630,7 @@ gcs_group_handle_comp_msg (gcs_group_t* group, const gcs_comp_msg_t* comp)
             group_nodes_reset (group);
             group->state      = GCS_GROUP_WAIT_STATE_UUID;
             group->state_uuid = GU_UUID_NIL; // prepare for state exchange
+            group->state_msgs = 0;
         }
         else {
             if (GCS_GROUP_PRIMARY == group->state) {
@@ -543,6 +653,7 @@ gcs_group_handle_uuid_msg  (gcs_group_t* group, const gcs_recv_msg_t* msg)
     if (GCS_GROUP_WAIT_STATE_UUID == group->state &&
         0 == msg->sender_idx /* check that it is from the representative */) {
         group->state_uuid = *(gu_uuid_t*)msg->buf;
+        group->state_msgs = 0;
         group->state      = GCS_GROUP_WAIT_STATE_MSG;
     }
     else {
@@ -583,8 +694,24 @@ gcs_group_handle_state_msg (gcs_group_t* group, const gcs_recv_msg_t* msg)
 
                 if (gu_log_debug) group_print_state_debug(state);
 
-                gcs_node_record_state (&group->nodes[msg->sender_idx], state);
-                group_post_state_exchange (group);
+                gcs_node_t* const node = &group->nodes[msg->sender_idx];
+
+                /* count each node once per exchange, so that quorum is
+                 * calculated only when the last state message arrives instead
+                 * of scanning all nodes on every message: O(N^2) per view
+                 * change in large clusters */
+                if (NULL == node->state_msg ||
+                    gu_uuid_compare(&group->state_uuid,
+                                    gcs_state_msg_uuid(node->state_msg))) {
+                    group->state_msgs++;
+                }
+
+                gcs_node_record_state (node, state);
+                group->cut_dirty = true;
+
+                if (group->state_msgs >= group->num) {
+                    group_post_state_exchange (group);
+                }
             }
             else {
                 gu_debug ("STATE EXCHANGE: stray state msg: " GU_UUID_FORMAT
@@ -625,13 +752,14 @@ gcs_group_handle_last_msg (gcs_group_t* group, const gcs_recv_msg_t* msg)
     // assert (seqno >= group->last_applied);
 
     gcs_node_set_last_applied (&group->nodes[msg->sender_idx], seqno);
+    group_cut_update (group, msg->sender_idx);
 
     if (msg->sender_idx == group->last_node && seqno > group->last_applied) {
         /* node that was responsible for the last value, has changed it.
          * need to recompute it */
         gcs_seqno_t old_val = group->last_applied;
 
-        group_redo_last_applied (group);
+        group_cut_publish (group);
 
         if (old_val < group->last_applied) {
             gu_debug ("New COMMIT CUT %lld after %lld from %d",
@@ -707,6 +835,8 @@ gcs_group_handle_join_msg  (gcs_group_t* group, const gcs_recv_msg_t* msg)
             }
         }
 
+        group->cut_dirty = true;
+
         // Try to find peer.
         for (j = 0; j < group->num; j++) {
 // #483            if (j == sender_idx) continue;
@@ -781,6 +911,27 @@ gcs_group_handle_join_msg  (gcs_group_t* group, const gcs_recv_msg_t* msg)
     return (sender_idx == group->my_idx);
 }
 
+void
+gcs_group_handle_flow_msg  (gcs_group_t* group, const gcs_recv_msg_t* msg)
+{
+    assert (GCS_MSG_FLOW == msg->type);
+    assert (msg->sender_idx < group->num);
+
+    if (gu_unlikely(msg->size != sizeof(struct gcs_fc_event))) {
+        gu_warn ("Bogus FLOW message size %d from node %d, expected %zu",
+                 msg->size, msg->sender_idx, sizeof(struct gcs_fc_event));
+        return;
+    }
+
+    const struct gcs_fc_event* const fc =
+        static_cast<const struct gcs_fc_event*>(msg->buf);
+
+    if (gtohl(fc->conf_id) != (uint32_t)group->conf_id) return; // obsolete
+
+    gcs_node_handle_fc (&group->nodes[msg->sender_idx], fc->stop != 0,
+                        gu_time_monotonic());
+}
+
 int
 gcs_group_handle_sync_msg  (gcs_group_t* group, const gcs_recv_msg_t* msg)
 {
@@ -836,6 +987,46 @@ group_node_is_stateful (const gcs_group_t* group, const gcs_node_t* node)
     }
 }
 
+/*!
+ * Load of a member as the whole group sees it: members holding FC_STOP are
+ * the busiest, the rest are ranked by how far behind their appliers are.
+ * Only totally ordered events since the last configuration change contribute
+ * to it, so that every member arrives at the same donor choice.
+ */
+static inline gcs_seqno_t
+group_node_load (const gcs_group_t* const group, const gcs_node_t* const node)
+{
+    if (node->fc_stopped > 0) return GU_LLONG_MAX;
+
+    if (!node->last_reported) return 0; /* not known yet, don't penalize */
+
+    gcs_seqno_t const lag = group->act_id_ - node->last_applied;
+
+    return lag > 0 ? lag : 0;
+}
+
+/*! @return true if member a is less loaded than member b or b is none */
+static bool
+group_less_loaded (const gcs_group_t* const group, int const a, int const b)
+{
+    return (b < 0 ||
+            group_node_load (group, &group->nodes[a]) <
+            group_node_load (group, &group->nodes[b]));
+}
+
+/*! @return true if IST donor candidate a is preferable to b: less loaded or,
+ *          if equally loaded, having less history in cache to spare */
+static bool
+group_better_ist_donor (const gcs_group_t* const group,
+                        int const a, int const b)
+{
+    if (group_less_loaded (group, a, b)) return true;
+    if (group_less_loaded (group, b, a)) return false;
+
+    return gcs_node_cached(&group->nodes[a]) >=
+           gcs_node_cached(&group->nodes[b]);
+}
+
 static int
 group_find_node_by_state (const gcs_group_t*     const group,
                           int              const joiner_idx,
@@ -843,7 +1034,8 @@ group_find_node_by_state (const gcs_group_t*     const group,
 {
     gcs_segment_t const segment = group->nodes[joiner_idx].segment;
     int  idx;
-    int  donor = -1;
+    int  donor = -1;  /* least loaded suitable donor in the same segment */
+    int  remote = -1; /* least loaded suitable donor outside */
     bool hnss = false; /* have nodes in the same segment */
 
     for (idx = 0; idx < group->num; idx++) {
@@ -851,17 +1043,23 @@ group_find_node_by_state (const gcs_group_t*     const group,
         if (joiner_idx == idx) continue; /* skip joiner */
 
         gcs_node_t* node = &group->nodes[idx];
-
-        if (node->status >= status && group_node_is_stateful (group, node))
-            donor = idx; /* potential donor */
+        bool const suitable =
+            (node->status >= status && group_node_is_stateful (group, node));
 
         if (segment == node->segment) {
-            if (donor == idx) return donor; /* found suitable donor in the
-                                             * same segment */
+            if (suitable && group_less_loaded (group, idx, donor))
+                donor = idx;
             if (node->status >= GCS_NODE_STATE_JOINER) hnss = true;;
         }
+        else if (suitable && group_less_loaded (group, idx, remote)) {
+            remote = idx;
+        }
     }
 
+    if (donor >= 0) return donor; /* found suitable donor in the same segment*/
+
+    donor = remote;
+
     /* Have not found suitable donor in the same segment. */
     if (!hnss && donor >= 0) {
         if (joiner_idx == group->my_idx) {
@@ -1029,7 +1227,7 @@ group_find_ist_donor_by_name_in_string (
     const char* end;
 
     gu_debug("ist_seqno[%lld]", (long long)ist_seqno);
-    // return the highest cached seqno node.
+    // return the least loaded node, of equal ones the highest cached seqno.
     int ret = -1;
     do {
         end = strchr(begin, ',');
@@ -1044,14 +1242,9 @@ group_find_ist_donor_by_name_in_string (
         int idx = group_find_ist_donor_by_name(
             group, joiner_idx, begin, len,
             ist_seqno, status);
-        if (idx >= 0)
+        if (idx >= 0 && group_better_ist_donor(group, idx, ret))
         {
-            if (ret == -1 ||
-                gcs_node_cached(&group->nodes[idx]) >=
-                gcs_node_cached(&group->nodes[ret]))
-            {
-                ret = idx;
-            }
+            ret = idx;
         }
         begin = end + 1;
     } while (end != NULL);
@@ -1076,8 +1269,8 @@ group_find_ist_donor_by_state (const gcs_group_t* const group,
     gcs_segment_t joiner_segment = joiner->segment;
 
     // find node who is ist potentially possible.
-    // first highest cached seqno local node.
-    // then highest cached seqno remote node.
+    // first least loaded local node, then least loaded remote node.
+    // of equally loaded ones the highest cached seqno node.
     int idx = 0;
     int local_idx = -1;
     int remote_idx = -1;
@@ -1096,8 +1289,7 @@ group_find_ist_donor_by_state (const gcs_group_t* const group,
             int* const idx_ptr =
                 (joiner_segment == node->segment) ? &local_idx : &remote_idx;
 
-            if (*idx_ptr == -1 ||
-                node_cached >= gcs_node_cached(&group->nodes[*idx_ptr]))
+            if (group_better_ist_donor(group, idx, *idx_ptr))
             {
                 *idx_ptr = idx;
             }
@@ -1271,6 +1463,7 @@ group_select_donor (gcs_group_t* group,
         // reserve donor, confirm joiner (! assignment order is significant !)
         joiner->status = GCS_NODE_STATE_JOINER;
         donor->status  = GCS_NODE_STATE_DONOR;
+        group->cut_dirty = true;
 
         if (1 == donor->desync_count) {
             /* SST or first desync */
@@ -1292,6 +1485,57 @@ group_select_donor (gcs_group_t* group,
     return donor_idx;
 }
 
+/*!
+ * Selects synced members which can send a share of IST besides the donor:
+ * ones that are not busy with state transfers themselves and have the
+ * requested history in cache, same segment as joiner first. Group state is
+ * the same on all members, so all of them arrive at the same selection.
+ *
+ * @return number of helpers stored in helpers array
+ */
+static int
+group_select_ist_helpers (const gcs_group_t* const group,
+                          int const         joiner_idx,
+                          int const         donor_idx,
+                          gcs_seqno_t const ist_seqno,
+                          int               max,
+                          int* const        helpers)
+{
+    gcs_seqno_t const donor_cached =
+        gcs_node_cached(&group->nodes[donor_idx]);
+
+    /* donor has to do IST from cache, otherwise there is nothing to share */
+    if (ist_seqno < 0 || GCS_SEQNO_ILL == donor_cached ||
+        donor_cached > ist_seqno + 1) return 0;
+
+    /* no more donors than write sets to send */
+    if (max > group->act_id_ - ist_seqno - 1)
+        max = group->act_id_ - ist_seqno - 1;
+
+    gcs_segment_t const segment = group->nodes[joiner_idx].segment;
+    int n = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (int idx = 0; idx < group->num && n < max; idx++) {
+            if (idx == joiner_idx || idx == donor_idx) continue;
+
+            const gcs_node_t* const node = &group->nodes[idx];
+            gcs_seqno_t const node_cached = gcs_node_cached(node);
+
+            if ((0 == pass) != (segment == node->segment)) continue;
+
+            if (GCS_NODE_STATE_SYNCED == node->status &&
+                group_node_is_stateful(group, node) &&
+                node_cached != GCS_SEQNO_ILL &&
+                node_cached <= (ist_seqno + 1)) {
+                helpers[n++] = idx;
+            }
+        }
+    }
+
+    return n;
+}
+
 /* Cleanup ignored state request */
 void
 gcs_group_ignore_action (gcs_group_t* group, struct gcs_act_rcvd* act)
@@ -1331,6 +1575,7 @@ gcs_group_handle_state_request (gcs_group_t*         group,
 
     gu_uuid_t ist_uuid = {{0, }};
     gcs_seqno_t ist_seqno = GCS_SEQNO_ILL;
+    int ist_donors = 1;
     int str_version = 1; // actually it's 0 or 1.
 
     if (act->act.buf_len != (ssize_t)(donor_name_len + 1) &&
@@ -1346,10 +1591,19 @@ gcs_group_handle_state_request (gcs_group_t*         group,
         // change act.buf's content to original version.
         // and it's safe to change act.buf_len
         size_t head = donor_name_len + 3 + sizeof(ist_uuid) + sizeof(ist_seqno);
+
+        if (str_version >= 3) {
+            ist_donors = (uint8_t)ist_buf[sizeof(ist_uuid) + sizeof(ist_seqno)];
+            if (ist_donors < 1) ist_donors = 1;
+            if (ist_donors > GCS_IST_DONORS_MAX)
+                ist_donors = GCS_IST_DONORS_MAX;
+            head++;
+        }
+
         memmove((char*)act->act.buf + donor_name_len + 1,
                 (char*)act->act.buf + head,
                 act->act.buf_len - head);
-        act->act.buf_len -= sizeof(ist_uuid) + sizeof(ist_seqno) + 2;
+        act->act.buf_len -= head - donor_name_len - 1;
     }
 
     assert (GCS_ACT_STATE_REQ == act->act.type);
@@ -1382,18 +1636,53 @@ gcs_group_handle_state_request (gcs_group_t*         group,
     assert (donor_idx != joiner_idx || desync  || donor_idx < 0);
     assert (donor_idx == joiner_idx || !desync || donor_idx < 0);
 
-    if (group->my_idx != joiner_idx && group->my_idx != donor_idx) {
-        // if neither DONOR nor JOINER, ignore request
+    int helpers[GCS_IST_DONORS_MAX];
+    int n_helpers = 0;
+    int my_rank   = (group->my_idx == donor_idx ? 0 : -1);
+
+    if (donor_idx >= 0 && !desync && ist_donors > 1) {
+        n_helpers = group_select_ist_helpers (group, joiner_idx, donor_idx,
+                                              ist_seqno, ist_donors - 1,
+                                              helpers);
+        for (int i = 0; i < n_helpers; i++) {
+            if (group->my_idx == helpers[i]) my_rank = i + 1;
+        }
+
+        if (n_helpers > 0) {
+            gu_info ("Member %d.%d (%s) IST is split between %d donors",
+                     joiner_idx, group->nodes[joiner_idx].segment,
+                     joiner_name, n_helpers + 1);
+        }
+    }
+
+    if (group->my_idx != joiner_idx && my_rank < 0) {
+        // if neither DONOR nor JOINER nor IST helper, ignore request
         gcs_group_ignore_action (group, act);
         return 0;
     }
-    else if (group->my_idx == donor_idx) {
+    else if (my_rank >= 0) {
         act->act.buf_len -= donor_name_len + 1;
         memmove (*(void**)&act->act.buf,
                  ((char*)act->act.buf) + donor_name_len + 1,
                  act->act.buf_len);
         // now action starts with request, like it was supplied by application,
         // see gcs_request_state_transfer()
+
+        if (n_helpers > 0) {
+            // v3 head that was cut off leaves enough room for split header
+            char* const buf = (char*)act->act.buf;
+            memmove (buf + GCS_IST_SPLIT_HDR_LEN, buf, act->act.buf_len);
+            memcpy (buf, GCS_IST_SPLIT_TAG, sizeof(GCS_IST_SPLIT_TAG));
+            buf[sizeof(GCS_IST_SPLIT_TAG)]     = (char)my_rank;
+            buf[sizeof(GCS_IST_SPLIT_TAG) + 1] = (char)(n_helpers + 1);
+            act->act.buf_len += GCS_IST_SPLIT_HDR_LEN;
+        }
+
+        if (my_rank > 0) {
+            // helper does not become donor, see gcs_state_req_split()
+            act->id = GCS_SEQNO_ILL;
+            return act->act.buf_len;
+        }
     }
 
     // Return index of donor (or error) in the seqno field to sender.
@@ -1504,13 +1793,12 @@ group_get_node_state (const gcs_group_t* const group, long const node_idx)
     if (node->count_last_applied) flags |= GCS_STATE_FCLA;
     if (node->bootstrap)          flags |= GCS_STATE_FBOOTSTRAP;
 #ifdef GCS_FOR_GARB
+    /* arbitrator with a cache can still be named as IST donor */
     flags |= GCS_STATE_ARBITRATOR;
+#endif /* GCS_FOR_GARB */
 
-    int64_t const cached = GCS_SEQNO_ILL;
-#else
     int64_t const cached = /* group->cache check is needed for unit tests */
         group->cache ? gcache_seqno_min(group->cache) : GCS_SEQNO_ILL;
-#endif /* GCS_FOR_GARB */
 
     return gcs_state_msg_create (
         &group->state_uuid,
@@ -1556,6 +1844,22 @@ gcs_group_get_status (const gcs_group_t* group, gu::Status& status)
     }
 
     status.insert("desync_count", gu::to_string(desync_count));
+
+    /* FC_STOP/FC_CONT events sent by and total pause time caused by each
+     * member: "<name>:<stops>:<conts>:<paused ns>[,...]" */
+    std::ostringstream fc;
+    long long const now(gu_time_monotonic());
+
+    for (int i(0); i < group->num; ++i)
+    {
+        const gcs_node_t& node(group->nodes[i]);
+
+        if (i > 0) fc << ',';
+        fc << node.name << ':' << node.fc_stops << ':' << node.fc_conts << ':'
+           << gcs_node_fc_paused(&node, now);
+    }
+
+    status.insert("flow_control_nodes", fc.str());
 }
 
 
@@ -40,6 +40,7 @@ typedef struct gcs_group
     gcs_seqno_t   act_id_;      // current(last) action seqno
     gcs_seqno_t   conf_id;      // current configuration seqno
     gu_uuid_t     state_uuid;   // state exchange id
+    long          state_msgs;   // state messages received in this exchange
     gu_uuid_t     group_uuid;   // group UUID
     long          num;          // number of nodes
     long          my_idx;       // my index in the group
@@ -48,6 +49,9 @@ typedef struct gcs_group
     gcs_group_state_t state;    // group state: PRIMARY | NON_PRIMARY
     gcs_seqno_t   last_applied; // last_applied action group-wide
     long          last_node;    // node that reported last_applied
+    long*         cut_tree;     // commit cut tournament tree over nodes
+    long          cut_leaves;   // leaves in cut_tree, power of 2 >= num
+    bool          cut_dirty;    // node states changed, cut_tree is stale
     bool          frag_reset;   // indicate that fragmentation was reset
     gcs_node_t*   nodes;        // array of node contexts
 
@@ -130,6 +134,11 @@ gcs_group_handle_join_msg  (gcs_group_t* group, const gcs_recv_msg_t* msg);
 extern int
 gcs_group_handle_sync_msg  (gcs_group_t* group, const gcs_recv_msg_t* msg);
 
+/*! Accounts for FC_STOP/FC_CONT event sent by the message sender,
+ *  obsolete events are ignored */
+extern void
+gcs_group_handle_flow_msg  (gcs_group_t* group, const gcs_recv_msg_t* msg);
+
 /*! @return 0 if request is ignored, request size if it should be passed up */
 extern int
 gcs_group_handle_state_request (gcs_group_t*         group,
@@ -146,8 +155,9 @@ gcs_group_handle_act_msg (gcs_group_t*          const group,
                           struct gcs_act_rcvd*  const rcvd,
                           bool commonly_supported_version)
 {
-    long const sender_idx = msg->sender_idx;
-    bool const local      = (sender_idx == group->my_idx);
+    long const        sender_idx = msg->sender_idx;
+    bool const        local      = (sender_idx == group->my_idx);
+    gcs_node_t* const sender     = &group->nodes[sender_idx];
     ssize_t ret;
 
     assert (GCS_MSG_ACTION == msg->type);
@@ -155,14 +165,16 @@ gcs_group_handle_act_msg (gcs_group_t*          const group,
     assert (frg->act_id > 0);
     assert (frg->act_size > 0);
 
-    // clear reset flag if set by own first fragment after reset flag was set
-    group->frag_reset = (group->frag_reset &&
-                         !(local && 0 == frg->frag_no &&
-                           GCS_GROUP_PRIMARY == group->state));
+    // clear reset flag if set by own first fragment after reset flag was set.
+    // The flag is almost never set, so don't store to group on every message.
+    if (gu_unlikely(group->frag_reset) && local && 0 == frg->frag_no &&
+        GCS_GROUP_PRIMARY == group->state) {
+        group->frag_reset = false;
+    }
 
-    ret = gcs_node_handle_act_frag (&group->nodes[sender_idx], frg, &rcvd->act,
-                                    local);
+    ret = gcs_node_handle_act_frag (sender, frg, &rcvd->act, local);
 
+    /* most messages are non-final fragments, node state is of no interest */
     if (ret > 0) {
 
         assert (ret == rcvd->act.buf_len);
@@ -171,7 +183,7 @@ gcs_group_handle_act_msg (gcs_group_t*          const group,
 
         if (gu_likely(GCS_ACT_TORDERED  == rcvd->act.type &&
                       GCS_GROUP_PRIMARY == group->state   &&
-                      group->nodes[sender_idx].status >= GCS_NODE_STATE_DONOR &&
+                      sender->status >= GCS_NODE_STATE_DONOR &&
                       !(group->frag_reset && local) &&
                       commonly_supported_version)) {
             /* Common situation -
@@ -188,7 +200,7 @@ gcs_group_handle_act_msg (gcs_group_t*          const group,
                          " = %s, sender->status = %s, frag_reset = %s, "
                          "buf = %p",
                          gcs_group_state_str[group->state],
-                         gcs_node_state_to_str(group->nodes[sender_idx].status),
+                         gcs_node_state_to_str(sender->status),
                          group->frag_reset ? "true" : "false", rcvd->act.buf);
             }
             else {
@@ -220,6 +232,14 @@ gcs_group_my_idx (const gcs_group_t* group)
     return group->my_idx;
 }
 
+/*! Preallocated buffer for the next own action, @see gcs_defrag_set_preset()*/
+static inline void
+gcs_group_set_local_preset (gcs_group_t* group, const void* buf)
+{
+    assert (group->my_idx >= 0 && group->my_idx < group->num);
+    gcs_defrag_set_preset (&group->nodes[group->my_idx].app, buf);
+}
+
 /*!
  * Creates new configuration action
  * @param group group handle
@@ -43,9 +43,14 @@ struct gcs_node
     int              repl_proto_ver;
     int              appl_proto_ver;
     int              desync_count;
+    long long        fc_stops;     // FC_STOP events sent by the node
+    long long        fc_conts;     // FC_CONT events sent by the node
+    long long        fc_paused;    // total time node kept FC_STOP (nanosec)
+    long long        fc_stopped;   // when outstanding FC_STOP came, 0 - none
     gcs_node_state_t status;       // node status
     gcs_segment_t    segment;
     bool             count_last_applied; // should it be counted
+    bool             last_reported; // sent LAST since configuration change
     bool             bootstrap; // is part of prim comp bootstrap process
 };
 typedef struct gcs_node gcs_node_t;
@@ -92,13 +97,8 @@ gcs_node_handle_act_frag (gcs_node_t*           node,
     if (gu_likely(GCS_ACT_SERVICE != frg->act_type)) {
         return gcs_defrag_handle_frag (&node->app, frg, act, local);
     }
-    else if (GCS_ACT_SERVICE == frg->act_type) {
-        return gcs_defrag_handle_frag (&node->oob, frg, act, local);
-    }
     else {
-        gu_warn ("Unrecognised action type: %d", frg->act_type);
-        assert(0);
-        return -EPROTO;
+        return gcs_defrag_handle_frag (&node->oob, frg, act, local);
     }
 }
 
@@ -110,7 +110,8 @@ gcs_node_set_last_applied (gcs_node_t* node, gcs_seqno_t seqno)
                  "expected >= %lld. Ignoring.",
                  seqno, node->id, node->last_applied);
     } else {
-        node->last_applied = seqno;
+        node->last_applied  = seqno;
+        node->last_reported = true;
     }
 }
 
@@ -120,6 +121,42 @@ gcs_node_get_last_applied (gcs_node_t* node)
     return node->last_applied;
 }
 
+/*! Account for FC_STOP or FC_CONT event sent by the node */
+static inline void
+gcs_node_handle_fc (gcs_node_t* node, bool stop, long long now)
+{
+    if (stop) {
+        node->fc_stops++;
+        if (0 == node->fc_stopped) node->fc_stopped = now;
+    }
+    else {
+        node->fc_conts++;
+        if (node->fc_stopped > 0) {
+            node->fc_paused += now - node->fc_stopped;
+            node->fc_stopped = 0;
+        }
+    }
+}
+
+/*! Closes outstanding FC_STOP interval: FC state is reset on configuration
+ *  change. */
+static inline void
+gcs_node_reset_fc (gcs_node_t* node, long long now)
+{
+    if (node->fc_stopped > 0) {
+        node->fc_paused += now - node->fc_stopped;
+        node->fc_stopped = 0;
+    }
+}
+
+/*! @return total time the node kept FC_STOP, including outstanding one */
+static inline long long
+gcs_node_fc_paused (const gcs_node_t* node, long long now)
+{
+    return node->fc_paused +
+        (node->fc_stopped > 0 ? now - node->fc_stopped : 0);
+}
+
 /*! Record state message from the node */
 extern void
 gcs_node_record_state (gcs_node_t* node, gcs_state_msg_t* state);
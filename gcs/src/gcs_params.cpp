@@ -15,11 +15,18 @@ const char* const GCS_PARAMS_FC_FACTOR         = "gcs.fc_factor";
 const char* const GCS_PARAMS_FC_LIMIT          = "gcs.fc_limit";
 const char* const GCS_PARAMS_FC_MASTER_SLAVE   = "gcs.fc_master_slave";
 const char* const GCS_PARAMS_FC_DEBUG          = "gcs.fc_debug";
+const char* const GCS_PARAMS_FC_MODE           = "gcs.fc_mode";
+const char* const GCS_PARAMS_FC_UNITS          = "gcs.fc_units";
 const char* const GCS_PARAMS_SYNC_DONOR        = "gcs.sync_donor";
 const char* const GCS_PARAMS_MAX_PKT_SIZE      = "gcs.max_packet_size";
+const char* const GCS_PARAMS_AUTO_PKT_SIZE     = "gcs.auto_packet_size";
+const char* const GCS_PARAMS_SM_SMALL_SIZE     = "gcs.sm_small_size";
+const char* const GCS_PARAMS_SM_BUDGET         = "gcs.sm_budget";
 const char* const GCS_PARAMS_RECV_Q_HARD_LIMIT = "gcs.recv_q_hard_limit";
 const char* const GCS_PARAMS_RECV_Q_SOFT_LIMIT = "gcs.recv_q_soft_limit";
+const char* const GCS_PARAMS_RECV_Q_LENGTH     = "gcs.recv_q_length";
 const char* const GCS_PARAMS_MAX_THROTTLE      = "gcs.max_throttle";
+const char* const GCS_PARAMS_NUMA_NODE         = "gcs.numa_node";
 #ifdef GCS_SM_DEBUG
 const char* const GCS_PARAMS_SM_DUMP           = "gcs.sm_dump";
 #endif /* GCS_SM_DEBUG */
@@ -28,11 +35,18 @@ static const char* const GCS_PARAMS_FC_FACTOR_DEFAULT         = "1.0";
 static const char* const GCS_PARAMS_FC_LIMIT_DEFAULT          = "16";
 static const char* const GCS_PARAMS_FC_MASTER_SLAVE_DEFAULT   = "no";
 static const char* const GCS_PARAMS_FC_DEBUG_DEFAULT          = "0";
+static const char* const GCS_PARAMS_FC_MODE_DEFAULT           = "limit";
+static const char* const GCS_PARAMS_FC_UNITS_DEFAULT          = "actions";
 static const char* const GCS_PARAMS_SYNC_DONOR_DEFAULT        = "no";
 static const char* const GCS_PARAMS_MAX_PKT_SIZE_DEFAULT      = "64500";
+static const char* const GCS_PARAMS_AUTO_PKT_SIZE_DEFAULT     = "no";
+static const char* const GCS_PARAMS_SM_SMALL_SIZE_DEFAULT     = "32K";
+static const char* const GCS_PARAMS_SM_BUDGET_DEFAULT         = "0";
 static ssize_t const GCS_PARAMS_RECV_Q_HARD_LIMIT_DEFAULT     = SSIZE_MAX;
 static const char* const GCS_PARAMS_RECV_Q_SOFT_LIMIT_DEFAULT = "0.25";
+static const char* const GCS_PARAMS_RECV_Q_LENGTH_DEFAULT     = "0";
 static const char* const GCS_PARAMS_MAX_THROTTLE_DEFAULT      = "0.25";
+static const char* const GCS_PARAMS_NUMA_NODE_DEFAULT         = "-1";
 
 bool
 gcs_params_register(gu_config_t* conf)
@@ -47,10 +61,20 @@ gcs_params_register(gu_config_t* conf)
                           GCS_PARAMS_FC_MASTER_SLAVE_DEFAULT);
     ret |= gu_config_add (conf, GCS_PARAMS_FC_DEBUG,
                           GCS_PARAMS_FC_DEBUG_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_FC_MODE,
+                          GCS_PARAMS_FC_MODE_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_FC_UNITS,
+                          GCS_PARAMS_FC_UNITS_DEFAULT);
     ret |= gu_config_add (conf, GCS_PARAMS_SYNC_DONOR,
                           GCS_PARAMS_SYNC_DONOR_DEFAULT);
     ret |= gu_config_add (conf, GCS_PARAMS_MAX_PKT_SIZE,
                           GCS_PARAMS_MAX_PKT_SIZE_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_AUTO_PKT_SIZE,
+                          GCS_PARAMS_AUTO_PKT_SIZE_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_SM_SMALL_SIZE,
+                          GCS_PARAMS_SM_SMALL_SIZE_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_SM_BUDGET,
+                          GCS_PARAMS_SM_BUDGET_DEFAULT);
 
     char tmp[32] = { 0, };
     snprintf (tmp, sizeof(tmp) - 1, "%lld",
@@ -59,8 +83,12 @@ gcs_params_register(gu_config_t* conf)
 
     ret |= gu_config_add (conf, GCS_PARAMS_RECV_Q_SOFT_LIMIT,
                           GCS_PARAMS_RECV_Q_SOFT_LIMIT_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_RECV_Q_LENGTH,
+                          GCS_PARAMS_RECV_Q_LENGTH_DEFAULT);
     ret |= gu_config_add (conf, GCS_PARAMS_MAX_THROTTLE,
                           GCS_PARAMS_MAX_THROTTLE_DEFAULT);
+    ret |= gu_config_add (conf, GCS_PARAMS_NUMA_NODE,
+                          GCS_PARAMS_NUMA_NODE_DEFAULT);
 #ifdef GCS_SM_DEBUG
     ret |= gu_config_add (conf, GCS_PARAMS_SM_DUMP, "0");
 #endif /* GCS_SM_DEBUG */
@@ -178,6 +206,38 @@ params_init_double (gu_config_t* conf, const char* const name,
     return 0;
 }
 
+static long
+params_init_fc_mode (gu_config_t* conf, const char* const name,
+                     gcs_fc_mode_t* const var)
+{
+    const char* str;
+
+    long rc = gu_config_get_string(conf, name, &str);
+
+    if (rc < 0 || gcs_fc_mode_parse (str, var)) {
+        gu_error ("Bad %s value", name);
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
+static long
+params_init_fc_units (gu_config_t* conf, const char* const name,
+                      gcs_fc_units_t* const var)
+{
+    const char* str;
+
+    long rc = gu_config_get_string(conf, name, &str);
+
+    if (rc < 0 || gcs_fc_units_parse (str, var)) {
+        gu_error ("Bad %s value", name);
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
 long
 gcs_params_init (struct gcs_params* params, gu_config_t* config)
 {
@@ -192,6 +252,18 @@ gcs_params_init (struct gcs_params* params, gu_config_t* config)
     if ((ret = params_init_long (config, GCS_PARAMS_MAX_PKT_SIZE, 0,LONG_MAX,
                                  &params->max_packet_size))) return ret;
 
+    if ((ret = params_init_long (config, GCS_PARAMS_SM_SMALL_SIZE, 0,LONG_MAX,
+                                 &params->sm_small_size))) return ret;
+
+    if ((ret = params_init_long (config, GCS_PARAMS_SM_BUDGET, 0, LONG_MAX,
+                                 &params->sm_budget))) return ret;
+
+    if ((ret = params_init_long (config, GCS_PARAMS_NUMA_NODE, -1, LONG_MAX,
+                                 &params->numa_node))) return ret;
+
+    if ((ret = params_init_long (config, GCS_PARAMS_RECV_Q_LENGTH, 0, LONG_MAX,
+                                 &params->recv_q_length))) return ret;
+
     if ((ret = params_init_double (config, GCS_PARAMS_FC_FACTOR, 0.0, 1.0,
                                    &params->fc_resume_factor))) return ret;
 
@@ -214,5 +286,14 @@ gcs_params_init (struct gcs_params* params, gu_config_t* config)
 
     if ((ret = params_init_bool (config, GCS_PARAMS_SYNC_DONOR,
                                  &params->sync_donor))) return ret;
+
+    if ((ret = params_init_bool (config, GCS_PARAMS_AUTO_PKT_SIZE,
+                                 &params->auto_pkt_size))) return ret;
+
+    if ((ret = params_init_fc_mode (config, GCS_PARAMS_FC_MODE,
+                                    &params->fc_mode))) return ret;
+
+    if ((ret = params_init_fc_units (config, GCS_PARAMS_FC_UNITS,
+                                     &params->fc_units))) return ret;
     return 0;
 }
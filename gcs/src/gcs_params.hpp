@@ -6,6 +6,8 @@
 #ifndef _gcs_params_h_
 #define _gcs_params_h_
 
+#include "gcs_fc.hpp"
+
 #include "galerautils.h"
 
 struct gcs_params
@@ -14,22 +16,36 @@ struct gcs_params
     double  recv_q_soft_limit;
     double  max_throttle;
     ssize_t recv_q_hard_limit;
+    long    recv_q_length; // max recv queue items, 0 - from available memory
     long    fc_base_limit;
     long    max_packet_size;
+    long    sm_small_size;
+    long    sm_budget;
     long    fc_debug;
+    long    numa_node;
     bool    fc_master_slave;
     bool    sync_donor;
+    bool    auto_pkt_size;
+    gcs_fc_mode_t  fc_mode;
+    gcs_fc_units_t fc_units;
 };
 
 extern const char* const GCS_PARAMS_FC_FACTOR;
 extern const char* const GCS_PARAMS_FC_LIMIT;
 extern const char* const GCS_PARAMS_FC_MASTER_SLAVE;
 extern const char* const GCS_PARAMS_FC_DEBUG;
+extern const char* const GCS_PARAMS_FC_MODE;
+extern const char* const GCS_PARAMS_FC_UNITS;
 extern const char* const GCS_PARAMS_SYNC_DONOR;
 extern const char* const GCS_PARAMS_MAX_PKT_SIZE;
+extern const char* const GCS_PARAMS_AUTO_PKT_SIZE;
+extern const char* const GCS_PARAMS_SM_SMALL_SIZE;
+extern const char* const GCS_PARAMS_SM_BUDGET;
 extern const char* const GCS_PARAMS_RECV_Q_HARD_LIMIT;
 extern const char* const GCS_PARAMS_RECV_Q_SOFT_LIMIT;
+extern const char* const GCS_PARAMS_RECV_Q_LENGTH;
 extern const char* const GCS_PARAMS_MAX_THROTTLE;
+extern const char* const GCS_PARAMS_NUMA_NODE;
 #ifdef GCS_SM_DEBUG
 extern const char* const GCS_PARAMS_SM_DUMP;
 #endif /* GCS_SM_DEBUG */
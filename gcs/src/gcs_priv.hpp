@@ -15,4 +15,10 @@
 
 #define GCS_DESYNC_REQ "self-desync"
 
+/* State request header of a split IST share: tag, rank, number of donors,
+ * see gcs_state_req_split() */
+#define GCS_IST_SPLIT_TAG     "IST split"
+#define GCS_IST_SPLIT_HDR_LEN (sizeof(GCS_IST_SPLIT_TAG) + 2)
+#define GCS_IST_DONORS_MAX    16
+
 #endif /* _gcs_priv_h_ */
@@ -52,6 +52,7 @@ gcs_sm_create (long len, long n)
         sm->wait_q_mask = sm->wait_q_len - 1;
         sm->wait_q_head = 1;
         sm->wait_q_tail = 0;
+        sm->wait_q_next = 0;
         sm->users       = 0;
         sm->users_max   = 0;
         sm->users_min   = 0;
@@ -62,6 +63,9 @@ gcs_sm_create (long len, long n)
 #endif /* GCS_SM_CONCURRENCY */
         sm->pause       = false;
         sm->wait_time   = gu::datetime::Sec;
+        sm->budget      = 0;
+        memset (sm->class_sent, 0, sizeof(sm->class_sent));
+        memset (sm->class_waiting, 0, sizeof(sm->class_waiting));
 
 #ifdef GCS_SM_DEBUG
         memset (&sm->history, 0, sizeof(sm->history));
@@ -112,6 +116,16 @@ gcs_sm_close (gcs_sm_t* sm)
     return 0;
 }
 
+void
+gcs_sm_set_budget (gcs_sm_t* sm, long long const budget)
+{
+    if (gu_unlikely(gu_mutex_lock (&sm->lock))) abort();
+
+    sm->budget = budget;
+
+    gu_mutex_unlock (&sm->lock);
+}
+
 long
 gcs_sm_open (gcs_sm_t* sm)
 {
@@ -21,10 +21,26 @@
 #define GCS_SM_CC 1
 #endif /* GCS_SM_CONCURRENCY */
 
+/*!
+ * Priority classes, in the order of precedence. Waiters of a higher class
+ * may overtake waiters of lower classes for up to the budget of bytes, then
+ * the earliest waiter of the next lower class gets its turn. Within a class
+ * the order is FIFO.
+ */
+typedef enum gcs_sm_class
+{
+    GCS_SM_CLASS_CTRL,  // service actions
+    GCS_SM_CLASS_SMALL, // small writesets
+    GCS_SM_CLASS_LARGE, // the rest
+    GCS_SM_CLASS_MAX
+}
+gcs_sm_class_t;
+
 typedef struct gcs_sm_user
 {
-    gu_cond_t* cond;
-    bool       wait;
+    gu_cond_t*     cond;
+    bool           wait;
+    gcs_sm_class_t cls;
 }
 gcs_sm_user_t;
 
@@ -51,6 +67,7 @@ typedef struct gcs_sm
     unsigned long wait_q_mask;
     unsigned long wait_q_head;
     unsigned long wait_q_tail;
+    unsigned long wait_q_next; // last signaled waiter
     long          users;
     long          users_min;
     long          users_max;
@@ -61,6 +78,9 @@ typedef struct gcs_sm
 #endif /* GCS_SM_CONCURRENCY */
     bool          pause;
     gu::datetime::Period wait_time;
+    long long     budget;
+    long long     class_sent[GCS_SM_CLASS_MAX]; // bytes sent ahead of lower
+    long          class_waiting[GCS_SM_CLASS_MAX];
 
 #ifdef GCS_SM_DEBUG
 #define GCS_SM_HIST_STR_LEN 128
@@ -134,8 +154,62 @@ gcs_sm_open (gcs_sm_t* sm);
 extern void
 gcs_sm_destroy (gcs_sm_t* sm);
 
+/*!
+ * Sets the number of bytes a priority class may send while lower classes
+ * wait.
+ */
+extern void
+gcs_sm_set_budget (gcs_sm_t* sm, long long budget);
+
 #define GCS_SM_INCREMENT(cursor) (cursor = ((cursor + 1) & sm->wait_q_mask))
 
+/* Picks the waiter to go next, the head must be waiting */
+static inline unsigned long
+_gcs_sm_pick_next (gcs_sm_t* sm)
+{
+    unsigned long const head(sm->wait_q_head);
+
+    assert (sm->wait_q[head].wait);
+
+    /* no budget means no classes, closing monitor expects strict order */
+    if (gu_likely(sm->budget <= 0) || gu_unlikely(0 != sm->ret)) return head;
+
+    int const     lowest(sm->wait_q[head].cls);
+    unsigned long first[GCS_SM_CLASS_MAX];
+    long          to_find(0);
+
+    for (int c(0); c < lowest; ++c) {
+        first[c] = sm->wait_q_len; // none
+        to_find += sm->class_waiting[c] > 0;
+    }
+
+    /* the earliest waiter of every class of higher precedence than head */
+    for (unsigned long i(head); to_find > 0 && i != sm->wait_q_tail;) {
+        GCS_SM_INCREMENT(i);
+        int const c(sm->wait_q[i].cls);
+        if (c < lowest && sm->wait_q[i].wait && first[c] == sm->wait_q_len) {
+            first[c] = i;
+            to_find--;
+        }
+    }
+
+    for (int c(0); c < lowest; ++c) {
+        if (first[c] != sm->wait_q_len && sm->class_sent[c] < sm->budget) {
+            return first[c];
+        }
+    }
+
+    return head;
+}
+
+/* Accounts bytes sent by a user of class cls who has just entered */
+static inline void
+_gcs_sm_account (gcs_sm_t* sm, gcs_sm_class_t cls, long long bytes)
+{
+    sm->class_sent[cls] += bytes;
+    for (int c(0); c < cls; ++c) sm->class_sent[c] = 0;
+}
+
 static inline void
 _gcs_sm_wake_up_next (gcs_sm_t* sm)
 {
@@ -146,11 +220,13 @@ _gcs_sm_wake_up_next (gcs_sm_t* sm)
 
     while (woken < GCS_SM_CC && sm->users > 0) {
         if (gu_likely(sm->wait_q[sm->wait_q_head].wait)) {
-            assert (NULL != sm->wait_q[sm->wait_q_head].cond);
-            // gu_debug ("Waking up %lu", sm->wait_q_head);
-            gu_cond_signal (sm->wait_q[sm->wait_q_head].cond);
+            unsigned long const next(_gcs_sm_pick_next(sm));
+            assert (NULL != sm->wait_q[next].cond);
+            // gu_debug ("Waking up %lu", next);
+            gu_cond_signal (sm->wait_q[next].cond);
+            sm->wait_q_next = next;
             woken++;
-            GCS_SM_HIST_LOG("signaled %lu", sm->wait_q_head);
+            GCS_SM_HIST_LOG("signaled %lu", next);
             break;
         }
         else { /* skip interrupted */
@@ -210,17 +286,21 @@ _gcs_sm_leave_common (gcs_sm_t* sm)
 
 static inline int
 _gcs_sm_enqueue_common (gcs_sm_t* sm, gu_cond_t* cond, bool block,
-                        unsigned long tail)
+                        unsigned long tail,
+                        gcs_sm_class_t cls = GCS_SM_CLASS_LARGE)
 {
     sm->wait_q[tail].cond = cond;
     sm->wait_q[tail].wait = true;
+    sm->wait_q[tail].cls  = cls;
+    sm->class_waiting[cls]++;
     int ret;
 
     if (block == true)
     {
         GCS_SM_HIST_LOG("queueing at %lu", tail);
         gu_cond_wait (cond, &sm->lock);
-        assert(tail == sm->wait_q_head || false == sm->wait_q[tail].wait);
+        assert(tail == sm->wait_q_head || tail == sm->wait_q_next ||
+               false == sm->wait_q[tail].wait);
         assert(sm->wait_q[tail].cond == cond || false == sm->wait_q[tail].wait);
         ret = sm->wait_q[tail].wait ? 0 : -EINTR;
     }
@@ -271,6 +351,7 @@ _gcs_sm_enqueue_common (gcs_sm_t* sm, gu_cond_t* cond, bool block,
 
     sm->wait_q[tail].cond = NULL;
     sm->wait_q[tail].wait = false;
+    sm->class_waiting[cls]--;
 
     if (gu_unlikely(0 != ret)) GCS_SM_HIST_LOG("%ld wait failed: %d", tail, ret);
 
@@ -340,6 +421,8 @@ gcs_sm_schedule (gcs_sm_t* sm)
  * @param cond condition to signal to wake up thread in case of wait
  * @param block if true block until entered or send monitor is closed,
  *              if false enter wait times out eventually
+ * @param cls   priority class of the user
+ * @param bytes how much the user is going to send
  *
  * @retval -EAGAIN - out of space
  * @retval -EBADFD - monitor closed
@@ -348,7 +431,8 @@ gcs_sm_schedule (gcs_sm_t* sm)
  * @retval 0 - successfully entered
  */
 static inline long
-gcs_sm_enter (gcs_sm_t* sm, gu_cond_t* cond, bool scheduled, bool block)
+gcs_sm_enter (gcs_sm_t* sm, gu_cond_t* cond, bool scheduled, bool block,
+              gcs_sm_class_t cls = GCS_SM_CLASS_LARGE, long long bytes = 0)
 {
     long ret = 0; /* if scheduled and no queue */
 
@@ -360,7 +444,7 @@ gcs_sm_enter (gcs_sm_t* sm, gu_cond_t* cond, bool scheduled, bool block)
            was true) */
         bool wait = GCS_SM_HAS_TO_WAIT;
         while (wait && ret >= 0) {
-            ret = _gcs_sm_enqueue_common (sm, cond, block, tail);
+            ret = _gcs_sm_enqueue_common (sm, cond, block, tail, cls);
             if (gu_likely((0 == ret))) {
                 ret = sm->ret;
                 /* weaken the condition, so that we do enter if there
@@ -375,6 +459,7 @@ gcs_sm_enter (gcs_sm_t* sm, gu_cond_t* cond, bool scheduled, bool block)
             assert(sm->users   > 0);
             assert(sm->entered < GCS_SM_CC);
             sm->entered++;
+            _gcs_sm_account (sm, cls, bytes);
 #ifdef GCS_SM_SIMULATE_TIMEOUTS
             if (tail & 1) usleep(1000);
 #endif
@@ -411,7 +496,15 @@ gcs_sm_leave (gcs_sm_t* sm)
     sm->entered--;
     GCS_SM_ASSERT(sm->entered < GCS_SM_CC);
 
-    _gcs_sm_leave_common(sm);
+    if (gu_likely(!sm->wait_q[sm->wait_q_head].wait)) {
+        _gcs_sm_leave_common(sm);
+    }
+    else {
+        /* entered ahead of the head waiter, own slot will be skipped as an
+         * interrupted one when it becomes the head */
+        _gcs_sm_wake_up_waiters (sm);
+        GCS_SM_HIST_LOG("leaving out of order");
+    }
 
     gu_mutex_unlock (&sm->lock);
 }
@@ -480,7 +573,8 @@ gcs_sm_interrupt (gcs_sm_t* sm, long handle)
         GCS_SM_HIST_LOG("interrupted %ld", handle);
         sm->wait_q[handle].cond = NULL;
         ret = 0;
-        if (!sm->pause && handle == (long)sm->wait_q_head) {
+        if (!sm->pause && (handle == (long)sm->wait_q_head ||
+                           handle == (long)sm->wait_q_next)) {
             /* gcs_sm_interrupt() was called right after the waiter was
              * signaled by gcs_sm_continue() or gcs_sm_leave() but before
              * the waiter has woken up. Wake up the next waiter */
@@ -7,6 +7,20 @@
 /*  This program imitates 3rd party application and        */
 /*  tests GCS library in a dummy standalone configuration  */
 /***********************************************************/
+/*
+ * It also serves as a benchmark of gcs_core/gcs_sm over the dummy or gcomm
+ * backend, e.g.:
+ *
+ *   gcs_test -b -r 1000 -d exp -m 4096 -j out.json dummy:// 10 8 2 1
+ *
+ * runs 8 REPL and 2 SEND threads, each at 1000 actions/second with
+ * exponentially distributed sizes for 10 seconds and writes throughput
+ * and latency percentiles of every action type to out.json.
+ * Without -r the threads run in a closed loop. Replication and send
+ * latencies are measured around gcs_repl()/gcs_send() calls, delivery
+ * latency - from sending to receiving of our own actions sent by SEND
+ * threads. With -r latencies are counted from when the action was due.
+ */
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,6 +30,7 @@
 #include <string.h>
 #include <sys/time.h>
 #include <stdbool.h>
+#include <math.h>
 
 #include <galerautils.h>
 
@@ -45,6 +60,104 @@ static gcs_test_log_t *send_log, *recv_log;
 static bool throughput = true; // bench for throughput
 static bool total      = true; // also enable TO locking
 
+typedef enum
+{
+    TEST_SIZE_UNIFORM, // 1..msg_len
+    TEST_SIZE_FIXED,   // msg_len
+    TEST_SIZE_EXP      // exponential with mean msg_len
+}
+test_size_dist_t;
+
+static test_size_dist_t size_dist = TEST_SIZE_UNIFORM;
+static double           send_rate = 0.0; // per thread, 0 - closed loop
+
+/* Latency histogram: 16 linear sub-buckets per power of 2 of nanoseconds,
+ * which bounds the error of a reported percentile by 1/16. One per thread,
+ * merged at the end, so no locking. */
+#define HIST_SUB_BITS 4
+#define HIST_SUB      (1 << HIST_SUB_BITS)
+#define HIST_BUCKETS  (64 * HIST_SUB)
+
+typedef struct test_hist
+{
+    unsigned long long count[HIST_BUCKETS];
+    unsigned long long n;
+    long long          max;
+}
+test_hist_t;
+
+static inline int
+test_hist_idx (long long const v)
+{
+    if (v < HIST_SUB) return (v > 0 ? v : 0);
+
+    int const e(63 - __builtin_clzll(v)); // >= HIST_SUB_BITS
+    int const m((v >> (e - HIST_SUB_BITS)) & (HIST_SUB - 1));
+
+    return (e - HIST_SUB_BITS + 1) * HIST_SUB + m;
+}
+
+/* upper bound of the bucket values */
+static inline long long
+test_hist_val (int const idx)
+{
+    if (idx < HIST_SUB) return idx;
+
+    int const e(idx / HIST_SUB + HIST_SUB_BITS - 1);
+    int const m(idx % HIST_SUB);
+
+    return ((long long)(HIST_SUB + m + 1) << (e - HIST_SUB_BITS)) - 1;
+}
+
+static inline void
+test_hist_add (test_hist_t* const h, long long const ns)
+{
+    h->count[test_hist_idx(ns)]++;
+    h->n++;
+    if (ns > h->max) h->max = ns;
+}
+
+static void
+test_hist_merge (test_hist_t* const to, const test_hist_t* const from)
+{
+    for (int i = 0; i < HIST_BUCKETS; i++) to->count[i] += from->count[i];
+    to->n += from->n;
+    if (from->max > to->max) to->max = from->max;
+}
+
+/* returns q-quantile in nanoseconds */
+static long long
+test_hist_quantile (const test_hist_t* const h, double const q)
+{
+    if (0 == h->n) return 0;
+
+    unsigned long long const target(ceil(q * h->n));
+    unsigned long long sum(0);
+
+    for (int i = 0; i < HIST_BUCKETS; i++)
+    {
+        sum += h->count[i];
+        if (sum >= target)
+        {
+            long long const v(test_hist_val(i));
+            return (v < h->max ? v : h->max);
+        }
+    }
+
+    return h->max;
+}
+
+/* In throughput mode every action starts with a stamp, so that receivers
+ * can tell actions sent by this process and measure delivery latency. */
+typedef struct test_stamp
+{
+    unsigned long long tag;
+    long long          time;
+}
+test_stamp_t;
+
+static unsigned long long stamp_tag = 0;
+
 typedef enum
 {
     GCS_TEST_SEND,
@@ -61,6 +174,9 @@ typedef struct gcs_test_thread
     long              n_tries;
     void*             msg;
     char*             log_msg;
+    test_hist_t*      hist;    // latencies of this thread actions
+    long long         start;   // when current action was due
+    long long         next;    // when next action is due with fixed rate
 }
 gcs_test_thread_t;
 
@@ -76,8 +192,11 @@ static long gcs_test_thread_create (gcs_test_thread_t *t, long id, long n_tries)
     t->act.seqno_l  = GCS_SEQNO_ILL;
     t->act.type     = GCS_ACT_TORDERED;
     t->n_tries      = n_tries;
+    t->start        = 0;
+    t->next         = 0;
+    t->hist         = (test_hist_t*)calloc (1, sizeof(test_hist_t));
 
-    if (t->msg)
+    if (t->msg && t->hist)
     {
         t->log_msg = (char*)calloc (MAX_MSG_LEN, sizeof(char));
         if (t->log_msg) return 0;
@@ -90,6 +209,7 @@ static long gcs_test_thread_destroy (gcs_test_thread_t *t)
 {
     if (t->msg)     free (t->msg);
     if (t->log_msg) free (t->log_msg);
+    if (t->hist)    free (t->hist);
     return 0;
 }
 
@@ -185,8 +305,23 @@ test_make_msg (char* msg, const long mlen)
                         rand(), (unsigned long long)count++, gcs_test_data);
     }
     else {
-        len = rand() % mlen + 1; // just random length, we don't care about
-                                 // contents
+        // we don't care about contents, just the length
+        switch (size_dist)
+        {
+        case TEST_SIZE_FIXED:
+            len = mlen;
+            break;
+        case TEST_SIZE_EXP:
+            len = -log(1.0 - rand()/(RAND_MAX + 1.0)) * mlen + 1;
+            if (len > MAX_MSG_LEN) len = MAX_MSG_LEN;
+            return (len < (long)sizeof(test_stamp_t) ?
+                    (long)sizeof(test_stamp_t) : len);
+        case TEST_SIZE_UNIFORM:
+            len = rand() % mlen + 1;
+            break;
+        }
+
+        if (len < (long)sizeof(test_stamp_t)) len = sizeof(test_stamp_t);
     }
 
     if (len >= mlen)
@@ -329,6 +464,24 @@ test_before_send (gcs_test_thread_t* thread)
     thread->act.buf  = thread->msg;
     if (thread->act.size <= 0) return -1;
 
+    if (send_rate > 0.0) {
+        /* Latency is counted from when the action was due, not from when
+         * it was actually sent, so falling behind the schedule shows. */
+        long long const now(gu_time_monotonic());
+
+        if (0 == thread->next) thread->next = now;
+
+        if (thread->next > now) {
+            long long const d(thread->next - now);
+            struct timespec const ts = { (time_t)(d / 1000000000LL),
+                                         (long)(d % 1000000000LL) };
+            nanosleep (&ts, NULL);
+        }
+
+        thread->start = thread->next;
+        thread->next += 1000000000.0 / send_rate;
+    }
+
     if (!throughput) {
         /* log message before replication */
         ret = test_send_log_create (thread);
@@ -337,6 +490,14 @@ test_before_send (gcs_test_thread_t* thread)
 #ifdef USE_WAIT
     while ((ret = gcs_wait(gcs)) && ret > 0) nanosleep (&wait, NULL);
 #endif
+
+    if (send_rate <= 0.0) thread->start = gu_time_monotonic();
+
+    if (throughput) {
+        test_stamp_t const stamp = { stamp_tag, thread->start };
+        memcpy (thread->msg, &stamp, sizeof(stamp));
+    }
+
     return ret;
 }
 
@@ -389,6 +550,7 @@ void *gcs_test_repl (void *arg)
             break;
         }
 
+        test_hist_add (thread->hist, gu_time_monotonic() - thread->start);
         msg_repld++;
         size_repld += thread->act.size;
 //      usleep ((rand() & 1) << 1);
@@ -420,6 +582,7 @@ void *gcs_test_send (void *arg)
 
         if (ret < 0) break;
         //sleep (1);
+        test_hist_add (thread->hist, gu_time_monotonic() - thread->start);
         msg_sent++;
         size_sent += thread->act.size;
     }
@@ -458,7 +621,7 @@ gcs_test_handle_configuration (gcs_conn_t* gcs, gcs_test_thread_t* thread)
                      (long long)conf->seqno, // this is global seqno
                      strerror (-gcs_request_state_transfer (gcs, 0, &conf->seqno,
                                                             sizeof(conf->seqno),
-                                                            "", &ist_uuid, ist_seqno,
+                                                            "", &ist_uuid, ist_seqno, 1,
                                                             &seqno)));
 
             // pretend that state transfer is complete, cancel every action up
@@ -511,6 +674,15 @@ void *gcs_test_recv (void *arg)
 
         switch (thread->act.type) {
         case GCS_ACT_TORDERED:
+            if (throughput && thread->act.size >= (ssize_t)sizeof(test_stamp_t))
+            {
+                test_stamp_t stamp;
+                memcpy (&stamp, thread->act.buf, sizeof(stamp));
+                if (stamp_tag == stamp.tag) {
+                    test_hist_add (thread->hist,
+                                   gu_time_monotonic() - stamp.time);
+                }
+            }
             test_after_recv (thread);
             //puts (thread->log_msg); fflush (stdout);
             break;
@@ -623,53 +795,108 @@ typedef struct gcs_test_conf
     long n_send;
     long n_recv;
     const char* backend;
+    long msg_len;
+    test_size_dist_t size_dist;
+    double rate;
+    bool   batch;           // don't wait for key presses
+    const char* json;       // file to write results to
 }
 gcs_test_conf_t;
 
 static const char* DEFAULT_BACKEND = "dummy://";
 
+static const char* const size_dist_str[] = { "uniform", "fixed", "exp" };
+
 static long gcs_test_conf (gcs_test_conf_t *conf, long argc, char *argv[])
 {
     char *endptr;
+    int  opt;
+    long i;
 
     /* defaults */
-    conf->n_tries = 10;
-    conf->n_repl  = 10;
-    conf->n_send  = 0;
-    conf->n_recv  = 1;
-    conf->backend = DEFAULT_BACKEND;
+    conf->n_tries   = 10;
+    conf->n_repl    = 10;
+    conf->n_send    = 0;
+    conf->n_recv    = 1;
+    conf->backend   = DEFAULT_BACKEND;
+    conf->msg_len   = 1300;
+    conf->size_dist = TEST_SIZE_UNIFORM;
+    conf->rate      = 0.0;
+    conf->batch     = false;
+    conf->json      = NULL;
+
+    while ((opt = getopt (argc, argv, "bd:j:m:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            conf->batch = true;
+            break;
+        case 'd':
+            for (i = TEST_SIZE_EXP; i >= 0; i--) {
+                if (!strcmp (optarg, size_dist_str[i])) break;
+            }
+            if (i < 0) goto error;
+            conf->size_dist = (test_size_dist_t)i;
+            break;
+        case 'j':
+            conf->json = optarg;
+            break;
+        case 'm':
+            conf->msg_len = strtol (optarg, &endptr, 10);
+            if ('\0' != *endptr || conf->msg_len <= 0) goto error;
+            if (conf->msg_len > MAX_MSG_LEN) conf->msg_len = MAX_MSG_LEN;
+            break;
+        case 'r':
+            conf->rate = strtod (optarg, &endptr);
+            if ('\0' != *endptr || conf->rate < 0.0) goto error;
+            break;
+        default:
+            goto error;
+        }
+    }
 
-    switch (argc)
+    switch (argc - optind)
     {
-    case 6:
-        conf->n_recv = strtol (argv[5], &endptr, 10);
-        if ('\0' != *endptr) goto error;
     case 5:
-        conf->n_send = strtol (argv[4], &endptr, 10);
+        conf->n_recv = strtol (argv[optind + 4], &endptr, 10);
         if ('\0' != *endptr) goto error;
     case 4:
-        conf->n_repl = strtol (argv[3], &endptr, 10);
+        conf->n_send = strtol (argv[optind + 3], &endptr, 10);
         if ('\0' != *endptr) goto error;
     case 3:
-        conf->n_tries = strtol (argv[2], &endptr, 10);
+        conf->n_repl = strtol (argv[optind + 2], &endptr, 10);
         if ('\0' != *endptr) goto error;
     case 2:
-        conf->backend = argv[1];
+        conf->n_tries = strtol (argv[optind + 1], &endptr, 10);
+        if ('\0' != *endptr) goto error;
+    case 1:
+        conf->backend = argv[optind];
         break;
-    default:
+    case 0:
         break;
+    default:
+        goto error;
     }
 
     printf ("Config: n_tries = %ld, n_repl = %ld, n_send = %ld, n_recv = %ld, "
-            "backend = %s\n",
+            "backend = %s, msg_len = %ld (%s), rate = %.1f\n",
             conf->n_tries, conf->n_repl, conf->n_send, conf->n_recv,
-            conf->backend);
+            conf->backend, conf->msg_len, size_dist_str[conf->size_dist],
+            conf->rate);
 
     return 0;
 error:
-    printf ("Usage: %s [backend] [tries:%ld] [repl threads:%ld] "
-            "[send threads: %ld] [recv threads: %ld]\n",
-            argv[0], conf->n_tries, conf->n_repl, conf->n_send, conf->n_recv);
+    printf ("Usage: %s [-b] [-d uniform|fixed|exp] [-j file] [-m msg_len] "
+            "[-r rate] [backend] [seconds:%ld] [repl threads:%ld] "
+            "[send threads: %ld] [recv threads: %ld]\n"
+            "  -b  batch mode, don't wait for key presses\n"
+            "  -d  action size distribution (uniform)\n"
+            "  -j  write results in JSON to file, '-' for stdout\n"
+            "  -m  maximum action size or mean for exp (%ld)\n"
+            "  -r  actions per second per thread, 0 - closed loop (%.1f)\n",
+            argv[0], conf->n_tries, conf->n_repl, conf->n_send, conf->n_recv,
+            conf->msg_len, conf->rate);
     exit (EXIT_SUCCESS);
 }
 
@@ -681,6 +908,70 @@ test_print_stat (long msgs, size_t size, double interval)
             size >> 10, (double)(size >> 10)/interval);
 }
 
+static void
+test_pool_hist (const gcs_test_thread_pool_t* pool, test_hist_t* hist)
+{
+    memset (hist, 0, sizeof(*hist));
+    for (long i = 0; i < pool->n_threads; i++) {
+        test_hist_merge (hist, pool->threads[i].hist);
+    }
+}
+
+static inline void
+test_print_latency (const test_hist_t* h)
+{
+    printf ("%7llu p50: %9.1fus p99: %9.1fus p999: %9.1fus max: %9.1fus\n",
+            h->n,
+            test_hist_quantile (h, 0.5)   * 0.001,
+            test_hist_quantile (h, 0.99)  * 0.001,
+            test_hist_quantile (h, 0.999) * 0.001,
+            h->max * 0.001);
+}
+
+static void
+test_json_stat (FILE* f, const char* name, long msgs, size_t size,
+                const test_hist_t* h, double interval, bool last)
+{
+    fprintf (f, "  \"%s\": { \"actions\": %ld, \"bytes\": %zu, "
+             "\"actions_per_sec\": %.1f, \"bytes_per_sec\": %.1f, "
+             "\"latency_samples\": %llu, \"p50_us\": %.1f, "
+             "\"p99_us\": %.1f, \"p999_us\": %.1f, \"max_us\": %.1f }%s\n",
+             name, msgs, size, msgs/interval, size/interval, h->n,
+             test_hist_quantile (h, 0.5)   * 0.001,
+             test_hist_quantile (h, 0.99)  * 0.001,
+             test_hist_quantile (h, 0.999) * 0.001,
+             h->max * 0.001, last ? "" : ",");
+}
+
+static void
+test_json_write (const gcs_test_conf_t* conf, double interval,
+                 const test_hist_t* repl, const test_hist_t* send,
+                 const test_hist_t* recv)
+{
+    bool const out(!strcmp (conf->json, "-"));
+    FILE* const f(out ? stdout : fopen (conf->json, "w"));
+
+    if (!f) {
+        fprintf (stderr, "Failed to open '%s': %d (%s)\n",
+                 conf->json, errno, strerror(errno));
+        return;
+    }
+
+    fprintf (f, "{\n  \"backend\": \"%s\", \"repl_threads\": %ld, "
+             "\"send_threads\": %ld, \"recv_threads\": %ld,\n"
+             "  \"msg_len\": %ld, \"size_dist\": \"%s\", \"rate\": %.1f, "
+             "\"seconds\": %.3f,\n",
+             conf->backend, conf->n_repl, conf->n_send, conf->n_recv,
+             conf->msg_len, size_dist_str[conf->size_dist], conf->rate,
+             interval);
+    test_json_stat (f, "repl", msg_repld, size_repld, repl, interval, false);
+    test_json_stat (f, "send", msg_sent,  size_sent,  send, interval, false);
+    test_json_stat (f, "recv", msg_recvd, size_recvd, recv, interval, true);
+    fprintf (f, "}\n");
+
+    if (out) fflush (f); else fclose (f);
+}
+
 int main (int argc, char *argv[])
 {
     long err = 0;
@@ -694,6 +985,9 @@ int main (int argc, char *argv[])
     gcs_conf_debug_on(); // turn on debug messages
 
     if ((err = gcs_test_conf     (&conf, argc, argv)))   goto out;
+    size_dist = conf.size_dist;
+    send_rate = conf.rate;
+    stamp_tag = ((unsigned long long)getpid() << 32) ^ gu_time_calendar();
     if (!throughput) {
         if ((err = test_log_open (&send_log, SEND_LOG))) goto out;
         if ((err = test_log_open (&recv_log, RECV_LOG))) goto out;
@@ -709,19 +1003,22 @@ int main (int argc, char *argv[])
     gconf = gu_config_create ();
     if (!gconf) goto out;
 
-    if (gu_config_add(gconf, "gcache.size", "0")) goto out;
-    if (gu_config_add(gconf, "gcache.page_size", "1M")) goto out;
+    gcache_register_params(gconf);
+    if (gcs_register_params(gconf)) goto out;
+    gu_config_set_string(gconf, "gcache.size", "0");
+    gu_config_set_string(gconf, "gcache.page_size", "1M");
 
     if (!(gcache = gcache_create (gconf, ""))) goto out;
     if (!(gcs = gcs_create (gconf, gcache, NULL, NULL, 0, 0))) goto out;
     puts ("debug"); fflush(stdout);
-    /* the following hack won't work if there is 0.0.0.0 in URL options */
-    bstrap = (NULL != strstr(conf.backend, "0.0.0.0"));
+    /* the following hack won't work if there is 0.0.0.0 in URL options,
+     * dummy backend has no one to join, so it always bootstraps */
+    bstrap = (NULL != strstr(conf.backend, "0.0.0.0") ||
+              !strncmp(conf.backend, "dummy://", strlen("dummy://")));
     if ((err  = gcs_open   (gcs, channel, conf.backend, bstrap))) goto out;
     printf ("Connected\n");
 
-    msg_len = 1300;
-    if (msg_len > MAX_MSG_LEN) msg_len = MAX_MSG_LEN;
+    msg_len = conf.msg_len;
     gcs_conf_set_pkt_size (gcs, 7570); // to test fragmentation
 
     if ((err = gcs_test_thread_pool_create
@@ -737,8 +1034,10 @@ int main (int argc, char *argv[])
     gcs_test_thread_pool_start (&repl_pool);
     gcs_test_thread_pool_start (&send_pool);
 
-    printf ("Press any key to start the load:");
-    fgetc (stdin);
+    if (!conf.batch) {
+        printf ("Press any key to start the load:");
+        fgetc (stdin);
+    }
 
     puts ("Started load.");
     gettimeofday (&t_begin, NULL);
@@ -784,10 +1083,30 @@ int main (int argc, char *argv[])
         printf ("Overhead at 10000 actions/sec: %5.2f%%\n",
                 1000000.0 * interval / (msg_repld + msg_recvd));
         puts("");
+
+        test_hist_t repl_hist, send_hist, recv_hist;
+        test_pool_hist (&repl_pool, &repl_hist);
+        test_pool_hist (&send_pool, &send_hist);
+        test_pool_hist (&recv_pool, &recv_hist);
+
+        printf ("Replication latency:");
+        test_print_latency (&repl_hist);
+        printf ("Send latency:       ");
+        test_print_latency (&send_hist);
+        printf ("Delivery latency:   ");
+        test_print_latency (&recv_hist);
+        puts("");
+
+        if (conf.json) {
+            test_json_write (&conf, interval, &repl_hist, &send_hist,
+                             &recv_hist);
+        }
     }
 
-    printf ("Press any key to exit the program:\n");
-    fgetc (stdin);
+    if (!conf.batch) {
+        printf ("Press any key to exit the program:\n");
+        fgetc (stdin);
+    }
 
     printf ("Freeing GCS connection handle...");
     if ((err = gcs_destroy (gcs))) goto out;
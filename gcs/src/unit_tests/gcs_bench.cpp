@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2017 Codership Oy <info@codership.com>
+ *
+ * Action defragmentation and flow control microbenchmark.
+ *
+ * Measures, separately:
+ *   defrag      - every action is cut into fragments of the given size,
+ *                 each fragment gets a protocol header with
+ *                 gcs_act_proto_write() and is taken apart with
+ *                 gcs_act_proto_read() and gcs_defrag_handle_frag() the way
+ *                 gcs_group does on delivery,
+ *   fc_rate     - gcs_fcr_account() for an action queued and dequeued, as
+ *                 done under slave queue lock in gcs.fc_mode=rate,
+ *   fc_coord    - gcs_fcc_cut() every commit cut interval actions and
+ *                 gcs_fcc_delay() for every action in gcs.fc_mode=coord,
+ *   fc_throttle - gcs_fc_process() with the queue between the soft and
+ *                 hard limits, which is how state transfer is throttled.
+ * Action sizes and queue length swings are generated with a fixed seed.
+ *
+ * Usage: gcs_bench [-n actions] [-s action size] [-f fragment size]
+ *                  [-c commit cut interval]
+ */
+
+#include "../gcs_defrag.hpp"
+#include "../gcs_fc.hpp"
+
+#include <galerautils.h>
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+struct bench_opt
+{
+    long acts;
+    long size;
+    long frag;
+    long cut;
+};
+
+static void
+bench_usage (const char* const name)
+{
+    fprintf (stderr, "Usage: %s [-n actions] [-s action size]"
+             " [-f fragment size] [-c commit cut interval]\n", name);
+}
+
+/* simple LCG to be independent of libc rand() */
+static long
+bench_rand (unsigned long long* const x, long const n)
+{
+    *x = *x * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (long)((*x >> 33) % n);
+}
+
+/* this variable serves to prevent compiler from optimizing out the calls */
+static long long volatile bench_sink = 0;
+
+static void
+bench_report (const char* const what, long long const ns, double const bytes,
+              long const acts)
+{
+    if (bytes > 0)
+        printf ("%-12s %8.1f ns/act, %8.1f MB/s\n", what, double(ns) / acts,
+                bytes / (1 << 20) / (ns / 1.0e9));
+    else
+        printf ("%-12s %8.1f ns/act\n", what, double(ns) / acts);
+}
+
+static int
+bench_defrag (const bench_opt& opt)
+{
+    long const hdr_size (gcs_act_proto_hdr_size (GCS_ACT_PROTO_MAX));
+
+    std::vector<uint8_t> act (opt.size);
+    std::vector<uint8_t> pkt (hdr_size + opt.frag);
+
+    unsigned long long x (0x1234567ULL);
+    for (size_t i = 0; i < act.size(); ++i)
+        act[i] = bench_rand (&x, 256);
+
+    gcs_defrag_t df;
+    gcs_defrag_init (&df, NULL);
+
+    double bytes (0);
+    long long const t0 (gu_time_monotonic());
+
+    for (long i = 0; i < opt.acts; ++i)
+    {
+        gcs_act_frag_t frg;
+        frg.act_id    = i;
+        frg.act_size  = opt.size;
+        frg.frag_no   = 0;
+        frg.act_type  = GCS_ACT_TORDERED;
+        frg.proto_ver = GCS_ACT_PROTO_MAX;
+
+        for (long sent = 0; sent < opt.size; ++frg.frag_no)
+        {
+            long const len (opt.size - sent < opt.frag ? opt.size - sent :
+                            opt.frag);
+
+            /* sender */
+            gcs_act_proto_write (&frg, &pkt[0], hdr_size + len);
+            memcpy (const_cast<void*>(frg.frag), &act[sent], len);
+            sent += len;
+
+            /* receiver */
+            gcs_act_frag_t rfrg;
+            struct gcs_act racts;
+            long ret (gcs_act_proto_read (&rfrg, &pkt[0], hdr_size + len));
+
+            if (0 == ret)
+                ret = gcs_defrag_handle_frag (&df, &rfrg, &racts, false);
+
+            if (ret < 0)
+            {
+                fprintf (stderr, "Failed to defragment action %ld: %ld (%s)\n",
+                         i, -ret, strerror(-ret));
+                return -1;
+            }
+
+            if (ret > 0)
+            {
+                bench_sink += static_cast<const uint8_t*>(racts.buf)[0];
+                gcs_gcache_free (NULL, racts.buf);
+                bytes += ret;
+            }
+        }
+    }
+
+    bench_report ("defrag:", gu_time_monotonic() - t0, bytes, opt.acts);
+
+    return 0;
+}
+
+static void
+bench_fc (const bench_opt& opt)
+{
+    unsigned long long x (0x1234567ULL);
+
+    /* queue length follows a slow random walk around the target */
+    long const target (opt.cut);
+    std::vector<long> queue (opt.acts);
+    long len (target);
+    for (size_t i = 0; i < queue.size(); ++i)
+    {
+        len += bench_rand (&x, 3) - 1;
+        if (len < 0) len = 0;
+        queue[i] = len;
+    }
+
+    gcs_fcr_t fcr;
+    gcs_fcr_reset (&fcr, target);
+
+    long long t0 (gu_time_monotonic());
+    double out (0);
+    for (long i = 0; i < opt.acts; ++i)
+    {
+        out += gcs_fcr_update (&fcr, queue[i] + 1, true);
+        out += gcs_fcr_update (&fcr, queue[i], false);
+    }
+    bench_report ("fc_rate:", gu_time_monotonic() - t0, 0, opt.acts);
+
+    gcs_fcc_t fcc;
+    gcs_fcc_reset (&fcc, 0);
+
+    t0 = gu_time_monotonic();
+    long long delay (0);
+    for (long i = 0; i < opt.acts; ++i)
+    {
+        if (0 == i % opt.cut) gcs_fcc_cut (&fcc, i - queue[i]);
+        delay += gcs_fcc_delay (&fcc, i, target / 2, target);
+    }
+    bench_report ("fc_coord:", gu_time_monotonic() - t0, 0, opt.acts);
+
+    /* queue starts at the soft limit and never reaches the hard one */
+    ssize_t const hard_limit ((opt.acts + 1) * opt.size * 4);
+    gcs_fc_t fc;
+    gcs_fc_init (&fc, hard_limit, 0.5, 0.25);
+    gcs_fc_reset (&fc, hard_limit / 2);
+
+    t0 = gu_time_monotonic();
+    for (long i = 0; i < opt.acts; ++i)
+    {
+        delay += gcs_fc_process (&fc, opt.size / 2 + bench_rand (&x, opt.size));
+    }
+    bench_report ("fc_throttle:", gu_time_monotonic() - t0, 0, opt.acts);
+
+    bench_sink += delay + (long long)out;
+}
+
+int
+main (int argc, char* argv[])
+{
+    bench_opt opt = { 1000000, 4096, 1024, 16 };
+    int c;
+
+    while ((c = getopt (argc, argv, "n:s:f:c:")) != -1)
+    {
+        long const val (optarg ? strtol (optarg, NULL, 10) : 0);
+
+        switch (c)
+        {
+        case 'n': opt.acts = val; break;
+        case 's': opt.size = val; break;
+        case 'f': opt.frag = val; break;
+        case 'c': opt.cut  = val; break;
+        default:  bench_usage (argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (opt.acts <= 0 || opt.size <= 0 || opt.frag <= 0 || opt.cut <= 0)
+    {
+        bench_usage (argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    gu_conf_self_tstamp_on ();
+
+    printf ("actions: %ld, size: %ld bytes, fragment: %ld bytes, "
+            "commit cut interval: %ld\n",
+            opt.acts, opt.size, opt.frag, opt.cut);
+
+    if (bench_defrag (opt)) return EXIT_FAILURE;
+
+    bench_fc (opt);
+
+    return EXIT_SUCCESS;
+}
@@ -242,7 +242,8 @@ core_send_thread (void* arg)
     action_t* act = (action_t*)arg;
 
     // use seqno field to pass the return code, it is signed 8-byte integer
-    act->seqno = gcs_core_send (Core, act->in, act->size, act->type);
+    act->seqno = gcs_core_send (Core, act->in, act->size, act->type,
+                                false);
 
     return (NULL);
 }
@@ -374,7 +375,8 @@ core_test_init (bool bootstrap = true,
              ret, strerror(-ret));
 
     // try to send an action to check that everything's alright
-    ret = gcs_core_send (Core, act1, sizeof(act1_str), GCS_ACT_TORDERED);
+    ret = gcs_core_send (Core, act1, sizeof(act1_str), GCS_ACT_TORDERED,
+                         false);
     fail_if (ret != sizeof(act1_str), "Expected %d, got %d (%s)",
              sizeof(act1_str), ret, strerror (-ret));
     gu_warn ("Next CORE_RECV_ACT fails under valgrind");
@@ -488,6 +490,59 @@ START_TEST (gcs_core_test_api)
 }
 END_TEST
 
+static void*
+core_caused_thread (void* arg)
+{
+    *(gcs_seqno_t*)arg = gcs_core_caused (Core);
+    return NULL;
+}
+
+START_TEST (gcs_core_test_caused)
+{
+    core_test_init ();
+    fail_if (NULL == Core);
+
+    const struct gu_buf* act = act1;
+    size_t act_size = sizeof(act1_str);
+
+    action_t act_s(act, NULL, NULL, act_size, GCS_ACT_TORDERED, -1, (gu_thread_t)-1);
+    action_t act_r(act, NULL, NULL, -1, (gcs_act_type_t)-1, -1, (gu_thread_t)-1);
+
+    fail_if (CORE_SEND_START (&act_s));
+    while (gcs_core_send_step (Core, 300) > 0) {}
+    fail_if (CORE_SEND_END (&act_s, act_size));
+    fail_if (CORE_RECV_ACT (&act_r, act1_str, act_size, GCS_ACT_TORDERED));
+
+    /* concurrent callers share causal messages and all get the same answer */
+    static int const n_callers = 8;
+    gu_thread_t thr[n_callers];
+    gcs_seqno_t res[n_callers];
+
+    for (int i = 0; i < n_callers; i++) {
+        res[i] = GCS_SEQNO_ILL;
+        fail_if (gu_thread_create (&thr[i], NULL, core_caused_thread, &res[i]));
+    }
+
+    fail_if (CORE_RECV_START (&act_r));
+
+    for (int i = 0; i < n_callers; i++) {
+        gu_thread_join (thr[i], NULL);
+        fail_if (res[i] != Seqno, "caller %d got %lld, expected %lld",
+                 i, (long long)res[i], (long long)Seqno);
+    }
+
+    /* let recv thread return */
+    long ret = gcs_core_set_last_applied (Core, Seqno);
+    fail_if (ret != 0, "gcs_core_set_last_applied(): %ld (%s)",
+             ret, strerror(-ret));
+    fail_if (CORE_RECV_END (&act_r, NULL, sizeof(gcs_seqno_t),
+                            GCS_ACT_COMMIT_CUT));
+    free (act_r.out);
+
+    core_test_cleanup ();
+}
+END_TEST
+
 // do a single send step, compare with the expected result
 static inline bool
 CORE_SEND_STEP (gcs_core_t* core, long timeout, long ret)
@@ -949,6 +1004,7 @@ Suite *gcs_core_suite(void)
   if (skip == false) {
       tcase_add_test  (tcase, gcs_core_test_api);
       tcase_add_test  (tcase, gcs_core_test_own);
+      tcase_add_test  (tcase, gcs_core_test_caused);
       //  tcase_add_test  (tcase, gcs_core_test_foreign);
       // tcase_add_test (tcase, gcs_core_test_gh74);
   }
@@ -161,6 +161,28 @@ START_TEST (gcs_defrag_test)
     defrag_check_init (&defrag); // should be empty
 
 // memleack in recv_act.buf !
+
+    // 11. Local action in a buffer preset by sender is returned as is
+    char preset[sizeof (act_buf)];
+    memcpy (preset, act_buf, act_len);
+
+    gcs_defrag_set_preset (&defrag, preset);
+    ret = gcs_defrag_handle_frag (&defrag, &frg1, &recv_act, TRUE);
+    fail_if (ret != 0);
+    fail_if (defrag.head != (uint8_t*)preset);
+    fail_if (defrag.preset != NULL);
+
+    ret = gcs_defrag_handle_frag (&defrag, &frg2, &recv_act, TRUE);
+    fail_if (ret != 0);
+
+    ret = gcs_defrag_handle_frag (&defrag, &frg3, &recv_act, TRUE);
+    fail_if (ret != (long)act_len);
+    fail_if (recv_act.buf != preset);
+    fail_if (recv_act.buf_len != (long)act_len);
+    fail_if (strncmp(preset, act_buf, act_len));
+
+    defrag_check_init (&defrag); // should be empty
+    fail_if (defrag.cached);
 }
 END_TEST
 
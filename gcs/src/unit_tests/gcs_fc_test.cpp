@@ -120,6 +120,107 @@ START_TEST(gcs_fc_test_precise)
 }
 END_TEST
 
+START_TEST(gcs_fc_test_mode)
+{
+    gcs_fc_mode_t mode = GCS_FC_MODE_LIMIT;
+
+    fail_if (gcs_fc_mode_parse ("rate", &mode) != 0);
+    fail_if (mode != GCS_FC_MODE_RATE);
+    fail_if (gcs_fc_mode_parse ("LIMIT", &mode) != 0);
+    fail_if (mode != GCS_FC_MODE_LIMIT);
+    fail_if (gcs_fc_mode_parse ("pid", &mode) != -EINVAL);
+    fail_if (mode != GCS_FC_MODE_LIMIT);
+    fail_if (strcmp (gcs_fc_mode_str (GCS_FC_MODE_RATE), "rate"));
+}
+END_TEST
+
+START_TEST(gcs_fc_test_units)
+{
+    gcs_fc_units_t units = GCS_FC_UNITS_ACTIONS;
+
+    fail_if (gcs_fc_units_parse ("bytes", &units) != 0);
+    fail_if (units != GCS_FC_UNITS_BYTES);
+    fail_if (gcs_fc_units_parse ("Actions", &units) != 0);
+    fail_if (units != GCS_FC_UNITS_ACTIONS);
+    fail_if (gcs_fc_units_parse ("time", &units) != -EINVAL);
+    fail_if (units != GCS_FC_UNITS_ACTIONS);
+    fail_if (strcmp (gcs_fc_units_str (GCS_FC_UNITS_BYTES), "bytes"));
+
+    /* rates must be accounted in the same units as the queue */
+    gcs_fcr_t fc;
+    struct timespec p20ms = {0, 20000000 }; // 20 ms
+
+    gcs_fcr_reset (&fc, 1 << 20);
+    gcs_fcr_account (&fc, 1 << 10, true, 1 << 10);
+    nanosleep (&p20ms, NULL);
+    gcs_fcr_account (&fc, 2 << 10, true, 1 << 10);
+    fail_if (fc.in_rate < 1 << 10, "Incoming rate: %f", fc.in_rate);
+}
+END_TEST
+
+START_TEST(gcs_fc_test_rate)
+{
+    gcs_fcr_t fc;
+    double    out;
+    struct timespec p20ms = {0, 20000000 }; // 20 ms
+
+    gcs_fcr_reset (&fc, 16.0);
+
+    /* no rate history: plain queue length error */
+    out = gcs_fcr_update (&fc, 20, true);
+    fail_if (out <= 0.0, "Output above target: %f", out);
+    out = gcs_fcr_update (&fc, 10, false);
+    fail_if (out >= 0.0, "Output below target: %f", out);
+
+    /* fast inflow should call for stop before target is reached */
+    for (int i = 0; i < 1000; ++i) gcs_fcr_update (&fc, 8, true);
+    nanosleep (&p20ms, NULL);
+    out = gcs_fcr_update (&fc, 8, true);
+    fail_if (fc.in_rate <= 0.0, "Incoming rate: %f", fc.in_rate);
+    fail_if (out <= 0.0, "Output at fast inflow: %f", out);
+
+    /* and fast drain should call for resume while queue is still long */
+    for (int i = 0; i < 4000; ++i) gcs_fcr_update (&fc, 24, false);
+    nanosleep (&p20ms, NULL);
+    out = gcs_fcr_update (&fc, 24, false);
+    fail_if (fc.out_rate <= fc.in_rate, "Drain rate: %f, incoming rate: %f",
+             fc.out_rate, fc.in_rate);
+    fail_if (out >= 0.0, "Output at fast drain: %f", out);
+}
+END_TEST
+
+START_TEST(gcs_fc_test_coord)
+{
+    gcs_fcc_t fc;
+    gcs_fc_mode_t mode = GCS_FC_MODE_LIMIT;
+    struct timespec p20ms = {0, 20000000 }; // 20 ms
+
+    fail_if (gcs_fc_mode_parse ("coord", &mode) != 0);
+    fail_if (mode != GCS_FC_MODE_COORD);
+
+    gcs_fcc_reset (&fc, 100);
+    fail_if (gcs_fcc_delay (&fc, 200, 8, 16) != 0,
+             "Delay without apply rate history");
+
+    nanosleep (&p20ms, NULL);
+    gcs_fcc_cut (&fc, 110);
+    fail_if (fc.period < 2000000.0, "Period: %f", fc.period);
+
+    /* stale cut does not change anything */
+    gcs_fcc_cut (&fc, 105);
+    fail_if (fc.cut != 110);
+
+    long long const full(gcs_fcc_delay (&fc, fc.cut + 16, 8, 16));
+    long long const half(gcs_fcc_delay (&fc, fc.cut + 12, 8, 16));
+
+    fail_if (gcs_fcc_delay (&fc, fc.cut + 8, 8, 16) != 0);
+    fail_if (full <= 0 || full != gcs_fcc_delay (&fc, fc.cut + 100, 8, 16),
+             "Full delay: %lld", full);
+    fail_if (half > full / 2 + 1 || half < full / 2 - 1,
+             "Half delay: %lld, full: %lld", half, full);
+}
+END_TEST
+
 Suite *gcs_fc_suite(void)
 {
     Suite *s  = suite_create("GCS state transfer FC");
@@ -129,6 +230,10 @@ Suite *gcs_fc_suite(void)
     tcase_add_test  (tc, gcs_fc_test_limits);
     tcase_add_test  (tc, gcs_fc_test_basic);
     tcase_add_test  (tc, gcs_fc_test_precise);
+    tcase_add_test  (tc, gcs_fc_test_mode);
+    tcase_add_test  (tc, gcs_fc_test_units);
+    tcase_add_test  (tc, gcs_fc_test_rate);
+    tcase_add_test  (tc, gcs_fc_test_coord);
 
     return s;
 }
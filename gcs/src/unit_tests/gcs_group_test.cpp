@@ -12,6 +12,7 @@
 #include "../gcs_group.hpp"
 #include "../gcs_act_proto.hpp"
 #include "../gcs_comp_msg.hpp"
+#include "../gcs_fc.hpp"
 
 #include <check.h>
 #include "gcs_group_test.hpp"
@@ -498,6 +499,75 @@ START_TEST(gcs_group_last_applied)
 }
 END_TEST
 
+// Commit cut maintained incrementally must follow the linear scan
+START_TEST(gcs_group_commit_cut)
+{
+    gcs_group_t     group;
+    gcs_comp_msg_t* comp;
+    const int       number = 37; // not a power of 2
+    gcs_seqno_t     la[number];
+    gcs_seqno_t     cut  = GCS_SEQNO_ILL;
+    long            cut_node = -1;
+    uint8_t         buf[sizeof(gcs_seqno_t)];
+    int             i;
+
+    comp = gcs_comp_msg_new (TRUE, false, 0, number, 0);
+    fail_if (comp == NULL);
+    for (i = 0; i < number; i++) {
+        char id[16];
+        snprintf (id, sizeof(id), "node%d", i);
+        fail_if (gcs_comp_msg_add (comp, id, 0) < 0);
+    }
+
+    gcs_group_init(&group, NULL, "", "", 0, 0, 0);
+    fail_if (new_component (&group, comp) < 0);
+    fail_if (group.num != number);
+    group.last_applied_proto_ver = 1;
+
+    // every node but the last is counted after it syncs
+    for (i = 0; i < number - 1; i++) {
+        gcs_recv_msg_t msg(buf, sizeof(buf), 0, i, GCS_MSG_SYNC);
+        group.nodes[i].status = GCS_NODE_STATE_JOINED;
+        gcs_group_handle_sync_msg (&group, &msg);
+        fail_if (group.last_node != 0);
+        la[i] = 0;
+    }
+    la[number - 1] = 0;
+    cut = 0; cut_node = 0;
+
+    unsigned int seed = 1;
+    for (int n = 0; n < 10000; n++) {
+        int const sender = rand_r(&seed) % number;
+        gcs_seqno_t const seqno = la[sender] + rand_r(&seed) % 4;
+        gcs_recv_msg_t msg(buf, sizeof(buf), sizeof(buf), sender,
+                           GCS_MSG_LAST);
+
+        group_set_last_msg (&msg, seqno);
+        gcs_seqno_t const ret = gcs_group_handle_last_msg (&group, &msg);
+
+        // reference: rescan only when the slowest node moved
+        la[sender] = seqno;
+        gcs_seqno_t expected = 0;
+        if (sender == cut_node && seqno > cut) {
+            gcs_seqno_t const old_cut = cut;
+            for (i = 0; i < number - 1; i++) {
+                if (i == 0 || la[i] < cut) { cut = la[i]; cut_node = i; }
+            }
+            if (cut > old_cut) expected = cut;
+        }
+
+        fail_if (ret != expected, "step %d: ret %lld, expected %lld",
+                 n, (long long)ret, (long long)expected);
+        fail_if (group.last_applied != cut, "step %d: cut %lld, expected %lld",
+                 n, (long long)group.last_applied, (long long)cut);
+        fail_if (group.last_node != cut_node);
+    }
+
+    gcs_comp_msg_delete (comp);
+    gcs_group_free (&group);
+}
+END_TEST
+
 START_TEST(test_gcs_group_find_donor)
 {
     gcs_group_t group;
@@ -593,6 +663,33 @@ START_TEST(test_gcs_group_find_donor)
     nodes[0].status = GCS_NODE_STATE_SYNCED;
     nodes[1].status = GCS_NODE_STATE_SYNCED;
     nodes[2].status = GCS_NODE_STATE_SYNCED;
+
+    // ========== load ==========
+    group.quorum.act_id = 0; // in safe range.
+    nodes[1].fc_stopped = 1; // holds flow control
+    donor = gcs_group_find_donor(&group, sv, joiner, SARGS("home0,home1,home2"),
+                                 group_uuid, ist_seqno);
+    fail_if(donor != 0);
+    nodes[1].fc_stopped = 0;
+
+    group.act_id_ = 200;
+    nodes[0].last_applied  = 150;
+    nodes[0].last_reported = true;
+    nodes[1].last_applied  = 190;
+    nodes[1].last_reported = true;
+    nodes[2].last_applied  = 100;
+    nodes[2].last_reported = true;
+    donor = gcs_group_find_donor(&group, sv, joiner, SARGS(""),
+                                 group_uuid, ist_seqno);
+    fail_if(donor != 1); // least lagging of IST capable ones
+
+    donor = gcs_group_find_donor(&group, sv, joiner, SARGS("home3,"),
+                                 &empty_uuid, GCS_SEQNO_ILL);
+    fail_if(donor != 1); // least lagging of all
+    nodes[2].last_reported = false;
+    donor = gcs_group_find_donor(&group, sv, joiner, SARGS("home3,"),
+                                 &empty_uuid, GCS_SEQNO_ILL);
+    fail_if(donor != 2); // did not report yet, is not penalized
 #undef SARGS
 
     // todo: free
@@ -604,6 +701,64 @@ START_TEST(test_gcs_group_find_donor)
 }
 END_TEST
 
+START_TEST(gcs_group_flow_control)
+{
+    gcs_group_t     group;
+    gcs_comp_msg_t* comp;
+
+    comp = gcs_comp_msg_new (TRUE, false, 0, 2, 0);
+    fail_if (comp == NULL);
+    fail_if (gcs_comp_msg_add (comp, LOCALHOST,  0) < 0);
+    fail_if (gcs_comp_msg_add (comp, REMOTEHOST, 1) < 0);
+
+    gcs_group_init(&group, NULL, "", "", 0, 0, 0);
+    fail_if (new_component (&group, comp) < 0);
+
+    struct gcs_fc_event fc = { htogl((uint32_t)group.conf_id), 1 };
+    gcs_recv_msg_t msg(&fc, sizeof(fc), sizeof(fc), 1, GCS_MSG_FLOW);
+
+    gcs_group_handle_flow_msg (&group, &msg);
+    fail_if (group.nodes[1].fc_stops != 1);
+    fail_if (group.nodes[1].fc_stopped == 0);
+    fail_if (group.nodes[0].fc_stops != 0);
+
+    usleep (1000);
+    fc.stop = 0;
+    gcs_group_handle_flow_msg (&group, &msg);
+    fail_if (group.nodes[1].fc_conts != 1);
+    fail_if (group.nodes[1].fc_stopped != 0);
+    fail_if (group.nodes[1].fc_paused < 1000000,
+             "Paused for %lld ns", group.nodes[1].fc_paused);
+
+    // obsolete event must be ignored
+    long long const paused(group.nodes[1].fc_paused);
+    fc.conf_id = htogl((uint32_t)(group.conf_id + 1));
+    fc.stop = 1;
+    gcs_group_handle_flow_msg (&group, &msg);
+    fail_if (group.nodes[1].fc_stops != 1);
+
+    // configuration change closes outstanding stop
+    fc.conf_id = htogl((uint32_t)group.conf_id);
+    gcs_group_handle_flow_msg (&group, &msg);
+    fail_if (group.nodes[1].fc_stops != 2);
+    fail_if (new_component (&group, comp) < 0);
+    fail_if (group.nodes[1].fc_stopped != 0);
+    fail_if (group.nodes[1].fc_paused <= paused);
+
+    gu::Status status;
+    gcs_group_get_status (&group, status);
+    bool found(false);
+    for (gu::Status::const_iterator i(status.begin()); i != status.end(); ++i)
+    {
+        found = found || (i->first == "flow_control_nodes");
+    }
+    fail_if (!found);
+
+    gcs_comp_msg_delete (comp);
+    gcs_group_free (&group);
+}
+END_TEST
+
 Suite *gcs_group_suite(void)
 {
     Suite *suite = suite_create("GCS group context");
@@ -613,7 +768,9 @@ Suite *gcs_group_suite(void)
     suite_add_tcase (suite, tcase);
     tcase_add_test  (tcase_ignore, gcs_group_configuration);
     tcase_add_test  (tcase_ignore, gcs_group_last_applied);
+    tcase_add_test  (tcase, gcs_group_commit_cut);
     tcase_add_test  (tcase, test_gcs_group_find_donor);
+    tcase_add_test  (tcase, gcs_group_flow_control);
 
     return suite;
 }
@@ -515,6 +515,92 @@ START_TEST (gcs_sm_test_interrupt)
 END_TEST
 
 
+struct class_user
+{
+    gcs_sm_t*      sm;
+    gcs_sm_class_t cls;
+    long long      bytes;
+    int            id;
+};
+
+static int class_order[8];
+static int class_entered;
+
+static void* class_thread (void* arg)
+{
+    const struct class_user* const u = (const struct class_user*)arg;
+
+    gu_cond_t cond;
+    gu_cond_init (&cond, NULL);
+
+    if (0 == gcs_sm_enter (u->sm, &cond, false, true, u->cls, u->bytes)) {
+        class_order[class_entered++] = u->id;
+        gcs_sm_leave (u->sm);
+    }
+
+    gu_cond_destroy (&cond);
+
+    return NULL;
+}
+
+START_TEST (gcs_sm_test_classes)
+{
+    gcs_sm_t* sm = gcs_sm_create(8, 1);
+    fail_if(!sm);
+
+    gcs_sm_set_budget (sm, 100);
+
+    gu_cond_t cond;
+    gu_cond_init (&cond, NULL);
+
+    long ret = gcs_sm_enter (sm, &cond, false, true);
+    fail_if (ret != 0);
+
+    struct class_user users[] = {
+        { sm, GCS_SM_CLASS_LARGE, 1000, 1 },
+        { sm, GCS_SM_CLASS_SMALL,   60, 2 },
+        { sm, GCS_SM_CLASS_SMALL,   60, 3 },
+        { sm, GCS_SM_CLASS_SMALL,   60, 4 },
+        { sm, GCS_SM_CLASS_CTRL,    10, 5 }
+    };
+    int const n_users = sizeof(users)/sizeof(users[0]);
+    gu_thread_t thr[n_users];
+
+    class_entered = 0;
+
+    for (int i = 0; i < n_users; i++) {
+        gu_thread_create (&thr[i], NULL, class_thread, &users[i]);
+        WAIT_FOR(sm->users == i + 2);
+        fail_if (sm->users != i + 2, "users = %ld, expected %d",
+                 sm->users, i + 2);
+    }
+
+    gcs_sm_leave (sm);
+
+    for (int i = 0; i < n_users; i++) gu_thread_join (thr[i], NULL);
+
+    /* control goes first, small ones until the budget is spent, then large */
+    int const expected[] = { 5, 2, 3, 1, 4 };
+    fail_if (class_entered != n_users);
+    for (int i = 0; i < n_users; i++) {
+        fail_if (class_order[i] != expected[i],
+                 "entered #%d: %d, expected %d", i, class_order[i],
+                 expected[i]);
+    }
+    fail_if (sm->users != 0, "users = %ld, expected 0", sm->users);
+
+    /* monitor is still functional and in order */
+    ret = gcs_sm_enter (sm, &cond, false, true);
+    fail_if (ret != 0);
+    fail_if (sm->users != 1, "users = %ld, expected 1", sm->users);
+    gcs_sm_leave (sm);
+
+    gu_cond_destroy (&cond);
+    gcs_sm_close (sm);
+    gcs_sm_destroy (sm);
+}
+END_TEST
+
 Suite *gcs_send_monitor_suite(void)
 {
   Suite *s  = suite_create("GCS send monitor");
@@ -526,6 +612,7 @@ Suite *gcs_send_monitor_suite(void)
   tcase_add_test  (tc, gcs_sm_test_close);
   tcase_add_test  (tc, gcs_sm_test_pause);
   tcase_add_test  (tc, gcs_sm_test_interrupt);
+  tcase_add_test  (tc, gcs_sm_test_classes);
   return s;
 }
 
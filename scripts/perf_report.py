@@ -0,0 +1,263 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2017 Codership Oy <info@codership.com>
+#
+# Performance regression suite report.
+#
+# Collects output of the benchmarks run by 'scons perf' into a JSON report
+# and optionally compares it against a baseline report:
+#
+#   perf_report.py [-o report.json] [-b baseline.json] [-t threshold %]
+#                  <bench output|report.json>...
+#
+# Every bench output file starts with 'bench: <program> <args>' line followed
+# by the output of one or more runs of the program. Metrics are extracted
+# from it with the patterns listed below, the best value of all runs is
+# reported. A metric regresses when it is worse than in the baseline by more
+# than the threshold, which is taken from the baseline metric's "threshold"
+# field, from the pattern list or from the command line, in that order.
+# Exit status is 1 if anything regressed.
+#
+# To make a baseline run 'scons perf' on a known good tree and keep the
+# resulting perf_report.json, e.g.:
+#
+#   scons perf && cp perf_report.json ../perf_baseline.json
+#   ... change the code ...
+#   scons perf perf_baseline=../perf_baseline.json perf_threshold=5
+#
+# Two existing reports can also be compared without running anything:
+#
+#   perf_report.py -b old.json new.json
+#
+
+import json
+import os
+import platform
+import re
+import sys
+
+from optparse import OptionParser
+
+NUM = r'([-+]?\d+(?:\.\d*)?(?:[eE][-+]?\d+)?)'
+
+LOWER = 'lower'
+HIGHER = 'higher'
+
+# program: [ (metric, pattern, unit, better[, threshold %]) ]
+METRICS = {
+    'gu_bench': [
+        (name, r'^%s:\s+%s ns/op' % (name, NUM), 'ns/op', LOWER)
+        for name in ('mmh128', 'xxh64', 'crc32c', 'fast64',
+                     'vlq_enc', 'vlq_dec')
+    ],
+    'gcache_bench': [
+        ('alloc',   r'^alloc:\s+%s ns/buf' % NUM,   'ns/buf', LOWER),
+        ('recover', r'^recover:\s+%s ns/buf' % NUM, 'ns/buf', LOWER),
+    ],
+    'gcs_bench': [
+        (name, r'^%s:\s+%s ns/act' % (name, NUM), 'ns/act', LOWER)
+        for name in ('defrag', 'fc_rate', 'fc_coord', 'fc_throttle')
+    ],
+    'gcomm_bench': [
+        ('throughput',  r'^throughput: %s msg/s' % NUM, 'msg/s', HIGHER),
+        ('latency_p50', r'^latency \(us\): p50 %s' % NUM, 'us', LOWER, 25),
+        ('latency_p99', r'^latency \(us\):.* p99 %s' % NUM, 'us', LOWER, 50),
+    ],
+    'cert_bench': [
+        ('prepare', r'^prepare:\s+%s ns/key' % NUM, 'ns/key', LOWER),
+        ('certify', r'^certify:\s+%s ns/key' % NUM, 'ns/key', LOWER),
+        ('purge',   r'^purge:\s+%s ns/key' % NUM,   'ns/key', LOWER),
+        ('purge_max_pause', r'^purge:.* max pause %s us' % NUM, 'us',
+         LOWER, 50),
+    ],
+    'ws_bench': [
+        (name, r'^%s:\s+%s ns/ws' % (name, NUM), 'ns/ws', LOWER)
+        for name in ('build', 'parse', 'checksum')
+    ],
+    'monitor_bench': [
+        ('apply', r'^apply:\s+%s ns/trx' % NUM, 'ns/trx', LOWER),
+    ],
+    'repl_bench': [
+        ('throughput',  r'^throughput:\s+%s trx/s' % NUM, 'trx/s', HIGHER),
+        ('pre_commit',  r'^pre_commit:\s+%s us avg' % NUM, 'us', LOWER),
+        ('post_commit', r'^post_commit:\s+%s us avg' % NUM, 'us', LOWER),
+    ],
+}
+
+
+def parse_bench(path):
+    """Returns (name, bench) for the bench output file"""
+    f = open(path)
+    lines = f.read().splitlines()
+    f.close()
+
+    if not lines or not lines[0].startswith('bench: '):
+        raise ValueError("'%s' is not a bench output file" % path)
+
+    cmd = lines[0][len('bench: '):].split()
+    program = cmd[0]
+    if program not in METRICS:
+        raise ValueError("'%s': unknown benchmark '%s'" % (path, program))
+
+    metrics = {}
+    for m in METRICS[program]:
+        name, pattern, unit, better = m[:4]
+        regex = re.compile(pattern)
+        samples = []
+        for line in lines[1:]:
+            match = regex.search(line)
+            if match:
+                samples.append(float(match.group(1)))
+        if not samples:
+            raise ValueError("'%s': no samples of '%s'" % (path, name))
+
+        metric = {
+            'value': min(samples) if better == LOWER else max(samples),
+            'unit': unit,
+            'better': better,
+            'samples': samples,
+        }
+        if len(m) > 4:
+            metric['threshold'] = m[4]
+        metrics[name] = metric
+
+    name = os.path.splitext(os.path.basename(path))[0]
+    return name, {'command': ' '.join(cmd), 'metrics': metrics}
+
+
+def load_report(path):
+    f = open(path)
+    report = json.load(f)
+    f.close()
+    return report
+
+
+def make_report(paths):
+    if len(paths) == 1 and paths[0].endswith('.json'):
+        return load_report(paths[0])
+
+    benches = {}
+    for path in paths:
+        name, bench = parse_bench(path)
+        benches[name] = bench
+
+    return {
+        'host': {
+            'system': platform.system(),
+            'machine': platform.machine(),
+            'node': platform.node(),
+        },
+        'benchmarks': benches,
+    }
+
+
+def compare(report, baseline, threshold):
+    """Prints comparison table, returns number of regressions"""
+    regressions = 0
+    rows = []
+
+    base_benches = baseline.get('benchmarks', {})
+    for bench_name in sorted(base_benches):
+        base_bench = base_benches[bench_name]
+        bench = report['benchmarks'].get(bench_name)
+
+        if bench is None:
+            rows.append((bench_name, '', '', '', '', 'MISSING'))
+            continue
+
+        if bench.get('command') != base_bench.get('command'):
+            sys.stderr.write("Warning: '%s' profile differs from baseline: "
+                             "'%s' vs '%s'\n" % (bench_name,
+                                                 bench.get('command'),
+                                                 base_bench.get('command')))
+
+        for name in sorted(base_bench['metrics']):
+            base = base_bench['metrics'][name]
+            metric = bench['metrics'].get(name)
+
+            if metric is None:
+                rows.append((bench_name, name, '%g' % base['value'], '',
+                             '', 'MISSING'))
+                continue
+
+            limit = base.get('threshold',
+                             metric.get('threshold', threshold))
+
+            if base['value'] == 0:
+                change = 0.0
+            else:
+                change = (metric['value'] - base['value']) * 100.0 / \
+                    base['value']
+
+            # positive is worse
+            worse = change if base['better'] == LOWER else -change
+
+            if worse > limit:
+                status = 'REGRESSION'
+                regressions += 1
+            elif worse < -limit:
+                status = 'improved'
+            else:
+                status = 'ok'
+
+            rows.append((bench_name, name, '%g' % base['value'],
+                         '%g' % metric['value'], '%+.1f%%' % change, status))
+
+    header = ('benchmark', 'metric', 'baseline', 'current', 'change', '')
+    widths = [max(len(r[i]) for r in rows + [header])
+              for i in range(len(header))]
+    for row in [header] + rows:
+        print('  '.join(row[i].ljust(widths[i])
+                        for i in range(len(row))).rstrip())
+
+    return regressions
+
+
+def main():
+    parser = OptionParser(usage='%prog [-o report.json] [-b baseline.json] '
+                          '[-t threshold %] <bench output|report.json>...')
+    parser.add_option('-o', '--output', dest='output',
+                      help='write JSON report to FILE', metavar='FILE')
+    parser.add_option('-b', '--baseline', dest='baseline',
+                      help='compare against baseline report FILE',
+                      metavar='FILE')
+    parser.add_option('-t', '--threshold', dest='threshold', type='float',
+                      default=10.0,
+                      help='regression threshold in percent, default: 10')
+    (opts, args) = parser.parse_args()
+
+    if not args:
+        parser.error('no bench output files given')
+
+    try:
+        report = make_report(args)
+    except (IOError, ValueError) as e:
+        sys.stderr.write('%s\n' % e)
+        return 2
+
+    if opts.output:
+        f = open(opts.output, 'w')
+        json.dump(report, f, indent=2, sort_keys=True)
+        f.write('\n')
+        f.close()
+
+    if not opts.baseline:
+        for bench_name in sorted(report['benchmarks']):
+            metrics = report['benchmarks'][bench_name]['metrics']
+            for name in sorted(metrics):
+                print('%-24s %-16s %12g %s' % (bench_name, name,
+                                               metrics[name]['value'],
+                                               metrics[name]['unit']))
+        return 0
+
+    regressions = compare(report, load_report(opts.baseline), opts.threshold)
+    if regressions:
+        sys.stderr.write('%d metric(s) regressed by more than the threshold\n'
+                         % regressions)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())